@@ -13,7 +13,7 @@ create_ip -name axi_clock_converter -vendor xilinx.com -library ip -version 2.1
 
 set_property -dict [list \
   CONFIG.PROTOCOL {AXI4LITE} \
-  CONFIG.ADDR_WIDTH {20} \
+  CONFIG.ADDR_WIDTH {24} \
   CONFIG.DATA_WIDTH {32} \
 ] [get_ips $ipName]
 
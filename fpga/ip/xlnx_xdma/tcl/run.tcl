@@ -29,7 +29,7 @@ set_property -dict [list \
   CONFIG.axil_master_64bit_en {true} \
   CONFIG.axilite_master_en {true} \
   CONFIG.axilite_master_scale {Megabytes} \
-  CONFIG.axilite_master_size {1} \
+  CONFIG.axilite_master_size {16} \
   CONFIG.axist_bypass_en {false} \
   CONFIG.axisten_freq {125} \
   CONFIG.coreclk_freq {250} \
@@ -56,7 +56,7 @@ set_property -dict [list \
   CONFIG.xdma_rnum_rids {2} \
   CONFIG.xdma_wnum_rids {2} \
   CONFIG.MSI_X_OPTIONS {MSI-X_Internal} \
-  CONFIG.xdma_num_usr_irq {1} \
+  CONFIG.xdma_num_usr_irq {6} \
 ] [get_ips $ipName]
 
 generate_target {instantiation_template} [get_files ./$ipName.srcs/sources_1/ip/$ipName/$ipName.xci]
@@ -0,0 +1,54 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: Apache-2.0
+"""Compare the achieved emulation clock of two or more FPGA builds.
+
+Reads the <prefix>_freq.txt files that loom::report_achieved_freq writes
+after routing. Arguments are freq files or run directories (searched for
+reports/*_freq.txt). The first build is the baseline.
+
+    freq_compare.py work-u250/runs/*_dfx_rm_dut_en work-u250/runs/*_dfx_rm_dut_cg
+"""
+
+import glob
+import os
+import sys
+
+
+def load(path):
+    if os.path.isdir(path):
+        found = sorted(glob.glob(os.path.join(path, "reports", "*_freq.txt")))
+        if not found:
+            sys.exit(f"{path}: no reports/*_freq.txt")
+        path = found[-1]
+    values = {}
+    with open(path) as f:
+        for line in f:
+            parts = line.split()
+            if len(parts) == 2:
+                values[parts[0]] = float(parts[1])
+    for key in ("wns_ns", "achieved_freq_mhz", "target_freq_mhz"):
+        if key not in values:
+            sys.exit(f"{path}: missing {key}")
+    return path, values
+
+
+def main():
+    if len(sys.argv) < 3 or sys.argv[1] in ("-h", "--help"):
+        print(__doc__.strip())
+        return 0 if len(sys.argv) > 1 else 1
+
+    builds = [load(p) for p in sys.argv[1:]]
+    base = builds[0][1]["achieved_freq_mhz"]
+    print(f"{'build':<48} {'target':>8} {'WNS ns':>8} {'Fmax MHz':>9} {'vs base':>8}")
+    for path, v in builds:
+        name = os.path.relpath(path)
+        if len(name) > 48:
+            name = "..." + name[-45:]
+        delta = (v["achieved_freq_mhz"] / base - 1.0) * 100.0 if base > 0 else 0.0
+        print(f"{name:<48} {v['target_freq_mhz']:>8.1f} {v['wns_ns']:>+8.3f} "
+              f"{v['achieved_freq_mhz']:>9.1f} {delta:>+7.1f}%")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
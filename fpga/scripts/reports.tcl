@@ -21,7 +21,8 @@ proc read_ips {} {
 proc read_shell_rtl {} {
     set s $::env(LOOM_SRC)
     read_verilog -sv \
-        $s/rtl/loom_axi4_err_slv.sv \
+        $s/rtl/loom_axi4_to_axil.sv \
+        $s/rtl/loom_axil_arb.sv \
         $s/rtl/loom_axil_demux.sv \
         $s/rtl/loom_emu_ctrl.sv \
         $s/rtl/loom_dpi_regfile.sv \
@@ -37,7 +38,9 @@ proc read_rm_rtl {} {
         $s/rtl/loom_axil_demux.sv \
         $s/rtl/loom_emu_ctrl.sv \
         $s/rtl/loom_dpi_regfile.sv \
-        $s/rtl/loom_scan_ctrl.sv
+        $s/rtl/loom_scan_ctrl.sv \
+        $s/rtl/loom_trace_ctrl.sv \
+        $s/rtl/loom_clk_gate.sv
 }
 
 # Print the timing closure result and the maximum achievable frequency.
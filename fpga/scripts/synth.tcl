@@ -26,11 +26,14 @@ read_ip $ip_dir/xlnx_decoupler/xlnx_decoupler.srcs/sources_1/ip/xlnx_decoupler/x
 # ----------------------------------------------------------------
 set loom_src $::env(LOOM_SRC)
 read_verilog -sv \
-  $loom_src/rtl/loom_axi4_err_slv.sv \
+  $loom_src/rtl/loom_axi4_to_axil.sv \
+  $loom_src/rtl/loom_axil_arb.sv \
   $loom_src/rtl/loom_axil_demux.sv \
   $loom_src/rtl/loom_emu_ctrl.sv \
   $loom_src/rtl/loom_dpi_regfile.sv \
   $loom_src/rtl/loom_scan_ctrl.sv \
+  $loom_src/rtl/loom_trace_ctrl.sv \
+  $loom_src/rtl/loom_clk_gate.sv \
   $loom_src/rtl/loom_axil_firewall.sv \
   $loom_src/rtl/loom_icap_ctrl.sv \
   $loom_src/rtl/loom_shell.sv
@@ -21,7 +21,8 @@ read_ip $ip_dir/xlnx_cdc/xlnx_cdc.srcs/sources_1/ip/xlnx_cdc/xlnx_cdc.xci
 read_ip $ip_dir/xlnx_decoupler/xlnx_decoupler.srcs/sources_1/ip/xlnx_decoupler/xlnx_decoupler.xci
 
 read_verilog -sv \
-  $loom_src/rtl/loom_axi4_err_slv.sv \
+  $loom_src/rtl/loom_axi4_to_axil.sv \
+  $loom_src/rtl/loom_axil_arb.sv \
   $loom_src/rtl/loom_axil_demux.sv \
   $loom_src/rtl/loom_emu_ctrl.sv \
   $loom_src/rtl/loom_dpi_regfile.sv \
@@ -9,8 +9,14 @@
  *   4. loom_dpi_regfile: DPI call registers
  *   5. loom_scan_ctrl: scan chain controller
  *
+ * With -instances N the above is built once as `loom_emu_inst` and
+ * loom_emu_top holds N copies of it behind a further demux, instance k at
+ * k * 0x10_0000, so one FPGA runs N independent tests.
+ *
  * The DUT clock runs free (ungated). State freezing is done via loom_en_o
- * from emu_ctrl which owns the enable signal end-to-end.
+ * from emu_ctrl which owns the enable signal end-to-end. If loom_instrument
+ * ran with -clock_gate, the DUT clock goes through loom_clk_gate instead,
+ * enabled by loom_en | scan_enable.
  *
  * The generated module exposes only:
  *   - clk_i, rst_ni: clock and reset
@@ -56,11 +62,39 @@ struct EmuTopPass : public Pass {
         log("        Name of the reset signal in DUT (default: rst_ni)\n");
         log("\n");
         log("    -addr_width <bits>\n");
-        log("        AXI-Lite address width (default: 20)\n");
+        log("        AXI-Lite address width (default: 24)\n");
         log("\n");
         log("    -n_irq <count>\n");
         log("        Number of IRQ lines (default: 16)\n");
         log("\n");
+        log("    -scan_buf_words <words>\n");
+        log("        Largest scan image held in the scan controller's data buffer\n");
+        log("        (default: 1024). Longer chains get a stream-only controller\n");
+        log("        that is read/written through a small FIFO window instead.\n");
+        log("\n");
+        log("    -scan_stream\n");
+        log("        Always build a stream-only scan controller\n");
+        log("\n");
+        log("    -reset_rom\n");
+        log("        Store the initial scan image from scan_insert in a ROM inside\n");
+        log("        the scan controller, so the host resets the DUT with a single\n");
+        log("        reinit command instead of uploading the image\n");
+        log("\n");
+        log("    -mem_page_bytes <bytes>\n");
+        log("        Dirty-tracking page size for shadow memories, a power of two\n");
+        log("        (default: 4096, 0 disables). Doubled as needed to keep the\n");
+        log("        bitmap within 4096 pages. Only used when mem_shadow -dirty\n");
+        log("        exported the DUT write ports.\n");
+        log("\n");
+        log("    -trace_depth <entries>\n");
+        log("        Trace RAM depth when scan_insert -trace exported loom_trace_data,\n");
+        log("        a power of two (default: 1024)\n");
+        log("\n");
+        log("    -instances <count>\n");
+        log("        Build <count> copies of the instrumented DUT, each with its own\n");
+        log("        controllers, at 0x100000-byte strides (default: 1). The copy\n");
+        log("        becomes module loom_emu_inst; loom_emu_top instantiates them.\n");
+        log("\n");
         log("DPI function count and scan chain length are auto-detected from\n");
         log("module attributes set by loom_instrument and scan_insert.\n");
         log("\n");
@@ -73,14 +107,121 @@ struct EmuTopPass : public Pass {
         log("\n");
     }
 
+    // loom_emu_top for -instances: a loom_axil_demux with one master per
+    // copy of `inst` (loom_emu_inst), copy k at k << 20. Every copy sees
+    // only the low 20 address bits, so its own map is unchanged. IRQs and
+    // finish are ORed: the host polls instance Contexts, and a simulation
+    // ends when any copy finishes.
+    static void build_instance_top(RTLIL::Design *design, RTLIL::Module *inst,
+                                   int n_instances, int addr_width) {
+        RTLIL::Module *top = design->addModule(ID(loom_emu_top));
+        for (auto port : inst->ports) {
+            if (port == ID(instance_id_i))
+                continue;
+            RTLIL::Wire *w = inst->wire(port);
+            RTLIL::Wire *t = top->addWire(port, w->width);
+            t->port_input = w->port_input;
+            t->port_output = w->port_output;
+        }
+        top->fixup_ports();
+
+        RTLIL::Cell *demux = top->addCell(ID(u_instance_demux), ID(loom_axil_demux));
+        demux->setParam(ID(ADDR_WIDTH), addr_width);
+        demux->setParam(ID(N_MASTERS), n_instances);
+        RTLIL::Const base_addr_val(0, n_instances * addr_width);
+        RTLIL::Const addr_mask_val(0, n_instances * addr_width);
+        for (int k = 0; k < n_instances; k++) {
+            for (int b = 20; b < addr_width; b++) {
+                addr_mask_val.bits()[k * addr_width + b] = RTLIL::State::S1;
+                if (b - 20 < 8 && ((k >> (b - 20)) & 1))
+                    base_addr_val.bits()[k * addr_width + b] = RTLIL::State::S1;
+            }
+        }
+        demux->setParam(ID(BASE_ADDR), base_addr_val);
+        demux->setParam(ID(ADDR_MASK), addr_mask_val);
+        demux->setPort(ID(clk_i), top->wire(ID(clk_i)));
+        demux->setPort(ID(rst_ni), top->wire(ID(rst_ni)));
+
+        // AXI-Lite signals: name, width, driven towards the instances
+        struct AxilSignal {
+            const char *name;
+            int width;
+            bool downstream;
+        };
+        const AxilSignal axil_signals[] = {
+            {"araddr", addr_width, true}, {"arvalid", 1, true},  {"arready", 1, false},
+            {"rdata", 32, false},         {"rresp", 2, false},   {"rvalid", 1, false},
+            {"rready", 1, true},          {"awaddr", addr_width, true}, {"awvalid", 1, true},
+            {"awready", 1, false},        {"wdata", 32, true},   {"wstrb", 4, true},
+            {"wvalid", 1, true},          {"wready", 1, false},  {"bresp", 2, false},
+            {"bvalid", 1, false},         {"bready", 1, true},
+        };
+
+        std::vector<RTLIL::Cell *> cells;
+        for (int k = 0; k < n_instances; k++) {
+            RTLIL::Cell *cell = top->addCell(RTLIL::escape_id("u_inst_" + std::to_string(k)),
+                                             ID(loom_emu_inst));
+            cell->setPort(ID(clk_i), top->wire(ID(clk_i)));
+            cell->setPort(ID(rst_ni), top->wire(ID(rst_ni)));
+            cell->setPort(ID(instance_id_i), RTLIL::Const(k, 8));
+            cells.push_back(cell);
+        }
+
+        for (const auto &sig : axil_signals) {
+            std::string name = sig.name;
+            RTLIL::IdString s_port = RTLIL::escape_id("s_axil_" + name + (sig.downstream ? "_i" : "_o"));
+            RTLIL::IdString m_port = RTLIL::escape_id("m_axil_" + name + (sig.downstream ? "_o" : "_i"));
+            demux->setPort(s_port, top->wire(s_port));
+
+            RTLIL::Wire *bus = top->addWire(RTLIL::escape_id("inst_" + name), n_instances * sig.width);
+            demux->setPort(m_port, bus);
+            bool is_addr = name == "araddr" || name == "awaddr";
+            for (int k = 0; k < n_instances; k++) {
+                RTLIL::SigSpec slice(bus, k * sig.width, is_addr ? 20 : sig.width);
+                if (is_addr)
+                    slice.append(RTLIL::SigSpec(RTLIL::State::S0, addr_width - 20));
+                cells[k]->setPort(s_port, slice);
+            }
+        }
+
+        RTLIL::Wire *irq_o = top->wire(ID(irq_o));
+        RTLIL::SigSpec irq_acc, finish_all;
+        for (int k = 0; k < n_instances; k++) {
+            RTLIL::Wire *irq = top->addWire(NEW_ID, irq_o->width);
+            RTLIL::Wire *finish = top->addWire(NEW_ID, 1);
+            cells[k]->setPort(ID(irq_o), irq);
+            cells[k]->setPort(ID(finish_o), finish);
+            finish_all.append(finish);
+            if (k == 0) {
+                irq_acc = irq;
+            } else {
+                RTLIL::Wire *acc = top->addWire(NEW_ID, irq_o->width);
+                top->addOr(NEW_ID, irq_acc, irq, acc);
+                irq_acc = acc;
+            }
+        }
+        top->connect(RTLIL::SigSpec(irq_o), irq_acc);
+        top->addReduceOr(NEW_ID, finish_all, RTLIL::SigSpec(top->wire(ID(finish_o))));
+
+        log("Generated loom_emu_top module with %d instances of loom_emu_inst\n", n_instances);
+        log("  Instantiated: loom_axil_demux (u_instance_demux) - %d masters, instance k at k << 20\n",
+            n_instances);
+    }
+
     void execute(std::vector<std::string> args, RTLIL::Design *design) override {
         log_header(design, "Executing EMU_TOP pass (complete wrapper).\n");
 
         std::string top_name;
         std::string clk_name = "clk_i";
         std::string rst_name = "rst_ni";
-        int addr_width = 20;
+        int addr_width = 24;
         int n_irq = 16;
+        int scan_buf_words = 1024;
+        bool scan_stream = false;
+        bool reset_rom = false;
+        int mem_page_bytes = 4096;
+        int trace_depth = 1024;
+        int n_instances = 1;
 
         size_t argidx;
         for (argidx = 1; argidx < args.size(); argidx++) {
@@ -104,6 +245,30 @@ struct EmuTopPass : public Pass {
                 n_irq = atoi(args[++argidx].c_str());
                 continue;
             }
+            if (args[argidx] == "-scan_buf_words" && argidx + 1 < args.size()) {
+                scan_buf_words = atoi(args[++argidx].c_str());
+                continue;
+            }
+            if (args[argidx] == "-scan_stream") {
+                scan_stream = true;
+                continue;
+            }
+            if (args[argidx] == "-reset_rom") {
+                reset_rom = true;
+                continue;
+            }
+            if (args[argidx] == "-mem_page_bytes" && argidx + 1 < args.size()) {
+                mem_page_bytes = atoi(args[++argidx].c_str());
+                continue;
+            }
+            if (args[argidx] == "-trace_depth" && argidx + 1 < args.size()) {
+                trace_depth = atoi(args[++argidx].c_str());
+                continue;
+            }
+            if (args[argidx] == "-instances" && argidx + 1 < args.size()) {
+                n_instances = atoi(args[++argidx].c_str());
+                continue;
+            }
             break;
         }
         extra_args(args, argidx, design);
@@ -111,6 +276,15 @@ struct EmuTopPass : public Pass {
         if (top_name.empty()) {
             log_error("No top module specified. Use -top <module>\n");
         }
+        // Instance k sits at k << 20; INSTANCE reports the count in 8 bits
+        int instance_bits = 0;
+        while ((1 << instance_bits) < n_instances)
+            instance_bits++;
+        if (n_instances < 1 || n_instances > 255)
+            log_error("-instances must be between 1 and 255 (got %d)\n", n_instances);
+        if (n_instances > 1 && addr_width < 20 + instance_bits)
+            log_error("-instances %d needs -addr_width %d or more\n",
+                      n_instances, 20 + instance_bits);
 
         // Find the DUT module
         RTLIL::Module *dut = design->module(RTLIL::escape_id(top_name));
@@ -124,6 +298,11 @@ struct EmuTopPass : public Pass {
         if (!n_dpi_str.empty()) {
             n_dpi_funcs = atoi(n_dpi_str.c_str());
         }
+        // Function IDs are 8 bits from loom_instrument through emu_ctrl to
+        // the FIFO word (whose upper bits carry the cycle stamp), so a
+        // 257th function would alias function 0
+        if (n_dpi_funcs > 256)
+            log_error("More than 256 DPI functions are not supported (got %d)\n", n_dpi_funcs);
 
         // Auto-detect scan chain length from scan_insert attribute
         int scan_chain_length = 0;
@@ -131,12 +310,20 @@ struct EmuTopPass : public Pass {
         if (!scan_len_str.empty()) {
             scan_chain_length = atoi(scan_len_str.c_str());
         }
+        int n_scan_chains = 1;
+        int scan_chain_bits = scan_chain_length;
+        std::string scan_chains_str = dut->get_string_attribute(ID(loom_scan_chains));
+        if (!scan_chains_str.empty()) {
+            n_scan_chains = std::max(1, atoi(scan_chains_str.c_str()));
+            scan_chain_bits = atoi(dut->get_string_attribute(ID(loom_scan_chain_bits)).c_str());
+        }
 
         // Auto-detect memory shadow from mem_shadow attributes
         int n_memories = 0;
         int shadow_addr_bits = 0;
         int shadow_data_bits = 0;
         uint32_t shadow_total_bytes = 0;
+        int mem_wr_ports = 0;
         std::string n_mem_str = dut->get_string_attribute(ID(loom_n_memories));
         if (!n_mem_str.empty()) {
             n_memories = atoi(n_mem_str.c_str());
@@ -147,9 +334,49 @@ struct EmuTopPass : public Pass {
             if (!s.empty()) shadow_data_bits = atoi(s.c_str());
             s = dut->get_string_attribute(ID(loom_shadow_total_bytes));
             if (!s.empty()) shadow_total_bytes = atoi(s.c_str());
+            s = dut->get_string_attribute(ID(loom_mem_wr_ports));
+            if (!s.empty()) mem_wr_ports = atoi(s.c_str());
         }
         bool has_memories = (n_memories > 0);
 
+        // MEM_DATA must stay below the MEM_DIRTY registers at 0x400
+        if (has_memories && (shadow_data_bits + 31) / 32 > 252)
+            log_error("Memories wider than %d bits are not supported\n", 252 * 32);
+
+        // Dirty page tracking: the bitmap window holds 128 words
+        int dirty_page_bytes = 0;
+        if (has_memories && mem_wr_ports > 0 && mem_page_bytes > 0) {
+            if (mem_page_bytes < 4 || (mem_page_bytes & (mem_page_bytes - 1)))
+                log_error("-mem_page_bytes must be a power of two >= 4\n");
+            dirty_page_bytes = mem_page_bytes;
+            while ((shadow_total_bytes + dirty_page_bytes - 1) / dirty_page_bytes > 4096)
+                dirty_page_bytes *= 2;
+        }
+
+        // Auto-detect traced registers from scan_insert -trace
+        int trace_width = 0;
+        std::string trace_width_str = dut->get_string_attribute(ID(loom_trace_width));
+        if (!trace_width_str.empty())
+            trace_width = atoi(trace_width_str.c_str());
+        bool has_trace = (trace_width > 0);
+        if (has_trace) {
+            if (trace_depth < 2 || (trace_depth & (trace_depth - 1)))
+                log_error("-trace_depth must be a power of two >= 2\n");
+            // The entry (stamp + probe words) is latched in one register
+            if (trace_width > 4096)
+                log_error("Traces wider than 4096 bits are not supported (got %d)\n", trace_width);
+        }
+
+        // Auto-detect watched registers from scan_insert -watch
+        int watch_width = 0;
+        std::string watch_width_str = dut->get_string_attribute(ID(loom_watch_width));
+        if (!watch_width_str.empty())
+            watch_width = atoi(watch_width_str.c_str());
+        // TRIG_SEL addresses probe words with 16 bits
+        if (watch_width > 65536 * 32)
+            log_error("Watched signals wider than %d bits are not supported (got %d)\n",
+                      65536 * 32, watch_width);
+
         // Auto-detect DPI FIFO attributes
         int n_ro_dpi_funcs = 0;
         int fifo_entry_words = 4;
@@ -193,6 +420,15 @@ struct EmuTopPass : public Pass {
 
         bool resets_extracted = dut->get_bool_attribute(ID(loom_resets_extracted));
 
+        // Clock gating from loom_instrument -clock_gate (FFs have no loom_en)
+        std::string gated_clk = dut->get_string_attribute(ID(loom_clock_gate));
+        bool clock_gated = !gated_clk.empty();
+        if (clock_gated && gated_clk != clk_name)
+            log_error("loom_instrument gated clock '%s', but the DUT clock is '%s'.\n",
+                      gated_clk.c_str(), clk_name.c_str());
+        if (clock_gated && has_memories)
+            log_error("Clock-gated DUT has memories; shadow ports need a free-running clock.\n");
+
         // Ensure clock (and reset, if not extracted) are input ports on the DUT.
         // This handles the "tbx clkgen" pattern where the clock is driven by
         // an initial block (skipped by --ignore-initial) and may have been
@@ -285,7 +521,10 @@ struct EmuTopPass : public Pass {
             if (mf) {
                 std::fprintf(mf, "[design]\n");
                 std::fprintf(mf, "hash = \"%s\"\n", hash_hex.c_str());
-                std::fprintf(mf, "top_module = \"%s\"\n\n", top_name.c_str());
+                std::fprintf(mf, "top_module = \"%s\"\n", top_name.c_str());
+                if (n_instances > 1)
+                    std::fprintf(mf, "instances = %d\n", n_instances);
+                std::fprintf(mf, "\n");
                 std::fprintf(mf, "[shell]\n");
                 std::fprintf(mf, "version = \"%d.%d.%d\"\n",
                     LOOM_SHELL_VERSION_MAJOR,
@@ -300,13 +539,16 @@ struct EmuTopPass : public Pass {
         }
 
         log("Creating loom_emu_top wrapper for DUT '%s'\n", top_name.c_str());
-        log("  Clock: %s, Reset: %s\n", clk_name.c_str(), rst_name.c_str());
+        log("  Clock: %s%s, Reset: %s\n", clk_name.c_str(), clock_gated ? " (gated)" : "",
+            rst_name.c_str());
         log("  DPI functions: %d (auto-detected)\n", n_dpi_funcs);
-        log("  Scan chain: %d bits (auto-detected)\n", scan_chain_length);
+        log("  Scan chain: %d bits in %d chain(s) (auto-detected)\n", scan_chain_length, n_scan_chains);
         log("  Memories: %d (auto-detected)\n", n_memories);
+        if (dirty_page_bytes > 0)
+            log("  Dirty tracking: %d write ports, %d-byte pages\n", mem_wr_ports, dirty_page_bytes);
 
-        // Create the wrapper module
-        RTLIL::Module *wrapper = design->addModule(ID(loom_emu_top));
+        // Create the wrapper module (one DUT copy of several with -instances)
+        RTLIL::Module *wrapper = design->addModule(n_instances > 1 ? ID(loom_emu_inst) : ID(loom_emu_top));
 
         // =========================================================================
         // Create wrapper ports
@@ -364,12 +606,22 @@ struct EmuTopPass : public Pass {
         RTLIL::Wire *finish_o = wrapper->addWire(ID(finish_o), 1);
         finish_o->port_output = true;
 
+        // Instance index, reported by emu_ctrl (-instances only)
+        RTLIL::SigSpec instance_id(RTLIL::State::S0, 8);
+        if (n_instances > 1) {
+            RTLIL::Wire *instance_id_i = wrapper->addWire(ID(instance_id_i), 8);
+            instance_id_i->port_input = true;
+            instance_id = instance_id_i;
+        }
+
         wrapper->fixup_ports();
 
         // =========================================================================
         // Create internal wires for demux master ports (flat arrays)
         // =========================================================================
-        const int n_demux_masters = has_memories ? 4 : 3;
+        const int mem_slot = 3;
+        const int trace_slot = has_memories ? 4 : 3;
+        const int n_demux_masters = 3 + (has_memories ? 1 : 0) + (has_trace ? 1 : 0);
 
         // Flat bus wires for demux
         RTLIL::Wire *demux_araddr  = wrapper->addWire(ID(demux_araddr),  n_demux_masters * addr_width);
@@ -408,26 +660,39 @@ struct EmuTopPass : public Pass {
 
         // Scan chain signals
         RTLIL::Wire *scan_enable = wrapper->addWire(ID(scan_enable), 1);
-        RTLIL::Wire *scan_in = wrapper->addWire(ID(scan_in), 1);
-        RTLIL::Wire *scan_out = wrapper->addWire(ID(scan_out), 1);
+        RTLIL::Wire *scan_in = wrapper->addWire(ID(scan_in), n_scan_chains);
+        RTLIL::Wire *scan_out = wrapper->addWire(ID(scan_out), n_scan_chains);
         RTLIL::Wire *scan_busy = wrapper->addWire(ID(scan_busy), 1);
+        RTLIL::Wire *scan_done = wrapper->addWire(ID(scan_done), 1);
+        RTLIL::Wire *mem_done = wrapper->addWire(ID(mem_done), 1);
+        RTLIL::Wire *trace_stall = wrapper->addWire(ID(trace_stall), 1);
+        RTLIL::Wire *trace_data = has_trace ? wrapper->addWire(ID(trace_data), trace_width) : nullptr;
+        RTLIL::Wire *watch_data = watch_width > 0 ? wrapper->addWire(ID(watch_data), watch_width) : nullptr;
 
         // emu_ctrl signals
         RTLIL::Wire *loom_en_wire = wrapper->addWire(ID(loom_en_wire), 1);
         RTLIL::Wire *cycle_count = wrapper->addWire(ID(cycle_count), 64);
         RTLIL::Wire *irq_state_change = wrapper->addWire(ID(irq_state_change), 1);
+        RTLIL::Wire *irq_scan_done = wrapper->addWire(ID(irq_scan_done), 1);
+        RTLIL::Wire *irq_mem_done = wrapper->addWire(ID(irq_mem_done), 1);
         RTLIL::Wire *emu_finish = wrapper->addWire(ID(emu_finish), 1);
         RTLIL::Wire *dut_finish = wrapper->addWire(ID(dut_finish), 1);
 
         // Read actual DPI port widths from DUT (set by loom_instrument)
         int dut_args_width = 64;   // default
         int dut_result_width = 32; // default
+        int dut_xargs_width = 0;   // large-argument window, when present
+        int dut_xresult_width = 0;
         for (auto wire : dut->wires()) {
             std::string wn = wire->name.str();
             if (wn.find("loom_dpi_args") != std::string::npos && wire->port_output)
                 dut_args_width = wire->width;
             if (wn.find("loom_dpi_result") != std::string::npos && wire->port_input)
                 dut_result_width = wire->width;
+            if (wire->name == ID(loom_dpi_xargs) && wire->port_output)
+                dut_xargs_width = wire->width;
+            if (wire->name == ID(loom_dpi_xresult) && wire->port_input)
+                dut_xresult_width = wire->width;
         }
 
         // DPI regfile <-> emu_ctrl signals
@@ -444,6 +709,19 @@ struct EmuTopPass : public Pass {
             log_error("DPI args width %d bits (%d words) exceeds 12-word regfile limit.\n"
                       "Reduce DPI argument sizes or split into multiple calls.\n",
                       dut_args_width, max_args);
+
+        // Arrays too large for the arg registers bypass them entirely: the
+        // regfile's scratch window reads the DUT's xargs bus and drives its
+        // xresult bus directly (see loom_dpi_regfile.sv)
+        bool has_xargs = dut_xargs_width > 0 || dut_xresult_width > 0;
+        int xarg_words = std::max(1, (dut_xargs_width + 31) / 32);
+        int xres_words = std::max(1, (dut_xresult_width + 31) / 32);
+        if (xarg_words > 4096 || xres_words > 4096)
+            log_error("Large DPI arrays need %d input / %d output words; the scratch window holds 4096.\n",
+                      xarg_words, xres_words);
+        if (has_xargs)
+            log("DPI large-argument window: %d input word(s), %d output word(s)\n",
+                dut_xargs_width > 0 ? xarg_words : 0, dut_xresult_width > 0 ? xres_words : 0);
         int n_dpi = n_dpi_funcs > 0 ? n_dpi_funcs : 1;
         RTLIL::Wire *dpi_call_valid = wrapper->addWire(ID(dpi_call_valid), n_dpi);
         RTLIL::Wire *dpi_call_ready = wrapper->addWire(ID(dpi_call_ready), n_dpi);
@@ -477,6 +755,8 @@ struct EmuTopPass : public Pass {
         RTLIL::Wire *dut_dpi_func_id = wrapper->addWire(ID(dut_dpi_func_id), 8);
         RTLIL::Wire *dut_dpi_args = wrapper->addWire(ID(dut_dpi_args), dut_args_width);
         RTLIL::Wire *dut_dpi_result = wrapper->addWire(ID(dut_dpi_result), dut_result_width);
+        RTLIL::Wire *dut_dpi_xargs = wrapper->addWire(ID(dut_dpi_xargs), xarg_words * 32);
+        RTLIL::Wire *dut_dpi_xresult = wrapper->addWire(ID(dut_dpi_xresult), xres_words * 32);
 
         // =========================================================================
         // Instantiate AXI-Lite Demux
@@ -484,6 +764,8 @@ struct EmuTopPass : public Pass {
         // Address map: slave 0 = emu_ctrl  (0x00000, mask 0xF0000)
         //              slave 1 = dpi_regfile (0x10000, mask 0xF0000)
         //              slave 2 = scan_ctrl   (0x20000, mask 0xF0000)
+        //              slave 3 = mem_ctrl    (0x30000, mask 0xF8000)
+        //              slave 4 = trace_ctrl  (0x38000, mask 0xF8000)
         RTLIL::Cell *interconnect = wrapper->addCell(ID(u_interconnect), ID(loom_axil_demux));
         interconnect->setParam(ID(ADDR_WIDTH), addr_width);
         interconnect->setParam(ID(N_MASTERS), n_demux_masters);
@@ -493,6 +775,7 @@ struct EmuTopPass : public Pass {
         //   Master 1: dpi      = 0x10000
         //   Master 2: scan     = 0x20000
         //   Master 3: mem_ctrl = 0x30000 (when present)
+        //   Next:     trace    = 0x38000 (when present)
         RTLIL::Const base_addr_val(0, n_demux_masters * addr_width);
         // Master 0: BASE=0x00000 (already zero)
         // Master 1: BASE=0x10000
@@ -501,15 +784,22 @@ struct EmuTopPass : public Pass {
         base_addr_val.bits()[2 * addr_width + 17] = RTLIL::State::S1; // bit 17 of master 2
         // Master 3: BASE=0x30000
         if (has_memories) {
-            base_addr_val.bits()[3 * addr_width + 16] = RTLIL::State::S1; // bit 16
-            base_addr_val.bits()[3 * addr_width + 17] = RTLIL::State::S1; // bit 17
+            base_addr_val.bits()[mem_slot * addr_width + 16] = RTLIL::State::S1; // bit 16
+            base_addr_val.bits()[mem_slot * addr_width + 17] = RTLIL::State::S1; // bit 17
+        }
+        // Trace: BASE=0x38000
+        if (has_trace) {
+            base_addr_val.bits()[trace_slot * addr_width + 15] = RTLIL::State::S1; // bit 15
+            base_addr_val.bits()[trace_slot * addr_width + 16] = RTLIL::State::S1; // bit 16
+            base_addr_val.bits()[trace_slot * addr_width + 17] = RTLIL::State::S1; // bit 17
         }
         interconnect->setParam(ID(BASE_ADDR), base_addr_val);
 
-        // ADDR_MASK: all slaves use 0xF0000 (bits [19:16])
+        // ADDR_MASK: 0xF0000 (bits [19:16]); mem_ctrl and trace_ctrl split
+        // 0x3xxxx in halves with 0xF8000 (bits [19:15])
         RTLIL::Const addr_mask_val(0, n_demux_masters * addr_width);
         for (int m = 0; m < n_demux_masters; m++)
-            for (int b = 16; b < addr_width; b++)
+            for (int b = (m >= mem_slot ? 15 : 16); b < addr_width; b++)
                 addr_mask_val.bits()[m * addr_width + b] = RTLIL::State::S1;
         interconnect->setParam(ID(ADDR_MASK), addr_mask_val);
 
@@ -558,12 +848,15 @@ struct EmuTopPass : public Pass {
         RTLIL::Cell *emu_ctrl = wrapper->addCell(ID(u_emu_ctrl), ID(loom_emu_ctrl));
         emu_ctrl->setParam(ID(N_DPI_FUNCS), n_dpi);
         emu_ctrl->setParam(ID(N_MEMORIES), n_memories);
-        emu_ctrl->setParam(ID(N_SCAN_CHAINS), 1);
+        emu_ctrl->setParam(ID(N_SCAN_CHAINS), n_scan_chains);
         emu_ctrl->setParam(ID(TOTAL_SCAN_BITS), scan_chain_length);
         emu_ctrl->setParam(ID(MAX_ARG_WIDTH), dut_args_width);
         emu_ctrl->setParam(ID(MAX_RET_WIDTH), dut_result_width);
         emu_ctrl->setParam(ID(MAX_ARGS), max_args);
         emu_ctrl->setParam(ID(SHELL_VERSION), (int)LOOM_SHELL_VERSION);
+        emu_ctrl->setParam(ID(TRACE_BITS), trace_width);
+        emu_ctrl->setParam(ID(WATCH_BITS), watch_width);
+        emu_ctrl->setParam(ID(N_INSTANCES), n_instances);
         for (int i = 0; i < 8; i++) {
             char pname[32];
             std::snprintf(pname, sizeof(pname), "DESIGN_HASH_%d", i);
@@ -587,6 +880,7 @@ struct EmuTopPass : public Pass {
         }
         emu_ctrl->setPort(ID(clk_i), clk_i);
         emu_ctrl->setPort(ID(rst_ni), rst_ni);
+        emu_ctrl->setPort(ID(instance_id_i), instance_id);
         // AXI-Lite (from demux master 0)
         emu_ctrl->setPort(ID(axil_araddr_i), addr_slice(demux_araddr, 0, 8));
         emu_ctrl->setPort(ID(axil_arvalid_i), bit(demux_arvalid, 0));
@@ -626,6 +920,15 @@ struct EmuTopPass : public Pass {
         emu_ctrl->setPort(ID(cycle_count_o), cycle_count);
         emu_ctrl->setPort(ID(finish_o), emu_finish);
         emu_ctrl->setPort(ID(irq_state_change_o), irq_state_change);
+        emu_ctrl->setPort(ID(irq_scan_done_o), irq_scan_done);
+        emu_ctrl->setPort(ID(irq_mem_done_o), irq_mem_done);
+        emu_ctrl->setPort(ID(scan_done_i), scan_done);
+        emu_ctrl->setPort(ID(mem_done_i), mem_done);
+        emu_ctrl->setPort(ID(trace_stall_i), trace_stall);
+        if (watch_data)
+            emu_ctrl->setPort(ID(watch_i), watch_data);
+        else
+            emu_ctrl->setPort(ID(watch_i), RTLIL::SigSpec(RTLIL::State::S0, 1));
         // FIFO ports
         if (has_dpi_fifo) {
             emu_ctrl->setPort(ID(fifo_wr_valid_o), fifo_wr_valid_w);
@@ -653,6 +956,11 @@ struct EmuTopPass : public Pass {
             dpi_regfile->setParam(ID(FIFO_ENTRY_WORDS), fifo_entry_words);
             dpi_regfile->setParam(ID(FIFO_DEPTH_LOG2), 10);  // 1024 entries
         }
+        if (has_xargs) {
+            dpi_regfile->setParam(ID(HAS_XARGS), 1);
+            dpi_regfile->setParam(ID(XARG_WORDS), xarg_words);
+            dpi_regfile->setParam(ID(XRES_WORDS), xres_words);
+        }
         dpi_regfile->setPort(ID(clk_i), clk_i);
         dpi_regfile->setPort(ID(rst_ni), rst_ni);
         dpi_regfile->setPort(ID(axil_araddr_i), addr_slice(demux_araddr, 1, 16));
@@ -678,6 +986,8 @@ struct EmuTopPass : public Pass {
         dpi_regfile->setPort(ID(dpi_ret_ready_i), dpi_ret_ready);
         dpi_regfile->setPort(ID(dpi_ret_data_o), dpi_ret_data);
         dpi_regfile->setPort(ID(dpi_stall_o), dpi_stall);
+        dpi_regfile->setPort(ID(dpi_xargs_i), dut_dpi_xargs);
+        dpi_regfile->setPort(ID(dpi_xresult_o), dut_dpi_xresult);
         // FIFO ports on regfile
         if (has_dpi_fifo) {
             dpi_regfile->setPort(ID(fifo_wr_valid_i), fifo_wr_valid_w);
@@ -700,16 +1010,48 @@ struct EmuTopPass : public Pass {
         // =========================================================================
         RTLIL::Cell *scan_ctrl = wrapper->addCell(ID(u_scan_ctrl), ID(loom_scan_ctrl));
         scan_ctrl->setParam(ID(CHAIN_LENGTH), scan_chain_length);
+        scan_ctrl->setParam(ID(N_CHAINS), n_scan_chains);
+        scan_ctrl->setParam(ID(CHAIN_BITS), scan_chain_bits);
+        // SCAN_DATA spans 0x10..0x7FFF, so larger images can only stream
+        int scan_words = (n_scan_chains * scan_chain_bits + 31) / 32;
+
+        // Reset image ROM, in stream entry order: entry w holds word w of
+        // every chain, chain c at bits [c*32 +: 32]
+        bool has_reset_rom = reset_rom && scan_chain_length > 0 &&
+                             dut->attributes.count(ID(loom_scan_init_image));
+        if (reset_rom && !has_reset_rom)
+            log_warning("-reset_rom: no initial scan image on '%s', ROM omitted\n",
+                        top_name.c_str());
+        if (has_reset_rom) {
+            const RTLIL::Const &image = dut->attributes.at(ID(loom_scan_init_image));
+            int wpc = (scan_chain_bits + 31) / 32;
+            RTLIL::Const rom(RTLIL::State::S0, wpc * n_scan_chains * 32);
+            for (int c = 0; c < n_scan_chains; c++)
+                for (int w = 0; w < wpc; w++)
+                    for (int b = 0; b < 32; b++) {
+                        int src = (c * wpc + w) * 32 + b;
+                        if (src < GetSize(image) && image[src] == RTLIL::State::S1)
+                            rom.bits()[(w * n_scan_chains + c) * 32 + b] = RTLIL::State::S1;
+                    }
+            scan_ctrl->setParam(ID(HAS_RESET_ROM), 1);
+            scan_ctrl->setParam(ID(RESET_ROM), rom);
+            log("  Reset image ROM: %d x %d bits\n", wpc, n_scan_chains * 32);
+        }
+
+        // With the ROM, the patch registers at 0x7F00 bound the data buffer
+        int max_buf_words = has_reset_rom ? 8124 : 8188;
+        bool scan_stream_only = scan_stream || scan_words > std::min(scan_buf_words, max_buf_words);
+        scan_ctrl->setParam(ID(STREAM_ONLY), scan_stream_only ? 1 : 0);
         scan_ctrl->setPort(ID(clk_i), clk_i);
         scan_ctrl->setPort(ID(rst_ni), rst_ni);
-        scan_ctrl->setPort(ID(axil_araddr_i), addr_slice(demux_araddr, 2, 12));
+        scan_ctrl->setPort(ID(axil_araddr_i), addr_slice(demux_araddr, 2, 16));
         scan_ctrl->setPort(ID(axil_arvalid_i), bit(demux_arvalid, 2));
         scan_ctrl->setPort(ID(axil_arready_o), bit(demux_arready, 2));
         scan_ctrl->setPort(ID(axil_rdata_o), slice(demux_rdata, 2, 32));
         scan_ctrl->setPort(ID(axil_rresp_o), slice(demux_rresp, 2, 2));
         scan_ctrl->setPort(ID(axil_rvalid_o), bit(demux_rvalid, 2));
         scan_ctrl->setPort(ID(axil_rready_i), bit(demux_rready, 2));
-        scan_ctrl->setPort(ID(axil_awaddr_i), addr_slice(demux_awaddr, 2, 12));
+        scan_ctrl->setPort(ID(axil_awaddr_i), addr_slice(demux_awaddr, 2, 16));
         scan_ctrl->setPort(ID(axil_awvalid_i), bit(demux_awvalid, 2));
         scan_ctrl->setPort(ID(axil_awready_o), bit(demux_awready, 2));
         scan_ctrl->setPort(ID(axil_wdata_i), slice(demux_wdata, 2, 32));
@@ -722,6 +1064,7 @@ struct EmuTopPass : public Pass {
         scan_ctrl->setPort(ID(scan_in_o), scan_in);
         scan_ctrl->setPort(ID(scan_out_i), scan_out);
         scan_ctrl->setPort(ID(scan_busy_o), scan_busy);
+        scan_ctrl->setPort(ID(scan_done_o), scan_done);
 
         // =========================================================================
         // Conditionally instantiate Memory Controller (4th AXI-Lite slave)
@@ -731,6 +1074,8 @@ struct EmuTopPass : public Pass {
         RTLIL::Wire *shadow_rdata_w = nullptr;
         RTLIL::Wire *shadow_wen_w = nullptr;
         RTLIL::Wire *shadow_ren_w = nullptr;
+        RTLIL::Wire *mem_wr_valid_w = nullptr;
+        RTLIL::Wire *mem_wr_addr_w = nullptr;
 
         if (has_memories) {
             shadow_addr_w  = wrapper->addWire(ID(shadow_addr), shadow_addr_bits);
@@ -743,29 +1088,78 @@ struct EmuTopPass : public Pass {
             mem_ctrl->setParam(ID(ADDR_BITS), shadow_addr_bits);
             mem_ctrl->setParam(ID(DATA_BITS), shadow_data_bits);
             mem_ctrl->setParam(ID(TOTAL_BYTES), (int)shadow_total_bytes);
+            mem_ctrl->setParam(ID(DIRTY_PAGE_BYTES), dirty_page_bytes);
+            mem_ctrl->setParam(ID(N_WR_PORTS), std::max(1, mem_wr_ports));
             mem_ctrl->setPort(ID(clk_i), clk_i);
             mem_ctrl->setPort(ID(rst_ni), rst_ni);
-            mem_ctrl->setPort(ID(axil_araddr_i), addr_slice(demux_araddr, 3, 12));
-            mem_ctrl->setPort(ID(axil_arvalid_i), bit(demux_arvalid, 3));
-            mem_ctrl->setPort(ID(axil_arready_o), bit(demux_arready, 3));
-            mem_ctrl->setPort(ID(axil_rdata_o), slice(demux_rdata, 3, 32));
-            mem_ctrl->setPort(ID(axil_rresp_o), slice(demux_rresp, 3, 2));
-            mem_ctrl->setPort(ID(axil_rvalid_o), bit(demux_rvalid, 3));
-            mem_ctrl->setPort(ID(axil_rready_i), bit(demux_rready, 3));
-            mem_ctrl->setPort(ID(axil_awaddr_i), addr_slice(demux_awaddr, 3, 12));
-            mem_ctrl->setPort(ID(axil_awvalid_i), bit(demux_awvalid, 3));
-            mem_ctrl->setPort(ID(axil_awready_o), bit(demux_awready, 3));
-            mem_ctrl->setPort(ID(axil_wdata_i), slice(demux_wdata, 3, 32));
-            mem_ctrl->setPort(ID(axil_wvalid_i), bit(demux_wvalid, 3));
-            mem_ctrl->setPort(ID(axil_wready_o), bit(demux_wready, 3));
-            mem_ctrl->setPort(ID(axil_bresp_o), slice(demux_bresp, 3, 2));
-            mem_ctrl->setPort(ID(axil_bvalid_o), bit(demux_bvalid, 3));
-            mem_ctrl->setPort(ID(axil_bready_i), bit(demux_bready, 3));
+            mem_ctrl->setPort(ID(axil_araddr_i), addr_slice(demux_araddr, mem_slot, 12));
+            mem_ctrl->setPort(ID(axil_arvalid_i), bit(demux_arvalid, mem_slot));
+            mem_ctrl->setPort(ID(axil_arready_o), bit(demux_arready, mem_slot));
+            mem_ctrl->setPort(ID(axil_rdata_o), slice(demux_rdata, mem_slot, 32));
+            mem_ctrl->setPort(ID(axil_rresp_o), slice(demux_rresp, mem_slot, 2));
+            mem_ctrl->setPort(ID(axil_rvalid_o), bit(demux_rvalid, mem_slot));
+            mem_ctrl->setPort(ID(axil_rready_i), bit(demux_rready, mem_slot));
+            mem_ctrl->setPort(ID(axil_awaddr_i), addr_slice(demux_awaddr, mem_slot, 12));
+            mem_ctrl->setPort(ID(axil_awvalid_i), bit(demux_awvalid, mem_slot));
+            mem_ctrl->setPort(ID(axil_awready_o), bit(demux_awready, mem_slot));
+            mem_ctrl->setPort(ID(axil_wdata_i), slice(demux_wdata, mem_slot, 32));
+            mem_ctrl->setPort(ID(axil_wvalid_i), bit(demux_wvalid, mem_slot));
+            mem_ctrl->setPort(ID(axil_wready_o), bit(demux_wready, mem_slot));
+            mem_ctrl->setPort(ID(axil_bresp_o), slice(demux_bresp, mem_slot, 2));
+            mem_ctrl->setPort(ID(axil_bvalid_o), bit(demux_bvalid, mem_slot));
+            mem_ctrl->setPort(ID(axil_bready_i), bit(demux_bready, mem_slot));
             mem_ctrl->setPort(ID(shadow_addr_o), shadow_addr_w);
             mem_ctrl->setPort(ID(shadow_wdata_o), shadow_wdata_w);
             mem_ctrl->setPort(ID(shadow_rdata_i), shadow_rdata_w);
             mem_ctrl->setPort(ID(shadow_wen_o), shadow_wen_w);
             mem_ctrl->setPort(ID(shadow_ren_o), shadow_ren_w);
+            mem_ctrl->setPort(ID(mem_done_o), mem_done);
+
+            mem_ctrl->setPort(ID(dut_en_i), loom_en_wire);
+            if (mem_wr_ports > 0) {
+                mem_wr_valid_w = wrapper->addWire(ID(mem_wr_valid), mem_wr_ports);
+                mem_wr_addr_w  = wrapper->addWire(ID(mem_wr_addr), mem_wr_ports * shadow_addr_bits);
+                mem_ctrl->setPort(ID(dut_wr_valid_i), mem_wr_valid_w);
+                mem_ctrl->setPort(ID(dut_wr_addr_i), mem_wr_addr_w);
+            } else {
+                mem_ctrl->setPort(ID(dut_wr_valid_i), RTLIL::SigSpec(RTLIL::State::S0, 1));
+                mem_ctrl->setPort(ID(dut_wr_addr_i), RTLIL::SigSpec(RTLIL::State::S0, shadow_addr_bits));
+            }
+        } else {
+            wrapper->connect(RTLIL::SigSpec(mem_done), RTLIL::SigSpec(RTLIL::State::S0));
+        }
+
+        // =========================================================================
+        // Instantiate Trace Controller (conditional)
+        // =========================================================================
+        if (has_trace) {
+            RTLIL::Cell *trace_ctrl = wrapper->addCell(ID(u_trace_ctrl), ID(loom_trace_ctrl));
+            trace_ctrl->setParam(ID(WIDTH), trace_width);
+            trace_ctrl->setParam(ID(DEPTH), trace_depth);
+            trace_ctrl->setPort(ID(clk_i), clk_i);
+            trace_ctrl->setPort(ID(rst_ni), rst_ni);
+            trace_ctrl->setPort(ID(axil_araddr_i), addr_slice(demux_araddr, trace_slot, 12));
+            trace_ctrl->setPort(ID(axil_arvalid_i), bit(demux_arvalid, trace_slot));
+            trace_ctrl->setPort(ID(axil_arready_o), bit(demux_arready, trace_slot));
+            trace_ctrl->setPort(ID(axil_rdata_o), slice(demux_rdata, trace_slot, 32));
+            trace_ctrl->setPort(ID(axil_rresp_o), slice(demux_rresp, trace_slot, 2));
+            trace_ctrl->setPort(ID(axil_rvalid_o), bit(demux_rvalid, trace_slot));
+            trace_ctrl->setPort(ID(axil_rready_i), bit(demux_rready, trace_slot));
+            trace_ctrl->setPort(ID(axil_awaddr_i), addr_slice(demux_awaddr, trace_slot, 12));
+            trace_ctrl->setPort(ID(axil_awvalid_i), bit(demux_awvalid, trace_slot));
+            trace_ctrl->setPort(ID(axil_awready_o), bit(demux_awready, trace_slot));
+            trace_ctrl->setPort(ID(axil_wdata_i), slice(demux_wdata, trace_slot, 32));
+            trace_ctrl->setPort(ID(axil_wvalid_i), bit(demux_wvalid, trace_slot));
+            trace_ctrl->setPort(ID(axil_wready_o), bit(demux_wready, trace_slot));
+            trace_ctrl->setPort(ID(axil_bresp_o), slice(demux_bresp, trace_slot, 2));
+            trace_ctrl->setPort(ID(axil_bvalid_o), bit(demux_bvalid, trace_slot));
+            trace_ctrl->setPort(ID(axil_bready_i), bit(demux_bready, trace_slot));
+            trace_ctrl->setPort(ID(dut_en_i), loom_en_wire);
+            trace_ctrl->setPort(ID(cycle_i), RTLIL::SigSpec(cycle_count, 0, 32));
+            trace_ctrl->setPort(ID(probe_i), trace_data);
+            trace_ctrl->setPort(ID(stall_o), trace_stall);
+        } else {
+            wrapper->connect(RTLIL::SigSpec(trace_stall), RTLIL::SigSpec(RTLIL::State::S0));
         }
 
         // =========================================================================
@@ -773,6 +1167,20 @@ struct EmuTopPass : public Pass {
         // =========================================================================
         RTLIL::Cell *dut_inst = wrapper->addCell(ID(u_dut), dut->name);
 
+        // Gated DUT clock: ticks while running or scanning
+        RTLIL::SigSpec dut_clk(clk_i);
+        if (clock_gated) {
+            RTLIL::Wire *dut_clk_en = wrapper->addWire(ID(dut_clk_en), 1);
+            wrapper->addOr(NEW_ID, RTLIL::SigSpec(loom_en_wire), RTLIL::SigSpec(scan_enable),
+                           RTLIL::SigSpec(dut_clk_en));
+            RTLIL::Wire *dut_clk_w = wrapper->addWire(ID(dut_clk), 1);
+            RTLIL::Cell *clk_gate = wrapper->addCell(ID(u_clk_gate), ID(loom_clk_gate));
+            clk_gate->setPort(ID(clk_i), clk_i);
+            clk_gate->setPort(ID(en_i), dut_clk_en);
+            clk_gate->setPort(ID(clk_o), dut_clk_w);
+            dut_clk = RTLIL::SigSpec(dut_clk_w);
+        }
+
         // Connect DUT ports
         bool dut_has_finish = false;
         bool dut_has_dpi = false;
@@ -782,9 +1190,9 @@ struct EmuTopPass : public Pass {
 
             std::string wire_name = wire->name.str();
 
-            // Handle clock - connect to ungated clock (free-running)
+            // Handle clock - free-running, or gated with -clock_gate
             if (wire->name == RTLIL::escape_id(clk_name)) {
-                dut_inst->setPort(wire->name, RTLIL::SigSpec(clk_i));
+                dut_inst->setPort(wire->name, dut_clk);
                 continue;
             }
 
@@ -819,6 +1227,19 @@ struct EmuTopPass : public Pass {
                 dut_inst->setPort(wire->name, RTLIL::SigSpec(dut_dpi_result));
                 continue;
             }
+            // Large-argument buses: zero-extended to the window's word count
+            if (wire->name == ID(loom_dpi_xargs) && wire->port_output) {
+                dut_inst->setPort(wire->name, RTLIL::SigSpec(dut_dpi_xargs).extract(0, GetSize(wire)));
+                if (GetSize(wire) < GetSize(dut_dpi_xargs))
+                    wrapper->connect(RTLIL::SigSpec(dut_dpi_xargs).extract(GetSize(wire),
+                                         GetSize(dut_dpi_xargs) - GetSize(wire)),
+                                     RTLIL::SigSpec(RTLIL::State::S0, GetSize(dut_dpi_xargs) - GetSize(wire)));
+                continue;
+            }
+            if (wire->name == ID(loom_dpi_xresult) && wire->port_input) {
+                dut_inst->setPort(wire->name, RTLIL::SigSpec(dut_dpi_xresult).extract(0, GetSize(wire)));
+                continue;
+            }
             if (wire_name.find("loom_dpi_ack") != std::string::npos) {
                 dut_inst->setPort(wire->name, RTLIL::SigSpec(dut_dpi_ack));
                 continue;
@@ -845,6 +1266,26 @@ struct EmuTopPass : public Pass {
                 continue;
             }
 
+            // Handle traced registers (scan_insert -trace)
+            if (wire->name == ID(loom_trace_data) && wire->port_output) {
+                if (trace_data && GetSize(trace_data) == GetSize(wire))
+                    dut_inst->setPort(wire->name, RTLIL::SigSpec(trace_data));
+                else
+                    dut_inst->setPort(wire->name, RTLIL::SigSpec(
+                        wrapper->addWire(wrapper->uniquify("\\unused_loom_trace_data"), GetSize(wire))));
+                continue;
+            }
+
+            // Handle watched registers (scan_insert -watch)
+            if (wire->name == ID(loom_watch_data) && wire->port_output) {
+                if (watch_data && GetSize(watch_data) == GetSize(wire))
+                    dut_inst->setPort(wire->name, RTLIL::SigSpec(watch_data));
+                else
+                    dut_inst->setPort(wire->name, RTLIL::SigSpec(
+                        wrapper->addWire(wrapper->uniquify("\\unused_loom_watch_data"), GetSize(wire))));
+                continue;
+            }
+
             // Handle shadow memory ports — wire to mem_ctrl or tie to zero
             if (wire_name.find("loom_shadow_addr") != std::string::npos && wire->port_input) {
                 if (has_memories && shadow_addr_w) {
@@ -888,6 +1329,17 @@ struct EmuTopPass : public Pass {
                 continue;
             }
 
+            // Handle write-port activity for dirty tracking
+            if ((wire_name.find("loom_mem_wr_valid") != std::string::npos ||
+                 wire_name.find("loom_mem_wr_addr") != std::string::npos) && wire->port_output) {
+                bool is_valid = wire_name.find("loom_mem_wr_valid") != std::string::npos;
+                RTLIL::Wire *w = is_valid ? mem_wr_valid_w : mem_wr_addr_w;
+                if (!w || GetSize(w) != GetSize(wire))
+                    w = wrapper->addWire(wrapper->uniquify("\\unused_" + wire_name.substr(1)), GetSize(wire));
+                dut_inst->setPort(wire->name, RTLIL::SigSpec(w));
+                continue;
+            }
+
             // All other inputs: tie to '0
             if (wire->port_input) {
                 dut_inst->setPort(wire->name, RTLIL::SigSpec(RTLIL::State::S0, GetSize(wire)));
@@ -910,6 +1362,9 @@ struct EmuTopPass : public Pass {
             wrapper->connect(RTLIL::SigSpec(dut_dpi_func_id), RTLIL::SigSpec(RTLIL::State::S0, 8));
             wrapper->connect(RTLIL::SigSpec(dut_dpi_args), RTLIL::SigSpec(RTLIL::State::S0, dut_args_width));
         }
+        if (dut_xargs_width == 0) {
+            wrapper->connect(RTLIL::SigSpec(dut_dpi_xargs), RTLIL::SigSpec(RTLIL::State::S0, xarg_words * 32));
+        }
 
         // =========================================================================
         // IRQ wiring
@@ -920,12 +1375,15 @@ struct EmuTopPass : public Pass {
         RTLIL::SigSpec irq_sig;
         irq_sig.append(RTLIL::SigSpec(irq_dpi));           // IRQ[0]
         irq_sig.append(RTLIL::SigSpec(irq_state_change));  // IRQ[1]
-        if (has_dpi_fifo) {
+        if (has_dpi_fifo)
             irq_sig.append(RTLIL::SigSpec(fifo_threshold_w));  // IRQ[2] = FIFO threshold
-            irq_sig.append(RTLIL::SigSpec(RTLIL::State::S0, n_irq - 3));  // IRQ[15:3]
-        } else {
-            irq_sig.append(RTLIL::SigSpec(RTLIL::State::S0, n_irq - 2));  // IRQ[15:2]
-        }
+        else
+            irq_sig.append(RTLIL::SigSpec(RTLIL::State::S0));
+        irq_sig.append(RTLIL::SigSpec(irq_scan_done));     // IRQ[3]
+        irq_sig.append(RTLIL::SigSpec(irq_mem_done));      // IRQ[4]
+        if (n_irq < irq_sig.size())
+            log_error("-n_irq %d is too small, need at least %d\n", n_irq, irq_sig.size());
+        irq_sig.append(RTLIL::SigSpec(RTLIL::State::S0, n_irq - irq_sig.size()));  // IRQ[15:5]
         wrapper->connect(RTLIL::SigSpec(irq_o), irq_sig);
 
         // =========================================================================
@@ -955,18 +1413,28 @@ struct EmuTopPass : public Pass {
 
         wrapper->fixup_ports();
 
-        log("Generated loom_emu_top module\n");
+        log("Generated %s module\n", log_id(wrapper));
         log("  Instantiated: loom_axil_demux (u_interconnect) - %d masters\n", n_demux_masters);
         log("  Instantiated: loom_emu_ctrl (u_emu_ctrl) - controls loom_en + DPI bridge\n");
         log("  Instantiated: loom_dpi_regfile (u_dpi_regfile)\n");
-        log("  Instantiated: loom_scan_ctrl (u_scan_ctrl) - %d bits\n", scan_chain_length);
+        log("  Instantiated: loom_scan_ctrl (u_scan_ctrl) - %d bits, %d chain(s)%s\n",
+            scan_chain_length, n_scan_chains, scan_stream_only ? ", stream only" : "");
         if (has_memories)
             log("  Instantiated: loom_mem_ctrl (u_mem_ctrl) - %d memories, %u bytes\n",
                 n_memories, shadow_total_bytes);
+        if (has_trace)
+            log("  Instantiated: loom_trace_ctrl (u_trace_ctrl) - %d bits x %d entries\n",
+                trace_width, trace_depth);
         if (has_dpi_fifo)
             log("  DPI FIFO: %d read-only functions, entry_words=%d\n",
                 n_ro_dpi_funcs, fifo_entry_words);
-        log("  Instantiated: %s (u_dut) - clock free-running, loom_en for FF enable\n", top_name.c_str());
+        if (clock_gated)
+            log("  Instantiated: loom_clk_gate (u_clk_gate) - DUT clock enabled by loom_en | scan_enable\n");
+        log("  Instantiated: %s (u_dut) - %s\n", top_name.c_str(),
+            clock_gated ? "gated clock" : "clock free-running, loom_en for FF enable");
+
+        if (n_instances > 1)
+            build_instance_top(design, wrapper, n_instances, addr_width);
     }
 };
 
@@ -8,7 +8,10 @@
  *   2. Transforms $__loom_finish cells into hardware output signals.
  *   3. Adds flip-flop enable (loom_en) so the DUT can be frozen while
  *      the clock runs free.  scan_enable overrides loom_en so scanning
- *      always works.
+ *      always works.  With -clock_gate, emu_top gates the DUT clock
+ *      instead and FFs keep their original enables.
+ *   4. Turns $cover cells into saturating hit counters (and optionally
+ *      first-hit cycle stamps) on the scan chain, named loom_cover.*.
  *
  * IMPORTANT: DPI calls must only appear in clocked (always_ff) blocks.
  *
@@ -17,18 +20,24 @@
  *   - loom_dpi_func_id: Function identifier (output)
  *   - loom_dpi_args:    Packed function arguments (output)
  *   - loom_dpi_result:  Return value from host (input)
+ *   - loom_dpi_xargs:   Input arrays of large-argument functions (output)
+ *   - loom_dpi_xresult: Output arrays of large-argument functions (input)
  *   - loom_en:          Flip-flop enable (input)
  *
  * The pass also outputs:
  *   - JSON metadata for host-side integration
  *   - C header with function prototypes for user implementation
+ *   - Display map (-display_map): format strings of the $display calls,
+ *     so the host can log raw DPI FIFO entries and format them offline
  */
 
 #include "kernel/yosys.h"
 #include "kernel/sigtools.h"
 #include "kernel/mem.h"
 #include "kernel/fmt.h"
+#include "loom_snapshot.pb.h"
 #include <fstream>
+#include <memory>
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
@@ -37,6 +46,7 @@ PRIVATE_NAMESPACE_BEGIN
 constexpr int LOOM_MAILBOX_BASE = 0x00000;
 constexpr int LOOM_DPI_BASE = 0x10000;
 constexpr int FUNC_BLOCK_ALIGN = 64;  // Bytes per function block
+constexpr int REGFILE_MAX_ARGS = 12;  // Arg registers that fit in a function block
 
 // Argument descriptor
 struct DpiArg {
@@ -64,6 +74,7 @@ struct DpiFunction {
     RTLIL::SigSpec valid_condition;  // Derived execution condition (populated after derive)
     bool builtin = false;            // true for loom-provided functions (__loom_display_*)
     bool call_at_init = false;       // execute before emulation starts (initial/reset DPI)
+    bool large = false;              // arrays go through the regfile scratch window
     std::vector<uint32_t> const_arg_words;  // pre-packed constant args (for call_at_init)
 };
 
@@ -80,6 +91,7 @@ struct LoomInstrumentPass : public Pass {
         log("  1. DPI bridge: convert $__loom_dpi_call cells to hardware interfaces\n");
         log("  2. $finish transform: convert $__loom_finish cells to output ports\n");
         log("  3. Flop enable: add loom_en input that freezes all FFs\n");
+        log("  4. Coverage: count $cover hits in scan-readable registers\n");
         log("\n");
         log("IMPORTANT: DPI calls must only appear in clocked (always_ff) blocks.\n");
         log("\n");
@@ -88,12 +100,36 @@ struct LoomInstrumentPass : public Pass {
         log("        Write C header file with DPI function prototypes.\n");
         log("        Users implement these functions for host-side dispatch.\n");
         log("\n");
+        log("    -display_map <file>\n");
+        log("        Write the format string and argument widths of every converted\n");
+        log("        $display/$write call to a protobuf DisplayMap, for rendering\n");
+        log("        binary display logs (loomx -display-log) offline.\n");
+        log("\n");
+        log("    -cover_bits <N>\n");
+        log("        Width of the saturating hit counter built for each $cover cell\n");
+        log("        (default: 32). 0 removes $cover cells instead.\n");
+        log("\n");
+        log("    -cover_first\n");
+        log("        Also record the cycle of each cover's first hit (64 bits per\n");
+        log("        cover, plus one shared 64-bit cycle counter).\n");
+        log("\n");
+        log("    -clock_gate\n");
+        log("        Freeze the DUT by gating its clock (emu_top adds a BUFGCE)\n");
+        log("        instead of adding loom_en to every FF. Only FFs with their\n");
+        log("        own enable get a scan_enable override. Needs a single clock\n");
+        log("        port and no memories; otherwise flop enables are used.\n");
+        log("\n");
         log("DUT ports created:\n");
         log("  - loom_en:          FF enable (input, freezes DUT when low)\n");
         log("  - loom_dpi_valid:   DPI call pending (output)\n");
         log("  - loom_dpi_func_id: Function identifier (output, 8-bit)\n");
         log("  - loom_dpi_args:    Packed function arguments (output)\n");
         log("  - loom_dpi_result:  Return value from host (input)\n");
+        log("  - loom_dpi_xargs:   Large input arrays (output, only when needed)\n");
+        log("  - loom_dpi_xresult: Large output arrays (input, only when needed)\n");
+        log("\n");
+        log("A function whose arguments need more than %d arg registers passes\n", REGFILE_MAX_ARGS);
+        log("all of its arrays through the DPI regfile's scratch window instead.\n");
         log("\n");
     }
 
@@ -135,7 +171,11 @@ struct LoomInstrumentPass : public Pass {
         log_header(design, "Executing LOOM_INSTRUMENT pass.\n");
 
         bool gen_wrapper = false;
+        bool clock_gate = false;
+        int cover_bits = 32;
+        bool cover_first = false;
         std::string header_out_path;
+        std::string display_map_path;
 
         size_t argidx;
         for (argidx = 1; argidx < args.size(); argidx++) {
@@ -147,6 +187,24 @@ struct LoomInstrumentPass : public Pass {
                 header_out_path = args[++argidx];
                 continue;
             }
+            if (args[argidx] == "-display_map" && argidx + 1 < args.size()) {
+                display_map_path = args[++argidx];
+                continue;
+            }
+            if (args[argidx] == "-clock_gate") {
+                clock_gate = true;
+                continue;
+            }
+            if (args[argidx] == "-cover_bits" && argidx + 1 < args.size()) {
+                cover_bits = atoi(args[++argidx].c_str());
+                if (cover_bits < 0 || cover_bits > 64)
+                    log_cmd_error("-cover_bits must be between 0 and 64\n");
+                continue;
+            }
+            if (args[argidx] == "-cover_first") {
+                cover_first = true;
+                continue;
+            }
             break;
         }
         extra_args(args, argidx, design);
@@ -160,6 +218,12 @@ struct LoomInstrumentPass : public Pass {
             // Transform $print cells into $__loom_dpi_call cells
             process_print_cells(module);
 
+            // Build hit counters for $cover cells (before process_assert_cells
+            // drops the remaining formal cells, and before flop enable so the
+            // counters freeze with the DUT)
+            if (cover_bits > 0)
+                process_cover_cells(module, cover_bits, cover_first);
+
             // Transform $assert cells into DPI display calls + failure signals
             // (must run before DPI bridge processing collects $__loom_dpi_call cells)
             std::vector<RTLIL::SigBit> assert_fail_sigs;
@@ -179,6 +243,7 @@ struct LoomInstrumentPass : public Pass {
                 log("  No DPI call cells found.\n");
             } else {
                 log("  Found %zu DPI call cell(s)\n", cells_to_process.size());
+                std::unique_ptr<ValidConditionIndex> valid_index;
 
                 // First pass: collect all DPI function info
                 for (auto cell : cells_to_process) {
@@ -335,7 +400,12 @@ struct LoomInstrumentPass : public Pass {
                     func.func_id = hw_func_id++;
 
                     // Derive valid condition before removing the cell
-                    func.valid_condition = derive_valid_condition(module, func);
+                    func.valid_condition = derive_valid_condition(module, func, valid_index);
+
+                    func.large = needs_large_args(func);
+                    if (func.large)
+                        log("  Function '%s' (ID %d): large arrays (%d in / %d out words) via scratch window\n",
+                            func.name.c_str(), func.func_id, xarg_words(func), xres_words(func));
 
                     module_functions.push_back(func);
                     dpi_functions.push_back(func);
@@ -399,7 +469,7 @@ struct LoomInstrumentPass : public Pass {
             process_finish_cells(module, assert_fail_sigs);
 
             // Add flop enable logic (must run after DPI bridge and finish processing)
-            run_flop_enable(module);
+            run_flop_enable(module, clock_gate);
         }
 
         // Assign dispatch-only IDs to init/reset DPI functions (after all
@@ -427,6 +497,10 @@ struct LoomInstrumentPass : public Pass {
             write_c_header(dpi_functions, header_out_path);
         }
 
+        if (!display_map_path.empty()) {
+            write_display_map(dpi_functions, display_map_path);
+        }
+
         log("Processed %zu DPI function(s) (%d hardware, %zu init/reset)\n",
             dpi_functions.size(), hw_func_id,
             dpi_functions.size() - hw_func_id);
@@ -440,8 +514,44 @@ struct LoomInstrumentPass : public Pass {
     //   - loom_en=0, scan_enable=0 → FF frozen
     //   - loom_en=1, scan_enable=0 → normal operation (original EN honored)
     //   - scan_enable=1            → FF always enabled (scan shift override)
+    //
+    // With clock_gate, emu_top gates the DUT clock with loom_en | scan_enable
+    // and the FFs are left alone, apart from scan_enable overriding their
+    // own enables. This removes the loom_en fanout and the per-FF enable
+    // logic from the critical path.
+
+    // The clock port all FFs share, or an empty string if the module can't
+    // be frozen by gating one clock: memories need their shadow ports
+    // clocked while the DUT is frozen, and other clocks would keep running.
+    static std::string gateable_clock(RTLIL::Module *module,
+                                      const std::vector<RTLIL::Cell*> &dffs,
+                                      const std::vector<Mem> &mems) {
+        if (!mems.empty()) {
+            log_warning("-clock_gate: %s has %zu memories, using flop enables\n",
+                        log_id(module), mems.size());
+            return "";
+        }
+        SigMap sigmap(module);
+        pool<RTLIL::SigBit> clocks;
+        for (auto cell : dffs) {
+            if (cell->hasPort(ID::CLK))
+                clocks.insert(sigmap(cell->getPort(ID::CLK)[0]));
+        }
+        if (clocks.size() != 1) {
+            log_warning("-clock_gate: %s has %zu FF clocks, using flop enables\n",
+                        log_id(module), clocks.size());
+            return "";
+        }
+        RTLIL::SigBit clk = *clocks.begin();
+        if (!clk.wire || !clk.wire->port_input || clk.wire->width != 1) {
+            log_warning("-clock_gate: %s FF clock is not a 1-bit input port, using flop enables\n",
+                        log_id(module));
+            return "";
+        }
+        return clk.wire->name.str();
+    }
 
-    void run_flop_enable(RTLIL::Module *module) {
+    void run_flop_enable(RTLIL::Module *module, bool clock_gate) {
         // Collect FFs, skipping memory output registers
         std::vector<RTLIL::Cell*> dffs;
         for (auto cell : module->cells()) {
@@ -476,7 +586,11 @@ struct LoomInstrumentPass : public Pass {
             return;
         }
 
-        log("  Instrumenting %zu FF(s) with loom_en\n", dffs.size());
+        std::string gated_clk = clock_gate ? gateable_clock(module, dffs, mems) : "";
+        if (gated_clk.empty())
+            log("  Instrumenting %zu FF(s) with loom_en\n", dffs.size());
+        else
+            log("  Gating clock %s with loom_en (%zu FF(s))\n", gated_clk.c_str(), dffs.size());
 
         // Add loom_en input port
         RTLIL::Wire *loom_en = module->addWire(ID(loom_en), 1);
@@ -491,6 +605,32 @@ struct LoomInstrumentPass : public Pass {
             module->fixup_ports();
         }
 
+        if (!gated_clk.empty()) {
+            // The gated clock only ticks on loom_en | scan_enable, so an FF
+            // without an enable is already frozen; one with its own enable
+            // must still shift while scanning: new_EN = active_en | scan_enable
+            int n_overridden = 0;
+            for (auto cell : dffs) {
+                if (!has_enable(cell))
+                    continue;
+                RTLIL::SigSpec active_en = cell->getPort(ID::EN);
+                if (cell->getParam(ID::EN_POLARITY).as_int() != 1) {
+                    RTLIL::Wire *inv_wire = module->addWire(NEW_ID, 1);
+                    module->addNot(NEW_ID, active_en, RTLIL::SigSpec(inv_wire));
+                    active_en = RTLIL::SigSpec(inv_wire);
+                }
+                RTLIL::Wire *final_wire = module->addWire(NEW_ID, 1);
+                module->addOr(NEW_ID, active_en, RTLIL::SigSpec(scan_enable), RTLIL::SigSpec(final_wire));
+                cell->setPort(ID::EN, RTLIL::SigSpec(final_wire));
+                cell->setParam(ID::EN_POLARITY, RTLIL::Const(1, 1));
+                n_overridden++;
+            }
+            module->set_string_attribute(ID(loom_clock_gate), RTLIL::unescape_id(gated_clk));
+            module->fixup_ports();
+            log("  Added loom_en port, %d FF enable(s) overridden by scan_enable\n", n_overridden);
+            return;
+        }
+
         // Build combined_en = loom_en | loom_scan_enable
         RTLIL::Wire *comb_wire = module->addWire(NEW_ID, 1);
         module->addOr(NEW_ID, RTLIL::SigSpec(loom_en), RTLIL::SigSpec(scan_enable), RTLIL::SigSpec(comb_wire));
@@ -618,12 +758,66 @@ struct LoomInstrumentPass : public Pass {
         return result;
     }
 
+    // Select-input lookup for derive_valid_condition, built once per module.
+    // Maps (sigmapped B-input bit, bit position within the case) to the
+    // first $pmux case / $mux reading it, in module cell order, so each DPI
+    // call is resolved in O(result width) instead of a walk over all cells.
+    struct ValidConditionIndex {
+        struct Hit { int order = 0; RTLIL::Cell *cell = nullptr; int case_idx = 0; };
+        using Key = std::pair<RTLIL::SigBit, int>;
+
+        SigMap sigmap;
+        dict<Key, Hit> pmux_cases;
+        dict<Key, Hit> mux_inputs;
+
+        explicit ValidConditionIndex(RTLIL::Module *module) : sigmap(module) {
+            int order = 0;
+            for (auto cell : module->cells()) {
+                order++;
+                if (cell->type == ID($pmux)) {
+                    RTLIL::SigSpec port_b = sigmap(cell->getPort(ID::B));
+                    int width = GetSize(cell->getPort(ID::A));
+                    int n_cases = GetSize(cell->getPort(ID::S));
+                    for (int case_idx = 0; case_idx < n_cases; case_idx++)
+                        for (int i = 0; i < width; i++) {
+                            Key key(port_b[case_idx * width + i], i);
+                            if (!pmux_cases.count(key))
+                                pmux_cases[key] = Hit{order, cell, case_idx};
+                        }
+                } else if (cell->type == ID($mux)) {
+                    RTLIL::SigSpec port_b = sigmap(cell->getPort(ID::B));
+                    for (int i = 0; i < GetSize(port_b); i++) {
+                        Key key(port_b[i], i);
+                        if (!mux_inputs.count(key))
+                            mux_inputs[key] = Hit{order, cell, 0};
+                    }
+                }
+            }
+        }
+
+        // First cell (in module order, then first case) with any bit i of
+        // its input equal to bit i of `sig`, as a linear scan would find it
+        static const Hit *first_match(const dict<Key, Hit> &index, const RTLIL::SigSpec &sig) {
+            const Hit *best = nullptr;
+            for (int i = 0; i < GetSize(sig); i++) {
+                auto it = index.find(Key(sig[i], i));
+                if (it == index.end())
+                    continue;
+                const Hit &h = it->second;
+                if (!best || h.order < best->order ||
+                    (h.order == best->order && h.case_idx < best->case_idx))
+                    best = &h;
+            }
+            return best;
+        }
+    };
+
     // Derive the execution condition for a DPI call.
     // Prefers the EN port (set by yosys-slang's set_effects_trigger) if available.
-    // Falls back to tracing the RESULT signal through pmux/mux select bits.
-    RTLIL::SigSpec derive_valid_condition(RTLIL::Module *module, const DpiFunction &func) {
-        SigMap sigmap(module);
-
+    // Falls back to tracing the RESULT signal through pmux/mux select bits;
+    // `index` is built on first use and reused for the module's other calls.
+    RTLIL::SigSpec derive_valid_condition(RTLIL::Module *module, const DpiFunction &func,
+                                          std::unique_ptr<ValidConditionIndex> &index) {
         // If the cell has an EN port (set by yosys-slang for procedural calls),
         // use it directly as the valid condition.
         if (func.cell->hasPort(ID::EN)) {
@@ -634,7 +828,10 @@ struct LoomInstrumentPass : public Pass {
             }
         }
 
-        RTLIL::SigSpec result_sig = sigmap(func.result_sig);
+        if (!index)
+            index = std::make_unique<ValidConditionIndex>(module);
+
+        RTLIL::SigSpec result_sig = index->sigmap(func.result_sig);
         if (GetSize(result_sig) == 0) {
             log_warning("    No result signal and no EN port, defaulting to valid=1\n");
             return RTLIL::SigSpec(RTLIL::State::S1);
@@ -643,55 +840,19 @@ struct LoomInstrumentPass : public Pass {
         log("    Tracing result signal: %s\n", log_signal(result_sig));
 
         // Find the $pmux that uses this DPI result and extract the specific select bit.
-        for (auto cell : module->cells()) {
-            if (cell->type != ID($pmux))
-                continue;
-
-            RTLIL::SigSpec port_b = sigmap(cell->getPort(ID::B));
-            RTLIL::SigSpec port_s = cell->getPort(ID::S);
-            int width = GetSize(cell->getPort(ID::A));
-            int n_cases = GetSize(port_s);
-
-            for (int case_idx = 0; case_idx < n_cases; case_idx++) {
-                RTLIL::SigSpec case_input = sigmap(port_b.extract(case_idx * width, width));
-
-                bool matches = false;
-                for (int i = 0; i < GetSize(case_input) && i < GetSize(result_sig); i++) {
-                    if (case_input[i] == result_sig[i]) {
-                        matches = true;
-                        break;
-                    }
-                }
-
-                if (matches) {
-                    RTLIL::SigBit sel_bit = port_s[case_idx];
-                    log("    Found valid condition: %s (case %d of %s)\n",
-                        log_signal(sel_bit), case_idx, log_id(cell));
-                    return RTLIL::SigSpec(sel_bit);
-                }
-            }
+        if (auto *hit = ValidConditionIndex::first_match(index->pmux_cases, result_sig)) {
+            RTLIL::SigBit sel_bit = hit->cell->getPort(ID::S)[hit->case_idx];
+            log("    Found valid condition: %s (case %d of %s)\n",
+                log_signal(sel_bit), hit->case_idx, log_id(hit->cell));
+            return RTLIL::SigSpec(sel_bit);
         }
 
         // Fallback: check for simple 2:1 $mux (single DPI call case)
-        for (auto cell : module->cells()) {
-            if (cell->type != ID($mux))
-                continue;
-
-            RTLIL::SigSpec port_b = sigmap(cell->getPort(ID::B));
-            bool matches = false;
-            for (int i = 0; i < GetSize(port_b) && i < GetSize(result_sig); i++) {
-                if (port_b[i] == result_sig[i]) {
-                    matches = true;
-                    break;
-                }
-            }
-
-            if (matches) {
-                RTLIL::SigSpec sel = cell->getPort(ID::S);
-                log("    Found valid condition: %s (from $mux %s)\n",
-                    log_signal(sel), log_id(cell));
-                return sel;
-            }
+        if (auto *hit = ValidConditionIndex::first_match(index->mux_inputs, result_sig)) {
+            RTLIL::SigSpec sel = hit->cell->getPort(ID::S);
+            log("    Found valid condition: %s (from $mux %s)\n",
+                log_signal(sel), log_id(hit->cell));
+            return sel;
         }
 
         log_warning("    Could not derive valid condition for DPI call '%s'\n", func.name.c_str());
@@ -752,6 +913,7 @@ struct LoomInstrumentPass : public Pass {
                         else if (ch == '"') c_fmt += "\\\"";
                         else if (ch == '\n') c_fmt += "\\n";
                         else if (ch == '\t') c_fmt += "\\t";
+                        else if (ch == '%') c_fmt += "%%";
                         else c_fmt += ch;
                     }
                 } else if (part.type == FmtPart::INTEGER) {
@@ -847,6 +1009,123 @@ struct LoomInstrumentPass : public Pass {
         }
     }
 
+    // =========================================================================
+    // Coverage Counters
+    // =========================================================================
+    //
+    // Each $cover cell becomes a saturating counter of the cycles where
+    // EN & A holds, clocked by the module's main clock. The counters are
+    // ordinary FFs, so scan_insert puts them on the chain and the host
+    // reads them from any scan capture or snapshot with no extra hardware
+    // or DPI traffic. Scan map names (via hdlname):
+    //   loom_cover.<label>.hits    hit count, all ones = saturated
+    //   loom_cover.<label>.first   cycle of the first hit (-cover_first)
+    //   loom_cover.cycle           enabled-cycle counter the stamps use
+    // The cover's source location goes to the scan map via loom_cover_src.
+
+    // The clock driving most FFs of the module
+    static RTLIL::SigBit main_clock(RTLIL::Module *module) {
+        SigMap sigmap(module);
+        dict<RTLIL::SigBit, int> counts;
+        for (auto cell : module->cells())
+            if (is_ff(cell) && cell->hasPort(ID::CLK))
+                counts[sigmap(cell->getPort(ID::CLK)[0])]++;
+        RTLIL::SigBit best;
+        int best_count = 0;
+        for (auto &it : counts)
+            if (it.second > best_count) {
+                best = it.first;
+                best_count = it.second;
+            }
+        return best;
+    }
+
+    void process_cover_cells(RTLIL::Module *module, int cover_bits, bool cover_first) {
+        std::vector<RTLIL::Cell*> cover_cells;
+        for (auto cell : module->cells())
+            if (cell->type == ID($cover))
+                cover_cells.push_back(cell);
+        if (cover_cells.empty())
+            return;
+
+        RTLIL::SigBit clk = main_clock(module);
+        if (clk == RTLIL::SigBit()) {
+            log_warning("%s has %zu $cover cell(s) but no clocked FFs; not counting them\n",
+                        log_id(module), cover_cells.size());
+            return;
+        }
+
+        // Counter FFs have no fanout, so keep them through opt_clean
+        auto add_counter_ff = [&](const std::string &wire_name, const std::string &hdlname,
+                                  RTLIL::SigSpec d, RTLIL::SigSpec en, int width) {
+            RTLIL::Wire *q = module->addWire(RTLIL::escape_id(wire_name), width);
+            q->set_string_attribute(ID::hdlname, hdlname);
+            q->set_bool_attribute(ID::keep);
+            RTLIL::Cell *ff = en.empty() ? module->addDff(NEW_ID, clk, d, q)
+                                         : module->addDffe(NEW_ID, clk, en, d, q);
+            ff->set_bool_attribute(ID::keep);
+            return q;
+        };
+
+        RTLIL::Wire *cycle = nullptr;
+        if (cover_first) {
+            RTLIL::Wire *cycle_next = module->addWire(NEW_ID, 64);
+            cycle = add_counter_ff("loom_cover_cycle", "loom_cover cycle", cycle_next, {}, 64);
+            module->addAdd(NEW_ID, cycle, RTLIL::Const(1, 64), cycle_next);
+        }
+
+        int idx = 0;
+        for (auto cell : cover_cells) {
+            // Label: the HDL name of the cover, else its index
+            std::string label;
+            if (cell->has_attribute(ID::hdlname))
+                label = cell->get_string_attribute(ID::hdlname);
+            else if (cell->name.isPublic())
+                label = cell->name.str().substr(1);
+            else
+                label = "cover" + std::to_string(idx);
+            for (auto &ch : label)
+                if (ch == ' ') ch = '.';
+            std::string hdl_label = label;
+            for (auto &ch : hdl_label)
+                if (ch == '.') ch = ' ';
+
+            // hit = EN & A; count while not saturated
+            RTLIL::Wire *hit = module->addWire(NEW_ID, 1);
+            module->addAnd(NEW_ID, cell->getPort(ID::EN), cell->getPort(ID::A), hit);
+
+            std::string prefix = "loom_cover_" + std::to_string(idx);
+            RTLIL::Wire *hits_next = module->addWire(NEW_ID, cover_bits);
+            RTLIL::Wire *inc = module->addWire(NEW_ID, 1);
+            RTLIL::Wire *hits = add_counter_ff(prefix + "_hits", "loom_cover " + hdl_label + " hits",
+                                               hits_next, inc, cover_bits);
+            hits->set_string_attribute(ID(loom_cover_src), cell->get_src_attribute());
+            module->addAdd(NEW_ID, hits, RTLIL::Const(1, cover_bits), hits_next);
+            RTLIL::Wire *saturated = module->addWire(NEW_ID, 1);
+            module->addReduceAnd(NEW_ID, hits, saturated);
+            RTLIL::Wire *not_saturated = module->addWire(NEW_ID, 1);
+            module->addNot(NEW_ID, saturated, not_saturated);
+            module->addAnd(NEW_ID, hit, not_saturated, inc);
+
+            if (cover_first) {
+                // Stamp the cycle on the hit that finds the counter at zero
+                RTLIL::Wire *first_hit = module->addWire(NEW_ID, 1);
+                RTLIL::Wire *none_yet = module->addWire(NEW_ID, 1);
+                module->addLogicNot(NEW_ID, hits, none_yet);
+                module->addAnd(NEW_ID, hit, none_yet, first_hit);
+                RTLIL::Wire *first = add_counter_ff(prefix + "_first", "loom_cover " + hdl_label + " first",
+                                                    cycle, first_hit, 64);
+                first->set_string_attribute(ID(loom_cover_src), cell->get_src_attribute());
+            }
+
+            log("    $cover %s → loom_cover.%s (%d-bit counter%s)\n", log_id(cell),
+                label.c_str(), cover_bits, cover_first ? ", first-hit stamp" : "");
+            module->remove(cell);
+            idx++;
+        }
+        log("  Built %d coverage counter(s)\n", idx);
+    }
+
     // Process formal cells ($assert, $assume, $cover) from chformal -lower.
     // For $assert: generate a DPI display call with failure message and
     // collect failure signals for loom_finish_o.
@@ -1000,27 +1279,47 @@ struct LoomInstrumentPass : public Pass {
     bool is_read_only(const DpiFunction &func) {
         if (func.ret_width != 0) return false;
         if (func.call_at_init) return false;
+        if (func.large) return false;  // FIFO entries only carry the arg registers
         for (const auto &arg : func.args) {
             if (arg.direction != "input") return false;
         }
         return true;
     }
 
-    // Compute input-only arg width (excluding output arrays).
+    // A function needs the scratch window when its arrays do not fit the
+    // arg registers; then all of its arrays move there, scalars stay.
+    bool needs_large_args(const DpiFunction &func) {
+        if (func.call_at_init || func.builtin) return false;
+        int in_words = 0, out_words = 0;
+        bool has_array = false;
+        for (const auto &arg : func.args) {
+            if (arg.type == "string") continue;
+            has_array |= arg.is_array;
+            if (arg.is_array && arg.direction == "output")
+                out_words += (arg.width + 31) / 32;
+            else
+                in_words += (arg.width + 31) / 32;
+        }
+        return has_array && std::max(in_words, out_words) > REGFILE_MAX_ARGS;
+    }
+
+    // Compute input-only arg width (excluding output arrays, and all arrays
+    // of large-argument functions).
     int input_arg_width(const DpiFunction &func) {
         int w = 0;
         for (const auto &arg : func.args) {
             if (arg.type == "string") continue;
-            if (arg.is_array && arg.direction == "output") continue;
+            if (arg.is_array && (func.large || arg.direction == "output")) continue;
             // Each arg occupies a 32-bit word slot (matching regfile layout)
             w += ((arg.width + 31) / 32) * 32;
         }
         return w;
     }
 
-    // Compute output array total width for a function.
+    // Compute output array total width for a function (regfile path only).
     int output_array_width(const DpiFunction &func) {
         int w = 0;
+        if (func.large) return 0;
         for (const auto &arg : func.args) {
             if (arg.is_array && arg.direction == "output")
                 w += arg.width;
@@ -1028,6 +1327,24 @@ struct LoomInstrumentPass : public Pass {
         return w;
     }
 
+    // Scratch window words of a large-argument function: its input arrays,
+    // and its output arrays, each in argument order, one element per word.
+    int xarg_words(const DpiFunction &func) {
+        int words = 0;
+        if (!func.large) return 0;
+        for (const auto &arg : func.args)
+            if (arg.is_array && arg.direction != "output") words += arg.n_elements;
+        return words;
+    }
+
+    int xres_words(const DpiFunction &func) {
+        int words = 0;
+        if (!func.large) return 0;
+        for (const auto &arg : func.args)
+            if (arg.is_array && arg.direction == "output") words += arg.n_elements;
+        return words;
+    }
+
     // Create bridge interface with proper multiplexing for multiple DPI functions.
     void create_bridge_interface(RTLIL::Module *module, std::vector<DpiFunction> &functions) {
         // Calculate maximum widths across all functions.
@@ -1046,6 +1363,14 @@ struct LoomInstrumentPass : public Pass {
         if (max_arg_width < 1) max_arg_width = 1;
         if (max_ret_width < 1) max_ret_width = 1;
 
+        // Large-argument buses, only created when some function needs them
+        int max_xarg_words = 0;
+        int max_xres_words = 0;
+        for (const auto &func : functions) {
+            max_xarg_words = std::max(max_xarg_words, xarg_words(func));
+            max_xres_words = std::max(max_xres_words, xres_words(func));
+        }
+
         // Create bridge interface ports
         RTLIL::Wire *dpi_valid = module->addWire(ID(loom_dpi_valid), 1);
         dpi_valid->port_output = true;
@@ -1059,6 +1384,49 @@ struct LoomInstrumentPass : public Pass {
         RTLIL::Wire *dpi_result_in = module->addWire(ID(loom_dpi_result), max_ret_width);
         dpi_result_in->port_input = true;
 
+        RTLIL::Wire *dpi_xargs_out = nullptr;
+        RTLIL::Wire *dpi_xresult_in = nullptr;
+        if (max_xarg_words > 0) {
+            dpi_xargs_out = module->addWire(ID(loom_dpi_xargs), max_xarg_words * 32);
+            dpi_xargs_out->port_output = true;
+        }
+        if (max_xres_words > 0) {
+            dpi_xresult_in = module->addWire(ID(loom_dpi_xresult), max_xres_words * 32);
+            dpi_xresult_in->port_input = true;
+        }
+
+        // Helper: for a large-argument function, gather its input arrays onto
+        // the xargs bus and connect its output arrays from the xresult bus.
+        // Element j of an array lands in window word base+j, so the host can
+        // hand the window words to the callback unchanged. Yosys puts
+        // element[0] at the MSB of the flattened wire, hence the reversal.
+        auto connect_func_xargs = [&](const DpiFunction &func) {
+            RTLIL::SigSpec xargs;
+            int bit_offset = 0;
+            int out_word = 0;
+            for (const auto &arg : func.args) {
+                if (arg.type == "string") continue;
+                if (!arg.is_array) {
+                    bit_offset += arg.width;
+                    continue;
+                }
+                int n = arg.n_elements;
+                for (int j = 0; j < n; j++) {
+                    RTLIL::SigSpec elem = func.args_sig.extract(bit_offset + (n - 1 - j) * 32, 32);
+                    if (arg.direction == "output")
+                        module->connect(elem,
+                            RTLIL::SigSpec(dpi_xresult_in).extract((out_word + j) * 32, 32));
+                    else
+                        xargs.append(elem);
+                }
+                if (arg.direction == "output") out_word += n;
+                bit_offset += arg.width;
+            }
+            if (GetSize(xargs) < max_xarg_words * 32)
+                xargs.append(RTLIL::SigSpec(RTLIL::State::S0, max_xarg_words * 32 - GetSize(xargs)));
+            return xargs;
+        };
+
         // Helper: split a function's args_sig into input-only portion and
         // connect output array wires from the result bus.
         auto connect_func_args_result = [&](const DpiFunction &func) {
@@ -1069,7 +1437,7 @@ struct LoomInstrumentPass : public Pass {
             int bit_offset = 0;
             for (const auto &arg : func.args) {
                 if (arg.type == "string") continue;
-                if (arg.is_array && arg.direction == "output") {
+                if (arg.is_array && (func.large || arg.direction == "output")) {
                     bit_offset += arg.width;
                     continue;
                 }
@@ -1099,6 +1467,7 @@ struct LoomInstrumentPass : public Pass {
             int out_arg_offset = 64;
             bit_offset = 0;
             for (const auto &arg : func.args) {
+                if (func.large) break;  // arrays connected by connect_func_xargs
                 if (arg.type == "string") continue;
                 if (arg.is_array && arg.direction == "output") {
                     RTLIL::SigSpec out_wire = func.args_sig.extract(bit_offset, arg.width);
@@ -1121,6 +1490,11 @@ struct LoomInstrumentPass : public Pass {
 
             RTLIL::SigSpec input_args = connect_func_args_result(func);
             module->connect(RTLIL::SigSpec(dpi_args_out), input_args);
+            if (func.large) {
+                RTLIL::SigSpec xargs = connect_func_xargs(func);
+                if (dpi_xargs_out)
+                    module->connect(RTLIL::SigSpec(dpi_xargs_out), xargs);
+            }
 
             module->remove(func.cell);
 
@@ -1178,6 +1552,21 @@ struct LoomInstrumentPass : public Pass {
             }
             module->connect(RTLIL::SigSpec(dpi_args_out), args_mux);
 
+            // Large-argument functions share the xargs bus the same way
+            if (dpi_xargs_out || dpi_xresult_in) {
+                RTLIL::SigSpec xargs_mux = RTLIL::SigSpec(RTLIL::State::S0, max_xarg_words * 32);
+                for (int i = (int)functions.size() - 1; i >= 0; i--) {
+                    if (!functions[i].large) continue;
+                    RTLIL::SigSpec xargs = connect_func_xargs(functions[i]);
+                    if (!dpi_xargs_out) continue;
+                    RTLIL::Wire *mux_out = module->addWire(NEW_ID, max_xarg_words * 32);
+                    module->addMux(NEW_ID, xargs_mux, xargs, valid_1bit[i], mux_out);
+                    xargs_mux = RTLIL::SigSpec(mux_out);
+                }
+                if (dpi_xargs_out)
+                    module->connect(RTLIL::SigSpec(dpi_xargs_out), xargs_mux);
+            }
+
             for (const auto &func : functions) {
                 module->remove(func.cell);
 
@@ -1253,9 +1642,10 @@ struct LoomInstrumentPass : public Pass {
         return false;
     }
 
-    // Count output array words for a function.
+    // Count output array words written back through the arg registers.
     int out_arg_words(const DpiFunction &func) {
         int words = 0;
+        if (func.large) return 0;
         for (const auto &arg : func.args) {
             if (arg.is_array && arg.direction == "output")
                 words += (arg.width + 31) / 32;
@@ -1281,9 +1671,25 @@ struct LoomInstrumentPass : public Pass {
         ofs << "#include <svdpi.h>\n";
         ofs << "#include \"loom_svdpi_array.h\"\n";
         ofs << "\n";
+        ofs << "#include <stdarg.h>\n";
         ofs << "#include <stdio.h>\n";
         ofs << "#include <string.h>\n\n";
 
+        // Built-in $display goes through a host-settable sink
+        bool has_builtin = false;
+        for (const auto &func : functions) has_builtin |= func.builtin;
+        ofs << "// Set by the host (loomx) to route $display into its logger\n";
+        ofs << "loom_dpi_display_fn_t loom_dpi_display_hook = 0;\n\n";
+        if (has_builtin) {
+            ofs << "static void _loom_display(const char *fmt, ...) {\n";
+            ofs << "    va_list args;\n";
+            ofs << "    va_start(args, fmt);\n";
+            ofs << "    if (loom_dpi_display_hook) loom_dpi_display_hook(fmt, args);\n";
+            ofs << "    else vprintf(fmt, args);\n";
+            ofs << "    va_end(args);\n";
+            ofs << "}\n\n";
+        }
+
         // Emit one extern per unique function name (open arrays all map to
         // svOpenArrayHandle, so identical across call sites)
         ofs << "// User-provided DPI function implementations\n";
@@ -1319,13 +1725,13 @@ struct LoomInstrumentPass : public Pass {
                 << "(const uint32_t *args, uint32_t *out_args) {\n";
 
             if (func.builtin) {
-                // Built-in display function: generate printf inline
+                // Built-in display function: format through the display sink
                 std::string fmt_str;
                 int arg_offset = 0;
                 for (const auto &arg : func.args) {
                     if (arg.type == "string") fmt_str = arg.string_value;
                 }
-                ofs << "    printf(\"" << fmt_str << "\"";
+                ofs << "    _loom_display(\"" << fmt_str << "\"";
                 for (size_t i = 0; i < func.args.size(); i++) {
                     const auto &arg = func.args[i];
                     if (arg.type == "string") continue;
@@ -1336,12 +1742,34 @@ struct LoomInstrumentPass : public Pass {
                 ofs << ");\n";
                 ofs << "    return 0;\n";
             } else {
+                // Large-argument functions use the window words in place:
+                // inputs at args[LOOM_DPI_XARG_BASE + k], outputs at out_args[k]
+                std::vector<std::string> xarg_ptr(func.args.size());
+                if (func.large) {
+                    int in_word = 0, out_word = 0;
+                    for (size_t i = 0; i < func.args.size(); i++) {
+                        const auto &arg = func.args[i];
+                        if (arg.type == "string" || !arg.is_array) continue;
+                        if (arg.direction == "output") {
+                            xarg_ptr[i] = "(out_args + " + std::to_string(out_word) + ")";
+                            out_word += arg.n_elements;
+                        } else {
+                            xarg_ptr[i] = "(uint32_t *)(args + LOOM_DPI_XARG_BASE + " +
+                                          std::to_string(in_word) + ")";
+                            in_word += arg.n_elements;
+                        }
+                        if (arg.is_open_array)
+                            ofs << "    loom_sv_array_t " << arg.name << "_arr = { "
+                                << xarg_ptr[i] << ", " << arg.n_elements << ", 32 };\n";
+                    }
+                }
+
                 // Declare array buffers for array args (open and fixed-size)
                 int arg_offset = 0;
                 int out_offset = 0;
                 for (size_t i = 0; i < func.args.size(); i++) {
                     const auto &arg = func.args[i];
-                    if (arg.type == "string" || !arg.is_array) continue;
+                    if (arg.type == "string" || !arg.is_array || func.large) continue;
                     int n = arg.n_elements;
                     if (arg.direction == "output") {
                         ofs << "    uint32_t " << arg.name << "_buf[" << n << "];\n";
@@ -1362,7 +1790,7 @@ struct LoomInstrumentPass : public Pass {
                 for (size_t i = 0; i < func.args.size(); i++) {
                     const auto &arg = func.args[i];
                     if (arg.type == "string") continue;
-                    if (arg.is_array && arg.direction == "output") continue;
+                    if (arg.is_array && (func.large || arg.direction == "output")) continue;
                     if (arg.is_array && arg.direction == "input") {
                         int n = arg.n_elements;
                         for (int j = 0; j < n; j++) {
@@ -1394,10 +1822,12 @@ struct LoomInstrumentPass : public Pass {
                         // Fixed-size arrays: pass buffer pointer directly
                         if (arg.is_open_array) {
                             call_args += "(svOpenArrayHandle)&" + arg.name + "_arr";
+                        } else if (func.large) {
+                            call_args += xarg_ptr[i];
                         } else {
                             call_args += arg.name + "_buf";
                         }
-                        if (arg.direction != "output")
+                        if (arg.direction != "output" && !func.large)
                             arg_offset += (arg.width + 31) / 32;
                     } else {
                         std::string c_type = sv_type_to_c(arg.type, arg.width);
@@ -1425,7 +1855,7 @@ struct LoomInstrumentPass : public Pass {
                 out_offset = 0;
                 for (size_t i = 0; i < func.args.size(); i++) {
                     const auto &arg = func.args[i];
-                    if (!arg.is_array || arg.direction != "output") continue;
+                    if (!arg.is_array || arg.direction != "output" || func.large) continue;
                     int n = arg.n_elements;
                     for (int j = 0; j < n; j++) {
                         ofs << "    out_args[" << (out_offset + (n - 1 - j)) << "] = "
@@ -1454,6 +1884,7 @@ struct LoomInstrumentPass : public Pass {
                 << out_arg_words(func) << ", "
                 << (func.call_at_init ? 1 : 0) << ", "
                 << (is_read_only(func) ? 1 : 0) << ", "
+                << xarg_words(func) << ", " << xres_words(func) << ", "
                 << "_loom_wrap_" << func.name << "_" << func.func_id << " }";
             if (i + 1 < functions.size()) ofs << ",";
             ofs << "\n";
@@ -1465,6 +1896,56 @@ struct LoomInstrumentPass : public Pass {
         ofs.close();
         log("Wrote C source to: %s\n", path.c_str());
     }
+
+    // Undo the C string escaping applied by process_print_cells
+    static std::string c_unescape(const std::string &s) {
+        std::string out;
+        for (size_t i = 0; i < s.size(); i++) {
+            if (s[i] != '\\' || i + 1 == s.size()) {
+                out += s[i];
+                continue;
+            }
+            char ch = s[++i];
+            out += ch == 'n' ? '\n' : ch == 't' ? '\t' : ch;
+        }
+        return out;
+    }
+
+    // Write DisplayMap protobuf: one entry per hardware $display function.
+    // Argument words follow the generated wrapper: each argument starts on
+    // a word boundary, in declaration order.
+    void write_display_map(const std::vector<DpiFunction> &functions, const std::string &path) {
+        loom::DisplayMap map;
+        for (const auto &func : functions) {
+            if (!func.builtin || func.func_id < 0 || func.call_at_init ||
+                func.name.rfind("__loom_display_", 0) != 0)
+                continue;
+            auto *entry = map.add_formats();
+            entry->set_func_id(func.func_id);
+            entry->set_name(func.name);
+            for (const auto &arg : func.args) {
+                if (arg.type == "string") {
+                    entry->set_format(c_unescape(arg.string_value));
+                    continue;
+                }
+                auto *a = entry->add_args();
+                a->set_width(arg.width);
+                a->set_is_signed(arg.type == "int");
+            }
+        }
+
+        std::ofstream f(path, std::ios::binary);
+        if (!f.is_open()) {
+            log_error("Could not open file '%s' for writing.\n", path.c_str());
+        }
+        if (!map.SerializeToOstream(&f)) {
+            log_error("Failed to serialize DisplayMap to '%s'.\n", path.c_str());
+        }
+        f.close();
+
+        log("Wrote display map protobuf to '%s' (%d format(s))\n",
+            path.c_str(), map.formats_size());
+    }
 };
 
 LoomInstrumentPass LoomInstrumentPass_singleton;
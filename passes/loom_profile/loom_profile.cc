@@ -0,0 +1,141 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+ * loom_profile - Yosys pass for compile-time profiling
+ *
+ * loomc -profile places a loom_profile call after every command of the
+ * generated script. Each call closes the interval since the previous one
+ * and appends a [[pass]] entry to a TOML file:
+ *
+ *   [[pass]]
+ *   name = "scan_insert"
+ *   wall_s = 1.234          wall-clock time of the interval
+ *   cpu_s = 1.201           user + system CPU time of the interval
+ *   peak_rss_mb = 812.5     process peak RSS at the end of the interval
+ *   cells_before = 10240    cells / wires over all modules at the start
+ *   cells_after = 12288     and at the end of the interval
+ *   wires_before = 20480
+ *   wires_after = 24576
+ *
+ * Peak RSS is the high-water mark of the whole Yosys process, so the pass
+ * that raised it is the first one whose entry shows the new value.
+ */
+
+#include "kernel/yosys.h"
+#include <chrono>
+#include <cstdio>
+#include <sys/resource.h>
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+struct ProfileSample {
+    std::chrono::steady_clock::time_point wall;
+    double cpu_s = 0;
+    double peak_rss_mb = 0;
+    size_t cells = 0;
+    size_t wires = 0;
+
+    static ProfileSample take(RTLIL::Design *design) {
+        ProfileSample s;
+        s.wall = std::chrono::steady_clock::now();
+
+        struct rusage ru;
+        getrusage(RUSAGE_SELF, &ru);
+        s.cpu_s = ru.ru_utime.tv_sec + ru.ru_utime.tv_usec * 1e-6 +
+                  ru.ru_stime.tv_sec + ru.ru_stime.tv_usec * 1e-6;
+#if defined(__APPLE__)
+        s.peak_rss_mb = ru.ru_maxrss / (1024.0 * 1024.0);  // bytes
+#else
+        s.peak_rss_mb = ru.ru_maxrss / 1024.0;             // KiB
+#endif
+
+        for (auto module : design->modules()) {
+            s.cells += module->cells().size();
+            s.wires += module->wires().size();
+        }
+        return s;
+    }
+};
+
+struct LoomProfilePass : public Pass {
+    LoomProfilePass() : Pass("loom_profile", "Record per-pass compile time and design size") {}
+
+    void help() override {
+        log("\n");
+        log("    loom_profile -o <file.toml> [-start] [name]\n");
+        log("\n");
+        log("Append a [[pass]] entry named <name> to <file.toml> covering the time\n");
+        log("since the previous loom_profile call: wall and CPU time, process peak\n");
+        log("RSS, and cell and wire counts before and after. Used by loomc -profile.\n");
+        log("\n");
+        log("    -start\n");
+        log("        Truncate the file and start the first interval; no entry is\n");
+        log("        written.\n");
+        log("\n");
+    }
+
+    bool started = false;
+    ProfileSample last;
+
+    void execute(std::vector<std::string> args, RTLIL::Design *design) override {
+        std::string file;
+        bool start = false;
+
+        size_t argidx;
+        for (argidx = 1; argidx < args.size(); argidx++) {
+            if (args[argidx] == "-o" && argidx + 1 < args.size()) {
+                file = args[++argidx];
+                continue;
+            }
+            if (args[argidx] == "-start") {
+                start = true;
+                continue;
+            }
+            break;
+        }
+        std::string name = argidx < args.size() ? args[argidx++] : "unnamed";
+        if (argidx < args.size())
+            cmd_error(args, argidx, "Extra argument.");
+        if (file.empty())
+            log_cmd_error("loom_profile needs -o <file>\n");
+
+        auto now = ProfileSample::take(design);
+
+        if (start || !started) {
+            FILE *f = std::fopen(file.c_str(), "w");
+            if (!f)
+                log_cmd_error("Cannot open profile file '%s' for writing\n", file.c_str());
+            std::fprintf(f, "# Loom compile profile (loomc -profile)\n\n");
+            std::fclose(f);
+            started = true;
+            last = now;
+            if (start)
+                return;
+        }
+
+        FILE *f = std::fopen(file.c_str(), "a");
+        if (!f)
+            log_cmd_error("Cannot open profile file '%s' for appending\n", file.c_str());
+        double wall_s = std::chrono::duration<double>(now.wall - last.wall).count();
+        std::fprintf(f, "[[pass]]\n");
+        std::fprintf(f, "name = \"%s\"\n", name.c_str());
+        std::fprintf(f, "wall_s = %.3f\n", wall_s);
+        std::fprintf(f, "cpu_s = %.3f\n", now.cpu_s - last.cpu_s);
+        std::fprintf(f, "peak_rss_mb = %.1f\n", now.peak_rss_mb);
+        std::fprintf(f, "cells_before = %zu\n", last.cells);
+        std::fprintf(f, "cells_after = %zu\n", now.cells);
+        std::fprintf(f, "wires_before = %zu\n", last.wires);
+        std::fprintf(f, "wires_after = %zu\n\n", now.wires);
+        std::fclose(f);
+
+        log("loom_profile: %s %.3fs wall, %zu -> %zu cells\n",
+            name.c_str(), wall_s, last.cells, now.cells);
+
+        // Start the next interval after our own bookkeeping
+        last = ProfileSample::take(design);
+    }
+};
+
+LoomProfilePass LoomProfilePass_singleton;
+
+PRIVATE_NAMESPACE_END
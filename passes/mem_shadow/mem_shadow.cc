@@ -14,6 +14,7 @@
  *   5. Instantiates controller and wires to memory shadow ports
  *   6. Extracts initial memory content from inline inits and $readmemh/$readmemb
  *   7. Emits MemMap protobuf for host driver
+ *   8. With -dirty, exports DUT write-port activity for dirty page tracking
  *
  * Usage:
  *   read_slang design.sv
@@ -47,6 +48,8 @@ struct MemInfo {
     RTLIL::Wire *shadow_wdata;
     RTLIL::Wire *shadow_wen;
     RTLIL::Wire *shadow_ren;
+    // Original DUT write ports: (enable, entry address)
+    std::vector<std::pair<RTLIL::SigSpec, RTLIL::SigSpec>> dut_wr_ports;
     // Initial content
     std::vector<uint8_t> initial_content;
     bool has_initial_content = false;
@@ -76,6 +79,11 @@ struct MemShadowPass : public Pass {
         log("    -clk <name>\n");
         log("        DUT clock signal name (default: clk_i)\n");
         log("\n");
+        log("    -dirty\n");
+        log("        Export DUT write-port activity as loom_mem_wr_valid (one bit per\n");
+        log("        port) and loom_mem_wr_addr (global byte address per port) so\n");
+        log("        loom_mem_ctrl can track dirty pages.\n");
+        log("\n");
     }
 
     static int ceil_log2(int n) {
@@ -91,6 +99,7 @@ struct MemShadowPass : public Pass {
         std::string map_file;
         std::string ctrl_name = "loom_mem_ctrl";
         std::string clk_name = "clk_i";
+        bool dirty = false;
 
         size_t argidx;
         for (argidx = 1; argidx < args.size(); argidx++) {
@@ -106,6 +115,10 @@ struct MemShadowPass : public Pass {
                 clk_name = args[++argidx];
                 continue;
             }
+            if (args[argidx] == "-dirty") {
+                dirty = true;
+                continue;
+            }
             break;
         }
         extra_args(args, argidx, design);
@@ -151,6 +164,9 @@ struct MemShadowPass : public Pass {
                 module->set_string_attribute(ID(loom_shadow_total_bytes),
                     std::to_string(total_addr_space));
 
+                if (dirty)
+                    export_write_activity(module, memories, global_addr_bits);
+
                 // Write protobuf memory map
                 if (!map_file.empty()) {
                     write_mem_map(map_file, memories);
@@ -232,6 +248,10 @@ struct MemShadowPass : public Pass {
                           const std::string &clk_name) {
         std::string prefix = "loom_shadow_" + mi.memid;
 
+        // Remember the DUT's own write ports before the shadow port joins them
+        for (auto &wp : mem.wr_ports)
+            mi.dut_wr_ports.emplace_back(wp.en, wp.addr);
+
         // Create shadow port wires (internal, NOT module ports)
         mi.shadow_addr  = module->addWire(RTLIL::IdString("\\" + prefix + "_addr"), mi.abits);
         mi.shadow_rdata = module->addWire(RTLIL::IdString("\\" + prefix + "_rdata"), mi.width);
@@ -563,6 +583,48 @@ struct MemShadowPass : public Pass {
         log("  Instantiated %s in %s\n", ctrl_name.c_str(), log_id(module));
     }
 
+    // Drive loom_mem_wr_valid[p] / loom_mem_wr_addr[p] from every DUT write
+    // port. The address is the entry's global shadow address (base + 4*entry,
+    // as decoded by the controller), so loom_mem_ctrl can map it to a page
+    // without knowing the memory layout. Activity is not gated here: loom_en
+    // does not exist yet, emu_top feeds it to the controller instead.
+    void export_write_activity(RTLIL::Module *module, std::vector<MemInfo> &memories,
+                               int global_addr_bits) {
+        RTLIL::SigSpec valid, addr;
+
+        for (auto &mi : memories) {
+            for (auto &[en, entry] : mi.dut_wr_ports) {
+                valid.append(module->ReduceOr(NEW_ID, en));
+
+                // {entry, 2'b00}, truncated to the global address width
+                RTLIL::SigSpec offset(RTLIL::State::S0, 2);
+                offset.append(entry);
+                offset.extend_u0(global_addr_bits);
+                RTLIL::SigSpec byte_addr = module->Add(NEW_ID, offset,
+                    RTLIL::Const(mi.base_addr, global_addr_bits));
+                addr.append(byte_addr);
+            }
+            mi.dut_wr_ports.clear();
+        }
+
+        if (valid.empty()) {
+            log("  No DUT write ports, dirty tracking not exported\n");
+            return;
+        }
+
+        RTLIL::Wire *valid_w = module->addWire(ID(loom_mem_wr_valid), GetSize(valid));
+        valid_w->port_output = true;
+        RTLIL::Wire *addr_w = module->addWire(ID(loom_mem_wr_addr), GetSize(addr));
+        addr_w->port_output = true;
+        module->fixup_ports();
+
+        module->connect(RTLIL::SigSpec(valid_w), valid);
+        module->connect(RTLIL::SigSpec(addr_w), addr);
+        module->set_string_attribute(ID(loom_mem_wr_ports), std::to_string(GetSize(valid)));
+
+        log("  Exported %d DUT write ports for dirty tracking\n", GetSize(valid));
+    }
+
     // Extract initial memory content using Mem::get_init_data()
     void extract_init_content(RTLIL::Module * /*module*/, std::vector<MemInfo> &memories) {
         for (auto &mi : memories) {
@@ -25,6 +25,7 @@
 
 #include "kernel/yosys.h"
 #include "kernel/sigtools.h"
+#include <memory>
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
@@ -87,6 +88,8 @@ struct ResetExtractPass : public Pass {
         for (auto cell : module->cells())
             cells_to_process.push_back(cell);
 
+        std::unique_ptr<DpiResultIndex> dpi_index;
+
         for (auto cell : cells_to_process) {
             RTLIL::IdString type = cell->type;
 
@@ -143,7 +146,7 @@ struct ResetExtractPass : public Pass {
                 }
 
                 // Check if AD is driven by a $__loom_dpi_call cell
-                RTLIL::Cell *dpi_cell = find_driving_dpi_call(module, ad);
+                RTLIL::Cell *dpi_cell = find_driving_dpi_call(module, ad, dpi_index);
                 if (dpi_cell) {
                     // Verify DPI args are all constants
                     RTLIL::SigSpec dpi_args = dpi_cell->getPort(ID(ARGS));
@@ -341,18 +344,30 @@ struct ResetExtractPass : public Pass {
         module->remove(cell);
     }
 
-    // Find $__loom_dpi_call cell driving a signal
-    RTLIL::Cell *find_driving_dpi_call(RTLIL::Module *module, RTLIL::SigSpec sig) {
-        SigMap sigmap(module);
-        sig = sigmap(sig);
-        for (auto cell : module->cells()) {
-            if (cell->type != ID($__loom_dpi_call)) continue;
-            if (!cell->hasPort(ID(RESULT))) continue;
-            RTLIL::SigSpec result = sigmap(cell->getPort(ID(RESULT)));
-            if (GetSize(result) > 0 && result == sig)
-                return cell;
+    // Sigmapped RESULT of every $__loom_dpi_call cell (first in module
+    // order wins), built on the first non-constant $aldff of a module
+    struct DpiResultIndex {
+        SigMap sigmap;
+        dict<RTLIL::SigSpec, RTLIL::Cell*> by_result;
+
+        explicit DpiResultIndex(RTLIL::Module *module) : sigmap(module) {
+            for (auto cell : module->cells()) {
+                if (cell->type != ID($__loom_dpi_call)) continue;
+                if (!cell->hasPort(ID(RESULT))) continue;
+                RTLIL::SigSpec result = sigmap(cell->getPort(ID(RESULT)));
+                if (GetSize(result) > 0 && !by_result.count(result))
+                    by_result[result] = cell;
+            }
         }
-        return nullptr;
+    };
+
+    // Find $__loom_dpi_call cell driving a signal
+    RTLIL::Cell *find_driving_dpi_call(RTLIL::Module *module, RTLIL::SigSpec sig,
+                                       std::unique_ptr<DpiResultIndex> &index) {
+        if (!index)
+            index = std::make_unique<DpiResultIndex>(module);
+        auto it = index->by_result.find(index->sigmap(sig));
+        return it != index->by_result.end() ? it->second : nullptr;
     }
 };
 
@@ -11,13 +11,29 @@
  *
  * The chain connects: loom_scan_in -> FF1.D -> FF1.Q -> FF2.D -> ... -> loom_scan_out
  *
+ * With -chains N (or -chain_length), the bits are split into N chains of
+ * equal length that shift in parallel: loom_scan_in/loom_scan_out become
+ * N bits wide and chain c holds scan offsets [c*L, (c+1)*L). For N > 1, L
+ * is rounded up to a multiple of 32 so every chain starts on a data word
+ * boundary in loom_scan_ctrl; only the last chain may be shorter. Scan
+ * offsets therefore keep the single-chain numbering.
+ *
  * Generates a protobuf scan map file that maps scan chain bit positions to
- * original flip-flop names grouped by variable.
+ * original flip-flop names grouped by variable, and with -index a binary
+ * companion (loom_map_index.h) the host maps instead of parsing it.
+ *
+ * With -trace, the Q outputs of matching flip-flops are also concatenated
+ * onto a loom_trace_data output for loom_trace_ctrl. The trace map uses the
+ * scan map format with offsets into loom_trace_data instead of the chain.
+ * -watch does the same for loom_watch_data, the probe of the trigger bank
+ * in loom_emu_ctrl.
  */
 
 #include "kernel/yosys.h"
 #include "kernel/sigtools.h"
 #include "loom_snapshot.pb.h"
+#include "loom_map_index.h"
+#include <deque>
 #include <fstream>
 #include <sstream>
 
@@ -33,13 +49,41 @@ struct ScanInsertPass : public Pass {
         log("\n");
         log("Insert scan chain multiplexers on all flip-flops.\n");
         log("\n");
+        log("    -chains N\n");
+        log("        Split the scan bits into N parallel chains (default: 1)\n");
+        log("\n");
         log("    -chain_length N\n");
-        log("        Maximum flip-flops per chain (default: all in one chain)\n");
+        log("        Maximum bits per chain; raises the chain count to fit\n");
+        log("        (default: all in one chain). With several chains the\n");
+        log("        per-chain length is rounded up to a multiple of 32.\n");
         log("\n");
         log("    -map <file.pb>\n");
         log("        Write scan chain mapping to protobuf file.\n");
         log("        Maps bit positions to original flip-flop names.\n");
         log("\n");
+        log("    -index <file.idx>\n");
+        log("        Also write a binary index of the scan map (offsets, widths and a\n");
+        log("        name hash) that the host maps at startup instead of parsing\n");
+        log("        the protobuf. Requires -map.\n");
+        log("\n");
+        log("    -trace <pattern>\n");
+        log("        Also route flip-flops whose scan map name matches <pattern>\n");
+        log("        (glob, e.g. 'top.u_core.*') to the loom_trace_data output.\n");
+        log("        May be given several times.\n");
+        log("\n");
+        log("    -trace_map <file.pb>\n");
+        log("        Write the traced variables, with offsets into loom_trace_data,\n");
+        log("        to a protobuf file in the scan map format.\n");
+        log("\n");
+        log("    -watch <pattern>\n");
+        log("        Route flip-flops whose scan map name matches <pattern> to the\n");
+        log("        loom_watch_data output, which emu_top connects to the hardware\n");
+        log("        trigger comparators. May be given several times.\n");
+        log("\n");
+        log("    -watch_map <file.pb>\n");
+        log("        Write the watched variables, with offsets into loom_watch_data,\n");
+        log("        to a protobuf file in the scan map format.\n");
+        log("\n");
         log("    -check_equiv\n");
         log("        Verify functional equivalence after scan insertion.\n");
         log("        The design with scan_enable=0 should be equivalent to the\n");
@@ -99,8 +143,16 @@ struct ScanInsertPass : public Pass {
         log_header(design, "Executing SCAN_INSERT pass.\n");
 
         int chain_length = 0;
+        int n_chains = 1;
         bool check_equiv = false;
         std::string map_file;
+        std::string index_file;
+        std::string trace_map_file;
+        std::string watch_map_file;
+        trace_patterns.clear();
+        trace_map.Clear();
+        watch_patterns.clear();
+        watch_map.Clear();
 
         size_t argidx;
         for (argidx = 1; argidx < args.size(); argidx++) {
@@ -108,10 +160,34 @@ struct ScanInsertPass : public Pass {
                 chain_length = atoi(args[++argidx].c_str());
                 continue;
             }
+            if (args[argidx] == "-chains" && argidx + 1 < args.size()) {
+                n_chains = atoi(args[++argidx].c_str());
+                continue;
+            }
             if (args[argidx] == "-map" && argidx + 1 < args.size()) {
                 map_file = args[++argidx];
                 continue;
             }
+            if (args[argidx] == "-index" && argidx + 1 < args.size()) {
+                index_file = args[++argidx];
+                continue;
+            }
+            if (args[argidx] == "-trace" && argidx + 1 < args.size()) {
+                trace_patterns.push_back(args[++argidx]);
+                continue;
+            }
+            if (args[argidx] == "-trace_map" && argidx + 1 < args.size()) {
+                trace_map_file = args[++argidx];
+                continue;
+            }
+            if (args[argidx] == "-watch" && argidx + 1 < args.size()) {
+                watch_patterns.push_back(args[++argidx]);
+                continue;
+            }
+            if (args[argidx] == "-watch_map" && argidx + 1 < args.size()) {
+                watch_map_file = args[++argidx];
+                continue;
+            }
             if (args[argidx] == "-check_equiv") {
                 check_equiv = true;
                 continue;
@@ -120,6 +196,11 @@ struct ScanInsertPass : public Pass {
         }
         extra_args(args, argidx, design);
 
+        if (n_chains < 1)
+            log_cmd_error("-chains must be at least 1\n");
+        if (chain_length < 0)
+            log_cmd_error("-chain_length must not be negative\n");
+
         // Collect variables across all modules
         loom::ScanMap scan_map;
         int total_chain_bits = 0;
@@ -131,10 +212,10 @@ struct ScanInsertPass : public Pass {
             if (mod_name[0] == '\\') mod_name = mod_name.substr(1);
 
             if (check_equiv) {
-                run_scan_insert_with_equiv_check(module, chain_length, design,
+                run_scan_insert_with_equiv_check(module, chain_length, n_chains, design,
                                                   scan_map, total_chain_bits, mod_name);
             } else {
-                run_scan_insert(module, chain_length,
+                run_scan_insert(module, chain_length, n_chains,
                                 scan_map, total_chain_bits, mod_name);
             }
         }
@@ -143,17 +224,89 @@ struct ScanInsertPass : public Pass {
 
         // Write mapping file if requested
         if (!map_file.empty() && scan_map.variables_size() > 0) {
-            write_scan_map(map_file, scan_map);
+            write_scan_map(map_file, scan_map, index_file);
+        }
+
+        if (!trace_patterns.empty() && trace_map.variables_size() == 0)
+            log_warning("No flip-flops matched the -trace patterns\n");
+        if (!trace_map_file.empty() && trace_map.variables_size() > 0) {
+            trace_map.set_n_chains(1);
+            trace_map.set_chain_bits(trace_map.chain_length());
+            write_scan_map(trace_map_file, trace_map);
+        }
+
+        if (!watch_patterns.empty() && watch_map.variables_size() == 0)
+            log_warning("No flip-flops matched the -watch patterns\n");
+        if (!watch_map_file.empty() && watch_map.variables_size() > 0) {
+            watch_map.set_n_chains(1);
+            watch_map.set_chain_bits(watch_map.chain_length());
+            write_scan_map(watch_map_file, watch_map);
+        }
+    }
+
+    // Flip-flops selected for loom_trace_data / loom_watch_data, and where
+    // their bits landed
+    std::vector<std::string> trace_patterns;
+    loom::ScanMap trace_map;
+    std::vector<std::string> watch_patterns;
+    loom::ScanMap watch_map;
+
+    static bool matches_any(const std::vector<std::string> &patterns, const std::string &full_name) {
+        for (auto &pat : patterns)
+            if (patmatch(pat.c_str(), full_name.c_str()))
+                return true;
+        return false;
+    }
+
+    bool is_traced(const std::string &full_name) const {
+        return matches_any(trace_patterns, full_name);
+    }
+
+    bool is_watched(const std::string &full_name) const {
+        return matches_any(watch_patterns, full_name);
+    }
+
+    // Bits per chain for n chains: everything in one chain, or an even
+    // split rounded up to whole 32-bit words. The host derives the same
+    // value from SCAN_LENGTH and SCAN_CHAINS (loom::scan_chain_bits).
+    static int chain_bits_for(int total_bits, int n) {
+        if (n <= 1) return total_bits;
+        return ((total_bits + n - 1) / n + 31) / 32 * 32;
+    }
+
+    // Pick the chain count: the requested count, raised to honour
+    // max_chain_length, then lowered until no chain is empty
+    static void plan_chains(int total_bits, int max_chain_length, int req_chains,
+                            int &n_chains, int &chain_bits) {
+        n_chains = req_chains;
+        if (max_chain_length > 0)
+            n_chains = std::max(n_chains, (total_bits + max_chain_length - 1) / max_chain_length);
+        n_chains = std::max(1, std::min(n_chains, total_bits));
+
+        while (true) {
+            chain_bits = chain_bits_for(total_bits, n_chains);
+            int used = chain_bits > 0 ? (total_bits + chain_bits - 1) / chain_bits : 1;
+            if (used >= n_chains) break;
+            n_chains = used;
         }
     }
 
-    void run_scan_insert(RTLIL::Module *module, int /* chain_length */,
+    void run_scan_insert(RTLIL::Module *module, int max_chain_length, int req_chains,
                          loom::ScanMap &scan_map, int &chain_pos,
                          const std::string &mod_name) {
         // Collect all flip-flop cells, skipping memory output registers
         std::vector<RTLIL::Cell*> dffs;
         int skipped_mem_ffs = 0;
+
+        // Reset DPI call cells left by loom_instrument, by function name in
+        // module order; looked up per FF below without rescanning the module
+        dict<std::string, std::deque<RTLIL::Cell*>> reset_dpi_cells;
+
         for (auto cell : module->cells()) {
+            if (cell->type == ID($__loom_dpi_call) && cell->get_bool_attribute(ID(loom_dpi_reset))) {
+                reset_dpi_cells[cell->get_string_attribute(ID(loom_dpi_func))].push_back(cell);
+                continue;
+            }
             if (is_ff(cell)) {
                 if (is_memory_output_ff(cell)) {
                     log("  Skipping memory output FF: %s\n", log_id(cell));
@@ -187,19 +340,33 @@ struct ScanInsertPass : public Pass {
             scan_en->port_input = true;
         }
 
-        RTLIL::Wire *scan_in = module->addWire(ID(loom_scan_in), 1);
+        int total_bits = 0;
+        for (auto dff : dffs)
+            total_bits += GetSize(dff->getPort(ID::Q));
+
+        int n_chains, chain_bits;
+        plan_chains(total_bits, max_chain_length, req_chains, n_chains, chain_bits);
+        log("  Scan chains: %d x %d bits\n", n_chains, chain_bits);
+
+        RTLIL::Wire *scan_in = module->addWire(ID(loom_scan_in), n_chains);
         scan_in->port_input = true;
 
-        RTLIL::Wire *scan_out = module->addWire(ID(loom_scan_out), 1);
+        RTLIL::Wire *scan_out = module->addWire(ID(loom_scan_out), n_chains);
         scan_out->port_output = true;
 
-        // Track the previous Q output to chain to next FF
-        RTLIL::SigSpec prev_q = RTLIL::SigSpec(scan_in);
+        // Module-local bit index along the chains, and the previous bit's Q
+        const int base_pos = chain_pos;
+        int bit_idx = 0;
+        RTLIL::SigBit prev_bit;
 
         // Accumulate reset entries for building the initial scan image
         struct ResetEntry { int offset; int width; RTLIL::Const value; };
         std::vector<ResetEntry> reset_entries;
 
+        // Q outputs of traced and watched FFs, in trace/watch map order
+        RTLIL::SigSpec trace_sig;
+        RTLIL::SigSpec watch_sig;
+
         // Process each flip-flop
         for (auto dff : dffs) {
             // Get the D and Q signals
@@ -234,6 +401,8 @@ struct ScanInsertPass : public Pass {
             var->set_name(full_name);
             var->set_width(width);
             var->set_offset(chain_pos);
+            var->set_chain((chain_pos - base_pos) / chain_bits);
+            var->set_chain_offset((chain_pos - base_pos) % chain_bits);
 
             // Propagate enum member metadata from wire attribute to protobuf
             for (int i = 0; i < GetSize(q); i++) {
@@ -254,6 +423,10 @@ struct ScanInsertPass : public Pass {
                 }
             }
 
+            // Coverage counters carry their cover's source location
+            if (q_wire && q_wire->has_attribute(ID(loom_cover_src)))
+                var->set_src(q_wire->get_string_attribute(ID(loom_cover_src)));
+
             // Check for loom_reset_value attribute (set by reset_extract pass)
             if (q_wire && q_wire->has_attribute(ID(loom_reset_value))) {
                 RTLIL::Const rv = q_wire->attributes.at(ID(loom_reset_value));
@@ -276,12 +449,10 @@ struct ScanInsertPass : public Pass {
 
                 // Find the $__loom_dpi_call cell left by loom_instrument
                 RTLIL::Cell *dpi_cell = nullptr;
-                for (auto c : module->cells()) {
-                    if (c->type == ID($__loom_dpi_call) && c->get_bool_attribute(ID(loom_dpi_reset))
-                        && c->get_string_attribute(ID(loom_dpi_func)) == dpi_func_name) {
-                        dpi_cell = c;
-                        break;
-                    }
+                auto it = reset_dpi_cells.find(dpi_func_name);
+                if (it != reset_dpi_cells.end() && !it->second.empty()) {
+                    dpi_cell = it->second.front();
+                    it->second.pop_front();
                 }
 
                 if (dpi_cell) {
@@ -295,6 +466,32 @@ struct ScanInsertPass : public Pass {
                 }
             }
 
+            if (is_traced(full_name)) {
+                auto *tvar = trace_map.add_variables();
+                tvar->set_name(full_name);
+                tvar->set_width(width);
+                tvar->set_offset(trace_map.chain_length());
+                tvar->set_chain_offset(trace_map.chain_length());
+                *tvar->mutable_enum_members() = var->enum_members();
+                trace_map.set_chain_length(trace_map.chain_length() + width);
+                trace_sig.append(q);
+                log("    traced at loom_trace_data[%d:%d]\n",
+                    tvar->offset() + width - 1, tvar->offset());
+            }
+
+            if (is_watched(full_name)) {
+                auto *wvar = watch_map.add_variables();
+                wvar->set_name(full_name);
+                wvar->set_width(width);
+                wvar->set_offset(watch_map.chain_length());
+                wvar->set_chain_offset(watch_map.chain_length());
+                *wvar->mutable_enum_members() = var->enum_members();
+                watch_map.set_chain_length(watch_map.chain_length() + width);
+                watch_sig.append(q);
+                log("    watched at loom_watch_data[%d:%d]\n",
+                    wvar->offset() + width - 1, wvar->offset());
+            }
+
             chain_pos += width;
 
             // For multi-bit FFs, we do bit-serial scan:
@@ -304,16 +501,20 @@ struct ScanInsertPass : public Pass {
             // Create intermediate wire for mux output
             RTLIL::Wire *mux_out = module->addWire(NEW_ID, width);
 
-            // Build serial scan chain: each bit connects to the previous bit's Q
+            // Build serial scan chains: each bit connects to the previous
+            // bit's Q, or to its chain's scan input at a chain boundary
             RTLIL::SigSpec scan_data;
-            for (int i = 0; i < width; i++) {
-                if (i == 0) {
-                    // First bit of this FF connects to previous FF's last bit
-                    scan_data.append(prev_q[GetSize(prev_q) - 1]);
-                } else {
-                    // Subsequent bits connect to this FF's previous bit
-                    scan_data.append(q[i - 1]);
-                }
+            for (int i = 0; i < width; i++, bit_idx++) {
+                int chain = bit_idx / chain_bits;
+                if (bit_idx % chain_bits == 0)
+                    scan_data.append(RTLIL::SigBit(scan_in, chain));
+                else
+                    scan_data.append(prev_bit);
+                prev_bit = q[i];
+
+                // Last bit of a chain drives that chain's scan output
+                if ((bit_idx + 1) % chain_bits == 0 || bit_idx + 1 == total_bits)
+                    module->connect(RTLIL::SigBit(scan_out, chain), prev_bit);
             }
 
             // Add mux: sel=scan_enable, A=orig_d (normal), B=scan_data (scan mode)
@@ -321,13 +522,23 @@ struct ScanInsertPass : public Pass {
 
             // Reconnect FF's D input to mux output
             dff->setPort(ID::D, RTLIL::SigSpec(mux_out));
+        }
 
-            // Update prev_q to this FF's Q for the next iteration
-            prev_q = q;
+        if (GetSize(trace_sig) > 0) {
+            RTLIL::Wire *trace_out = module->addWire(ID(loom_trace_data), GetSize(trace_sig));
+            trace_out->port_output = true;
+            module->connect(RTLIL::SigSpec(trace_out), trace_sig);
+            module->set_string_attribute(ID(loom_trace_width), std::to_string(GetSize(trace_sig)));
+            log("  Added port: loom_trace_data[%d] (out)\n", GetSize(trace_sig));
         }
 
-        // Connect the last FF's Q MSB to scan_out (end of serial chain)
-        module->connect(RTLIL::SigSpec(scan_out), RTLIL::SigBit(prev_q[GetSize(prev_q) - 1]));
+        if (GetSize(watch_sig) > 0) {
+            RTLIL::Wire *watch_out = module->addWire(ID(loom_watch_data), GetSize(watch_sig));
+            watch_out->port_output = true;
+            module->connect(RTLIL::SigSpec(watch_out), watch_sig);
+            module->set_string_attribute(ID(loom_watch_width), std::to_string(GetSize(watch_sig)));
+            log("  Added port: loom_watch_data[%d] (out)\n", GetSize(watch_sig));
+        }
 
         // Update port list
         module->fixup_ports();
@@ -356,17 +567,31 @@ struct ScanInsertPass : public Pass {
             scan_map.set_initial_scan_image(img);
             log("  Built initial scan image (%d bytes, %zu reset entries)\n",
                 n_bytes, reset_entries.size());
+
+            // Also on the module, for emu_top -reset_rom
+            RTLIL::Const init_image(RTLIL::State::S0, n_words * 32);
+            for (int i = 0; i < n_words * 32; i++)
+                if ((init_words[i / 32] >> (i % 32)) & 1)
+                    init_image.bits()[i] = RTLIL::State::S1;
+            module->attributes[ID(loom_scan_init_image)] = init_image;
         }
 
-        // Stamp chain length on the module so emu_top can read it
+        scan_map.set_n_chains(n_chains);
+        scan_map.set_chain_bits(chain_bits);
+
+        // Stamp chain geometry on the module so emu_top can read it
         module->set_string_attribute(ID(loom_scan_chain_length), std::to_string(chain_pos));
+        module->set_string_attribute(ID(loom_scan_chains), std::to_string(n_chains));
+        module->set_string_attribute(ID(loom_scan_chain_bits), std::to_string(chain_bits));
 
-        log("  Inserted scan chain with %zu element(s), %d bits total\n", dffs.size(), chain_pos);
-        log("  Added ports: loom_scan_enable (in), loom_scan_in (in), loom_scan_out (out)\n");
+        log("  Inserted %d scan chain(s) with %zu element(s), %d bits total\n",
+            n_chains, dffs.size(), chain_pos);
+        log("  Added ports: loom_scan_enable (in), loom_scan_in[%d] (in), loom_scan_out[%d] (out)\n",
+            n_chains, n_chains);
     }
 
     void run_scan_insert_with_equiv_check(RTLIL::Module *module, int chain_length,
-                                           RTLIL::Design *design,
+                                           int n_chains, RTLIL::Design *design,
                                            loom::ScanMap &scan_map, int &chain_pos,
                                            const std::string &mod_name) {
         std::string orig_name = module->name.str();
@@ -382,7 +607,7 @@ struct ScanInsertPass : public Pass {
         design->add(gold);
 
         // Step 2: Run scan insertion on the original module
-        run_scan_insert(module, chain_length, scan_map, chain_pos, mod_name);
+        run_scan_insert(module, chain_length, n_chains, scan_map, chain_pos, mod_name);
 
         // Step 3: Create gate copy and tie off scan ports
         log("  Creating gate copy with scan ports tied off: %s\n", gate_name.c_str());
@@ -409,19 +634,36 @@ struct ScanInsertPass : public Pass {
         }
     }
 
-    void write_scan_map(const std::string &filename, const loom::ScanMap &scan_map) {
+    void write_scan_map(const std::string &filename, const loom::ScanMap &scan_map,
+                        const std::string &index_filename = "") {
+        std::string bytes;
+        if (!scan_map.SerializeToString(&bytes)) {
+            log_error("Failed to serialize scan map to '%s'\n", filename.c_str());
+        }
+
         std::ofstream f(filename, std::ios::binary);
         if (!f.is_open()) {
             log_error("Cannot open scan map file '%s' for writing\n", filename.c_str());
         }
-
-        if (!scan_map.SerializeToOstream(&f)) {
-            log_error("Failed to serialize scan map to '%s'\n", filename.c_str());
-        }
-
+        f.write(bytes.data(), bytes.size());
         f.close();
         log("Wrote scan chain mapping to '%s' (%d variables, %u bits)\n",
             filename.c_str(), scan_map.variables_size(), scan_map.chain_length());
+
+        if (index_filename.empty())
+            return;
+        // Indexes the bytes just written, so entry positions match the file
+        std::string index = loom::build_scan_map_index(bytes);
+        if (index.empty()) {
+            log_error("Failed to index scan map '%s'\n", filename.c_str());
+        }
+        std::ofstream fi(index_filename, std::ios::binary);
+        if (!fi.is_open()) {
+            log_error("Cannot open scan map index '%s' for writing\n", index_filename.c_str());
+        }
+        fi.write(index.data(), index.size());
+        fi.close();
+        log("Wrote scan map index to '%s' (%zu bytes)\n", index_filename.c_str(), index.size());
     }
 
     void tie_off_scan_ports(RTLIL::Module *module) {
@@ -429,6 +671,8 @@ struct ScanInsertPass : public Pass {
         RTLIL::Wire *scan_en = module->wire(ID(loom_scan_enable));
         RTLIL::Wire *scan_in = module->wire(ID(loom_scan_in));
         RTLIL::Wire *scan_out = module->wire(ID(loom_scan_out));
+        RTLIL::Wire *trace_out = module->wire(ID(loom_trace_data));
+        RTLIL::Wire *watch_out = module->wire(ID(loom_watch_data));
 
         SigMap sigmap(module);
 
@@ -465,6 +709,12 @@ struct ScanInsertPass : public Pass {
         if (scan_out) {
             scan_out->port_output = false;
         }
+        if (trace_out) {
+            trace_out->port_output = false;
+        }
+        if (watch_out) {
+            watch_out->port_output = false;
+        }
 
         module->fixup_ports();
     }
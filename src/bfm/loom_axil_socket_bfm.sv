@@ -1,8 +1,12 @@
 // SPDX-License-Identifier: Apache-2.0
-// Generic AXI-Lite master BFM driven by a Unix domain socket
+// Generic AXI-Lite master BFM driven by a Unix domain socket (or, with
+// +shm=PATH, by shared-memory rings)
 //
 // This module is completely DUT-agnostic and reusable in any project.
 // It bridges a Unix domain socket to AXI-Lite transactions.
+// Transactions are serviced one at a time, in arrival order; request
+// tags, posted writes and message batching (wire protocol v2) are handled
+// entirely in loom_sock_dpi.c, as is backing off the idle socket poll.
 // Compatible with Verilator --binary --timing.
 
 module loom_axil_socket_bfm #(
@@ -47,6 +51,7 @@ module loom_axil_socket_bfm #(
     // DPI-C imports
     // -------------------------------------------------------------------------
     import "DPI-C" function int  loom_sock_init(string path);
+    import "DPI-C" function int  loom_shm_init(string path);
     import "DPI-C" function int  loom_sock_try_recv(
         output byte unsigned req_type,
         output int unsigned  req_offset,
@@ -59,6 +64,7 @@ module loom_axil_socket_bfm #(
     );
     import "DPI-C" function void loom_sock_close();
     import "DPI-C" function void loom_sock_set_trace(int enable);
+    import "DPI-C" function void loom_sock_set_poll_max(int max_cycles);
 
     // -------------------------------------------------------------------------
     // State machine
@@ -112,20 +118,33 @@ module loom_axil_socket_bfm #(
 
     initial begin
         string effective_path;
+        int    poll_max;
         socket_initialized = 1'b0;
         // Wait for reset to complete (100ns at 1ns timescale)
         #200;
-        // Allow runtime override via +socket=PATH (used by loomx for
-        // PID-based paths that avoid collisions in parallel test runs)
-        if (!$value$plusargs("socket=%s", effective_path)) begin
-            effective_path = SOCKET_PATH;
-        end
-        if (loom_sock_init(effective_path) < 0) begin
-            $error("[loom_bfm] Failed to initialize socket at %s", effective_path);
-            $finish;
+        // +shm=PATH selects the shared-memory rings (loomx -t shm).
+        // Otherwise allow runtime override via +socket=PATH (used by loomx
+        // for PID-based paths that avoid collisions in parallel test runs)
+        if ($value$plusargs("shm=%s", effective_path)) begin
+            if (loom_shm_init(effective_path) < 0) begin
+                $error("[loom_bfm] Failed to initialize shared memory at %s", effective_path);
+                $finish;
+            end
+        end else begin
+            if (!$value$plusargs("socket=%s", effective_path)) begin
+                effective_path = SOCKET_PATH;
+            end
+            if (loom_sock_init(effective_path) < 0) begin
+                $error("[loom_bfm] Failed to initialize socket at %s", effective_path);
+                $finish;
+            end
         end
         socket_initialized = 1'b1;
         loom_sock_set_trace(int'(bfm_trace));
+        // Idle poll backoff limit in cycles (+loom_poll_max=0 polls every cycle)
+        if ($value$plusargs("loom_poll_max=%d", poll_max)) begin
+            loom_sock_set_poll_max(poll_max);
+        end
     end
 
     // Cleanup on finish
@@ -4,16 +4,51 @@
 // These functions provide a Unix domain socket interface for the BFM.
 // The BFM uses these to receive read/write requests from the host and
 // send responses back. This is completely DUT-agnostic.
+//
+// Wire protocol v2 (see loom_transport_socket.cpp for the full layout):
+//   - request byte 1 is a tag, echoed in the response
+//   - request byte 2 bit0 marks a posted write (no ack is sent)
+//   - request byte 2 bit1 is the hello probe, answered here directly
+//   - response byte 3 carries LOOM_SOCK_PROTO_VERSION
+// The BFM still runs one AXI transaction at a time, so the tag and flags
+// of the request in flight are kept here and applied to its response.
+//
+// Requests are read in bulk into rx_buf and responses are queued in
+// tx_buf, which is flushed whenever no more requests are waiting (and
+// immediately for IRQ/SHUTDOWN). A pipelined host thus costs a handful
+// of syscalls per window instead of several per message.
+//
+// The BFM polls on every idle clock. After a poll that finds nothing, the
+// following polls are skipped without a syscall, doubling the gap each
+// time up to poll_max cycles; the first request that arrives resets it.
+// An idle host (e.g. one blocked waiting for an IRQ) thus costs one
+// read() per poll_max cycles, while request bursts are still picked up
+// on the next cycle.
+//
+// Shared-memory mode (loom_shm_init, selected by +shm=PATH): the same
+// messages travel through two single-producer/single-consumer rings in a
+// file mapped by both processes (layout below, mirrored in
+// loom_transport_shm.cpp). Requests are picked up with a plain load, so
+// polling is not backed off; responses wake the host through a futex
+// only when it has gone to sleep on an empty ring.
 
 #include <svdpi.h>
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <poll.h>
+#include <sched.h>
+#include <stdint.h>
 #include <string.h>
 #include <stdio.h>
 #include <errno.h>
+#include <time.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -30,11 +65,304 @@ static int trace_enabled = 0;
 #define LOOM_SOCK_WRITE_ACK  1
 #define LOOM_SOCK_IRQ        2
 
+#define LOOM_SOCK_FLAG_POSTED  0x01
+#define LOOM_SOCK_FLAG_HELLO   0x02
+#define LOOM_SOCK_PROTO_VERSION 2
+
+#define LOOM_SOCK_MSG_SIZE 12
+#define LOOM_SOCK_POLL_MAX_DEFAULT 32
+#define LOOM_SOCK_BUF_SIZE (LOOM_SOCK_MSG_SIZE * 256)
+
+static unsigned char rx_buf[LOOM_SOCK_BUF_SIZE];
+static size_t rx_len = 0;   // valid bytes in rx_buf
+static size_t rx_pos = 0;   // next unread byte
+static unsigned char tx_buf[LOOM_SOCK_BUF_SIZE];
+static size_t tx_len = 0;
+
+// Tag/flags of the request currently handed to the BFM
+static unsigned char cur_tag = 0;
+static unsigned char cur_flags = 0;
+
+// Idle poll backoff (see top of file)
+static unsigned int poll_max = LOOM_SOCK_POLL_MAX_DEFAULT;
+static unsigned int poll_gap = 0;    // current gap between polls
+static unsigned int poll_skip = 0;   // polls left to skip
+
+// ============================================================================
+// Shared-memory rings
+// ============================================================================
+
+// Segment layout (all fields native-endian, both peers are on one host):
+//   0x000  header: magic, version, slots, sim_pid, host_attached,
+//          sim_closed, host_closed
+//   0x040  request ring control  (host -> sim), one cache line per index
+//   0x100  response ring control (sim -> host)
+//   0x200  request slots, then response slots (LOOM_SHM_SLOTS x 16 bytes)
+// A slot carries the socket message fields; head/tail are free-running.
+
+#define LOOM_SHM_MAGIC   0x48534D4Cu   /* "LMSH" */
+#define LOOM_SHM_VERSION 1u
+#define LOOM_SHM_SLOTS   1024u
+#define LOOM_SHM_SLOTS_OFFSET 0x200u
+
+typedef struct {
+    uint32_t head;     uint32_t pad0[15];   // written by the producer
+    uint32_t tail;     uint32_t pad1[15];   // written by the consumer
+    uint32_t waiting;  uint32_t pad2[15];   // consumer sleeps on head
+} loom_shm_ring_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slots;
+    uint32_t sim_pid;
+    uint32_t host_attached;
+    uint32_t sim_closed;
+    uint32_t host_closed;
+    uint32_t pad[9];
+    loom_shm_ring_t req;
+    loom_shm_ring_t resp;
+} loom_shm_hdr_t;
+
+typedef struct {
+    unsigned char type;
+    unsigned char tag;
+    unsigned char flags;
+    unsigned char version;
+    uint32_t word0;    // request: address, response: read data
+    uint32_t word1;    // request: write data, response: irq bits
+    uint32_t reserved;
+} loom_shm_slot_t;
+
+static loom_shm_hdr_t *shm_hdr = NULL;
+static loom_shm_slot_t *shm_req = NULL;
+static loom_shm_slot_t *shm_resp = NULL;
+static size_t shm_size = 0;
+static char shm_path[256];
+static int shm_host_gone = 0;
+
+static void shm_futex_wait(uint32_t *addr, uint32_t val, long timeout_ns) {
+#ifdef __linux__
+    struct timespec ts = { timeout_ns / 1000000000L, timeout_ns % 1000000000L };
+    syscall(SYS_futex, addr, FUTEX_WAIT, val, &ts, NULL, 0);
+#else
+    (void)addr; (void)val;
+    struct timespec ts = { 0, timeout_ns < 100000L ? timeout_ns : 100000L };
+    nanosleep(&ts, NULL);
+#endif
+}
+
+static void shm_futex_wake(uint32_t *addr) {
+#ifdef __linux__
+    syscall(SYS_futex, addr, FUTEX_WAKE, 1, NULL, NULL, 0);
+#else
+    (void)addr;
+#endif
+}
+
+// Response push; spins while the host has not drained a full ring
+static void shm_push(unsigned char type, unsigned char tag,
+                     uint32_t data, uint32_t irq_bits) {
+    loom_shm_ring_t *r = &shm_hdr->resp;
+    uint32_t head = r->head;
+    while (head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) >= LOOM_SHM_SLOTS) {
+        if (__atomic_load_n(&shm_hdr->host_closed, __ATOMIC_ACQUIRE)) return;
+        sched_yield();
+    }
+    loom_shm_slot_t *slot = &shm_resp[head % LOOM_SHM_SLOTS];
+    slot->type = type;
+    slot->tag = tag;
+    slot->flags = 0;
+    slot->version = LOOM_SOCK_PROTO_VERSION;
+    slot->word0 = data;
+    slot->word1 = irq_bits;
+    // seq_cst store/load pair against the consumer's waiting/head pair:
+    // either it sees the new head or we see it waiting
+    __atomic_store_n(&r->head, head + 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&r->waiting, __ATOMIC_SEQ_CST)) shm_futex_wake(&r->head);
+}
+
+static int shm_try_recv(unsigned char *req_type, unsigned int *req_offset,
+                        unsigned int *req_wdata) {
+    loom_shm_ring_t *r = &shm_hdr->req;
+    uint32_t tail = r->tail;
+    if (__atomic_load_n(&r->head, __ATOMIC_ACQUIRE) == tail) {
+        if (__atomic_load_n(&shm_hdr->host_closed, __ATOMIC_ACQUIRE)) {
+            if (!shm_host_gone) printf("[loom_bfm] Client disconnected\n");
+            shm_host_gone = 1;
+            return -1;
+        }
+        return 0;
+    }
+    const loom_shm_slot_t *slot = &shm_req[tail % LOOM_SHM_SLOTS];
+    *req_type   = slot->type;
+    *req_offset = slot->word0;
+    *req_wdata  = slot->word1;
+    cur_tag     = slot->tag;
+    cur_flags   = slot->flags;
+    __atomic_store_n(&r->tail, tail + 1, __ATOMIC_RELEASE);
+
+    if (trace_enabled) {
+        printf("[DPI] shm_recv: type=%d tag=%u flags=0x%02x offset=0x%08x wdata=0x%08x\n",
+               *req_type, cur_tag, cur_flags, *req_offset, *req_wdata);
+        fflush(stdout);
+    }
+    return 1;
+}
+
+// Create the segment under a temporary name and rename it into place once
+// initialized, so a host that sees PATH never maps a half-built header.
+// Then wait for the host to attach, like accept() in socket mode.
+int loom_shm_init(const char *path) {
+    char tmp[sizeof(shm_path) + 8];
+    strncpy(shm_path, path, sizeof(shm_path) - 1);
+    shm_path[sizeof(shm_path) - 1] = '\0';
+    snprintf(tmp, sizeof(tmp), "%s.tmp", shm_path);
+
+    shm_size = LOOM_SHM_SLOTS_OFFSET + 2u * LOOM_SHM_SLOTS * sizeof(loom_shm_slot_t);
+    unlink(tmp);
+    int fd = open(tmp, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        perror("[loom_bfm] open shm");
+        return -1;
+    }
+    if (ftruncate(fd, (off_t)shm_size) < 0) {
+        perror("[loom_bfm] ftruncate shm");
+        close(fd);
+        unlink(tmp);
+        return -1;
+    }
+    void *mem = mmap(NULL, shm_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {
+        perror("[loom_bfm] mmap shm");
+        unlink(tmp);
+        return -1;
+    }
+    memset(mem, 0, shm_size);
+    shm_hdr = (loom_shm_hdr_t *)mem;
+    shm_req = (loom_shm_slot_t *)((char *)mem + LOOM_SHM_SLOTS_OFFSET);
+    shm_resp = shm_req + LOOM_SHM_SLOTS;
+    shm_hdr->version = LOOM_SHM_VERSION;
+    shm_hdr->slots = LOOM_SHM_SLOTS;
+    shm_hdr->sim_pid = (uint32_t)getpid();
+    __atomic_store_n(&shm_hdr->magic, LOOM_SHM_MAGIC, __ATOMIC_RELEASE);
+
+    unlink(shm_path);
+    if (rename(tmp, shm_path) < 0) {
+        perror("[loom_bfm] rename shm");
+        munmap(mem, shm_size);
+        shm_hdr = NULL;
+        unlink(tmp);
+        return -1;
+    }
+
+    printf("[loom_bfm] Waiting for connection on %s (shm) ...\n", shm_path);
+    fflush(stdout);
+    while (!__atomic_load_n(&shm_hdr->host_attached, __ATOMIC_ACQUIRE))
+        shm_futex_wait(&shm_hdr->host_attached, 0, 100000000L);
+    printf("[loom_bfm] Connected\n");
+    fflush(stdout);
+    return 0;
+}
+
+static void shm_close(void) {
+    __atomic_store_n(&shm_hdr->sim_closed, 1, __ATOMIC_SEQ_CST);
+    shm_futex_wake(&shm_hdr->resp.head);
+    munmap(shm_hdr, shm_size);
+    shm_hdr = NULL;
+    unlink(shm_path);
+}
+
+// ============================================================================
+// Socket
+// ============================================================================
+
+// Write out all queued responses (blocking)
+static int flush_tx(void) {
+    size_t total = 0;
+    while (total < tx_len) {
+        ssize_t n = write(client_fd, tx_buf + total, tx_len - total);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            struct pollfd pfd = { .fd = client_fd, .events = POLLOUT };
+            poll(&pfd, 1, -1);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            tx_len = 0;
+            return -1;
+        }
+        total += (size_t)n;
+    }
+    tx_len = 0;
+    return 0;
+}
+
+static void queue_msg(unsigned char type, unsigned char tag,
+                      unsigned int data, unsigned int irq_bits) {
+    if (tx_len + LOOM_SOCK_MSG_SIZE > sizeof(tx_buf)) flush_tx();
+
+    unsigned char *buf = tx_buf + tx_len;
+    buf[0] = type;
+    buf[1] = tag;
+    buf[2] = 0;
+    buf[3] = LOOM_SOCK_PROTO_VERSION;
+    buf[4] = data & 0xFF;
+    buf[5] = (data >> 8) & 0xFF;
+    buf[6] = (data >> 16) & 0xFF;
+    buf[7] = (data >> 24) & 0xFF;
+    buf[8] = irq_bits & 0xFF;
+    buf[9] = (irq_bits >> 8) & 0xFF;
+    buf[10] = (irq_bits >> 16) & 0xFF;
+    buf[11] = (irq_bits >> 24) & 0xFF;
+    tx_len += LOOM_SOCK_MSG_SIZE;
+}
+
+// Make at least one complete request available in rx_buf.
+// Returns: 1 if available, 0 if nothing pending, -1 on error/disconnect
+static int fill_rx(void) {
+    while (rx_len - rx_pos < LOOM_SOCK_MSG_SIZE) {
+        // Compact the partial message (if any) to the start of the buffer
+        if (rx_pos > 0) {
+            memmove(rx_buf, rx_buf + rx_pos, rx_len - rx_pos);
+            rx_len -= rx_pos;
+            rx_pos = 0;
+        }
+
+        ssize_t n = read(client_fd, rx_buf + rx_len, sizeof(rx_buf) - rx_len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) return -1;
+            // Nothing waiting: answer everything served so far
+            if (flush_tx() < 0) return -1;
+            if (rx_len == 0) return 0;
+            // Mid-message: must finish reading
+            struct pollfd pfd = { .fd = client_fd, .events = POLLIN };
+            poll(&pfd, 1, -1);
+            continue;
+        }
+        if (n == 0) {
+            printf("[loom_bfm] Client disconnected\n");
+            return -1;
+        }
+        rx_len += (size_t)n;
+    }
+    return 1;
+}
+
 // Enable/disable trace logging
 void loom_sock_set_trace(int enable) {
     trace_enabled = enable;
 }
 
+// Longest idle gap between socket polls, in BFM polls (0 = poll every cycle)
+void loom_sock_set_poll_max(int max_cycles) {
+    poll_max = max_cycles > 0 ? (unsigned int)max_cycles : 0;
+    poll_gap = 0;
+    poll_skip = 0;
+}
+
 // Initialize socket server, wait for client connection
 // Called once at simulation start
 int loom_sock_init(const char *path) {
@@ -92,91 +420,84 @@ int loom_sock_try_recv(
     unsigned int  *req_offset,
     unsigned int  *req_wdata
 ) {
+    if (shm_hdr) return shm_try_recv(req_type, req_offset, req_wdata);
     if (client_fd < 0) return -1;
 
-    struct pollfd pfd = { .fd = client_fd, .events = POLLIN };
-    int poll_ret = poll(&pfd, 1, 0);
-
-    if (poll_ret < 0) {
-        if (errno == EINTR) return 0;
-        return -1;
+    // Everything received has been answered (fill_rx flushed before
+    // reporting idle), so skipping here delays nothing already queued
+    if (poll_skip > 0) {
+        poll_skip--;
+        return 0;
     }
-    if (poll_ret == 0) return 0;
 
-    // Data available - read the full 12-byte message
-    unsigned char buf[12];
+    while (1) {
+        int rv = fill_rx();
+        if (rv == 0) {
+            poll_gap = poll_gap ? poll_gap * 2 : 1;
+            if (poll_gap > poll_max) poll_gap = poll_max;
+            poll_skip = poll_gap;
+            return 0;
+        }
+        if (rv < 0) return rv;
+        poll_gap = 0;
 
-    // Temporarily set blocking for complete read
-    fcntl(client_fd, F_SETFL, 0);
+        // Parse little-endian message
+        const unsigned char *buf = rx_buf + rx_pos;
+        rx_pos += LOOM_SOCK_MSG_SIZE;
 
-    ssize_t total = 0;
-    while (total < 12) {
-        ssize_t n = read(client_fd, buf + total, 12 - total);
-        if (n <= 0) {
-            fcntl(client_fd, F_SETFL, O_NONBLOCK);
-            if (n == 0) {
-                printf("[loom_bfm] Client disconnected\n");
-            }
-            return -1;
-        }
-        total += n;
-    }
+        *req_type   = buf[0];
+        *req_offset = buf[4] | (buf[5] << 8) | (buf[6] << 16) | (buf[7] << 24);
+        *req_wdata  = buf[8] | (buf[9] << 8) | (buf[10] << 16) | (buf[11] << 24);
+        cur_tag     = buf[1];
+        cur_flags   = buf[2];
 
-    fcntl(client_fd, F_SETFL, O_NONBLOCK);
+        if (trace_enabled) {
+            printf("[DPI] try_recv: type=%d tag=%u flags=0x%02x offset=0x%08x wdata=0x%08x\n",
+                   *req_type, cur_tag, cur_flags, *req_offset, *req_wdata);
+            fflush(stdout);
+        }
 
-    // Parse little-endian message
-    *req_type   = buf[0];
-    *req_offset = buf[4] | (buf[5] << 8) | (buf[6] << 16) | (buf[7] << 24);
-    *req_wdata  = buf[8] | (buf[9] << 8) | (buf[10] << 16) | (buf[11] << 24);
+        // Version probe: answered here, never reaches the AXI bus
+        if (cur_flags & LOOM_SOCK_FLAG_HELLO) {
+            queue_msg(LOOM_SOCK_READ_RESP, cur_tag, 0, 0);
+            continue;
+        }
 
-    if (trace_enabled) {
-        printf("[DPI] try_recv: type=%d offset=0x%08x wdata=0x%08x\n",
-               *req_type, *req_offset, *req_wdata);
-        fflush(stdout);
+        return 1;
     }
-
-    return 1;
 }
 
-// Send a 12-byte response (blocking)
+// Send a 12-byte response. Read responses and write acks are tagged with
+// the request in flight and queued; IRQ/SHUTDOWN go out immediately.
 void loom_sock_send(
     unsigned char resp_type,
     unsigned int  rdata,
     unsigned int  irq_bits
 ) {
-    if (client_fd < 0) return;
-
-    unsigned char buf[12] = {0};
-    buf[0] = resp_type;
-    // bytes 1-3 reserved
-    buf[4] = rdata & 0xFF;
-    buf[5] = (rdata >> 8) & 0xFF;
-    buf[6] = (rdata >> 16) & 0xFF;
-    buf[7] = (rdata >> 24) & 0xFF;
-    buf[8] = irq_bits & 0xFF;
-    buf[9] = (irq_bits >> 8) & 0xFF;
-    buf[10] = (irq_bits >> 16) & 0xFF;
-    buf[11] = (irq_bits >> 24) & 0xFF;
+    if (!shm_hdr && client_fd < 0) return;
 
-    // Blocking send
-    fcntl(client_fd, F_SETFL, 0);
+    if (resp_type == LOOM_SOCK_READ_RESP || resp_type == LOOM_SOCK_WRITE_ACK) {
+        if (resp_type == LOOM_SOCK_WRITE_ACK && (cur_flags & LOOM_SOCK_FLAG_POSTED))
+            return;  // posted write: host does not wait for an ack
+        if (shm_hdr) shm_push(resp_type, cur_tag, rdata, irq_bits);
+        else queue_msg(resp_type, cur_tag, rdata, irq_bits);
+        return;
+    }
 
-    size_t total = 0;
-    while (total < 12) {
-        ssize_t n = write(client_fd, buf + total, 12 - total);
-        if (n <= 0) {
-            fcntl(client_fd, F_SETFL, O_NONBLOCK);
-            return;
-        }
-        total += n;
+    if (shm_hdr) {
+        shm_push(resp_type, 0, rdata, irq_bits);
+        return;
     }
 
-    fcntl(client_fd, F_SETFL, O_NONBLOCK);
+    queue_msg(resp_type, 0, rdata, irq_bits);
+    flush_tx();
 }
 
 // Clean up sockets
 void loom_sock_close(void) {
+    if (shm_hdr) shm_close();
     if (client_fd >= 0) {
+        flush_tx();
         close(client_fd);
         client_fd = -1;
     }
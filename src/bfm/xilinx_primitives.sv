@@ -27,6 +27,23 @@ module IBUFDS_GTE4 #(
     assign ODIV2 = I;
 endmodule
 
+// Global clock buffer with clock enable (loom_clk_gate)
+//
+// Behavioral model: CE is latched while I is low, so the output only
+// carries whole clock pulses and a CE change from the I rising-edge
+// domain takes effect on the next rising edge.
+module BUFGCE #(
+    parameter CE_TYPE = "SYNC"
+)(
+    output wire O,
+    input  wire CE,
+    input  wire I
+);
+    reg ce_q = 1'b0;
+    always @(negedge I) ce_q <= CE;
+    assign O = I & ce_q;
+endmodule
+
 // ICAP for UltraScale+ — in-system configuration access port
 //
 // Behavioral model for simulation:
@@ -8,7 +8,7 @@ module xlnx_cdc (
     // Source side
     input  wire        s_axi_aclk,
     input  wire        s_axi_aresetn,
-    input  wire [19:0] s_axi_araddr,
+    input  wire [23:0] s_axi_araddr,
     input  wire [2:0]  s_axi_arprot,
     input  wire        s_axi_arvalid,
     output wire        s_axi_arready,
@@ -16,7 +16,7 @@ module xlnx_cdc (
     output wire [1:0]  s_axi_rresp,
     output wire        s_axi_rvalid,
     input  wire        s_axi_rready,
-    input  wire [19:0] s_axi_awaddr,
+    input  wire [23:0] s_axi_awaddr,
     input  wire [2:0]  s_axi_awprot,
     input  wire        s_axi_awvalid,
     output wire        s_axi_awready,
@@ -31,7 +31,7 @@ module xlnx_cdc (
     // Destination side
     input  wire        m_axi_aclk,
     input  wire        m_axi_aresetn,
-    output wire [19:0] m_axi_araddr,
+    output wire [23:0] m_axi_araddr,
     output wire [2:0]  m_axi_arprot,
     output wire        m_axi_arvalid,
     input  wire        m_axi_arready,
@@ -39,7 +39,7 @@ module xlnx_cdc (
     input  wire [1:0]  m_axi_rresp,
     input  wire        m_axi_rvalid,
     output wire        m_axi_rready,
-    output wire [19:0] m_axi_awaddr,
+    output wire [23:0] m_axi_awaddr,
     output wire [2:0]  m_axi_awprot,
     output wire        m_axi_awvalid,
     input  wire        m_axi_awready,
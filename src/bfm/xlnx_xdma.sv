@@ -80,8 +80,8 @@ module xlnx_xdma (
     output wire        m_axil_bready,
 
     // IRQ
-    input  wire [0:0]  usr_irq_req,
-    output wire [0:0]  usr_irq_ack,
+    input  wire [5:0]  usr_irq_req,
+    output wire [5:0]  usr_irq_ack,
     output wire        msi_enable,
     output wire [2:0]  msi_vector_width,
     input  wire        loom_finish_i,
@@ -102,7 +102,7 @@ module xlnx_xdma (
     // =========================================================================
     // Parameters
     // =========================================================================
-    localparam int ADDR_WIDTH = 20;
+    localparam int ADDR_WIDTH = 24;
     localparam int N_IRQ      = 16;
 
     // =========================================================================
@@ -174,7 +174,7 @@ module xlnx_xdma (
     // =========================================================================
     // IRQ — acknowledge immediately
     // =========================================================================
-    assign usr_irq_ack     = 1'b0;
+    assign usr_irq_ack     = 6'd0;
     assign msi_enable      = 1'b0;
     assign msi_vector_width = 3'd0;
 
@@ -209,7 +209,7 @@ module xlnx_xdma (
     wire                  bfm_shutdown;
 
     // IRQ vector for the BFM. Use the full synchronized IRQ from the shell
-    // (passed via loom_irq_i port) rather than the single-bit usr_irq_req.
+    // (passed via loom_irq_i port) rather than the per-vector usr_irq_req.
     wire [15:0] loom_irq;
 
     assign loom_irq = loom_irq_i;
@@ -245,8 +245,8 @@ module xlnx_xdma (
         .shutdown_o(bfm_shutdown)
     );
 
-    // Zero-extend BFM's 20-bit addresses to 32-bit
-    assign m_axil_araddr  = {12'd0, bfm_araddr};
+    // Zero-extend BFM's 24-bit addresses to 32-bit
+    assign m_axil_araddr  = {8'd0, bfm_araddr};
     assign m_axil_arvalid = bfm_arvalid;
     assign bfm_arready    = m_axil_arready;
     assign bfm_rdata      = m_axil_rdata;
@@ -254,7 +254,7 @@ module xlnx_xdma (
     assign bfm_rvalid     = m_axil_rvalid;
     assign m_axil_rready  = bfm_rready;
 
-    assign m_axil_awaddr  = {12'd0, bfm_awaddr};
+    assign m_axil_awaddr  = {8'd0, bfm_awaddr};
     assign m_axil_awvalid = bfm_awvalid;
     assign bfm_awready    = m_axil_awready;
     assign m_axil_wdata   = bfm_wdata;
@@ -0,0 +1,187 @@
+// SPDX-License-Identifier: Apache-2.0
+// Loom Display Log Implementation
+
+#include "loom_display_log.h"
+#include "loom_log.h"
+#include "loom_snapshot.pb.h"
+
+#include <algorithm>
+#include <fstream>
+
+namespace loom {
+
+static Logger logger = make_logger("display");
+
+namespace {
+
+constexpr RecordFormat kFormat = {{'L', 'O', 'O', 'M', 'D', 'S', 'P', 'L'}, 1, "display log"};
+
+struct RecordHeader {
+    uint16_t func_id;
+    uint16_t n_args;
+    uint32_t reserved;
+    uint64_t cycle;
+
+    size_t n_words() const { return n_args; }
+};
+static_assert(sizeof(RecordHeader) == 16);
+
+// Bits [lsb, lsb + 64) of the arg words; words past the span read as zero
+uint64_t arg_bits(std::span<const uint32_t> args, uint32_t lsb) {
+    auto word = [&](size_t i) -> uint64_t { return i < args.size() ? args[i] : 0; };
+    size_t w = lsb / 32;
+    uint32_t shift = lsb % 32;
+    uint64_t v = word(w) | (word(w + 1) << 32);
+    if (shift) v = (v >> shift) | (word(w + 2) << (64 - shift));
+    return v;
+}
+
+} // namespace
+
+// ============================================================================
+// Writer
+// ============================================================================
+
+Result<std::unique_ptr<DisplayLogWriter>> DisplayLogWriter::open(const std::string& path) {
+    std::unique_ptr<DisplayLogWriter> w(new DisplayLogWriter());
+    auto rc = w->file_.open(path, kFormat);
+    if (!rc.ok()) return rc.error();
+    w->file_.flush();
+    w->last_flush_ = std::chrono::steady_clock::now();
+    return w;
+}
+
+DisplayLogWriter::~DisplayLogWriter() {
+    close();
+}
+
+void DisplayLogWriter::append(const DisplayLogRecord& rec) {
+    RecordHeader h{static_cast<uint16_t>(rec.func_id),
+                   static_cast<uint16_t>(std::min<size_t>(trimmed_size(rec.args), UINT16_MAX)),
+                   0, rec.cycle};
+    file_.append(h, rec.args.first(h.n_args));
+}
+
+void DisplayLogWriter::flush_if_due() {
+    if (!file_.is_open() || file_.n_records() == n_flushed_) return;
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_flush_ < std::chrono::milliseconds(kDisplayFlushMs)) return;
+    file_.flush();
+    n_flushed_ = file_.n_records();
+    last_flush_ = now;
+}
+
+// ============================================================================
+// Reader
+// ============================================================================
+
+Result<std::unique_ptr<DisplayLogReader>> DisplayLogReader::open(const std::string& path) {
+    std::unique_ptr<DisplayLogReader> r(new DisplayLogReader());
+    auto rc = r->file_.open(path, kFormat);
+    if (!rc.ok()) return rc.error();
+    return r;
+}
+
+bool DisplayLogReader::next(DisplayLogRecord& rec) {
+    RecordHeader h;
+    if (!file_.next(h, args_)) return false;
+    rec.func_id = h.func_id;
+    rec.cycle = h.cycle;
+    rec.args = args_;
+    return true;
+}
+
+// ============================================================================
+// Formatter
+// ============================================================================
+
+Result<std::unique_ptr<DisplayFormatter>> DisplayFormatter::open(const std::string& path) {
+    std::ifstream f(path, std::ios::binary);
+    if (!f.is_open()) {
+        logger.error("Cannot open display map %s", path.c_str());
+        return Error::InvalidArg;
+    }
+    DisplayMap map;
+    if (!map.ParseFromIstream(&f)) {
+        logger.error("Failed to parse display map: %s", path.c_str());
+        return Error::Protocol;
+    }
+    return std::make_unique<DisplayFormatter>(map);
+}
+
+DisplayFormatter::DisplayFormatter(const DisplayMap& map) {
+    for (const auto& df : map.formats()) {
+        if (df.func_id() >= formats_.size()) formats_.resize(df.func_id() + 1);
+        Format& fmt = formats_[df.func_id()];
+        fmt.valid = true;
+        fmt.format = df.format();
+        uint32_t word = 0;
+        for (const auto& a : df.args()) {
+            fmt.args.push_back({word, a.width(), a.is_signed()});
+            word += (a.width() + 31) / 32;
+        }
+        n_formats_++;
+    }
+    logger.debug("Loaded display map: %zu format(s)", n_formats_);
+}
+
+bool DisplayFormatter::format(uint32_t func_id, std::span<const uint32_t> args,
+                              std::string& out) const {
+    if (func_id >= formats_.size() || !formats_[func_id].valid) return false;
+    const Format& fmt = formats_[func_id];
+    const std::string& f = fmt.format;
+
+    size_t next_arg = 0;
+    size_t i = 0;
+    while (i < f.size()) {
+        size_t pct = f.find('%', i);
+        out.append(f, i, pct == std::string::npos ? std::string::npos : pct - i);
+        if (pct == std::string::npos) break;
+        if (pct + 1 < f.size() && f[pct + 1] == '%') {
+            out += '%';
+            i = pct + 2;
+            continue;
+        }
+
+        // %[flags][width][.precision]conv
+        size_t end = f.find_first_not_of("-+ #0123456789.", pct + 1);
+        if (end == std::string::npos || next_arg >= fmt.args.size()) {
+            out.append(f, pct, end == std::string::npos ? std::string::npos : end + 1 - pct);
+            i = end == std::string::npos ? f.size() : end + 1;
+            continue;
+        }
+        std::string spec = f.substr(pct, end - pct);
+        char conv = f[end];
+        const Arg& arg = fmt.args[next_arg++];
+        i = end + 1;
+
+        if (conv == 's') {
+            // Verilog strings pack the first character at the MSB; NULs
+            // (unused leading bytes) print nothing
+            std::string str;
+            for (uint32_t byte = (arg.width + 7) / 8; byte-- > 0;) {
+                char ch = static_cast<char>(arg_bits(args, arg.word * 32 + byte * 8) & 0xFF);
+                if (ch) str += ch;
+            }
+            append_format(out, (spec + "s").c_str(), str.c_str());
+            continue;
+        }
+
+        uint32_t bits = std::min<uint32_t>(arg.width, 64);
+        uint64_t v = arg_bits(args, arg.word * 32);
+        if (bits < 64) v &= (uint64_t{1} << bits) - 1;
+        if (conv == 'd' || conv == 'i') {
+            int64_t sv = static_cast<int64_t>(v);
+            if (arg.is_signed && bits > 0 && bits < 64 && (v >> (bits - 1)) & 1)
+                sv = static_cast<int64_t>(v | ~((uint64_t{1} << bits) - 1));
+            append_format(out, (spec + "lld").c_str(), static_cast<long long>(sv));
+        } else if (conv == 'u' || conv == 'x' || conv == 'X' || conv == 'o') {
+            append_format(out, (spec + "ll" + conv).c_str(), static_cast<unsigned long long>(v));
+        } else {
+            out.append(spec).push_back(conv);
+        }
+    }
+    return true;
+}
+
+} // namespace loom
@@ -0,0 +1,118 @@
+// SPDX-License-Identifier: Apache-2.0
+// Loom Display Log - binary $display output, formatted offline
+//
+// loom_instrument turns $display/$write into read-only DPI functions
+// (__loom_display_N) whose wrapper does nothing but printf(). With a
+// display log, DpiService appends their DPI FIFO entries to a binary file
+// instead of formatting them; `loomx decode-log` renders the text later
+// from the display map loom_instrument writes (display_map.pb).
+//
+// A record file (loom_record_file.h) with magic "LOOMDSPL" and one record
+// per entry:
+//
+//   u16 func_id
+//   u16 n_args       arg words stored (trailing zero words dropped)
+//   u32 reserved
+//   u64 cycle        EMU cycle of the $display
+//   u32 args[n_args]
+//
+// The writer pushes its buffer to the file at least every kDisplayFlushMs
+// while entries arrive, so a reader can follow a running test.
+
+#pragma once
+
+#include "loom.h"
+#include "loom_record_file.h"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace loom {
+
+class DisplayMap;
+
+constexpr uint32_t kDisplayFlushMs = 200;
+
+struct DisplayLogRecord {
+    uint32_t func_id = 0;
+    uint64_t cycle = 0;
+    std::span<const uint32_t> args;
+};
+
+class DisplayLogWriter {
+public:
+    static Result<std::unique_ptr<DisplayLogWriter>> open(const std::string& path);
+    ~DisplayLogWriter();
+
+    DisplayLogWriter(const DisplayLogWriter&) = delete;
+    DisplayLogWriter& operator=(const DisplayLogWriter&) = delete;
+
+    const std::string& path() const { return file_.path(); }
+    uint64_t n_records() const { return file_.n_records(); }
+
+    void append(const DisplayLogRecord& rec);
+    // Flush if records were appended and kDisplayFlushMs passed since the
+    // last flush; call once per batch of appends
+    void flush_if_due();
+    Result<void> close() { return file_.close(); }
+
+private:
+    DisplayLogWriter() = default;
+
+    RecordFileWriter file_;
+    uint64_t n_flushed_ = 0;   // n_records() at the last flush
+    std::chrono::steady_clock::time_point last_flush_{};
+};
+
+// Sequential reader; follows a log that is still being written the way
+// RecordFileReader does
+class DisplayLogReader {
+public:
+    static Result<std::unique_ptr<DisplayLogReader>> open(const std::string& path);
+
+    const std::string& path() const { return file_.path(); }
+
+    // Next record (args valid until the following call); false at the end
+    bool next(DisplayLogRecord& rec);
+
+private:
+    DisplayLogReader() = default;
+
+    RecordFileReader file_;
+    std::vector<uint32_t> args_;
+};
+
+// Renders display log records as $display would have printed them
+class DisplayFormatter {
+public:
+    // Read a display map written by loom_instrument -display_map
+    static Result<std::unique_ptr<DisplayFormatter>> open(const std::string& path);
+    explicit DisplayFormatter(const DisplayMap& map);
+
+    size_t size() const { return n_formats_; }
+
+    // Append the text of one entry to `out`; false if func_id is not a
+    // $display function of this design. Arguments wider than 64 bits
+    // print their low 64 bits, like the generated wrapper's.
+    bool format(uint32_t func_id, std::span<const uint32_t> args, std::string& out) const;
+
+private:
+    struct Arg {
+        uint32_t word = 0;      // first arg word
+        uint32_t width = 0;
+        bool is_signed = false;
+    };
+    struct Format {
+        bool valid = false;
+        std::string format;
+        std::vector<Arg> args;
+    };
+    std::vector<Format> formats_;   // by func_id
+    size_t n_formats_ = 0;
+};
+
+} // namespace loom
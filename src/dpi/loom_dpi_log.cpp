@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: Apache-2.0
+// Loom DPI Call Log Implementation
+
+#include "loom_dpi_log.h"
+#include "loom_log.h"
+
+#include <algorithm>
+
+namespace loom {
+
+static Logger logger = make_logger("dpi");
+
+namespace {
+
+constexpr RecordFormat kFormat = {{'L', 'O', 'O', 'M', 'D', 'P', 'I', 'L'}, 1, "DPI log"};
+
+struct RecordHeader {
+    uint8_t kind;
+    uint8_t reserved;
+    uint16_t func_id;
+    uint16_t n_args;
+    uint16_t n_out;
+    uint64_t cycle;
+    uint64_t result;
+
+    size_t n_words() const { return size_t{n_args} + n_out; }
+};
+static_assert(sizeof(RecordHeader) == 24);
+
+} // namespace
+
+// ============================================================================
+// Writer
+// ============================================================================
+
+Result<std::unique_ptr<DpiLogWriter>> DpiLogWriter::open(const std::string& path) {
+    std::unique_ptr<DpiLogWriter> w(new DpiLogWriter());
+    auto rc = w->file_.open(path, kFormat);
+    if (!rc.ok()) return rc.error();
+    return w;
+}
+
+DpiLogWriter::~DpiLogWriter() {
+    close();
+}
+
+void DpiLogWriter::append(const DpiLogRecord& rec) {
+    RecordHeader h{static_cast<uint8_t>(rec.kind), 0, static_cast<uint16_t>(rec.func_id),
+                   static_cast<uint16_t>(std::min<size_t>(trimmed_size(rec.args), UINT16_MAX)),
+                   static_cast<uint16_t>(std::min<size_t>(rec.out.size(), UINT16_MAX)),
+                   rec.cycle, rec.result};
+    file_.append(h, rec.args.first(h.n_args), rec.out.first(h.n_out));
+}
+
+// ============================================================================
+// Reader
+// ============================================================================
+
+Result<std::unique_ptr<DpiLogReader>> DpiLogReader::open(const std::string& path) {
+    std::unique_ptr<DpiLogReader> r(new DpiLogReader());
+    r->path_ = path;
+
+    RecordFileReader file;
+    auto rc = file.open(path, kFormat);
+    if (!rc.ok()) return rc.error();
+
+    // Replay needs each kind in order independently; the log is read once
+    // up front so the per-kind cursors can scan it in memory
+    RecordHeader h;
+    std::vector<uint32_t> words;
+    while (file.next(h, words)) {
+        r->entries_.push_back({static_cast<DpiLogKind>(h.kind), h.func_id, h.cycle, h.result,
+                               r->words_.size(), h.n_args, h.n_out});
+        r->words_.insert(r->words_.end(), words.begin(), words.end());
+    }
+    if (file.partial()) logger.warning("DPI log %s is truncated", path.c_str());
+    return r;
+}
+
+bool DpiLogReader::next(DpiLogKind kind, DpiLogRecord& rec) {
+    size_t& cursor = cursor_[static_cast<size_t>(kind) % 3];
+    while (cursor < entries_.size()) {
+        const Entry& e = entries_[cursor++];
+        if (e.kind != kind) continue;
+        const uint32_t* data = words_.data() + e.word;
+        rec.kind = e.kind;
+        rec.func_id = e.func_id;
+        rec.cycle = e.cycle;
+        rec.result = e.result;
+        rec.args = std::span<const uint32_t>(data, e.n_args);
+        rec.out = std::span<const uint32_t>(data + e.n_args, e.n_out);
+        return true;
+    }
+    return false;
+}
+
+} // namespace loom
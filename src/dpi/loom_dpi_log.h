@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: Apache-2.0
+// Loom DPI Call Log - record/replay of DPI traffic
+//
+// DpiService can record every call it services to a binary log and later
+// replay a run from it: regfile and initial calls are completed with the
+// logged result and output words instead of running user code, so a
+// failing test reruns without its multisim peers or file-backed models
+// and as fast as the hardware allows.
+//
+// A record file (loom_record_file.h) with magic "LOOMDPIL" and one record
+// per call:
+//
+//   u8  kind         DpiLogKind
+//   u8  reserved
+//   u16 func_id
+//   u16 n_args       arg words stored (trailing zero words dropped)
+//   u16 n_out        output words stored
+//   u64 cycle        EMU cycle count when serviced (0 for FIFO entries)
+//   u64 result
+//   u32 words[n_args + n_out]
+//
+// FIFO entries do not stall the DUT, so they are not ordered against
+// regfile calls: the reader keeps one cursor per kind.
+
+#pragma once
+
+#include "loom.h"
+#include "loom_record_file.h"
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace loom {
+
+enum class DpiLogKind : uint8_t {
+    Call = 0,   // regfile call (DUT stalled until completed)
+    Fifo = 1,   // read-only FIFO entry
+    Init = 2,   // initial / reset DPI call run by the shell
+};
+
+struct DpiLogRecord {
+    DpiLogKind kind = DpiLogKind::Call;
+    uint32_t func_id = 0;
+    uint64_t cycle = 0;
+    uint64_t result = 0;
+    std::span<const uint32_t> args;
+    std::span<const uint32_t> out;
+};
+
+class DpiLogWriter {
+public:
+    static Result<std::unique_ptr<DpiLogWriter>> open(const std::string& path);
+    ~DpiLogWriter();
+
+    DpiLogWriter(const DpiLogWriter&) = delete;
+    DpiLogWriter& operator=(const DpiLogWriter&) = delete;
+
+    const std::string& path() const { return file_.path(); }
+    uint64_t n_records() const { return file_.n_records(); }
+
+    void append(const DpiLogRecord& rec);
+    Result<void> close() { return file_.close(); }
+
+private:
+    DpiLogWriter() = default;
+
+    RecordFileWriter file_;
+};
+
+class DpiLogReader {
+public:
+    static Result<std::unique_ptr<DpiLogReader>> open(const std::string& path);
+
+    const std::string& path() const { return path_; }
+
+    // Next record of `kind`; false once there are none left
+    bool next(DpiLogKind kind, DpiLogRecord& rec);
+
+private:
+    struct Entry {
+        DpiLogKind kind;
+        uint32_t func_id;
+        uint64_t cycle;
+        uint64_t result;
+        size_t word;                // first arg word in words_
+        uint32_t n_args;
+        uint32_t n_out;
+    };
+
+    DpiLogReader() = default;
+
+    std::string path_;
+    std::vector<Entry> entries_;
+    std::vector<uint32_t> words_;   // arg and output words of all entries
+    size_t cursor_[3] = {};         // per kind: entry index to scan from
+};
+
+} // namespace loom
@@ -3,18 +3,211 @@
 
 #include "loom_dpi_service.h"
 #include "loom_log.h"
+#include "loom_ring.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
 
 namespace loom {
 
 static Logger logger = make_logger("dpi");
 
+// ============================================================================
+// Worker Pool (concurrent mode)
+// ============================================================================
+//
+// The servicing thread reads call arguments, pushes a job onto the worker's
+// ring and keeps polling. The worker runs the callback and posts the result
+// on the shared completion ring; the servicing thread writes it back to the
+// regfile on its next round. Regfile calls use the function's own args/out
+// buffers (hardware keeps at most one call per function pending); FIFO
+// entries copy their args into one of kFifoSlots slots, freed in order.
+
+namespace {
+
+constexpr size_t kJobDepth = 1024;
+constexpr size_t kFifoSlots = kJobDepth;
+// FIFO entries popped per batched read
+constexpr uint32_t kFifoBatch = 256;
+
+struct DpiJob {
+    DpiFunc* func = nullptr;
+    const uint32_t* args = nullptr;
+    uint32_t n_args = 0;
+    bool fifo = false;
+};
+
+struct DpiDone {
+    DpiFunc* func = nullptr;
+    uint64_t result = 0;
+    bool fifo = false;
+    uint64_t callback_ns = 0;
+};
+
+thread_local DpiService* t_current_service = nullptr;
+thread_local bool t_dpi_worker = false;    // running on a Pool worker
+
+// Built-in $display / assertion functions always run live under replay
+bool is_builtin(const DpiFunc& func) {
+    return func.name.starts_with("__loom_");
+}
+
+bool is_display(const DpiFunc& func) {
+    return func.name.starts_with("__loom_display_");
+}
+
+uint64_t ns_since(std::chrono::steady_clock::time_point t0) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - t0).count());
+}
+
+} // namespace
+
+struct DpiService::Pool {
+    struct Worker {
+        Ring<DpiJob> jobs{kJobDepth};
+        std::atomic<uint32_t> signal{0};
+        std::thread thread;
+    };
+
+    Pool(DpiService* owner, unsigned n_workers)
+        : owner(owner), done(n_workers * (kJobDepth + 1)) {
+        for (unsigned i = 0; i < n_workers; i++)
+            workers.push_back(std::make_unique<Worker>());
+        for (auto& w : workers)
+            w->thread = std::thread([this, wp = w.get()] { run(*wp); });
+    }
+
+    ~Pool() {
+        stop.store(true, std::memory_order_release);
+        for (auto& w : workers) {
+            w->signal.fetch_add(1, std::memory_order_release);
+            w->signal.notify_one();
+        }
+        for (auto& w : workers) w->thread.join();
+    }
+
+    // Function-pinned worker; independent FIFO entries all go to worker 0
+    Worker& worker_for(int func_id, bool fifo) {
+        if (fifo || workers.size() == 1) return *workers[0];
+        return *workers[1 + static_cast<size_t>(func_id) % (workers.size() - 1)];
+    }
+
+    void push(Worker& w, const DpiJob& job) {
+        while (!w.jobs.try_push(job)) std::this_thread::yield();
+        w.signal.fetch_add(1, std::memory_order_release);
+        w.signal.notify_one();
+    }
+
+    void run(Worker& w) {
+        t_dpi_worker = true;
+        DpiJob job;
+        while (true) {
+            if (w.jobs.try_pop(job)) {
+                execute(job);
+                continue;
+            }
+            uint32_t seen = w.signal.load(std::memory_order_acquire);
+            if (stop.load(std::memory_order_acquire)) break;
+            if (w.jobs.try_pop(job)) {
+                execute(job);
+                continue;
+            }
+            w.signal.wait(seen, std::memory_order_acquire);
+        }
+    }
+
+    void execute(const DpiJob& job) {
+        // VPI calls from the callback find this service's Context, not the
+        // global one (several services run side by side under -farm)
+        t_current_service = owner;
+        std::span<const uint32_t> args(job.args, job.n_args);
+        DpiDone d{job.func, 0, job.fifo};
+        auto t0 = std::chrono::steady_clock::now();
+        if (job.fifo) {
+            job.func->callback(args, std::span<uint32_t>());
+        } else {
+            std::span<uint32_t> out_args(job.func->out_args_buf);
+            std::fill(out_args.begin(), out_args.end(), 0);
+            d.result = job.func->callback(args, out_args);
+        }
+        d.callback_ns = ns_since(t0);
+        while (!done.try_push(d)) std::this_thread::yield();
+    }
+
+    DpiService* owner;
+    std::vector<std::unique_ptr<Worker>> workers;
+    Ring<DpiDone> done;
+    std::atomic<bool> stop{false};
+
+    // FIFO arg slots (servicing thread allocates in order, reap frees in order)
+    std::vector<uint32_t> fifo_args;
+    size_t fifo_stride = 0;
+    size_t fifo_next = 0;
+    size_t fifo_used = 0;
+};
+
 // ============================================================================
 // DpiService Implementation
 // ============================================================================
 
+DpiService::DpiService() = default;
+DpiService::~DpiService() {
+    if (t_current_service == this) t_current_service = nullptr;
+}
+
+void DpiService::set_workers(unsigned n_workers) {
+    if (busy())
+        logger.warning("set_workers: %zu call(s) still in flight", n_in_flight_);
+    pool_.reset();
+    n_in_flight_ = 0;
+    std::fill(in_flight_.begin(), in_flight_.end(), 0);
+    if (n_workers > 0) {
+        pool_ = std::make_unique<Pool>(this, n_workers);
+        logger.info("Concurrent DPI service: %u worker(s)", n_workers);
+    }
+}
+
+unsigned DpiService::workers() const {
+    return pool_ ? static_cast<unsigned>(pool_->workers.size()) : 0;
+}
+
+bool DpiService::set_independent(std::string_view name, bool independent) {
+    for (auto& func : funcs_) {
+        if (func.name == name) {
+            func.independent = independent;
+            return true;
+        }
+    }
+    return false;
+}
+
+void DpiService::set_all_independent(bool independent) {
+    for (auto& func : funcs_)
+        if (!is_builtin(func)) func.independent = independent;
+}
+
 void DpiService::register_func(int func_id, std::string_view name, int n_args,
                                 int ret_width, int out_arg_words, bool call_at_init,
-                                bool read_only, DpiCallback callback) {
+                                bool read_only, DpiCallback callback,
+                                int xarg_words, int xres_words) {
+    if (func_id < 0) {
+        logger.error("Invalid function ID %d for '%.*s'", func_id,
+                     static_cast<int>(name.size()), name.data());
+        return;
+    }
+    if (static_cast<size_t>(func_id) >= dispatch_.size())
+        dispatch_.resize(func_id + 1, -1);
+    if (dispatch_[func_id] >= 0)
+        logger.warning("Function ID %d re-registered as '%.*s'", func_id,
+                       static_cast<int>(name.size()), name.data());
+    dispatch_[func_id] = static_cast<int>(funcs_.size());
+
     funcs_.push_back({
         .func_id = func_id,
         .name = std::string(name),
@@ -23,103 +216,410 @@ void DpiService::register_func(int func_id, std::string_view name, int n_args,
         .out_arg_words = out_arg_words,
         .call_at_init = call_at_init,
         .read_only = read_only,
-        .callback = std::move(callback)
+        .xarg_words = std::max(xarg_words, 0),
+        .xres_words = std::max(xres_words, 0),
+        .callback = std::move(callback),
+        // Large-argument functions read their arrays in place past the arg registers
+        .args_buf = std::vector<uint32_t>(xarg_words > 0 ? kDpiXargBase + xarg_words
+                                                         : kDpiDefaultMaxArgs, 0),
+        .out_args_buf = std::vector<uint32_t>(std::max({out_arg_words, xres_words, 0}), 0)
     });
     logger.debug("Registered function '%.*s' (id=%d, %d args, %d-bit return, %d out words, init=%d, ro=%d)",
               static_cast<int>(name.size()), name.data(), func_id, n_args, ret_width, out_arg_words, call_at_init, read_only);
 }
 
 const DpiFunc* DpiService::find_func(int func_id) const {
-    for (const auto& func : funcs_) {
-        if (func.func_id == func_id) {
-            return &func;
-        }
-    }
-    return nullptr;
+    if (func_id < 0 || static_cast<size_t>(func_id) >= dispatch_.size())
+        return nullptr;
+    int idx = dispatch_[func_id];
+    return idx >= 0 ? &funcs_[idx] : nullptr;
+}
+
+DpiFunc* DpiService::find_func(int func_id) {
+    return const_cast<DpiFunc*>(std::as_const(*this).find_func(func_id));
 }
 
 const DpiFunc* DpiService::find_func_by_id(int func_id) const {
     return find_func(func_id);
 }
 
+void DpiService::size_buffers(const Context& ctx) {
+    size_t n_args = ctx.max_dpi_args();
+    for (auto& func : funcs_) {
+        if (func.args_buf.size() < n_args) func.args_buf.resize(n_args, 0);
+    }
+
+    // FIFO entries are read straight into fifo_buf_; the words past the
+    // entry stay zero so the arg span always covers max_dpi_args words.
+    size_t fifo_words = std::max<size_t>(ctx.fifo_entry_words(), 1 + n_args);
+    if (fifo_buf_.size() < fifo_words) fifo_buf_.resize(fifo_words, 0);
+
+    if (pending_buf_.size() < ctx.dpi_pending_words())
+        pending_buf_.resize(ctx.dpi_pending_words(), 0);
+
+    if (in_flight_.size() < dispatch_.size())
+        in_flight_.resize(dispatch_.size(), 0);
+
+    // Slots are only resized while none are in use
+    if (pool_ && pool_->fifo_stride < n_args && pool_->fifo_used == 0) {
+        pool_->fifo_stride = n_args;
+        pool_->fifo_args.assign(kFifoSlots * n_args, 0);
+        pool_->fifo_next = 0;
+    }
+}
+
 int DpiService::drain_fifo(Context& ctx) {
-    if (ctx.fifo_entry_words() == 0)
+    uint32_t ew = ctx.fifo_entry_words();
+    if (ew == 0)
         return 0;  // No FIFO in this design
 
+    size_buffers(ctx);
+    if (fifo_batch_.size() < kFifoBatch * ew) fifo_batch_.resize(kFifoBatch * ew, 0);
+
+    // Each round reads the level once and pops everything it reported in a
+    // single batched read; stop once a round comes back empty.
     int drained = 0;
     while (true) {
-        auto empty = ctx.fifo_is_empty();
-        if (!empty.ok()) {
-            if (empty.error() == Error::Shutdown)
+        auto n = ctx.fifo_pop_entries(fifo_batch_, kFifoBatch);
+        if (!n.ok()) {
+            if (n.error() == Error::Shutdown)
                 return static_cast<int>(Error::Shutdown);
-            logger.error("FIFO status read failed");
+            logger.error("FIFO pop failed");
             return -1;
         }
-        if (empty.value())
+        if (n.value() == 0)
             break;  // FIFO empty
 
-        // Pop entry: read data words, then write pop command
-        auto entry = ctx.fifo_pop_entry();
-        if (!entry.ok()) {
-            if (entry.error() == Error::Shutdown)
-                return static_cast<int>(Error::Shutdown);
-            logger.error("FIFO pop failed");
-            return -1;
+        // Entries carry the low 24 bits of their cycle; one full read per
+        // batch, taken after the pop, extends them
+        if (display_log_) {
+            auto cycle = ctx.get_cycle_count();
+            if (cycle.ok()) fifo_cycle_ = cycle.value();
         }
 
-        const auto& words = entry.value();
-        if (words.empty()) break;
-
-        // Parse: func_id in word[0][7:0], args in word[1..N-1]
-        int func_id = words[0] & 0xFF;
-        const DpiFunc* func = find_func(func_id);
-        if (!func) {
-            logger.error("FIFO: unknown function ID %d", func_id);
-            error_count_++;
+        for (uint32_t i = 0; i < n.value(); i++) {
+            // Words past the entry stay zero so the arg span always covers
+            // max_dpi_args words
+            std::copy_n(&fifo_batch_[i * ew], ew, fifo_buf_.begin());
+            int rc = dispatch_fifo_entry(ctx, drained);
+            if (rc < 0) return rc;
             drained++;
-            continue;
         }
+    }
 
-        if (!func->callback) {
-            logger.error("FIFO: no callback for '%s' (id=%d)", func->name.c_str(), func_id);
-            error_count_++;
-            drained++;
-            continue;
+    if (display_log_) display_log_->flush_if_due();
+    return drained;
+}
+
+int DpiService::dispatch_fifo_entry(Context& ctx, int drained) {
+    std::span<const uint32_t> args(fifo_buf_.data() + 1, ctx.max_dpi_args());
+
+    // Parse: func_id in word[0][7:0], args in word[1..N-1]
+    int func_id = fifo_buf_[0] & 0xFF;
+    DpiFunc* func = find_func(func_id);
+    if (!func) {
+        logger.error("FIFO: unknown function ID %d", func_id);
+        error_count_++;
+        return 0;
+    }
+
+    if (!func->callback) {
+        logger.error("FIFO: no callback for '%s' (id=%d)", func->name.c_str(), func_id);
+        error_count_++;
+        return 0;
+    }
+
+    // FIFO calls return nothing, so replay only checks them against the
+    // log; the callback still runs for its side effects
+    if (replay_) {
+        DpiLogRecord rec;
+        replay_match(DpiLogKind::Fifo, *func, 0, args, rec);
+    }
+    if (record_) record_call(DpiLogKind::Fifo, *func, 0, args, 0, {});
+
+    // Display log: store the raw entry, leave formatting to decode-log
+    if (display_log_ && is_display(*func)) {
+        uint64_t stamp = fifo_buf_[0] >> 8;
+        uint64_t cycle = fifo_cycle_ - ((fifo_cycle_ - stamp) & 0xFFFFFF);
+        display_log_->append({static_cast<uint32_t>(func_id), cycle, args});
+        func->stats.calls++;
+        return 0;
+    }
+
+    // Args are FIFO words [1..N-1]; read-only calls have no outputs.
+    // Entries of other functions run inline, in FIFO order with the
+    // regfile calls serviced after this drain.
+    if (pool_ && func->independent && pool_->fifo_stride >= args.size()) {
+        // Wait for a free arg slot, then hand the entry to worker 0
+        while (pool_->fifo_used == kFifoSlots) {
+            int rc = reap(ctx);
+            if (rc < 0) return rc;
+            if (rc == 0) std::this_thread::yield();
+        }
+        uint32_t* slot = &pool_->fifo_args[pool_->fifo_next * pool_->fifo_stride];
+        std::copy(args.begin(), args.end(), slot);
+        pool_->fifo_next = (pool_->fifo_next + 1) % kFifoSlots;
+        pool_->fifo_used++;
+        n_in_flight_++;
+        pool_->push(pool_->worker_for(func_id, true),
+                    {const_cast<DpiFunc*>(func), slot,
+                     static_cast<uint32_t>(args.size()), true});
+        return 0;
+    }
+    auto t0 = std::chrono::steady_clock::now();
+    func->callback(args, std::span<uint32_t>());
+    add_callback_time(*func, ns_since(t0));
+    func->stats.calls++;
+
+    if (drained < 20 || (drained % 10000 == 0)) {
+        logger.debug("FIFO[%d] '%s' drained#%d", func_id, func->name.c_str(), drained);
+    }
+
+    call_count_++;
+    return 0;
+}
+
+int DpiService::service_call(Context& ctx, uint32_t func_id) {
+    DpiFunc* func = find_func(static_cast<int>(func_id));
+    if (!func) {
+        logger.error("Unknown function ID: %u", func_id);
+        ctx.dpi_error(func_id);
+        error_count_++;
+        return 0;
+    }
+
+    if (!func->callback) {
+        logger.error("No callback for function '%s' (id=%d)",
+                     func->name.c_str(), func->func_id);
+        ctx.dpi_error(func_id);
+        error_count_++;
+        return 0;
+    }
+
+    // Register traffic of this call, up to its staged completion
+    const auto& tstats = ctx.transport_stats();
+    uint64_t reads0 = tstats.read_ops;
+    uint64_t writes0 = tstats.write_ops;
+    func->pending_since = poll_time_;
+
+    // Get call details; a large-argument call's arrays follow in one
+    // burst from the scratch window, read straight into the arg buffer
+    std::span<uint32_t> args(func->args_buf.data(), ctx.max_dpi_args());
+    auto call_result = ctx.dpi_get_call(func_id, args);
+    if (call_result.ok() && func->xarg_words > 0) {
+        args = std::span<uint32_t>(func->args_buf.data(), kDpiXargBase + func->xarg_words);
+        call_result = ctx.dpi_read_xargs(args.subspan(kDpiXargBase));
+    }
+    func->stats.mmio_reads += tstats.read_ops - reads0;
+    func->stats.mmio_writes += tstats.write_ops - writes0;
+    if (!call_result.ok()) {
+        if (call_result.error() == Error::Shutdown) {
+            return static_cast<int>(Error::Shutdown);
         }
+        logger.error("Failed to get call for '%s'", func->name.c_str());
+        error_count_++;
+        return 0;
+    }
 
-        // Build args from FIFO words [1..N-1]
-        std::vector<uint32_t> args(ctx.max_dpi_args(), 0);
-        for (uint32_t w = 1; w < words.size() && (w - 1) < args.size(); w++) {
-            args[w - 1] = words[w];
+    // Complete the call from the replay log instead of running user code
+    if (record_ || replay_) func->call_cycle = log_cycle(ctx);
+    if (replay_) {
+        DpiLogRecord rec;
+        if (replay_match(DpiLogKind::Call, *func, func->call_cycle, args, rec) &&
+            !is_builtin(*func)) {
+            std::span<uint32_t> out_args(func->out_args_buf);
+            std::fill(out_args.begin(), out_args.end(), 0);
+            std::copy_n(rec.out.begin(), std::min(rec.out.size(), out_args.size()), out_args.begin());
+            replayed_count_++;
+            return finish_call(ctx, *func, rec.result);
         }
+    }
+
+    // Concurrent mode: the worker owns args/out_args until it posts the
+    // result; the regfile holds the call pending until reap() completes it.
+    // Recording runs calls inline so the log keeps them in call order.
+    if (pool_ && func->independent && !record_) {
+        in_flight_[func_id] = 1;
+        n_in_flight_++;
+        pool_->push(pool_->worker_for(func->func_id, false),
+                    {func, args.data(), static_cast<uint32_t>(args.size()), false});
+        return 1;
+    }
 
-        std::span<const uint32_t> args_span(args.data(), args.size());
-        std::vector<uint32_t> out_args_buf;  // empty for read-only
-        std::span<uint32_t> out_args(out_args_buf);
-        func->callback(args_span, out_args);
+    // Call the user function.
+    // Pass all arg register words — the wrapper indexes by hardware
+    // offset, not logical argument count.
+    std::span<uint32_t> out_args(func->out_args_buf);
+    std::fill(out_args.begin(), out_args.end(), 0);
+    auto t0 = std::chrono::steady_clock::now();
+    reads0 = tstats.read_ops;
+    writes0 = tstats.write_ops;
+    uint64_t result = func->callback(args, out_args);
+    add_callback_time(*func, ns_since(t0));
+    // Callbacks may access registers themselves (e.g. through VPI)
+    func->stats.mmio_reads += tstats.read_ops - reads0;
+    func->stats.mmio_writes += tstats.write_ops - writes0;
+
+    return finish_call(ctx, *func, result);
+}
+
+int DpiService::finish_call(Context& ctx, DpiFunc& func, uint64_t result) {
+    auto func_id = static_cast<uint32_t>(func.func_id);
 
-        if (drained < 20 || (drained % 10000 == 0)) {
-            logger.debug("FIFO[%d] '%s' drained#%d", func_id, func->name.c_str(), drained);
+    // Log: first 20, then every 10000th
+    if (call_count_ < 20 || (call_count_ % 10000 == 0)) {
+        logger.debug("DPI[%u] '%s' result=0x%llx out_words=%d call#%llu",
+            func_id, func.name.c_str(), (unsigned long long)result,
+            func.out_arg_words, (unsigned long long)call_count_);
+    }
+
+    // Stage output open array data, the result (void functions have none)
+    // and set_done; post_completions() issues the round's completions as
+    // one write batch
+    std::span<const uint32_t> out_args(func.out_args_buf);
+    std::span<const uint32_t> xresult;
+    if (func.xres_words > 0) std::swap(out_args, xresult);  // scratch window, not arg registers
+    auto staged = ctx.dpi_stage_complete(func_id, result, out_args, func.ret_width > 0, xresult);
+    if (!staged.ok()) {
+        logger.error("Failed to complete call for '%s'", func.name.c_str());
+        error_count_++;
+        return 0;
+    }
+
+    if (record_) {
+        size_t n_args = func.xarg_words > 0 ? kDpiXargBase + func.xarg_words : ctx.max_dpi_args();
+        record_call(DpiLogKind::Call, func, func.call_cycle,
+                    std::span<const uint32_t>(func.args_buf.data(), n_args), result,
+                    func.out_args_buf);
+    }
+
+    call_count_++;
+    func.stats.calls++;
+    staged_funcs_.push_back(&func);
+    return 1;
+}
+
+void DpiService::add_callback_time(DpiFunc& func, uint64_t ns) {
+    func.stats.callback_ns += ns;
+    func.stats.max_callback_ns = std::max(func.stats.max_callback_ns, ns);
+}
+
+int DpiService::post_completions(Context& ctx) {
+    auto posted = ctx.dpi_flush_completions();
+    auto now = std::chrono::steady_clock::now();
+    for (auto* func : staged_funcs_) {
+        func->stats.stall_ns += static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now - func->pending_since).count());
+    }
+    staged_funcs_.clear();
+    if (!posted.ok()) {
+        if (posted.error() == Error::Shutdown) {
+            return static_cast<int>(Error::Shutdown);
         }
+        logger.error("Failed to post DPI completions");
+        error_count_++;
+        return 0;
+    }
+    return static_cast<int>(posted.value());
+}
 
-        drained++;
-        call_count_++;
+int DpiService::reap(Context& ctx) {
+    if (!pool_) return 0;
+
+    int completed = 0;
+    DpiDone d;
+    while (pool_->done.try_pop(d)) {
+        n_in_flight_--;
+        add_callback_time(*d.func, d.callback_ns);
+        if (d.fifo) {
+            pool_->fifo_used--;
+            d.func->stats.calls++;
+            call_count_++;
+            completed++;
+            continue;
+        }
+        in_flight_[d.func->func_id] = 0;
+        int rc = finish_call(ctx, *d.func, d.result);
+        if (rc == static_cast<int>(Error::Shutdown)) return rc;
+        completed += rc;
     }
+    return completed;
+}
 
-    return drained;
+int DpiService::flush(Context& ctx) {
+    int completed = 0;
+    while (busy()) {
+        int rc = reap(ctx);
+        if (rc < 0) return rc;
+        if (rc == 0) std::this_thread::yield();
+        completed += rc;
+    }
+    int rc = post_completions(ctx);
+    if (rc < 0) return rc;
+    rc = apply_worker_control(ctx);
+    if (rc < 0) return rc;
+    return completed;
+}
+
+Result<void> DpiService::request_finish(int exit_code) {
+    if (t_dpi_worker) {
+        finish_code_.store(exit_code, std::memory_order_relaxed);
+        finish_requested_.store(true, std::memory_order_release);
+        return {};
+    }
+    if (!current_ctx_) return Error::InvalidArg;
+    return current_ctx_->finish(exit_code);
+}
+
+Result<void> DpiService::request_stop() {
+    if (t_dpi_worker) {
+        stop_requested_.store(true, std::memory_order_release);
+        return {};
+    }
+    if (!current_ctx_) return Error::InvalidArg;
+    return current_ctx_->stop();
+}
+
+int DpiService::apply_worker_control(Context& ctx) {
+    Result<void> rc;
+    if (stop_requested_.exchange(false, std::memory_order_acquire))
+        rc = ctx.stop();
+    if (rc.ok() && finish_requested_.exchange(false, std::memory_order_acquire))
+        rc = ctx.finish(finish_code_.load(std::memory_order_relaxed));
+    if (rc.ok()) return 0;
+    if (rc.error() == Error::Shutdown) return static_cast<int>(Error::Shutdown);
+    logger.error("vpi_control from a DPI worker failed");
+    error_count_++;
+    return 0;
 }
 
 int DpiService::service_once(Context& ctx) {
     // Set context so user DPI functions can call vpi_control etc.
     current_ctx_ = &ctx;
+    t_current_service = this;
+
+    // After an interrupt, skip the reads its source rules out. The FIFO is
+    // still drained on a DPI interrupt (entries below the threshold raise
+    // none) so FIFO entries keep their order ahead of the call.
+    round_wake_ = std::exchange(wake_bits_, irq_src::All);
+    const bool check_fifo = round_wake_ & (irq_src::Dpi | irq_src::FifoThreshold);
+    const bool check_pending = round_wake_ & irq_src::Dpi;
+    idle_stats_.skipped_reads += !check_fifo + !check_pending;
 
     // Drain FIFO before servicing regfile calls (preserves ordering)
-    int fifo_rc = drain_fifo(ctx);
+    int fifo_rc = check_fifo ? drain_fifo(ctx) : 0;
     if (fifo_rc == static_cast<int>(Error::Shutdown))
         return fifo_rc;
 
-    // Poll for pending DPI calls
-    auto poll_result = ctx.dpi_poll();
+    // Complete calls finished by workers since the last round
+    int serviced = reap(ctx);
+    if (serviced < 0) return serviced;
+
+    // Poll for pending DPI calls (one burst over the pending mask bank)
+    size_buffers(ctx);
+    std::span<uint32_t> pending(pending_buf_.data(), check_pending ? ctx.dpi_pending_words() : 0);
+    poll_time_ = std::chrono::steady_clock::now();
+    auto poll_result = check_pending ? ctx.dpi_poll(pending) : Result<void>{};
     if (!poll_result.ok()) {
         if (poll_result.error() == Error::Shutdown) {
             return static_cast<int>(Error::Shutdown);
@@ -128,103 +628,83 @@ int DpiService::service_once(Context& ctx) {
         return static_cast<int>(poll_result.error());
     }
 
-    uint32_t pending_mask = poll_result.value();
-    if (pending_mask == 0) {
-        return 0;  // No pending calls
-    }
-
-    int serviced = 0;
-
-    // Service each pending call
-    for (size_t func_id = 0; func_id < funcs_.size() && func_id < 32; func_id++) {
-        if (!(pending_mask & (1u << func_id))) {
-            continue;
-        }
-
-        const DpiFunc* func = find_func(static_cast<int>(func_id));
-        if (!func) {
-            logger.error("Unknown function ID: %zu", func_id);
-            ctx.dpi_error(static_cast<uint32_t>(func_id));
-            error_count_++;
-            continue;
+    // Service each pending call, lowest function ID first
+    for (size_t word = 0; word < pending.size(); word++) {
+        for (uint32_t bits = pending[word]; bits != 0; bits &= bits - 1) {
+            auto func_id = static_cast<uint32_t>(word * 32 + std::countr_zero(bits));
+            if (func_id < in_flight_.size() && in_flight_[func_id])
+                continue;  // Still running on a worker
+            int rc = service_call(ctx, func_id);
+            if (rc == static_cast<int>(Error::Shutdown))
+                return rc;
+            serviced += rc;
         }
+    }
 
-        if (!func->callback) {
-            logger.error("No callback for function '%s' (id=%d)",
-                      func->name.c_str(), func->func_id);
-            ctx.dpi_error(static_cast<uint32_t>(func_id));
-            error_count_++;
-            continue;
-        }
+    int post_rc = post_completions(ctx);
+    if (post_rc < 0) return post_rc;
+    // After the completions, so a call that finished the test is answered
+    int ctl_rc = apply_worker_control(ctx);
+    if (ctl_rc < 0) return ctl_rc;
 
-        // Get call details
-        auto call_result = ctx.dpi_get_call(static_cast<uint32_t>(func_id));
-        if (!call_result.ok()) {
-            if (call_result.error() == Error::Shutdown) {
-                return static_cast<int>(Error::Shutdown);
-            }
-            logger.error("Failed to get call for '%s'", func->name.c_str());
-            error_count_++;
-            continue;
-        }
+    if (serviced > 0 || fifo_rc > 0) last_work_ = std::chrono::steady_clock::now();
+    return serviced;
+}
 
-        const DpiCall& call = call_result.value();
-
-        // Call the user function.
-        // Pass all arg register words — the wrapper indexes by hardware
-        // offset, not logical argument count.
-        std::span<const uint32_t> args(call.args.data(), call.args.size());
-        // Allocate buffer for output open array data
-        std::vector<uint32_t> out_args_buf(func->out_arg_words, 0);
-        std::span<uint32_t> out_args(out_args_buf);
-        uint64_t result = func->callback(args, out_args);
-
-        // Log: first 20, then every 10000th
-        if (call_count_ < 20 || (call_count_ % 10000 == 0)) {
-            logger.debug("DPI[%zu] '%s' result=0x%llx out_words=%d call#%llu",
-                func_id, func->name.c_str(), (unsigned long long)result,
-                func->out_arg_words, (unsigned long long)call_count_);
-        }
+Result<void> DpiService::wait_for_work(Context& ctx) {
+    // Calls running on workers complete without an interrupt, so keep
+    // polling while any are outstanding.
+    if (!uses_irq(ctx) || busy())
+        return {};
 
-        // Write output open array data back to regfile arg registers
-        for (int i = 0; i < func->out_arg_words; i++) {
-            auto wr_result = ctx.dpi_write_arg(static_cast<uint32_t>(func_id), i, out_args_buf[i]);
-            if (!wr_result.ok()) {
-                logger.error("Failed to write output arg %d for '%s'", i, func->name.c_str());
-                error_count_++;
-                break;
-            }
-        }
+    auto now = std::chrono::steady_clock::now();
+    if (mode_ == DpiMode::Adaptive && now - last_work_ < spin_budget_) {
+        idle_stats_.spin_polls++;
+        return {};
+    }
 
-        // Complete the call
-        auto complete_result = ctx.dpi_complete(static_cast<uint32_t>(func_id), result);
-        if (!complete_result.ok()) {
-            if (complete_result.error() == Error::Shutdown) {
-                return static_cast<int>(Error::Shutdown);
-            }
-            logger.error("Failed to complete call for '%s'", func->name.c_str());
-            error_count_++;
-            continue;
-        }
+    idle_stats_.irq_waits++;
+    wake_bits_ = irq_src::All;
+    auto irq = ctx.wait_irq();
+    auto woke = std::chrono::steady_clock::now();
+    idle_stats_.sleep_ns += static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(woke - now).count());
+    // Spin again after every wakeup: chatty designs stay in the poll loop
+    last_work_ = woke;
+    if (!irq.ok()) return irq.error();
+    if (irq.value()) wake_bits_ = irq.value();
+    return {};
+}
 
-        serviced++;
-        call_count_++;
+static const char* dpi_mode_name(DpiMode mode, bool has_irq) {
+    if (!has_irq) return "polling";
+    switch (mode) {
+        case DpiMode::Interrupt: return "interrupt";
+        case DpiMode::Adaptive:  return "adaptive";
+        default:                 return "polling";
     }
-
-    return serviced;
 }
 
 DpiExitCode DpiService::run(Context& ctx, int /*timeout_ms*/) {
     current_ctx_ = &ctx;
+    t_current_service = this;
+    last_work_ = std::chrono::steady_clock::now();
 
-    bool use_irq = (mode_ == DpiMode::Interrupt) && ctx.has_irq_support();
     logger.info("Entering service loop (n_funcs=%zu, mode=%s)",
-                funcs_.size(), use_irq ? "interrupt" : "polling");
+                funcs_.size(), dpi_mode_name(mode_, ctx.has_irq_support()));
+
+    // State-change IRQ wakes the loop on finish and lets it skip the
+    // EMU_STATUS read after other interrupts
+    const bool use_irq = uses_irq(ctx);
+    if (use_irq) {
+        auto en = ctx.read32(addr::EmuCtrl + reg::IrqEnable);
+        if (en.ok()) ctx.write32(addr::EmuCtrl + reg::IrqEnable, en.value() | status::IrqStateChange);
+    }
 
     while (true) {
-        // --- Wait for interrupt (interrupt mode only) ---
-        if (use_irq) {
-            auto irq = ctx.wait_irq();
+        // --- Wait for the next event (interrupt / adaptive modes) ---
+        {
+            auto irq = wait_for_work(ctx);
             if (!irq.ok()) {
                 if (irq.error() == Error::Shutdown) {
                     logger.info("Shutdown received");
@@ -258,6 +738,7 @@ DpiExitCode DpiService::run(Context& ctx, int /*timeout_ms*/) {
         }
 
         // --- Check emulation state ---
+        if (use_irq && !state_may_have_changed()) continue;
         auto state_result = ctx.get_state();
         if (!state_result.ok()) {
             if (state_result.error() == Error::Shutdown) {
@@ -277,6 +758,7 @@ DpiExitCode DpiService::run(Context& ctx, int /*timeout_ms*/) {
         if (state_result.value() == State::Frozen) {
             // Final FIFO drain to flush any remaining entries
             drain_fifo(ctx);
+            flush(ctx);
             logger.info("Emulation frozen, test complete");
             current_ctx_ = nullptr;
             return DpiExitCode::Complete;
@@ -284,14 +766,205 @@ DpiExitCode DpiService::run(Context& ctx, int /*timeout_ms*/) {
     }
 }
 
+// ============================================================================
+// Record / Replay
+// ============================================================================
+
+Result<void> DpiService::record_to(const std::string& path) {
+    auto w = DpiLogWriter::open(path);
+    if (!w.ok()) return w.error();
+    record_ = std::move(w.value());
+    logger.info("Recording DPI calls to %s", path.c_str());
+    return {};
+}
+
+Result<void> DpiService::replay_from(const std::string& path) {
+    auto r = DpiLogReader::open(path);
+    if (!r.ok()) return r.error();
+    replay_ = std::move(r.value());
+    replayed_count_ = 0;
+    divergence_cycle_.reset();
+    logger.info("Replaying DPI calls from %s", path.c_str());
+    return {};
+}
+
+Result<void> DpiService::display_log_to(const std::string& path) {
+    auto w = DisplayLogWriter::open(path);
+    if (!w.ok()) return w.error();
+    display_log_ = std::move(w.value());
+    logger.info("Logging $display output to %s", path.c_str());
+    return {};
+}
+
+Result<void> DpiService::close_log() {
+    Result<void> display_rc;
+    if (display_log_) {
+        display_rc = display_log_->close();
+        if (display_rc.ok())
+            logger.info("Logged %llu $display entries to %s",
+                        static_cast<unsigned long long>(display_log_->n_records()),
+                        display_log_->path().c_str());
+        display_log_.reset();
+    }
+
+    if (replay_ || replayed_count_ > 0 || divergence_cycle_) {
+        if (divergence_cycle_)
+            logger.info("Replay: %llu call(s) served from the log, diverged at cycle %llu",
+                        static_cast<unsigned long long>(replayed_count_),
+                        static_cast<unsigned long long>(*divergence_cycle_));
+        else
+            logger.info("Replay: %llu call(s) served from the log",
+                        static_cast<unsigned long long>(replayed_count_));
+        replay_.reset();
+    }
+    if (!record_) return display_rc;
+    auto rc = record_->close();
+    if (rc.ok())
+        logger.info("Recorded %llu DPI call(s) to %s",
+                    static_cast<unsigned long long>(record_->n_records()), record_->path().c_str());
+    record_.reset();
+    return rc.ok() ? display_rc : rc;
+}
+
+uint64_t DpiService::call_init(const DpiFunc& func, std::span<uint32_t> out_args) {
+    std::fill(out_args.begin(), out_args.end(), 0);
+    if (replay_) {
+        DpiLogRecord rec;
+        if (replay_match(DpiLogKind::Init, func, 0, {}, rec) && !is_builtin(func)) {
+            std::copy_n(rec.out.begin(), std::min(rec.out.size(), out_args.size()), out_args.begin());
+            replayed_count_++;
+            return rec.result;
+        }
+    }
+    uint64_t result = func.callback(std::span<const uint32_t>(), out_args);
+    if (record_) record_call(DpiLogKind::Init, func, 0, {}, result, out_args);
+    return result;
+}
+
+uint64_t DpiService::log_cycle(Context& ctx) {
+    auto cycle = ctx.get_cycle_count();
+    if (cycle.ok()) last_cycle_ = cycle.value();
+    return last_cycle_;
+}
+
+bool DpiService::replay_match(DpiLogKind kind, const DpiFunc& func, uint64_t cycle,
+                              std::span<const uint32_t> args, DpiLogRecord& rec) {
+    // The log trims trailing zero arg words
+    size_t n_args = args.size();
+    while (n_args > 0 && args[n_args - 1] == 0) n_args--;
+
+    const char* what = nullptr;
+    if (!replay_->next(kind, rec))
+        what = "log exhausted";
+    else if (rec.func_id != static_cast<uint32_t>(func.func_id))
+        what = "different function";
+    else if (rec.cycle != cycle)
+        what = "different cycle";
+    else if (!std::equal(rec.args.begin(), rec.args.end(), args.begin(), args.begin() + n_args))
+        what = "different arguments";
+    if (!what) return true;
+
+    // FIFO entries carry no cycle; report the last regfile call's
+    uint64_t at = kind == DpiLogKind::Fifo ? last_cycle_ : cycle;
+    logger.error("Replay diverged at cycle %llu: '%s' (id=%d): %s; continuing live",
+                 static_cast<unsigned long long>(at), func.name.c_str(), func.func_id, what);
+    divergence_cycle_ = at;
+    replay_.reset();
+    return false;
+}
+
+void DpiService::record_call(DpiLogKind kind, const DpiFunc& func, uint64_t cycle,
+                             std::span<const uint32_t> args, uint64_t result,
+                             std::span<const uint32_t> out) {
+    record_->append({kind, static_cast<uint32_t>(func.func_id), cycle, result, args, out});
+}
+
 void DpiService::print_stats() const {
     logger.info("Statistics:");
     logger.info("  Total calls serviced: %llu", static_cast<unsigned long long>(call_count_));
     logger.info("  Errors: %llu", static_cast<unsigned long long>(error_count_));
     logger.info("  Registered functions: %zu", funcs_.size());
+    if (mode_ != DpiMode::Polling) {
+        logger.info("  Idle: %llu spin polls, %llu irq waits (%.3f ms asleep), %llu reads skipped",
+                    static_cast<unsigned long long>(idle_stats_.spin_polls),
+                    static_cast<unsigned long long>(idle_stats_.irq_waits),
+                    static_cast<double>(idle_stats_.sleep_ns) / 1e6,
+                    static_cast<unsigned long long>(idle_stats_.skipped_reads));
+    }
+    for (const auto& func : funcs_) {
+        logger.info("    [%d] %s (%d args, %d-bit return): %llu calls, %.3f ms in callback",
+                 func.func_id, func.name.c_str(), func.n_args, func.ret_width,
+                 static_cast<unsigned long long>(func.stats.calls),
+                 static_cast<double>(func.stats.callback_ns) / 1e6);
+    }
+}
+
+void DpiService::reset_stats(Context& ctx) {
+    for (auto& func : funcs_) {
+        func.stats = {};
+    }
+    idle_stats_ = {};
+    call_count_ = 0;
+    error_count_ = 0;
+    ctx.reset_transport_stats();
+    if (ctx.has_emu_perf()) {
+        auto rc = ctx.clear_emu_perf();
+        if (!rc.ok()) logger.warning("Failed to clear emu_ctrl perf counters");
+    }
+}
+
+void DpiService::write_perf(std::ostream& os, const Context& ctx, const EmuPerf* emu) const {
+    auto u = [](uint64_t v) { return std::to_string(v); };
+
+    os << "[dpi]\n"
+       << "calls = " << u(call_count_) << "\n"
+       << "errors = " << u(error_count_) << "\n"
+       << "spin_polls = " << u(idle_stats_.spin_polls) << "\n"
+       << "irq_waits = " << u(idle_stats_.irq_waits) << "\n"
+       << "sleep_ns = " << u(idle_stats_.sleep_ns) << "\n"
+       << "skipped_reads = " << u(idle_stats_.skipped_reads) << "\n";
+
     for (const auto& func : funcs_) {
-        logger.info("    [%d] %s (%d args, %d-bit return)",
-                 func.func_id, func.name.c_str(), func.n_args, func.ret_width);
+        os << "\n[[dpi_func]]\n"
+           << "id = " << func.func_id << "\n"
+           << "name = \"" << func.name << "\"\n"
+           << "calls = " << u(func.stats.calls) << "\n"
+           << "callback_ns = " << u(func.stats.callback_ns) << "\n"
+           << "max_callback_ns = " << u(func.stats.max_callback_ns) << "\n"
+           << "stall_ns = " << u(func.stats.stall_ns) << "\n"
+           << "mmio_reads = " << u(func.stats.mmio_reads) << "\n"
+           << "mmio_writes = " << u(func.stats.mmio_writes) << "\n";
+        if (emu && func.func_id >= 0 &&
+            static_cast<size_t>(func.func_id) < emu->func_stall_cycles.size()) {
+            os << "hw_stall_cycles = " << u(emu->func_stall_cycles[func.func_id]) << "\n";
+        }
+    }
+
+    const auto& t = ctx.transport_stats();
+    os << "\n[transport]\n"
+       << "read_ops = " << u(t.read_ops) << "\n"
+       << "write_ops = " << u(t.write_ops) << "\n"
+       << "read_bytes = " << u(t.read_bytes) << "\n"
+       << "write_bytes = " << u(t.write_bytes) << "\n"
+       << "round_trips = " << u(t.round_trips()) << "\n"
+       << "irq_waits = " << u(t.irq_waits) << "\n"
+       << "busy_ns = " << u(t.busy_ns) << "\n"
+       << "p50_ns = " << u(t.latency_quantile_ns(0.50)) << "\n"
+       << "p99_ns = " << u(t.latency_quantile_ns(0.99)) << "\n"
+       << "latency_hist = [";
+    for (size_t i = 0; i < t.latency_hist.size(); i++) {
+        os << (i ? ", " : "") << u(t.latency_hist[i]);
+    }
+    os << "]\n";
+
+    if (emu) {
+        os << "\n[emu]\n"
+           << "clock_mhz = " << ctx.clock_mhz() << "\n"
+           << "run_cycles = " << u(emu->run_cycles) << "\n"
+           << "enabled_cycles = " << u(emu->enabled_cycles) << "\n"
+           << "dpi_stall_cycles = " << u(emu->dpi_stall_cycles) << "\n"
+           << "fifo_stall_cycles = " << u(emu->fifo_stall_cycles) << "\n"
+           << "efficiency = " << emu->efficiency() << "\n";
     }
 }
 
@@ -301,4 +974,8 @@ DpiService& global_dpi_service() {
     return instance;
 }
 
+DpiService& current_dpi_service() {
+    return t_current_service ? *t_current_service : global_dpi_service();
+}
+
 } // namespace loom
@@ -8,6 +8,7 @@
 #ifndef LOOM_DPI_SERVICE_H
 #define LOOM_DPI_SERVICE_H
 
+#include <stdarg.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -23,6 +24,12 @@ extern "C" {
 // Return value is 64-bit to accommodate all scalar types.
 typedef uint64_t (*loom_dpi_callback_t)(const uint32_t *args, uint32_t *out_args);
 
+// Functions with xarg_words/xres_words set pass their arrays through the
+// regfile's scratch window: the callback finds the input array words at
+// args[LOOM_DPI_XARG_BASE..] (past every arg register) and writes output
+// arrays to out_args[0..xres_words).
+#define LOOM_DPI_XARG_BASE 12
+
 // DPI function descriptor
 typedef struct {
     int func_id;                    // Function ID (from loom_instrument)
@@ -32,9 +39,16 @@ typedef struct {
     int out_arg_words;              // Number of 32-bit output open array words (0 if none)
     int call_at_init;               // Execute before emulation starts (initial/reset DPI)
     int read_only;                  // 1 = uses DPI FIFO path (void return, all-input args)
+    int xarg_words;                 // Input array words in the scratch window (0 if none)
+    int xres_words;                 // Output array words in the scratch window (0 if none)
     loom_dpi_callback_t callback;   // User-provided callback
 } loom_dpi_func_t;
 
+// Sink for built-in $display output. The generated dispatch defines
+// `loom_dpi_display_hook` (NULL = vprintf); loomx points it at the
+// host logger so DUT output shares the async log.
+typedef int (*loom_dpi_display_fn_t)(const char *fmt, va_list args);
+
 #ifdef __cplusplus
 }
 #endif
@@ -46,9 +60,16 @@ typedef struct {
 #ifdef __cplusplus
 
 #include "loom.h"
+#include "loom_display_log.h"
+#include "loom_dpi_log.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
 #include <string>
 #include <vector>
 #include <functional>
+#include <iosfwd>
+#include <optional>
 #include <span>
 
 namespace loom {
@@ -57,11 +78,25 @@ namespace loom {
 // Actual value is read from hardware at connect time (Context::max_dpi_args()).
 constexpr int kDpiDefaultMaxArgs = 8;
 
+// First args word of a large-argument function's scratch window data
+constexpr int kDpiXargBase = LOOM_DPI_XARG_BASE;
+
 // DPI function callback type
 // Args are passed as a span, return value is 64-bit to accommodate all types
 using DpiCallback = std::function<uint64_t(std::span<const uint32_t> args,
                                            std::span<uint32_t> out_args)>;
 
+// Per-function performance counters (see DpiService::write_perf)
+struct DpiFuncStats {
+    uint64_t calls = 0;
+    uint64_t callback_ns = 0;      // time inside the user callback
+    uint64_t max_callback_ns = 0;
+    uint64_t mmio_reads = 0;       // transport reads/writes issued while
+    uint64_t mmio_writes = 0;      // servicing the call (batched completions excluded)
+    uint64_t stall_ns = 0;         // seen pending -> completion posted; the DUT
+                                   // is stalled meanwhile (regfile calls only)
+};
+
 // DPI function descriptor
 struct DpiFunc {
     int func_id;                // Function ID (from loom_instrument)
@@ -71,13 +106,37 @@ struct DpiFunc {
     int out_arg_words = 0;      // Number of 32-bit output open array words
     bool call_at_init = false;  // Execute before emulation starts (initial/reset DPI)
     bool read_only = false;     // Uses DPI FIFO path (void return, all-input args)
+    int xarg_words = 0;         // Input array words read from the scratch window
+    int xres_words = 0;         // Output array words written to the scratch window
+    bool independent = false;   // May run on a worker thread (concurrent mode)
     DpiCallback callback;       // User-provided callback
+
+    // Per-call scratch, sized at registration and reused for every call
+    // (grown once if the hardware reports more arg words than the default)
+    std::vector<uint32_t> args_buf;
+    std::vector<uint32_t> out_args_buf;
+
+    DpiFuncStats stats{};
+    std::chrono::steady_clock::time_point pending_since{};  // poll that saw the call
+    uint64_t call_cycle = 0;    // EMU cycle of the call in service (record mode)
 };
 
 // DPI service mode
 enum class DpiMode {
     Polling,    // Tight poll loop on pending mask register (default, lowest latency)
     Interrupt,  // Block in wait_irq() until hardware interrupt fires
+    Adaptive,   // Poll for a spin budget after the last call, then wait_irq()
+};
+
+// Default Adaptive-mode spin budget after the last serviced call
+constexpr uint32_t kDpiDefaultSpinUs = 200;
+
+// Idle-wait statistics (Interrupt and Adaptive modes)
+struct DpiIdleStats {
+    uint64_t spin_polls = 0;   // Idle rounds that kept polling (within budget)
+    uint64_t irq_waits = 0;    // Times the loop blocked in wait_irq()
+    uint64_t sleep_ns = 0;     // Total time blocked in wait_irq()
+    uint64_t skipped_reads = 0;  // FIFO / pending mask reads the IRQ source made unnecessary
 };
 
 // Service loop exit codes
@@ -95,8 +154,8 @@ enum class DpiExitCode {
 
 class DpiService {
 public:
-    DpiService() = default;
-    ~DpiService() = default;
+    DpiService();
+    ~DpiService();
 
     // Non-copyable
     DpiService(const DpiService&) = delete;
@@ -105,7 +164,8 @@ public:
     // Register a DPI function
     void register_func(int func_id, std::string_view name, int n_args,
                        int ret_width, int out_arg_words, bool call_at_init,
-                       bool read_only, DpiCallback callback);
+                       bool read_only, DpiCallback callback,
+                       int xarg_words = 0, int xres_words = 0);
 
     // Register functions from a C-style array (for compatibility with generated code)
     template<typename T>
@@ -117,7 +177,8 @@ public:
                           [cb = funcs[i].callback](std::span<const uint32_t> args,
                                                     std::span<uint32_t> out_args) {
                               return cb(args.data(), out_args.data());
-                          });
+                          },
+                          funcs[i].xarg_words, funcs[i].xres_words);
         }
     }
 
@@ -133,8 +194,17 @@ public:
 
     // Service a single round of DPI calls (non-blocking)
     // Returns number of calls serviced, or negative on error
+    //
+    // The first round after an interrupt wakeup only reads what the
+    // interrupt source calls for: the pending mask on a DPI interrupt, the
+    // FIFO on a DPI or FIFO-threshold one. Every other round reads both.
     int service_once(Context& ctx);
 
+    // False if the last round followed an interrupt that was not a state
+    // change, so EMU_STATUS cannot have changed since the previous check.
+    // Callers that skip get_state() on it must enable the state-change IRQ.
+    bool state_may_have_changed() const { return round_wake_ & irq_src::StateChange; }
+
     // Accessors
     uint64_t call_count() const { return call_count_; }
     uint64_t error_count() const { return error_count_; }
@@ -149,26 +219,175 @@ public:
     // Print service statistics
     void print_stats() const;
 
+    // Zero the per-function counters, idle stats and the context's
+    // transport and emu_ctrl counters
+    void reset_stats(Context& ctx);
+
+    // Machine-readable dump of all counters (TOML): [dpi], one [[dpi_func]]
+    // per registered function, [transport] and, when given, [emu] with the
+    // hardware stall counters (each [[dpi_func]] then gets hw_stall_cycles)
+    void write_perf(std::ostream& os, const Context& ctx, const EmuPerf* emu = nullptr) const;
+
     // DPI service mode
     void set_mode(DpiMode mode) { mode_ = mode; }
     DpiMode mode() const { return mode_; }
 
+    // Adaptive mode: keep polling for spin_us after the last serviced call
+    void set_spin_budget_us(uint32_t spin_us) { spin_budget_ = std::chrono::microseconds(spin_us); }
+    uint32_t spin_budget_us() const { return static_cast<uint32_t>(spin_budget_.count()); }
+
+    // True if the mode may block in wait_irq() on this transport
+    bool uses_irq(const Context& ctx) const {
+        return mode_ != DpiMode::Polling && ctx.has_irq_support();
+    }
+
+    // Wait for the next DPI event after an idle service round, according
+    // to the mode: Polling returns at once, Interrupt blocks in
+    // wait_irq(), Adaptive returns at once while within the spin budget of
+    // the last serviced call and blocks afterwards. Never blocks while
+    // busy(). Errors are those of Context::wait_irq().
+    Result<void> wait_for_work(Context& ctx);
+
+    const DpiIdleStats& idle_stats() const { return idle_stats_; }
+
+    // Concurrent mode: with n_workers > 0, calls and read-only FIFO entries
+    // of independent functions run on a worker pool while this thread
+    // keeps polling. Each function is pinned to one worker, so calls of the
+    // same function stay in order; their FIFO entries all go to worker 0
+    // and stay in FIFO order. Everything else, $display included, runs
+    // inline in order. All register access stays on the servicing thread, so
+    // independent callbacks must not touch the Context; vpi_control finish
+    // and stop from a worker are deferred to it (request_finish). 0
+    // (default) runs every callback inline.
+    void set_workers(unsigned n_workers);
+    unsigned workers() const;
+
+    // Mark a function as safe to run concurrently with all others.
+    // Returns false if no function has that name.
+    bool set_independent(std::string_view name, bool independent = true);
+    // All user functions; $display and assertions keep their order
+    void set_all_independent(bool independent = true);
+
+    // True while calls handed to workers have not been completed yet.
+    // Callers must keep calling service_once() (not block in wait_irq)
+    // while busy: the DUT stays stalled until the completion is written.
+    bool busy() const { return n_in_flight_ > 0; }
+
+    // Wait for all outstanding worker calls and complete them.
+    // Returns the number of calls completed, or negative on error.
+    int flush(Context& ctx);
+
     // Get current context (for VPI functions)
     Context* current_context() const { return current_ctx_; }
 
+    // vpi_control(vpiFinish / vpiStop) from a callback. On the servicing
+    // thread the command goes straight to the current Context; on a worker
+    // it is recorded and the next service_once() (or flush()) issues it,
+    // so workers never touch the transport.
+    Result<void> request_finish(int exit_code);
+    Result<void> request_stop();
+
+    // Record/replay (see loom_dpi_log.h). Recording logs every call
+    // serviced, with its EMU cycle, args and results. Replay completes
+    // regfile and init calls from the log without running their callbacks;
+    // the first call whose function, cycle or args differ from the log is
+    // reported as a divergence and the run continues with live callbacks.
+    // Built-in __loom_* functions ($display, assertions) always run live.
+    // While recording, independent functions run inline (not on workers).
+    Result<void> record_to(const std::string& path);
+    Result<void> replay_from(const std::string& path);
+    // Binary display log (see loom_display_log.h): FIFO entries of the
+    // built-in __loom_display_* functions are appended raw, with their EMU
+    // cycle, instead of being formatted. Assertion messages still print.
+    Result<void> display_log_to(const std::string& path);
+    bool display_logging() const { return display_log_ != nullptr; }
+    // Flush the record and display logs / end replay and log a summary
+    Result<void> close_log();
+    bool recording() const { return record_ != nullptr; }
+    bool replaying() const { return replay_ != nullptr; }
+    uint64_t replayed_count() const { return replayed_count_; }
+    std::optional<uint64_t> divergence_cycle() const { return divergence_cycle_; }
+
+    // Run an initial / reset DPI function (no args), recorded or replayed
+    // like a regfile call. The shell calls these before scan-in.
+    uint64_t call_init(const DpiFunc& func, std::span<uint32_t> out_args);
+
 private:
     const DpiFunc* find_func(int func_id) const;
+    DpiFunc* find_func(int func_id);
+
+    // Service one pending regfile call. Returns 1 if serviced (or handed
+    // to a worker), 0 on a per-call error, or Error::Shutdown.
+    int service_call(Context& ctx, uint32_t func_id);
+
+    // Write back results posted by workers. Returns calls completed, or
+    // Error::Shutdown / negative on error.
+    int reap(Context& ctx);
+    int finish_call(Context& ctx, DpiFunc& func, uint64_t result);
+    void add_callback_time(DpiFunc& func, uint64_t ns);
+    // Issue completions staged by finish_call; negative on shutdown
+    int post_completions(Context& ctx);
+    // Issue finish / stop requested by worker callbacks; negative on shutdown
+    int apply_worker_control(Context& ctx);
+
+    struct Pool;                      // Worker threads and rings
+    std::unique_ptr<Pool> pool_;
+    std::vector<uint8_t> in_flight_;  // func_id → call handed to a worker
+    size_t n_in_flight_ = 0;
+
+    // Grow per-function and FIFO buffers to the connected design's sizes
+    void size_buffers(const Context& ctx);
+
+    // Run or queue the FIFO entry held in fifo_buf_; negative on error
+    int dispatch_fifo_entry(Context& ctx, int drained);
+
+    // Next replay record of `kind` if it matches the call, else report the
+    // divergence and stop replaying
+    bool replay_match(DpiLogKind kind, const DpiFunc& func, uint64_t cycle,
+                      std::span<const uint32_t> args, DpiLogRecord& rec);
+    void record_call(DpiLogKind kind, const DpiFunc& func, uint64_t cycle,
+                     std::span<const uint32_t> args, uint64_t result,
+                     std::span<const uint32_t> out);
+    uint64_t log_cycle(Context& ctx);
+
+    std::unique_ptr<DpiLogWriter> record_;
+    std::unique_ptr<DpiLogReader> replay_;
+    std::unique_ptr<DisplayLogWriter> display_log_;
+    uint64_t fifo_cycle_ = 0;          // cycle count read after the last FIFO pop (display log)
+    uint64_t replayed_count_ = 0;
+    uint64_t last_cycle_ = 0;          // cycle of the last logged regfile call
+    std::optional<uint64_t> divergence_cycle_;
 
     std::vector<DpiFunc> funcs_;
+    std::vector<int> dispatch_;        // func_id → index into funcs_ (-1 = none)
+    std::vector<uint32_t> pending_buf_;  // DPI pending mask bank words
+    std::vector<uint32_t> fifo_buf_;  // [func_id word | max_dpi_args arg words]
+    std::vector<uint32_t> fifo_batch_;  // entries popped by one fifo_pop_entries
+    std::vector<DpiFunc*> staged_funcs_;  // completions awaiting post_completions
     uint64_t call_count_ = 0;
     uint64_t error_count_ = 0;
     Context* current_ctx_ = nullptr;
+    // Set by worker callbacks, cleared by apply_worker_control
+    std::atomic<bool> finish_requested_{false};
+    std::atomic<int> finish_code_{0};
+    std::atomic<bool> stop_requested_{false};
     DpiMode mode_ = DpiMode::Polling;
+    std::chrono::microseconds spin_budget_{kDpiDefaultSpinUs};
+    std::chrono::steady_clock::time_point last_work_{};
+    std::chrono::steady_clock::time_point poll_time_{};  // start of the last dpi_poll
+    DpiIdleStats idle_stats_;
+    uint32_t wake_bits_ = irq_src::All;   // irq_src bits of the last wakeup, for the next round
+    uint32_t round_wake_ = irq_src::All;  // wake_bits_ as used by the last round
 };
 
 // Global DPI service instance (for VPI compatibility)
 DpiService& global_dpi_service();
 
+// Service that last serviced calls on this thread, or the global one.
+// VPI calls made from a DPI callback use it, so each of several services
+// (one per board) finds its own Context.
+DpiService& current_dpi_service();
+
 } // namespace loom
 
 #endif // __cplusplus
@@ -0,0 +1,118 @@
+// SPDX-License-Identifier: Apache-2.0
+// Loom Record File Implementation
+
+#include "loom_record_file.h"
+#include "loom_log.h"
+
+#include <cerrno>
+#include <cstring>
+
+namespace loom {
+
+static Logger logger = make_logger("dpi");
+
+namespace {
+
+constexpr size_t kFileHeader = 16;     // magic, version, reserved
+constexpr size_t kWriteBuffer = 1 << 20;
+
+} // namespace
+
+// ============================================================================
+// Writer
+// ============================================================================
+
+Result<void> RecordFileWriter::open(const std::string& path, const RecordFormat& format) {
+    close();
+    path_ = path;
+    name_ = format.name;
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) {
+        logger.error("Cannot open %s %s: %s", name_, path.c_str(), std::strerror(errno));
+        return Error::InvalidArg;
+    }
+    buf_.resize(kWriteBuffer);
+    std::setvbuf(file_, buf_.data(), _IOFBF, buf_.size());
+
+    uint32_t header[2] = {format.version, 0};
+    std::fwrite(format.magic, 1, sizeof(format.magic), file_);
+    std::fwrite(header, 1, sizeof(header), file_);
+    n_records_ = 0;
+    return {};
+}
+
+RecordFileWriter::~RecordFileWriter() {
+    close();
+}
+
+void RecordFileWriter::append_raw(const void* h, size_t size, std::span<const uint32_t> a,
+                                  std::span<const uint32_t> b) {
+    if (!file_) return;
+    std::fwrite(h, 1, size, file_);
+    std::fwrite(a.data(), sizeof(uint32_t), a.size(), file_);
+    std::fwrite(b.data(), sizeof(uint32_t), b.size(), file_);
+    n_records_++;
+}
+
+void RecordFileWriter::flush() {
+    if (file_) std::fflush(file_);
+}
+
+Result<void> RecordFileWriter::close() {
+    if (!file_) return {};
+    bool ok = std::fflush(file_) == 0;
+    ok = std::fclose(file_) == 0 && ok;
+    file_ = nullptr;
+    if (!ok) {
+        logger.error("Write to %s %s failed", name_, path_.c_str());
+        return Error::InvalidArg;
+    }
+    return {};
+}
+
+// ============================================================================
+// Reader
+// ============================================================================
+
+Result<void> RecordFileReader::open(const std::string& path, const RecordFormat& format) {
+    path_ = path;
+    file_ = std::fopen(path.c_str(), "rb");
+    if (!file_) {
+        logger.error("Cannot open %s %s: %s", format.name, path.c_str(), std::strerror(errno));
+        return Error::InvalidArg;
+    }
+
+    char header[kFileHeader];
+    uint32_t version = 0;
+    if (std::fread(header, 1, kFileHeader, file_) != kFileHeader ||
+        std::memcmp(header, format.magic, sizeof(format.magic)) != 0) {
+        logger.error("%s is not a %s", path.c_str(), format.name);
+        return Error::Protocol;
+    }
+    std::memcpy(&version, header + sizeof(format.magic), sizeof(version));
+    if (version != format.version) {
+        logger.error("%s %s has version %u, expected %u", format.name, path.c_str(), version,
+                     format.version);
+        return Error::NotSupported;
+    }
+    return {};
+}
+
+RecordFileReader::~RecordFileReader() {
+    if (file_) std::fclose(file_);
+}
+
+bool RecordFileReader::read(void* p, size_t size) {
+    partial_ = false;
+    return std::fread(p, 1, size, file_) == size;
+}
+
+bool RecordFileReader::rewind(long pos) {
+    // Rewind to the record start: a writer may still complete it
+    partial_ = std::ftell(file_) != pos;
+    std::clearerr(file_);
+    std::fseek(file_, pos, SEEK_SET);
+    return false;
+}
+
+} // namespace loom
@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: Apache-2.0
+// Loom Record File - container shared by the binary DPI logs
+//
+// The DPI call log (loom_dpi_log.h) and the display log
+// (loom_display_log.h) are both a file header followed by records of a
+// fixed-size header and u32 words. This file owns that container; each log
+// defines only its magic and its record header.
+//
+// Layout (little-endian):
+//
+//   char magic[8]
+//   u32  version
+//   u32  reserved
+//   then per record: the log's header struct, then header.n_words() u32s
+
+#pragma once
+
+#include "loom.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace loom {
+
+struct RecordFormat {
+    char magic[8];
+    uint32_t version;
+    const char* name;      // for messages, e.g. "DPI log"
+};
+
+// Arg words past the last nonzero one, which record writers drop: unused
+// arg registers read as zero, so this keeps records short
+inline size_t trimmed_size(std::span<const uint32_t> words) {
+    size_t n = words.size();
+    while (n > 0 && words[n - 1] == 0) n--;
+    return n;
+}
+
+class RecordFileWriter {
+public:
+    RecordFileWriter() = default;
+    ~RecordFileWriter();
+
+    RecordFileWriter(const RecordFileWriter&) = delete;
+    RecordFileWriter& operator=(const RecordFileWriter&) = delete;
+
+    // Create `path` and write the file header
+    Result<void> open(const std::string& path, const RecordFormat& format);
+
+    bool is_open() const { return file_ != nullptr; }
+    const std::string& path() const { return path_; }
+    uint64_t n_records() const { return n_records_; }
+
+    template <typename Header>
+    void append(const Header& h, std::span<const uint32_t> a, std::span<const uint32_t> b = {}) {
+        append_raw(&h, sizeof(h), a, b);
+    }
+    // Push buffered records to the file so a reader can see them
+    void flush();
+    Result<void> close();
+
+private:
+    void append_raw(const void* h, size_t size, std::span<const uint32_t> a,
+                    std::span<const uint32_t> b);
+
+    std::string path_;
+    const char* name_ = "";
+    FILE* file_ = nullptr;
+    std::vector<char> buf_;    // stdio buffer
+    uint64_t n_records_ = 0;
+};
+
+// Sequential reader. Records are read one at a time, so files of any size
+// stream through a fixed buffer, and a file that is still being written
+// can be followed: next() returns false at a partial record and picks it
+// up on a later call once the writer has completed it.
+class RecordFileReader {
+public:
+    RecordFileReader() = default;
+    ~RecordFileReader();
+
+    RecordFileReader(const RecordFileReader&) = delete;
+    RecordFileReader& operator=(const RecordFileReader&) = delete;
+
+    // Open `path` and check its magic and version
+    Result<void> open(const std::string& path, const RecordFormat& format);
+
+    const std::string& path() const { return path_; }
+
+    // Next record: its header and h.n_words() words; false at the end
+    template <typename Header>
+    bool next(Header& h, std::vector<uint32_t>& words) {
+        long pos = std::ftell(file_);
+        if (!read(&h, sizeof(h))) return rewind(pos);
+        words.resize(h.n_words());
+        if (!read(words.data(), words.size() * sizeof(uint32_t))) return rewind(pos);
+        return true;
+    }
+    // Whether the last next() stopped inside a record
+    bool partial() const { return partial_; }
+
+private:
+    bool read(void* p, size_t size);
+    bool rewind(long pos);
+
+    std::string path_;
+    FILE* file_ = nullptr;
+    bool partial_ = false;
+};
+
+} // namespace loom
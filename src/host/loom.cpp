@@ -4,10 +4,15 @@
 #include "loom.h"
 #include "loom_log.h"
 
+#include <algorithm>
+#include <bit>
 #include <cerrno>
 #include <chrono>
 #include <cstdio>
 #include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <vector>
 
@@ -15,12 +20,135 @@ namespace loom {
 
 static Logger logger = make_logger("loom");
 
+// ============================================================================
+// Transport Default Batch Operations
+// ============================================================================
+
+Result<void> Transport::read_block(uint32_t addr, std::span<uint32_t> data) {
+    for (size_t i = 0; i < data.size(); i++) {
+        auto val = read32(addr + static_cast<uint32_t>(i * 4));
+        if (!val.ok()) return val.error();
+        data[i] = val.value();
+    }
+    return {};
+}
+
+Result<void> Transport::write_block(uint32_t addr, std::span<const uint32_t> data) {
+    for (size_t i = 0; i < data.size(); i++) {
+        auto rc = write32(addr + static_cast<uint32_t>(i * 4), data[i]);
+        if (!rc.ok()) return rc;
+    }
+    return {};
+}
+
+Result<void> Transport::read_batch(std::span<const uint32_t> addrs, std::span<uint32_t> data) {
+    if (data.size() < addrs.size()) return Error::InvalidArg;
+    for (size_t i = 0; i < addrs.size(); i++) {
+        auto val = read32(addrs[i]);
+        if (!val.ok()) return val.error();
+        data[i] = val.value();
+    }
+    return {};
+}
+
+Result<void> Transport::write_batch(std::span<const RegWrite> writes) {
+    for (const auto& w : writes) {
+        auto rc = write32(w.addr, w.data);
+        if (!rc.ok()) return rc;
+    }
+    return {};
+}
+
+uint64_t TransportStats::latency_quantile_ns(double q) const {
+    uint64_t total = 0;
+    for (auto n : latency_hist) total += n;
+    if (total == 0) return 0;
+    auto target = static_cast<uint64_t>(q * static_cast<double>(total - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < latency_hist.size(); i++) {
+        seen += latency_hist[i];
+        if (seen >= target) return uint64_t{2} << i;
+    }
+    return uint64_t{1} << latency_hist.size();
+}
+
+namespace {
+
+// Forwards to the real transport and updates the Context's counters.
+// Two clock reads per call; negligible next to any transport round trip.
+class CountingTransport final : public Transport {
+public:
+    CountingTransport(std::unique_ptr<Transport> inner, TransportStats& stats)
+        : inner_(std::move(inner)), stats_(stats) {}
+
+    Result<void> connect(std::string_view target) override { return inner_->connect(target); }
+    void disconnect() override { inner_->disconnect(); }
+
+    Result<uint32_t> read32(uint32_t addr) override {
+        Timer t(*this, stats_.read_ops, stats_.read_bytes, 4);
+        return inner_->read32(addr);
+    }
+    Result<void> write32(uint32_t addr, uint32_t data) override {
+        Timer t(*this, stats_.write_ops, stats_.write_bytes, 4);
+        return inner_->write32(addr, data);
+    }
+    Result<void> read_block(uint32_t addr, std::span<uint32_t> data) override {
+        Timer t(*this, stats_.read_ops, stats_.read_bytes, data.size_bytes());
+        return inner_->read_block(addr, data);
+    }
+    Result<void> write_block(uint32_t addr, std::span<const uint32_t> data) override {
+        Timer t(*this, stats_.write_ops, stats_.write_bytes, data.size_bytes());
+        return inner_->write_block(addr, data);
+    }
+    Result<void> read_batch(std::span<const uint32_t> addrs, std::span<uint32_t> data) override {
+        Timer t(*this, stats_.read_ops, stats_.read_bytes, addrs.size_bytes());
+        return inner_->read_batch(addrs, data);
+    }
+    Result<void> write_batch(std::span<const RegWrite> writes) override {
+        Timer t(*this, stats_.write_ops, stats_.write_bytes, writes.size() * 4);
+        return inner_->write_batch(writes);
+    }
+
+    Result<uint32_t> wait_irq(int timeout_ms) override {
+        stats_.irq_waits++;
+        return inner_->wait_irq(timeout_ms);
+    }
+    bool has_irq_support() const override { return inner_->has_irq_support(); }
+    bool is_connected() const override { return inner_->is_connected(); }
+
+private:
+    struct Timer {
+        Timer(CountingTransport& tr, uint64_t& ops, uint64_t& bytes, size_t n_bytes)
+            : stats(tr.stats_), start(std::chrono::steady_clock::now()) {
+            ops++;
+            bytes += n_bytes;
+        }
+        ~Timer() {
+            auto ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count());
+            stats.busy_ns += ns;
+            size_t bucket = ns > 1 ? static_cast<size_t>(std::bit_width(ns) - 1) : 0;
+            stats.latency_hist[std::min(bucket, stats.latency_hist.size() - 1)]++;
+        }
+        TransportStats& stats;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    std::unique_ptr<Transport> inner_;
+    TransportStats& stats_;
+};
+
+} // namespace
+
 // ============================================================================
 // Context Implementation
 // ============================================================================
 
 Context::Context(std::unique_ptr<Transport> transport)
-    : transport_(std::move(transport)) {}
+    : transport_stats_(std::make_unique<TransportStats>()) {
+    if (transport)
+        transport_ = std::make_unique<CountingTransport>(std::move(transport), *transport_stats_);
+}
 
 Context::~Context() {
     disconnect();
@@ -76,6 +204,8 @@ Result<void> Context::connect(std::string_view target, uint32_t freq_mhz) {
              version_string(shell_version_).c_str(),
              design_hash_hex().c_str(),
              n_dpi_funcs_, scan_chain_length_, n_memories_, fifo_entry_words_);
+    if (n_instances_ > 1)
+        logger.info("Driving instance %u of %u", instance_, n_instances_);
 
     return {};
 }
@@ -84,6 +214,12 @@ Result<void> Context::probe_rm() {
     auto val = read32(addr::EmuCtrl + reg::NDpiFuncs);
     if (!val.ok()) return val.error();
     n_dpi_funcs_ = val.value();
+    // Function IDs are 8 bits wide in hardware; more would alias
+    if (n_dpi_funcs_ > reg::DpiMaxFuncs) {
+        logger.error("Design has %u DPI functions; the DPI bridge supports %u",
+                     n_dpi_funcs_, reg::DpiMaxFuncs);
+        return Error::NotSupported;
+    }
 
     val = read32(addr::EmuCtrl + reg::MaxDpiArgs);
     if (!val.ok()) return val.error();
@@ -94,14 +230,91 @@ Result<void> Context::probe_rm() {
     if (!val.ok()) return val.error();
     scan_chain_length_ = val.value();
 
+    val = read32(addr::EmuCtrl + reg::NScanChains);
+    if (!val.ok()) return val.error();
+    n_scan_chains_ = std::max(1u, val.value());
+
+    // Older scan controllers answer the reserved SCAN_CHAINS slot with 0xDEADBEEF
+    val = read32(addr::ScanCtrl + reg::ScanChains);
+    if (!val.ok()) return val.error();
+    scan_stream_only_ = val.value() != 0xDEADBEEF && (val.value() & (1u << 31));
+    scan_has_reset_rom_ = val.value() != 0xDEADBEEF && (val.value() & (1u << 30));
+
     val = read32(addr::EmuCtrl + reg::ShellVersion);
     if (!val.ok()) return val.error();
     shell_version_ = val.value();
 
+    // Older emu controllers answer INSTANCE with 0xDEADBEEF
+    val = read32(addr::EmuCtrl + reg::Instance);
+    if (!val.ok()) return val.error();
+    instance_ = 0;
+    n_instances_ = 1;
+    if ((val.value() >> 16) == 0 && ((val.value() >> 8) & 0xFF) > 0) {
+        instance_ = val.value() & 0xFF;
+        n_instances_ = (val.value() >> 8) & 0xFF;
+    }
+
     val = read32(addr::EmuCtrl + reg::NMemories);
     if (!val.ok()) return val.error();
     n_memories_ = val.value();
 
+    // Older mem controllers answer the MEM_DIRTY_* slots with 0xDEADBEEF.
+    // A newly probed design starts a new dirty epoch.
+    mem_dirty_epoch_++;
+    mem_page_bytes_ = 0;
+    mem_page_count_ = 0;
+    if (n_memories_ > 0) {
+        uint32_t addrs[] = {addr::MemCtrl + reg::MemDirtyPage, addr::MemCtrl + reg::MemDirtyCount};
+        uint32_t vals[2] = {};
+        auto rc = read_batch(addrs, vals);
+        if (!rc.ok()) return rc;
+        if (vals[0] != 0xDEADBEEF && vals[0] != 0 && vals[1] != 0) {
+            mem_page_bytes_ = vals[0];
+            mem_page_count_ = vals[1];
+        }
+    }
+
+    // ... and MEM_CAPS likewise
+    mem_bulk_write_ = false;
+    if (n_memories_ > 0) {
+        val = read32(addr::MemCtrl + reg::MemCaps);
+        if (!val.ok()) return val.error();
+        mem_bulk_write_ = val.value() != 0xDEADBEEF && (val.value() & 0x3) == 0x3;
+    }
+
+    // Older emu controllers answer TRACE_BITS with 0xDEADBEEF
+    trace_bits_ = 0;
+    trace_depth_ = 0;
+    trace_entry_words_ = 0;
+    val = read32(addr::EmuCtrl + reg::TraceBits);
+    if (!val.ok()) return val.error();
+    if (val.value() != 0xDEADBEEF && val.value() != 0) {
+        uint32_t addrs[] = {addr::TraceCtrl + reg::TraceDepth, addr::TraceCtrl + reg::TraceEntryWords};
+        uint32_t vals[2] = {};
+        auto rc = read_batch(addrs, vals);
+        if (!rc.ok()) return rc;
+        trace_bits_ = val.value();
+        trace_depth_ = vals[0];
+        trace_entry_words_ = vals[1];
+    }
+
+    // ... and PERF_CTRL likewise
+    val = read32(addr::EmuCtrl + reg::PerfCtrl);
+    if (!val.ok()) return val.error();
+    emu_perf_ = val.value() != 0xDEADBEEF && (val.value() & 0x1);
+
+    // ... and WATCH_BITS likewise
+    watch_bits_ = 0;
+    n_triggers_ = 0;
+    val = read32(addr::EmuCtrl + reg::WatchBits);
+    if (!val.ok()) return val.error();
+    if (val.value() != 0xDEADBEEF && val.value() != 0) {
+        auto ctrl = read32(addr::EmuCtrl + reg::TrigCtrl);
+        if (!ctrl.ok()) return ctrl.error();
+        watch_bits_ = val.value();
+        n_triggers_ = ctrl.value() >> 24;
+    }
+
     // Read DPI FIFO entry words (0 if no FIFO present)
     // CONTROL register at func_idx=1022: {entry_words[31:16], threshold[15:0]}
     // When no FIFO is present, regfile returns 0xDEAD_BEEF for unknown addresses.
@@ -112,15 +325,28 @@ Result<void> Context::probe_rm() {
     } else {
         fifo_entry_words_ = 0;  // No FIFO or read failed
     }
+    // STATUS bit 2 advertises the stream window; older regfiles leave it 0
+    fifo_stream_ = false;
+    if (fifo_entry_words_ > 0) {
+        val = read32(addr::DpiRegfile + reg::DpiFifoStatus);
+        fifo_stream_ = val.ok() && val.value() != 0xDEADBEEF &&
+                       (val.value() & status::FifoStream) != 0;
+    }
 
-    // Read 8-word design hash
-    for (int i = 0; i < 8; i++) {
-        val = read32(addr::EmuCtrl + reg::DesignHash0 + i * 4);
-        if (!val.ok()) return val.error();
-        design_hash_[i] = val.value();
+    // Per-function STATUS bit 3 advertises DONE_MASK writes; older
+    // regfiles leave it 0 and would silently ignore them
+    dpi_done_mask_ = false;
+    if (n_dpi_funcs_ > 0) {
+        val = read32(addr::DpiRegfile + reg::DpiStatus);
+        dpi_done_mask_ = val.ok() && val.value() != 0xDEADBEEF &&
+                         (val.value() & status::DpiDoneMaskCap) != 0;
     }
+    dpi_staged_.clear();
+    dpi_staged_mask_.assign(reg::DpiPendingMaxWords, 0);
+    dpi_staged_count_ = 0;
 
-    return {};
+    // Read 8-word design hash
+    return read_block(addr::EmuCtrl + reg::DesignHash0, design_hash_);
 }
 
 void Context::disconnect() {
@@ -236,6 +462,7 @@ Result<void> Context::configure_clock(uint32_t freq_mhz) {
         auto locked = is_clock_locked();
         if (locked.ok() && locked.value()) {
             logger.info("Clock locked at %u MHz", actual_freq);
+            clock_mhz_ = actual_freq;
             return {};
         }
         usleep(1000);  // 1ms
@@ -263,6 +490,34 @@ Result<void> Context::write32(uint32_t addr, uint32_t data) {
     return transport_->write32(addr, data);
 }
 
+Result<void> Context::read_block(uint32_t addr, std::span<uint32_t> data) {
+    if (!transport_) {
+        return Error::InvalidArg;
+    }
+    return transport_->read_block(addr, data);
+}
+
+Result<void> Context::write_block(uint32_t addr, std::span<const uint32_t> data) {
+    if (!transport_) {
+        return Error::InvalidArg;
+    }
+    return transport_->write_block(addr, data);
+}
+
+Result<void> Context::read_batch(std::span<const uint32_t> addrs, std::span<uint32_t> data) {
+    if (!transport_) {
+        return Error::InvalidArg;
+    }
+    return transport_->read_batch(addrs, data);
+}
+
+Result<void> Context::write_batch(std::span<const RegWrite> writes) {
+    if (!transport_) {
+        return Error::InvalidArg;
+    }
+    return transport_->write_batch(writes);
+}
+
 // ============================================================================
 // Interrupt Support
 // ============================================================================
@@ -271,9 +526,82 @@ Result<uint32_t> Context::wait_irq() {
     if (!transport_) {
         return Error::InvalidArg;
     }
+    if (irq_stash_) {
+        uint32_t bits = irq_stash_;
+        irq_stash_ = 0;
+        return bits;
+    }
     return transport_->wait_irq();
 }
 
+// Scan and memory operations usually finish within a few register round
+// trips, so the status register is first polled back-to-back. Longer
+// operations (full scan chains, slow clocks) then either sleep on the
+// completion IRQ or poll with a sleep that doubles up to 1 ms. IRQ waits
+// are bounded by the deadline and re-check the status at least every
+// kMaxIrqWaitMs, so a lost interrupt costs latency, not the whole timeout;
+// a transport that cannot bound its wait falls back to polling.
+Result<void> Context::wait_status(uint32_t status_addr, uint32_t done_mask,
+                                  uint32_t irq_bit, int timeout_ms) {
+    constexpr int kSpinPolls = 64;
+    constexpr int kMaxSleepUs = 1000;
+    constexpr int kMaxIrqWaitMs = 100;
+
+    for (int i = 0; i < kSpinPolls; i++) {
+        auto st = read32(status_addr);
+        if (!st.ok()) return st.error();
+        if (st.value() & done_mask) return {};
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+
+    if (completion_irq_ && has_irq_support()) {
+        // done is a level, so enabling after the command still raises the
+        // IRQ if the operation already finished
+        auto en = read32(addr::EmuCtrl + reg::IrqEnable);
+        if (!en.ok()) return en.error();
+        auto rc = write32(addr::EmuCtrl + reg::IrqEnable, en.value() | irq_bit);
+        if (!rc.ok()) return rc;
+
+        Result<void> result = Error::Timeout;
+        bool poll_instead = false;
+        while (true) {
+            auto st = read32(status_addr);
+            if (!st.ok()) { result = st.error(); break; }
+            if (st.value() & done_mask) { result = {}; break; }
+
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            if (left <= 0) break;
+            auto irq = transport_->wait_irq(static_cast<int>(std::min<decltype(left)>(left, kMaxIrqWaitMs)));
+            if (!irq.ok()) {
+                if (irq.error() == Error::Interrupted || irq.error() == Error::Timeout) continue;
+                if (irq.error() == Error::NotSupported) { poll_instead = true; break; }
+                result = irq.error();
+                break;
+            }
+            irq_stash_ |= irq.value();
+        }
+
+        auto restore = write32(addr::EmuCtrl + reg::IrqEnable, en.value());
+        if (!poll_instead) {
+            if (result.ok() && !restore.ok()) return restore;
+            return result;
+        }
+    }
+
+    int sleep_us = 1;
+    while (std::chrono::steady_clock::now() < deadline) {
+        auto st = read32(status_addr);
+        if (!st.ok()) return st.error();
+        if (st.value() & done_mask) return {};
+        usleep(sleep_us);
+        sleep_us = std::min(sleep_us * 2, kMaxSleepUs);
+    }
+
+    return Error::Timeout;
+}
+
 bool Context::has_irq_support() const {
     return transport_ && transport_->has_irq_support();
 }
@@ -336,6 +664,52 @@ Result<uint64_t> Context::get_time() {
     return (static_cast<uint64_t>(hi.value()) << 32) | lo.value();
 }
 
+Result<EmuPerf> Context::read_emu_perf() {
+    if (!emu_perf_) return Error::NotSupported;
+
+    // LO before HI: each LO read latches its high word
+    static constexpr uint32_t kRegs[] = {
+        reg::PerfRunLo, reg::PerfRunHi, reg::PerfEnLo, reg::PerfEnHi,
+        reg::PerfDpiLo, reg::PerfDpiHi, reg::PerfFifoLo, reg::PerfFifoHi,
+    };
+    std::vector<uint32_t> addrs;
+    for (uint32_t r : kRegs) addrs.push_back(addr::EmuCtrl + r);
+    std::vector<uint32_t> vals(addrs.size());
+    auto rc = read_batch(addrs, vals);
+    if (!rc.ok()) return rc.error();
+
+    auto u64 = [&](size_t i) { return (static_cast<uint64_t>(vals[i + 1]) << 32) | vals[i]; };
+    EmuPerf perf;
+    perf.run_cycles = u64(0);
+    perf.enabled_cycles = u64(2);
+    perf.dpi_stall_cycles = u64(4);
+    perf.fifo_stall_cycles = u64(6);
+
+    // Per-function counters: PERF_FUNC_HI reads step PERF_FUNC_SEL
+    if (n_dpi_funcs_ > 0) {
+        rc = write32(addr::EmuCtrl + reg::PerfFuncSel, 0);
+        if (!rc.ok()) return rc.error();
+        addrs.clear();
+        for (uint32_t i = 0; i < n_dpi_funcs_; i++) {
+            addrs.push_back(addr::EmuCtrl + reg::PerfFuncLo);
+            addrs.push_back(addr::EmuCtrl + reg::PerfFuncHi);
+        }
+        vals.assign(addrs.size(), 0);
+        rc = read_batch(addrs, vals);
+        if (!rc.ok()) return rc.error();
+        perf.func_stall_cycles.resize(n_dpi_funcs_);
+        for (uint32_t i = 0; i < n_dpi_funcs_; i++) {
+            perf.func_stall_cycles[i] = u64(2 * i);
+        }
+    }
+    return perf;
+}
+
+Result<void> Context::clear_emu_perf() {
+    if (!emu_perf_) return Error::NotSupported;
+    return write32(addr::EmuCtrl + reg::PerfCtrl, 0x1);
+}
+
 Result<void> Context::set_time_compare(uint64_t value) {
     auto rc = write32(addr::EmuCtrl + reg::TimeCmpLo,
                       static_cast<uint32_t>(value & 0xFFFFFFFF));
@@ -355,6 +729,16 @@ Result<uint64_t> Context::get_time_compare() {
     return (static_cast<uint64_t>(hi.value()) << 32) | lo.value();
 }
 
+Result<void> Context::set_counters(uint64_t cycle_count, uint64_t dut_time) {
+    const RegWrite writes[] = {
+        {addr::EmuCtrl + reg::CycleLo, static_cast<uint32_t>(cycle_count & 0xFFFFFFFF)},
+        {addr::EmuCtrl + reg::CycleHi, static_cast<uint32_t>(cycle_count >> 32)},
+        {addr::EmuCtrl + reg::TimeLo,  static_cast<uint32_t>(dut_time & 0xFFFFFFFF)},
+        {addr::EmuCtrl + reg::TimeHi,  static_cast<uint32_t>(dut_time >> 32)},
+    };
+    return write_batch(writes);
+}
+
 // ============================================================================
 // DPI Function Handling
 // ============================================================================
@@ -367,23 +751,31 @@ Result<uint32_t> Context::dpi_poll() {
     return read32(addr::DpiRegfile + reg::DpiPendingMask);
 }
 
-Result<DpiCall> Context::dpi_get_call(uint32_t func_id) {
+uint32_t Context::dpi_pending_words() const {
+    return std::min<uint32_t>((n_dpi_funcs_ + 31) / 32, reg::DpiPendingMaxWords);
+}
+
+Result<void> Context::dpi_poll(std::span<uint32_t> mask) {
+    uint32_t n_words = dpi_pending_words();
+    if (mask.size() < n_words) return Error::InvalidArg;
+    return read_block(addr::DpiRegfile + reg::DpiPendingMask, mask.first(n_words));
+}
+
+Result<void> Context::dpi_get_call(uint32_t func_id, std::span<uint32_t> args) {
     if (func_id >= n_dpi_funcs_) {
         return Error::InvalidArg;
     }
 
-    DpiCall call;
-    call.func_id = func_id;
-    call.args.resize(max_dpi_args_);
+    // Read all arguments in one burst
+    size_t n = std::min<size_t>(args.size(), max_dpi_args_);
+    return read_block(dpi_func_addr(func_id, reg::DpiArg0), args.first(n));
+}
 
-    // Read all arguments
-    for (uint32_t i = 0; i < max_dpi_args_; i++) {
-        auto arg = read32(dpi_func_addr(func_id, reg::DpiArg0 + i * 4));
-        if (!arg.ok()) return arg.error();
-        call.args[i] = arg.value();
+Result<void> Context::dpi_read_xargs(std::span<uint32_t> words) {
+    if (words.size() > reg::DpiXargMaxWords) {
+        return Error::InvalidArg;
     }
-
-    return call;
+    return read_block(addr::DpiRegfile + reg::DpiXargBase, words);
 }
 
 Result<void> Context::dpi_complete(uint32_t func_id, uint64_t result) {
@@ -391,16 +783,63 @@ Result<void> Context::dpi_complete(uint32_t func_id, uint64_t result) {
         return Error::InvalidArg;
     }
 
+    // Result words, then set_done — issued as one ordered batch
     uint32_t result_lo_offset = reg::DpiArg0 + max_dpi_args_ * 4;
-    auto rc = write32(dpi_func_addr(func_id, result_lo_offset),
-                      static_cast<uint32_t>(result & 0xFFFFFFFF));
-    if (!rc.ok()) return rc;
+    const RegWrite writes[] = {
+        {dpi_func_addr(func_id, result_lo_offset), static_cast<uint32_t>(result & 0xFFFFFFFF)},
+        {dpi_func_addr(func_id, result_lo_offset + 4), static_cast<uint32_t>(result >> 32)},
+        {dpi_func_addr(func_id, reg::DpiControl), ctrl::DpiSetDone},
+    };
+    return write_batch(writes);
+}
 
-    rc = write32(dpi_func_addr(func_id, result_lo_offset + 4),
-                 static_cast<uint32_t>(result >> 32));
-    if (!rc.ok()) return rc;
+Result<void> Context::dpi_stage_complete(uint32_t func_id, uint64_t result,
+                                         std::span<const uint32_t> out_args, bool has_result,
+                                         std::span<const uint32_t> xresult) {
+    if (func_id >= n_dpi_funcs_ || out_args.size() > max_dpi_args_ ||
+        xresult.size() > reg::DpiXargMaxWords) {
+        return Error::InvalidArg;
+    }
+
+    for (size_t i = 0; i < xresult.size(); i++)
+        dpi_staged_.push_back({addr::DpiRegfile + reg::DpiXargBase + static_cast<uint32_t>(i) * 4,
+                               xresult[i]});
+
+    for (size_t i = 0; i < out_args.size(); i++)
+        dpi_staged_.push_back({dpi_func_addr(func_id, reg::DpiArg0 + static_cast<uint32_t>(i) * 4),
+                               out_args[i]});
+    if (has_result) {
+        uint32_t result_lo_offset = reg::DpiArg0 + max_dpi_args_ * 4;
+        dpi_staged_.push_back({dpi_func_addr(func_id, result_lo_offset),
+                               static_cast<uint32_t>(result & 0xFFFFFFFF)});
+        dpi_staged_.push_back({dpi_func_addr(func_id, result_lo_offset + 4),
+                               static_cast<uint32_t>(result >> 32)});
+    }
 
-    return write32(dpi_func_addr(func_id, reg::DpiControl), ctrl::DpiSetDone);
+    // The mask bank covers the first 512 functions
+    if (dpi_done_mask_ && func_id / 32 < dpi_staged_mask_.size())
+        dpi_staged_mask_[func_id / 32] |= 1u << (func_id % 32);
+    else
+        dpi_staged_.push_back({dpi_func_addr(func_id, reg::DpiControl), ctrl::DpiSetDone});
+    dpi_staged_count_++;
+    return {};
+}
+
+Result<uint32_t> Context::dpi_flush_completions() {
+    if (dpi_staged_count_ == 0) return 0u;
+
+    for (size_t k = 0; k < dpi_staged_mask_.size(); k++) {
+        if (dpi_staged_mask_[k] == 0) continue;
+        dpi_staged_.push_back({addr::DpiRegfile + reg::DpiDoneMask + static_cast<uint32_t>(k) * 4,
+                               dpi_staged_mask_[k]});
+        dpi_staged_mask_[k] = 0;
+    }
+    uint32_t n = dpi_staged_count_;
+    auto rc = write_batch(dpi_staged_);
+    dpi_staged_.clear();
+    dpi_staged_count_ = 0;
+    if (!rc.ok()) return rc.error();
+    return n;
 }
 
 Result<void> Context::dpi_write_arg(uint32_t func_id, int arg_idx, uint32_t value) {
@@ -410,6 +849,13 @@ Result<void> Context::dpi_write_arg(uint32_t func_id, int arg_idx, uint32_t valu
     return write32(dpi_func_addr(func_id, reg::DpiArg0 + arg_idx * 4), value);
 }
 
+Result<void> Context::dpi_write_args(uint32_t func_id, std::span<const uint32_t> values) {
+    if (func_id >= n_dpi_funcs_ || values.size() > max_dpi_args_) {
+        return Error::InvalidArg;
+    }
+    return write_block(dpi_func_addr(func_id, reg::DpiArg0), values);
+}
+
 Result<void> Context::dpi_error(uint32_t func_id) {
     if (func_id >= n_dpi_funcs_) {
         return Error::InvalidArg;
@@ -433,23 +879,54 @@ Result<bool> Context::fifo_is_empty() {
     return (val.value() & 0x1) != 0;  // bit 0 = empty
 }
 
-Result<std::vector<uint32_t>> Context::fifo_pop_entry() {
+Result<void> Context::fifo_pop_entry(std::span<uint32_t> entry) {
     if (fifo_entry_words_ == 0)
         return Error::NotSupported;
+    if (entry.size() < fifo_entry_words_)
+        return Error::InvalidArg;
 
-    std::vector<uint32_t> data(fifo_entry_words_);
     // Read head entry data words (at ARG0 + k*4)
-    for (uint32_t k = 0; k < fifo_entry_words_; k++) {
-        auto val = read32(addr::DpiRegfile + reg::DpiFifoData + k * 4);
-        if (!val.ok()) return val.error();
-        data[k] = val.value();
-    }
+    auto rc = read_block(addr::DpiRegfile + reg::DpiFifoData, entry.first(fifo_entry_words_));
+    if (!rc.ok()) return rc;
 
     // Pop: write bit0 to CONTROL register
-    auto rc = write32(addr::DpiRegfile + reg::DpiFifoControl, 0x1);
-    if (!rc.ok()) return rc.error();
+    return write32(addr::DpiRegfile + reg::DpiFifoControl, 0x1);
+}
 
-    return data;
+Result<uint32_t> Context::fifo_pop_entries(std::span<uint32_t> out, uint32_t max_entries) {
+    if (fifo_entry_words_ == 0)
+        return Error::NotSupported;
+    max_entries = std::min<uint32_t>(max_entries, out.size() / fifo_entry_words_);
+    if (max_entries == 0)
+        return Error::InvalidArg;
+
+    auto st = fifo_status();
+    if (!st.ok()) return st.error();
+    if (st.value() & status::FifoEmpty) return 0u;
+    uint32_t n = std::min<uint32_t>(st.value() >> 16, max_entries);
+
+    if (!fifo_stream_) {
+        for (uint32_t i = 0; i < n; i++) {
+            auto rc = fifo_pop_entry(out.subspan(i * fifo_entry_words_, fifo_entry_words_));
+            if (!rc.ok()) return rc.error();
+        }
+        return n;
+    }
+
+    // Only the level snapshot above may be drained: entries are never
+    // removed behind our back, so every read of these words hits data.
+    // The window address cycles so a batch never runs off its 16 words.
+    uint32_t words = n * fifo_entry_words_;
+    if (fifo_addrs_.size() < words) {
+        size_t old = fifo_addrs_.size();
+        fifo_addrs_.resize(words);
+        for (size_t i = old; i < words; i++)
+            fifo_addrs_[i] = addr::DpiRegfile + reg::DpiFifoStream +
+                             static_cast<uint32_t>(i % reg::DpiFifoStreamWords) * 4;
+    }
+    auto rc = read_batch(std::span<const uint32_t>(fifo_addrs_).first(words), out.first(words));
+    if (!rc.ok()) return rc.error();
+    return n;
 }
 
 Result<void> Context::fifo_set_threshold(uint32_t level) {
@@ -465,22 +942,8 @@ Result<void> Context::scan_clear_done() {
 }
 
 Result<void> Context::scan_wait_done(int timeout_ms) {
-    int elapsed = 0;
-    const int poll_interval = 10;  // ms
-
-    while (elapsed < timeout_ms) {
-        auto status_result = read32(addr::ScanCtrl + reg::ScanStatus);
-        if (!status_result.ok()) return status_result.error();
-
-        if (status_result.value() & status::ScanDone) {
-            return {};
-        }
-
-        usleep(poll_interval * 1000);  // Convert ms to microseconds
-        elapsed += poll_interval;
-    }
-
-    return Error::Timeout;
+    return wait_status(addr::ScanCtrl + reg::ScanStatus, status::ScanDone,
+                       status::IrqScanDone, timeout_ms);
 }
 
 Result<void> Context::scan_capture(int timeout_ms) {
@@ -507,21 +970,139 @@ Result<std::vector<uint32_t>> Context::scan_read_data() {
     uint32_t n_words = (scan_chain_length_ + 31) / 32;
     std::vector<uint32_t> data(n_words);
 
-    for (uint32_t i = 0; i < n_words; i++) {
-        auto val = read32(addr::ScanCtrl + reg::ScanDataBase + (i * 4));
-        if (!val.ok()) return val.error();
-        data[i] = val.value();
-    }
+    auto rc = read_block(addr::ScanCtrl + reg::ScanDataBase, data);
+    if (!rc.ok()) return rc.error();
 
     return data;
 }
 
 Result<void> Context::scan_write_data(const std::vector<uint32_t>& data) {
-    for (size_t i = 0; i < data.size(); i++) {
-        auto rc = write32(addr::ScanCtrl + reg::ScanDataBase + (i * 4), data[i]);
+    return write_block(addr::ScanCtrl + reg::ScanDataBase, data);
+}
+
+uint32_t Context::scan_chain_bits() const {
+    // Must match scan_insert: one chain, or an even split in whole words
+    if (n_scan_chains_ <= 1) return scan_chain_length_;
+    uint32_t per_chain = (scan_chain_length_ + n_scan_chains_ - 1) / n_scan_chains_;
+    return (per_chain + 31) / 32 * 32;
+}
+
+Result<void> Context::scan_capture_stream(const ScanCaptureFn& sink, int timeout_ms) {
+    const uint32_t n_chains = n_scan_chains_;
+    const uint32_t n_entries = scan_words_per_chain();
+
+    auto rc = scan_clear_done();
+    if (!rc.ok()) return rc;
+    rc = write32(addr::ScanCtrl + reg::ScanControl, cmd::ScanCaptureStream);
+    if (!rc.ok()) return rc;
+
+    // Window reads stall until the chains have shifted out the next entry,
+    // so each read_block is one burst over as many entries as fit
+    const uint32_t batch = std::max(1u, reg::ScanStreamWords / n_chains);
+    std::vector<uint32_t> buf(std::min(batch, n_entries) * n_chains);
+    uint32_t word_idx = n_entries;
+    while (word_idx > 0) {
+        uint32_t n = std::min(batch, word_idx);
+        std::span<uint32_t> chunk(buf.data(), n * n_chains);
+        rc = read_block(addr::ScanCtrl + reg::ScanStreamBase, chunk);
         if (!rc.ok()) return rc;
+        for (uint32_t e = 0; e < n; e++) {
+            rc = sink(--word_idx, chunk.subspan(e * n_chains, n_chains));
+            if (!rc.ok()) return rc;
+        }
     }
-    return {};
+
+    return scan_wait_done(timeout_ms);
+}
+
+Result<void> Context::scan_restore_stream(const ScanRestoreFn& source, int timeout_ms) {
+    const uint32_t n_chains = n_scan_chains_;
+    const uint32_t n_entries = scan_words_per_chain();
+
+    auto rc = scan_clear_done();
+    if (!rc.ok()) return rc;
+    rc = write32(addr::ScanCtrl + reg::ScanControl, cmd::ScanRestoreStream);
+    if (!rc.ok()) return rc;
+
+    // Window writes stall while the FIFO is full
+    const uint32_t batch = std::max(1u, reg::ScanStreamWords / n_chains);
+    std::vector<uint32_t> buf(std::min(batch, n_entries) * n_chains);
+    uint32_t word_idx = n_entries;
+    while (word_idx > 0) {
+        uint32_t n = std::min(batch, word_idx);
+        std::span<uint32_t> chunk(buf.data(), n * n_chains);
+        for (uint32_t e = 0; e < n; e++) {
+            rc = source(--word_idx, chunk.subspan(e * n_chains, n_chains));
+            if (!rc.ok()) return rc;
+        }
+        rc = write_block(addr::ScanCtrl + reg::ScanStreamBase, chunk);
+        if (!rc.ok()) return rc;
+    }
+
+    return scan_wait_done(timeout_ms);
+}
+
+Result<std::vector<uint32_t>> Context::scan_capture_image(int timeout_ms) {
+    if (!scan_stream_only_) {
+        auto rc = scan_capture(timeout_ms);
+        if (!rc.ok()) return rc.error();
+        return scan_read_data();
+    }
+
+    const uint32_t wpc = scan_words_per_chain();
+    std::vector<uint32_t> image((scan_chain_length_ + 31) / 32);
+    auto rc = scan_capture_stream([&](uint32_t w, std::span<const uint32_t> words) -> Result<void> {
+        for (uint32_t c = 0; c < words.size(); c++) {
+            size_t i = static_cast<size_t>(c) * wpc + w;
+            if (i < image.size()) image[i] = words[c];
+        }
+        return {};
+    }, timeout_ms);
+    if (!rc.ok()) return rc.error();
+    return image;
+}
+
+Result<void> Context::scan_restore_image(std::span<const uint32_t> image, int timeout_ms) {
+    if (!scan_stream_only_) {
+        auto rc = write_block(addr::ScanCtrl + reg::ScanDataBase, image);
+        if (!rc.ok()) return rc;
+        return scan_restore(timeout_ms);
+    }
+
+    const uint32_t wpc = scan_words_per_chain();
+    return scan_restore_stream([&](uint32_t w, std::span<uint32_t> words) -> Result<void> {
+        for (uint32_t c = 0; c < words.size(); c++) {
+            size_t i = static_cast<size_t>(c) * wpc + w;
+            words[c] = i < image.size() ? image[i] : 0;
+        }
+        return {};
+    }, timeout_ms);
+}
+
+// Patch slots, STATUS clear-done and CONTROL go out as one ordered batch
+Result<void> Context::scan_reinit(std::span<const ScanPatch> patches, int timeout_ms) {
+    if (!scan_has_reset_rom_) return Error::NotSupported;
+    if (patches.size() > reg::ScanPatchSlots) return Error::InvalidArg;
+
+    std::vector<RegWrite> writes;
+    writes.reserve(reg::ScanPatchSlots * 3 + 2);
+    for (uint32_t p = 0; p < reg::ScanPatchSlots; p++) {
+        uint32_t base = addr::ScanCtrl + reg::ScanPatchBase + p * 16;
+        if (p < patches.size()) {
+            writes.push_back({base + 0x0, patches[p].word});
+            writes.push_back({base + 0x4, patches[p].value});
+            writes.push_back({base + 0x8, patches[p].mask});
+        } else {
+            writes.push_back({base + 0x8, 0});  // MASK=0 disables the slot
+        }
+    }
+    writes.push_back({addr::ScanCtrl + reg::ScanStatus, status::ScanDone});
+    writes.push_back({addr::ScanCtrl + reg::ScanControl, cmd::ScanReinit});
+
+    auto rc = write_batch(writes);
+    if (!rc.ok()) return rc;
+
+    return scan_wait_done(timeout_ms);
 }
 
 Result<bool> Context::scan_is_busy() {
@@ -534,106 +1115,235 @@ Result<bool> Context::scan_is_busy() {
 // Memory Shadow Access
 // ============================================================================
 
-Result<void> Context::mem_clear_done() {
-    return write32(addr::MemCtrl + reg::MemStatus, status::MemDone);
-}
-
 Result<void> Context::mem_wait_done(int timeout_ms) {
-    int elapsed = 0;
-    const int poll_interval = 10;  // ms
-
-    while (elapsed < timeout_ms) {
-        auto status_result = read32(addr::MemCtrl + reg::MemStatus);
-        if (!status_result.ok()) return status_result.error();
-
-        if (status_result.value() & status::MemDone) {
-            return {};
-        }
-
-        usleep(poll_interval * 1000);
-        elapsed += poll_interval;
-    }
-
-    return Error::Timeout;
+    return wait_status(addr::MemCtrl + reg::MemStatus, status::MemDone,
+                       status::IrqMemDone, timeout_ms);
 }
 
-Result<void> Context::mem_write_entry(uint32_t global_addr, const std::vector<uint32_t>& data) {
-    // Write data words
+// Issue a mem_ctrl command as one ordered batch:
+//   DATA[0..n-1] (if any), ADDR (if given), STATUS clear-done, CONTROL
+Result<void> Context::mem_issue(uint32_t command, std::optional<uint32_t> global_addr,
+                                std::span<const uint32_t> data) {
+    std::vector<RegWrite> writes;
+    writes.reserve(data.size() + 3);
     for (size_t i = 0; i < data.size(); i++) {
-        auto rc = write32(addr::MemCtrl + reg::MemDataBase + (i * 4), data[i]);
-        if (!rc.ok()) return rc;
+        writes.push_back({static_cast<uint32_t>(addr::MemCtrl + reg::MemDataBase + i * 4), data[i]});
     }
-    // Write address
-    auto rc = write32(addr::MemCtrl + reg::MemAddr, global_addr);
-    if (!rc.ok()) return rc;
+    if (global_addr) {
+        writes.push_back({addr::MemCtrl + reg::MemAddr, *global_addr});
+    }
+    writes.push_back({addr::MemCtrl + reg::MemStatus, status::MemDone});
+    writes.push_back({addr::MemCtrl + reg::MemControl, command});
 
-    // Issue write command
-    rc = mem_clear_done();
-    if (!rc.ok()) return rc;
-    rc = write32(addr::MemCtrl + reg::MemControl, cmd::MemWrite);
+    auto rc = write_batch(writes);
     if (!rc.ok()) return rc;
 
     return mem_wait_done(1000);
 }
 
+Result<void> Context::mem_write_entry(uint32_t global_addr, const std::vector<uint32_t>& data) {
+    return mem_issue(cmd::MemWrite, global_addr, data);
+}
+
 Result<std::vector<uint32_t>> Context::mem_read_entry(uint32_t global_addr, int n_data_words) {
-    // Write address
-    auto rc = write32(addr::MemCtrl + reg::MemAddr, global_addr);
+    auto rc = mem_issue(cmd::MemRead, global_addr, {});
     if (!rc.ok()) return rc.error();
 
-    // Issue read command
-    rc = mem_clear_done();
-    if (!rc.ok()) return rc.error();
-    rc = write32(addr::MemCtrl + reg::MemControl, cmd::MemRead);
+    // Read data words
+    std::vector<uint32_t> data(n_data_words);
+    rc = read_block(addr::MemCtrl + reg::MemDataBase, data);
     if (!rc.ok()) return rc.error();
 
-    rc = mem_wait_done(1000);
+    return data;
+}
+
+Result<void> Context::mem_preload_start(uint32_t global_addr, const std::vector<uint32_t>& data) {
+    return mem_issue(cmd::MemPreloadStart, global_addr, data);
+}
+
+Result<void> Context::mem_preload_next(const std::vector<uint32_t>& data) {
+    // Preload next auto-increments the address, so ADDR is not written
+    return mem_issue(cmd::MemPreloadNext, std::nullopt, data);
+}
+
+Result<std::vector<uint32_t>> Context::mem_read_range(uint32_t global_addr, uint32_t count,
+                                                      int n_data_words) {
+    if (n_data_words < 1 || n_data_words > 255) return Error::InvalidArg;
+
+    std::vector<uint32_t> data(static_cast<size_t>(count) * n_data_words);
+    if (data.empty()) return data;
+
+    // No completion wait: window reads stall until each entry is fetched
+    uint32_t command = cmd::MemReadStream | (static_cast<uint32_t>(n_data_words) << 8);
+    RegWrite writes[] = {
+        {addr::MemCtrl + reg::MemAddr, global_addr},
+        {addr::MemCtrl + reg::MemStatus, status::MemDone},
+        {addr::MemCtrl + reg::MemControl, command},
+    };
+    auto rc = write_batch(writes);
     if (!rc.ok()) return rc.error();
 
-    // Read data words
-    std::vector<uint32_t> data(n_data_words);
-    for (int i = 0; i < n_data_words; i++) {
-        auto val = read32(addr::MemCtrl + reg::MemDataBase + (i * 4));
-        if (!val.ok()) return val.error();
-        data[i] = val.value();
+    std::span<uint32_t> rest(data);
+    while (!rest.empty()) {
+        size_t n = std::min<size_t>(rest.size(), reg::MemStreamWords);
+        rc = read_block(addr::MemCtrl + reg::MemStreamBase, rest.first(n));
+        if (!rc.ok()) return rc.error();
+        rest = rest.subspan(n);
     }
 
+    // End the stream
+    rc = write32(addr::MemCtrl + reg::MemStatus, status::MemDone);
+    if (!rc.ok()) return rc.error();
+
     return data;
 }
 
-Result<void> Context::mem_preload_start(uint32_t global_addr, const std::vector<uint32_t>& data) {
-    // Write data words
-    for (size_t i = 0; i < data.size(); i++) {
-        auto rc = write32(addr::MemCtrl + reg::MemDataBase + (i * 4), data[i]);
-        if (!rc.ok()) return rc;
-    }
-    // Write start address
-    auto rc = write32(addr::MemCtrl + reg::MemAddr, global_addr);
+Result<void> Context::mem_write_range(uint32_t global_addr, std::span<const uint32_t> data,
+                                      int n_data_words) {
+    if (!mem_bulk_write_) return Error::NotSupported;
+    if (n_data_words < 1 || n_data_words > 255 || data.size() % n_data_words != 0)
+        return Error::InvalidArg;
+    if (data.empty()) return {};
+
+    uint32_t command = cmd::MemWriteStream | (static_cast<uint32_t>(n_data_words) << 8);
+    RegWrite writes[] = {
+        {addr::MemCtrl + reg::MemAddr, global_addr},
+        {addr::MemCtrl + reg::MemStatus, status::MemDone},
+        {addr::MemCtrl + reg::MemControl, command},
+    };
+    auto rc = write_batch(writes);
     if (!rc.ok()) return rc;
 
-    // Issue preload start command
-    rc = mem_clear_done();
-    if (!rc.ok()) return rc;
-    rc = write32(addr::MemCtrl + reg::MemControl, cmd::MemPreloadStart);
-    if (!rc.ok()) return rc;
+    while (!data.empty()) {
+        size_t n = std::min<size_t>(data.size(), reg::MemStreamWords);
+        rc = write_block(addr::MemCtrl + reg::MemStreamBase, data.first(n));
+        if (!rc.ok()) return rc;
+        data = data.subspan(n);
+    }
 
-    return mem_wait_done(1000);
+    // End the stream; this write waits for the last entry to land
+    return write32(addr::MemCtrl + reg::MemStatus, status::MemDone);
 }
 
-Result<void> Context::mem_preload_next(const std::vector<uint32_t>& data) {
-    // Write data words
-    for (size_t i = 0; i < data.size(); i++) {
-        auto rc = write32(addr::MemCtrl + reg::MemDataBase + (i * 4), data[i]);
+Result<void> Context::mem_fill(uint32_t global_addr, std::span<const uint32_t> value,
+                               uint32_t count) {
+    if (!mem_bulk_write_) return Error::NotSupported;
+    // Chunked so each command finishes well inside the done timeout, even
+    // on a slow simulator
+    constexpr uint32_t kMaxFill = 1u << 16;
+    while (count > 0) {
+        uint32_t n = std::min(count, kMaxFill);
+        auto rc = mem_issue(cmd::MemFill | (n << 8), global_addr, value);
         if (!rc.ok()) return rc;
+        global_addr += n * 4;
+        count -= n;
     }
+    return {};
+}
 
-    // Issue preload next command (auto-increments address)
-    auto rc = mem_clear_done();
-    if (!rc.ok()) return rc;
-    rc = write32(addr::MemCtrl + reg::MemControl, cmd::MemPreloadNext);
-    if (!rc.ok()) return rc;
+Result<std::vector<uint32_t>> Context::mem_dirty_pages() {
+    if (mem_page_bytes_ == 0) return Error::NotSupported;
+    std::vector<uint32_t> bitmap((mem_page_count_ + 31) / 32);
+    auto rc = read_block(addr::MemCtrl + reg::MemDirtyBase, bitmap);
+    if (!rc.ok()) return rc.error();
+    return bitmap;
+}
 
-    return mem_wait_done(1000);
+Result<void> Context::mem_dirty_clear() {
+    if (mem_page_bytes_ == 0) return Error::NotSupported;
+    auto rc = write32(addr::MemCtrl + reg::MemControl, cmd::MemDirtyClear);
+    if (rc.ok()) mem_dirty_epoch_++;
+    return rc;
+}
+
+// ============================================================================
+// Trace Buffer
+// ============================================================================
+
+Result<void> Context::trace_arm(const TraceConfig& config) {
+    if (trace_bits_ == 0) return Error::NotSupported;
+    if (config.trig_word >= (trace_bits_ + 31) / 32) return Error::InvalidArg;
+
+    uint32_t command = cmd::TraceArm | (config.stall ? cmd::TraceStallFull : 0);
+    RegWrite writes[] = {
+        {addr::TraceCtrl + reg::TraceTrigWord, config.trig_word},
+        {addr::TraceCtrl + reg::TraceTrigMask, config.trig_mask},
+        {addr::TraceCtrl + reg::TraceTrigValue, config.trig_value},
+        {addr::TraceCtrl + reg::TracePost, config.post},
+        {addr::TraceCtrl + reg::TraceControl, command},
+    };
+    return write_batch(writes);
+}
+
+Result<void> Context::trace_stop() {
+    if (trace_bits_ == 0) return Error::NotSupported;
+    return write32(addr::TraceCtrl + reg::TraceControl, cmd::TraceStop);
+}
+
+Result<uint32_t> Context::trace_status() {
+    if (trace_bits_ == 0) return Error::NotSupported;
+    return read32(addr::TraceCtrl + reg::TraceStatus);
+}
+
+Result<uint32_t> Context::trace_dropped() {
+    if (trace_bits_ == 0) return Error::NotSupported;
+    return read32(addr::TraceCtrl + reg::TraceDropped);
+}
+
+Result<uint32_t> Context::trace_drain(std::vector<uint32_t>& entries) {
+    if (trace_bits_ == 0) return Error::NotSupported;
+
+    // Only what LEVEL reports; entries recorded meanwhile wait for the next drain
+    auto level = read32(addr::TraceCtrl + reg::TraceLevel);
+    if (!level.ok()) return level.error();
+    uint32_t n = level.value();
+    if (n == 0) return 0u;
+
+    size_t start = entries.size();
+    entries.resize(start + static_cast<size_t>(n) * trace_entry_words_);
+    std::span<uint32_t> rest(entries.data() + start, entries.size() - start);
+    while (!rest.empty()) {
+        size_t chunk = std::min<size_t>(rest.size(), reg::TraceStreamWords);
+        auto rc = read_block(addr::TraceCtrl + reg::TraceStreamBase, rest.first(chunk));
+        if (!rc.ok()) {
+            entries.resize(start);
+            return rc.error();
+        }
+        rest = rest.subspan(chunk);
+    }
+    return n;
+}
+
+// ============================================================================
+// Hardware Triggers
+// ============================================================================
+
+Result<void> Context::set_triggers(std::span<const Trigger> triggers, bool all) {
+    if (watch_bits_ == 0) return Error::NotSupported;
+    if (triggers.size() > n_triggers_) return Error::InvalidArg;
+
+    std::vector<RegWrite> writes;
+    uint32_t enable = 0;
+    for (size_t i = 0; i < triggers.size(); i++) {
+        const Trigger& t = triggers[i];
+        if (t.word >= (watch_bits_ + 31) / 32) return Error::InvalidArg;
+        uint32_t base = addr::EmuCtrl + reg::TrigBase + static_cast<uint32_t>(i) * reg::TrigStride;
+        writes.push_back({base + reg::TrigSel, t.word | (static_cast<uint32_t>(t.mode) << 16)});
+        writes.push_back({base + reg::TrigMask, t.mask});
+        writes.push_back({base + reg::TrigValue, t.value});
+        enable |= 1u << i;
+    }
+    // Enables last, so no comparator fires on a half-written setting
+    writes.push_back({addr::EmuCtrl + reg::TrigCtrl, enable | (all ? 1u << 8 : 0)});
+    return write_batch(writes);
+}
+
+Result<uint32_t> Context::trigger_hits() {
+    if (watch_bits_ == 0) return Error::NotSupported;
+    auto val = read32(addr::EmuCtrl + reg::TrigHit);
+    if (!val.ok()) return val.error();
+    if (!(val.value() & status::TrigFired)) return 0u;
+    return val.value() & ((1u << n_triggers_) - 1);
 }
 
 // ============================================================================
@@ -666,55 +1376,99 @@ Result<bool> Context::is_coupled() {
 // PCIe-based Partial Reconfiguration
 // ============================================================================
 
+// Expected design hash from the .hash sidecar written next to a partial
+// bitstream at build time; empty if there is none
+static std::string read_hash_sidecar(const std::string& path) {
+    std::string hash_path = path;
+    if (hash_path.size() > 4 &&
+        hash_path.compare(hash_path.size() - 4, 4, ".bit") == 0)
+        hash_path = hash_path.substr(0, hash_path.size() - 4) + ".hash";
+    else
+        hash_path += ".hash";
+
+    FILE* hf = std::fopen(hash_path.c_str(), "r");
+    if (!hf) {
+        logger.warning("reconfigure: no .hash sidecar found at '%s' — "
+                       "cannot verify bitstream acceptance", hash_path.c_str());
+        return {};
+    }
+    char expected[65] = {};
+    size_t n = std::fread(expected, 1, 64, hf);
+    std::fclose(hf);
+    if (n < 8) {
+        logger.warning("reconfigure: .hash sidecar '%s' is malformed", hash_path.c_str());
+        return {};
+    }
+    return std::string(expected, n);
+}
+
 Result<void> Context::reconfigure(std::string_view partial_bit_path) {
-    // Open and read the partial bitstream file
+    return reconfigure(partial_bit_path, ReconfigureOptions{});
+}
+
+Result<void> Context::reconfigure(std::string_view partial_bit_path,
+                                  const ReconfigureOptions& opts) {
     std::string path(partial_bit_path);
-    FILE* f = std::fopen(path.c_str(), "rb");
-    if (!f) {
+    const std::string expected_hash = read_hash_sidecar(path);
+
+    // Same RM already loaded: skip the stream, just give it a clean start
+    if (opts.skip_if_loaded && !expected_hash.empty() && expected_hash == design_hash_hex()) {
+        logger.info("reconfigure: '%s' already loaded (%-.16s...), skipping PR",
+                    path.c_str(), expected_hash.c_str());
+        auto rc = reset();
+        if (!rc.ok()) logger.warning("reconfigure: reset failed (non-fatal)");
+        return {};
+    }
+
+    // Map the partial bitstream file
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
         logger.error("reconfigure: cannot open '%s': %s", path.c_str(), std::strerror(errno));
         return Error::InvalidArg;
     }
-
-    std::fseek(f, 0, SEEK_END);
-    long file_size = std::ftell(f);
-    std::fseek(f, 0, SEEK_SET);
-
-    if (file_size <= 0) {
-        std::fclose(f);
+    struct stat sb = {};
+    if (::fstat(fd, &sb) != 0 || sb.st_size <= 0) {
+        ::close(fd);
         logger.error("reconfigure: empty or unreadable file '%s'", path.c_str());
         return Error::InvalidArg;
     }
-
-    std::vector<uint8_t> buf(static_cast<size_t>(file_size));
-    if (std::fread(buf.data(), 1, buf.size(), f) != buf.size()) {
-        std::fclose(f);
-        logger.error("reconfigure: short read on '%s'", path.c_str());
+    size_t file_size = static_cast<size_t>(sb.st_size);
+    void* map = ::mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        logger.error("reconfigure: mmap '%s' failed: %s", path.c_str(), std::strerror(errno));
         return Error::Transport;
     }
-    std::fclose(f);
+    ::madvise(map, file_size, MADV_SEQUENTIAL);
+    struct Unmap {
+        void* p; size_t n;
+        ~Unmap() { ::munmap(p, n); }
+    } unmap{map, file_size};
+    const uint8_t* buf = static_cast<const uint8_t*>(map);
 
     // Locate the bitstream sync word 0xAA995566 (UG570).
     // Everything before it (including the .bit file header) is skipped.
-    size_t sync_off = buf.size();  // sentinel: not found
-    for (size_t i = 0; i + 4 <= buf.size(); i++) {
-        if (buf[i] == 0xAA && buf[i+1] == 0x99 &&
-            buf[i+2] == 0x55 && buf[i+3] == 0x66) {
-            sync_off = i;
-            break;
-        }
-    }
-    if (sync_off == buf.size()) {
+    static constexpr uint8_t kSync[] = {0xAA, 0x99, 0x55, 0x66};
+    const uint8_t* sync = std::search(buf, buf + file_size, std::begin(kSync), std::end(kSync));
+    if (sync == buf + file_size) {
         logger.error("reconfigure: sync word 0xAA995566 not found in '%s'", path.c_str());
         return Error::InvalidArg;
     }
+    size_t sync_off = static_cast<size_t>(sync - buf);
 
-    const uint8_t* data    = buf.data() + sync_off;
-    size_t         data_sz = buf.size() - sync_off;
+    const uint8_t* data    = sync;
+    size_t         data_sz = file_size - sync_off;
     size_t         n_words = (data_sz + 3) / 4;
 
     logger.info("reconfigure: '%s' — %zu bytes (header %zu bytes skipped)",
                 path.c_str(), data_sz, sync_off);
 
+    // Controllers with a FIFO take block writes through the DATA window;
+    // older ones get the same words as a batch of DATA writes
+    auto depth = read32(addr::IcapCtrl + reg::IcapDepth);
+    if (!depth.ok()) return depth.error();
+    const bool window = depth.value() != 0 && depth.value() != 0xDEADBEEF;
+
     // 1. Decouple RP to isolate it during configuration
     auto rc = decouple();
     if (!rc.ok()) {
@@ -722,13 +1476,13 @@ Result<void> Context::reconfigure(std::string_view partial_bit_path) {
         return rc;
     }
 
-    // 2. Reset ICAP state machine and clear sticky status bits
+    // 2. Reset ICAP state machine, flush its FIFO and clear sticky status bits
     auto wr = write32(addr::IcapCtrl + reg::IcapCtrl, 0x1);  // assert sw_reset
     if (!wr.ok()) { couple(); return wr.error(); }
     wr = write32(addr::IcapCtrl + reg::IcapCtrl, 0x0);        // deassert
     if (!wr.ok()) { couple(); return wr.error(); }
 
-    // 3. Stream bitstream words to the DATA register.
+    // 3. Stream bitstream words to ICAP.
     // The .bit file stores 32-bit words big-endian.  ICAPE3 expects file byte 0
     // at I[31:24], byte 1 at I[23:16], etc. (UG570 §9, Table 9-24).  We pack
     // each 4-byte group big-endian into a uint32_t; hardware applies per-byte
@@ -742,13 +1496,27 @@ Result<void> Context::reconfigure(std::string_view partial_bit_path) {
         std::string empty_bar(static_cast<size_t>(BAR_WIDTH), ' ');
         std::fprintf(stderr, "  PR [%s]   0%%  --.- MB/s", empty_bar.c_str());
 
-        for (size_t w = 0; w < n_words; w++) {
-            uint32_t word = 0;
-            for (int b = 0; b < 4; b++) {
-                size_t off = w * 4 + static_cast<size_t>(b);
-                word |= static_cast<uint32_t>(off < data_sz ? data[off] : 0x00u) << ((3 - b) * 8);
+        std::vector<uint32_t> chunk(reg::IcapWindowWords);
+        std::vector<RegWrite> writes;
+        for (size_t w = 0; w < n_words; w += chunk.size()) {
+            size_t n = std::min(chunk.size(), n_words - w);
+            for (size_t i = 0; i < n; i++) {
+                uint32_t word = 0;
+                for (int b = 0; b < 4; b++) {
+                    size_t off = (w + i) * 4 + static_cast<size_t>(b);
+                    word |= static_cast<uint32_t>(off < data_sz ? data[off] : 0x00u) << ((3 - b) * 8);
+                }
+                chunk[i] = word;
+            }
+            if (window) {
+                wr = write_block(addr::IcapCtrl + reg::IcapWindow,
+                                 std::span<const uint32_t>(chunk).first(n));
+            } else {
+                writes.clear();
+                for (size_t i = 0; i < n; i++)
+                    writes.push_back({addr::IcapCtrl + reg::IcapData, chunk[i]});
+                wr = write_batch(writes);
             }
-            wr = write32(addr::IcapCtrl + reg::IcapData, word);
             if (!wr.ok()) {
                 std::fprintf(stderr, "\n");
                 logger.error("reconfigure: write failed at word %zu", w);
@@ -756,14 +1524,15 @@ Result<void> Context::reconfigure(std::string_view partial_bit_path) {
                 return wr.error();
             }
 
-            int pct = static_cast<int>(100 * w / n_words);
+            size_t sent = w + n;
+            int pct = static_cast<int>(100 * sent / n_words);
             if (pct != last_pct) {
                 last_pct = pct;
                 int filled = pct * BAR_WIDTH / 100;
                 auto now = std::chrono::steady_clock::now();
                 double elapsed_s = std::chrono::duration<double>(now - t0).count();
                 double mb_s = elapsed_s > 0.0
-                    ? (static_cast<double>(w) * 4.0 / 1e6) / elapsed_s
+                    ? (static_cast<double>(sent) * 4.0 / 1e6) / elapsed_s
                     : 0.0;
                 // Build bar: █ = U+2588 = \xe2\x96\x88, space for empty
                 std::string bar;
@@ -837,37 +1606,16 @@ Result<void> Context::reconfigure(std::string_view partial_bit_path) {
     //     build time.  A mismatch means the bitstream wasn't applied (e.g. it
     //     was built against a different static_routed.dcp and ICAP silently
     //     accepted it, or the wrong .bit file was given).
-    {
-        std::string hash_path = path;
-        if (hash_path.size() > 4 &&
-            hash_path.compare(hash_path.size() - 4, 4, ".bit") == 0)
-            hash_path = hash_path.substr(0, hash_path.size() - 4) + ".hash";
-        else
-            hash_path += ".hash";
-
-        FILE* hf = std::fopen(hash_path.c_str(), "r");
-        if (!hf) {
-            logger.warning("reconfigure: no .hash sidecar found at '%s' — "
-                           "cannot verify bitstream acceptance", hash_path.c_str());
+    if (!expected_hash.empty()) {
+        std::string actual = design_hash_hex();
+        if (actual == expected_hash) {
+            logger.info("reconfigure: hash verified (%-.16s...)", expected_hash.c_str());
         } else {
-            char expected[65] = {};
-            if (std::fread(expected, 1, 64, hf) < 8) {
-                logger.warning("reconfigure: .hash sidecar '%s' is malformed",
-                               hash_path.c_str());
-            } else {
-                expected[64] = '\0';
-                std::string actual = design_hash_hex();
-                if (actual == std::string(expected)) {
-                    logger.info("reconfigure: hash verified (%-.16s...)", expected);
-                } else {
-                    logger.error("reconfigure: HASH MISMATCH — bitstream may not have "
-                                 "been applied!\n"
-                                 "  expected: %s\n"
-                                 "  actual:   %s",
-                                 expected, actual.c_str());
-                }
-            }
-            std::fclose(hf);
+            logger.error("reconfigure: HASH MISMATCH — bitstream may not have "
+                         "been applied!\n"
+                         "  expected: %s\n"
+                         "  actual:   %s",
+                         expected_hash.c_str(), actual.c_str());
         }
     }
 
@@ -11,6 +11,7 @@
 #include <cstdint>
 #include <cstdio>
 #include <memory>
+#include <span>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -107,9 +108,13 @@ namespace addr {
     constexpr uint32_t DpiRegfile = 0x10000;
     constexpr uint32_t ScanCtrl = 0x20000;
     constexpr uint32_t MemCtrl  = 0x30000;
+    constexpr uint32_t TraceCtrl = 0x38000;  // loom_trace_ctrl (scan_insert -trace)
     constexpr uint32_t ClkGen   = 0x40000;
     constexpr uint32_t Firewall = 0x50000;
     constexpr uint32_t IcapCtrl = 0x60000;  // loom_icap_ctrl (ICAP_ULTRASCALE)
+    // emu_top -instances: instance k's emu_top window (EmuCtrl .. ClkGen)
+    // starts at k * InstanceStride
+    constexpr uint32_t InstanceStride = 0x100000;
 }
 
 namespace reg {
@@ -140,6 +145,33 @@ namespace reg {
     constexpr uint32_t DesignHash5 = 0x5C;
     constexpr uint32_t DesignHash6 = 0x60;
     constexpr uint32_t DesignHash7 = 0x64;
+    constexpr uint32_t TraceBits = 0x68;     // 0 (or 0xDEADBEEF) = no trace buffer
+
+    // emu_ctrl performance counters (host clock cycles). Reading a *Lo
+    // register latches the high word returned by the following *Hi read.
+    constexpr uint32_t PerfCtrl = 0x6C;      // R: bit0=present, W: bit0=clear
+    constexpr uint32_t PerfRunLo = 0x70;
+    constexpr uint32_t PerfRunHi = 0x74;
+    constexpr uint32_t PerfEnLo = 0x78;
+    constexpr uint32_t PerfEnHi = 0x7C;
+    constexpr uint32_t PerfDpiLo = 0x80;
+    constexpr uint32_t PerfDpiHi = 0x84;
+    constexpr uint32_t PerfFifoLo = 0x88;
+    constexpr uint32_t PerfFifoHi = 0x8C;
+    constexpr uint32_t PerfFuncSel = 0x90;
+    constexpr uint32_t PerfFuncLo = 0x94;
+    constexpr uint32_t PerfFuncHi = 0x98;    // read advances PerfFuncSel
+
+    // emu_ctrl trigger bank (scan_insert -watch)
+    constexpr uint32_t WatchBits = 0x9C;     // 0 (or 0xDEADBEEF) = no triggers
+    constexpr uint32_t TrigCtrl = 0xA0;      // [3:0]=enable, [8]=AND, R: [31:24]=count
+    constexpr uint32_t TrigHit = 0xA4;       // [3:0]=matched, [31]=fired
+    constexpr uint32_t Instance = 0xA8;      // [7:0]=index, [15:8]=count (emu_top -instances)
+    constexpr uint32_t TrigBase = 0xC0;      // comparator k at TrigBase + k * TrigStride
+    constexpr uint32_t TrigStride = 0x10;
+    constexpr uint32_t TrigSel = 0x00;       // [15:0]=probe word, [17:16]=mode
+    constexpr uint32_t TrigMask = 0x04;
+    constexpr uint32_t TrigValue = 0x08;
 
     // DPI regfile register offsets (per function, 64 bytes each)
     constexpr uint32_t DpiFuncSize = 0x40;
@@ -150,16 +182,30 @@ namespace reg {
     //   DpiResultLo = DpiArg0 + max_args * 4
     //   DpiResultHi = DpiResultLo + 4
 
-    // Global DPI pending mask (func_idx=1023, one bit per function)
+    // Global DPI pending mask bank (func_idx=1023): word k at +4*k holds
+    // one bit per function 32*k .. 32*k+31
     constexpr uint32_t DpiPendingMask = 0xFFC0;
+    constexpr uint32_t DpiDoneMask = 0xFFC0;   // write: set_done per bit
+    constexpr uint32_t DpiPendingMaxWords = 16;
+    constexpr uint32_t DpiMaxFuncs = 256;      // 8-bit function ID bus
 
     // DPI FIFO registers (func_idx=1022, offset 0xFF80)
     constexpr uint32_t DpiFifoBase      = 0xFF80;
-    constexpr uint32_t DpiFifoStatus    = DpiFifoBase + 0x00;   // REG_STATUS: {level, 14'b0, full, empty}
+    constexpr uint32_t DpiFifoStatus    = DpiFifoBase + 0x00;   // REG_STATUS: {level, 13'b0, stream, full, empty}
     constexpr uint32_t DpiFifoControl   = DpiFifoBase + 0x04;   // REG_CONTROL: {entry_words, threshold}
     constexpr uint32_t DpiFifoThreshold = DpiFifoBase + 0x08;   // ARG0: threshold write
     constexpr uint32_t DpiFifoData      = DpiFifoBase + 0x08;   // ARG0+: head entry data words
 
+    // DPI FIFO stream window (func_idx=1021): every read returns the next
+    // head-entry word and pops after the entry's last word
+    constexpr uint32_t DpiFifoStream      = 0xFF40;
+    constexpr uint32_t DpiFifoStreamWords = 16;
+
+    // Large-argument scratch window (func_idx 512..767): reads return the
+    // pending call's input array words, writes set its output array words
+    constexpr uint32_t DpiXargBase     = 0x8000;
+    constexpr uint32_t DpiXargMaxWords = 4096;
+
     // Firewall management register offsets (at addr::Firewall = 0x50000)
     constexpr uint32_t FwCtrl            = 0x00;  // bit0=lockdown, bit1=clear_counts, bit2=decouple
     constexpr uint32_t FwStatus          = 0x04;  // bit0=locked, bit1=wr_outstanding, bit2=rd_outstanding, bit3=decouple_status
@@ -182,7 +228,12 @@ namespace reg {
     constexpr uint32_t ScanStatus = 0x00;
     constexpr uint32_t ScanControl = 0x04;
     constexpr uint32_t ScanLength = 0x08;
+    constexpr uint32_t ScanChains = 0x0C;         // R: [15:0]=chains, [30]=reset ROM, [31]=stream only
     constexpr uint32_t ScanDataBase = 0x10;
+    constexpr uint32_t ScanPatchBase = 0x7F00;    // W: reinit patch slots (WORD, VALUE, MASK)
+    constexpr uint32_t ScanPatchSlots = 16;       // 16 bytes per slot
+    constexpr uint32_t ScanStreamBase = 0x8000;   // RW: stream window
+    constexpr uint32_t ScanStreamWords = 8192;    // window size in words
 
     // mem_ctrl register offsets
     constexpr uint32_t MemStatus   = 0x00;
@@ -190,11 +241,35 @@ namespace reg {
     constexpr uint32_t MemAddr     = 0x08;
     constexpr uint32_t MemLength   = 0x0C;
     constexpr uint32_t MemDataBase = 0x10;
+    constexpr uint32_t MemDirtyPage  = 0x400;    // R: dirty page size in bytes (0 = off)
+    constexpr uint32_t MemDirtyCount = 0x404;    // R: number of tracked pages
+    constexpr uint32_t MemCaps       = 0x408;    // R: [0]=write stream, [1]=fill
+    constexpr uint32_t MemDirtyBase  = 0x600;    // R: dirty bitmap, 32 pages per word
+    constexpr uint32_t MemStreamBase = 0x800;    // RW: read/write-stream window
+    constexpr uint32_t MemStreamWords = 512;     // window size in words
+
+    // trace_ctrl register offsets (at addr::TraceCtrl = 0x38000)
+    constexpr uint32_t TraceStatus     = 0x00;
+    constexpr uint32_t TraceControl    = 0x04;   // W: [7:0]=command, [8]=stall when full
+    constexpr uint32_t TraceWidth      = 0x08;
+    constexpr uint32_t TraceDepth      = 0x0C;
+    constexpr uint32_t TraceLevel      = 0x10;   // R: entries waiting
+    constexpr uint32_t TraceDropped    = 0x14;
+    constexpr uint32_t TraceTrigWord   = 0x18;
+    constexpr uint32_t TraceTrigMask   = 0x1C;
+    constexpr uint32_t TraceTrigValue  = 0x20;
+    constexpr uint32_t TracePost       = 0x24;
+    constexpr uint32_t TraceEntryWords = 0x28;
+    constexpr uint32_t TraceStreamBase = 0x800;  // R: pop window
+    constexpr uint32_t TraceStreamWords = 512;   // window size in words
 
     // icap_ctrl register offsets (at addr::IcapCtrl = 0x60000)
     constexpr uint32_t IcapStatus = 0x00;  // R: [0]=busy, [1]=prdone, [2]=prerror
     constexpr uint32_t IcapCtrl   = 0x04;  // W: [0]=sw_reset
     constexpr uint32_t IcapData   = 0x08;  // W: bitstream word (big-endian from file)
+    constexpr uint32_t IcapDepth  = 0x0C;  // R: FIFO depth in words (0 = no FIFO)
+    constexpr uint32_t IcapWindow = 0x1000;     // W: DATA window for block writes
+    constexpr uint32_t IcapWindowWords = 1024;
 }
 
 namespace cmd {
@@ -206,23 +281,66 @@ namespace cmd {
 
     constexpr uint32_t ScanCapture = 0x01;
     constexpr uint32_t ScanRestore = 0x02;
+    constexpr uint32_t ScanCaptureStream = 0x03;
+    constexpr uint32_t ScanRestoreStream = 0x04;
+    constexpr uint32_t ScanReinit = 0x05;        // shift in the reset image ROM
 
     constexpr uint32_t MemRead = 0x01;
     constexpr uint32_t MemWrite = 0x02;
     constexpr uint32_t MemPreloadStart = 0x03;
     constexpr uint32_t MemPreloadNext = 0x04;
+    constexpr uint32_t MemReadStream = 0x05;     // [15:8] = words per entry
+    constexpr uint32_t MemDirtyClear = 0x06;
+    constexpr uint32_t MemWriteStream = 0x07;    // [15:8] = words per entry
+    constexpr uint32_t MemFill = 0x08;           // [31:8] = entry count
+
+    constexpr uint32_t TraceArm = 0x01;
+    constexpr uint32_t TraceStop = 0x02;
+    constexpr uint32_t TraceClear = 0x03;
+    constexpr uint32_t TraceStallFull = 1 << 8;  // with TraceArm
 }
 
 namespace status {
     constexpr uint32_t DpiPending = 1 << 0;
     constexpr uint32_t DpiDone = 1 << 1;
     constexpr uint32_t DpiError = 1 << 2;
+    constexpr uint32_t DpiDoneMaskCap = 1 << 3;  // regfile accepts DONE_MASK writes
 
     constexpr uint32_t ScanBusy = 1 << 0;
     constexpr uint32_t ScanDone = 1 << 1;
 
     constexpr uint32_t MemBusy = 1 << 0;
     constexpr uint32_t MemDone = 1 << 1;
+
+    constexpr uint32_t FifoEmpty = 1 << 0;
+    constexpr uint32_t FifoFull = 1 << 1;
+    constexpr uint32_t FifoStream = 1 << 2;
+
+    constexpr uint32_t TraceArmed = 1 << 0;
+    constexpr uint32_t TraceCapturing = 1 << 1;
+    constexpr uint32_t TraceDone = 1 << 2;
+    constexpr uint32_t TraceOverflow = 1 << 3;
+    constexpr uint32_t TraceFull = 1 << 4;
+
+    // emu_ctrl IRQ_STATUS / IRQ_ENABLE bits
+    constexpr uint32_t IrqDpi = 1 << 1;
+    constexpr uint32_t IrqStateChange = 1 << 2;
+    constexpr uint32_t IrqScanDone = 1 << 3;
+    constexpr uint32_t IrqMemDone = 1 << 4;
+    constexpr uint32_t IrqTrigger = 1 << 5;   // status only: freeze caused by a trigger
+
+    constexpr uint32_t TrigFired = 1u << 31;
+}
+
+// Interrupt sources as reported by wait_irq(): the emu_top irq_o order,
+// which differs from the IRQ_ENABLE bit positions above
+namespace irq_src {
+    constexpr uint32_t Dpi = 1 << 0;            // a DPI call is stalled
+    constexpr uint32_t StateChange = 1 << 1;
+    constexpr uint32_t FifoThreshold = 1 << 2;
+    constexpr uint32_t ScanDone = 1 << 3;
+    constexpr uint32_t MemDone = 1 << 4;
+    constexpr uint32_t All = 0xFFFF;            // source unknown: any may have fired
 }
 
 namespace ctrl {
@@ -249,6 +367,12 @@ inline std::string version_string(uint32_t v) {
 // Transport Interface
 // ============================================================================
 
+// One entry of a scatter write batch (see Transport::write_batch)
+struct RegWrite {
+    uint32_t addr;
+    uint32_t data;
+};
+
 class Transport {
 public:
     virtual ~Transport() = default;
@@ -258,17 +382,42 @@ public:
     virtual Result<uint32_t> read32(uint32_t addr) = 0;
     virtual Result<void> write32(uint32_t addr, uint32_t data) = 0;
 
-    // Block until a hardware interrupt fires. Returns IRQ bitmask.
+    // Batched access. Accesses are issued in order and complete in order,
+    // so a batch may mix data and command registers (e.g. data words
+    // followed by a CONTROL write). The first failing access aborts the
+    // batch and its error is returned.
+    //
+    // The default implementations loop over read32()/write32(); transports
+    // override them with a native path:
+    //   Socket: requests are pipelined, then responses are collected
+    //   Shm:    as Socket, through shared-memory rings
+    //   XDMA:   mmap mode copies through the BAR, pread mode uses one
+    //           preadv()/pwritev() per contiguous block
+    //
+    // read_block/write_block: contiguous words starting at addr
+    // read_batch/write_batch: independent addresses (scatter/gather)
+    virtual Result<void> read_block(uint32_t addr, std::span<uint32_t> data);
+    virtual Result<void> write_block(uint32_t addr, std::span<const uint32_t> data);
+    virtual Result<void> read_batch(std::span<const uint32_t> addrs, std::span<uint32_t> data);
+    virtual Result<void> write_batch(std::span<const RegWrite> writes);
+
+    // Block until a hardware interrupt fires, for at most timeout_ms
+    // milliseconds (< 0: no limit). Returns IRQ bitmask.
     //
     // Socket:  blocks on recv() waiting for type=2 (IRQ) or type=3 (shutdown)
-    // XDMA:    blocks on read(events_fd) waiting for MSI
+    // Shm:     spins, then sleeps on a futex, for the same messages
+    // XDMA:    epoll on the per-source events_N devices waiting for MSI
     //
     // Returns:
-    //   Ok(bitmask)        — interrupt fired, bitmask indicates which IRQ lines
+    //   Ok(bitmask)        — interrupt fired, irq_src bits of the lines that
+    //                        rose (irq_src::All if the source is unknown)
     //   Error::Shutdown    — emulation ended (shutdown message or EOF)
     //   Error::Interrupted — signal received (EINTR), caller should check flags
-    //   Error::NotSupported — transport has no interrupt capability (use polling)
-    virtual Result<uint32_t> wait_irq() = 0;
+    //   Error::Timeout     — timeout_ms passed without an interrupt
+    //   Error::NotSupported — transport has no interrupt capability (use polling),
+    //                        or cannot bound the wait (timeout_ms >= 0)
+    virtual Result<uint32_t> wait_irq(int timeout_ms) = 0;
+    Result<uint32_t> wait_irq() { return wait_irq(-1); }
 
     // Returns true if the transport supports interrupt-driven wait_irq()
     virtual bool has_irq_support() const = 0;
@@ -276,13 +425,39 @@ public:
     virtual bool is_connected() const = 0;
 };
 
-// ============================================================================
-// DPI Call Information
-// ============================================================================
+// Transport-level counters, kept by Context around every Transport call.
+// A call is one round trip whatever its size (a whole block or batch is
+// one); its latency is the call's wall time, histogrammed by powers of
+// two. wait_irq() is counted but not timed.
+struct TransportStats {
+    static constexpr size_t kLatencyBuckets = 32;  // bucket i: [2^i, 2^(i+1)) ns
+
+    uint64_t read_ops = 0;     // read32 / read_block / read_batch calls
+    uint64_t write_ops = 0;    // write32 / write_block / write_batch calls
+    uint64_t read_bytes = 0;   // data payload, excluding addresses
+    uint64_t write_bytes = 0;
+    uint64_t irq_waits = 0;
+    uint64_t busy_ns = 0;      // summed latency of all read and write calls
+    std::array<uint64_t, kLatencyBuckets> latency_hist{};
+
+    uint64_t round_trips() const { return read_ops + write_ops; }
+    // Upper bound of the histogram bucket holding quantile q (0..1)
+    uint64_t latency_quantile_ns(double q) const;
+};
 
-struct DpiCall {
-    uint32_t func_id;
-    std::vector<uint32_t> args;
+// emu_ctrl stall counters, in emulation clock cycles. They run from the
+// last clear_emu_perf() (or bitstream load) and only count while running.
+struct EmuPerf {
+    uint64_t run_cycles = 0;         // Running and below the time compare
+    uint64_t enabled_cycles = 0;     // ... with loom_en high (DUT advanced)
+    uint64_t dpi_stall_cycles = 0;   // held by a blocking DPI call
+    uint64_t fifo_stall_cycles = 0;  // held by a full DPI FIFO
+    std::vector<uint64_t> func_stall_cycles;  // DPI stall per function ID
+
+    // Fraction of running cycles in which the DUT advanced
+    double efficiency() const {
+        return run_cycles ? static_cast<double>(enabled_cycles) / static_cast<double>(run_cycles) : 0.0;
+    }
 };
 
 // ============================================================================
@@ -317,8 +492,20 @@ public:
     uint32_t n_dpi_funcs() const { return n_dpi_funcs_; }
     uint32_t max_dpi_args() const { return max_dpi_args_; }
     uint32_t scan_chain_length() const { return scan_chain_length_; }
+    uint32_t n_scan_chains() const { return n_scan_chains_; }
+    // Shift cycles per capture/restore; each chain owns this many image bits
+    uint32_t scan_chain_bits() const;
+    uint32_t scan_words_per_chain() const { return (scan_chain_bits() + 31) / 32; }
+    // True if the scan controller has no data buffer (streaming only)
+    bool scan_stream_only() const { return scan_stream_only_; }
+    // True if the scan controller holds the initial image (emu_top -reset_rom)
+    bool scan_has_reset_rom() const { return scan_has_reset_rom_; }
     uint32_t shell_version() const { return shell_version_; }
     const std::array<uint32_t, 8>& design_hash() const { return design_hash_; }
+    // emu_top -instances: DUT copy this Context drives and the number of
+    // copies in the design (0 and 1 without -instances)
+    uint32_t instance() const { return instance_; }
+    uint32_t n_instances() const { return n_instances_; }
 
     // Return design hash as hex string (64 chars)
     std::string design_hash_hex() const;
@@ -339,16 +526,40 @@ public:
     Result<void> set_time_compare(uint64_t value);
     Result<uint64_t> get_time_compare();
 
+    // Overwrite cycle and DUT time counters (snapshot restore / rewind).
+    // emu_ctrl only accepts counter writes while frozen.
+    Result<void> set_counters(uint64_t cycle_count, uint64_t dut_time);
+
     // ========================================================================
     // DPI Function Handling
     // ========================================================================
 
-    Result<uint32_t> dpi_poll();  // Returns pending mask
-    Result<DpiCall> dpi_get_call(uint32_t func_id);
+    // Argument and FIFO buffers are caller-owned: dpi_get_call fills the
+    // first min(args.size(), max_dpi_args()) words, fifo_pop_entry needs
+    // room for fifo_entry_words().
+    Result<uint32_t> dpi_poll();  // Returns pending mask word 0 (functions 0..31)
+    Result<void> dpi_poll(std::span<uint32_t> mask);  // Fills dpi_pending_words() words
+    uint32_t dpi_pending_words() const;
+    Result<void> dpi_get_call(uint32_t func_id, std::span<uint32_t> args);
+    // Input array words of the pending large-argument call, in one burst
+    // from the scratch window (only one such call is pending at a time)
+    Result<void> dpi_read_xargs(std::span<uint32_t> words);
     Result<void> dpi_complete(uint32_t func_id, uint64_t result);
     Result<void> dpi_write_arg(uint32_t func_id, int arg_idx, uint32_t value);
+    Result<void> dpi_write_args(uint32_t func_id, std::span<const uint32_t> values);
     Result<void> dpi_error(uint32_t func_id);
 
+    // Coalesced completion: stage any number of completions, then issue
+    // them as one write batch. Output args and result words (skipped for
+    // void functions) go first, then one DONE_MASK word per 32 functions
+    // on regfiles that support it, else one CONTROL write per function.
+    bool has_dpi_done_mask() const { return dpi_done_mask_; }
+    // `xresult` words go to the scratch window ahead of the set_done.
+    Result<void> dpi_stage_complete(uint32_t func_id, uint64_t result,
+                                    std::span<const uint32_t> out_args, bool has_result = true,
+                                    std::span<const uint32_t> xresult = {});
+    Result<uint32_t> dpi_flush_completions();  // returns completions issued
+
     // ========================================================================
     // DPI FIFO (read-only DPI call buffering)
     // ========================================================================
@@ -356,7 +567,12 @@ public:
     uint32_t fifo_entry_words() const { return fifo_entry_words_; }
     Result<uint32_t> fifo_status();
     Result<bool> fifo_is_empty();
-    Result<std::vector<uint32_t>> fifo_pop_entry();
+    Result<void> fifo_pop_entry(std::span<uint32_t> entry);
+    // Pop up to max_entries entries (bounded by out.size()) in one batched
+    // read through the stream window; returns the number popped. Falls back
+    // to fifo_pop_entry one entry at a time on hardware without the window.
+    bool fifo_has_stream() const { return fifo_stream_; }
+    Result<uint32_t> fifo_pop_entries(std::span<uint32_t> out, uint32_t max_entries);
     Result<void> fifo_set_threshold(uint32_t level);
 
     // ========================================================================
@@ -368,6 +584,82 @@ public:
     Result<std::vector<uint32_t>> mem_read_entry(uint32_t global_addr, int n_data_words);
     Result<void> mem_preload_start(uint32_t global_addr, const std::vector<uint32_t>& data);
     Result<void> mem_preload_next(const std::vector<uint32_t>& data);
+    // Read `count` consecutive entries starting at global_addr using the
+    // read-stream window (entries are 4 address bytes apart, as for preload).
+    // Returns count * n_data_words words, entry-major.
+    Result<std::vector<uint32_t>> mem_read_range(uint32_t global_addr, uint32_t count,
+                                                 int n_data_words = 1);
+    // Bulk preload, available when mem_has_bulk_write(): mem_write_range
+    // streams data.size() / n_data_words consecutive entries through the
+    // write-stream window; mem_fill writes `value` to `count` consecutive
+    // entries in hardware, one per cycle.
+    bool mem_has_bulk_write() const { return mem_bulk_write_; }
+    Result<void> mem_write_range(uint32_t global_addr, std::span<const uint32_t> data,
+                                 int n_data_words = 1);
+    Result<void> mem_fill(uint32_t global_addr, std::span<const uint32_t> value, uint32_t count);
+    // Dirty page tracking: page p covers global bytes [p, p+1) * mem_page_bytes().
+    // A page is dirty once a DUT write port or a shadow write touches it.
+    // mem_page_bytes() is 0 when the design has no dirty tracking.
+    uint32_t mem_page_bytes() const { return mem_page_bytes_; }
+    uint32_t mem_page_count() const { return mem_page_count_; }
+    Result<std::vector<uint32_t>> mem_dirty_pages();   // bitmap, 32 pages per word
+    Result<void> mem_dirty_clear();
+    // Successful mem_dirty_clear() calls so far: unchanged since a restore
+    // means the memories differ from it only on the pages now dirty
+    uint64_t mem_dirty_epoch() const { return mem_dirty_epoch_; }
+
+    // ========================================================================
+    // Trace Buffer
+    // ========================================================================
+
+    // Entries are trace_entry_words() words: the low 32 bits of the cycle
+    // counter, then trace_bits() probe bits LSB first (laid out per the
+    // trace map written by scan_insert -trace). trace_bits() is 0 when the
+    // design has no trace buffer.
+    struct TraceConfig {
+        uint32_t trig_word = 0;    // probe word compared by the trigger
+        uint32_t trig_mask = 0;    // 0 = start recording on arm
+        uint32_t trig_value = 0;
+        uint32_t post = 0;         // cycles to record from the trigger, 0 = until stop
+        bool stall = false;        // hold the DUT while the RAM is full instead of dropping
+    };
+    uint32_t trace_bits() const { return trace_bits_; }
+    uint32_t trace_depth() const { return trace_depth_; }
+    uint32_t trace_entry_words() const { return trace_entry_words_; }
+    Result<void> trace_arm(const TraceConfig& config);
+    Result<void> trace_stop();
+    Result<uint32_t> trace_status();
+    Result<uint32_t> trace_dropped();
+    // Append every waiting entry to `entries`; returns the number read
+    Result<uint32_t> trace_drain(std::vector<uint32_t>& entries);
+
+    // ========================================================================
+    // Hardware Triggers
+    // ========================================================================
+
+    // Comparators over the watch probe: watch_bits() bits LSB first, laid
+    // out per the watch map written by scan_insert -watch. When the combined
+    // condition holds, emu_ctrl freezes the DUT on that cycle and raises the
+    // state-change IRQ. watch_bits() is 0 when the design has no triggers.
+    enum class TriggerMode : uint32_t {
+        Equal = 0,    // (probe word & mask) == value
+        Enter = 1,    // ... and was not on the previous DUT cycle
+        Change = 2,   // masked bits differ from the previous DUT cycle
+    };
+    struct Trigger {
+        uint32_t word = 0;     // probe word compared
+        uint32_t mask = 0;
+        uint32_t value = 0;
+        TriggerMode mode = TriggerMode::Equal;
+    };
+    uint32_t watch_bits() const { return watch_bits_; }
+    uint32_t n_triggers() const { return n_triggers_; }
+    // Load and enable `triggers` (at most n_triggers(); none disables the
+    // bank). With `all` the bank fires when every trigger matches, else any.
+    Result<void> set_triggers(std::span<const Trigger> triggers, bool all = false);
+    // Triggers that matched when the bank froze the DUT, 0 if the current
+    // freeze (or run) has another cause
+    Result<uint32_t> trigger_hits();
 
     // ========================================================================
     // Scan Chain Control
@@ -380,6 +672,35 @@ public:
     Result<bool> scan_is_busy();
     Result<void> scan_clear_done();
 
+    // Streaming capture/restore through the scan controller's FIFO window.
+    // Entries come in shift order, word_idx running from
+    // scan_words_per_chain()-1 down to 0; chain_words[c] is image word
+    // c * scan_words_per_chain() + word_idx. Returning an error from the
+    // callback aborts the transfer (the controller is left mid-shift until
+    // the next scan command).
+    using ScanCaptureFn = std::function<Result<void>(uint32_t word_idx,
+                                                     std::span<const uint32_t> chain_words)>;
+    using ScanRestoreFn = std::function<Result<void>(uint32_t word_idx,
+                                                     std::span<uint32_t> chain_words)>;
+    Result<void> scan_capture_stream(const ScanCaptureFn& sink, int timeout_ms = 5000);
+    Result<void> scan_restore_stream(const ScanRestoreFn& source, int timeout_ms = 5000);
+
+    // Whole scan image (ceil(scan_chain_length()/32) words), using the data
+    // buffer when present and streaming otherwise
+    Result<std::vector<uint32_t>> scan_capture_image(int timeout_ms = 5000);
+    Result<void> scan_restore_image(std::span<const uint32_t> image, int timeout_ms = 5000);
+
+    // Shift the reset image ROM back in (scan_has_reset_rom() only). Each
+    // patch replaces the `mask` bits of image word `word` with `value` on
+    // the way in; at most reg::ScanPatchSlots patches, unused slots are
+    // cleared. No image data crosses the transport.
+    struct ScanPatch {
+        uint32_t word;
+        uint32_t value;
+        uint32_t mask;
+    };
+    Result<void> scan_reinit(std::span<const ScanPatch> patches = {}, int timeout_ms = 5000);
+
     // ========================================================================
     // Decoupler Control
     // ========================================================================
@@ -397,15 +718,49 @@ public:
     // The bitstream header is stripped automatically (searches for sync word
     // 0xAA995566); only the raw configuration data is sent to ICAP.
     // FPGA transport only — returns Error::NotSupported on socket transport.
+    //
+    // The file is mapped, not read, and streamed in window-sized block
+    // writes into the controller's FIFO. With skip_if_loaded, a bitstream
+    // whose .hash sidecar matches the loaded design hash is not streamed
+    // again; the RM is only reset.
+    struct ReconfigureOptions {
+        bool skip_if_loaded = false;
+    };
     Result<void> reconfigure(std::string_view partial_bit_path);
+    Result<void> reconfigure(std::string_view partial_bit_path,
+                             const ReconfigureOptions& opts);
 
     // ========================================================================
     // Interrupt Support
     // ========================================================================
 
+    // Interrupts consumed by an internal completion wait are kept and
+    // returned by the next wait_irq() without blocking.
     Result<uint32_t> wait_irq();
     bool has_irq_support() const;
 
+    // Scan/memory completion waits spin on the status register, then either
+    // block on the scan/mem done IRQ (if enabled here and the transport has
+    // interrupt support) or poll with exponential backoff.
+    void set_completion_irq(bool enable) { completion_irq_ = enable; }
+    bool completion_irq() const { return completion_irq_; }
+
+    // ========================================================================
+    // Performance Counters
+    // ========================================================================
+
+    // Counters over every access since construction or the last reset
+    const TransportStats& transport_stats() const { return *transport_stats_; }
+    void reset_transport_stats() { *transport_stats_ = {}; }
+
+    // emu_ctrl stall counters; shells before 0.5.0 have none
+    bool has_emu_perf() const { return emu_perf_; }
+    Result<EmuPerf> read_emu_perf();
+    Result<void> clear_emu_perf();
+
+    // Emulation clock set by configure_clock(), 0 when unknown (simulation)
+    uint32_t clock_mhz() const { return clock_mhz_; }
+
     // ========================================================================
     // Low-level Register Access
     // ========================================================================
@@ -413,20 +768,54 @@ public:
     Result<uint32_t> read32(uint32_t addr);
     Result<void> write32(uint32_t addr, uint32_t data);
 
+    // Batched access (see Transport::read_block et al.)
+    Result<void> read_block(uint32_t addr, std::span<uint32_t> data);
+    Result<void> write_block(uint32_t addr, std::span<const uint32_t> data);
+    Result<void> read_batch(std::span<const uint32_t> addrs, std::span<uint32_t> data);
+    Result<void> write_batch(std::span<const RegWrite> writes);
+
 private:
     Result<void> probe_rm();   // re-read RM registers after connect or reconfigure
     Result<void> scan_wait_done(int timeout_ms);
     Result<void> mem_wait_done(int timeout_ms);
-    Result<void> mem_clear_done();
+    Result<void> wait_status(uint32_t status_addr, uint32_t done_mask,
+                             uint32_t irq_bit, int timeout_ms);
+    Result<void> mem_issue(uint32_t command, std::optional<uint32_t> global_addr,
+                           std::span<const uint32_t> data);
 
-    std::unique_ptr<Transport> transport_;
+    std::unique_ptr<TransportStats> transport_stats_;  // heap: stable across moves
+    std::unique_ptr<Transport> transport_;   // counting wrapper around the real one
     uint32_t n_dpi_funcs_ = 0;
     uint32_t max_dpi_args_ = 8;
     uint32_t scan_chain_length_ = 0;
+    uint32_t n_scan_chains_ = 1;
+    bool scan_stream_only_ = false;
+    bool scan_has_reset_rom_ = false;
     uint32_t n_memories_ = 0;
+    uint32_t mem_page_bytes_ = 0;
+    uint64_t mem_dirty_epoch_ = 0;
+    uint32_t mem_page_count_ = 0;
+    bool mem_bulk_write_ = false;
     uint32_t shell_version_ = 0;
+    uint32_t instance_ = 0;
+    uint32_t n_instances_ = 1;
     uint32_t fifo_entry_words_ = 0;
+    bool fifo_stream_ = false;
+    bool dpi_done_mask_ = false;
+    std::vector<RegWrite> dpi_staged_;        // staged completion writes
+    std::vector<uint32_t> dpi_staged_mask_;   // functions staged for set_done
+    uint32_t dpi_staged_count_ = 0;
+    std::vector<uint32_t> fifo_addrs_;
+    uint32_t trace_bits_ = 0;
+    uint32_t trace_depth_ = 0;
+    uint32_t trace_entry_words_ = 0;
+    uint32_t watch_bits_ = 0;
+    uint32_t n_triggers_ = 0;
+    bool emu_perf_ = false;
+    uint32_t clock_mhz_ = 0;
     std::array<uint32_t, 8> design_hash_ = {};
+    bool completion_irq_ = false;
+    uint32_t irq_stash_ = 0;   // IRQs seen during a completion wait
 };
 
 // ============================================================================
@@ -435,5 +824,18 @@ private:
 
 std::unique_ptr<Transport> create_socket_transport();
 std::unique_ptr<Transport> create_xdma_transport();
+// Shared-memory rings to a socket BFM started with +shm=PATH (target: PATH)
+std::unique_ptr<Transport> create_shm_transport();
+
+// emu_top -instances: one Context per DUT copy, all on one transport.
+// The shared transport serialises calls from several threads and connects
+// the real one for its first user, disconnecting after its last. An
+// instance transport moves emu_top accesses (below addr::ClkGen) to
+// instance `index`'s window and passes the shell's registers through.
+// The copies share the IRQ lines, so instance transports report no
+// interrupt support and their Contexts poll.
+std::shared_ptr<Transport> create_shared_transport(std::unique_ptr<Transport> transport);
+std::unique_ptr<Transport> create_instance_transport(std::shared_ptr<Transport> shared,
+                                                     uint32_t index);
 
 } // namespace loom
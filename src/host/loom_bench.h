@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: Apache-2.0
+// Loom Host Benchmarks
+//
+// Micro-benchmarks of the host <-> emu_top path, run by the shell `bench`
+// command over whatever transport the context was opened with. Each one
+// times a fixed number of operations and reports operations/s, µs per
+// operation and MB/s. Results are written as JSON Lines (one object per
+// benchmark) so runs against different transports or builds can simply
+// be concatenated; tests/loom_bench/bench_compare.py diffs two files.
+//
+// The DPI benchmarks need a DUT that exercises DPI and are driven by the
+// shell (it runs the emulation to completion); see tests/loom_bench.
+
+#pragma once
+
+#include "loom.h"
+#include "loom_snapshot.pb.h"
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace loom {
+
+struct BenchResult {
+    std::string name;       // e.g. "mmio_read", "scan_capture", "dpi_bench_ping4"
+    uint64_t param = 0;     // size parameter (bits, words, args); 0 = none
+    uint64_t ops = 0;       // operations timed
+    uint64_t bytes = 0;     // payload moved by all of them
+    double seconds = 0.0;
+
+    double ops_per_s() const { return seconds > 0 ? static_cast<double>(ops) / seconds : 0.0; }
+    double us_per_op() const { return ops ? seconds * 1e6 / static_cast<double>(ops) : 0.0; }
+    double mb_per_s() const { return seconds > 0 ? static_cast<double>(bytes) / seconds / 1e6 : 0.0; }
+};
+
+// Single-register reads and writes, and 32-register read batches.
+// Writes go to IRQ_ENABLE with its current value.
+Result<std::vector<BenchResult>> bench_mmio(Context& ctx, uint32_t n);
+
+// Full scan capture (capture + read out) and restore of the same image,
+// `reps` times each. The emulation must not be running.
+Result<std::vector<BenchResult>> bench_scan(Context& ctx, uint32_t reps);
+
+// Dump and re-preload every memory in `mem_map`, `reps` times each.
+// Contents are written back unchanged.
+Result<std::vector<BenchResult>> bench_mem(Context& ctx, const MemMap& mem_map, uint32_t reps);
+
+// One JSON object per result and line; `label` names the transport/setup
+void write_bench_json(std::ostream& os, const std::vector<BenchResult>& results,
+                      const std::string& label);
+
+} // namespace loom
@@ -0,0 +1,191 @@
+// SPDX-License-Identifier: Apache-2.0
+// Loom Functional Coverage Implementation
+
+#include "loom_coverage.h"
+#include "loom_log.h"
+#include "loom_scan_decode.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+
+namespace loom {
+
+namespace {
+
+Logger logger = make_logger("coverage");
+
+constexpr std::string_view kCoverScope = ".loom_cover.";
+
+void write_json_string(std::ostream& os, const std::string& s) {
+    os << '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') os << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20) os << ' ';
+        else os << c;
+    }
+    os << '"';
+}
+
+std::string xml_escape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        switch (c) {
+        case '&': out += "&amp;"; break;
+        case '<': out += "&lt;"; break;
+        case '>': out += "&gt;"; break;
+        case '"': out += "&quot;"; break;
+        default: out += c;
+        }
+    }
+    return out;
+}
+
+// "file.sv:12.5-12.30" (first of several '|'-joined locations) -> file, line
+std::pair<std::string, uint32_t> split_src(const std::string& src) {
+    std::string first = src.substr(0, src.find('|'));
+    size_t colon = first.rfind(':');
+    if (colon == std::string::npos)
+        return {first, 0};
+    return {first.substr(0, colon),
+            static_cast<uint32_t>(std::strtoul(first.c_str() + colon + 1, nullptr, 10))};
+}
+
+Result<std::ofstream> open_out(const std::string& path) {
+    std::ofstream out(path);
+    if (!out) {
+        logger.error("Cannot open %s: %s", path.c_str(), std::strerror(errno));
+        return Error::InvalidArg;
+    }
+    return out;
+}
+
+} // namespace
+
+CoverageMap::CoverageMap(const ScanMap& map) {
+    // <top>.loom_cover.<label>.hits / .first, in the order loom_instrument
+    // built them
+    std::map<std::string, size_t> index;
+    for (const auto& var : map.variables()) {
+        const std::string& name = var.name();
+        size_t scope = name.find(kCoverScope);
+        size_t dot = name.rfind('.');
+        if (scope == std::string::npos || dot <= scope + kCoverScope.size())
+            continue;
+        std::string label = name.substr(scope + kCoverScope.size(), dot - scope - kCoverScope.size());
+        std::string field = name.substr(dot + 1);
+        if (field != "hits" && field != "first")
+            continue;
+
+        if (top_.empty())
+            top_ = name.substr(0, scope);
+        auto [it, added] = index.emplace(label, points_.size());
+        if (added)
+            points_.push_back({label, var.src()});
+        Point& p = points_[it->second];
+        if (field == "hits") {
+            p.hits_offset = var.offset();
+            p.hits_width = var.width();
+        } else {
+            p.first_offset = var.offset();
+            p.first_width = var.width();
+        }
+    }
+}
+
+std::vector<CoverPoint> CoverageMap::read(std::span<const uint32_t> scan) const {
+    std::vector<CoverPoint> out;
+    out.reserve(points_.size());
+    for (const auto& p : points_) {
+        CoverPoint cp;
+        cp.name = p.name;
+        cp.src = p.src;
+        if (p.hits_width > 0) {
+            cp.hits = low_bits(ScanDecoder::decode(scan, p.hits_offset, p.hits_width));
+            uint64_t all_ones = p.hits_width >= 64 ? ~uint64_t{0} : (uint64_t{1} << p.hits_width) - 1;
+            cp.saturated = cp.hits == all_ones;
+        }
+        if (p.first_width > 0 && cp.hits > 0)
+            cp.first = low_bits(ScanDecoder::decode(scan, p.first_offset, p.first_width));
+        out.push_back(std::move(cp));
+    }
+    return out;
+}
+
+Result<void> write_coverage_json(const std::string& path, std::span<const CoverPoint> points,
+                                 const std::string& design) {
+    auto f = open_out(path);
+    if (!f.ok()) return f.error();
+    auto& os = f.value();
+
+    size_t covered = 0;
+    for (const auto& p : points)
+        covered += p.hits > 0;
+
+    os << "{\"design\":";
+    write_json_string(os, design);
+    os << ",\"covered\":" << covered << ",\"total\":" << points.size() << ",\"points\":[";
+    for (size_t i = 0; i < points.size(); i++) {
+        const auto& p = points[i];
+        os << (i ? ",\n" : "\n") << "  {\"name\":";
+        write_json_string(os, p.name);
+        os << ",\"src\":";
+        write_json_string(os, p.src);
+        os << ",\"hits\":" << p.hits << ",\"saturated\":" << (p.saturated ? "true" : "false");
+        if (p.first)
+            os << ",\"first_cycle\":" << *p.first;
+        os << "}";
+    }
+    os << "\n]}\n";
+
+    if (!os) {
+        logger.error("Write to %s failed", path.c_str());
+        return Error::InvalidArg;
+    }
+    return {};
+}
+
+Result<void> write_coverage_ucis(const std::string& path, std::span<const CoverPoint> points,
+                                 const std::string& design) {
+    auto f = open_out(path);
+    if (!f.ok()) return f.error();
+    auto& os = f.value();
+
+    // Source files are referenced by id
+    std::map<std::string, size_t> files;
+    for (const auto& p : points)
+        files.emplace(split_src(p.src).first, files.size() + 1);
+
+    os << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+       << "<UCIS xmlns=\"http://www.accellera.org/XMLSchema/UCIS\" ucisVersion=\"1.0\""
+       << " writtenBy=\"loom\">\n";
+    for (const auto& [file, id] : files)
+        os << "  <sourceFiles fileName=\"" << xml_escape(file) << "\" id=\"" << id << "\"/>\n";
+    os << "  <historyNodes historyNodeId=\"0\" logicalName=\"" << xml_escape(design)
+       << "\" kind=\"test\" testStatus=\"true\" simtime=\"0\" timeunit=\"ns\""
+       << " toolCategory=\"emulation\"/>\n";
+    os << "  <instanceCoverages name=\"" << xml_escape(design) << "\" key=\"0\" moduleName=\""
+       << xml_escape(design) << "\">\n";
+    for (size_t i = 0; i < points.size(); i++) {
+        const auto& p = points[i];
+        auto [file, line] = split_src(p.src);
+        os << "    <assertionCoverage name=\"" << xml_escape(p.name) << "\" key=\"" << i
+           << "\" kind=\"cover\">\n"
+           << "      <id file=\"" << files[file] << "\" line=\"" << line << "\" inlineCount=\"1\"/>\n"
+           << "      <coverBin name=\"coveredBin\" key=\"0\" type=\"cover\">\n"
+           << "        <contents coverCount=\"" << p.hits << "\"/>\n"
+           << "      </coverBin>\n"
+           << "    </assertionCoverage>\n";
+    }
+    os << "  </instanceCoverages>\n</UCIS>\n";
+
+    if (!os) {
+        logger.error("Write to %s failed", path.c_str());
+        return Error::InvalidArg;
+    }
+    return {};
+}
+
+} // namespace loom
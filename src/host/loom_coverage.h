@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: Apache-2.0
+// Loom Functional Coverage
+//
+// loom_instrument turns every SystemVerilog cover property into a
+// saturating hit counter (and, with -cover_first, a first-hit cycle stamp)
+// that sits on the scan chain like any other register. This module finds
+// those counters in a ScanMap, reads them out of a scan image and writes
+// the result as JSON or as UCIS XML so regression tools can merge
+// coverage from emulation runs with simulation runs.
+//
+// Because the counters are plain scan state they are also present in
+// every snapshot and checkpoint, so coverage of a saved run can be
+// reported offline from its snapshot.
+
+#pragma once
+
+#include "loom.h"
+#include "loom_snapshot.pb.h"
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace loom {
+
+struct CoverPoint {
+    std::string name;               // HDL name of the cover property
+    std::string src;                // source location, "file:line.col-line.col"
+    uint64_t hits = 0;
+    bool saturated = false;         // counter stuck at all ones
+    std::optional<uint64_t> first;  // cycle of the first hit (-cover_first)
+};
+
+// Coverage counters of a design, located once from its scan map
+class CoverageMap {
+public:
+    CoverageMap() = default;
+    explicit CoverageMap(const ScanMap& map);
+
+    size_t size() const { return points_.size(); }
+    bool empty() const { return points_.empty(); }
+    const std::string& top() const { return top_; }   // module holding the counters
+
+    // Read every cover point from a scan image
+    std::vector<CoverPoint> read(std::span<const uint32_t> scan) const;
+
+private:
+    struct Point {
+        std::string name;
+        std::string src;
+        uint32_t hits_offset = 0;
+        uint32_t hits_width = 0;
+        uint32_t first_offset = 0;
+        uint32_t first_width = 0;   // 0 = no first-hit stamp
+    };
+    std::vector<Point> points_;
+    std::string top_;
+};
+
+Result<void> write_coverage_json(const std::string& path, std::span<const CoverPoint> points,
+                                 const std::string& design);
+// Subset of the UCIS XML interchange format: one instance, one
+// assertionCoverage (kind "cover") with a single bin per point
+Result<void> write_coverage_ucis(const std::string& path, std::span<const CoverPoint> points,
+                                 const std::string& design);
+
+} // namespace loom
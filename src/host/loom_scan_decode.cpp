@@ -0,0 +1,158 @@
+// SPDX-License-Identifier: Apache-2.0
+// Loom Scan Image Decoder Implementation
+
+#include "loom_scan_decode.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+
+namespace loom {
+
+ScanDecoder::ScanDecoder(const ScanMap& map) {
+    size_t n_words = 0;
+    for (const auto& var : map.variables())
+        n_words += (var.width() + 31) / 32;
+
+    src_.reserve(n_words);
+    shift_.reserve(n_words);
+    mask_.reserve(n_words);
+    first_word_.reserve(map.variables_size() + 1);
+    width_.reserve(map.variables_size());
+
+    for (const auto& var : map.variables()) {
+        first_word_.push_back(static_cast<uint32_t>(src_.size()));
+        width_.push_back(var.width());
+        for (uint32_t bit = 0; bit < var.width(); bit += 32) {
+            uint64_t pos = static_cast<uint64_t>(var.offset()) + bit;
+            uint32_t bits = std::min<uint32_t>(32, var.width() - bit);
+            src_.push_back(static_cast<uint32_t>(pos / 32));
+            shift_.push_back(static_cast<uint32_t>(pos % 32));
+            mask_.push_back(bits == 32 ? ~0u : (1u << bits) - 1);
+            scan_words_ = std::max<size_t>(scan_words_, pos / 32 + 2);
+        }
+    }
+    first_word_.push_back(static_cast<uint32_t>(src_.size()));
+}
+
+void ScanDecoder::decode_all(std::span<const uint32_t> scan,
+                             std::vector<uint32_t>& values) const {
+    // Every op reads src and src + 1: pad short images with zeros, which is
+    // also what bits past the end of the chain read as
+    std::vector<uint32_t> padded;
+    const uint32_t* s = scan.data();
+    if (scan.size() < scan_words_) {
+        padded.assign(scan.begin(), scan.end());
+        padded.resize(scan_words_, 0);
+        s = padded.data();
+    }
+
+    const size_t n = src_.size();
+    values.resize(n);
+    uint32_t* out = values.data();
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    const __m256i thirty_two = _mm256_set1_epi32(32);
+    for (; i + 8 <= n; i += 8) {
+        __m256i idx = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_.data() + i));
+        __m256i sh = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(shift_.data() + i));
+        __m256i mask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(mask_.data() + i));
+        __m256i lo = _mm256_i32gather_epi32(reinterpret_cast<const int*>(s), idx, 4);
+        __m256i hi = _mm256_i32gather_epi32(reinterpret_cast<const int*>(s + 1), idx, 4);
+        // Shift counts of 32 (shift == 0) yield 0, dropping the high word
+        __m256i v = _mm256_or_si256(_mm256_srlv_epi32(lo, sh),
+                                    _mm256_sllv_epi32(hi, _mm256_sub_epi32(thirty_two, sh)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_and_si256(v, mask));
+    }
+#endif
+
+    for (; i < n; i++) {
+        uint64_t w = s[src_[i]] | (static_cast<uint64_t>(s[src_[i] + 1]) << 32);
+        out[i] = static_cast<uint32_t>(w >> shift_[i]) & mask_[i];
+    }
+}
+
+std::vector<uint32_t> ScanDecoder::decode(std::span<const uint32_t> scan,
+                                          uint32_t offset, uint32_t width) {
+    std::vector<uint32_t> out((width + 31) / 32);
+    auto word = [&](uint64_t idx) { return idx < scan.size() ? scan[idx] : 0u; };
+    for (uint32_t bit = 0; bit < width; bit += 32) {
+        uint64_t pos = static_cast<uint64_t>(offset) + bit;
+        uint32_t bits = std::min<uint32_t>(32, width - bit);
+        uint64_t w = word(pos / 32) | (static_cast<uint64_t>(word(pos / 32 + 1)) << 32);
+        out[bit / 32] = static_cast<uint32_t>(w >> (pos % 32)) &
+                        (bits == 32 ? ~0u : (1u << bits) - 1);
+    }
+    return out;
+}
+
+std::vector<size_t> ScanDecoder::diff(std::span<const uint32_t> a,
+                                      std::span<const uint32_t> b) const {
+    std::vector<size_t> out;
+    if (diff_scan_words(a, b).empty())
+        return out;
+    std::vector<uint32_t> va, vb;
+    decode_all(a, va);
+    decode_all(b, vb);
+    for (size_t var = 0; var < n_variables(); var++) {
+        auto x = value(va, var);
+        if (!std::equal(x.begin(), x.end(), value(vb, var).begin()))
+            out.push_back(var);
+    }
+    return out;
+}
+
+std::vector<uint32_t> diff_scan_words(std::span<const uint32_t> a, std::span<const uint32_t> b) {
+    std::vector<uint32_t> out;
+    const size_t n = std::min(a.size(), b.size());
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_xor_si256(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a.data() + i)),
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b.data() + i)));
+        if (_mm256_testz_si256(x, x)) continue;
+        for (size_t j = i; j < i + 8; j++)
+            if (a[j] != b[j]) out.push_back(static_cast<uint32_t>(j));
+    }
+#endif
+
+    for (; i < n; i++)
+        if (a[i] != b[i]) out.push_back(static_cast<uint32_t>(i));
+    auto longer = a.size() > b.size() ? a : b;
+    for (; i < longer.size(); i++)
+        if (longer[i] != 0) out.push_back(static_cast<uint32_t>(i));
+    return out;
+}
+
+std::vector<uint32_t> unpack_words(std::string_view bytes) {
+    std::vector<uint32_t> words((bytes.size() + 3) / 4, 0);
+    for (size_t i = 0; i < bytes.size(); i++)
+        words[i / 4] |= static_cast<uint32_t>(static_cast<uint8_t>(bytes[i])) << ((i % 4) * 8);
+    return words;
+}
+
+std::string format_hex_words(std::span<const uint32_t> value, uint32_t width) {
+    static const char digits[] = "0123456789abcdef";
+    uint32_t n = std::max<uint32_t>(1, (width + 3) / 4);
+    std::string out = "0x";
+    out.reserve(n + 2);
+    for (uint32_t d = n; d-- > 0;) {
+        uint32_t word = d / 8 < value.size() ? value[d / 8] : 0;
+        out += digits[(word >> ((d % 8) * 4)) & 0xF];
+    }
+    return out;
+}
+
+uint64_t low_bits(std::span<const uint32_t> value) {
+    uint64_t v = value.empty() ? 0 : value[0];
+    if (value.size() > 1) v |= static_cast<uint64_t>(value[1]) << 32;
+    return v;
+}
+
+} // namespace loom
@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: Apache-2.0
+// Loom Scan Image Decoder
+//
+// Compiles a ScanMap into a flat extraction plan. Each 32-bit word of each
+// variable's value becomes one op: read two adjacent scan words, shift,
+// mask. Decoding a whole image is then a single linear pass over the ops
+// (8 at a time with AVX2 gathers when built for it), independent of how
+// many variables there are or how wide they get.
+//
+// Values come out as LE 32-bit words, (width + 31) / 32 per variable,
+// variables back to back in map order.
+
+#pragma once
+
+#include "loom_snapshot.pb.h"
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace loom {
+
+class ScanDecoder {
+public:
+    ScanDecoder() = default;
+    explicit ScanDecoder(const ScanMap& map);
+
+    size_t n_variables() const { return width_.size(); }
+    size_t n_value_words() const { return src_.size(); }
+    uint32_t width(size_t var) const { return width_[var]; }
+
+    // Decode every variable into `values` (resized to n_value_words())
+    void decode_all(std::span<const uint32_t> scan, std::vector<uint32_t>& values) const;
+
+    // Value of variable `var` within a decode_all() buffer
+    std::span<const uint32_t> value(std::span<const uint32_t> values, size_t var) const {
+        return values.subspan(first_word_[var], first_word_[var + 1] - first_word_[var]);
+    }
+
+    // Decode the variable at `offset` / `width` without a plan
+    static std::vector<uint32_t> decode(std::span<const uint32_t> scan,
+                                        uint32_t offset, uint32_t width);
+
+    // Variables (map indices) whose values differ between two images
+    std::vector<size_t> diff(std::span<const uint32_t> a, std::span<const uint32_t> b) const;
+
+private:
+    // Structure of arrays, one entry per value word
+    std::vector<uint32_t> src_;     // first scan word read
+    std::vector<uint32_t> shift_;   // bit position within it
+    std::vector<uint32_t> mask_;    // valid bits of the value word
+    std::vector<uint32_t> first_word_;  // per variable, plus an end sentinel
+    std::vector<uint32_t> width_;
+    size_t scan_words_ = 0;         // scan words read, including src + 1
+};
+
+// Indices of the words that differ between two scan images; words past
+// the end of the shorter one compare as zero. XORs 8 words at a time with
+// AVX2 when built for it, so images that agree cost one pass.
+std::vector<uint32_t> diff_scan_words(std::span<const uint32_t> a, std::span<const uint32_t> b);
+
+// LE bytes (raw_scan_data) to 32-bit words, zero-padding a partial last word
+std::vector<uint32_t> unpack_words(std::string_view bytes);
+
+// "0x" + (width + 3) / 4 hex digits
+std::string format_hex_words(std::span<const uint32_t> value, uint32_t width);
+
+// Low 64 bits of a decoded value
+uint64_t low_bits(std::span<const uint32_t> value);
+
+} // namespace loom
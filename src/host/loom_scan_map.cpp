@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: Apache-2.0
+// Loom Scan Map File Implementation
+
+#include "loom_scan_map.h"
+#include "loom_log.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <filesystem>
+
+namespace loom {
+
+static Logger logger = make_logger("scan_map");
+
+namespace {
+
+// Read-only private mapping of a whole file; false if it can't be opened
+bool map_file(const std::string& path, const char*& data, size_t& size) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+    data = nullptr;
+    size = 0;
+    if (st.st_size > 0) {
+        void* m = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m == MAP_FAILED) {
+            ::close(fd);
+            return false;
+        }
+        data = static_cast<const char*>(m);
+        size = st.st_size;
+    }
+    ::close(fd);
+    return true;
+}
+
+} // namespace
+
+Result<std::unique_ptr<ScanMapFile>> ScanMapFile::open(const std::string& path) {
+    std::unique_ptr<ScanMapFile> file(new ScanMapFile());
+    file->path_ = path;
+    if (!map_file(path, file->data_, file->size_)) {
+        logger.debug("No scan map at %s", path.c_str());
+        return Error::InvalidArg;
+    }
+    if (!file->parse()) {
+        logger.warning("Failed to parse scan map: %s", path.c_str());
+        return Error::Protocol;
+    }
+
+    // A stale or foreign index is ignored, not an error
+    std::string index_path = std::filesystem::path(path).replace_extension(".idx").string();
+    if (map_file(index_path, file->index_data_, file->index_size_)) {
+        if (file->index_.open(std::string_view(file->index_data_, file->index_size_),
+                              std::string_view(file->data_, file->size_))) {
+            file->n_variables_ = file->index_.size();
+        } else {
+            logger.warning("Ignoring scan map index %s: does not match %s",
+                           index_path.c_str(), path.c_str());
+        }
+    }
+    logger.debug("Mapped scan map %s: %zu variables, %u bits%s", path.c_str(),
+                 file->n_variables_, file->chain_length_,
+                 file->has_index() ? " (indexed)" : "");
+    return file;
+}
+
+ScanMapFile::~ScanMapFile() {
+    if (data_)
+        munmap(const_cast<char*>(data_), size_);
+    if (index_data_)
+        munmap(const_cast<char*>(index_data_), index_size_);
+}
+
+bool ScanMapFile::parse() {
+    WireReader r(std::string_view(data_, size_));
+    WireField f;
+    while (r.next(f)) {
+        switch (f.number) {
+        case 1:
+            if (f.type == 0) chain_length_ = static_cast<uint32_t>(f.varint);
+            break;
+        case 2:
+            // Counted here, decoded by parse_map() or find()
+            if (f.type == 2) n_variables_++;
+            break;
+        case 3:
+            if (f.type == 2) initial_scan_image_ = f.bytes;
+            break;
+        case 4:
+            if (f.type == 2) {
+                ResetDpiMapping m;
+                if (!m.ParseFromArray(f.bytes.data(), static_cast<int>(f.bytes.size())))
+                    return false;
+                reset_dpi_mappings_.push_back(std::move(m));
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    return !r.error();
+}
+
+std::optional<ScanVariable> ScanMapFile::find(std::string_view name) const {
+    if (index_.valid()) {
+        auto i = index_.find(name);
+        if (!i) return std::nullopt;
+        std::string_view rec = index_.record(*i);
+        ScanVariable var;
+        if (var.ParseFromArray(rec.data(), static_cast<int>(rec.size())))
+            return var;
+        logger.warning("Corrupt scan map index entry for %.*s",
+                       static_cast<int>(name.size()), name.data());
+    }
+    // Unindexed: walk the records, decoding only the name of each
+    WireReader r(std::string_view(data_, size_));
+    WireField f;
+    while (r.next(f)) {
+        if (f.number != 2 || f.type != 2 || encoded_name(f.bytes) != name) continue;
+        ScanVariable var;
+        if (var.ParseFromArray(f.bytes.data(), static_cast<int>(f.bytes.size())))
+            return var;
+        break;
+    }
+    return std::nullopt;
+}
+
+Result<ScanMap> ScanMapFile::parse_map() const {
+    ScanMap m;
+    if (!m.ParseFromArray(data_, static_cast<int>(size_))) {
+        logger.error("Corrupt scan map %s", path_.c_str());
+        return Error::Protocol;
+    }
+    logger.debug("Parsed scan map %s: %d variables", path_.c_str(), m.variables_size());
+    return m;
+}
+
+} // namespace loom
@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: Apache-2.0
+// Loom Scan Map File
+//
+// scan_map.pb, mapped rather than parsed. Opening walks only the top-level
+// fields the shell needs before the first command (chain geometry, the
+// initial scan image and the reset DPI mappings), skipping over the
+// variables. With the scan_map.idx companion written by scan_insert,
+// variable counts, offsets, widths and name lookups come from the index
+// without decoding anything. The full ScanMap is parsed only by callers
+// that list every variable by name (parse_map()).
+
+#pragma once
+
+#include "loom.h"
+#include "loom_map_index.h"
+#include "loom_snapshot.pb.h"
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace loom {
+
+class ScanMapFile {
+public:
+    // Map `path` and, if present and matching, `path` with .idx for .pb
+    static Result<std::unique_ptr<ScanMapFile>> open(const std::string& path);
+    ~ScanMapFile();
+
+    ScanMapFile(const ScanMapFile&) = delete;
+    ScanMapFile& operator=(const ScanMapFile&) = delete;
+
+    const std::string& path() const { return path_; }
+    bool has_index() const { return index_.valid(); }
+
+    uint32_t chain_length() const { return chain_length_; }
+    std::string_view initial_scan_image() const { return initial_scan_image_; }
+    const std::vector<ResetDpiMapping>& reset_dpi_mappings() const { return reset_dpi_mappings_; }
+    size_t n_variables() const { return n_variables_; }
+
+    // Variable named exactly `name`, decoding only its record when indexed
+    std::optional<ScanVariable> find(std::string_view name) const;
+
+    // Parse the whole map (not cached: the caller keeps it)
+    Result<ScanMap> parse_map() const;
+
+private:
+    ScanMapFile() = default;
+    bool parse();
+
+    std::string path_;
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    const char* index_data_ = nullptr;
+    size_t index_size_ = 0;
+    ScanMapIndex index_;
+
+    uint32_t chain_length_ = 0;
+    size_t n_variables_ = 0;
+    std::string_view initial_scan_image_;
+    std::vector<ResetDpiMapping> reset_dpi_mappings_;
+};
+
+} // namespace loom
@@ -3,6 +3,8 @@
 
 #include "loom_shell.h"
 #include "loom_log.h"
+#include "loom_snapshot.h"
+#include "sha256.h"
 
 #include <replxx.hxx>
 
@@ -12,6 +14,10 @@
 #include <cstdlib>
 #include <filesystem>
 #include <fstream>
+#include <future>
+#include <map>
+#include <mutex>
+#include <optional>
 #include <set>
 #include <sstream>
 #include <unistd.h>
@@ -24,12 +30,50 @@ static Logger logger = make_logger("shell");
 // SIGINT handling for the `run` command
 // ============================================================================
 
-static std::atomic<bool>* g_interrupted_flag = nullptr;
+// Several shells may be in `run` at once (loomx -farm runs one per board
+// thread); a SIGINT interrupts all of them. The handler is installed while
+// at least one is registered and only touches the lock-free slots.
+
+static constexpr int kMaxRunFlags = 64;
+static std::atomic<std::atomic<bool>*> g_interrupted_flags[kMaxRunFlags];
+static std::atomic<uint64_t> g_sigint_count{0};
+static std::mutex g_sigint_mutex;
+static int g_sigint_users = 0;
+static struct sigaction g_old_sigint{};
 
 static void sigint_handler(int) {
-    if (g_interrupted_flag) {
-        g_interrupted_flag->store(true);
+    g_sigint_count.fetch_add(1, std::memory_order_relaxed);
+    for (auto& slot : g_interrupted_flags) {
+        if (auto* flag = slot.load(std::memory_order_acquire)) flag->store(true);
+    }
+}
+
+static void register_interrupt_flag(std::atomic<bool>* flag) {
+    std::lock_guard<std::mutex> lock(g_sigint_mutex);
+    for (auto& slot : g_interrupted_flags) {
+        std::atomic<bool>* expected = nullptr;
+        if (slot.compare_exchange_strong(expected, flag)) break;
+    }
+    if (g_sigint_users++ == 0) {
+        struct sigaction sa{};
+        sa.sa_handler = sigint_handler;
+        sa.sa_flags = 0;
+        sigemptyset(&sa.sa_mask);
+        sigaction(SIGINT, &sa, &g_old_sigint);
+    }
+}
+
+static void unregister_interrupt_flag(std::atomic<bool>* flag) {
+    std::lock_guard<std::mutex> lock(g_sigint_mutex);
+    for (auto& slot : g_interrupted_flags) {
+        std::atomic<bool>* expected = flag;
+        if (slot.compare_exchange_strong(expected, nullptr)) break;
     }
+    if (--g_sigint_users == 0) sigaction(SIGINT, &g_old_sigint, nullptr);
+}
+
+uint64_t Shell::interrupt_count() {
+    return g_sigint_count.load(std::memory_order_relaxed);
 }
 
 // ============================================================================
@@ -46,6 +90,21 @@ static std::vector<std::string> tokenize(const std::string& line) {
     return tokens;
 }
 
+// ============================================================================
+// Design hash packing (Snapshot.design_hash: word 0 first, LE)
+// ============================================================================
+
+static std::string pack_design_hash(const std::array<uint32_t, 8>& hash) {
+    std::string out(hash.size() * 4, '\0');
+    for (size_t i = 0; i < hash.size(); i++) {
+        out[i * 4 + 0] = static_cast<char>((hash[i] >>  0) & 0xFF);
+        out[i * 4 + 1] = static_cast<char>((hash[i] >>  8) & 0xFF);
+        out[i * 4 + 2] = static_cast<char>((hash[i] >> 16) & 0xFF);
+        out[i * 4 + 3] = static_cast<char>((hash[i] >> 24) & 0xFF);
+    }
+    return out;
+}
+
 // ============================================================================
 // State name helper
 // ============================================================================
@@ -74,31 +133,79 @@ Shell::Shell(Context& ctx, DpiService& dpi_service)
 
 Shell::~Shell() {
     // Save history on destruction
-    rx_->history_save(history_path());
+    if (save_history_) rx_->history_save(history_path());
 }
 
 // ============================================================================
 // Scan Map Loading
 // ============================================================================
 
-void Shell::load_scan_map(const std::string& path) {
+bool Shell::read_scan_map(const std::string& path, ScanMap& map) {
     std::ifstream f(path, std::ios::binary);
     if (!f.is_open()) {
         logger.debug("No scan map at %s", path.c_str());
-        return;
+        return false;
     }
-
-    if (!scan_map_.ParseFromIstream(&f)) {
+    if (!map.ParseFromIstream(&f)) {
         logger.warning("Failed to parse scan map: %s", path.c_str());
-        return;
+        return false;
     }
+    return true;
+}
+
+void Shell::load_scan_map(const std::string& path) {
+    auto file = ScanMapFile::open(path);
+    if (!file.ok()) return;
+    scan_map_file_ = std::move(file.value());
+    scan_map_ = ScanMap();
+    scan_map_loaded_ = true;
+    scan_map_parsed_ = false;
+    logger.debug("Loaded scan map: %zu variables, %u bits%s",
+                 scan_map_file_->n_variables(), scan_map_file_->chain_length(),
+                 scan_map_file_->has_index() ? " (indexed)" : "");
+
+    set_initial_scan_image(scan_map_file_->initial_scan_image());
+    reset_dpi_mappings_.clear();
+    for (const auto& m : scan_map_file_->reset_dpi_mappings())
+        reset_dpi_mappings_.push_back({m.func_id(), m.scan_offset(), m.scan_width()});
+}
 
+void Shell::set_scan_map(const ScanMap& map) {
+    scan_map_file_.reset();
+    scan_map_ = map;
     scan_map_loaded_ = true;
+    scan_map_parsed_ = false;
     logger.debug("Loaded scan map: %d variables, %u bits",
                  scan_map_.variables_size(), scan_map_.chain_length());
 
-    // Unpack initial scan image if present
-    const auto& img = scan_map_.initial_scan_image();
+    set_initial_scan_image(scan_map_.initial_scan_image());
+
+    // Unpack reset DPI mappings
+    reset_dpi_mappings_.clear();
+    for (const auto& m : scan_map_.reset_dpi_mappings()) {
+        reset_dpi_mappings_.push_back({m.func_id(), m.scan_offset(), m.scan_width()});
+        logger.debug("Reset DPI mapping: func_id=%u scan[%u:%u]",
+                      m.func_id(), m.scan_offset(), m.scan_offset() + m.scan_width() - 1);
+    }
+}
+
+const ScanMap& Shell::scan_map() {
+    if (scan_map_parsed_)
+        return scan_map_;
+    if (scan_map_file_) {
+        auto map = scan_map_file_->parse_map();
+        if (map.ok())
+            scan_map_ = std::move(map.value());
+    }
+    scan_decoder_ = ScanDecoder(scan_map_);
+    coverage_ = CoverageMap(scan_map_);
+    scan_map_parsed_ = true;
+    return scan_map_;
+}
+
+// Unpack initial scan image (LE bytes) if present
+void Shell::set_initial_scan_image(std::string_view img) {
+    has_initial_image_ = false;
     if (!img.empty()) {
         size_t n_words = img.size() / 4;
         initial_scan_image_.resize(n_words);
@@ -112,13 +219,43 @@ void Shell::load_scan_map(const std::string& path) {
         has_initial_image_ = true;
         logger.debug("Initial scan image: %zu words", n_words);
     }
+}
 
-    // Unpack reset DPI mappings
-    for (const auto& m : scan_map_.reset_dpi_mappings()) {
-        reset_dpi_mappings_.push_back({m.func_id(), m.scan_offset(), m.scan_width()});
-        logger.debug("Reset DPI mapping: func_id=%u scan[%u:%u]",
-                      m.func_id(), m.scan_offset(), m.scan_offset() + m.scan_width() - 1);
+bool Shell::read_trace_map(const std::string& path, ScanMap& map) {
+    std::ifstream f(path, std::ios::binary);
+    if (!f.is_open()) {
+        logger.debug("No trace map at %s", path.c_str());
+        return false;
     }
+    if (!map.ParseFromIstream(&f)) {
+        logger.warning("Failed to parse trace map: %s", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+void Shell::load_trace_map(const std::string& path) {
+    ScanMap map;
+    if (read_trace_map(path, map)) set_trace_map(map);
+}
+
+void Shell::set_trace_map(const ScanMap& map) {
+    trace_map_ = map;
+    trace_map_loaded_ = true;
+    logger.debug("Loaded trace map: %d variables, %u bits",
+                 trace_map_.variables_size(), trace_map_.chain_length());
+}
+
+void Shell::load_watch_map(const std::string& path) {
+    ScanMap map;
+    if (read_trace_map(path, map)) set_watch_map(map);
+}
+
+void Shell::set_watch_map(const ScanMap& map) {
+    watch_map_ = map;
+    watch_map_loaded_ = true;
+    logger.debug("Loaded watch map: %d variables, %u bits",
+                 watch_map_.variables_size(), watch_map_.chain_length());
 }
 
 // ============================================================================
@@ -126,40 +263,113 @@ void Shell::load_scan_map(const std::string& path) {
 // ============================================================================
 
 void Shell::load_mem_map(const std::string& path) {
+    MemMap map;
+    if (read_mem_map(path, map)) set_mem_map(map);
+}
+
+void Shell::set_mem_map(const MemMap& map) {
+    mem_map_ = map;
+    mem_map_loaded_ = true;
+    mem_mirror_valid_ = false;
+    logger.debug("Loaded mem map: %d memories, %u bytes addr space",
+                 mem_map_.num_memories(), mem_map_.total_bytes());
+}
+
+bool Shell::read_mem_map(const std::string& path, MemMap& map) {
     std::ifstream f(path, std::ios::binary);
     if (!f.is_open()) {
         logger.debug("No mem map at %s", path.c_str());
-        return;
+        return false;
     }
 
-    if (!mem_map_.ParseFromIstream(&f)) {
+    if (!map.ParseFromIstream(&f)) {
         logger.warning("Failed to parse mem map: %s", path.c_str());
-        return;
+        return false;
     }
 
-    mem_map_loaded_ = true;
-    logger.debug("Loaded mem map: %d memories, %u bytes addr space",
-                 mem_map_.num_memories(), mem_map_.total_bytes());
-
-    // For each memory with init_file, resolve and parse the file
-    for (int i = 0; i < mem_map_.memories_size(); i++) {
-        auto* entry = mem_map_.mutable_memories(i);
+    // Parse every init_file into initial_content, one task per file.
+    // Parsed images are cached next to the mem map.
+    std::string cache_dir = (std::filesystem::path(path).parent_path() / "init_cache").string();
+    struct Parsed {
+        std::string content;
+        bool cached = false;
+    };
+    std::vector<std::pair<MemoryEntry*, std::future<Parsed>>> tasks;
+    for (int i = 0; i < map.memories_size(); i++) {
+        auto* entry = map.mutable_memories(i);
         if (entry->init_file().empty())
             continue;
+        tasks.emplace_back(entry, std::async(std::launch::async, [entry, &cache_dir] {
+            Parsed p;
+            p.content = load_init_file(*entry, cache_dir, p.cached);
+            return p;
+        }));
+    }
+
+    for (auto& [entry, task] : tasks) {
+        Parsed p = task.get();
+        if (p.content.empty())
+            continue;
+        logger.debug("%s %s: %zu bytes for memory %s", p.cached ? "Cached" : "Parsed",
+                     entry->init_file().c_str(), p.content.size(), entry->name().c_str());
+        entry->set_initial_content(std::move(p.content));
+    }
+    return true;
+}
 
-        // Parse the memory file into initial_content
-        auto content = entry->init_file_hex()
-            ? parse_readmemh(entry->init_file(), entry->width(), entry->depth())
-            : parse_readmemb(entry->init_file(), entry->width(), entry->depth());
+std::string Shell::load_init_file(const MemoryEntry& entry, const std::string& cache_dir,
+                                  bool& cached) {
+    cached = false;
+    std::string key;
+    std::filesystem::path cache_path;
+    if (!cache_dir.empty()) {
+        std::ifstream f(entry.init_file(), std::ios::binary);
+        if (f.is_open()) {
+            std::ostringstream text;
+            text << f.rdbuf();
+            // The image depends on the file and on how it is parsed
+            key = text.str();
+            key += entry.init_file_hex() ? "\nhex " : "\nbin ";
+            key += std::to_string(entry.width()) + "x" + std::to_string(entry.depth());
+            cache_path = std::filesystem::path(cache_dir) /
+                         (sha256_hex(sha256(key)).substr(0, 32) + ".bin");
+
+            size_t expected = static_cast<size_t>(entry.depth()) * ((entry.width() + 7) / 8);
+            std::ifstream hit(cache_path, std::ios::binary);
+            if (hit.is_open()) {
+                std::string image(expected, '\0');
+                if (hit.read(image.data(), static_cast<std::streamsize>(expected)) &&
+                    hit.peek() == std::char_traits<char>::eof()) {
+                    cached = true;
+                    return image;
+                }
+            }
+        }
+    }
 
-        if (!content.empty()) {
-            entry->set_initial_content(
-                std::string(content.begin(), content.end()));
-            logger.debug("Parsed %s: %zu bytes for memory %s",
-                         entry->init_file().c_str(), content.size(),
-                         entry->name().c_str());
+    auto content = entry.init_file_hex()
+        ? parse_readmemh(entry.init_file(), entry.width(), entry.depth())
+        : parse_readmemb(entry.init_file(), entry.width(), entry.depth());
+    std::string image(content.begin(), content.end());
+
+    // Write-then-rename so concurrent launches never see a partial image
+    if (!image.empty() && !cache_path.empty()) {
+        std::error_code ec;
+        std::filesystem::create_directories(cache_dir, ec);
+        auto tmp = cache_path;
+        tmp += ".tmp." + std::to_string(getpid());
+        bool written;
+        {
+            std::ofstream out(tmp, std::ios::binary);
+            out.write(image.data(), static_cast<std::streamsize>(image.size()));
+            written = static_cast<bool>(out);
         }
+        if (written)
+            std::filesystem::rename(tmp, cache_path, ec);
+        if (!written || ec)
+            std::filesystem::remove(tmp, ec);
     }
+    return image;
 }
 
 std::vector<uint8_t> Shell::parse_readmemh(const std::string& path, int width, int depth) {
@@ -263,8 +473,7 @@ void Shell::apply_initial_state() {
     }
     if (has_initial_image_ && !initial_image_applied_) {
         logger.info("Scanning in initial state...");
-        ctx_.scan_write_data(initial_scan_image_);
-        ctx_.scan_restore();
+        scan_in_initial_image();
         initial_image_applied_ = true;
     }
     // Memory preload
@@ -280,88 +489,371 @@ void Shell::preload_memories() {
         if (entry.initial_content().empty())
             continue;
 
-        const auto& content = entry.initial_content();
-        int bytes_per_entry = (entry.width() + 7) / 8;
-        int words_per_entry = (entry.width() + 31) / 32;
-
         logger.info("Preloading memory %s (%u entries)...",
                     entry.name().c_str(), entry.depth());
+        if (!preload_memory(entry, entry.initial_content(), (entry.width() + 7) / 8))
+            return;
+        preloaded++;
+    }
+
+    mem_preloaded_ = true;
+    if (preloaded > 0)
+        logger.info("Preloaded %d memory/memories", preloaded);
+}
+
+bool Shell::preload_memory(const MemoryEntry& entry, std::string_view content,
+                           size_t stride) {
+    if (ctx_.mem_has_bulk_write())
+        return preload_memory_bulk(entry, content, stride);
+
+    int words_per_entry = (entry.width() + 31) / 32;
+    size_t bytes_per_entry = std::min(stride, static_cast<size_t>(words_per_entry) * 4);
+
+    // Use bulk preload: CMD_PRELOAD_START for first entry, CMD_PRELOAD_NEXT for rest
+    std::vector<uint32_t> data(words_per_entry);
+    for (uint32_t a = 0; a < entry.depth(); a++) {
+        // Pack entry into 32-bit words
+        std::fill(data.begin(), data.end(), 0);
+        size_t content_offset = static_cast<size_t>(a) * stride;
+        for (size_t b = 0; b < bytes_per_entry && content_offset + b < content.size(); b++) {
+            data[b / 4] |= static_cast<uint32_t>(
+                static_cast<uint8_t>(content[content_offset + b])) << ((b % 4) * 8);
+        }
 
-        // Use bulk preload: CMD_PRELOAD_START for first entry, CMD_PRELOAD_NEXT for rest
-        for (uint32_t a = 0; a < entry.depth(); a++) {
-            // Pack entry into 32-bit words
-            std::vector<uint32_t> data(words_per_entry, 0);
-            int content_offset = a * bytes_per_entry;
-            for (int b = 0; b < bytes_per_entry && content_offset + b < static_cast<int>(content.size()); b++) {
-                data[b / 4] |= static_cast<uint32_t>(
-                    static_cast<uint8_t>(content[content_offset + b])) << ((b % 4) * 8);
+        if (a == 0) {
+            uint32_t global_addr = entry.base_addr();
+            auto rc = ctx_.mem_preload_start(global_addr, data);
+            if (!rc.ok()) {
+                logger.error("Memory preload failed for %s at addr 0x%x",
+                            entry.name().c_str(), global_addr);
+                return false;
+            }
+        } else {
+            auto rc = ctx_.mem_preload_next(data);
+            if (!rc.ok()) {
+                logger.error("Memory preload next failed for %s at entry %u",
+                            entry.name().c_str(), a);
+                return false;
             }
+        }
+    }
+    return true;
+}
 
-            if (a == 0) {
-                uint32_t global_addr = entry.base_addr();
-                auto rc = ctx_.mem_preload_start(global_addr, data);
-                if (!rc.ok()) {
-                    logger.error("Memory preload failed for %s at addr 0x%x",
-                                entry.name().c_str(), global_addr);
-                    return;
-                }
-            } else {
-                auto rc = ctx_.mem_preload_next(data);
-                if (!rc.ok()) {
-                    logger.error("Memory preload next failed for %s at entry %u",
-                                entry.name().c_str(), a);
-                    return;
-                }
+// Runs of at least this many identical entries are filled in hardware
+// rather than streamed
+static constexpr uint32_t kPreloadFillRun = 32;
+
+bool Shell::preload_memory_bulk(const MemoryEntry& entry, std::string_view content,
+                                size_t stride) {
+    const uint32_t wpe = (entry.width() + 31) / 32;
+    const size_t bytes_per_entry = std::min(stride, static_cast<size_t>(wpe) * 4);
+    const uint32_t depth = entry.depth();
+
+    std::vector<uint32_t> words(static_cast<size_t>(depth) * wpe, 0);
+    for (uint32_t a = 0; a < depth; a++) {
+        size_t content_offset = static_cast<size_t>(a) * stride;
+        uint32_t* data = &words[static_cast<size_t>(a) * wpe];
+        for (size_t b = 0; b < bytes_per_entry && content_offset + b < content.size(); b++) {
+            data[b / 4] |= static_cast<uint32_t>(
+                static_cast<uint8_t>(content[content_offset + b])) << ((b % 4) * 8);
+        }
+    }
+
+    auto at = [&](uint32_t a) { return std::span<const uint32_t>(words).subspan(
+                                    static_cast<size_t>(a) * wpe, wpe); };
+    auto stream = [&](uint32_t begin, uint32_t end) {
+        if (begin == end) return true;
+        auto rc = ctx_.mem_write_range(entry.base_addr() + begin * 4,
+                                       std::span<const uint32_t>(words).subspan(
+                                           static_cast<size_t>(begin) * wpe,
+                                           static_cast<size_t>(end - begin) * wpe),
+                                       static_cast<int>(wpe));
+        if (!rc.ok()) {
+            logger.error("Memory preload failed for %s at entry %u", entry.name().c_str(), begin);
+            return false;
+        }
+        return true;
+    };
+
+    // Long runs of one value (zeroed BSS, padding, erased flash) become a
+    // single fill; everything between them is streamed
+    uint32_t streamed_from = 0;
+    uint32_t filled = 0;
+    for (uint32_t a = 0; a < depth;) {
+        uint32_t end = a + 1;
+        while (end < depth && std::equal(at(a).begin(), at(a).end(), at(end).begin()))
+            end++;
+        if (end - a >= kPreloadFillRun) {
+            if (!stream(streamed_from, a)) return false;
+            auto rc = ctx_.mem_fill(entry.base_addr() + a * 4, at(a), end - a);
+            if (!rc.ok()) {
+                logger.error("Memory fill failed for %s at entry %u", entry.name().c_str(), a);
+                return false;
             }
+            filled += end - a;
+            streamed_from = end;
         }
-        preloaded++;
+        a = end;
     }
+    if (!stream(streamed_from, depth)) return false;
 
-    mem_preloaded_ = true;
-    if (preloaded > 0)
-        logger.info("Preloaded %d memory/memories", preloaded);
+    logger.debug("Preloaded %s: %u entries streamed, %u filled",
+                 entry.name().c_str(), depth - filled, filled);
+    return true;
 }
 
 // ============================================================================
-// Value Extraction
+// Machine State Capture / Restore
 // ============================================================================
+//
+// Memory contents use the Snapshot raw_mem_data layout: memories in map
+// order, each entry padded to whole 32-bit words, words packed LE.
+
+static size_t raw_mem_size(const MemMap& map) {
+    size_t total = 0;
+    for (const auto& entry : map.memories())
+        total += static_cast<size_t>(entry.depth()) * ((entry.width() + 31) / 32) * 4;
+    return total;
+}
+
+// Runs [begin, end) of entries of `entry` lying on dirty pages, with runs of
+// adjacent dirty pages merged (entries are 4 address bytes apart)
+static std::vector<std::pair<uint32_t, uint32_t>> dirty_runs(const MemoryEntry& entry,
+                                                             const std::vector<uint32_t>& dirty,
+                                                             uint32_t page) {
+    auto is_dirty = [&](uint32_t addr) {
+        uint32_t p = addr / page;
+        return p / 32 < dirty.size() && ((dirty[p / 32] >> (p % 32)) & 1);
+    };
+    // First entry past the page holding entry `a`
+    auto page_end = [&](uint32_t a) {
+        uint64_t addr = entry.base_addr() + 4ull * a;
+        uint64_t next = (addr / page + 1) * page;
+        return static_cast<uint32_t>(std::min<uint64_t>(entry.depth(), a + (next - addr + 3) / 4));
+    };
+
+    std::vector<std::pair<uint32_t, uint32_t>> runs;
+    for (uint32_t a = 0; a < entry.depth();) {
+        uint32_t end = page_end(a);
+        if (is_dirty(entry.base_addr() + a * 4)) {
+            while (end < entry.depth() && is_dirty(entry.base_addr() + end * 4))
+                end = page_end(end);
+            runs.emplace_back(a, end);
+        }
+        a = end;
+    }
+    return runs;
+}
 
-uint64_t Shell::extract_variable(const std::vector<uint32_t>& raw,
-                                 uint32_t offset, uint32_t width) {
-    uint64_t value = 0;
-    for (uint32_t i = 0; i < width && i < 64; i++) {
-        uint32_t chain_pos = offset + i;
-        uint32_t word_idx = chain_pos / 32;
-        uint32_t bit_in_word = chain_pos % 32;
-        if (word_idx < raw.size() && ((raw[word_idx] >> bit_in_word) & 1)) {
-            value |= uint64_t(1) << i;
+// With dirty page tracking, mem_mirror_ holds the memory contents as of the
+// last bitmap clear; only pages dirtied since then are read back. Host
+// shadow writes mark pages dirty too, so the mirror stays exact across
+// preload, loadmem and restore.
+bool Shell::read_memories(std::string& raw) {
+    const uint32_t page = ctx_.mem_page_bytes();
+    std::vector<uint32_t> dirty;
+    if (page > 0 && mem_mirror_valid_) {
+        auto bitmap = ctx_.mem_dirty_pages();
+        if (bitmap.ok())
+            dirty = std::move(bitmap.value());
+    }
+    const bool sparse = !dirty.empty();
+    if (!sparse)
+        mem_mirror_.assign(raw_mem_size(mem_map_), '\0');
+
+    bool ok = true;
+    size_t offset = 0;
+    size_t read_entries = 0, total_entries = 0;
+    for (const auto& entry : mem_map_.memories()) {
+        int words_per_entry = (entry.width() + 31) / 32;
+        size_t stride = static_cast<size_t>(words_per_entry) * 4;
+        total_entries += entry.depth();
+
+        auto runs = sparse ? dirty_runs(entry, dirty, page)
+                           : std::vector<std::pair<uint32_t, uint32_t>>{{0, entry.depth()}};
+        for (auto [a, end] : runs) {
+            auto mem_data = ctx_.mem_read_range(entry.base_addr() + a * 4, end - a,
+                                                words_per_entry);
+            if (!mem_data.ok()) {
+                logger.error("Memory read failed for %s", entry.name().c_str());
+                std::fill_n(mem_mirror_.begin() + offset + a * stride, (end - a) * stride, '\0');
+                ok = false;
+            } else {
+                char* out = mem_mirror_.data() + offset + a * stride;
+                for (uint32_t word : mem_data.value()) {
+                    *out++ = static_cast<char>((word >>  0) & 0xFF);
+                    *out++ = static_cast<char>((word >>  8) & 0xFF);
+                    *out++ = static_cast<char>((word >> 16) & 0xFF);
+                    *out++ = static_cast<char>((word >> 24) & 0xFF);
+                }
+            }
+            read_entries += end - a;
+        }
+        offset += static_cast<size_t>(entry.depth()) * stride;
+    }
+
+    // Frozen, so nothing can dirty a page between the reads and the clear
+    mem_mirror_valid_ = ok && page > 0 && ctx_.mem_dirty_clear().ok();
+    if (sparse)
+        logger.debug("Read %zu of %zu memory entries (dirty pages only)",
+                     read_entries, total_entries);
+
+    raw = mem_mirror_;
+    return ok;
+}
+
+bool Shell::write_memories(const MemMap& map, std::string_view raw,
+                           const std::vector<uint32_t>* dirty) {
+    if (raw.size() != raw_mem_size(map)) {
+        logger.error("Memory data is %zu bytes, memory map expects %zu",
+                     raw.size(), raw_mem_size(map));
+        return false;
+    }
+    size_t offset = 0;
+    size_t written = 0, total = 0;
+    for (const auto& entry : map.memories()) {
+        size_t stride = static_cast<size_t>((entry.width() + 31) / 32) * 4;
+        size_t bytes = static_cast<size_t>(entry.depth()) * stride;
+        total += entry.depth();
+        if (!dirty) {
+            if (!preload_memory(entry, raw.substr(offset, bytes), stride))
+                return false;
+            written += entry.depth();
+        } else {
+            // Only the dirty runs, each preloaded as a memory of its own
+            for (auto [a, end] : dirty_runs(entry, *dirty, ctx_.mem_page_bytes())) {
+                MemoryEntry run;
+                run.set_name(entry.name());
+                run.set_width(entry.width());
+                run.set_depth(end - a);
+                run.set_base_addr(entry.base_addr() + a * 4);
+                if (!preload_memory(run, raw.substr(offset + a * stride, (end - a) * stride),
+                                    stride))
+                    return false;
+                written += end - a;
+            }
         }
+        offset += bytes;
     }
-    return value;
+    if (dirty)
+        logger.debug("Wrote %zu of %zu memory entries (dirty pages only)", written, total);
+    return true;
 }
 
-std::string Shell::format_hex(uint64_t value, uint32_t width) {
-    // Number of hex digits needed
-    int hex_digits = (width + 3) / 4;
-    if (hex_digits < 1) hex_digits = 1;
+bool Shell::capture_checkpoint(Checkpoint& cp) {
+    auto st = ctx_.get_state();
+    if (st.ok() && st.value() == State::Running)
+        ctx_.stop();
 
-    char buf[32];
-    if (width <= 32) {
-        std::snprintf(buf, sizeof(buf), "0x%0*x", hex_digits,
-                      static_cast<uint32_t>(value));
-    } else {
-        std::snprintf(buf, sizeof(buf), "0x%0*llx", hex_digits,
-                      static_cast<unsigned long long>(value));
+    auto cycles = ctx_.get_cycle_count();
+    auto time_val = ctx_.get_time();
+    if (!cycles.ok() || !time_val.ok()) {
+        logger.error("Failed to read cycle/time counters");
+        return false;
+    }
+    cp.cycle_count = cycles.value();
+    cp.dut_time = time_val.value();
+
+    cp.scan.clear();
+    if (ctx_.scan_chain_length() > 0) {
+        auto data = ctx_.scan_capture_image(5000);
+        if (!data.ok()) {
+            logger.error("Scan capture failed");
+            return false;
+        }
+        cp.scan = std::move(data.value());
+    }
+
+    cp.mem.clear();
+    if (mem_map_loaded_ && ctx_.n_memories() > 0 && !read_memories(cp.mem))
+        return false;
+    return true;
+}
+
+bool Shell::restore_checkpoint(const Checkpoint& cp, const MemMap& map, bool mem_delta) {
+    auto st = ctx_.get_state();
+    if (!st.ok()) {
+        logger.error("Failed to get state");
+        return false;
+    }
+
+    // Counters only accept writes while frozen.  From Idle, start with
+    // time_cmp = 0 so emu_ctrl drops straight to Frozen without clocking
+    // the DUT.
+    if (st.value() == State::Running) {
+        ctx_.stop();
+    } else if (st.value() == State::Idle) {
+        ctx_.couple();
+        if (!ctx_.set_time_compare(0).ok() || !ctx_.start().ok()) {
+            logger.error("Failed to leave Idle for restore");
+            return false;
+        }
+    }
+    for (int i = 0; i < 100; i++) {
+        st = ctx_.get_state();
+        if (!st.ok() || st.value() == State::Frozen) break;
+    }
+    if (!st.ok() || st.value() != State::Frozen) {
+        logger.error("Emulation did not freeze for restore");
+        return false;
     }
-    return buf;
+
+    if (!cp.scan.empty()) {
+        auto rc = ctx_.scan_restore_image(cp.scan);
+        if (!rc.ok()) {
+            logger.error("Scan restore failed");
+            return false;
+        }
+    }
+    // Delta: the memories hold cp.mem apart from pages dirtied since the
+    // last clear, so only those are written back
+    std::vector<uint32_t> dirty;
+    bool delta = false;
+    if (mem_delta && !cp.mem.empty() && ctx_.mem_page_bytes() > 0) {
+        auto bitmap = ctx_.mem_dirty_pages();
+        if (bitmap.ok()) {
+            dirty = std::move(bitmap.value());
+            delta = true;
+        }
+    }
+    if (!cp.mem.empty() && !write_memories(map, cp.mem, delta ? &dirty : nullptr))
+        return false;
+
+    // The restored image is the new clean baseline for dirty tracking
+    if (!cp.mem.empty() && ctx_.mem_page_bytes() > 0 &&
+        cp.mem.size() == raw_mem_size(mem_map_) && ctx_.mem_dirty_clear().ok()) {
+        mem_mirror_ = cp.mem;
+        mem_mirror_valid_ = true;
+    }
+
+    auto rc = ctx_.set_counters(cp.cycle_count, cp.dut_time);
+    if (!rc.ok()) {
+        logger.error("Failed to restore cycle/time counters");
+        return false;
+    }
+
+    // The restored state supersedes initial scan-in, reset DPI and preload
+    initial_dpi_executed_ = true;
+    initial_image_applied_ = true;
+    mem_preloaded_ = true;
+    return true;
 }
 
-std::string Shell::format_value(const ScanVariable& var, uint64_t value) {
-    for (const auto& mem : var.enum_members()) {
-        if (mem.value() == value)
-            return mem.name() + " (" + format_hex(value, var.width()) + ")";
+// ============================================================================
+// Value Extraction
+// ============================================================================
+
+std::string Shell::format_value(const ScanVariable& var, std::span<const uint32_t> value) {
+    std::string hex = format_hex_words(value, var.width());
+    if (var.width() <= 64) {
+        uint64_t v = low_bits(value);
+        for (const auto& mem : var.enum_members()) {
+            if (mem.value() == v)
+                return mem.name() + " (" + hex + ")";
+        }
     }
-    return format_hex(value, var.width());
+    return hex;
 }
 
 // ============================================================================
@@ -403,15 +895,153 @@ void Shell::register_commands() {
         "  Print emulation state, cycle count, design info, and DPI stats.",
         [this](const auto& args) { return cmd_status(args); }
     });
+    commands_.push_back({
+        "perf", {},
+        "Show host performance counters",
+        "Usage: perf [reset | -o <file.toml>]\n"
+        "  Print transport round trips, bytes and latency percentiles,\n"
+        "  per-DPI-function call counts, callback time and stall time, and\n"
+        "  the emu_ctrl stall counters with the effective emulation speed.\n"
+        "  reset       Zero all counters\n"
+        "  -o <file>   Write the counters as TOML instead",
+        [this](const auto& args) { return cmd_perf(args); }
+    });
+    commands_.push_back({
+        "bench", {},
+        "Run host <-> emulator benchmarks",
+        "Usage: bench <mmio|scan|mem|dpi|all> [-n <N>] [-label <L>] [-o <file.jsonl>]\n"
+        "  Time register access, scan capture/restore, memory dump/preload, or\n"
+        "  DPI round trips (runs the design to completion), and print ops/s,\n"
+        "  us per op and MB/s. scan and mem stop a running emulation.\n"
+        "  -n <N>       Register accesses, or scan/mem repetitions (default 10000 / 10)\n"
+        "  -label <L>   Transport/setup label recorded in the output (default \"default\")\n"
+        "  -o <file>    Append the results as JSON Lines",
+        [this](const auto& args) { return cmd_bench(args); }
+    });
     commands_.push_back({
         "dump", {"d"},
         "Capture and display scan chain",
-        "Usage: dump [<file.pb>]\n"
+        "Usage: dump [-z] [-delta | -base <base.pb>] [-nomap] [<file.pb>]\n"
         "  Stop emulation if running, perform scan capture, and display\n"
         "  the captured scan chain data with named variables.\n"
-        "  If a filename is given, serialize a Snapshot protobuf to that file.",
+        "  If a filename is given, serialize a Snapshot protobuf to that file.\n"
+        "  -z          zstd-compress scan and memory data\n"
+        "  -delta      Store only changes against the last full snapshot\n"
+        "              saved in this session\n"
+        "  -base <f>   Store only changes against snapshot <f>\n"
+        "  -nomap      Omit scan/memory maps; readers match them by design hash",
         [this](const auto& args) { return cmd_dump(args); }
     });
+    commands_.push_back({
+        "restore", {},
+        "Load a saved snapshot into hardware",
+        "Usage: restore <file.pb>\n"
+        "  Scan in the registers and write back the memories of a Snapshot\n"
+        "  protobuf saved by 'dump', then restore its cycle and DUT time.\n"
+        "  The snapshot must come from the same design (design hash).\n"
+        "  Emulation is left frozen; use 'run' or 'step' to continue.",
+        [this](const auto& args) { return cmd_restore(args); }
+    });
+    commands_.push_back({
+        "checkpoint", {"cp"},
+        "Take or configure in-memory checkpoints",
+        "Usage: checkpoint [every <N> [<depth>] | off | list | clear]\n"
+        "  (no args)            Capture a checkpoint now\n"
+        "  every <N> [<depth>]  Checkpoint every N time units during 'run',\n"
+        "                       keeping the newest <depth> (default 8)\n"
+        "  off                  Stop automatic checkpoints\n"
+        "  list                 Show checkpoints, newest first\n"
+        "  clear                Drop all checkpoints",
+        [this](const auto& args) { return cmd_checkpoint(args); }
+    });
+    commands_.push_back({
+        "rewind", {"rw"},
+        "Restore a recent checkpoint",
+        "Usage: rewind [N]\n"
+        "  Restore the N-th newest checkpoint (default 1 = newest) and drop\n"
+        "  the newer ones. Emulation is left frozen.",
+        [this](const auto& args) { return cmd_rewind(args); }
+    });
+    commands_.push_back({
+        "bisect", {},
+        "Find where this run diverges from reference snapshots",
+        "Usage: bisect [-n <N>] <ref.pb|dir>...\n"
+        "  Reference snapshots come from another run of the same design\n"
+        "  (e.g. Verilator, or a run with different stimulus), given as files\n"
+        "  or directories of .pb files. Starting from the earliest, restore and\n"
+        "  step the hardware to binary-search the last reference it still\n"
+        "  matches and the first it does not, then list the variables that\n"
+        "  differ there. Emulation is left frozen at the last matching state.\n"
+        "  -n <N>   Show at most N differing variables (default 20)",
+        [this](const auto& args) { return cmd_bisect(args); }
+    });
+    commands_.push_back({
+        "wave", {"w"},
+        "Trace variables to a VCD waveform",
+        "Usage: wave [<file.vcd> [every <N>] [var...] | sample | off]\n"
+        "  <file.vcd> [var...]  Start tracing all variables (or those starting\n"
+        "                       with each var) to file\n"
+        "  every <N>            Sample every N time units during 'run'; without\n"
+        "                       it, sample whenever 'run' or 'step' stops\n"
+        "  sample               Capture a sample now\n"
+        "  off                  Stop tracing and close the file\n"
+        "  (no args)            Show tracing status",
+        [this](const auto& args) { return cmd_wave(args); }
+    });
+    commands_.push_back({
+        "trace", {"tr"},
+        "Record registers every cycle with the hardware trace buffer",
+        "Usage: trace [<file.vcd> [-trig <var>=<value>] [-post <N>] [-stall] [var...] | off]\n"
+        "  <file.vcd> [var...]  Arm the trace buffer and write the traced\n"
+        "                       registers (or those starting with each var) to\n"
+        "                       file while 'run' or 'step' executes; times are\n"
+        "                       DUT cycles\n"
+        "  -trig <var>=<value>  Start recording when the traced register equals\n"
+        "                       value (registers up to 32 bits)\n"
+        "  -post <N>            Record N cycles from the trigger, then stop\n"
+        "  -stall               Hold the DUT while the buffer is full instead\n"
+        "                       of dropping cycles\n"
+        "  off                  Stop recording, drain and close the file\n"
+        "  (no args)            Show trace status\n"
+        "  Requires a design built with loomc -trace.",
+        [this](const auto& args) { return cmd_trace(args); }
+    });
+    commands_.push_back({
+        "break", {"b"},
+        "Freeze emulation in hardware when a watched register matches",
+        "Usage: break [[-enter] [-mask <M>] <var> <value> | delete <N> | clear | -and | -or]\n"
+        "  <var> <value>  Freeze on the cycle the watched register equals value,\n"
+        "                 before the DUT advances; 'run' and 'step' report the hit\n"
+        "  -enter         Only on the cycle it becomes equal\n"
+        "  -mask <M>      Compare only the bits set in M\n"
+        "  delete <N>     Remove breakpoint N\n"
+        "  clear          Remove all breakpoints\n"
+        "  -and | -or     Freeze when all / any (default) breakpoints match\n"
+        "  (no args)      List breakpoints\n"
+        "  Registers up to 32 bits; requires a design built with loomc -watch.",
+        [this](const auto& args) { return cmd_break(args); }
+    });
+    commands_.push_back({
+        "watch", {},
+        "Freeze emulation in hardware when a watched register changes",
+        "Usage: watch [-mask <M>] <var>\n"
+        "  Add a breakpoint that freezes the DUT on the first cycle the\n"
+        "  register (or the bits set in M) differs from the cycle before.\n"
+        "  List and remove it with 'break'.",
+        [this](const auto& args) { return cmd_watch(args); }
+    });
+    commands_.push_back({
+        "coverage", {"cov"},
+        "Report SystemVerilog cover property hits",
+        "Usage: coverage [-missed] [-json <file>] [-ucis <file>]\n"
+        "  Stop emulation if running, scan out the cover counters and print\n"
+        "  each cover property's hit count (and first-hit cycle when built\n"
+        "  with loomc -cover-first).\n"
+        "  -missed       List only covers that were never hit\n"
+        "  -json <file>  Also write the counts as JSON\n"
+        "  -ucis <file>  Also write them as UCIS XML for coverage merging",
+        [this](const auto& args) { return cmd_coverage(args); }
+    });
     commands_.push_back({
         "reset", {},
         "Assert DUT reset",
@@ -438,9 +1068,11 @@ void Shell::register_commands() {
     commands_.push_back({
         "inspect", {},
         "Inspect a saved snapshot",
-        "Usage: inspect <file.pb> [<var>]\n"
-        "  Load a Snapshot protobuf and display metadata + variable values.\n"
-        "  If <var> is given, filter variables by name prefix.",
+        "Usage: inspect <file.pb> [<var>...]\n"
+        "  Display snapshot metadata + variable values.\n"
+        "  With <var> arguments, show only variables starting with each\n"
+        "  name (memories are skipped); the file is memory-mapped and only\n"
+        "  the matching entries are decoded.",
         [this](const auto& args) { return cmd_inspect(args); }
     });
     commands_.push_back({
@@ -489,11 +1121,14 @@ void Shell::register_commands() {
     commands_.push_back({
         "reconfigure", {"pr"},
         "Load partial bitstream via PCIe (ICAP_ULTRASCALE)",
-        "Usage: reconfigure <partial.bit>\n"
+        "Usage: reconfigure [-skip] <partial.bit>\n"
         "  Stream a partial bitstream into the FPGA reconfigurable partition\n"
         "  via the on-chip ICAP controller.  The RP is automatically decoupled\n"
         "  before programming and re-coupled after.\n"
         "\n"
+        "  -skip   Skip the stream if the bitstream's .hash sidecar matches\n"
+        "          the loaded design; the RM is only reset\n"
+        "\n"
         "  Requires XDMA transport (-t xdma).  FPGA-only; not available in sim.\n"
         "\n"
         "  Example: reconfigure new_dut_partial.bit",
@@ -666,6 +1301,7 @@ int Shell::run_interactive() {
     logger.info("Loom interactive shell. Type 'help' for commands.");
 
     while (!exit_requested_) {
+        log_flush();  // queued async output belongs above the prompt
         const char* input = rx_->input("loom> ");
         if (input == nullptr) {
             // EOF (Ctrl+D)
@@ -743,8 +1379,27 @@ int Shell::cmd_run(const std::vector<std::string>& args) {
         time_cmp = cur_time.value() + delta;
     }
 
+    // With automatic checkpoints or waveform sampling, run in slices that
+    // end on multiples of the intervals and capture at each boundary
+    auto next_multiple = [](uint64_t now, uint64_t interval) {
+        return interval == 0 ? UINT64_MAX : (now / interval + 1) * interval;
+    };
+    uint64_t wave_every = wave_ ? wave_interval_ : 0;
+    uint64_t next_ckpt = UINT64_MAX;
+    uint64_t next_wave = UINT64_MAX;
+    if (checkpoint_interval_ != 0 || wave_every != 0) {
+        auto now = ctx_.get_time();
+        if (!now.ok()) {
+            logger.error("Failed to get current time");
+            return -1;
+        }
+        next_ckpt = next_multiple(now.value(), checkpoint_interval_);
+        next_wave = next_multiple(now.value(), wave_every);
+    }
+    uint64_t slice_cmp = std::min({time_cmp, next_ckpt, next_wave});
+
     // Set time compare before starting
-    auto tc_rc = ctx_.set_time_compare(time_cmp);
+    auto tc_rc = ctx_.set_time_compare(slice_cmp);
     if (!tc_rc.ok()) {
         logger.error("Failed to set time compare");
         return -1;
@@ -772,17 +1427,10 @@ int Shell::cmd_run(const std::vector<std::string>& args) {
 
     // Install SIGINT handler
     interrupted_.store(false);
-    g_interrupted_flag = &interrupted_;
-
-    struct sigaction sa{}, old_sa{};
-    sa.sa_handler = sigint_handler;
-    sa.sa_flags = 0;
-    sigemptyset(&sa.sa_mask);
-    sigaction(SIGINT, &sa, &old_sa);
+    register_interrupt_flag(&interrupted_);
 
     // Service DPI calls until interrupted or emulation stops
-    bool use_irq = (dpi_service_.mode() == DpiMode::Interrupt) &&
-                   ctx_.has_irq_support();
+    bool use_irq = dpi_service_.uses_irq(ctx_);
 
     // Enable state-change IRQ (bit 2) so that finish → Frozen wakes wait_irq()
     if (use_irq) {
@@ -790,9 +1438,19 @@ int Shell::cmd_run(const std::vector<std::string>& args) {
     }
 
     while (!interrupted_.load()) {
-        // Wait for DPI interrupt (interrupt mode only)
-        if (use_irq) {
-            auto irq = ctx_.wait_irq();
+        // Drain the trace buffer about once a millisecond
+        if (trace_wave_) {
+            auto now = std::chrono::steady_clock::now();
+            if (now - trace_last_drain_ >= std::chrono::milliseconds(1)) {
+                trace_last_drain_ = now;
+                if (!drain_trace()) break;
+            }
+        }
+
+        // Wait for the next DPI event (interrupt / adaptive modes). While
+        // tracing, keep polling so the buffer is drained without a DPI call.
+        if (!trace_wave_) {
+            auto irq = dpi_service_.wait_for_work(ctx_);
             if (!irq.ok()) {
                 if (irq.error() == Error::Shutdown) {
                     logger.info("Shutdown received");
@@ -824,7 +1482,10 @@ int Shell::cmd_run(const std::vector<std::string>& args) {
         }
         if (should_exit) break;
 
-        // Check state
+        // Check state, unless the wakeup was for something else (the
+        // state-change IRQ is enabled above)
+        if (use_irq && !dpi_service_.state_may_have_changed())
+            continue;
         auto st = ctx_.get_state();
         if (!st.ok()) {
             if (st.error() == Error::Shutdown) {
@@ -836,6 +1497,29 @@ int Shell::cmd_run(const std::vector<std::string>& args) {
         }
 
         if (st.value() == State::Frozen) {
+            if (slice_cmp < time_cmp && !interrupted_.load()) {
+                auto fin = ctx_.read32(addr::EmuCtrl + reg::Finish);
+                auto now = ctx_.get_time();
+                if (fin.ok() && !(fin.value() & 1) && now.ok() && now.value() >= slice_cmp) {
+                    bool ckpt = now.value() >= next_ckpt;
+                    if (ckpt) {
+                        if (!take_checkpoint()) break;
+                        next_ckpt = next_multiple(now.value(), checkpoint_interval_);
+                    }
+                    if (now.value() >= next_wave) {
+                        // Same instant as a checkpoint: reuse its image
+                        if (!take_wave_sample(ckpt ? &checkpoints_.back().scan : nullptr)) break;
+                        next_wave = next_multiple(now.value(), wave_every);
+                    }
+                    slice_cmp = std::min({time_cmp, next_ckpt, next_wave});
+                    if (!ctx_.set_time_compare(slice_cmp).ok() || !ctx_.start().ok()) {
+                        logger.error("Failed to resume after capture");
+                        break;
+                    }
+                    continue;
+                }
+            }
+            report_breakpoints();
             logger.info("Emulation frozen");
             break;
         }
@@ -845,15 +1529,22 @@ int Shell::cmd_run(const std::vector<std::string>& args) {
         }
     }
 
+    // Complete calls still running on DPI workers
+    dpi_service_.flush(ctx_);
+
     // Restore original SIGINT handler
-    sigaction(SIGINT, &old_sa, nullptr);
-    g_interrupted_flag = nullptr;
+    unregister_interrupt_flag(&interrupted_);
 
     if (interrupted_.load()) {
         ctx_.stop();
         logger.info("Interrupted");
     }
 
+    if (wave_ && wave_interval_ == 0)
+        take_wave_sample();
+    if (trace_wave_)
+        drain_trace();
+
     // Print cycle count and DUT time
     auto cycles = ctx_.get_cycle_count();
     if (cycles.ok()) {
@@ -894,16 +1585,41 @@ int Shell::cmd_step(const std::vector<std::string>& args) {
     }
 
     apply_initial_state();
+    if (!step_and_service(n))
+        return -1;
+    report_breakpoints();
+
+    if (wave_ && wave_interval_ == 0)
+        take_wave_sample();
+    if (trace_wave_)
+        drain_trace();
+
+    auto cycles = ctx_.get_cycle_count();
+    if (cycles.ok()) {
+        logger.info("Stepped %u cycle%s (total: %llu)", n, n == 1 ? "" : "s",
+                    static_cast<unsigned long long>(cycles.value()));
+    }
+
+    return 0;
+}
+
+bool Shell::step_and_service(uint32_t n) {
+    // State-change IRQ lets interrupt / adaptive modes sleep until the step
+    // completes instead of polling
+    if (dpi_service_.uses_irq(ctx_)) {
+        ctx_.write32(addr::EmuCtrl + reg::IrqEnable, 0x4);
+    }
 
     // SW-based step: set time_cmp = time + N, then CMD_START
     auto rc = ctx_.step(n);
     if (!rc.ok()) {
         logger.error("Failed to step");
-        return -1;
+        return false;
     }
 
     // Wait for DUT to reach time_cmp (state transitions Running → Frozen)
     // and service DPI calls during the run
+    const bool use_irq = dpi_service_.uses_irq(ctx_);
     while (true) {
         int svc = dpi_service_.service_once(ctx_);
         if (svc == static_cast<int>(Error::Shutdown)) {
@@ -911,21 +1627,20 @@ int Shell::cmd_step(const std::vector<std::string>& args) {
             break;
         }
 
-        auto st = ctx_.get_state();
-        if (!st.ok()) break;
-        if (st.value() != State::Running) break;
-        if (svc == 0) {
-            usleep(1000);  // only when idle
+        if (!use_irq || dpi_service_.state_may_have_changed()) {
+            auto st = ctx_.get_state();
+            if (!st.ok()) break;
+            if (st.value() != State::Running) break;
+        }
+        if (trace_wave_) {
+            if (!drain_trace()) break;
+        } else if (svc == 0) {
+            auto w = dpi_service_.wait_for_work(ctx_);
+            if (!w.ok() && w.error() != Error::Interrupted) break;
         }
     }
-
-    auto cycles = ctx_.get_cycle_count();
-    if (cycles.ok()) {
-        logger.info("Stepped %u cycle%s (total: %llu)", n, n == 1 ? "" : "s",
-                    static_cast<unsigned long long>(cycles.value()));
-    }
-
-    return 0;
+    dpi_service_.flush(ctx_);
+    return true;
 }
 
 // ============================================================================
@@ -959,33 +1674,280 @@ int Shell::cmd_status(const std::vector<std::string>& /*args*/) {
     std::printf("  Shell ver:   %s\n", version_string(ctx_.shell_version()).c_str());
     std::printf("  Design hash: %s\n", ctx_.design_hash_hex().c_str());
     std::printf("  DPI funcs:   %u\n", ctx_.n_dpi_funcs());
-    std::printf("  Scan bits:   %u\n", ctx_.scan_chain_length());
+    std::printf("  Scan bits:   %u (%u chain%s%s)\n", ctx_.scan_chain_length(),
+                ctx_.n_scan_chains(), ctx_.n_scan_chains() == 1 ? "" : "s",
+                ctx_.scan_stream_only() ? ", streamed" : "");
     std::printf("  Memories:    %u\n", ctx_.n_memories());
     if (mem_map_loaded_) {
         std::printf("  Mem space:   %u bytes\n", mem_map_.total_bytes());
     }
     std::printf("  DPI calls:   %llu\n", static_cast<unsigned long long>(dpi_service_.call_count()));
     std::printf("  DPI errors:  %llu\n", static_cast<unsigned long long>(dpi_service_.error_count()));
+    if (dpi_service_.mode() != DpiMode::Polling) {
+        const auto& idle = dpi_service_.idle_stats();
+        std::printf("  DPI idle:    %llu spin polls, %llu irq waits, %.3f ms asleep, %llu reads skipped\n",
+                    static_cast<unsigned long long>(idle.spin_polls),
+                    static_cast<unsigned long long>(idle.irq_waits),
+                    static_cast<double>(idle.sleep_ns) / 1e6,
+                    static_cast<unsigned long long>(idle.skipped_reads));
+    }
 
     return 0;
 }
 
 // ============================================================================
-// Command: dump
+// Command: perf
 // ============================================================================
 
-int Shell::cmd_dump(const std::vector<std::string>& args) {
-    if (ctx_.scan_chain_length() == 0) {
-        logger.info("No scan chain in design");
+int Shell::cmd_perf(const std::vector<std::string>& args) {
+    if (args.size() == 2 && args[1] == "reset") {
+        dpi_service_.reset_stats(ctx_);
+        std::printf("  Counters reset\n");
         return 0;
     }
-
-    // Scan-based init: apply initial image if no reset DPI mappings need
-    // to patch it.  When reset DPI exists, defer to first step/run.
-    if (has_initial_image_ && !initial_image_applied_ && reset_dpi_mappings_.empty()) {
-        logger.info("Scanning in initial state...");
-        ctx_.scan_write_data(initial_scan_image_);
-        ctx_.scan_restore();
+    if (args.size() == 3 && args[1] == "-o") {
+        std::ofstream out(args[2]);
+        if (!out) {
+            logger.error("Cannot write %s", args[2].c_str());
+            return -1;
+        }
+        std::optional<EmuPerf> emu;
+        if (ctx_.has_emu_perf()) {
+            auto perf = ctx_.read_emu_perf();
+            if (perf.ok()) emu = std::move(perf.value());
+        }
+        dpi_service_.write_perf(out, ctx_, emu ? &*emu : nullptr);
+        std::printf("  Counters written to %s\n", args[2].c_str());
+        return 0;
+    }
+    if (args.size() != 1) {
+        logger.error("Usage: perf [reset | -o <file.toml>]");
+        return -1;
+    }
+
+    const auto& t = ctx_.transport_stats();
+    uint64_t trips = t.round_trips();
+    std::printf("  Round trips: %llu (%llu reads, %llu writes)\n",
+                static_cast<unsigned long long>(trips),
+                static_cast<unsigned long long>(t.read_ops),
+                static_cast<unsigned long long>(t.write_ops));
+    std::printf("  Bytes:       %llu read, %llu written\n",
+                static_cast<unsigned long long>(t.read_bytes),
+                static_cast<unsigned long long>(t.write_bytes));
+    if (trips) {
+        std::printf("  Latency:     avg %.0f ns, p50 < %llu ns, p99 < %llu ns\n",
+                    static_cast<double>(t.busy_ns) / static_cast<double>(trips),
+                    static_cast<unsigned long long>(t.latency_quantile_ns(0.50)),
+                    static_cast<unsigned long long>(t.latency_quantile_ns(0.99)));
+    }
+    std::printf("  Busy:        %.3f ms, %llu irq waits\n",
+                static_cast<double>(t.busy_ns) / 1e6,
+                static_cast<unsigned long long>(t.irq_waits));
+
+    // Hardware view: where the emulation clock went
+    std::optional<EmuPerf> emu;
+    if (ctx_.has_emu_perf()) {
+        auto perf = ctx_.read_emu_perf();
+        if (!perf.ok()) {
+            logger.error("Failed to read emu_ctrl perf counters");
+            return -1;
+        }
+        emu = std::move(perf.value());
+        auto pct = [&](uint64_t n) {
+            return emu->run_cycles ? 100.0 * static_cast<double>(n) / static_cast<double>(emu->run_cycles) : 0.0;
+        };
+        std::printf("  Run cycles:  %llu, DUT enabled %.1f%%\n",
+                    static_cast<unsigned long long>(emu->run_cycles), pct(emu->enabled_cycles));
+        std::printf("  HW stalls:   DPI %llu (%.1f%%), FIFO full %llu (%.1f%%)\n",
+                    static_cast<unsigned long long>(emu->dpi_stall_cycles), pct(emu->dpi_stall_cycles),
+                    static_cast<unsigned long long>(emu->fifo_stall_cycles), pct(emu->fifo_stall_cycles));
+        if (ctx_.clock_mhz() > 0) {
+            std::printf("  Eff. speed:  %.2f MHz of %u MHz\n",
+                        emu->efficiency() * ctx_.clock_mhz(), ctx_.clock_mhz());
+        }
+    }
+
+    const auto& funcs = dpi_service_.funcs();
+    if (funcs.empty()) {
+        return 0;
+    }
+    std::printf("\n  %-4s %-24s %10s %12s %12s %12s %10s %14s\n",
+                "ID", "Function", "Calls", "Callback ms", "Max us", "Stall ms", "MMIO", "HW stall cyc");
+    for (const auto& func : funcs) {
+        const auto& fs = func.stats;
+        uint64_t hw_stall = 0;
+        if (emu && func.func_id >= 0 &&
+            static_cast<size_t>(func.func_id) < emu->func_stall_cycles.size()) {
+            hw_stall = emu->func_stall_cycles[func.func_id];
+        }
+        std::printf("  %-4d %-24s %10llu %12.3f %12.1f %12.3f %10llu %14llu\n",
+                    func.func_id, func.name.c_str(),
+                    static_cast<unsigned long long>(fs.calls),
+                    static_cast<double>(fs.callback_ns) / 1e6,
+                    static_cast<double>(fs.max_callback_ns) / 1e3,
+                    static_cast<double>(fs.stall_ns) / 1e6,
+                    static_cast<unsigned long long>(fs.mmio_reads + fs.mmio_writes),
+                    static_cast<unsigned long long>(hw_stall));
+    }
+    return 0;
+}
+
+// ============================================================================
+// Command: bench
+// ============================================================================
+
+int Shell::cmd_bench(const std::vector<std::string>& args) {
+    static const char* kUsage =
+        "Usage: bench <mmio|scan|mem|dpi|all> [-n <N>] [-label <L>] [-o <file.jsonl>]";
+    if (args.size() < 2) {
+        logger.error("%s", kUsage);
+        return -1;
+    }
+    const std::string& what = args[1];
+    uint32_t n = 0;
+    std::string label = "default";
+    std::string out_file;
+    for (size_t i = 2; i < args.size(); i++) {
+        if (args[i] == "-n" && i + 1 < args.size()) {
+            n = static_cast<uint32_t>(std::strtoul(args[++i].c_str(), nullptr, 0));
+        } else if (args[i] == "-label" && i + 1 < args.size()) {
+            label = args[++i];
+        } else if (args[i] == "-o" && i + 1 < args.size()) {
+            out_file = args[++i];
+        } else {
+            logger.error("%s", kUsage);
+            return -1;
+        }
+    }
+    const bool all = what == "all";
+    if (!all && what != "mmio" && what != "scan" && what != "mem" && what != "dpi") {
+        logger.error("%s", kUsage);
+        return -1;
+    }
+
+    std::vector<BenchResult> results;
+    auto collect = [&](const char* kind, Result<std::vector<BenchResult>> rc) {
+        if (!rc.ok()) {
+            logger.error("bench %s failed (error %d)", kind, static_cast<int>(rc.error()));
+            return false;
+        }
+        results.insert(results.end(), rc.value().begin(), rc.value().end());
+        return true;
+    };
+
+    if (all || what == "mmio") {
+        if (!collect("mmio", bench_mmio(ctx_, n ? n : 10000))) return -1;
+    }
+    if (all || what == "scan" || what == "mem") {
+        auto st = ctx_.get_state();
+        if (st.ok() && st.value() == State::Running) {
+            ctx_.stop();
+            logger.info("Stopped for benchmark");
+        }
+    }
+    if ((all && ctx_.scan_chain_length() > 0) || what == "scan") {
+        if (!collect("scan", bench_scan(ctx_, n ? n : 10))) return -1;
+    }
+    if ((all && mem_map_loaded_) || what == "mem") {
+        if (!mem_map_loaded_) {
+            logger.error("bench mem needs a memory map");
+            return -1;
+        }
+        if (!collect("mem", bench_mem(ctx_, mem_map_, n ? n : 10))) return -1;
+    }
+    if ((all && ctx_.n_dpi_funcs() > 0) || what == "dpi") {
+        // The design's own DPI traffic is the workload: run it to $finish
+        // and divide by each function's call count
+        dpi_service_.reset_stats(ctx_);
+        auto t0 = std::chrono::steady_clock::now();
+        int rc = cmd_run({"run"});
+        double seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - t0).count();
+        if (rc != 0) return rc;
+        for (const auto& func : dpi_service_.funcs()) {
+            if (func.stats.calls == 0) continue;
+            std::string name = (func.read_only ? "dpi_fifo_" : "dpi_") + func.name;
+            uint64_t bytes = func.stats.calls * static_cast<uint64_t>(func.n_args) * 4;
+            results.push_back({name, static_cast<uint64_t>(func.n_args),
+                               func.stats.calls, bytes, seconds});
+        }
+    }
+
+    std::printf("  %-24s %10s %12s %14s %12s %10s\n",
+                "Benchmark", "Param", "Ops", "Ops/s", "us/op", "MB/s");
+    for (const auto& r : results) {
+        std::printf("  %-24s %10llu %12llu %14.1f %12.3f %10.3f\n",
+                    r.name.c_str(), static_cast<unsigned long long>(r.param),
+                    static_cast<unsigned long long>(r.ops),
+                    r.ops_per_s(), r.us_per_op(), r.mb_per_s());
+    }
+
+    if (!out_file.empty()) {
+        std::ofstream out(out_file, std::ios::app);
+        if (!out) {
+            logger.error("Cannot write %s", out_file.c_str());
+            return -1;
+        }
+        write_bench_json(out, results, label);
+        std::printf("  Results appended to %s\n", out_file.c_str());
+    }
+    return 0;
+}
+
+// ============================================================================
+// Command: dump
+// ============================================================================
+
+int Shell::cmd_dump(const std::vector<std::string>& args) {
+    // Parse arguments: dump [-z] [-delta | -base <base.pb>] [-nomap] [<file.pb>]
+    std::string filename;
+    std::string base_file;
+    bool delta = false;
+    SnapshotWriteOptions opts;
+    for (size_t i = 1; i < args.size(); i++) {
+        if (args[i] == "-z") {
+            opts.compress = true;
+        } else if (args[i] == "-delta") {
+            delta = true;
+        } else if (args[i] == "-base" && i + 1 < args.size()) {
+            base_file = args[++i];
+        } else if (args[i] == "-nomap") {
+            opts.embed_maps = false;
+        } else if (args[i][0] == '-') {
+            logger.error("Usage: dump [-z] [-delta | -base <base.pb>] [-nomap] [<file.pb>]");
+            return -1;
+        } else {
+            filename = args[i];
+        }
+    }
+    if (delta && base_file.empty()) {
+        if (last_full_path_.empty()) {
+            logger.error("dump -delta needs a full snapshot saved earlier in this session");
+            return -1;
+        }
+        base_file = last_full_path_;
+    }
+    Snapshot base;
+    if (!base_file.empty()) {
+        if (base_file == last_full_path_) {
+            base = last_full_;
+        } else if (!load_snapshot(base_file, base)) {
+            return -1;
+        }
+        opts.base = &base;
+        opts.base_path = base_file;
+    }
+
+    if (ctx_.scan_chain_length() == 0) {
+        logger.info("No scan chain in design");
+        return 0;
+    }
+
+    // Scan-based init: apply initial image if no reset DPI mappings need
+    // to patch it.  When reset DPI exists, defer to first step/run.
+    if (has_initial_image_ && !initial_image_applied_ && reset_dpi_mappings_.empty()) {
+        logger.info("Scanning in initial state...");
+        scan_in_initial_image();
         initial_image_applied_ = true;
     }
 
@@ -996,17 +1958,10 @@ int Shell::cmd_dump(const std::vector<std::string>& args) {
         logger.info("Stopped for scan capture");
     }
 
-    // Capture
-    auto rc = ctx_.scan_capture(5000);
-    if (!rc.ok()) {
-        logger.error("Scan capture failed");
-        return -1;
-    }
-
-    // Read raw data
-    auto data = ctx_.scan_read_data();
+    // Capture (buffered, or streamed for stream-only scan controllers)
+    auto data = ctx_.scan_capture_image(5000);
     if (!data.ok()) {
-        logger.error("Failed to read scan data");
+        logger.error("Scan capture failed");
         return -1;
     }
 
@@ -1015,18 +1970,21 @@ int Shell::cmd_dump(const std::vector<std::string>& args) {
                 ctx_.scan_chain_length(), scan.size());
 
     // Display named variables if scan map is loaded
-    if (scan_map_loaded_ && scan_map_.variables_size() > 0) {
+    if (scan_map_loaded_ && scan_map().variables_size() > 0) {
         // Find max name length for alignment
         size_t max_name = 0;
         for (const auto& var : scan_map_.variables()) {
             max_name = std::max(max_name, var.name().size());
         }
 
-        for (const auto& var : scan_map_.variables()) {
-            uint64_t val = extract_variable(scan, var.offset(), var.width());
+        // One pass over the whole image, then format
+        std::vector<uint32_t> values;
+        scan_decoder_.decode_all(scan, values);
+        for (int i = 0; i < scan_map_.variables_size(); i++) {
+            const auto& var = scan_map_.variables(i);
             std::printf("  %-*s [%2u] = %s\n",
-                        static_cast<int>(max_name), var.name().c_str(),
-                        var.width(), format_value(var, val).c_str());
+                        static_cast<int>(max_name), var.name().c_str(), var.width(),
+                        format_value(var, scan_decoder_.value(values, i)).c_str());
         }
     } else {
         // Fallback: raw words
@@ -1040,36 +1998,15 @@ int Shell::cmd_dump(const std::vector<std::string>& args) {
     if (mem_map_loaded_ && ctx_.n_memories() > 0) {
         std::printf("\n  Memories: %d\n", mem_map_.num_memories());
         for (const auto& entry : mem_map_.memories()) {
-            int words_per_entry = (entry.width() + 31) / 32;
             std::printf("    %s: %u x %u bits (0x%x - 0x%x)\n",
                         entry.name().c_str(), entry.depth(), entry.width(),
                         entry.base_addr(), entry.end_addr());
-
-            // Read all entries and accumulate raw bytes
-            int bytes_per_entry = words_per_entry * 4;
-            for (uint32_t a = 0; a < entry.depth(); a++) {
-                uint32_t global_addr = entry.base_addr() + a * words_per_entry * 4;
-                auto mem_data = ctx_.mem_read_entry(global_addr, words_per_entry);
-                if (mem_data.ok()) {
-                    for (int w = 0; w < words_per_entry; w++) {
-                        uint32_t word = mem_data.value()[w];
-                        raw_mem_bytes += static_cast<char>((word >>  0) & 0xFF);
-                        raw_mem_bytes += static_cast<char>((word >>  8) & 0xFF);
-                        raw_mem_bytes += static_cast<char>((word >> 16) & 0xFF);
-                        raw_mem_bytes += static_cast<char>((word >> 24) & 0xFF);
-                    }
-                } else {
-                    // Pad with zeros on error
-                    raw_mem_bytes.append(bytes_per_entry, '\0');
-                }
-            }
         }
+        read_memories(raw_mem_bytes);
     }
 
     // Save snapshot to file if requested
-    if (args.size() > 1) {
-        const std::string& filename = args[1];
-
+    if (!filename.empty()) {
         Snapshot snapshot;
 
         auto cycles = ctx_.get_cycle_count();
@@ -1081,6 +2018,7 @@ int Shell::cmd_dump(const std::vector<std::string>& args) {
             snapshot.set_dut_time(time_val.value());
 
         snapshot.set_design_id(ctx_.design_hash()[0]);
+        snapshot.set_design_hash(pack_design_hash(ctx_.design_hash()));
 
         // Pack raw scan data as LE bytes
         std::string raw_bytes(scan.size() * 4, '\0');
@@ -1094,7 +2032,7 @@ int Shell::cmd_dump(const std::vector<std::string>& args) {
 
         // Embed scan map for self-contained file
         if (scan_map_loaded_) {
-            *snapshot.mutable_scan_map() = scan_map_;
+            *snapshot.mutable_scan_map() = scan_map();
         }
 
         // Embed memory map and data
@@ -1103,111 +2041,1010 @@ int Shell::cmd_dump(const std::vector<std::string>& args) {
             snapshot.set_raw_mem_data(raw_mem_bytes);
         }
 
-        std::ofstream out(filename, std::ios::binary);
-        if (!out.is_open()) {
-            logger.error("Cannot open %s for writing", filename.c_str());
+        if (!write_snapshot(filename, snapshot, opts).ok())
             return -1;
+
+        // Full snapshots become the default base for later `dump -delta`
+        if (!opts.base) {
+            last_full_path_ = filename;
+            last_full_ = std::move(snapshot);
         }
-        if (!snapshot.SerializeToOstream(&out)) {
-            logger.error("Failed to serialize snapshot to %s", filename.c_str());
+        logger.info("Snapshot saved to %s%s%s", filename.c_str(),
+                    opts.base ? " (delta)" : "", opts.compress ? " (zstd)" : "");
+    }
+
+    return 0;
+}
+
+// ============================================================================
+// Snapshot Loading
+// ============================================================================
+
+bool Shell::matches_design(uint32_t design_id, std::string_view design_hash) const {
+    // Older snapshots only carry the first hash word
+    if (design_hash.empty())
+        return design_id == ctx_.design_hash()[0];
+    return design_hash == pack_design_hash(ctx_.design_hash());
+}
+
+bool Shell::matches_design(const Snapshot& snapshot) const {
+    return matches_design(snapshot.design_id(), snapshot.design_hash());
+}
+
+std::unique_ptr<SnapshotFile> Shell::open_snapshot(const std::string& path) {
+    auto rc = SnapshotFile::open(path);
+    if (!rc.ok())
+        return nullptr;
+    auto file = std::move(rc.value());
+
+    // Same map fallback as load_snapshot()
+    if (matches_design(file->design_id(), file->design_hash())) {
+        // Parsing our map is only worth it when the file has none
+        file->set_maps(scan_map_loaded_ && !file->has_scan_map() ? &scan_map() : nullptr,
+                       mem_map_loaded_ ? &mem_map_ : nullptr);
+    }
+    return file;
+}
+
+bool Shell::load_snapshot(const std::string& path, Snapshot& snapshot) {
+    auto rc = read_snapshot(path);
+    if (!rc.ok())
+        return false;
+    snapshot = std::move(rc.value());
+
+    // Maps left out of the file are identified by design hash: attach ours
+    // if the snapshot comes from the loaded design
+    if (matches_design(snapshot)) {
+        if (!snapshot.has_scan_map() && scan_map_loaded_)
+            *snapshot.mutable_scan_map() = scan_map();
+        if (!snapshot.has_mem_map() && mem_map_loaded_)
+            *snapshot.mutable_mem_map() = mem_map_;
+    }
+    return true;
+}
+
+// ============================================================================
+// Command: restore
+// ============================================================================
+
+int Shell::cmd_restore(const std::vector<std::string>& args) {
+    if (args.size() < 2) {
+        logger.error("Usage: restore <file.pb>");
+        return -1;
+    }
+
+    const std::string& filename = args[1];
+    Snapshot snapshot;
+    if (!load_snapshot(filename, snapshot))
+        return -1;
+    if (!restore_snapshot(snapshot))
+        return -1;
+
+    logger.info("Restored %s (cycle %llu, time %llu)", filename.c_str(),
+                static_cast<unsigned long long>(snapshot.cycle_count()),
+                static_cast<unsigned long long>(snapshot.dut_time()));
+    return 0;
+}
+
+bool Shell::restore_snapshot(const Snapshot& snapshot, bool mem_delta) {
+    if (!matches_design(snapshot)) {
+        logger.error("Snapshot design 0x%08x does not match loaded design 0x%08x",
+                     snapshot.design_id(), ctx_.design_hash()[0]);
+        return false;
+    }
+
+    Checkpoint cp;
+    cp.cycle_count = snapshot.cycle_count();
+    cp.dut_time = snapshot.dut_time();
+
+    const auto& raw = snapshot.raw_scan_data();
+    size_t n_words = (ctx_.scan_chain_length() + 31) / 32;
+    if (raw.size() != n_words * 4) {
+        logger.error("Snapshot has %zu scan bytes, design expects %zu",
+                     raw.size(), n_words * 4);
+        return false;
+    }
+    cp.scan.resize(n_words);
+    for (size_t i = 0; i < n_words; i++) {
+        cp.scan[i] = static_cast<uint8_t>(raw[i * 4 + 0])
+                   | (static_cast<uint8_t>(raw[i * 4 + 1]) << 8)
+                   | (static_cast<uint8_t>(raw[i * 4 + 2]) << 16)
+                   | (static_cast<uint32_t>(static_cast<uint8_t>(raw[i * 4 + 3])) << 24);
+    }
+
+    // Memory contents follow the map embedded in the snapshot
+    const MemMap& map = snapshot.has_mem_map() ? snapshot.mem_map() : mem_map_;
+    if (!snapshot.raw_mem_data().empty()) {
+        if (map.memories_size() == 0) {
+            logger.error("Snapshot has memory data but no memory map");
+            return false;
+        }
+        cp.mem = snapshot.raw_mem_data();
+    }
+
+    return restore_checkpoint(cp, map, mem_delta);
+}
+
+// ============================================================================
+// Command: checkpoint / rewind
+// ============================================================================
+
+bool Shell::take_checkpoint() {
+    Checkpoint cp;
+    if (!capture_checkpoint(cp))
+        return false;
+    // A rewind followed by a re-run lands on the same times again
+    while (!checkpoints_.empty() && checkpoints_.back().dut_time >= cp.dut_time)
+        checkpoints_.pop_back();
+    checkpoints_.push_back(std::move(cp));
+    while (checkpoints_.size() > checkpoint_depth_)
+        checkpoints_.pop_front();
+    return true;
+}
+
+int Shell::cmd_checkpoint(const std::vector<std::string>& args) {
+    if (args.size() < 2) {
+        if (!take_checkpoint())
+            return -1;
+        logger.info("Checkpoint at time %llu (%zu/%zu)",
+                    static_cast<unsigned long long>(checkpoints_.back().dut_time),
+                    checkpoints_.size(), checkpoint_depth_);
+        return 0;
+    }
+
+    const std::string& sub = args[1];
+    if (sub == "every") {
+        if (args.size() < 3) {
+            logger.error("Usage: checkpoint every <N> [<depth>]");
             return -1;
         }
-        logger.info("Snapshot saved to %s", filename.c_str());
+        uint64_t n = std::strtoull(args[2].c_str(), nullptr, 10);
+        size_t depth = args.size() > 3 ? std::strtoul(args[3].c_str(), nullptr, 10)
+                                       : checkpoint_depth_;
+        if (n == 0 || depth == 0) {
+            logger.error("Interval and depth must be non-zero");
+            return -1;
+        }
+        checkpoint_interval_ = n;
+        checkpoint_depth_ = depth;
+        while (checkpoints_.size() > checkpoint_depth_)
+            checkpoints_.pop_front();
+        logger.info("Checkpointing every %llu time units (keeping %zu)",
+                    static_cast<unsigned long long>(n), depth);
+        return 0;
+    }
+    if (sub == "off") {
+        checkpoint_interval_ = 0;
+        logger.info("Automatic checkpoints disabled");
+        return 0;
+    }
+    if (sub == "clear") {
+        checkpoints_.clear();
+        return 0;
+    }
+    if (sub == "list") {
+        if (checkpoints_.empty()) {
+            std::printf("  (no checkpoints)\n");
+            return 0;
+        }
+        for (size_t i = 0; i < checkpoints_.size(); i++) {
+            const auto& cp = checkpoints_[checkpoints_.size() - 1 - i];
+            std::printf("  [%zu] time %llu, cycle %llu, %zu bytes\n", i + 1,
+                        static_cast<unsigned long long>(cp.dut_time),
+                        static_cast<unsigned long long>(cp.cycle_count),
+                        cp.scan.size() * 4 + cp.mem.size());
+        }
+        return 0;
+    }
+
+    logger.error("Usage: checkpoint [every <N> [<depth>] | off | list | clear]");
+    return -1;
+}
+
+int Shell::cmd_rewind(const std::vector<std::string>& args) {
+    size_t back = 1;
+    if (args.size() > 1)
+        back = std::strtoul(args[1].c_str(), nullptr, 10);
+    if (back == 0 || back > checkpoints_.size()) {
+        logger.error("No checkpoint %zu (have %zu)", back, checkpoints_.size());
+        return -1;
     }
 
+    // Drop everything newer than the target; the target itself stays so
+    // repeated rewinds return to the same point
+    checkpoints_.resize(checkpoints_.size() - back + 1);
+    const auto& cp = checkpoints_.back();
+    if (!restore_checkpoint(cp, mem_map_))
+        return -1;
+
+    logger.info("Rewound to time %llu (cycle %llu)",
+                static_cast<unsigned long long>(cp.dut_time),
+                static_cast<unsigned long long>(cp.cycle_count));
     return 0;
 }
 
 // ============================================================================
-// Command: inspect
+// Command: bisect
 // ============================================================================
 
-int Shell::cmd_inspect(const std::vector<std::string>& args) {
+int Shell::cmd_bisect(const std::vector<std::string>& args) {
+    namespace fs = std::filesystem;
+    size_t max_vars = 20;
+    std::vector<std::string> paths;
+    for (size_t i = 1; i < args.size(); i++) {
+        if (args[i] == "-n" && i + 1 < args.size()) {
+            max_vars = std::strtoul(args[++i].c_str(), nullptr, 10);
+        } else if (args[i][0] == '-') {
+            logger.error("Usage: bisect [-n <N>] <ref.pb|dir>...");
+            return -1;
+        } else if (fs::is_directory(args[i])) {
+            for (const auto& entry : fs::directory_iterator(args[i]))
+                if (entry.path().extension() == ".pb")
+                    paths.push_back(entry.path().string());
+        } else {
+            paths.push_back(args[i]);
+        }
+    }
+    if (ctx_.scan_chain_length() == 0) {
+        logger.info("No scan chain in design");
+        return 0;
+    }
+
+    // Breakpoints would stop the probes short of the reference times
+    struct TriggersOff {
+        Shell& shell;
+        bool off;
+        ~TriggersOff() { if (off) shell.apply_breakpoints(); }
+    } triggers_off{*this, !breakpoints_.empty() && ctx_.set_triggers({}).ok()};
+
+    // Reference points in time order; a reference that matches is a valid
+    // starting state for the hardware, so no checkpoints of this run are
+    // needed
+    std::vector<std::unique_ptr<SnapshotFile>> refs;
+    for (const auto& path : paths) {
+        auto file = open_snapshot(path);
+        if (!file)
+            return -1;
+        if (!matches_design(file->design_id(), file->design_hash())) {
+            logger.error("%s is from a different design", path.c_str());
+            return -1;
+        }
+        refs.push_back(std::move(file));
+    }
+    std::sort(refs.begin(), refs.end(),
+              [](const auto& a, const auto& b) { return a->dut_time() < b->dut_time(); });
+    refs.erase(std::unique(refs.begin(), refs.end(),
+                           [](const auto& a, const auto& b) { return a->dut_time() == b->dut_time(); }),
+               refs.end());
+    if (refs.size() < 2) {
+        logger.error("bisect needs reference snapshots at two or more times");
+        return -1;
+    }
+
+    auto ref_scan = [&](size_t i, std::vector<uint32_t>& scan) {
+        auto raw = refs[i]->raw_scan_data();
+        if (!raw.ok()) {
+            logger.error("Cannot read scan data of %s", refs[i]->path().c_str());
+            return false;
+        }
+        scan = unpack_words(raw.value());
+        scan.resize((ctx_.scan_chain_length() + 31) / 32, 0);
+        return true;
+    };
+    auto restore_ref = [&](size_t i) {
+        Checkpoint cp;
+        cp.cycle_count = refs[i]->cycle_count();
+        cp.dut_time = refs[i]->dut_time();
+        if (!ref_scan(i, cp.scan))
+            return false;
+        auto mem = refs[i]->raw_mem_data();
+        if (mem.ok())
+            cp.mem = std::string(mem.value());
+        const MemMap* map = refs[i]->mem_map();
+        return restore_checkpoint(cp, map ? *map : mem_map_);
+    };
+    // Step from reference `from` (already in hardware) to the time of `to`
+    // and compare; 1 = match, 0 = differs, -1 = error
+    std::vector<uint32_t> hw_scan, want;
+    auto probe = [&](size_t from, size_t to) {
+        for (uint64_t left = refs[to]->dut_time() - refs[from]->dut_time(); left > 0;) {
+            auto n = static_cast<uint32_t>(std::min<uint64_t>(left, UINT32_MAX));
+            if (!step_and_service(n))
+                return -1;
+            left -= n;
+        }
+        auto data = ctx_.scan_capture_image(5000);
+        if (!data.ok()) {
+            logger.error("Scan capture failed");
+            return -1;
+        }
+        hw_scan = std::move(data.value());
+        if (!ref_scan(to, want))
+            return -1;
+        size_t n_diff = diff_scan_words(hw_scan, want).size();
+        logger.info("  time %llu: %s", static_cast<unsigned long long>(refs[to]->dut_time()),
+                    n_diff ? (std::to_string(n_diff) + " scan word(s) differ").c_str() : "match");
+        return n_diff ? 0 : 1;
+    };
+
+    logger.info("Bisecting over %zu reference snapshots (time %llu..%llu)", refs.size(),
+                static_cast<unsigned long long>(refs.front()->dut_time()),
+                static_cast<unsigned long long>(refs.back()->dut_time()));
+    if (ctx_.n_memories() > 0) {
+        auto mem = refs.front()->raw_mem_data();
+        if (!mem.ok() || mem.value().empty())
+            logger.warning("References carry no memory contents; memories are not restored");
+    }
+
+    // Invariant: the hardware matches refs[lo] and, stepped from it,
+    // differs at refs[hi]. at_lo: the hardware currently holds refs[lo].
+    size_t lo = 0, hi = refs.size() - 1;
+    if (!restore_ref(lo))
+        return -1;
+    int rc = probe(lo, hi);
+    if (rc < 0)
+        return -1;
+    if (rc == 1) {
+        std::printf("  No divergence up to time %llu\n",
+                    static_cast<unsigned long long>(refs[hi]->dut_time()));
+        return 0;
+    }
+    std::vector<uint32_t> bad_scan = hw_scan;
+    bool at_lo = false;
+    while (hi - lo > 1) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (!at_lo && !restore_ref(lo))
+            return -1;
+        rc = probe(lo, mid);
+        if (rc < 0)
+            return -1;
+        if (rc == 1) {
+            lo = mid;
+            at_lo = true;
+        } else {
+            hi = mid;
+            bad_scan = hw_scan;
+            at_lo = false;
+        }
+    }
+
+    std::printf("  Last match:     time %llu, cycle %llu (%s)\n",
+                static_cast<unsigned long long>(refs[lo]->dut_time()),
+                static_cast<unsigned long long>(refs[lo]->cycle_count()), refs[lo]->path().c_str());
+    std::printf("  First mismatch: time %llu, cycle %llu (%s)\n",
+                static_cast<unsigned long long>(refs[hi]->dut_time()),
+                static_cast<unsigned long long>(refs[hi]->cycle_count()), refs[hi]->path().c_str());
+
+    if (!ref_scan(hi, want))
+        return -1;
+    if (scan_map_loaded_ && scan_map().variables_size() > 0) {
+        auto vars = scan_decoder_.diff(want, bad_scan);
+        std::printf("  Differing variables: %zu\n", vars.size());
+        size_t max_name = 0;
+        for (size_t k = 0; k < vars.size() && k < max_vars; k++)
+            max_name = std::max(max_name, scan_map_.variables(static_cast<int>(vars[k])).name().size());
+        for (size_t k = 0; k < vars.size() && k < max_vars; k++) {
+            const auto& var = scan_map_.variables(static_cast<int>(vars[k]));
+            std::printf("    %-*s  ref %s  hw %s\n", static_cast<int>(max_name), var.name().c_str(),
+                        format_value(var, ScanDecoder::decode(want, var.offset(), var.width())).c_str(),
+                        format_value(var, ScanDecoder::decode(bad_scan, var.offset(), var.width())).c_str());
+        }
+        if (vars.size() > max_vars)
+            std::printf("    ... %zu more (bisect -n)\n", vars.size() - max_vars);
+    } else {
+        for (uint32_t w : diff_scan_words(want, bad_scan))
+            std::printf("    [%2u] ref 0x%08x  hw 0x%08x\n", w, want[w], bad_scan[w]);
+    }
+
+    // Leave the hardware where single-stepping toward the divergence starts
+    if (!at_lo && !restore_ref(lo))
+        return -1;
+    return 0;
+}
+
+// ============================================================================
+// Command: wave
+// ============================================================================
+
+bool Shell::take_wave_sample(const std::vector<uint32_t>* scan) {
+    auto time_val = ctx_.get_time();
+    if (!time_val.ok()) {
+        logger.error("Failed to read DUT time");
+        return false;
+    }
+    if (scan) {
+        wave_->sample(time_val.value(), *scan);
+        return true;
+    }
+
+    if (ctx_.scan_chain_length() == 0) {
+        wave_->sample(time_val.value(), {});
+        return true;
+    }
+    auto st = ctx_.get_state();
+    if (st.ok() && st.value() == State::Running)
+        ctx_.stop();
+    auto data = ctx_.scan_capture_image(5000);
+    if (!data.ok()) {
+        logger.error("Scan capture failed");
+        return false;
+    }
+    wave_->sample(time_val.value(), std::move(data.value()));
+    return true;
+}
+
+int Shell::cmd_wave(const std::vector<std::string>& args) {
     if (args.size() < 2) {
-        logger.error("Usage: inspect <file.pb> [<var>]");
+        if (!wave_) {
+            std::printf("  Waveform tracing off\n");
+            return 0;
+        }
+        std::printf("  Tracing %zu variables to %s, %llu samples", wave_->n_variables(),
+                    wave_->path().c_str(), static_cast<unsigned long long>(wave_->n_samples()));
+        if (wave_interval_ != 0)
+            std::printf(", every %llu\n", static_cast<unsigned long long>(wave_interval_));
+        else
+            std::printf(", on stop\n");
+        return 0;
+    }
+
+    if (args[1] == "off") {
+        if (!wave_)
+            return 0;
+        uint64_t n = wave_->n_samples();
+        std::string path = wave_->path();
+        auto rc = wave_->close();
+        wave_.reset();
+        if (!rc.ok())
+            return -1;
+        logger.info("Wrote %llu samples to %s", static_cast<unsigned long long>(n), path.c_str());
+        return 0;
+    }
+
+    if (args[1] == "sample") {
+        if (!wave_) {
+            logger.error("Waveform tracing is off");
+            return -1;
+        }
+        return take_wave_sample() ? 0 : -1;
+    }
+
+    if (!scan_map_loaded_) {
+        logger.error("No scan map loaded");
         return -1;
     }
 
-    const std::string& filename = args[1];
-    std::string filter;
-    if (args.size() > 2)
-        filter = args[2];
-
-    // Load snapshot
-    std::ifstream in(filename, std::ios::binary);
-    if (!in.is_open()) {
-        logger.error("Cannot open %s", filename.c_str());
+    uint64_t interval = 0;
+    size_t first_filter = 2;
+    if (args.size() > 3 && args[2] == "every") {
+        interval = std::strtoull(args[3].c_str(), nullptr, 10);
+        if (interval == 0) {
+            logger.error("Usage: wave <file.vcd> every <N> [var...]");
+            return -1;
+        }
+        first_filter = 4;
+    }
+    std::vector<std::string> filters(args.begin() + first_filter, args.end());
+
+    // Closing the previous trace first keeps two writers off one file
+    if (wave_) {
+        wave_->close();
+        wave_.reset();
+    }
+    auto w = WaveWriter::open(args[1], scan_map(), filters);
+    if (!w.ok())
         return -1;
+    wave_ = std::move(w.value());
+    wave_interval_ = interval;
+    logger.info("Tracing %zu variables to %s", wave_->n_variables(), args[1].c_str());
+
+    // Start the trace with the current state
+    return take_wave_sample() ? 0 : -1;
+}
+
+// ============================================================================
+// Command: trace
+// ============================================================================
+
+bool Shell::drain_trace() {
+    trace_entries_.clear();
+    auto n = ctx_.trace_drain(trace_entries_);
+    if (!n.ok()) {
+        logger.error("Trace drain failed");
+        return false;
+    }
+    if (n.value() == 0)
+        return true;
+
+    // Entries carry the low 32 cycle-counter bits. None is 2^32 cycles old
+    // when drained, so each belongs to the newest cycle <= now (read after
+    // the drain) with those low bits.
+    auto now = ctx_.get_cycle_count();
+    if (!now.ok()) {
+        logger.error("Failed to read cycle count");
+        return false;
+    }
+
+    uint32_t ew = ctx_.trace_entry_words();
+    for (uint32_t i = 0; i < n.value(); i++) {
+        const uint32_t* entry = trace_entries_.data() + static_cast<size_t>(i) * ew;
+        uint64_t cycle = (now.value() & ~0xFFFFFFFFull) | entry[0];
+        if (cycle > now.value())
+            cycle -= 1ull << 32;
+        trace_wave_->sample(cycle, std::vector<uint32_t>(entry + 1, entry + ew));
+    }
+    return true;
+}
+
+int Shell::cmd_trace(const std::vector<std::string>& args) {
+    if (args.size() < 2) {
+        if (!trace_wave_) {
+            std::printf("  Hardware trace off");
+            if (ctx_.trace_bits() != 0)
+                std::printf(" (%u bits x %u entries available)", ctx_.trace_bits(),
+                            ctx_.trace_depth());
+            std::printf("\n");
+            return 0;
+        }
+        auto st = ctx_.trace_status();
+        auto dropped = ctx_.trace_dropped();
+        if (!st.ok() || !dropped.ok()) {
+            logger.error("Failed to read trace status");
+            return -1;
+        }
+        const char* state = (st.value() & status::TraceArmed)      ? "waiting for trigger"
+                          : (st.value() & status::TraceCapturing)  ? "recording"
+                          : (st.value() & status::TraceDone)       ? "done"
+                                                                   : "stopped";
+        std::printf("  Tracing %zu variables to %s, %llu samples, %s, %u dropped\n",
+                    trace_wave_->n_variables(), trace_wave_->path().c_str(),
+                    static_cast<unsigned long long>(trace_wave_->n_samples()), state,
+                    dropped.value());
+        return 0;
     }
 
-    Snapshot snapshot;
-    if (!snapshot.ParseFromIstream(&in)) {
-        logger.error("Failed to parse snapshot: %s", filename.c_str());
+    if (args[1] == "off") {
+        if (!trace_wave_)
+            return 0;
+        bool ok = ctx_.trace_stop().ok() && drain_trace();
+        auto dropped = ctx_.trace_dropped();
+        if (dropped.ok() && dropped.value() != 0)
+            logger.warning("Trace buffer overflowed: %u cycles dropped (try -stall)",
+                           dropped.value());
+        uint64_t n = trace_wave_->n_samples();
+        std::string path = trace_wave_->path();
+        auto rc = trace_wave_->close();
+        trace_wave_.reset();
+        if (!ok || !rc.ok())
+            return -1;
+        logger.info("Wrote %llu samples to %s", static_cast<unsigned long long>(n), path.c_str());
+        return 0;
+    }
+
+    if (ctx_.trace_bits() == 0) {
+        logger.error("Design has no trace buffer (build with loomc -trace)");
+        return -1;
+    }
+    if (!trace_map_loaded_) {
+        logger.error("No trace map loaded");
         return -1;
     }
 
+    Context::TraceConfig config;
+    std::vector<std::string> filters;
+    for (size_t i = 2; i < args.size(); i++) {
+        if (args[i] == "-stall") {
+            config.stall = true;
+        } else if (args[i] == "-post" && i + 1 < args.size()) {
+            config.post = static_cast<uint32_t>(std::strtoul(args[++i].c_str(), nullptr, 0));
+        } else if (args[i] == "-trig" && i + 1 < args.size()) {
+            const std::string& spec = args[++i];
+            auto eq = spec.find('=');
+            const ScanVariable* var = nullptr;
+            if (eq != std::string::npos) {
+                for (const auto& v : trace_map_.variables())
+                    if (v.name() == spec.substr(0, eq))
+                        var = &v;
+            }
+            if (!var) {
+                logger.error("Usage: -trig <traced var>=<value>");
+                return -1;
+            }
+            uint32_t shift = var->offset() % 32;
+            if (var->width() > 32 || shift + var->width() > 32) {
+                logger.error("Trigger variable %s does not fit in one trace word",
+                             var->name().c_str());
+                return -1;
+            }
+            uint64_t mask = ((1ull << var->width()) - 1) << shift;
+            uint64_t value = std::strtoull(spec.c_str() + eq + 1, nullptr, 0) << shift;
+            config.trig_word = var->offset() / 32;
+            config.trig_mask = static_cast<uint32_t>(mask);
+            config.trig_value = static_cast<uint32_t>(value & mask);
+        } else {
+            filters.push_back(args[i]);
+        }
+    }
+
+    if (trace_wave_) {
+        ctx_.trace_stop();
+        trace_wave_->close();
+        trace_wave_.reset();
+    }
+    auto w = WaveWriter::open(args[1], trace_map_, filters);
+    if (!w.ok())
+        return -1;
+    if (!ctx_.trace_arm(config).ok()) {
+        logger.error("Failed to arm trace buffer");
+        return -1;
+    }
+    trace_wave_ = std::move(w.value());
+    logger.info("Tracing %zu variables to %s%s", trace_wave_->n_variables(), args[1].c_str(),
+                config.trig_mask ? " on trigger" : "");
+    return 0;
+}
+
+// ============================================================================
+// Command: break / watch
+// ============================================================================
+
+const ScanVariable* Shell::find_watched(const std::string& name) const {
+    for (const auto& v : watch_map_.variables())
+        if (v.name() == name)
+            return &v;
+    return nullptr;
+}
+
+int Shell::add_breakpoint(const std::string& name, Context::TriggerMode mode,
+                          const std::string& value, const std::string& mask) {
+    if (ctx_.watch_bits() == 0) {
+        logger.error("Design has no hardware triggers (build with loomc -watch)");
+        return -1;
+    }
+    if (!watch_map_loaded_) {
+        logger.error("No watch map loaded");
+        return -1;
+    }
+    const ScanVariable* var = find_watched(name);
+    if (!var) {
+        logger.error("%s is not a watched register", name.c_str());
+        return -1;
+    }
+    uint32_t shift = var->offset() % 32;
+    if (var->width() > 32 || shift + var->width() > 32) {
+        logger.error("Watched register %s does not fit in one probe word", name.c_str());
+        return -1;
+    }
+    if (breakpoints_.size() >= ctx_.n_triggers()) {
+        logger.error("All %u hardware triggers are in use", ctx_.n_triggers());
+        return -1;
+    }
+
+    auto parse = [](const std::string& s, uint64_t& out) {
+        char* end = nullptr;
+        out = std::strtoull(s.c_str(), &end, 0);
+        return !s.empty() && *end == '\0';
+    };
+    uint64_t all_bits = (1ull << var->width()) - 1;
+    uint64_t m = all_bits;
+    uint64_t v = 0;
+    if (!mask.empty() && !parse(mask, m)) {
+        logger.error("Invalid mask: %s", mask.c_str());
+        return -1;
+    }
+    if (!parse(value, v)) {
+        logger.error("Invalid value: %s", value.c_str());
+        return -1;
+    }
+    m &= all_bits;
+
+    Breakpoint bp;
+    bp.var = name;
+    bp.trigger.word = var->offset() / 32;
+    bp.trigger.mask = static_cast<uint32_t>(m << shift);
+    bp.trigger.value = static_cast<uint32_t>((v & m) << shift);
+    bp.trigger.mode = mode;
+    char cond[64];
+    if (mode == Context::TriggerMode::Change)
+        std::snprintf(cond, sizeof(cond), "changes");
+    else
+        std::snprintf(cond, sizeof(cond), "%s 0x%llx", mode == Context::TriggerMode::Enter ? "becomes" : "==",
+                      static_cast<unsigned long long>(v & m));
+    bp.cond = cond;
+    if (!mask.empty()) {
+        std::snprintf(cond, sizeof(cond), " (mask 0x%llx)", static_cast<unsigned long long>(m));
+        bp.cond += cond;
+    }
+
+    breakpoints_.push_back(bp);
+    if (!apply_breakpoints()) {
+        breakpoints_.pop_back();
+        return -1;
+    }
+    logger.info("Breakpoint %zu: %s %s", breakpoints_.size(), name.c_str(), bp.cond.c_str());
+    return 0;
+}
+
+bool Shell::apply_breakpoints() {
+    if (ctx_.watch_bits() == 0)
+        return true;
+    std::vector<Context::Trigger> triggers;
+    for (const auto& bp : breakpoints_)
+        triggers.push_back(bp.trigger);
+    if (!ctx_.set_triggers(triggers, break_all_).ok()) {
+        logger.error("Failed to program hardware triggers");
+        return false;
+    }
+    return true;
+}
+
+void Shell::report_breakpoints() {
+    if (breakpoints_.empty())
+        return;
+    auto hits = ctx_.trigger_hits();
+    if (!hits.ok() || hits.value() == 0)
+        return;
+    auto now = ctx_.get_time();
+    for (size_t i = 0; i < breakpoints_.size(); i++) {
+        if (!((hits.value() >> i) & 1))
+            continue;
+        logger.info("Breakpoint %zu hit at time %llu: %s %s", i + 1,
+                    static_cast<unsigned long long>(now.ok() ? now.value() : 0),
+                    breakpoints_[i].var.c_str(), breakpoints_[i].cond.c_str());
+    }
+}
+
+int Shell::cmd_break(const std::vector<std::string>& args) {
+    if (args.size() < 2) {
+        if (breakpoints_.empty()) {
+            std::printf("  No breakpoints");
+            if (ctx_.watch_bits() != 0)
+                std::printf(" (%u triggers over %u watched bits available)", ctx_.n_triggers(),
+                            ctx_.watch_bits());
+            std::printf("\n");
+            return 0;
+        }
+        for (size_t i = 0; i < breakpoints_.size(); i++)
+            std::printf("  %zu  %s %s\n", i + 1, breakpoints_[i].var.c_str(),
+                        breakpoints_[i].cond.c_str());
+        if (breakpoints_.size() > 1)
+            std::printf("  Freeze when %s match\n", break_all_ ? "all" : "any");
+        return 0;
+    }
+
+    if (args[1] == "-and" || args[1] == "-or") {
+        break_all_ = args[1] == "-and";
+        return apply_breakpoints() ? 0 : -1;
+    }
+    if (args[1] == "clear") {
+        breakpoints_.clear();
+        return apply_breakpoints() ? 0 : -1;
+    }
+    if (args[1] == "delete") {
+        size_t n = args.size() > 2 ? std::strtoul(args[2].c_str(), nullptr, 10) : 0;
+        if (n == 0 || n > breakpoints_.size()) {
+            logger.error("No breakpoint %s", args.size() > 2 ? args[2].c_str() : "given");
+            return -1;
+        }
+        breakpoints_.erase(breakpoints_.begin() + static_cast<std::ptrdiff_t>(n - 1));
+        return apply_breakpoints() ? 0 : -1;
+    }
+
+    auto mode = Context::TriggerMode::Equal;
+    std::string mask;
+    std::vector<std::string> operands;
+    for (size_t i = 1; i < args.size(); i++) {
+        if (args[i] == "-enter")
+            mode = Context::TriggerMode::Enter;
+        else if (args[i] == "-mask" && i + 1 < args.size())
+            mask = args[++i];
+        else
+            operands.push_back(args[i]);
+    }
+    if (operands.size() != 2) {
+        logger.error("Usage: break [-enter] [-mask <M>] <var> <value>");
+        return -1;
+    }
+    return add_breakpoint(operands[0], mode, operands[1], mask);
+}
+
+int Shell::cmd_watch(const std::vector<std::string>& args) {
+    std::string mask;
+    std::vector<std::string> operands;
+    for (size_t i = 1; i < args.size(); i++) {
+        if (args[i] == "-mask" && i + 1 < args.size())
+            mask = args[++i];
+        else
+            operands.push_back(args[i]);
+    }
+    if (operands.size() != 1) {
+        logger.error("Usage: watch [-mask <M>] <var>");
+        return -1;
+    }
+    return add_breakpoint(operands[0], Context::TriggerMode::Change, "0", mask);
+}
+
+// ============================================================================
+// Command: coverage
+// ============================================================================
+
+int Shell::cmd_coverage(const std::vector<std::string>& args) {
+    bool missed_only = false;
+    std::string json_path, ucis_path;
+    for (size_t i = 1; i < args.size(); i++) {
+        if (args[i] == "-missed") {
+            missed_only = true;
+        } else if (args[i] == "-json" && i + 1 < args.size()) {
+            json_path = args[++i];
+        } else if (args[i] == "-ucis" && i + 1 < args.size()) {
+            ucis_path = args[++i];
+        } else {
+            logger.error("Usage: coverage [-missed] [-json <file>] [-ucis <file>]");
+            return -1;
+        }
+    }
+
+    scan_map();
+    if (coverage_.empty()) {
+        logger.info("No cover properties in design (build with loomc -cover-bits > 0)");
+        return 0;
+    }
+
+    auto st = ctx_.get_state();
+    if (st.ok() && st.value() == State::Running) {
+        ctx_.stop();
+        logger.info("Stopped for scan capture");
+    }
+    auto data = ctx_.scan_capture_image(5000);
+    if (!data.ok()) {
+        logger.error("Scan capture failed");
+        return -1;
+    }
+    auto points = coverage_.read(data.value());
+
+    size_t max_name = 0, covered = 0;
+    for (const auto& p : points) {
+        max_name = std::max(max_name, p.name.size());
+        covered += p.hits > 0;
+    }
+    for (const auto& p : points) {
+        if (missed_only && p.hits > 0)
+            continue;
+        std::printf("  %-*s %12llu%s", static_cast<int>(max_name), p.name.c_str(),
+                    static_cast<unsigned long long>(p.hits), p.saturated ? "+" : " ");
+        if (p.first)
+            std::printf("  first @%llu", static_cast<unsigned long long>(*p.first));
+        if (!p.src.empty())
+            std::printf("  %s", p.src.c_str());
+        std::printf("\n");
+    }
+    std::printf("  Covered %zu/%zu (%.1f%%)\n", covered, points.size(),
+                100.0 * static_cast<double>(covered) / static_cast<double>(points.size()));
+
+    if (!json_path.empty()) {
+        if (!write_coverage_json(json_path, points, coverage_.top()).ok())
+            return -1;
+        logger.info("Wrote %s", json_path.c_str());
+    }
+    if (!ucis_path.empty()) {
+        if (!write_coverage_ucis(ucis_path, points, coverage_.top()).ok())
+            return -1;
+        logger.info("Wrote %s", ucis_path.c_str());
+    }
+    return 0;
+}
+
+// ============================================================================
+// Command: inspect
+// ============================================================================
+
+int Shell::cmd_inspect(const std::vector<std::string>& args) {
+    if (args.size() < 2) {
+        logger.error("Usage: inspect <file.pb> [<var>...]");
+        return -1;
+    }
+
+    const std::string& filename = args[1];
+    std::vector<std::string> filters(args.begin() + 2, args.end());
+
+    // Map the snapshot; only what is displayed below gets decoded
+    auto file = open_snapshot(filename);
+    if (!file)
+        return -1;
+
     // Display metadata
     std::printf("  File:       %s\n", filename.c_str());
     std::printf("  Cycle:      %llu\n",
-                static_cast<unsigned long long>(snapshot.cycle_count()));
+                static_cast<unsigned long long>(file->cycle_count()));
     std::printf("  DUT time:   %llu\n",
-                static_cast<unsigned long long>(snapshot.dut_time()));
-    std::printf("  Design hash[0]: 0x%08x\n", snapshot.design_id());
+                static_cast<unsigned long long>(file->dut_time()));
+    std::printf("  Design hash[0]: 0x%08x\n", file->design_id());
 
-    if (!snapshot.has_scan_map() || snapshot.scan_map().variables_size() == 0) {
+    if (!file->has_scan_map() || file->n_variables() == 0) {
         std::printf("  (no embedded scan map)\n");
         // Display raw data
-        const auto& raw = snapshot.raw_scan_data();
-        size_t n_words = raw.size() / 4;
+        auto raw = file->raw_scan_data();
+        if (!raw.ok())
+            return -1;
+        size_t n_words = raw.value().size() / 4;
         for (size_t i = 0; i < n_words; i++) {
-            uint32_t w = static_cast<uint8_t>(raw[i * 4 + 0])
-                       | (static_cast<uint8_t>(raw[i * 4 + 1]) << 8)
-                       | (static_cast<uint8_t>(raw[i * 4 + 2]) << 16)
-                       | (static_cast<uint8_t>(raw[i * 4 + 3]) << 24);
+            const char* p = raw.value().data() + i * 4;
+            uint32_t w = static_cast<uint8_t>(p[0])
+                       | (static_cast<uint8_t>(p[1]) << 8)
+                       | (static_cast<uint8_t>(p[2]) << 16)
+                       | (static_cast<uint8_t>(p[3]) << 24);
             std::printf("  [%2zu] 0x%08x\n", i, w);
         }
         return 0;
     }
 
-    const auto& map = snapshot.scan_map();
-    std::printf("  Chain:      %u bits, %d variables\n",
-                map.chain_length(), map.variables_size());
+    std::printf("  Chain:      %u bits, %zu variables\n",
+                file->chain_length(), file->n_variables());
 
-    // Unpack raw scan data to words
-    const auto& raw_bytes = snapshot.raw_scan_data();
-    size_t n_words = raw_bytes.size() / 4;
-    std::vector<uint32_t> raw(n_words);
-    for (size_t i = 0; i < n_words; i++) {
-        raw[i] = static_cast<uint8_t>(raw_bytes[i * 4 + 0])
-               | (static_cast<uint8_t>(raw_bytes[i * 4 + 1]) << 8)
-               | (static_cast<uint8_t>(raw_bytes[i * 4 + 2]) << 16)
-               | (static_cast<uint8_t>(raw_bytes[i * 4 + 3]) << 24);
+    // Variables: all of them in map order, or those matching each prefix
+    std::vector<ScanVariable> vars;
+    if (filters.empty()) {
+        const ScanMap* full = file->scan_map();
+        if (!full)
+            return -1;
+        vars.assign(full->variables().begin(), full->variables().end());
+    } else {
+        for (const auto& filter : filters) {
+            auto found = file->find_variables(filter);
+            if (!found.ok())
+                return -1;
+            if (found.value().empty())
+                std::printf("  %s: no such variable\n", filter.c_str());
+            for (auto& var : found.value())
+                vars.push_back(std::move(var));
+        }
     }
 
     // Find max name length for alignment
     size_t max_name = 0;
-    for (const auto& var : map.variables()) {
-        if (filter.empty() || var.name().find(filter) == 0)
-            max_name = std::max(max_name, var.name().size());
+    for (const auto& var : vars)
+        max_name = std::max(max_name, var.name().size());
+
+    // Everything: decode the full image in one pass. A few variables: pull
+    // just their bits so the rest of the image is never touched.
+    std::vector<uint32_t> scan_words, values;
+    ScanDecoder decoder;
+    if (filters.empty()) {
+        auto raw = file->raw_scan_data();
+        if (!raw.ok())
+            return -1;
+        scan_words = unpack_words(raw.value());
+        decoder = ScanDecoder(*file->scan_map());
+        decoder.decode_all(scan_words, values);
     }
 
-    for (const auto& var : map.variables()) {
-        if (!filter.empty() && var.name().find(filter) != 0)
-            continue;
-        uint64_t val = extract_variable(raw, var.offset(), var.width());
+    for (size_t i = 0; i < vars.size(); i++) {
+        const auto& var = vars[i];
+        std::vector<uint32_t> bits;
+        std::span<const uint32_t> val;
+        if (filters.empty()) {
+            val = decoder.value(values, i);
+        } else {
+            auto packed = file->scan_bits(var.offset(), var.width());
+            if (!packed.ok())
+                return -1;
+            bits = unpack_words(packed.value());
+            val = bits;
+        }
         std::printf("  %-*s [%2u] = %s\n",
                     static_cast<int>(max_name), var.name().c_str(),
                     var.width(), format_value(var, val).c_str());
     }
 
-    // Display memory contents if present
-    if (snapshot.has_mem_map() && !snapshot.raw_mem_data().empty()) {
-        const auto& mmap = snapshot.mem_map();
+    // Display memory contents if present (skipped when asking for variables)
+    const MemMap* mmap = filters.empty() && file->has_mem_map() ? file->mem_map() : nullptr;
+    auto mem = mmap ? file->raw_mem_data() : Result<std::string_view>(std::string_view());
+    if (mmap && mem.ok() && !mem.value().empty()) {
         std::printf("\n  Memories: %u (%u bytes total)\n",
-                    mmap.num_memories(), mmap.total_bytes());
-        const auto& mem_bytes = snapshot.raw_mem_data();
+                    mmap->num_memories(), mmap->total_bytes());
+        std::string_view mem_bytes = mem.value();
         size_t byte_offset = 0;
-        for (const auto& entry : mmap.memories()) {
+        for (const auto& entry : mmap->memories()) {
             int words_per_entry = (entry.width() + 31) / 32;
             int bytes_per_entry = words_per_entry * 4;
             std::printf("    %s: %u x %u bits\n",
@@ -1246,36 +3083,24 @@ int Shell::cmd_deposit_script(const std::vector<std::string>& args) {
 
     const std::string& filename = args[1];
 
-    // Load snapshot
-    std::ifstream in(filename, std::ios::binary);
-    if (!in.is_open()) {
-        logger.error("Cannot open %s", filename.c_str());
-        return -1;
-    }
-
-    Snapshot snapshot;
-    if (!snapshot.ParseFromIstream(&in)) {
-        logger.error("Failed to parse snapshot: %s", filename.c_str());
+    // Map the snapshot; memory data is only decoded if it is present
+    auto file = open_snapshot(filename);
+    if (!file)
         return -1;
-    }
 
-    if (!snapshot.has_scan_map() || snapshot.scan_map().variables_size() == 0) {
+    const ScanMap* scan_map = file->has_scan_map() ? file->scan_map() : nullptr;
+    if (!scan_map || scan_map->variables_size() == 0) {
         logger.error("Snapshot has no embedded scan map");
         return -1;
     }
 
-    const auto& map = snapshot.scan_map();
+    const auto& map = *scan_map;
 
     // Unpack raw scan data to words
-    const auto& raw_bytes = snapshot.raw_scan_data();
-    size_t n_words = raw_bytes.size() / 4;
-    std::vector<uint32_t> raw(n_words);
-    for (size_t i = 0; i < n_words; i++) {
-        raw[i] = static_cast<uint8_t>(raw_bytes[i * 4 + 0])
-               | (static_cast<uint8_t>(raw_bytes[i * 4 + 1]) << 8)
-               | (static_cast<uint8_t>(raw_bytes[i * 4 + 2]) << 16)
-               | (static_cast<uint8_t>(raw_bytes[i * 4 + 3]) << 24);
-    }
+    auto scan = file->raw_scan_data();
+    if (!scan.ok())
+        return -1;
+    std::vector<uint32_t> raw = unpack_words(scan.value());
 
     // Generate deposit statements
     FILE* out = stdout;
@@ -1303,30 +3128,31 @@ int Shell::cmd_deposit_script(const std::vector<std::string>& args) {
 
     emit("// Auto-generated by loom deposit_script\n");
     emit("// Source: %s (cycle %llu)\n", filename.c_str(),
-         static_cast<unsigned long long>(snapshot.cycle_count()));
-
-    for (const auto& var : map.variables()) {
-        uint64_t val = extract_variable(raw, var.offset(), var.width());
-        int hex_digits = (var.width() + 3) / 4;
-        if (hex_digits < 1) hex_digits = 1;
-
-        if (var.width() <= 32) {
-            emit("$deposit(%s, %u'h%0*x);\n", var.name().c_str(),
-                 var.width(), hex_digits, static_cast<uint32_t>(val));
-        } else {
-            emit("$deposit(%s, %u'h%0*llx);\n", var.name().c_str(),
-                 var.width(), hex_digits,
-                 static_cast<unsigned long long>(val));
-        }
+         static_cast<unsigned long long>(file->cycle_count()));
+
+    // Full-width values: the hex may be longer than emit()'s buffer
+    ScanDecoder decoder(map);
+    std::vector<uint32_t> values;
+    decoder.decode_all(raw, values);
+    for (int i = 0; i < map.variables_size(); i++) {
+        const auto& var = map.variables(i);
+        std::string hex = format_hex_words(decoder.value(values, i), var.width());
+        emit("$deposit(%s, %u'h", var.name().c_str(), var.width());
+        if (out_file.is_open())
+            out_file << std::string_view(hex).substr(2);
+        else
+            std::fputs(hex.c_str() + 2, out);
+        emit(");\n");
     }
 
     // Memory deposits
-    if (snapshot.has_mem_map() && !snapshot.raw_mem_data().empty()) {
-        const auto& mmap = snapshot.mem_map();
-        const auto& mem_bytes = snapshot.raw_mem_data();
+    const MemMap* mmap = file->has_mem_map() ? file->mem_map() : nullptr;
+    auto mem = mmap ? file->raw_mem_data() : Result<std::string_view>(std::string_view());
+    if (mmap && mem.ok() && !mem.value().empty()) {
+        std::string_view mem_bytes = mem.value();
         emit("\n// Memory contents\n");
         size_t byte_offset = 0;
-        for (const auto& entry : mmap.memories()) {
+        for (const auto& entry : mmap->memories()) {
             int words_per_entry = (entry.width() + 31) / 32;
             int bytes_per_entry = words_per_entry * 4;
             int hex_digits = (entry.width() + 3) / 4;
@@ -1361,8 +3187,7 @@ int Shell::cmd_reset(const std::vector<std::string>& /*args*/) {
     // counters, time counters, and the finish register.
     ctx_.reset();
     // Scan-based reset: re-scan the initial image
-    ctx_.scan_write_data(initial_scan_image_);
-    ctx_.scan_restore();
+    scan_in_initial_image();
     initial_image_applied_ = true;
     // Re-preload memories
     mem_preloaded_ = false;
@@ -1555,32 +3380,8 @@ int Shell::cmd_loadmem(const std::vector<std::string>& args) {
     target->set_initial_content(std::string(content.begin(), content.end()));
 
     // Write immediately via shadow ports
-    int bytes_per_entry = (target->width() + 7) / 8;
-    int words_per_entry = (target->width() + 31) / 32;
-
-    for (uint32_t a = 0; a < target->depth(); a++) {
-        std::vector<uint32_t> data(words_per_entry, 0);
-        int content_offset = a * bytes_per_entry;
-        for (int b = 0; b < bytes_per_entry &&
-             content_offset + b < static_cast<int>(content.size()); b++) {
-            data[b / 4] |= static_cast<uint32_t>(
-                static_cast<uint8_t>(content[content_offset + b])) << ((b % 4) * 8);
-        }
-
-        if (a == 0) {
-            auto rc = ctx_.mem_preload_start(target->base_addr(), data);
-            if (!rc.ok()) {
-                logger.error("Memory write failed for %s", mem_name.c_str());
-                return -1;
-            }
-        } else {
-            auto rc = ctx_.mem_preload_next(data);
-            if (!rc.ok()) {
-                logger.error("Memory write failed for %s at entry %u", mem_name.c_str(), a);
-                return -1;
-            }
-        }
-    }
+    if (!preload_memory(*target, target->initial_content(), (target->width() + 7) / 8))
+        return -1;
 
     logger.info("Loaded %s into %s (%u entries, %s format)",
                 filepath.c_str(), mem_name.c_str(), target->depth(),
@@ -1593,26 +3394,35 @@ int Shell::cmd_loadmem(const std::vector<std::string>& args) {
 // ============================================================================
 
 int Shell::cmd_reconfigure(const std::vector<std::string>& args) {
-    if (args.size() < 2) {
-        logger.error("Usage: reconfigure <partial.bit>");
+    Context::ReconfigureOptions opts;
+    std::string path;
+    for (size_t i = 1; i < args.size(); i++) {
+        if (args[i] == "-skip")
+            opts.skip_if_loaded = true;
+        else
+            path = args[i];
+    }
+    if (path.empty()) {
+        logger.error("Usage: reconfigure [-skip] <partial.bit>");
         return -1;
     }
-    const std::string& path = args[1];
 
-    auto rc = ctx_.reconfigure(path);
+    auto rc = ctx_.reconfigure(path, opts);
     if (!rc.ok()) {
         logger.error("Reconfiguration failed (error %d)", static_cast<int>(rc.error()));
         return -1;
     }
 
+    // New RM, new BRAM contents: the next memory read must be a full one
+    mem_mirror_valid_ = false;
+
     // Re-scan initial state into the new RM.  The scan image captured at
     // connect time may be stale if the design changed, but it's the best
     // we have without a new scan_map.pb.  A future enhancement could accept
     // an updated scan_map alongside the partial bitstream.
     if (!initial_scan_image_.empty()) {
         logger.info("reconfigure: scanning in initial state for new RM...");
-        ctx_.scan_write_data(initial_scan_image_);
-        ctx_.scan_restore();
+        scan_in_initial_image();
         initial_image_applied_ = true;
     }
 
@@ -1658,9 +3468,7 @@ void Shell::execute_initial_dpi_calls() {
         if (reset_func_ids.count(func.func_id)) continue;  // handled in Phase 2
 
         std::vector<uint32_t> out_args(func.out_arg_words, 0);
-        std::vector<uint32_t> dummy_args;
-        func.callback(std::span<const uint32_t>(dummy_args),
-                       std::span<uint32_t>(out_args));
+        dpi_service_.call_init(func, out_args);
         logger.info("Executed initial DPI call: %s (void)", func.name.c_str());
     }
 
@@ -1673,9 +3481,7 @@ void Shell::execute_initial_dpi_calls() {
         }
 
         std::vector<uint32_t> out_args(func->out_arg_words, 0);
-        std::vector<uint32_t> dummy_args;
-        uint64_t result = func->callback(std::span<const uint32_t>(dummy_args),
-                                          std::span<uint32_t>(out_args));
+        uint64_t result = dpi_service_.call_init(*func, out_args);
 
         // Inject result into scan image
         if (has_initial_image_) {
@@ -1696,4 +3502,37 @@ void Shell::execute_initial_dpi_calls() {
     }
 }
 
+// ============================================================================
+// Scan in the initial image
+// ============================================================================
+
+void Shell::scan_in_initial_image() {
+    // The ROM holds the image as scan_insert built it; only the reset DPI
+    // results differ, one patch per image word they touch
+    if (ctx_.scan_has_reset_rom() && has_initial_image_) {
+        std::map<uint32_t, uint32_t> masks;
+        for (const auto& mapping : reset_dpi_mappings_) {
+            for (uint32_t i = 0; i < mapping.scan_width && i < 64; i++) {
+                uint32_t pos = mapping.scan_offset + i;
+                masks[pos / 32] |= 1u << (pos % 32);
+            }
+        }
+        if (masks.size() <= reg::ScanPatchSlots) {
+            std::vector<Context::ScanPatch> patches;
+            for (const auto& [word, mask] : masks) {
+                uint32_t value = word < initial_scan_image_.size() ? initial_scan_image_[word] : 0;
+                patches.push_back({word, value & mask, mask});
+            }
+            auto rc = ctx_.scan_reinit(patches);
+            if (rc.ok()) return;
+            logger.warning("Scan reinit failed (error %d), uploading the image",
+                           static_cast<int>(rc.error()));
+        } else {
+            logger.debug("Reset DPI touches %zu scan words, more than %u patch slots",
+                         masks.size(), reg::ScanPatchSlots);
+        }
+    }
+    ctx_.scan_restore_image(initial_scan_image_);
+}
+
 } // namespace loom
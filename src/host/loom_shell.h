@@ -8,13 +8,22 @@
 #pragma once
 
 #include "loom.h"
+#include "loom_bench.h"
+#include "loom_coverage.h"
 #include "loom_dpi_service.h"
-#include "loom_snapshot.pb.h"
+#include "loom_scan_decode.h"
+#include "loom_scan_map.h"
+#include "loom_snapshot.h"
+#include "loom_wave.h"
 
+#include <deque>
 #include <functional>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <atomic>
+#include <chrono>
 
 namespace replxx {
 class Replxx;
@@ -42,12 +51,52 @@ public:
 
     // Load a scan map from a protobuf file.
     // Must be called before dump/inspect/deposit_script can decode variables.
+    // The file is mapped, not parsed: only the initial image and reset DPI
+    // mappings are read now, the variables on first use (see scan_map()).
     void load_scan_map(const std::string& path);
 
+    // Load the trace map written by scan_insert -trace_map.
+    // Required by the trace command.
+    void load_trace_map(const std::string& path);
+
+    // Load the watch map written by scan_insert -watch_map.
+    // Required by the break and watch commands.
+    void load_watch_map(const std::string& path);
+
     // Load a memory map from a protobuf file.
     // Enables memory preload on first run/step and memory dump/inspect.
     void load_mem_map(const std::string& path);
 
+    // Use maps parsed once for several shells (loomx -farm), equivalent to
+    // the load_* calls. read_mem_map also reads every init_file into the
+    // entries' initial_content. The read_* calls return false if the file
+    // is missing or malformed. read_trace_map also reads watch maps (same
+    // format).
+    static bool read_scan_map(const std::string& path, ScanMap& map);
+    static bool read_trace_map(const std::string& path, ScanMap& map);
+    static bool read_mem_map(const std::string& path, MemMap& map);
+    void set_scan_map(const ScanMap& map);
+    void set_trace_map(const ScanMap& map);
+    void set_watch_map(const ScanMap& map);
+    void set_mem_map(const MemMap& map);
+    // Leave ~/.loom_history alone on destruction (concurrent farm shells
+    // would race on the file)
+    void set_save_history(bool save) { save_history_ = save; }
+
+    // Snapshot files: read/resolve (deltas, compression, maps by hash)
+    bool load_snapshot(const std::string& path, Snapshot& snapshot);
+
+    // Scan in a snapshot's registers, write back its memories and restore
+    // its cycle and DUT time, as the restore command does; the initial
+    // scan-in, reset DPI calls and memory preload are then skipped. With
+    // mem_delta the memories already hold the snapshot's contents except
+    // for pages dirtied since the last dirty clear (see
+    // Context::mem_dirty_epoch()), and only those are written.
+    bool restore_snapshot(const Snapshot& snapshot, bool mem_delta = false);
+
+    // SIGINTs received while any shell was inside `run`, process-wide
+    static uint64_t interrupt_count();
+
     // Run interactive REPL loop. Returns process exit code.
     int run_interactive();
 
@@ -71,7 +120,18 @@ private:
     int cmd_stop(const std::vector<std::string>& args);
     int cmd_step(const std::vector<std::string>& args);
     int cmd_status(const std::vector<std::string>& args);
+    int cmd_perf(const std::vector<std::string>& args);
+    int cmd_bench(const std::vector<std::string>& args);
     int cmd_dump(const std::vector<std::string>& args);
+    int cmd_restore(const std::vector<std::string>& args);
+    int cmd_checkpoint(const std::vector<std::string>& args);
+    int cmd_rewind(const std::vector<std::string>& args);
+    int cmd_bisect(const std::vector<std::string>& args);
+    int cmd_wave(const std::vector<std::string>& args);
+    int cmd_trace(const std::vector<std::string>& args);
+    int cmd_break(const std::vector<std::string>& args);
+    int cmd_watch(const std::vector<std::string>& args);
+    int cmd_coverage(const std::vector<std::string>& args);
     int cmd_reset(const std::vector<std::string>& args);
     int cmd_read(const std::vector<std::string>& args);
     int cmd_write(const std::vector<std::string>& args);
@@ -84,17 +144,20 @@ private:
     int cmd_loadmem(const std::vector<std::string>& args);
     int cmd_reconfigure(const std::vector<std::string>& args);
 
-    // Value extraction helpers
-    static uint64_t extract_variable(const std::vector<uint32_t>& raw,
-                                     uint32_t offset, uint32_t width);
-    static std::string format_hex(uint64_t value, uint32_t width);
-    static std::string format_value(const ScanVariable& var, uint64_t value);
+    // Value formatting: hex, with the enum member name when one matches
+    static std::string format_value(const ScanVariable& var, std::span<const uint32_t> value);
 
     // Initial state: scan-in + memory preload (idempotent)
     void apply_initial_state();
 
     // Memory preload helpers
     void preload_memories();
+    bool preload_memory(const MemoryEntry& entry, std::string_view content, size_t stride);
+    bool preload_memory_bulk(const MemoryEntry& entry, std::string_view content, size_t stride);
+    // Parsed init_file contents, via a cache of binary images in cache_dir
+    // keyed by file hash (cache_dir empty: always parse). Empty on error.
+    static std::string load_init_file(const MemoryEntry& entry, const std::string& cache_dir,
+                                      bool& cached);
     static std::vector<uint8_t> parse_readmemh(const std::string& path, int width, int depth);
     static std::vector<uint8_t> parse_readmemb(const std::string& path, int width, int depth);
 
@@ -104,8 +167,17 @@ private:
     std::unique_ptr<replxx::Replxx> rx_;
     std::atomic<bool> interrupted_{false};
     bool exit_requested_ = false;
+    bool save_history_ = true;
+    // scan_map_, scan_decoder_ and coverage_ are filled in by scan_map() on
+    // first use; until then only scan_map_file_ is open (load_scan_map)
     ScanMap scan_map_;
+    ScanDecoder scan_decoder_;
+    CoverageMap coverage_;      // loom_cover counters in scan_map_
+    std::unique_ptr<ScanMapFile> scan_map_file_;
     bool scan_map_loaded_ = false;
+    bool scan_map_parsed_ = false;
+    const ScanMap& scan_map();
+    void set_initial_scan_image(std::string_view img);
     std::vector<uint32_t> initial_scan_image_;
     bool has_initial_image_ = false;
     bool initial_image_applied_ = false;
@@ -115,6 +187,72 @@ private:
     bool mem_map_loaded_ = false;
     bool mem_preloaded_ = false;
 
+    // Machine state for restore / rewind (Snapshot layout: LE scan words,
+    // raw_mem_data-style memory bytes)
+    struct Checkpoint {
+        uint64_t cycle_count = 0;
+        uint64_t dut_time = 0;
+        std::vector<uint32_t> scan;
+        std::string mem;
+    };
+    std::deque<Checkpoint> checkpoints_;  // oldest first
+    uint64_t checkpoint_interval_ = 0;    // 0 = no automatic checkpoints
+    size_t checkpoint_depth_ = 8;
+
+    std::string mem_mirror_;          // raw_mem_data as of the last dirty clear
+    bool mem_mirror_valid_ = false;
+
+    bool read_memories(std::string& raw);
+    // dirty: write only the entries on pages set in this bitmap
+    bool write_memories(const MemMap& map, std::string_view raw,
+                        const std::vector<uint32_t>* dirty = nullptr);
+    bool capture_checkpoint(Checkpoint& cp);
+    bool restore_checkpoint(const Checkpoint& cp, const MemMap& map, bool mem_delta = false);
+    bool take_checkpoint();
+
+    // Step n time units, servicing DPI calls until emulation freezes
+    bool step_and_service(uint32_t n);
+
+    // Waveform tracing: a scan image every wave_interval_ time units during
+    // 'run' (0 = whenever 'run' or 'step' stops), decoded and written by
+    // wave_ on its own thread
+    std::unique_ptr<WaveWriter> wave_;
+    uint64_t wave_interval_ = 0;
+    bool take_wave_sample(const std::vector<uint32_t>* scan = nullptr);
+
+    // Hardware trace: loom_trace_ctrl records the traced registers every
+    // cycle; 'run' and 'step' drain it into trace_wave_ with cycle times
+    ScanMap trace_map_;
+    bool trace_map_loaded_ = false;
+    std::unique_ptr<WaveWriter> trace_wave_;
+    std::vector<uint32_t> trace_entries_;
+    std::chrono::steady_clock::time_point trace_last_drain_{};
+    bool drain_trace();
+
+    // Hardware breakpoints: one emu_ctrl trigger comparator each over the
+    // watched registers; 'run' and 'step' report the ones that froze the DUT
+    struct Breakpoint {
+        std::string var;
+        std::string cond;           // for listing: "== 0x10", "changes", ...
+        Context::Trigger trigger;
+    };
+    ScanMap watch_map_;
+    bool watch_map_loaded_ = false;
+    std::vector<Breakpoint> breakpoints_;
+    bool break_all_ = false;        // fire when every breakpoint matches
+    const ScanVariable* find_watched(const std::string& name) const;
+    int add_breakpoint(const std::string& name, Context::TriggerMode mode,
+                       const std::string& value, const std::string& mask);
+    bool apply_breakpoints();
+    void report_breakpoints();
+
+    // Snapshot files: resolve maps by hash, lazy views
+    bool matches_design(const Snapshot& snapshot) const;
+    bool matches_design(uint32_t design_id, std::string_view design_hash) const;
+    std::unique_ptr<SnapshotFile> open_snapshot(const std::string& path);  // lazy view
+    std::string last_full_path_;  // default base for `dump -delta`
+    Snapshot last_full_;
+
     // Reset DPI mappings: func_id → scan chain position
     struct ResetDpiMapping {
         uint32_t func_id;
@@ -126,6 +264,9 @@ private:
 
     // Execute initial/reset DPI calls and patch scan image
     void execute_initial_dpi_calls();
+    // Scan in initial_scan_image_: a ROM reinit with the reset DPI bits as
+    // patches when the controller has the ROM and they fit, else upload it
+    void scan_in_initial_image();
 };
 
 } // namespace loom
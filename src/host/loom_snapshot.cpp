@@ -0,0 +1,620 @@
+// SPDX-License-Identifier: Apache-2.0
+// Loom Snapshot Files Implementation
+
+#include "loom_snapshot.h"
+#include "loom_log.h"
+#include "loom_wire.h"
+
+#include <zstd.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace loom {
+
+static Logger logger = make_logger("snapshot");
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr int kZstdLevel = 3;
+
+// Unchanged gaps shorter than this are folded into the surrounding range:
+// a DeltaRange costs about as much as this many bytes of data
+constexpr size_t kMergeGap = 16;
+
+// Guard against base_path cycles
+constexpr int kMaxDeltaChain = 64;
+
+using Ranges = google::protobuf::RepeatedPtrField<DeltaRange>;
+
+bool compress_blob(std::string& blob) {
+    if (blob.empty()) return true;
+    std::string out(ZSTD_compressBound(blob.size()), '\0');
+    size_t n = ZSTD_compress(out.data(), out.size(), blob.data(), blob.size(), kZstdLevel);
+    if (ZSTD_isError(n)) {
+        logger.error("zstd compression failed: %s", ZSTD_getErrorName(n));
+        return false;
+    }
+    out.resize(n);
+    blob = std::move(out);
+    return true;
+}
+
+// Empty blobs are stored uncompressed; in deltas the size fields describe
+// the resolved blob, not this one
+bool decompress_blob(std::string_view blob, size_t size, std::string& out) {
+    if (blob.empty()) {
+        out.clear();
+        return true;
+    }
+    out.assign(size, '\0');
+    size_t n = ZSTD_decompress(out.data(), out.size(), blob.data(), blob.size());
+    if (ZSTD_isError(n) || n != size) {
+        logger.error("zstd decompression failed: %s",
+                     ZSTD_isError(n) ? ZSTD_getErrorName(n) : "size mismatch");
+        return false;
+    }
+    return true;
+}
+
+bool decompress_blob(std::string& blob, size_t size) {
+    if (blob.empty()) return true;
+    std::string out;
+    if (!decompress_blob(std::string_view(blob), size, out)) return false;
+    blob = std::move(out);
+    return true;
+}
+
+// Word-granular diff of `cur` against `base`. Bytes past the end of `base`
+// always count as changed.
+void diff_blob(const std::string& base, const std::string& cur,
+               Ranges* ranges, std::string& data) {
+    const size_t n = cur.size();
+    auto differs = [&](size_t pos) {
+        size_t len = std::min<size_t>(4, n - pos);
+        if (pos + len > base.size()) return true;
+        return std::memcmp(cur.data() + pos, base.data() + pos, len) != 0;
+    };
+
+    size_t pos = 0;
+    while (pos < n) {
+        if (!differs(pos)) {
+            pos += 4;
+            continue;
+        }
+        size_t start = pos;
+        size_t end = std::min(pos + 4, n);
+        for (size_t p = end; p < n && p - end < kMergeGap; p += 4) {
+            if (differs(p)) end = std::min(p + 4, n);
+        }
+
+        auto* r = ranges->Add();
+        r->set_offset(static_cast<uint32_t>(start));
+        r->set_length(static_cast<uint32_t>(end - start));
+        data.append(cur, start, end - start);
+        pos = end;
+    }
+}
+
+bool apply_delta(std::string& blob, uint32_t size, const Ranges& ranges,
+                 std::string_view data, size_t& cursor) {
+    blob.resize(size, '\0');
+    for (const auto& r : ranges) {
+        if (static_cast<uint64_t>(r.offset()) + r.length() > size ||
+            cursor + r.length() > data.size()) {
+            logger.error("Delta range 0x%x+%u out of bounds", r.offset(), r.length());
+            return false;
+        }
+        blob.replace(r.offset(), r.length(), data.substr(cursor, r.length()));
+        cursor += r.length();
+    }
+    return true;
+}
+
+// Snapshot.scan_index for a serialized ScanMap
+std::string build_scan_index(std::string_view map_bytes) {
+    std::vector<std::string_view> vars;
+    WireReader r(map_bytes);
+    WireField f;
+    while (r.next(f)) {
+        if (f.number == 2 && f.type == 2) vars.push_back(f.bytes);
+    }
+    std::stable_sort(vars.begin(), vars.end(), [](std::string_view a, std::string_view b) {
+        return encoded_name(a) < encoded_name(b);
+    });
+
+    std::string index;
+    index.reserve(vars.size() * 8);
+    for (auto var : vars) {
+        uint32_t rec[2] = {static_cast<uint32_t>(var.data() - map_bytes.data()),
+                           static_cast<uint32_t>(var.size())};
+        for (uint32_t v : rec)
+            for (int i = 0; i < 4; i++)
+                index += static_cast<char>((v >> (8 * i)) & 0xFF);
+    }
+    return index;
+}
+
+Result<Snapshot> read_snapshot_impl(const fs::path& path, int depth) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        logger.error("Cannot open %s", path.c_str());
+        return Error::InvalidArg;
+    }
+
+    Snapshot snap;
+    if (!snap.ParseFromIstream(&in)) {
+        logger.error("Failed to parse snapshot: %s", path.c_str());
+        return Error::Protocol;
+    }
+
+    switch (snap.compression()) {
+    case COMPRESSION_NONE:
+        break;
+    case COMPRESSION_ZSTD:
+        if (!decompress_blob(*snap.mutable_raw_scan_data(), snap.raw_scan_size()) ||
+            !decompress_blob(*snap.mutable_raw_mem_data(), snap.raw_mem_size()) ||
+            !decompress_blob(*snap.mutable_delta_data(), snap.delta_size())) {
+            logger.error("Corrupt compressed snapshot: %s", path.c_str());
+            return Error::Protocol;
+        }
+        snap.set_compression(COMPRESSION_NONE);
+        break;
+    default:
+        logger.error("Unknown compression %d in %s", snap.compression(), path.c_str());
+        return Error::NotSupported;
+    }
+
+    if (!snap.base_path().empty()) {
+        if (depth >= kMaxDeltaChain) {
+            logger.error("Delta chain too long at %s", path.c_str());
+            return Error::InvalidArg;
+        }
+        fs::path base_path = path.parent_path() / snap.base_path();
+        auto base = read_snapshot_impl(base_path, depth + 1);
+        if (!base.ok()) return base.error();
+        Snapshot& full = base.value();
+
+        if (full.design_id() != snap.design_id() ||
+            full.cycle_count() != snap.base_cycle_count()) {
+            logger.error("Base %s (design 0x%08x, cycle %llu) does not match delta %s",
+                         base_path.c_str(), full.design_id(),
+                         static_cast<unsigned long long>(full.cycle_count()), path.c_str());
+            return Error::InvalidArg;
+        }
+
+        size_t cursor = 0;
+        if (!apply_delta(*full.mutable_raw_scan_data(), snap.raw_scan_size(),
+                         snap.scan_delta(), snap.delta_data(), cursor) ||
+            !apply_delta(*full.mutable_raw_mem_data(), snap.raw_mem_size(),
+                         snap.mem_delta(), snap.delta_data(), cursor)) {
+            logger.error("Corrupt delta snapshot: %s", path.c_str());
+            return Error::Protocol;
+        }
+
+        snap.set_raw_scan_data(std::move(*full.mutable_raw_scan_data()));
+        snap.set_raw_mem_data(std::move(*full.mutable_raw_mem_data()));
+        if (!snap.has_scan_map() && full.has_scan_map())
+            *snap.mutable_scan_map() = std::move(*full.mutable_scan_map());
+        if (!snap.has_mem_map() && full.has_mem_map())
+            *snap.mutable_mem_map() = std::move(*full.mutable_mem_map());
+        if (snap.design_hash().empty())
+            snap.set_design_hash(full.design_hash());
+
+        snap.clear_base_path();
+        snap.clear_base_cycle_count();
+        snap.clear_scan_delta();
+        snap.clear_mem_delta();
+        snap.clear_delta_data();
+        snap.clear_delta_size();
+        if (snap.scan_index().empty())
+            snap.set_scan_index(full.scan_index());
+    }
+
+    snap.set_raw_scan_size(static_cast<uint32_t>(snap.raw_scan_data().size()));
+    snap.set_raw_mem_size(static_cast<uint32_t>(snap.raw_mem_data().size()));
+    return snap;
+}
+
+} // namespace
+
+Result<void> write_snapshot(const std::string& path, const Snapshot& snapshot,
+                            const SnapshotWriteOptions& opts) {
+    Snapshot out = snapshot;
+    out.set_raw_scan_size(static_cast<uint32_t>(snapshot.raw_scan_data().size()));
+    out.set_raw_mem_size(static_cast<uint32_t>(snapshot.raw_mem_data().size()));
+
+    if (!opts.embed_maps) {
+        out.clear_scan_map();
+        out.clear_mem_map();
+    }
+    out.clear_scan_index();
+    if (out.has_scan_map() && out.scan_map().variables_size() > 0) {
+        // The embedded map serializes to the same bytes inside the snapshot
+        out.set_scan_index(build_scan_index(out.scan_map().SerializeAsString()));
+    }
+
+    if (opts.base) {
+        if (opts.base->design_id() != snapshot.design_id()) {
+            logger.error("Delta base %s is from a different design", opts.base_path.c_str());
+            return Error::InvalidArg;
+        }
+
+        std::string data;
+        diff_blob(opts.base->raw_scan_data(), snapshot.raw_scan_data(),
+                  out.mutable_scan_delta(), data);
+        diff_blob(opts.base->raw_mem_data(), snapshot.raw_mem_data(),
+                  out.mutable_mem_delta(), data);
+        out.clear_raw_scan_data();
+        out.clear_raw_mem_data();
+
+        // Store the base relative to the delta so the pair can move together
+        fs::path dir = fs::absolute(path).parent_path().lexically_normal();
+        fs::path base = fs::absolute(opts.base_path).lexically_normal();
+        out.set_base_path(base.lexically_proximate(dir).string());
+        out.set_base_cycle_count(opts.base->cycle_count());
+        out.set_delta_size(static_cast<uint32_t>(data.size()));
+        out.set_delta_data(std::move(data));
+    }
+
+    if (opts.compress) {
+        if (!compress_blob(*out.mutable_raw_scan_data()) ||
+            !compress_blob(*out.mutable_raw_mem_data()) ||
+            !compress_blob(*out.mutable_delta_data()))
+            return Error::InvalidArg;
+        out.set_compression(COMPRESSION_ZSTD);
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        logger.error("Cannot open %s for writing", path.c_str());
+        return Error::InvalidArg;
+    }
+    if (!out.SerializeToOstream(&file)) {
+        logger.error("Failed to serialize snapshot to %s", path.c_str());
+        return Error::Protocol;
+    }
+    return {};
+}
+
+Result<Snapshot> read_snapshot(const std::string& path) {
+    return read_snapshot_impl(fs::path(path), 0);
+}
+
+// ============================================================================
+// SnapshotFile
+// ============================================================================
+
+Result<std::unique_ptr<SnapshotFile>> SnapshotFile::open(const std::string& path) {
+    return open_impl(path, 0);
+}
+
+Result<std::unique_ptr<SnapshotFile>> SnapshotFile::open_impl(const std::string& path, int depth) {
+    std::unique_ptr<SnapshotFile> file(new SnapshotFile());
+    file->path_ = path;
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        logger.error("Cannot open %s", path.c_str());
+        return Error::InvalidArg;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        logger.error("Cannot stat %s", path.c_str());
+        return Error::InvalidArg;
+    }
+    if (st.st_size > 0) {
+        void* m = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m == MAP_FAILED) {
+            ::close(fd);
+            logger.error("Cannot map %s", path.c_str());
+            return Error::InvalidArg;
+        }
+        file->data_ = static_cast<const char*>(m);
+        file->size_ = st.st_size;
+    }
+    ::close(fd);
+
+    if (!file->parse()) {
+        logger.error("Failed to parse snapshot: %s", path.c_str());
+        return Error::Protocol;
+    }
+    if (file->compression_ != COMPRESSION_NONE && file->compression_ != COMPRESSION_ZSTD) {
+        logger.error("Unknown compression %d in %s", file->compression_, path.c_str());
+        return Error::NotSupported;
+    }
+
+    if (!file->base_path_.empty()) {
+        if (depth >= kMaxDeltaChain) {
+            logger.error("Delta chain too long at %s", path.c_str());
+            return Error::InvalidArg;
+        }
+        fs::path base_path = fs::path(path).parent_path() / std::string(file->base_path_);
+        auto base = open_impl(base_path.string(), depth + 1);
+        if (!base.ok()) return base.error();
+        if (base.value()->design_id() != file->design_id_ ||
+            base.value()->cycle_count() != file->base_cycle_count_) {
+            logger.error("Base %s (design 0x%08x, cycle %llu) does not match delta %s",
+                         base_path.c_str(), base.value()->design_id(),
+                         static_cast<unsigned long long>(base.value()->cycle_count()),
+                         path.c_str());
+            return Error::InvalidArg;
+        }
+        file->base_ = std::move(base.value());
+    }
+    return file;
+}
+
+SnapshotFile::~SnapshotFile() {
+    if (data_)
+        munmap(const_cast<char*>(data_), size_);
+}
+
+bool SnapshotFile::parse() {
+    WireReader r(std::string_view(data_, size_));
+    WireField f;
+    while (r.next(f)) {
+        bool is_varint = f.type == 0;
+        bool is_bytes = f.type == 2;
+        switch (f.number) {
+        case 1:  if (is_varint) cycle_count_ = f.varint; break;
+        case 2:  if (is_varint) dut_time_ = f.varint; break;
+        case 3:  if (is_varint) design_id_ = static_cast<uint32_t>(f.varint); break;
+        case 4:  if (is_bytes) raw_[0] = f.bytes; break;
+        case 5:  if (is_bytes) scan_map_bytes_ = f.bytes; break;
+        case 6:  if (is_bytes) mem_map_bytes_ = f.bytes; break;
+        case 7:  if (is_bytes) raw_[1] = f.bytes; break;
+        case 8:  if (is_varint) compression_ = static_cast<int>(f.varint); break;
+        case 9:  if (is_varint) raw_size_[0] = static_cast<uint32_t>(f.varint); break;
+        case 10: if (is_varint) raw_size_[1] = static_cast<uint32_t>(f.varint); break;
+        case 11: if (is_bytes) design_hash_ = f.bytes; break;
+        case 12: if (is_bytes) base_path_ = f.bytes; break;
+        case 13: if (is_varint) base_cycle_count_ = f.varint; break;
+        case 14:
+        case 15:
+            if (is_bytes && !delta_[f.number - 14].Add()->ParseFromArray(
+                    f.bytes.data(), static_cast<int>(f.bytes.size())))
+                return false;
+            break;
+        case 16: if (is_bytes) delta_data_ = f.bytes; break;
+        case 17: if (is_varint) delta_size_ = static_cast<uint32_t>(f.varint); break;
+        case 18: if (is_bytes) scan_index_ = f.bytes; break;
+        default: break;
+        }
+    }
+    return !r.error();
+}
+
+std::string_view SnapshotFile::design_hash() const {
+    if (design_hash_.empty() && base_) return base_->design_hash();
+    return design_hash_;
+}
+
+bool SnapshotFile::has_scan_map() const {
+    return !scan_map_bytes_.empty() || (base_ && base_->has_scan_map()) || ext_scan_map_;
+}
+
+bool SnapshotFile::has_mem_map() const {
+    return !mem_map_bytes_.empty() || (base_ && base_->has_mem_map()) || ext_mem_map_;
+}
+
+void SnapshotFile::set_maps(const ScanMap* scan_map, const MemMap* mem_map) {
+    ext_scan_map_ = scan_map;
+    ext_mem_map_ = mem_map;
+}
+
+SnapshotFile* SnapshotFile::map_owner() {
+    if (!scan_map_bytes_.empty()) return this;
+    return base_ ? base_->map_owner() : nullptr;
+}
+
+const ScanMap* SnapshotFile::scan_map() {
+    if (scan_map_) return &*scan_map_;
+    if (!scan_map_bytes_.empty()) {
+        ScanMap map;
+        if (!map.ParseFromArray(scan_map_bytes_.data(), static_cast<int>(scan_map_bytes_.size()))) {
+            logger.error("Corrupt scan map in %s", path_.c_str());
+            return nullptr;
+        }
+        scan_map_ = std::move(map);
+        return &*scan_map_;
+    }
+    if (base_) {
+        if (const ScanMap* map = base_->scan_map()) return map;
+    }
+    return ext_scan_map_;
+}
+
+const MemMap* SnapshotFile::mem_map() {
+    if (mem_map_) return &*mem_map_;
+    if (!mem_map_bytes_.empty()) {
+        MemMap map;
+        if (!map.ParseFromArray(mem_map_bytes_.data(), static_cast<int>(mem_map_bytes_.size()))) {
+            logger.error("Corrupt memory map in %s", path_.c_str());
+            return nullptr;
+        }
+        mem_map_ = std::move(map);
+        return &*mem_map_;
+    }
+    if (base_) {
+        if (const MemMap* map = base_->mem_map()) return map;
+    }
+    return ext_mem_map_;
+}
+
+uint32_t SnapshotFile::chain_length() {
+    SnapshotFile* owner = map_owner();
+    if (!owner) return ext_scan_map_ ? ext_scan_map_->chain_length() : 0;
+    // chain_length is field 1, serialized ahead of the variables
+    WireReader r(owner->scan_map_bytes_);
+    WireField f;
+    while (r.next(f)) {
+        if (f.number == 1 && f.type == 0) return static_cast<uint32_t>(f.varint);
+    }
+    return 0;
+}
+
+size_t SnapshotFile::n_variables() {
+    SnapshotFile* owner = map_owner();
+    if (owner && !owner->scan_index_.empty()) return owner->scan_index_.size() / 8;
+    const ScanMap* map = scan_map();
+    return map ? map->variables_size() : 0;
+}
+
+Result<std::vector<ScanVariable>> SnapshotFile::find_variables(std::string_view name, bool exact) {
+    auto matches = [&](std::string_view var_name) {
+        return exact ? var_name == name : var_name.substr(0, name.size()) == name;
+    };
+    std::vector<ScanVariable> found;
+
+    // Indexed: binary search the sorted {pos, len} records
+    SnapshotFile* owner = map_owner();
+    if (owner && !owner->scan_index_.empty()) {
+        std::string_view map = owner->scan_map_bytes_;
+        std::string_view index = owner->scan_index_;
+        size_t n = index.size() / 8;
+        bool bad = false;
+        auto entry = [&](size_t i) {
+            uint32_t pos = le32(index.data() + i * 8);
+            uint32_t len = le32(index.data() + i * 8 + 4);
+            if (static_cast<uint64_t>(pos) + len > map.size()) {
+                bad = true;
+                return std::string_view();
+            }
+            return map.substr(pos, len);
+        };
+
+        size_t lo = 0, hi = n;
+        while (lo < hi && !bad) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (encoded_name(entry(mid)) < name) lo = mid + 1;
+            else hi = mid;
+        }
+        for (size_t i = lo; i < n && !bad; i++) {
+            std::string_view var = entry(i);
+            if (bad || !matches(encoded_name(var))) break;
+            ScanVariable v;
+            if (!v.ParseFromArray(var.data(), static_cast<int>(var.size()))) {
+                bad = true;
+                break;
+            }
+            found.push_back(std::move(v));
+        }
+        if (!bad) return found;
+        logger.warning("Corrupt scan index in %s, falling back to a map walk", owner->path_.c_str());
+        found.clear();
+    }
+
+    const ScanMap* map = scan_map();
+    if (!map) return Error::InvalidArg;
+    for (const auto& var : map->variables()) {
+        if (matches(var.name())) found.push_back(var);
+    }
+    std::stable_sort(found.begin(), found.end(), [](const ScanVariable& a, const ScanVariable& b) {
+        return a.name() < b.name();
+    });
+    return found;
+}
+
+// which: 0 = raw_scan_data, 1 = raw_mem_data
+Result<std::string_view> SnapshotFile::resolve(int which) {
+    if (resolved_[which]) return std::string_view(*resolved_[which]);
+
+    if (!base_) {
+        if (compression_ == COMPRESSION_NONE) return raw_[which];
+        std::string out;
+        if (!decompress_blob(raw_[which], raw_size_[which], out)) {
+            logger.error("Corrupt compressed snapshot: %s", path_.c_str());
+            return Error::Protocol;
+        }
+        resolved_[which] = std::move(out);
+        return std::string_view(*resolved_[which]);
+    }
+
+    std::string_view delta = delta_data_;
+    if (compression_ == COMPRESSION_ZSTD) {
+        if (!delta_plain_) {
+            std::string out;
+            if (!decompress_blob(delta_data_, delta_size_, out)) {
+                logger.error("Corrupt compressed snapshot: %s", path_.c_str());
+                return Error::Protocol;
+            }
+            delta_plain_ = std::move(out);
+        }
+        delta = *delta_plain_;
+    }
+
+    auto base = base_->resolve(which);
+    if (!base.ok()) return base.error();
+    // The base is only ever read through this delta: take its copy if it made one
+    std::string blob = base_->resolved_[which] ? std::move(*base_->resolved_[which])
+                                               : std::string(base.value());
+    base_->resolved_[which].reset();
+
+    // Memory ranges follow the scan ranges in delta_data
+    size_t cursor = 0;
+    if (which == 1) {
+        for (const auto& r : delta_[0]) cursor += r.length();
+    }
+    if (!apply_delta(blob, raw_size_[which], delta_[which], delta, cursor)) {
+        logger.error("Corrupt delta snapshot: %s", path_.c_str());
+        return Error::Protocol;
+    }
+    resolved_[which] = std::move(blob);
+    return std::string_view(*resolved_[which]);
+}
+
+Result<std::string_view> SnapshotFile::raw_scan_data() {
+    return resolve(0);
+}
+
+Result<std::string_view> SnapshotFile::raw_mem_data() {
+    return resolve(1);
+}
+
+Result<std::string> SnapshotFile::scan_bits(uint32_t offset, uint32_t width) {
+    auto raw = raw_scan_data();
+    if (!raw.ok()) return raw.error();
+    std::string_view scan = raw.value();
+
+    std::string bits((width + 7) / 8, '\0');
+    for (uint32_t i = 0; i < width; i++) {
+        uint64_t pos = static_cast<uint64_t>(offset) + i;
+        if (pos / 8 < scan.size() && ((static_cast<uint8_t>(scan[pos / 8]) >> (pos % 8)) & 1))
+            bits[i / 8] = static_cast<char>(bits[i / 8] | (1 << (i % 8)));
+    }
+    return bits;
+}
+
+Result<std::vector<std::optional<SnapshotFile::Value>>>
+SnapshotFile::query(std::span<const std::string> names) {
+    std::vector<std::optional<Value>> values;
+    values.reserve(names.size());
+    for (const auto& name : names) {
+        auto vars = find_variables(name, true);
+        if (!vars.ok()) return vars.error();
+        if (vars.value().empty()) {
+            values.emplace_back();
+            continue;
+        }
+        Value v;
+        v.var = std::move(vars.value().front());
+        auto bits = scan_bits(v.var.offset(), v.var.width());
+        if (!bits.ok()) return bits.error();
+        v.bits = std::move(bits.value());
+        values.emplace_back(std::move(v));
+    }
+    return values;
+}
+
+} // namespace loom
@@ -0,0 +1,140 @@
+// SPDX-License-Identifier: Apache-2.0
+// Loom Snapshot Files
+//
+// Reads and writes Snapshot protobufs in their three on-disk forms:
+//
+//   full        raw_scan_data / raw_mem_data hold the complete state
+//   delta       only the words that differ from a base snapshot, which is
+//               referenced by path (and may itself be a delta)
+//   compressed  either of the above with the raw blobs zstd-compressed
+//
+// Readers always get the resolved, uncompressed full form back, so callers
+// never need to know how a file was written. Scan and memory maps may be
+// left out of the file and are then identified by design_hash.
+//
+// read_snapshot() parses everything up front. SnapshotFile instead maps the
+// file and decodes on demand, so looking at one variable of a multi-GB
+// snapshot only touches the index, that variable's map entry and the scan
+// words holding it.
+
+#pragma once
+
+#include "loom.h"
+#include "loom_snapshot.pb.h"
+
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace loom {
+
+struct SnapshotWriteOptions {
+    bool compress = false;          // zstd-compress raw blobs
+    bool embed_maps = true;         // false: reference maps by design_hash only
+    const Snapshot* base = nullptr; // write a delta against this (full) snapshot
+    std::string base_path;          // where `base` lives on disk
+};
+
+// Write `snapshot` (full, uncompressed form) to `path` encoded per `opts`.
+Result<void> write_snapshot(const std::string& path, const Snapshot& snapshot,
+                            const SnapshotWriteOptions& opts = {});
+
+// Read `path`, decompress and apply any delta chain. The result is always a
+// full, uncompressed snapshot with base_path cleared.
+Result<Snapshot> read_snapshot(const std::string& path);
+
+// Memory-mapped, lazily decoded snapshot file. open() maps the file and
+// walks its top-level fields only. Raw blobs of full, uncompressed files
+// are read in place; compressed blobs and delta chains are resolved on
+// first access, one blob at a time. Variable lookups use the scan_index
+// written by write_snapshot() and fall back to walking the map in older
+// files.
+class SnapshotFile {
+public:
+    static Result<std::unique_ptr<SnapshotFile>> open(const std::string& path);
+    ~SnapshotFile();
+
+    SnapshotFile(const SnapshotFile&) = delete;
+    SnapshotFile& operator=(const SnapshotFile&) = delete;
+
+    const std::string& path() const { return path_; }
+    uint64_t cycle_count() const { return cycle_count_; }
+    uint64_t dut_time() const { return dut_time_; }
+    uint32_t design_id() const { return design_id_; }
+    std::string_view design_hash() const;  // inherited from the base if absent
+    bool is_delta() const { return base_ != nullptr; }
+    bool is_compressed() const { return compression_ != COMPRESSION_NONE; }
+
+    // Maps embedded here or in the base chain. For files written without
+    // maps the caller may supply its own after checking design_hash().
+    bool has_scan_map() const;
+    bool has_mem_map() const;
+    void set_maps(const ScanMap* scan_map, const MemMap* mem_map);
+
+    // Fully decoded maps (cached); nullptr when there is none
+    const ScanMap* scan_map();
+    const MemMap* mem_map();
+
+    // Scan map summary without decoding the variables
+    uint32_t chain_length();
+    size_t n_variables();
+
+    // Variables named `name` (or starting with it, unless `exact`), in
+    // name order. Decodes only the matching map entries.
+    Result<std::vector<ScanVariable>> find_variables(std::string_view name, bool exact = false);
+
+    // Resolved raw_scan_data / raw_mem_data, valid while the file is open
+    Result<std::string_view> raw_scan_data();
+    Result<std::string_view> raw_mem_data();
+
+    // Bits [offset, offset + width) of the scan image, LE-packed
+    Result<std::string> scan_bits(uint32_t offset, uint32_t width);
+
+    // Batch lookup by exact name, for scripts that pull a handful of
+    // signals out of many snapshots. Unknown names give std::nullopt.
+    struct Value {
+        ScanVariable var;
+        std::string bits;   // LE-packed, (width + 7) / 8 bytes
+    };
+    Result<std::vector<std::optional<Value>>> query(std::span<const std::string> names);
+
+private:
+    SnapshotFile() = default;
+    static Result<std::unique_ptr<SnapshotFile>> open_impl(const std::string& path, int depth);
+    bool parse();
+    SnapshotFile* map_owner();
+    Result<std::string_view> resolve(int which);
+
+    std::string path_;
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+
+    uint64_t cycle_count_ = 0;
+    uint64_t dut_time_ = 0;
+    uint32_t design_id_ = 0;
+    uint64_t base_cycle_count_ = 0;
+    int compression_ = COMPRESSION_NONE;
+    uint32_t raw_size_[2] = {};          // 0 = scan, 1 = mem
+    std::string_view raw_[2];
+    std::string_view scan_map_bytes_;
+    std::string_view mem_map_bytes_;
+    std::string_view design_hash_;
+    std::string_view base_path_;
+    std::string_view delta_data_;
+    uint32_t delta_size_ = 0;
+    std::string_view scan_index_;
+    google::protobuf::RepeatedPtrField<DeltaRange> delta_[2];
+
+    std::unique_ptr<SnapshotFile> base_;
+    const ScanMap* ext_scan_map_ = nullptr;
+    const MemMap* ext_mem_map_ = nullptr;
+    std::optional<ScanMap> scan_map_;
+    std::optional<MemMap> mem_map_;
+    std::optional<std::string> resolved_[2];
+    std::optional<std::string> delta_plain_;
+};
+
+} // namespace loom
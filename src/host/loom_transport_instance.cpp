@@ -0,0 +1,164 @@
+// SPDX-License-Identifier: Apache-2.0
+// Loom Instance Transports (emu_top -instances)
+//
+// A design built with emu_top -instances N holds N copies of the DUT and
+// its controllers, copy k's emu_top window at k * addr::InstanceStride.
+// Each copy is driven by its own Context, typically from its own farm
+// thread, while all of them go through the one PCIe device (or socket).
+//
+// SharedTransport owns the real transport: every call takes its mutex, so
+// accesses from different Contexts never interleave within a batch, and
+// it connects the real transport for the first user and disconnects it
+// after the last. InstanceTransport is one Context's view of it: it adds
+// the instance offset to emu_top addresses and leaves the shell's
+// registers (clock generator, firewall, ICAP) where they are.
+//
+// The copies' IRQ lines are ORed in loom_emu_top, so an interrupt cannot
+// be attributed to one Context: both transports report no interrupt
+// support and the Contexts poll.
+
+#include "loom.h"
+#include "loom_log.h"
+
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace loom {
+
+static Logger logger = make_logger("instance");
+
+namespace {
+
+class SharedTransport final : public Transport {
+public:
+    explicit SharedTransport(std::unique_ptr<Transport> inner) : inner_(std::move(inner)) {}
+
+    Result<void> connect(std::string_view target) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!inner_->is_connected()) {
+            auto rc = inner_->connect(target);
+            if (!rc.ok()) return rc;
+        }
+        users_++;
+        return {};
+    }
+
+    void disconnect() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (users_ > 0 && --users_ == 0)
+            inner_->disconnect();
+    }
+
+    Result<uint32_t> read32(uint32_t addr) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return inner_->read32(addr);
+    }
+    Result<void> write32(uint32_t addr, uint32_t data) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return inner_->write32(addr, data);
+    }
+    Result<void> read_block(uint32_t addr, std::span<uint32_t> data) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return inner_->read_block(addr, data);
+    }
+    Result<void> write_block(uint32_t addr, std::span<const uint32_t> data) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return inner_->write_block(addr, data);
+    }
+    Result<void> read_batch(std::span<const uint32_t> addrs, std::span<uint32_t> data) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return inner_->read_batch(addrs, data);
+    }
+    Result<void> write_batch(std::span<const RegWrite> writes) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return inner_->write_batch(writes);
+    }
+
+    Result<uint32_t> wait_irq(int) override { return Error::NotSupported; }
+    bool has_irq_support() const override { return false; }
+
+    bool is_connected() const override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return inner_->is_connected();
+    }
+
+private:
+    std::unique_ptr<Transport> inner_;
+    mutable std::mutex mutex_;
+    unsigned users_ = 0;
+};
+
+class InstanceTransport final : public Transport {
+public:
+    InstanceTransport(std::shared_ptr<Transport> shared, uint32_t index)
+        : shared_(std::move(shared)), index_(index), base_(index * addr::InstanceStride) {}
+
+    ~InstanceTransport() override { disconnect(); }
+
+    Result<void> connect(std::string_view target) override {
+        disconnect();
+        auto rc = shared_->connect(target);
+        if (!rc.ok()) return rc;
+        connected_ = true;
+        logger.debug("Instance %u at 0x%06x", index_, base_);
+        return {};
+    }
+
+    void disconnect() override {
+        if (!connected_) return;
+        connected_ = false;
+        shared_->disconnect();
+    }
+
+    Result<uint32_t> read32(uint32_t addr) override { return shared_->read32(map(addr)); }
+    Result<void> write32(uint32_t addr, uint32_t data) override {
+        return shared_->write32(map(addr), data);
+    }
+    Result<void> read_block(uint32_t addr, std::span<uint32_t> data) override {
+        return shared_->read_block(map(addr), data);
+    }
+    Result<void> write_block(uint32_t addr, std::span<const uint32_t> data) override {
+        return shared_->write_block(map(addr), data);
+    }
+    Result<void> read_batch(std::span<const uint32_t> addrs, std::span<uint32_t> data) override {
+        std::vector<uint32_t> mapped(addrs.begin(), addrs.end());
+        for (auto& a : mapped) a = map(a);
+        return shared_->read_batch(mapped, data);
+    }
+    Result<void> write_batch(std::span<const RegWrite> writes) override {
+        std::vector<RegWrite> mapped(writes.begin(), writes.end());
+        for (auto& w : mapped) w.addr = map(w.addr);
+        return shared_->write_batch(mapped);
+    }
+
+    Result<uint32_t> wait_irq(int) override { return Error::NotSupported; }
+    bool has_irq_support() const override { return false; }
+    bool is_connected() const override { return connected_ && shared_->is_connected(); }
+
+private:
+    // emu_top registers move to this instance's window; shell registers stay
+    uint32_t map(uint32_t addr) const { return addr < addr::ClkGen ? base_ + addr : addr; }
+
+    std::shared_ptr<Transport> shared_;
+    uint32_t index_;
+    uint32_t base_;
+    bool connected_ = false;
+};
+
+} // namespace
+
+// ============================================================================
+// Factory Functions
+// ============================================================================
+
+std::shared_ptr<Transport> create_shared_transport(std::unique_ptr<Transport> transport) {
+    return std::make_shared<SharedTransport>(std::move(transport));
+}
+
+std::unique_ptr<Transport> create_instance_transport(std::shared_ptr<Transport> shared,
+                                                     uint32_t index) {
+    return std::make_unique<InstanceTransport>(std::move(shared), index);
+}
+
+} // namespace loom
@@ -0,0 +1,471 @@
+// SPDX-License-Identifier: Apache-2.0
+// Loom Shared-Memory Transport Implementation
+//
+// Connects to a Verilator simulation through a file both processes map
+// (normally in /dev/shm). The socket BFM creates it when started with
+// +shm=PATH; the target string is that path. Requests and responses are
+// the socket protocol's messages (tags, posted writes, IRQ and shutdown
+// messages; see loom_transport_socket.cpp), carried in two SPSC rings
+// instead of a byte stream, so an access costs no syscall on either side.
+//
+// Segment layout (mirrors loom_sock_dpi.c):
+//   0x000  header: magic, version, slots, sim_pid, host_attached,
+//          sim_closed, host_closed
+//   0x040  request ring control  (host -> sim): head, tail, waiting,
+//          each on its own cache line
+//   0x100  response ring control (sim -> host)
+//   0x200  request slots, then response slots (16 bytes each)
+//
+// The BFM polls the request ring every idle cycle. The host spins briefly
+// on an empty response ring, then sets `waiting` and sleeps on a futex on
+// the ring head; the BFM only issues the wake when it sees that flag.
+
+#include "loom.h"
+#include "loom_log.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <ctime>
+#include <thread>
+#include <utility>
+
+namespace loom {
+
+static Logger logger = make_logger("shm");
+
+namespace {
+
+constexpr uint32_t kShmMagic = 0x48534D4C;  // "LMSH"
+constexpr uint32_t kShmVersion = 1;
+constexpr size_t kSlotsOffset = 0x200;
+
+// Message types and flags, as on the socket
+namespace msg {
+    constexpr uint8_t Read = 0;
+    constexpr uint8_t Write = 1;
+    constexpr uint8_t ReadResp = 0;
+    constexpr uint8_t WriteAck = 1;
+    constexpr uint8_t Irq = 2;
+    constexpr uint8_t Shutdown = 3;
+
+    constexpr uint8_t FlagPosted = 1 << 0;
+}
+
+// Requests in flight per batch window; well below the ring size so the
+// BFM can always post every response of a window
+constexpr size_t kMaxInflight = 256;
+
+// Empty-ring polls before sleeping, and the sleep slice between liveness
+// checks of the simulator
+constexpr int kSpinPolls = 4096;
+constexpr long kSleepSliceNs = 100'000'000;
+
+struct ShmRing {
+    uint32_t head;     uint32_t pad0[15];
+    uint32_t tail;     uint32_t pad1[15];
+    uint32_t waiting;  uint32_t pad2[15];
+};
+
+struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slots;
+    uint32_t sim_pid;
+    uint32_t host_attached;
+    uint32_t sim_closed;
+    uint32_t host_closed;
+    uint32_t pad[9];
+    ShmRing req;
+    ShmRing resp;
+};
+static_assert(sizeof(Header) <= kSlotsOffset);
+static_assert(offsetof(Header, req) == 0x40 && offsetof(Header, resp) == 0x100);
+
+struct Slot {
+    uint8_t type;
+    uint8_t tag;
+    uint8_t flags;
+    uint8_t version;
+    uint32_t word0;    // request: address, response: read data
+    uint32_t word1;    // request: write data, response: irq bits
+    uint32_t reserved;
+};
+static_assert(sizeof(Slot) == 16);
+
+std::atomic_ref<uint32_t> atomic(uint32_t& v) { return std::atomic_ref<uint32_t>(v); }
+
+// Returns false if interrupted by a signal
+bool futex_wait(uint32_t* addr, uint32_t val, long timeout_ns) {
+#ifdef __linux__
+    struct timespec ts = {timeout_ns / 1'000'000'000, timeout_ns % 1'000'000'000};
+    long rc = syscall(SYS_futex, addr, FUTEX_WAIT, val, &ts, nullptr, 0);
+    return !(rc < 0 && errno == EINTR);
+#else
+    (void)addr; (void)val; (void)timeout_ns;
+    struct timespec ts = {0, 50'000};
+    return nanosleep(&ts, nullptr) == 0 || errno != EINTR;
+#endif
+}
+
+void futex_wake(uint32_t* addr) {
+#ifdef __linux__
+    syscall(SYS_futex, addr, FUTEX_WAKE, 1, nullptr, nullptr, 0);
+#else
+    (void)addr;
+#endif
+}
+
+} // namespace
+
+// ============================================================================
+// Shared-Memory Transport Implementation
+// ============================================================================
+
+class ShmTransport : public Transport {
+public:
+    ShmTransport() = default;
+    ~ShmTransport() override { disconnect(); }
+
+    // Non-copyable
+    ShmTransport(const ShmTransport&) = delete;
+    ShmTransport& operator=(const ShmTransport&) = delete;
+
+    Result<void> connect(std::string_view target) override;
+    void disconnect() override;
+    Result<uint32_t> read32(uint32_t addr) override;
+    Result<void> write32(uint32_t addr, uint32_t data) override;
+    Result<void> read_block(uint32_t addr, std::span<uint32_t> data) override;
+    Result<void> write_block(uint32_t addr, std::span<const uint32_t> data) override;
+    Result<void> read_batch(std::span<const uint32_t> addrs, std::span<uint32_t> data) override;
+    Result<void> write_batch(std::span<const RegWrite> writes) override;
+    Result<uint32_t> wait_irq(int timeout_ms) override;
+    bool has_irq_support() const override { return true; }
+    bool is_connected() const override { return hdr_ != nullptr; }
+
+private:
+    void push(uint8_t type, uint32_t addr, uint32_t wdata, uint8_t tag, uint8_t flags);
+    // Next response. `interruptible` returns Error::Interrupted on a signal
+    // while waiting (wait_irq); otherwise the wait resumes. Past `deadline`
+    // the wait ends with Error::Timeout.
+    Result<Slot> pop(bool interruptible,
+                     std::chrono::steady_clock::time_point deadline =
+                         std::chrono::steady_clock::time_point::max());
+    Result<uint32_t> wait_response(uint8_t expected, uint8_t tag);
+    void close_peer();
+
+    template<typename MakeReq>
+    Result<void> pipeline(size_t n, uint8_t type, MakeReq make_req, uint32_t *rdata);
+
+    Header* hdr_ = nullptr;
+    Slot* req_ = nullptr;
+    Slot* resp_ = nullptr;
+    size_t size_ = 0;
+    uint32_t slots_ = 0;
+    uint32_t pending_irq_ = 0;
+    uint8_t next_tag_ = 0;
+};
+
+// ============================================================================
+// Rings
+// ============================================================================
+
+void ShmTransport::push(uint8_t type, uint32_t addr, uint32_t wdata, uint8_t tag,
+                        uint8_t flags) {
+    ShmRing& r = hdr_->req;
+    uint32_t head = r.head;
+    // Only reachable with more than a ring of requests outstanding, which
+    // the pipeline window prevents
+    while (head - atomic(r.tail).load(std::memory_order_acquire) >= slots_)
+        std::this_thread::yield();
+
+    Slot& s = req_[head % slots_];
+    s.type = type;
+    s.tag = tag;
+    s.flags = flags;
+    s.version = 0;
+    s.word0 = addr;
+    s.word1 = wdata;
+    atomic(r.head).store(head + 1, std::memory_order_seq_cst);
+    if (atomic(r.waiting).load(std::memory_order_seq_cst)) futex_wake(&r.head);
+}
+
+Result<Slot> ShmTransport::pop(bool interruptible, std::chrono::steady_clock::time_point deadline) {
+    ShmRing& r = hdr_->resp;
+    const uint32_t tail = r.tail;
+    int spins = 0;
+    while (true) {
+        uint32_t head = atomic(r.head).load(std::memory_order_acquire);
+        if (head != tail) {
+            Slot s = resp_[tail % slots_];
+            atomic(r.tail).store(tail + 1, std::memory_order_release);
+            return s;
+        }
+        if (atomic(hdr_->sim_closed).load(std::memory_order_acquire)) {
+            logger.debug("Peer disconnected");
+            close_peer();
+            return Error::Shutdown;
+        }
+        if (++spins < kSpinPolls) continue;
+
+        // Sleep until the BFM posts (it wakes us only while `waiting` is
+        // set). The seq_cst store/load pair pairs with the BFM's
+        // head store/waiting load: one of the two sides sees the other.
+        atomic(r.waiting).store(1, std::memory_order_seq_cst);
+        head = atomic(r.head).load(std::memory_order_seq_cst);
+        bool signalled = false;
+        auto now = std::chrono::steady_clock::now();
+        if (head == tail && now >= deadline) {
+            atomic(r.waiting).store(0, std::memory_order_relaxed);
+            return Error::Timeout;
+        }
+        if (head == tail) {
+            auto left_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now).count();
+            signalled = !futex_wait(&r.head, head,
+                                    std::min<long>(kSleepSliceNs, std::max<decltype(left_ns)>(left_ns, 1)));
+        }
+        atomic(r.waiting).store(0, std::memory_order_relaxed);
+        if (signalled && interruptible) return Error::Interrupted;
+
+        // A simulator killed without running its final block never sets
+        // sim_closed
+        if (::kill(static_cast<pid_t>(hdr_->sim_pid), 0) < 0 && errno == ESRCH) {
+            logger.debug("Peer exited");
+            close_peer();
+            return Error::Shutdown;
+        }
+        spins = 0;
+    }
+}
+
+// Wait for the response to the oldest outstanding request, handling any
+// IRQ messages that arrive first. Returns read data (0 for write acks).
+Result<uint32_t> ShmTransport::wait_response(uint8_t expected, uint8_t tag) {
+    while (true) {
+        auto result = pop(false);
+        if (!result.ok()) return result.error();
+        const Slot& s = result.value();
+
+        if (s.type == msg::Irq) {
+            pending_irq_ |= s.word1;
+            continue;
+        }
+        if (s.type == msg::Shutdown) {
+            return Error::Shutdown;
+        }
+        if (s.type != expected) {
+            logger.error("Unexpected message type %u (expected %u)", s.type, expected);
+            return Error::Protocol;
+        }
+        if (s.tag != tag) {
+            logger.error("Response tag mismatch: got %u, expected %u", s.tag, tag);
+            return Error::Protocol;
+        }
+        return s.word0;
+    }
+}
+
+template<typename MakeReq>
+Result<void> ShmTransport::pipeline(size_t n, uint8_t type, MakeReq make_req,
+                                    uint32_t *rdata) {
+    if (!hdr_) return Error::NotConnected;
+
+    const uint8_t resp_type = (type == msg::Read) ? msg::ReadResp : msg::WriteAck;
+    uint8_t tags[kMaxInflight];
+    size_t tag_idx[kMaxInflight];
+
+    for (size_t base = 0; base < n; base += kMaxInflight) {
+        size_t count = std::min(kMaxInflight, n - base);
+        size_t n_acked = 0;
+
+        for (size_t i = 0; i < count; i++) {
+            size_t idx = base + i;
+            auto [addr, wdata] = make_req(idx);
+            uint8_t tag = next_tag_++;
+            bool posted = type == msg::Write && idx + 1 < n;
+            push(type, addr, wdata, tag, posted ? msg::FlagPosted : 0);
+            if (!posted) {
+                tags[n_acked] = tag;
+                tag_idx[n_acked] = idx;
+                n_acked++;
+            }
+        }
+
+        for (size_t i = 0; i < n_acked; i++) {
+            auto resp = wait_response(resp_type, tags[i]);
+            if (!resp.ok()) return resp.error();
+            if (rdata) rdata[tag_idx[i]] = resp.value();
+        }
+    }
+    return {};
+}
+
+// ============================================================================
+// Transport Operations
+// ============================================================================
+
+Result<void> ShmTransport::connect(std::string_view target) {
+    if (hdr_) {
+        return {};  // Already connected
+    }
+
+    std::string path(target);
+    int fd = ::open(path.c_str(), O_RDWR);
+    if (fd < 0) {
+        logger.error("open('%s') failed: %s", path.c_str(), strerror(errno));
+        return Error::Transport;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < kSlotsOffset) {
+        logger.error("%s is not a loom shared-memory segment", path.c_str());
+        ::close(fd);
+        return Error::Transport;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    void* mem = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mem == MAP_FAILED) {
+        logger.error("mmap('%s') failed: %s", path.c_str(), strerror(errno));
+        return Error::Transport;
+    }
+
+    auto* hdr = static_cast<Header*>(mem);
+    uint32_t slots = hdr->slots;
+    if (atomic(hdr->magic).load(std::memory_order_acquire) != kShmMagic ||
+        hdr->version != kShmVersion || slots == 0 ||
+        kSlotsOffset + 2 * static_cast<size_t>(slots) * sizeof(Slot) > size) {
+        logger.error("%s: bad shared-memory header (magic 0x%08x, version %u)",
+                     path.c_str(), hdr->magic, hdr->version);
+        ::munmap(mem, size);
+        return Error::Protocol;
+    }
+    if (::kill(static_cast<pid_t>(hdr->sim_pid), 0) < 0 && errno == ESRCH) {
+        logger.error("%s: simulator (pid %u) is not running", path.c_str(), hdr->sim_pid);
+        ::munmap(mem, size);
+        return Error::Transport;
+    }
+    if (atomic(hdr->host_attached).exchange(1) != 0) {
+        logger.error("%s: another host is attached", path.c_str());
+        ::munmap(mem, size);
+        return Error::Transport;
+    }
+    futex_wake(&hdr->host_attached);
+
+    hdr_ = hdr;
+    size_ = size;
+    slots_ = slots;
+    req_ = reinterpret_cast<Slot*>(static_cast<char*>(mem) + kSlotsOffset);
+    resp_ = req_ + slots;
+    next_tag_ = 0;
+    pending_irq_ = 0;
+
+    logger.info("Connected to %s (shm, %u slots)", path.c_str(), slots);
+    return {};
+}
+
+void ShmTransport::close_peer() {
+    ::munmap(hdr_, size_);
+    hdr_ = nullptr;
+    req_ = resp_ = nullptr;
+}
+
+void ShmTransport::disconnect() {
+    if (hdr_) {
+        atomic(hdr_->host_closed).store(1, std::memory_order_release);
+        close_peer();
+        logger.debug("Disconnected");
+    }
+}
+
+Result<uint32_t> ShmTransport::read32(uint32_t addr) {
+    if (!hdr_) return Error::NotConnected;
+
+    uint8_t tag = next_tag_++;
+    push(msg::Read, addr, 0, tag, 0);
+    return wait_response(msg::ReadResp, tag);
+}
+
+Result<void> ShmTransport::write32(uint32_t addr, uint32_t data) {
+    if (!hdr_) return Error::NotConnected;
+
+    uint8_t tag = next_tag_++;
+    push(msg::Write, addr, data, tag, 0);
+    auto ack = wait_response(msg::WriteAck, tag);
+    if (!ack.ok()) return ack.error();
+    return {};
+}
+
+Result<void> ShmTransport::read_block(uint32_t addr, std::span<uint32_t> data) {
+    return pipeline(data.size(), msg::Read,
+                    [&](size_t i) { return std::pair<uint32_t, uint32_t>(addr + static_cast<uint32_t>(i * 4), 0); },
+                    data.data());
+}
+
+Result<void> ShmTransport::write_block(uint32_t addr, std::span<const uint32_t> data) {
+    return pipeline(data.size(), msg::Write,
+                    [&](size_t i) { return std::pair<uint32_t, uint32_t>(addr + static_cast<uint32_t>(i * 4), data[i]); },
+                    nullptr);
+}
+
+Result<void> ShmTransport::read_batch(std::span<const uint32_t> addrs, std::span<uint32_t> data) {
+    if (data.size() < addrs.size()) return Error::InvalidArg;
+    return pipeline(addrs.size(), msg::Read,
+                    [&](size_t i) { return std::pair<uint32_t, uint32_t>(addrs[i], 0); },
+                    data.data());
+}
+
+Result<void> ShmTransport::write_batch(std::span<const RegWrite> writes) {
+    return pipeline(writes.size(), msg::Write,
+                    [&](size_t i) { return std::pair<uint32_t, uint32_t>(writes[i].addr, writes[i].data); },
+                    nullptr);
+}
+
+Result<uint32_t> ShmTransport::wait_irq(int timeout_ms) {
+    if (!hdr_) return Error::NotConnected;
+
+    // Return any IRQs accumulated during previous AXI transactions
+    if (pending_irq_) {
+        uint32_t irq = pending_irq_;
+        pending_irq_ = 0;
+        return irq;
+    }
+
+    auto deadline = timeout_ms < 0
+        ? std::chrono::steady_clock::time_point::max()
+        : std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (true) {
+        auto result = pop(true, deadline);
+        if (!result.ok()) return result.error();
+        const Slot& s = result.value();
+
+        if (s.type == msg::Irq) {
+            return s.word1;
+        }
+        if (s.type == msg::Shutdown) {
+            return Error::Shutdown;
+        }
+        logger.warning("Unexpected message type %u during wait_irq", s.type);
+    }
+}
+
+// ============================================================================
+// Factory Function
+// ============================================================================
+
+std::unique_ptr<Transport> create_shm_transport() {
+    return std::make_unique<ShmTransport>();
+}
+
+} // namespace loom
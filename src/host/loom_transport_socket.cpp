@@ -6,24 +6,42 @@
 //
 // Request (host -> sim):
 //   [0]     : type (0=read, 1=write)
-//   [1-3]   : reserved
+//   [1]     : tag (v2, echoed in the response)
+//   [2]     : flags (v2: bit0=posted write, no ack; bit1=hello)
+//   [3]     : reserved
 //   [4-7]   : address (little-endian)
 //   [8-11]  : write data (little-endian, ignored for reads)
 //
 // Response (sim -> host):
 //   [0]     : type (0=read response, 1=write ack, 2=irq, 3=shutdown)
-//   [1-3]   : reserved
+//   [1]     : tag of the request (v2)
+//   [2]     : reserved
+//   [3]     : BFM protocol version (0 = legacy BFM, treated as v1)
 //   [4-7]   : read data (little-endian)
 //   [8-11]  : irq bits (little-endian)
+//
+// Version negotiation: connect() sends a read of the firewall timeout
+// register with the hello flag set. A v2 BFM answers it directly with its
+// version in byte 3; a legacy BFM ignores the flag, performs a harmless
+// AXI read and answers with byte 3 = 0. Tags and posted writes are only
+// used once the peer has reported v2.
+//
+// Both versions serve requests strictly in order, so the host may keep up
+// to kMaxInflight requests outstanding. Multiple messages are sent (and
+// by a v2 BFM received and answered) per syscall.
 
 #include "loom.h"
 #include "loom_log.h"
 
+#include <poll.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <unistd.h>
+#include <algorithm>
 #include <cerrno>
+#include <chrono>
 #include <cstring>
+#include <utility>
 
 namespace loom {
 
@@ -37,8 +55,20 @@ namespace msg {
     constexpr uint8_t WriteAck = 1;
     constexpr uint8_t Irq = 2;
     constexpr uint8_t Shutdown = 3;
+
+    constexpr uint8_t FlagPosted = 1 << 0;
+    constexpr uint8_t FlagHello  = 1 << 1;
 }
 
+constexpr uint8_t kProtocolVersion = 2;
+
+// Maximum number of requests in flight during a pipelined batch (the send
+// window). The BFM serves requests strictly in order and blocks while
+// sending a response, so the window must stay well below what both socket
+// buffers can hold.
+constexpr size_t kMaxInflight = 256;
+constexpr size_t kMsgSize = 12;
+
 // ============================================================================
 // Socket Transport Implementation
 // ============================================================================
@@ -56,26 +86,55 @@ public:
     void disconnect() override;
     Result<uint32_t> read32(uint32_t addr) override;
     Result<void> write32(uint32_t addr, uint32_t data) override;
-    Result<uint32_t> wait_irq() override;
+    Result<void> read_block(uint32_t addr, std::span<uint32_t> data) override;
+    Result<void> write_block(uint32_t addr, std::span<const uint32_t> data) override;
+    Result<void> read_batch(std::span<const uint32_t> addrs, std::span<uint32_t> data) override;
+    Result<void> write_batch(std::span<const RegWrite> writes) override;
+    Result<uint32_t> wait_irq(int timeout_ms) override;
     bool has_irq_support() const override { return true; }
     bool is_connected() const override { return fd_ >= 0; }
 
 private:
-    Result<void> send_message(uint8_t type, uint32_t addr, uint32_t wdata);
-    Result<std::tuple<uint8_t, uint32_t, uint32_t>> recv_message();
+    struct Message {
+        uint8_t type;
+        uint8_t tag;
+        uint8_t version;
+        uint32_t data;
+        uint32_t irq_bits;
+    };
+
+    Result<void> negotiate();
+    Result<void> send_bytes(const uint8_t *buf, size_t len);
+    Result<void> send_message(uint8_t type, uint32_t addr, uint32_t wdata,
+                              uint8_t tag = 0, uint8_t flags = 0);
+    Result<Message> recv_message();
+    Result<uint32_t> wait_response(uint8_t expected, uint8_t tag);
+
+    // Pipelined batch: n requests built by make_req(i) are sent in windows
+    // of kMaxInflight, then responses are matched in order. Read data is
+    // stored to rdata[i] when rdata is non-null. With a v2 peer, all but
+    // the last write of a batch are posted.
+    template<typename MakeReq>
+    Result<void> pipeline(size_t n, uint8_t type, MakeReq make_req, uint32_t *rdata);
+
+    bool v2() const { return peer_version_ >= 2; }
 
     int fd_ = -1;
     uint32_t pending_irq_ = 0;
+    uint8_t peer_version_ = 1;
+    uint8_t next_tag_ = 0;
 };
 
 // ============================================================================
 // Helper Methods
 // ============================================================================
 
-Result<void> SocketTransport::send_message(uint8_t type, uint32_t addr, uint32_t wdata) {
-    uint8_t buf[12] = {0};
+static void encode_message(uint8_t *buf, uint8_t type, uint32_t addr, uint32_t wdata,
+                           uint8_t tag, uint8_t flags) {
     buf[0] = type;
-    // bytes 1-3 reserved
+    buf[1] = tag;
+    buf[2] = flags;
+    buf[3] = 0;  // reserved
     buf[4] = addr & 0xFF;
     buf[5] = (addr >> 8) & 0xFF;
     buf[6] = (addr >> 16) & 0xFF;
@@ -84,10 +143,19 @@ Result<void> SocketTransport::send_message(uint8_t type, uint32_t addr, uint32_t
     buf[9] = (wdata >> 8) & 0xFF;
     buf[10] = (wdata >> 16) & 0xFF;
     buf[11] = (wdata >> 24) & 0xFF;
+}
 
+Result<void> SocketTransport::send_message(uint8_t type, uint32_t addr, uint32_t wdata,
+                                          uint8_t tag, uint8_t flags) {
+    uint8_t buf[kMsgSize];
+    encode_message(buf, type, addr, wdata, tag, flags);
+    return send_bytes(buf, kMsgSize);
+}
+
+Result<void> SocketTransport::send_bytes(const uint8_t *buf, size_t len) {
     size_t total = 0;
-    while (total < 12) {
-        ssize_t n = ::write(fd_, buf + total, 12 - total);
+    while (total < len) {
+        ssize_t n = ::write(fd_, buf + total, len - total);
         if (n <= 0) {
             if (errno == EINTR) continue;
             // Broken pipe / connection reset = peer (sim) exited
@@ -105,7 +173,7 @@ Result<void> SocketTransport::send_message(uint8_t type, uint32_t addr, uint32_t
     return {};
 }
 
-Result<std::tuple<uint8_t, uint32_t, uint32_t>> SocketTransport::recv_message() {
+Result<SocketTransport::Message> SocketTransport::recv_message() {
     uint8_t buf[12];
     size_t total = 0;
     while (total < 12) {
@@ -131,11 +199,84 @@ Result<std::tuple<uint8_t, uint32_t, uint32_t>> SocketTransport::recv_message()
         total += static_cast<size_t>(n);
     }
 
-    uint8_t type = buf[0];
-    uint32_t rdata = buf[4] | (buf[5] << 8) | (buf[6] << 16) | (buf[7] << 24);
-    uint32_t irq_bits = buf[8] | (buf[9] << 8) | (buf[10] << 16) | (buf[11] << 24);
+    Message m;
+    m.type = buf[0];
+    m.tag = buf[1];
+    m.version = buf[3];
+    m.data = buf[4] | (buf[5] << 8) | (buf[6] << 16) | (buf[7] << 24);
+    m.irq_bits = buf[8] | (buf[9] << 8) | (buf[10] << 16) | (buf[11] << 24);
+    return m;
+}
+
+// Wait for the response to the oldest outstanding request, handling any
+// IRQ messages that arrive first. Returns read data (0 for write acks).
+Result<uint32_t> SocketTransport::wait_response(uint8_t expected, uint8_t tag) {
+    while (true) {
+        auto result = recv_message();
+        if (!result.ok()) return result.error();
+
+        const Message& m = result.value();
+
+        if (m.type == msg::Irq) {
+            pending_irq_ |= m.irq_bits;
+            continue;
+        }
+
+        if (m.type == msg::Shutdown) {
+            return Error::Shutdown;
+        }
 
-    return std::make_tuple(type, rdata, irq_bits);
+        if (m.type != expected) {
+            logger.error("Unexpected message type %u (expected %u)", m.type, expected);
+            return Error::Protocol;
+        }
+
+        if (v2() && m.tag != tag) {
+            logger.error("Response tag mismatch: got %u, expected %u", m.tag, tag);
+            return Error::Protocol;
+        }
+
+        return m.data;
+    }
+}
+
+template<typename MakeReq>
+Result<void> SocketTransport::pipeline(size_t n, uint8_t type, MakeReq make_req,
+                                       uint32_t *rdata) {
+    if (fd_ < 0) return Error::NotConnected;
+
+    const uint8_t resp_type = (type == msg::Read) ? msg::ReadResp : msg::WriteAck;
+    uint8_t buf[kMaxInflight * kMsgSize];
+    uint8_t tags[kMaxInflight];
+    size_t tag_idx[kMaxInflight];
+
+    for (size_t base = 0; base < n; base += kMaxInflight) {
+        size_t count = std::min(kMaxInflight, n - base);
+        size_t n_acked = 0;
+
+        for (size_t i = 0; i < count; i++) {
+            size_t idx = base + i;
+            auto [addr, wdata] = make_req(idx);
+            uint8_t tag = v2() ? next_tag_++ : 0;
+            bool posted = v2() && type == msg::Write && idx + 1 < n;
+            encode_message(buf + i * kMsgSize, type, addr, wdata, tag,
+                           posted ? msg::FlagPosted : 0);
+            if (!posted) {
+                tags[n_acked] = tag;
+                tag_idx[n_acked] = idx;
+                n_acked++;
+            }
+        }
+        auto rc = send_bytes(buf, count * kMsgSize);
+        if (!rc.ok()) return rc;
+
+        for (size_t i = 0; i < n_acked; i++) {
+            auto resp = wait_response(resp_type, tags[i]);
+            if (!resp.ok()) return resp.error();
+            if (rdata) rdata[tag_idx[i]] = resp.value();
+        }
+    }
+    return {};
 }
 
 // ============================================================================
@@ -172,6 +313,35 @@ Result<void> SocketTransport::connect(std::string_view target) {
     }
 
     logger.info("Connected to %.*s", static_cast<int>(target.size()), target.data());
+    return negotiate();
+}
+
+Result<void> SocketTransport::negotiate() {
+    // Hello rides on a read of the firewall timeout register: always
+    // mapped, on aclk (no CDC), and side-effect free — so a legacy BFM
+    // that ignores the flag still answers it safely.
+    peer_version_ = 1;
+    next_tag_ = 0;
+
+    auto rc = send_message(msg::Read, addr::Firewall + reg::FwTimeoutCycles, 0,
+                           0, msg::FlagHello);
+    if (!rc.ok()) return rc;
+
+    auto result = recv_message();
+    while (result.ok() && result.value().type == msg::Irq) {
+        pending_irq_ |= result.value().irq_bits;
+        result = recv_message();
+    }
+    if (!result.ok()) return result.error();
+    if (result.value().type == msg::Shutdown) return Error::Shutdown;
+    if (result.value().type != msg::ReadResp) {
+        logger.error("Unexpected message type %u during negotiation", result.value().type);
+        return Error::Protocol;
+    }
+
+    uint8_t version = result.value().version;
+    peer_version_ = std::min<uint8_t>(std::max<uint8_t>(version, 1), kProtocolVersion);
+    logger.debug("Wire protocol v%u (BFM reports v%u)", peer_version_, version);
     return {};
 }
 
@@ -186,66 +356,51 @@ void SocketTransport::disconnect() {
 Result<uint32_t> SocketTransport::read32(uint32_t addr) {
     if (fd_ < 0) return Error::NotConnected;
 
-    auto rc = send_message(msg::Read, addr, 0);
+    uint8_t tag = v2() ? next_tag_++ : 0;
+    auto rc = send_message(msg::Read, addr, 0, tag);
     if (!rc.ok()) return rc.error();
 
-    // Wait for response, handling any IRQ messages that arrive first
-    while (true) {
-        auto result = recv_message();
-        if (!result.ok()) return result.error();
-
-        auto [type, rdata, irq_bits] = result.value();
-
-        if (type == msg::Irq) {
-            pending_irq_ |= irq_bits;
-            continue;
-        }
-
-        if (type == msg::Shutdown) {
-            return Error::Shutdown;
-        }
-
-        if (type == msg::ReadResp) {
-            return rdata;
-        }
-
-        logger.error("Unexpected message type %u in read32", type);
-        return Error::Protocol;
-    }
+    return wait_response(msg::ReadResp, tag);
 }
 
 Result<void> SocketTransport::write32(uint32_t addr, uint32_t data) {
     if (fd_ < 0) return Error::NotConnected;
 
-    auto rc = send_message(msg::Write, addr, data);
+    uint8_t tag = v2() ? next_tag_++ : 0;
+    auto rc = send_message(msg::Write, addr, data, tag);
     if (!rc.ok()) return rc.error();
 
-    // Wait for ack, handling any IRQ messages that arrive first
-    while (true) {
-        auto result = recv_message();
-        if (!result.ok()) return result.error();
-
-        auto [type, rdata, irq_bits] = result.value();
+    auto ack = wait_response(msg::WriteAck, tag);
+    if (!ack.ok()) return ack.error();
+    return {};
+}
 
-        if (type == msg::Irq) {
-            pending_irq_ |= irq_bits;
-            continue;
-        }
+Result<void> SocketTransport::read_block(uint32_t addr, std::span<uint32_t> data) {
+    return pipeline(data.size(), msg::Read,
+                    [&](size_t i) { return std::pair<uint32_t, uint32_t>(addr + static_cast<uint32_t>(i * 4), 0); },
+                    data.data());
+}
 
-        if (type == msg::Shutdown) {
-            return Error::Shutdown;
-        }
+Result<void> SocketTransport::write_block(uint32_t addr, std::span<const uint32_t> data) {
+    return pipeline(data.size(), msg::Write,
+                    [&](size_t i) { return std::pair<uint32_t, uint32_t>(addr + static_cast<uint32_t>(i * 4), data[i]); },
+                    nullptr);
+}
 
-        if (type == msg::WriteAck) {
-            return {};
-        }
+Result<void> SocketTransport::read_batch(std::span<const uint32_t> addrs, std::span<uint32_t> data) {
+    if (data.size() < addrs.size()) return Error::InvalidArg;
+    return pipeline(addrs.size(), msg::Read,
+                    [&](size_t i) { return std::pair<uint32_t, uint32_t>(addrs[i], 0); },
+                    data.data());
+}
 
-        logger.error("Unexpected message type %u in write32", type);
-        return Error::Protocol;
-    }
+Result<void> SocketTransport::write_batch(std::span<const RegWrite> writes) {
+    return pipeline(writes.size(), msg::Write,
+                    [&](size_t i) { return std::pair<uint32_t, uint32_t>(writes[i].addr, writes[i].data); },
+                    nullptr);
 }
 
-Result<uint32_t> SocketTransport::wait_irq() {
+Result<uint32_t> SocketTransport::wait_irq(int timeout_ms) {
     if (fd_ < 0) return Error::NotConnected;
 
     // Return any IRQs accumulated during previous AXI transactions
@@ -258,7 +413,23 @@ Result<uint32_t> SocketTransport::wait_irq() {
     // Block on socket until IRQ or shutdown message arrives.
     // Unlike recv_message(), this does NOT retry on EINTR at message
     // boundaries, allowing SIGINT to interrupt the wait.
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
     while (true) {
+        // A bounded wait polls for the start of the next message; once one
+        // has begun it is read to the end
+        if (timeout_ms >= 0) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            pollfd pfd{fd_, POLLIN, 0};
+            int n = ::poll(&pfd, 1, static_cast<int>(std::max<decltype(left)>(left, 0)));
+            if (n < 0) {
+                if (errno == EINTR) return Error::Interrupted;
+                logger.error("poll failed: %s", strerror(errno));
+                return Error::Transport;
+            }
+            if (n == 0) return Error::Timeout;
+        }
+
         uint8_t buf[12];
         size_t total = 0;
         while (total < 12) {
@@ -5,6 +5,16 @@
 //   1. /dev/xdma0_user — via Xilinx XDMA kernel driver (pread/pwrite)
 //   2. sysfs resource   — direct BAR0 mmap (no driver needed)
 //
+// In driver mode, large aligned blocks inside the emu_top window go over
+// the H2C/C2H DMA channels (/dev/xdma0_h2c_0, /dev/xdma0_c2h_0) when they
+// are available. The shell bridges those bursts onto the same AXI-Lite
+// registers used by MMIO.
+//
+// Interrupts arrive on one XDMA user IRQ vector per source (vector i+1 =
+// irq_o[i], see loom_shell.sv); wait_irq() epolls all of their events
+// devices and reports the sources that fired. Vector 0 carried the OR of
+// every source in older shells and is reported as irq_src::All.
+//
 // The target string selects the mode:
 //   /dev/xdma*       → uses pread/pwrite
 //   /sys/bus/pci/...  → mmap the resource file
@@ -15,10 +25,16 @@
 
 #include <fcntl.h>
 #include <unistd.h>
+#include <sys/epoll.h>
 #include <sys/mman.h>
+#include <sys/uio.h>
+#include <algorithm>
+#include <array>
 #include <cerrno>
+#include <climits>
 #include <cstring>
 #include <string>
+#include <vector>
 
 namespace loom {
 
@@ -36,13 +52,40 @@ public:
     void disconnect() override;
     Result<uint32_t> read32(uint32_t addr) override;
     Result<void> write32(uint32_t addr, uint32_t data) override;
-    Result<uint32_t> wait_irq() override;
-    bool has_irq_support() const override { return events_fd_ >= 0; }
+    Result<void> read_block(uint32_t addr, std::span<uint32_t> data) override;
+    Result<void> write_block(uint32_t addr, std::span<const uint32_t> data) override;
+    Result<void> read_batch(std::span<const uint32_t> addrs, std::span<uint32_t> data) override;
+    Result<void> write_batch(std::span<const RegWrite> writes) override;
+    Result<uint32_t> wait_irq(int timeout_ms) override;
+    bool has_irq_support() const override { return events_fds_[0] >= 0; }
     bool is_connected() const override { return mmapped_ ? (bar_ != nullptr) : (fd_ >= 0); }
 
 private:
+    bool in_bar(uint32_t addr, size_t n_words) const {
+        return static_cast<size_t>(addr) + n_words * 4 <= bar_size_;
+    }
+
+    // Length of the DMA-able middle part of [addr, addr + n_words*4):
+    // 16-byte (one AXI4 beat) aligned, inside the emu_top window of the
+    // instance holding addr, and at least kDmaMinBytes long. Returns the
+    // head word count via *head.
+    size_t dma_span(uint32_t addr, size_t n_words, size_t *head) const;
+
+    Result<void> pio_read_block(uint32_t addr, std::span<uint32_t> data);
+    Result<void> pio_write_block(uint32_t addr, std::span<const uint32_t> data);
+
+    // Open /dev/xdma*_events_0 .. _N and register them with epoll
+    void open_events(const std::string& prefix);
+
+    static constexpr size_t kDmaBeatBytes = 16;   // 128-bit XDMA AXI4 data
+    static constexpr size_t kDmaMinBytes = 256;   // below this MMIO wins
+    static constexpr int kIrqVectors = 6;         // xdma_num_usr_irq
+
     int fd_ = -1;
-    int events_fd_ = -1;  // /dev/xdma0_events_0 for MSI support
+    std::array<int, kIrqVectors> events_fds_ = {-1, -1, -1, -1, -1, -1};
+    int epoll_fd_ = -1;   // all events_fds_; -1 = block on events_0 only
+    int h2c_fd_ = -1;     // /dev/xdma0_h2c_0 (host → card DMA)
+    int c2h_fd_ = -1;     // /dev/xdma0_c2h_0 (card → host DMA)
     volatile uint32_t *bar_ = nullptr;
     size_t bar_size_ = 0;
     bool mmapped_ = false;
@@ -70,8 +113,8 @@ Result<void> XdmaTransport::connect(std::string_view target) {
         // Get file size for BAR length
         off_t size = ::lseek(fd_, 0, SEEK_END);
         if (size <= 0) {
-            // Default to 1MB BAR
-            size = 1 << 20;
+            // Default to the shell's 16 MB BAR
+            size = 1 << 24;
         }
         bar_size_ = static_cast<size_t>(size);
 
@@ -98,14 +141,25 @@ Result<void> XdmaTransport::connect(std::string_view target) {
         mmapped_ = false;
         logger.info("Connected to %s (pread/pwrite)", path.c_str());
 
-        // Try to open events device for interrupt support.
-        // Derive path: /dev/xdma0_user → /dev/xdma0_events_0
+        // Try to open the events devices for interrupt support.
+        // Derive path: /dev/xdma0_user → /dev/xdma0_events_N
         auto user_pos = path.find("_user");
         if (user_pos != std::string::npos) {
-            std::string events_path = path.substr(0, user_pos) + "_events_0";
-            events_fd_ = ::open(events_path.c_str(), O_RDONLY);
-            if (events_fd_ >= 0) {
-                logger.info("Opened %s for interrupt support", events_path.c_str());
+            open_events(path.substr(0, user_pos));
+
+            // DMA channels for bulk scan/memory transfers (optional)
+            std::string h2c_path = path.substr(0, user_pos) + "_h2c_0";
+            std::string c2h_path = path.substr(0, user_pos) + "_c2h_0";
+            h2c_fd_ = ::open(h2c_path.c_str(), O_WRONLY);
+            c2h_fd_ = ::open(c2h_path.c_str(), O_RDONLY);
+            if (h2c_fd_ >= 0 && c2h_fd_ >= 0) {
+                logger.info("Opened %s / %s for DMA block transfers",
+                            h2c_path.c_str(), c2h_path.c_str());
+            } else {
+                if (h2c_fd_ >= 0) ::close(h2c_fd_);
+                if (c2h_fd_ >= 0) ::close(c2h_fd_);
+                h2c_fd_ = -1;
+                c2h_fd_ = -1;
             }
         }
     }
@@ -113,10 +167,51 @@ Result<void> XdmaTransport::connect(std::string_view target) {
     return {};
 }
 
+void XdmaTransport::open_events(const std::string& prefix) {
+    for (int i = 0; i < kIrqVectors; i++) {
+        std::string events_path = prefix + "_events_" + std::to_string(i);
+        events_fds_[i] = ::open(events_path.c_str(), O_RDONLY);
+    }
+    if (events_fds_[0] < 0) return;
+
+    epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    for (int i = 0; i < kIrqVectors && epoll_fd_ >= 0; i++) {
+        if (events_fds_[i] < 0) continue;
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.u32 = static_cast<uint32_t>(i);
+        if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, events_fds_[i], &ev) < 0) {
+            logger.warning("epoll_ctl(events_%d) failed: %s", i, strerror(errno));
+            ::close(epoll_fd_);
+            epoll_fd_ = -1;
+            break;
+        }
+    }
+    if (epoll_fd_ >= 0) {
+        logger.info("Opened %s_events_0..%d for interrupt support",
+                    prefix.c_str(), kIrqVectors - 1);
+    } else {
+        logger.info("Opened %s_events_0 for interrupt support (single vector)",
+                    prefix.c_str());
+    }
+}
+
 void XdmaTransport::disconnect() {
-    if (events_fd_ >= 0) {
-        ::close(events_fd_);
-        events_fd_ = -1;
+    if (epoll_fd_ >= 0) {
+        ::close(epoll_fd_);
+        epoll_fd_ = -1;
+    }
+    for (int& efd : events_fds_) {
+        if (efd >= 0) ::close(efd);
+        efd = -1;
+    }
+    if (h2c_fd_ >= 0) {
+        ::close(h2c_fd_);
+        h2c_fd_ = -1;
+    }
+    if (c2h_fd_ >= 0) {
+        ::close(c2h_fd_);
+        c2h_fd_ = -1;
     }
     if (bar_ && bar_ != MAP_FAILED) {
         ::munmap(const_cast<uint32_t *>(bar_), bar_size_);
@@ -171,27 +266,217 @@ Result<void> XdmaTransport::write32(uint32_t addr, uint32_t data) {
     }
 }
 
-Result<uint32_t> XdmaTransport::wait_irq() {
-    if (events_fd_ < 0) {
+size_t XdmaTransport::dma_span(uint32_t addr, size_t n_words, size_t *head) const {
+    uint64_t start = addr;
+    uint64_t end = start + static_cast<uint64_t>(n_words) * 4;
+    // Each emu_top instance window ends where the shell's slaves would be
+    uint64_t window = start & ~uint64_t(addr::InstanceStride - 1);
+    if (start - window >= addr::ClkGen) return 0;
+    end = std::min<uint64_t>(end, window + addr::ClkGen);
+
+    uint64_t a = (start + kDmaBeatBytes - 1) & ~uint64_t(kDmaBeatBytes - 1);
+    uint64_t b = end & ~uint64_t(kDmaBeatBytes - 1);
+    if (b <= a || b - a < kDmaMinBytes) return 0;
+
+    *head = static_cast<size_t>((a - start) / 4);
+    return static_cast<size_t>((b - a) / 4);
+}
+
+// The XDMA user char device transfers one 32-bit register per read()/
+// write() call and advances the file position by 4. preadv()/pwritev()
+// with one 4-byte iovec per word therefore covers a contiguous block in a
+// single syscall (the kernel loops over the iovecs for us).
+
+Result<void> XdmaTransport::read_block(uint32_t addr, std::span<uint32_t> data) {
+    if (!is_connected()) return Error::NotConnected;
+
+    if (mmapped_) {
+        if (!in_bar(addr, data.size())) {
+            logger.error("read_block(0x%05x, %zu) out of range (bar_size=0x%zx)",
+                         addr, data.size(), bar_size_);
+            return Error::InvalidArg;
+        }
+        // Word-by-word volatile copy keeps every access a single 32-bit TLP
+        const volatile uint32_t *src = bar_ + addr / 4;
+        for (size_t i = 0; i < data.size(); i++) data[i] = src[i];
+        return {};
+    }
+
+    size_t head = 0;
+    size_t dma_words = c2h_fd_ >= 0 ? dma_span(addr, data.size(), &head) : 0;
+    if (dma_words == 0) return pio_read_block(addr, data);
+
+    auto rc = pio_read_block(addr, data.first(head));
+    if (!rc.ok()) return rc;
+
+    uint32_t dma_addr = addr + static_cast<uint32_t>(head * 4);
+    size_t bytes = dma_words * 4;
+    ssize_t n = ::pread(c2h_fd_, &data[head], bytes, dma_addr);
+    if (n != static_cast<ssize_t>(bytes)) {
+        logger.error("c2h pread(addr=0x%05x, %zu bytes) failed: %s",
+                     dma_addr, bytes, strerror(errno));
+        return Error::Transport;
+    }
+
+    size_t tail = head + dma_words;
+    return pio_read_block(addr + static_cast<uint32_t>(tail * 4), data.subspan(tail));
+}
+
+Result<void> XdmaTransport::pio_read_block(uint32_t addr, std::span<uint32_t> data) {
+    std::vector<struct iovec> iov(std::min<size_t>(data.size(), IOV_MAX));
+    for (size_t base = 0; base < data.size(); base += iov.size()) {
+        size_t count = std::min(iov.size(), data.size() - base);
+        for (size_t i = 0; i < count; i++) {
+            iov[i].iov_base = &data[base + i];
+            iov[i].iov_len = 4;
+        }
+        off_t off = static_cast<off_t>(addr) + static_cast<off_t>(base * 4);
+        ssize_t n = ::preadv(fd_, iov.data(), static_cast<int>(count), off);
+        if (n != static_cast<ssize_t>(count * 4)) {
+            logger.error("preadv(addr=0x%05lx, %zu words) failed: %s",
+                         static_cast<long>(off), count, strerror(errno));
+            return Error::Transport;
+        }
+    }
+    return {};
+}
+
+Result<void> XdmaTransport::write_block(uint32_t addr, std::span<const uint32_t> data) {
+    if (!is_connected()) return Error::NotConnected;
+
+    if (mmapped_) {
+        if (!in_bar(addr, data.size())) {
+            logger.error("write_block(0x%05x, %zu) out of range (bar_size=0x%zx)",
+                         addr, data.size(), bar_size_);
+            return Error::InvalidArg;
+        }
+        volatile uint32_t *dst = bar_ + addr / 4;
+        for (size_t i = 0; i < data.size(); i++) dst[i] = data[i];
+        return {};
+    }
+
+    size_t head = 0;
+    size_t dma_words = h2c_fd_ >= 0 ? dma_span(addr, data.size(), &head) : 0;
+    if (dma_words == 0) return pio_write_block(addr, data);
+
+    auto rc = pio_write_block(addr, data.first(head));
+    if (!rc.ok()) return rc;
+
+    uint32_t dma_addr = addr + static_cast<uint32_t>(head * 4);
+    size_t bytes = dma_words * 4;
+    ssize_t n = ::pwrite(h2c_fd_, &data[head], bytes, dma_addr);
+    if (n != static_cast<ssize_t>(bytes)) {
+        logger.error("h2c pwrite(addr=0x%05x, %zu bytes) failed: %s",
+                     dma_addr, bytes, strerror(errno));
+        return Error::Transport;
+    }
+
+    size_t tail = head + dma_words;
+    return pio_write_block(addr + static_cast<uint32_t>(tail * 4), data.subspan(tail));
+}
+
+Result<void> XdmaTransport::pio_write_block(uint32_t addr, std::span<const uint32_t> data) {
+    std::vector<struct iovec> iov(std::min<size_t>(data.size(), IOV_MAX));
+    for (size_t base = 0; base < data.size(); base += iov.size()) {
+        size_t count = std::min(iov.size(), data.size() - base);
+        for (size_t i = 0; i < count; i++) {
+            iov[i].iov_base = const_cast<uint32_t *>(&data[base + i]);
+            iov[i].iov_len = 4;
+        }
+        off_t off = static_cast<off_t>(addr) + static_cast<off_t>(base * 4);
+        ssize_t n = ::pwritev(fd_, iov.data(), static_cast<int>(count), off);
+        if (n != static_cast<ssize_t>(count * 4)) {
+            logger.error("pwritev(addr=0x%05lx, %zu words) failed: %s",
+                         static_cast<long>(off), count, strerror(errno));
+            return Error::Transport;
+        }
+    }
+    return {};
+}
+
+// Scatter/gather: mmap mode goes straight to the BAR, pread mode needs one
+// syscall per address (offsets differ, so there is nothing to vectorize).
+
+Result<void> XdmaTransport::read_batch(std::span<const uint32_t> addrs, std::span<uint32_t> data) {
+    if (!is_connected()) return Error::NotConnected;
+    if (data.size() < addrs.size()) return Error::InvalidArg;
+
+    if (!mmapped_) return Transport::read_batch(addrs, data);
+
+    for (size_t i = 0; i < addrs.size(); i++) {
+        if (!in_bar(addrs[i], 1)) {
+            logger.error("read_batch(0x%05x) out of range (bar_size=0x%zx)", addrs[i], bar_size_);
+            return Error::InvalidArg;
+        }
+        data[i] = bar_[addrs[i] / 4];
+    }
+    return {};
+}
+
+Result<void> XdmaTransport::write_batch(std::span<const RegWrite> writes) {
+    if (!is_connected()) return Error::NotConnected;
+
+    if (!mmapped_) return Transport::write_batch(writes);
+
+    for (const auto& w : writes) {
+        if (!in_bar(w.addr, 1)) {
+            logger.error("write_batch(0x%05x) out of range (bar_size=0x%zx)", w.addr, bar_size_);
+            return Error::InvalidArg;
+        }
+        bar_[w.addr / 4] = w.data;
+    }
+    return {};
+}
+
+Result<uint32_t> XdmaTransport::wait_irq(int timeout_ms) {
+    if (events_fds_[0] < 0) {
         return Error::NotSupported;
     }
 
-    // Block until MSI fires (matches kernel driver's wait_event_interruptible).
     // The XDMA driver's events device: read() blocks until an interrupt fires,
-    // then returns the event count and auto-acknowledges.
-    uint32_t events = 0;
-    ssize_t n = ::read(events_fd_, &events, sizeof(events));
+    // then returns the event count and auto-acknowledges. poll() reports it
+    // readable once the vector has fired.
+    auto read_events = [&](int vector) -> Result<void> {
+        uint32_t events = 0;
+        ssize_t n = ::read(events_fds_[vector], &events, sizeof(events));
+        if (n < 0) {
+            if (errno == EINTR) return Error::Interrupted;
+            logger.error("events_%d read failed: %s", vector, strerror(errno));
+            return Error::Transport;
+        }
+        if (n != sizeof(events)) {
+            logger.error("events_%d read: short read (%zd bytes)", vector, n);
+            return Error::Transport;
+        }
+        return {};
+    };
+
+    // Without poll() support on the events devices only an unbounded
+    // read() is left
+    if (epoll_fd_ < 0) {
+        if (timeout_ms >= 0) return Error::NotSupported;
+        auto rc = read_events(0);
+        if (!rc.ok()) return rc.error();
+        return irq_src::All;
+    }
+
+    epoll_event ready[kIrqVectors];
+    int n = ::epoll_wait(epoll_fd_, ready, kIrqVectors, timeout_ms < 0 ? -1 : timeout_ms);
     if (n < 0) {
         if (errno == EINTR) return Error::Interrupted;
-        logger.error("events read failed: %s", strerror(errno));
-        return Error::Transport;
-    }
-    if (n != sizeof(events)) {
-        logger.error("events read: short read (%zd bytes)", n);
+        logger.error("epoll_wait failed: %s", strerror(errno));
         return Error::Transport;
     }
+    if (n == 0) return Error::Timeout;
 
-    return events;
+    uint32_t bits = 0;
+    for (int i = 0; i < n; i++) {
+        int vector = static_cast<int>(ready[i].data.u32);
+        auto rc = read_events(vector);
+        if (!rc.ok()) return rc.error();
+        bits |= vector == 0 ? irq_src::All : 1u << (vector - 1);
+    }
+    return bits ? bits : irq_src::All;
 }
 
 std::unique_ptr<Transport> create_xdma_transport() {
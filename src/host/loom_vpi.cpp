@@ -19,14 +19,17 @@ int vpi_control(int op, ...) {
 
     int result = 0;
 
-    loom::Context* ctx = loom::global_dpi_service().current_context();
+    // Through the service: a callback running on a DPI worker must not
+    // touch the Context, so the service defers the command to its thread
+    loom::DpiService& svc = loom::current_dpi_service();
+    loom::Context* ctx = svc.current_context();
 
     switch (op) {
     case vpiFinish: {
         int exit_code = va_arg(args, int);
         if (ctx) {
             logger.info("vpi_control(vpiFinish, %d)", exit_code);
-            ctx->finish(exit_code);
+            svc.request_finish(exit_code);
         } else {
             logger.warning("vpi_control(vpiFinish, %d) called without context", exit_code);
         }
@@ -35,7 +38,7 @@ int vpi_control(int op, ...) {
     case vpiStop:
         if (ctx) {
             logger.debug("vpi_control(vpiStop)");
-            ctx->stop();
+            svc.request_stop();
         }
         break;
     default:
@@ -51,7 +54,7 @@ int vpi_control(int op, ...) {
 int vpi_printf(const char* fmt, ...) {
     va_list args;
     va_start(args, fmt);
-    int ret = std::vprintf(fmt, args);
+    int ret = loom::log_display_v(fmt, args);
     va_end(args);
     return ret;
 }
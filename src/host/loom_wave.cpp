@@ -0,0 +1,231 @@
+// SPDX-License-Identifier: Apache-2.0
+// Loom Waveform Writer Implementation
+
+#include "loom_wave.h"
+#include "loom_log.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <numeric>
+
+namespace loom {
+
+namespace {
+
+Logger logger = make_logger("wave");
+
+constexpr size_t kQueueDepth = 16;
+constexpr size_t kFlushBytes = 1 << 20;
+
+// Hierarchical name split on '.', for grouping into $scope blocks
+std::vector<std::string> split_path(const std::string& name) {
+    std::vector<std::string> parts;
+    size_t pos = 0;
+    while (true) {
+        size_t dot = name.find('.', pos);
+        parts.push_back(name.substr(pos, dot == std::string::npos ? dot : dot - pos));
+        if (dot == std::string::npos) break;
+        pos = dot + 1;
+    }
+    for (auto& p : parts)
+        std::replace_if(p.begin(), p.end(), [](char c) { return c == ' ' || c == '\t'; }, '_');
+    return parts;
+}
+
+// Short printable identifier code for variable `i` (base 94 from '!')
+std::string vcd_id(size_t i) {
+    std::string id;
+    do {
+        id += static_cast<char>('!' + i % 94);
+        i /= 94;
+    } while (i > 0);
+    return id;
+}
+
+} // namespace
+
+WaveWriter::WaveWriter() : queue_(kQueueDepth) {}
+
+Result<std::unique_ptr<WaveWriter>> WaveWriter::open(const std::string& path, const ScanMap& map,
+                                                     std::span<const std::string> filters,
+                                                     const std::string& timescale) {
+    std::unique_ptr<WaveWriter> w(new WaveWriter());
+    w->path_ = path;
+
+    // Decode only the selected variables
+    ScanMap selected;
+    for (const auto& var : map.variables()) {
+        bool keep = filters.empty() ||
+                    std::any_of(filters.begin(), filters.end(), [&](const std::string& f) {
+                        return var.name().compare(0, f.size(), f) == 0;
+                    });
+        if (!keep || var.width() == 0) continue;
+        *selected.add_variables() = var;
+        w->names_.push_back(var.name());
+        w->widths_.push_back(var.width());
+        w->ids_.push_back(vcd_id(w->ids_.size()));
+    }
+    if (w->names_.empty()) {
+        logger.error("No variables to trace");
+        return Error::InvalidArg;
+    }
+    w->decoder_ = ScanDecoder(selected);
+
+    w->file_ = std::fopen(path.c_str(), "w");
+    if (!w->file_) {
+        logger.error("Cannot open %s: %s", path.c_str(), std::strerror(errno));
+        return Error::InvalidArg;
+    }
+    w->write_header(timescale);
+
+    w->thread_ = std::thread([wp = w.get()] { wp->run(); });
+    return w;
+}
+
+WaveWriter::~WaveWriter() {
+    close();
+}
+
+void WaveWriter::write_header(const std::string& timescale) {
+    buf_ += "$version loom $end\n";
+    buf_ += "$timescale " + timescale + " $end\n";
+
+    // Variables in hierarchy order, so each scope is opened exactly once
+    std::vector<std::vector<std::string>> paths;
+    for (const auto& name : names_)
+        paths.push_back(split_path(name));
+    std::vector<size_t> order(names_.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&](size_t a, size_t b) { return paths[a] < paths[b]; });
+
+    std::vector<std::string> scope;
+    for (size_t i : order) {
+        const auto& p = paths[i];
+        size_t common = 0;
+        while (common < scope.size() && common + 1 < p.size() && scope[common] == p[common])
+            common++;
+        for (size_t s = scope.size(); s > common; s--)
+            buf_ += "$upscope $end\n";
+        scope.resize(common);
+        for (size_t s = common; s + 1 < p.size(); s++) {
+            buf_ += "$scope module " + p[s] + " $end\n";
+            scope.push_back(p[s]);
+        }
+        buf_ += "$var wire " + std::to_string(widths_[i]) + " " + ids_[i] + " " + p.back() +
+                " $end\n";
+    }
+    for (size_t s = scope.size(); s > 0; s--)
+        buf_ += "$upscope $end\n";
+    buf_ += "$enddefinitions $end\n";
+}
+
+void WaveWriter::sample(uint64_t time, std::vector<uint32_t> scan) {
+    Sample s{time, std::move(scan)};
+    while (!queue_.try_push(std::move(s))) std::this_thread::yield();
+    signal_.fetch_add(1, std::memory_order_release);
+    signal_.notify_one();
+    n_samples_++;
+}
+
+void WaveWriter::run() {
+    Sample s;
+    while (true) {
+        if (queue_.try_pop(s)) {
+            write_sample(s);
+            continue;
+        }
+        uint32_t seen = signal_.load(std::memory_order_acquire);
+        if (stop_.load(std::memory_order_acquire)) {
+            if (queue_.try_pop(s)) {
+                write_sample(s);
+                continue;
+            }
+            break;
+        }
+        if (queue_.try_pop(s)) {
+            write_sample(s);
+            continue;
+        }
+        signal_.wait(seen, std::memory_order_acquire);
+    }
+    flush_buffer();
+}
+
+void WaveWriter::write_sample(const Sample& s) {
+    // Samples normally arrive in time order; a rewind moves time backwards,
+    // which VCD cannot express, so such samples are dropped
+    if (!first_ && s.time <= last_time_) {
+        logger.debug("Dropping sample at %llu (last %llu)",
+                     static_cast<unsigned long long>(s.time),
+                     static_cast<unsigned long long>(last_time_));
+        return;
+    }
+
+    decoder_.decode_all(s.scan, values_);
+    buf_ += "#" + std::to_string(s.time) + "\n";
+    if (first_)
+        buf_ += "$dumpvars\n";
+
+    std::span<const uint32_t> now(values_);
+    std::span<const uint32_t> prev(last_);
+    for (size_t i = 0; i < names_.size(); i++) {
+        auto v = decoder_.value(now, i);
+        if (!first_) {
+            auto p = decoder_.value(prev, i);
+            if (std::equal(v.begin(), v.end(), p.begin())) continue;
+        }
+        uint32_t width = widths_[i];
+        if (width == 1) {
+            buf_ += (v[0] & 1) ? '1' : '0';
+        } else {
+            // Leading zeros left out, VCD zero-extends
+            buf_ += 'b';
+            uint32_t top = width;
+            while (top > 1 && !((v[(top - 1) / 32] >> ((top - 1) % 32)) & 1)) top--;
+            for (uint32_t b = top; b-- > 0;)
+                buf_ += ((v[b / 32] >> (b % 32)) & 1) ? '1' : '0';
+            buf_ += ' ';
+        }
+        buf_ += ids_[i];
+        buf_ += '\n';
+    }
+    if (first_)
+        buf_ += "$end\n";
+
+    last_.swap(values_);
+    last_time_ = s.time;
+    first_ = false;
+    if (buf_.size() >= kFlushBytes)
+        flush_buffer();
+}
+
+void WaveWriter::flush_buffer() {
+    if (!buf_.empty() && std::fwrite(buf_.data(), 1, buf_.size(), file_) != buf_.size())
+        io_error_ = true;
+    buf_.clear();
+}
+
+Result<void> WaveWriter::close() {
+    if (!file_)
+        return {};
+    if (thread_.joinable()) {
+        stop_.store(true, std::memory_order_release);
+        signal_.fetch_add(1, std::memory_order_release);
+        signal_.notify_one();
+        thread_.join();
+    } else {
+        flush_buffer();
+    }
+    if (std::fclose(file_) != 0)
+        io_error_ = true;
+    file_ = nullptr;
+    if (io_error_) {
+        logger.error("Failed writing %s", path_.c_str());
+        return Error::InvalidArg;
+    }
+    return {};
+}
+
+} // namespace loom
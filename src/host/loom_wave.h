@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: Apache-2.0
+// Loom Waveform Writer
+//
+// Turns a sequence of scan images into a VCD file. The shell captures an
+// image every N time units (or on request) while the DUT is briefly
+// stopped and hands it to sample(); decoding and formatting run on a
+// background thread so the next slice of emulation overlaps with writing.
+// Only value changes are written, so long idle stretches cost nothing.
+//
+// VCD rather than FST: GTKWave and Surfer read it directly and
+// `vcd2fst` converts it when the file gets large.
+
+#pragma once
+
+#include "loom.h"
+#include "loom_ring.h"
+#include "loom_scan_decode.h"
+#include "loom_snapshot.pb.h"
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace loom {
+
+class WaveWriter {
+public:
+    // Write `map`'s variables (or those starting with one of `filters`) to
+    // `path`. Time stamps are DUT time, in `timescale` units.
+    static Result<std::unique_ptr<WaveWriter>> open(const std::string& path, const ScanMap& map,
+                                                    std::span<const std::string> filters = {},
+                                                    const std::string& timescale = "1ns");
+    ~WaveWriter();
+
+    WaveWriter(const WaveWriter&) = delete;
+    WaveWriter& operator=(const WaveWriter&) = delete;
+
+    const std::string& path() const { return path_; }
+    size_t n_variables() const { return names_.size(); }
+    uint64_t n_samples() const { return n_samples_; }
+
+    // Queue the image captured at `time`. Blocks only while the writer is
+    // a full queue of samples behind.
+    void sample(uint64_t time, std::vector<uint32_t> scan);
+
+    // Drain the queue and close the file
+    Result<void> close();
+
+private:
+    struct Sample {
+        uint64_t time = 0;
+        std::vector<uint32_t> scan;
+    };
+
+    WaveWriter();
+    void write_header(const std::string& timescale);
+    void run();
+    void write_sample(const Sample& s);
+    void flush_buffer();
+
+    std::string path_;
+    FILE* file_ = nullptr;
+    ScanDecoder decoder_;
+    std::vector<std::string> names_;
+    std::vector<uint32_t> widths_;
+    std::vector<std::string> ids_;       // VCD identifier codes
+    std::vector<uint32_t> values_;       // decode buffer
+    std::vector<uint32_t> last_;         // values as of the previous sample
+    bool first_ = true;
+    uint64_t last_time_ = 0;
+    std::string buf_;
+    bool io_error_ = false;
+
+    Ring<Sample> queue_;
+    std::atomic<uint32_t> signal_{0};
+    std::atomic<bool> stop_{false};
+    std::thread thread_;
+    uint64_t n_samples_ = 0;             // queued (owner thread only)
+};
+
+} // namespace loom
@@ -0,0 +1,165 @@
+// SPDX-License-Identifier: Apache-2.0
+// Loom Scan Map Index
+//
+// Companion file to scan_map.pb, written by `scan_insert -index`, that
+// lets the host start without parsing the map. A million-variable map
+// takes seconds to parse; the index is mapped and used in place:
+//
+//   header    magic, version, entry count, hash slots, size of the .pb
+//   entries   {offset, width, pos, len} per variable, in map order;
+//             pos/len locate the encoded ScanVariable within the .pb
+//   slots     open-addressed name hash (FNV-1a, linear probing);
+//             entry index + 1, 0 = empty
+//
+// Offsets and widths come straight from the entry array. Names, enum
+// members and reset values are decoded from the variable's own record
+// only when asked for, so a script that just runs to $finish touches
+// neither the names nor the .pb pages that hold them.
+//
+// All fields are little-endian; the file is only read on the host it was
+// built for (x86-64 / aarch64).
+
+#pragma once
+
+#include "loom_wire.h"
+
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace loom {
+
+struct ScanIndexHeader {
+    char magic[8];          // "LOOMSIDX"
+    uint32_t version;
+    uint32_t n_entries;
+    uint32_t hash_slots;    // power of two, at least 2 * n_entries
+    uint32_t reserved;
+    uint64_t map_size;      // byte size of the indexed scan_map.pb
+};
+
+struct ScanIndexEntry {
+    uint32_t offset;        // ScanVariable.offset
+    uint32_t width;         // ScanVariable.width
+    uint32_t pos;           // encoded ScanVariable within the .pb
+    uint32_t len;
+};
+
+constexpr char kScanIndexMagic[8] = {'L', 'O', 'O', 'M', 'S', 'I', 'D', 'X'};
+constexpr uint32_t kScanIndexVersion = 1;
+
+inline uint32_t scan_index_hash(std::string_view name) {
+    uint32_t h = 2166136261u;
+    for (char c : name) {
+        h ^= static_cast<uint8_t>(c);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Index for a serialized ScanMap; empty if the map is malformed
+inline std::string build_scan_map_index(std::string_view map_bytes) {
+    std::string entries;
+    std::vector<std::string_view> names;
+    WireReader r(map_bytes);
+    WireField f;
+    while (r.next(f)) {
+        if (f.number != 2 || f.type != 2) continue;
+        ScanIndexEntry e{0, 0, static_cast<uint32_t>(f.bytes.data() - map_bytes.data()),
+                         static_cast<uint32_t>(f.bytes.size())};
+        std::string_view name;
+        WireReader vr(f.bytes);
+        WireField vf;
+        while (vr.next(vf)) {
+            if (vf.number == 1 && vf.type == 2) name = vf.bytes;
+            else if (vf.number == 2 && vf.type == 0) e.width = static_cast<uint32_t>(vf.varint);
+            else if (vf.number == 3 && vf.type == 0) e.offset = static_cast<uint32_t>(vf.varint);
+        }
+        if (vr.error()) return {};
+        entries.append(reinterpret_cast<const char*>(&e), sizeof(e));
+        names.push_back(name);
+    }
+    if (r.error()) return {};
+
+    uint32_t slots = 16;
+    while (slots < 2 * names.size()) slots *= 2;
+    std::vector<uint32_t> table(slots, 0);
+    for (size_t i = 0; i < names.size(); i++) {
+        uint32_t s = scan_index_hash(names[i]) & (slots - 1);
+        while (table[s] != 0) s = (s + 1) & (slots - 1);
+        table[s] = static_cast<uint32_t>(i + 1);
+    }
+
+    ScanIndexHeader h{};
+    std::memcpy(h.magic, kScanIndexMagic, sizeof(h.magic));
+    h.version = kScanIndexVersion;
+    h.n_entries = static_cast<uint32_t>(names.size());
+    h.hash_slots = slots;
+    h.map_size = map_bytes.size();
+
+    std::string out(reinterpret_cast<const char*>(&h), sizeof(h));
+    out += entries;
+    out.append(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(uint32_t));
+    return out;
+}
+
+// Read-only view of an index and the map it indexes, both typically mapped
+class ScanMapIndex {
+public:
+    ScanMapIndex() = default;
+
+    // False if `index` is not a valid index of `map`
+    bool open(std::string_view index, std::string_view map) {
+        if (index.size() < sizeof(ScanIndexHeader)) return false;
+        ScanIndexHeader h;
+        std::memcpy(&h, index.data(), sizeof(h));
+        if (std::memcmp(h.magic, kScanIndexMagic, sizeof(h.magic)) != 0 ||
+            h.version != kScanIndexVersion || h.map_size != map.size() ||
+            h.hash_slots == 0 || (h.hash_slots & (h.hash_slots - 1)) != 0)
+            return false;
+        uint64_t need = sizeof(h) + uint64_t{h.n_entries} * sizeof(ScanIndexEntry) +
+                        uint64_t{h.hash_slots} * sizeof(uint32_t);
+        if (index.size() != need) return false;
+        entries_ = reinterpret_cast<const ScanIndexEntry*>(index.data() + sizeof(h));
+        slots_ = reinterpret_cast<const uint32_t*>(entries_ + h.n_entries);
+        n_entries_ = h.n_entries;
+        hash_mask_ = h.hash_slots - 1;
+        map_ = map;
+        return true;
+    }
+
+    bool valid() const { return entries_ != nullptr; }
+    size_t size() const { return n_entries_; }
+    const ScanIndexEntry& entry(size_t i) const { return entries_[i]; }
+
+    // Encoded ScanVariable i (empty if the entry points outside the map)
+    std::string_view record(size_t i) const {
+        const auto& e = entries_[i];
+        if (uint64_t{e.pos} + e.len > map_.size()) return {};
+        return map_.substr(e.pos, e.len);
+    }
+    std::string_view name(size_t i) const { return encoded_name(record(i)); }
+
+    std::optional<size_t> find(std::string_view name) const {
+        uint32_t s = scan_index_hash(name) & hash_mask_;
+        for (uint32_t probes = 0; probes <= hash_mask_; probes++) {
+            uint32_t v = slots_[s];
+            if (v == 0) break;
+            if (v <= n_entries_ && this->name(v - 1) == name) return v - 1;
+            s = (s + 1) & hash_mask_;
+        }
+        return std::nullopt;
+    }
+
+private:
+    const ScanIndexEntry* entries_ = nullptr;
+    const uint32_t* slots_ = nullptr;
+    uint32_t n_entries_ = 0;
+    uint32_t hash_mask_ = 0;
+    std::string_view map_;
+};
+
+} // namespace loom
@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: Apache-2.0
+// Loom Protobuf Wire Walker
+//
+// Minimal protobuf wire-format walker over a mapped buffer. Lets readers
+// find fields of a serialized ScanMap or Snapshot without parsing (or
+// copying) the rest: SnapshotFile uses it on mapped snapshots, the scan
+// map index (loom_map_index.h) to locate variables in scan_map.pb.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace loom {
+
+struct WireField {
+    uint32_t number = 0;
+    uint32_t type = 0;
+    uint64_t varint = 0;       // wire types 0, 1, 5
+    std::string_view bytes;    // wire type 2
+};
+
+class WireReader {
+public:
+    explicit WireReader(std::string_view buf) : p_(buf.data()), end_(buf.data() + buf.size()) {}
+
+    // False at the end of the buffer or on malformed input (see error())
+    bool next(WireField& f) {
+        if (p_ == end_) return false;
+        uint64_t tag;
+        if (!varint(tag)) return fail();
+        f.number = static_cast<uint32_t>(tag >> 3);
+        f.type = static_cast<uint32_t>(tag & 7);
+        switch (f.type) {
+        case 0:
+            if (!varint(f.varint)) return fail();
+            break;
+        case 1:
+        case 5: {
+            size_t n = f.type == 1 ? 8 : 4;
+            if (static_cast<size_t>(end_ - p_) < n) return fail();
+            f.varint = 0;
+            for (size_t i = 0; i < n; i++)
+                f.varint |= static_cast<uint64_t>(static_cast<uint8_t>(p_[i])) << (8 * i);
+            p_ += n;
+            break;
+        }
+        case 2: {
+            uint64_t len;
+            if (!varint(len) || len > static_cast<uint64_t>(end_ - p_)) return fail();
+            f.bytes = std::string_view(p_, len);
+            p_ += len;
+            break;
+        }
+        default:
+            return fail();
+        }
+        return true;
+    }
+
+    bool error() const { return error_; }
+
+private:
+    bool varint(uint64_t& v) {
+        v = 0;
+        for (int shift = 0; shift < 64 && p_ < end_; shift += 7) {
+            uint8_t b = static_cast<uint8_t>(*p_++);
+            v |= static_cast<uint64_t>(b & 0x7F) << shift;
+            if (!(b & 0x80)) return true;
+        }
+        return false;
+    }
+    bool fail() {
+        error_ = true;
+        return false;
+    }
+
+    const char* p_;
+    const char* end_;
+    bool error_ = false;
+};
+
+// Name field (1) of an encoded ScanVariable or MemoryEntry
+inline std::string_view encoded_name(std::string_view var) {
+    WireReader r(var);
+    WireField f;
+    while (r.next(f)) {
+        if (f.number == 1 && f.type == 2) return f.bytes;
+    }
+    return {};
+}
+
+inline uint32_t le32(const char* p) {
+    return static_cast<uint32_t>(static_cast<uint8_t>(p[0]))
+         | static_cast<uint32_t>(static_cast<uint8_t>(p[1])) << 8
+         | static_cast<uint32_t>(static_cast<uint8_t>(p[2])) << 16
+         | static_cast<uint32_t>(static_cast<uint8_t>(p[3])) << 24;
+}
+
+} // namespace loom
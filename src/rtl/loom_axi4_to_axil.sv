@@ -0,0 +1,488 @@
+// SPDX-License-Identifier: Apache-2.0
+// Loom AXI4 → AXI-Lite Bridge (XDMA DMA path)
+//
+// Lets the XDMA H2C/C2H engines reach the emu_top register space, so that
+// bulk transfers (scan data window, memory data window, DPI arguments)
+// move as DMA bursts instead of one 32-bit MMIO TLP per word.
+//
+// Each AXI4 beat of DATA_WIDTH bits is split into DATA_WIDTH/32 AXI-Lite
+// transactions at beat_addr + 4*lane:
+//
+//   Read:  AR → for each lane: AR on AXI-Lite; the R responses are gathered
+//          into one R beat (rlast on the final beat). Lane responses are
+//          merged (any error wins).
+//   Write: AW → for each W beat, for each lane with a non-zero strobe:
+//          AW+W on AXI-Lite → one B response after all of the burst's
+//          AXI-Lite B responses.
+//
+// Requests are pipelined: up to MAX_OUTSTANDING AXI-Lite transactions per
+// channel are in flight, so a burst pays the arbiter → firewall → CDC →
+// demux round trip once instead of once per word. Every request leaves a
+// tag in a per-channel FIFO; responses come back in order (AXI-Lite has no
+// IDs and every stage downstream keeps order), and the tags say which
+// lane, beat and burst each one completes. A new AXI4 burst, of any ID, is
+// accepted as soon as the previous one has been issued, so several bursts
+// can be outstanding; their responses are returned in issue order, which
+// AXI4 allows for any mix of IDs.
+//
+// Only INCR bursts of full-width beats are supported (what the XDMA
+// engines issue). The start address is aligned down to the beat size, so
+// the host issues beat-aligned transfers. Bursts whose start address is
+// at or beyond WINDOW_END are answered with DECERR without touching the
+// AXI-Lite side.
+//
+// Read and write channels are independent. MAX_OUTSTANDING must be a power
+// of two, at least 2, and no more than the firewall's MAX_OUTSTANDING is
+// useful.
+
+module loom_axi4_to_axil #(
+    parameter int unsigned ID_WIDTH        = 4,
+    parameter int unsigned DATA_WIDTH      = 128,
+    parameter int unsigned ADDR_WIDTH      = 20,
+    parameter logic [63:0] WINDOW_END      = 64'h4_0000,
+    parameter int unsigned MAX_OUTSTANDING = 8      // AXI-Lite requests in flight per channel
+)(
+    input  logic clk_i,
+    input  logic rst_ni,
+
+    // AXI4 Slave — Write Address
+    input  logic [ID_WIDTH-1:0]     s_axi_awid,
+    input  logic [63:0]             s_axi_awaddr,
+    input  logic [7:0]              s_axi_awlen,
+    input  logic [2:0]              s_axi_awsize,
+    input  logic [1:0]              s_axi_awburst,
+    input  logic                    s_axi_awlock,
+    input  logic [3:0]              s_axi_awcache,
+    input  logic [2:0]              s_axi_awprot,
+    input  logic                    s_axi_awvalid,
+    output logic                    s_axi_awready,
+
+    // AXI4 Slave — Write Data
+    input  logic [DATA_WIDTH-1:0]   s_axi_wdata,
+    input  logic [DATA_WIDTH/8-1:0] s_axi_wstrb,
+    input  logic                    s_axi_wlast,
+    input  logic                    s_axi_wvalid,
+    output logic                    s_axi_wready,
+
+    // AXI4 Slave — Write Response
+    output logic [ID_WIDTH-1:0]     s_axi_bid,
+    output logic [1:0]              s_axi_bresp,
+    output logic                    s_axi_bvalid,
+    input  logic                    s_axi_bready,
+
+    // AXI4 Slave — Read Address
+    input  logic [ID_WIDTH-1:0]     s_axi_arid,
+    input  logic [63:0]             s_axi_araddr,
+    input  logic [7:0]              s_axi_arlen,
+    input  logic [2:0]              s_axi_arsize,
+    input  logic [1:0]              s_axi_arburst,
+    input  logic                    s_axi_arlock,
+    input  logic [3:0]              s_axi_arcache,
+    input  logic [2:0]              s_axi_arprot,
+    input  logic                    s_axi_arvalid,
+    output logic                    s_axi_arready,
+
+    // AXI4 Slave — Read Data
+    output logic [ID_WIDTH-1:0]     s_axi_rid,
+    output logic [DATA_WIDTH-1:0]   s_axi_rdata,
+    output logic [1:0]              s_axi_rresp,
+    output logic                    s_axi_rlast,
+    output logic                    s_axi_rvalid,
+    input  logic                    s_axi_rready,
+
+    // AXI-Lite Master
+    output logic [ADDR_WIDTH-1:0]   m_axil_araddr_o,
+    output logic                    m_axil_arvalid_o,
+    input  logic                    m_axil_arready_i,
+    input  logic [31:0]             m_axil_rdata_i,
+    input  logic [1:0]              m_axil_rresp_i,
+    input  logic                    m_axil_rvalid_i,
+    output logic                    m_axil_rready_o,
+
+    output logic [ADDR_WIDTH-1:0]   m_axil_awaddr_o,
+    output logic                    m_axil_awvalid_o,
+    input  logic                    m_axil_awready_i,
+    output logic [31:0]             m_axil_wdata_o,
+    output logic [3:0]              m_axil_wstrb_o,
+    output logic                    m_axil_wvalid_o,
+    input  logic                    m_axil_wready_i,
+    input  logic [1:0]              m_axil_bresp_i,
+    input  logic                    m_axil_bvalid_i,
+    output logic                    m_axil_bready_o
+);
+
+    localparam int unsigned LANES       = DATA_WIDTH / 32;
+    localparam int unsigned LANE_W      = LANES > 1 ? $clog2(LANES) : 1;
+    localparam int unsigned BEAT_BYTES  = DATA_WIDTH / 8;
+    localparam int unsigned BEAT_SHIFT  = $clog2(BEAT_BYTES);
+    localparam int unsigned TAG_W       = MAX_OUTSTANDING > 1 ? $clog2(MAX_OUTSTANDING) : 1;
+    localparam logic [1:0]  RESP_OKAY   = 2'b00;
+    localparam logic [1:0]  RESP_DECERR = 2'b11;
+
+    function automatic logic [ADDR_WIDTH-1:0] beat_align(logic [63:0] addr);
+        return {addr[ADDR_WIDTH-1:BEAT_SHIFT], {BEAT_SHIFT{1'b0}}};
+    endfunction
+
+    function automatic logic [ADDR_WIDTH-1:0] lane_addr(logic [ADDR_WIDTH-1:0] beat,
+                                                         logic [LANE_W-1:0] lane);
+        return beat + ADDR_WIDTH'({lane, 2'b00});
+    endfunction
+
+    // Keep the first error seen in a beat (read) or burst (write)
+    function automatic logic [1:0] merge_resp(logic [1:0] acc, logic [1:0] resp);
+        return (acc != RESP_OKAY) ? acc : resp;
+    endfunction
+
+    // =========================================================================
+    // Read Channel
+    // =========================================================================
+    //
+    // Issue side: walks the accepted burst lane by lane, one AXI-Lite AR per
+    // lane, and pushes a tag per AR. Out-of-window bursts push one error tag
+    // per beat instead. Response side: pops tags in order, places each R in
+    // its lane and presents the beat once its last lane is in.
+
+    // Issue state
+    logic                   ar_busy_d,  ar_busy_q;
+    logic [ID_WIDTH-1:0]    ar_id_d,    ar_id_q;
+    logic [7:0]             ar_cnt_d,   ar_cnt_q;    // beats remaining (0 = last)
+    logic [ADDR_WIDTH-1:0]  ar_addr_d,  ar_addr_q;   // current beat address
+    logic [LANE_W-1:0]      ar_lane_d,  ar_lane_q;
+    logic                   ar_err_d,   ar_err_q;    // out-of-window burst
+
+    // Tag FIFO
+    logic [ID_WIDTH-1:0]    rt_id   [MAX_OUTSTANDING];
+    logic [LANE_W-1:0]      rt_lane [MAX_OUTSTANDING];
+    logic                   rt_end  [MAX_OUTSTANDING];  // last lane of its beat
+    logic                   rt_last [MAX_OUTSTANDING];  // last beat of its burst
+    logic                   rt_err  [MAX_OUTSTANDING];  // no AR issued, DECERR
+    logic [TAG_W:0]         rt_head_q, rt_tail_q;
+    logic                   rt_empty, rt_full;
+    logic                   rt_push, rt_pop;
+    logic                   rt_push_end, rt_push_last;
+
+    assign rt_empty = (rt_head_q == rt_tail_q);
+    assign rt_full  = (rt_head_q[TAG_W-1:0] == rt_tail_q[TAG_W-1:0]) &&
+                      (rt_head_q[TAG_W] != rt_tail_q[TAG_W]);
+
+    // Response state
+    logic                   rd_valid_d, rd_valid_q;  // assembled beat on AXI4 R
+    logic [ID_WIDTH-1:0]    rd_id_d,    rd_id_q;
+    logic                   rd_last_d,  rd_last_q;
+    logic [DATA_WIDTH-1:0]  rd_data_d,  rd_data_q;
+    logic [1:0]             rd_resp_d,  rd_resp_q;
+
+    logic [TAG_W-1:0] rt_h;
+    assign rt_h = rt_head_q[TAG_W-1:0];
+
+    always_comb begin
+        ar_busy_d = ar_busy_q;
+        ar_id_d   = ar_id_q;
+        ar_cnt_d  = ar_cnt_q;
+        ar_addr_d = ar_addr_q;
+        ar_lane_d = ar_lane_q;
+        ar_err_d  = ar_err_q;
+
+        rt_push      = 1'b0;
+        rt_push_end  = ar_err_q || (ar_lane_q == LANE_W'(LANES - 1));
+        rt_push_last = rt_push_end && (ar_cnt_q == 8'd0);
+
+        s_axi_arready    = !ar_busy_q;
+        m_axil_araddr_o  = lane_addr(ar_addr_q, ar_lane_q);
+        // Only start an AR with a free tag, so ARVALID never drops unaccepted
+        m_axil_arvalid_o = ar_busy_q && !ar_err_q && !rt_full;
+
+        if (!ar_busy_q) begin
+            if (s_axi_arvalid) begin
+                ar_busy_d = 1'b1;
+                ar_id_d   = s_axi_arid;
+                ar_cnt_d  = s_axi_arlen;
+                ar_addr_d = beat_align(s_axi_araddr);
+                ar_lane_d = '0;
+                ar_err_d  = (s_axi_araddr >= WINDOW_END);
+            end
+        end else if (!rt_full && (ar_err_q || m_axil_arready_i)) begin
+            rt_push = 1'b1;
+            if (!rt_push_end) begin
+                ar_lane_d = ar_lane_q + 1'b1;
+            end else begin
+                ar_lane_d = '0;
+                ar_addr_d = ar_addr_q + ADDR_WIDTH'(BEAT_BYTES);
+                ar_cnt_d  = ar_cnt_q - 8'd1;
+                if (rt_push_last) ar_busy_d = 1'b0;
+            end
+        end
+    end
+
+    always_comb begin
+        rd_valid_d = rd_valid_q;
+        rd_id_d    = rd_id_q;
+        rd_last_d  = rd_last_q;
+        rd_data_d  = rd_data_q;
+        rd_resp_d  = rd_resp_q;
+        rt_pop     = 1'b0;
+
+        s_axi_rvalid    = rd_valid_q;
+        s_axi_rid       = rd_id_q;
+        s_axi_rdata     = rd_data_q;
+        s_axi_rresp     = rd_resp_q;
+        s_axi_rlast     = rd_last_q;
+        m_axil_rready_o = !rd_valid_q && !rt_empty && !rt_err[rt_h];
+
+        if (rd_valid_q) begin
+            if (s_axi_rready) begin
+                rd_valid_d = 1'b0;
+                rd_resp_d  = RESP_OKAY;
+            end
+        end else if (!rt_empty && (rt_err[rt_h] || m_axil_rvalid_i)) begin
+            rt_pop = 1'b1;
+            if (rt_err[rt_h]) begin
+                rd_resp_d = RESP_DECERR;
+            end else begin
+                rd_data_d[rt_lane[rt_h]*32 +: 32] = m_axil_rdata_i;
+                rd_resp_d = merge_resp(rd_resp_q, m_axil_rresp_i);
+            end
+            if (rt_end[rt_h]) begin
+                rd_valid_d = 1'b1;
+                rd_id_d    = rt_id[rt_h];
+                rd_last_d  = rt_last[rt_h];
+            end
+        end
+    end
+
+    always_ff @(posedge clk_i or negedge rst_ni) begin
+        if (!rst_ni) begin
+            ar_busy_q  <= 1'b0;
+            ar_id_q    <= '0;
+            ar_cnt_q   <= 8'd0;
+            ar_addr_q  <= '0;
+            ar_lane_q  <= '0;
+            ar_err_q   <= 1'b0;
+            rt_head_q  <= '0;
+            rt_tail_q  <= '0;
+            rd_valid_q <= 1'b0;
+            rd_id_q    <= '0;
+            rd_last_q  <= 1'b0;
+            rd_data_q  <= '0;
+            rd_resp_q  <= RESP_OKAY;
+        end else begin
+            ar_busy_q  <= ar_busy_d;
+            ar_id_q    <= ar_id_d;
+            ar_cnt_q   <= ar_cnt_d;
+            ar_addr_q  <= ar_addr_d;
+            ar_lane_q  <= ar_lane_d;
+            ar_err_q   <= ar_err_d;
+            rd_valid_q <= rd_valid_d;
+            rd_id_q    <= rd_id_d;
+            rd_last_q  <= rd_last_d;
+            rd_data_q  <= rd_data_d;
+            rd_resp_q  <= rd_resp_d;
+
+            if (rt_push) begin
+                rt_id  [rt_tail_q[TAG_W-1:0]] <= ar_id_q;
+                rt_lane[rt_tail_q[TAG_W-1:0]] <= ar_lane_q;
+                rt_end [rt_tail_q[TAG_W-1:0]] <= rt_push_end;
+                rt_last[rt_tail_q[TAG_W-1:0]] <= rt_push_last;
+                rt_err [rt_tail_q[TAG_W-1:0]] <= ar_err_q;
+                rt_tail_q <= rt_tail_q + 1'b1;
+            end
+            if (rt_pop) rt_head_q <= rt_head_q + 1'b1;
+        end
+    end
+
+    // =========================================================================
+    // Write Channel
+    // =========================================================================
+    //
+    // Issue side: holds one W beat and sends an AXI-Lite AW+W per lane with
+    // a non-zero strobe, pushing a tag per write. Lanes without strobes are
+    // skipped; if the burst's final lane is one of them (or the burst is out
+    // of window) a skip tag still marks the end of the burst. Response
+    // side: pops tags in order, merges B responses and answers the AXI4
+    // burst at its last tag.
+
+    // Issue state
+    logic                    aw_busy_d,    aw_busy_q;
+    logic [ID_WIDTH-1:0]     aw_id_d,      aw_id_q;
+    logic [ADDR_WIDTH-1:0]   aw_addr_d,    aw_addr_q;    // current beat address
+    logic                    aw_err_d,     aw_err_q;
+    logic                    wb_valid_d,   wb_valid_q;   // W beat being split
+    logic [DATA_WIDTH-1:0]   wb_data_d,    wb_data_q;
+    logic [DATA_WIDTH/8-1:0] wb_strb_d,    wb_strb_q;
+    logic                    wb_last_d,    wb_last_q;
+    logic [LANE_W-1:0]       wb_lane_d,    wb_lane_q;
+    logic                    wr_aw_done_d, wr_aw_done_q;
+    logic                    wr_w_done_d,  wr_w_done_q;
+
+    // Tag FIFO
+    logic [ID_WIDTH-1:0]    wt_id   [MAX_OUTSTANDING];
+    logic                   wt_last [MAX_OUTSTANDING];  // last tag of its burst
+    logic                   wt_skip [MAX_OUTSTANDING];  // no AXI-Lite write behind it
+    logic                   wt_err  [MAX_OUTSTANDING];  // out-of-window burst
+    logic [TAG_W:0]         wt_head_q, wt_tail_q;
+    logic                   wt_empty, wt_full;
+    logic                   wt_push, wt_push_skip, wt_pop;
+
+    assign wt_empty = (wt_head_q == wt_tail_q);
+    assign wt_full  = (wt_head_q[TAG_W-1:0] == wt_tail_q[TAG_W-1:0]) &&
+                      (wt_head_q[TAG_W] != wt_tail_q[TAG_W]);
+
+    // Response state
+    logic                   b_valid_d,  b_valid_q;
+    logic [ID_WIDTH-1:0]    b_id_d,     b_id_q;
+    logic [1:0]             wr_resp_d,  wr_resp_q;
+
+    logic [3:0] wb_lane_strb;
+    logic       wb_lane_end;     // last lane of the held beat
+    logic       wb_lane_done;    // current lane written or skipped
+    assign wb_lane_strb = wb_strb_q[wb_lane_q*4 +: 4];
+    assign wb_lane_end  = aw_err_q || (wb_lane_q == LANE_W'(LANES - 1));
+
+    logic [TAG_W-1:0] wt_h;
+    assign wt_h = wt_head_q[TAG_W-1:0];
+
+    always_comb begin
+        aw_busy_d    = aw_busy_q;
+        aw_id_d      = aw_id_q;
+        aw_addr_d    = aw_addr_q;
+        aw_err_d     = aw_err_q;
+        wb_valid_d   = wb_valid_q;
+        wb_data_d    = wb_data_q;
+        wb_strb_d    = wb_strb_q;
+        wb_last_d    = wb_last_q;
+        wb_lane_d    = wb_lane_q;
+        wr_aw_done_d = wr_aw_done_q;
+        wr_w_done_d  = wr_w_done_q;
+
+        wt_push      = 1'b0;
+        wt_push_skip = 1'b1;
+
+        s_axi_awready    = !aw_busy_q;
+        s_axi_wready     = aw_busy_q && !wb_valid_q;
+
+        m_axil_awaddr_o  = lane_addr(aw_addr_q, wb_lane_q);
+        m_axil_wdata_o   = wb_data_q[wb_lane_q*32 +: 32];
+        m_axil_wstrb_o   = wb_lane_strb;
+        m_axil_awvalid_o = 1'b0;
+        m_axil_wvalid_o  = 1'b0;
+
+        if (!aw_busy_q && s_axi_awvalid) begin
+            aw_busy_d = 1'b1;
+            aw_id_d   = s_axi_awid;
+            aw_addr_d = beat_align(s_axi_awaddr);
+            aw_err_d  = (s_axi_awaddr >= WINDOW_END);
+        end
+
+        if (s_axi_wready && s_axi_wvalid) begin
+            wb_valid_d = 1'b1;
+            wb_data_d  = s_axi_wdata;
+            wb_strb_d  = s_axi_wstrb;
+            wb_last_d  = s_axi_wlast;
+            wb_lane_d  = '0;
+        end
+
+        wb_lane_done = 1'b0;
+        if (wb_valid_q && !wt_full) begin
+            if (aw_err_q || wb_lane_strb == 4'b0000) begin
+                // Nothing to write; only the burst's final lane leaves a tag
+                wb_lane_done = 1'b1;
+                wt_push      = wb_lane_end && wb_last_q;
+            end else begin
+                m_axil_awvalid_o = !wr_aw_done_q;
+                m_axil_wvalid_o  = !wr_w_done_q;
+                if (m_axil_awready_i) wr_aw_done_d = 1'b1;
+                if (m_axil_wready_i)  wr_w_done_d  = 1'b1;
+                wb_lane_done = wr_aw_done_d && wr_w_done_d;
+                wt_push      = wb_lane_done;
+                wt_push_skip = 1'b0;
+            end
+
+            if (wb_lane_done) begin
+                wr_aw_done_d = 1'b0;
+                wr_w_done_d  = 1'b0;
+                if (!wb_lane_end) begin
+                    wb_lane_d = wb_lane_q + 1'b1;
+                end else begin
+                    wb_valid_d = 1'b0;
+                    aw_addr_d  = aw_addr_q + ADDR_WIDTH'(BEAT_BYTES);
+                    if (wb_last_q) aw_busy_d = 1'b0;
+                end
+            end
+        end
+    end
+
+    always_comb begin
+        b_valid_d = b_valid_q;
+        b_id_d    = b_id_q;
+        wr_resp_d = wr_resp_q;
+        wt_pop    = 1'b0;
+
+        s_axi_bvalid    = b_valid_q;
+        s_axi_bid       = b_id_q;
+        s_axi_bresp     = wr_resp_q;
+        m_axil_bready_o = !b_valid_q && !wt_empty && !wt_skip[wt_h];
+
+        if (b_valid_q) begin
+            if (s_axi_bready) begin
+                b_valid_d = 1'b0;
+                wr_resp_d = RESP_OKAY;
+            end
+        end else if (!wt_empty && (wt_skip[wt_h] || m_axil_bvalid_i)) begin
+            wt_pop = 1'b1;
+            if (wt_err[wt_h])
+                wr_resp_d = RESP_DECERR;
+            else if (!wt_skip[wt_h])
+                wr_resp_d = merge_resp(wr_resp_q, m_axil_bresp_i);
+            if (wt_last[wt_h]) begin
+                b_valid_d = 1'b1;
+                b_id_d    = wt_id[wt_h];
+            end
+        end
+    end
+
+    always_ff @(posedge clk_i or negedge rst_ni) begin
+        if (!rst_ni) begin
+            aw_busy_q    <= 1'b0;
+            aw_id_q      <= '0;
+            aw_addr_q    <= '0;
+            aw_err_q     <= 1'b0;
+            wb_valid_q   <= 1'b0;
+            wb_data_q    <= '0;
+            wb_strb_q    <= '0;
+            wb_last_q    <= 1'b0;
+            wb_lane_q    <= '0;
+            wr_aw_done_q <= 1'b0;
+            wr_w_done_q  <= 1'b0;
+            wt_head_q    <= '0;
+            wt_tail_q    <= '0;
+            b_valid_q    <= 1'b0;
+            b_id_q       <= '0;
+            wr_resp_q    <= RESP_OKAY;
+        end else begin
+            aw_busy_q    <= aw_busy_d;
+            aw_id_q      <= aw_id_d;
+            aw_addr_q    <= aw_addr_d;
+            aw_err_q     <= aw_err_d;
+            wb_valid_q   <= wb_valid_d;
+            wb_data_q    <= wb_data_d;
+            wb_strb_q    <= wb_strb_d;
+            wb_last_q    <= wb_last_d;
+            wb_lane_q    <= wb_lane_d;
+            wr_aw_done_q <= wr_aw_done_d;
+            wr_w_done_q  <= wr_w_done_d;
+            b_valid_q    <= b_valid_d;
+            b_id_q       <= b_id_d;
+            wr_resp_q    <= wr_resp_d;
+
+            if (wt_push) begin
+                wt_id  [wt_tail_q[TAG_W-1:0]] <= aw_id_q;
+                wt_last[wt_tail_q[TAG_W-1:0]] <= wb_lane_end && wb_last_q;
+                wt_skip[wt_tail_q[TAG_W-1:0]] <= wt_push_skip;
+                wt_err [wt_tail_q[TAG_W-1:0]] <= aw_err_q;
+                wt_tail_q <= wt_tail_q + 1'b1;
+            end
+            if (wt_pop) wt_head_q <= wt_head_q + 1'b1;
+        end
+    end
+
+endmodule
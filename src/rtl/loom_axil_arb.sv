@@ -0,0 +1,250 @@
+// SPDX-License-Identifier: Apache-2.0
+// Loom AXI-Lite 2:1 Arbiter
+//
+// Merges two AXI-Lite masters onto one slave port. Read and write channels
+// are arbitrated independently:
+//
+//   StIdle  → pick a requesting port (round-robin on conflict)
+//   StAddr  → forward the granted port's ARs (or AW+Ws), up to
+//             MAX_OUTSTANDING without a response, while routing R (or B)
+//             back to it
+//   StDrain → the other port is waiting: stop forwarding and hand over once
+//             every response has come back
+//
+// A port streaming pipelined requests keeps the grant until the other
+// port asks, then the two alternate per transaction. AXI-Lite responses
+// carry no ID, so the grant never moves with responses outstanding.
+//
+// The grant is registered before the request is forwarded, so VALID and
+// the address on the master side never change before the handshake.
+// Used in loom_shell to let the XDMA DMA bridge share the emu_top path
+// with host MMIO.
+
+module loom_axil_arb #(
+    parameter int unsigned ADDR_WIDTH      = 20,
+    parameter int unsigned MAX_OUTSTANDING = 8
+)(
+    input  logic clk_i,
+    input  logic rst_ni,
+
+    // Slave ports — flat arrays, port i at [i*W +: W]
+    input  logic [2*ADDR_WIDTH-1:0] s_axil_araddr_i,
+    input  logic [1:0]              s_axil_arvalid_i,
+    output logic [1:0]              s_axil_arready_o,
+    output logic [2*32-1:0]         s_axil_rdata_o,
+    output logic [2*2-1:0]          s_axil_rresp_o,
+    output logic [1:0]              s_axil_rvalid_o,
+    input  logic [1:0]              s_axil_rready_i,
+
+    input  logic [2*ADDR_WIDTH-1:0] s_axil_awaddr_i,
+    input  logic [1:0]              s_axil_awvalid_i,
+    output logic [1:0]              s_axil_awready_o,
+    input  logic [2*32-1:0]         s_axil_wdata_i,
+    input  logic [2*4-1:0]          s_axil_wstrb_i,
+    input  logic [1:0]              s_axil_wvalid_i,
+    output logic [1:0]              s_axil_wready_o,
+    output logic [2*2-1:0]          s_axil_bresp_o,
+    output logic [1:0]              s_axil_bvalid_o,
+    input  logic [1:0]              s_axil_bready_i,
+
+    // Master port
+    output logic [ADDR_WIDTH-1:0]   m_axil_araddr_o,
+    output logic                    m_axil_arvalid_o,
+    input  logic                    m_axil_arready_i,
+    input  logic [31:0]             m_axil_rdata_i,
+    input  logic [1:0]              m_axil_rresp_i,
+    input  logic                    m_axil_rvalid_i,
+    output logic                    m_axil_rready_o,
+
+    output logic [ADDR_WIDTH-1:0]   m_axil_awaddr_o,
+    output logic                    m_axil_awvalid_o,
+    input  logic                    m_axil_awready_i,
+    output logic [31:0]             m_axil_wdata_o,
+    output logic [3:0]              m_axil_wstrb_o,
+    output logic                    m_axil_wvalid_o,
+    input  logic                    m_axil_wready_i,
+    input  logic [1:0]              m_axil_bresp_i,
+    input  logic                    m_axil_bvalid_i,
+    output logic                    m_axil_bready_o
+);
+
+    typedef enum logic [1:0] {
+        StIdle,
+        StAddr,
+        StDrain
+    } state_e;
+
+    localparam int unsigned CNT_W = $clog2(MAX_OUTSTANDING + 1);
+
+    // Round-robin pick: on conflict, prefer the port not served last
+    function automatic logic pick(logic [1:0] req, logic last);
+        if (req == 2'b11) return !last;
+        return req[1];
+    endfunction
+
+    // =========================================================================
+    // Read Channel
+    // =========================================================================
+
+    state_e           rd_state_d, rd_state_q;
+    logic             rd_sel_d,   rd_sel_q;
+    logic [CNT_W-1:0] rd_cnt_d,   rd_cnt_q;    // granted port's Rs still due
+
+    logic rd_ar_fire, rd_r_fire;
+
+    always_comb begin
+        rd_state_d = rd_state_q;
+        rd_sel_d   = rd_sel_q;
+
+        m_axil_araddr_o  = s_axil_araddr_i[rd_sel_q*ADDR_WIDTH +: ADDR_WIDTH];
+        m_axil_arvalid_o = 1'b0;
+        s_axil_arready_o = 2'b00;
+        s_axil_rdata_o   = {2{m_axil_rdata_i}};
+        s_axil_rresp_o   = {2{m_axil_rresp_i}};
+
+        // Responses always belong to the granted port: the grant only moves
+        // once they have all come back
+        m_axil_rready_o           = s_axil_rready_i[rd_sel_q];
+        s_axil_rvalid_o           = 2'b00;
+        s_axil_rvalid_o[rd_sel_q] = m_axil_rvalid_i;
+
+        unique case (rd_state_q)
+            StIdle: begin
+                if (|s_axil_arvalid_i) begin
+                    rd_sel_d   = pick(s_axil_arvalid_i, rd_sel_q);
+                    rd_state_d = StAddr;
+                end
+            end
+
+            StAddr: begin
+                m_axil_arvalid_o = s_axil_arvalid_i[rd_sel_q] &&
+                                   (rd_cnt_q != CNT_W'(MAX_OUTSTANDING));
+                s_axil_arready_o[rd_sel_q] = m_axil_arready_i && m_axil_arvalid_o;
+                // Hand over once the other port asks and no AR is mid-handshake
+                if (s_axil_arvalid_i[!rd_sel_q] && (!m_axil_arvalid_o || m_axil_arready_i))
+                    rd_state_d = StDrain;
+            end
+
+            StDrain: begin
+                if (rd_cnt_q == '0) rd_state_d = StIdle;
+            end
+
+            default: rd_state_d = StIdle;
+        endcase
+
+        rd_ar_fire = m_axil_arvalid_o && m_axil_arready_i;
+        rd_r_fire  = m_axil_rvalid_i && m_axil_rready_o;
+        rd_cnt_d   = rd_cnt_q + CNT_W'(rd_ar_fire) - CNT_W'(rd_r_fire);
+    end
+
+    always_ff @(posedge clk_i or negedge rst_ni) begin
+        if (!rst_ni) begin
+            rd_state_q <= StIdle;
+            rd_sel_q   <= 1'b0;
+            rd_cnt_q   <= '0;
+        end else begin
+            rd_state_q <= rd_state_d;
+            rd_sel_q   <= rd_sel_d;
+            rd_cnt_q   <= rd_cnt_d;
+        end
+    end
+
+    // =========================================================================
+    // Write Channel
+    // =========================================================================
+    //
+    // A port requests on AW or W (either may come first). AW and W are
+    // tracked separately while forwarding, as in loom_axil_demux; a write
+    // counts as outstanding once both have been accepted.
+
+    state_e           wr_state_d, wr_state_q;
+    logic             wr_sel_d,   wr_sel_q;
+    logic [CNT_W-1:0] wr_cnt_d,   wr_cnt_q;    // granted port's Bs still due
+    logic             wr_aw_done_d, wr_aw_done_q;
+    logic             wr_w_done_d,  wr_w_done_q;
+
+    logic wr_issue, wr_b_fire;
+    logic wr_room;
+
+    assign wr_room = (wr_cnt_q != CNT_W'(MAX_OUTSTANDING)) || wr_aw_done_q || wr_w_done_q;
+
+    always_comb begin
+        wr_state_d   = wr_state_q;
+        wr_sel_d     = wr_sel_q;
+        wr_aw_done_d = wr_aw_done_q;
+        wr_w_done_d  = wr_w_done_q;
+        wr_issue     = 1'b0;
+
+        m_axil_awaddr_o  = s_axil_awaddr_i[wr_sel_q*ADDR_WIDTH +: ADDR_WIDTH];
+        m_axil_wdata_o   = s_axil_wdata_i[wr_sel_q*32 +: 32];
+        m_axil_wstrb_o   = s_axil_wstrb_i[wr_sel_q*4 +: 4];
+        m_axil_awvalid_o = 1'b0;
+        m_axil_wvalid_o  = 1'b0;
+        s_axil_awready_o = 2'b00;
+        s_axil_wready_o  = 2'b00;
+        s_axil_bresp_o   = {2{m_axil_bresp_i}};
+
+        m_axil_bready_o           = s_axil_bready_i[wr_sel_q];
+        s_axil_bvalid_o           = 2'b00;
+        s_axil_bvalid_o[wr_sel_q] = m_axil_bvalid_i;
+
+        unique case (wr_state_q)
+            StIdle: begin
+                if (|(s_axil_awvalid_i | s_axil_wvalid_i)) begin
+                    wr_sel_d     = pick(s_axil_awvalid_i | s_axil_wvalid_i, wr_sel_q);
+                    wr_aw_done_d = 1'b0;
+                    wr_w_done_d  = 1'b0;
+                    wr_state_d   = StAddr;
+                end
+            end
+
+            StAddr: begin
+                // The limit is checked before either half goes out, so a
+                // write whose AW or W was accepted always completes
+                m_axil_awvalid_o = s_axil_awvalid_i[wr_sel_q] && !wr_aw_done_q && wr_room;
+                m_axil_wvalid_o  = s_axil_wvalid_i[wr_sel_q]  && !wr_w_done_q  && wr_room;
+                s_axil_awready_o[wr_sel_q] = m_axil_awready_i && m_axil_awvalid_o;
+                s_axil_wready_o[wr_sel_q]  = m_axil_wready_i  && m_axil_wvalid_o;
+                if (m_axil_awvalid_o && m_axil_awready_i) wr_aw_done_d = 1'b1;
+                if (m_axil_wvalid_o  && m_axil_wready_i)  wr_w_done_d  = 1'b1;
+                if (wr_aw_done_d && wr_w_done_d) begin
+                    wr_issue     = 1'b1;
+                    wr_aw_done_d = 1'b0;
+                    wr_w_done_d  = 1'b0;
+                end
+                // Hand over between writes, with nothing mid-handshake
+                if ((s_axil_awvalid_i[!wr_sel_q] || s_axil_wvalid_i[!wr_sel_q]) &&
+                    !wr_aw_done_d && !wr_w_done_d &&
+                    (!m_axil_awvalid_o || m_axil_awready_i) &&
+                    (!m_axil_wvalid_o  || m_axil_wready_i))
+                    wr_state_d = StDrain;
+            end
+
+            StDrain: begin
+                if (wr_cnt_q == '0) wr_state_d = StIdle;
+            end
+
+            default: wr_state_d = StIdle;
+        endcase
+
+        wr_b_fire = m_axil_bvalid_i && m_axil_bready_o;
+        wr_cnt_d  = wr_cnt_q + CNT_W'(wr_issue) - CNT_W'(wr_b_fire);
+    end
+
+    always_ff @(posedge clk_i or negedge rst_ni) begin
+        if (!rst_ni) begin
+            wr_state_q   <= StIdle;
+            wr_sel_q     <= 1'b0;
+            wr_cnt_q     <= '0;
+            wr_aw_done_q <= 1'b0;
+            wr_w_done_q  <= 1'b0;
+        end else begin
+            wr_state_q   <= wr_state_d;
+            wr_sel_q     <= wr_sel_d;
+            wr_cnt_q     <= wr_cnt_d;
+            wr_aw_done_q <= wr_aw_done_d;
+            wr_w_done_q  <= wr_w_done_d;
+        end
+    end
+
+endmodule
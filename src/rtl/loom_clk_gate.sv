@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: Apache-2.0
+// Loom DUT Clock Gate
+//
+// Freezes the DUT by stopping its clock instead of adding an enable to
+// every flop (loom_instrument -clock_gate). The gate is a BUFGCE on the
+// emulation clock, so the gated clock stays on dedicated clock routing
+// and the per-flop enable net and muxes disappear from the DUT.
+//
+// en_i (loom_en | scan_enable) comes from the clk_i domain and is timed
+// like a flop enable: the DUT sees a rising edge on every clk_i edge
+// where en_i was high just before it. clk_i is the BUFG output of
+// xlnx_clk_gen, so this is a BUFG -> BUFGCE cascade; the constraints put
+// both nets in one CLOCK_DELAY_GROUP to keep the shell <-> DUT skew low.
+// In simulation, xilinx_primitives.sv models BUFGCE as a latch gate.
+
+module loom_clk_gate (
+    input  logic clk_i,
+    input  logic en_i,
+    output logic clk_o
+);
+
+    (* DONT_TOUCH = "TRUE" *)
+    BUFGCE #(
+        .CE_TYPE ("SYNC")
+    ) u_bufgce (
+        .O  (clk_o),
+        .CE (en_i),
+        .I  (clk_i)
+    );
+
+endmodule
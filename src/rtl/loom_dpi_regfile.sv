@@ -6,7 +6,8 @@
 // MAX_ARGS is computed from the design's actual DPI argument widths.
 //
 // Per-function register layout:
-//   0x00              FUNC_STATUS   R    Bit 0: pending, Bit 1: done, Bit 2: error
+//   0x00              FUNC_STATUS   R    Bit 0: pending, Bit 1: done, Bit 2: error,
+//                                        Bit 3: DONE_MASK writes supported (always 1)
 //   0x04              FUNC_CONTROL  W    Bit 1: set_done, Bit 2: set_error
 //   0x08..0x08+4*N-4  ARG0..ARGN    R/W  Arguments (N = MAX_ARGS)
 //   0x08+4*N          RESULT_LO     W    Return value [31:0]
@@ -15,13 +16,40 @@
 // Address decoding:
 //   addr[15:6] = function index (up to 1024 functions)
 //   addr[5:0]  = register within function
+//
+// Global pending mask bank (func_idx=1023):
+//   0xFFC0 + 4*k      PENDING[k]    R    Bit j: function 32*k+j pending && !done
+//                                        (k = 0..15, covers 512 functions)
+//                     DONE_MASK[k]  W    Bit j: set_done for function 32*k+j if
+//                                        pending; completes many calls in one write
+//
+// DPI FIFO registers (func_idx=1022, HAS_DPI_FIFO only):
+//   0xFF80            STATUS        R    {level[15:0], 13'b0, stream, full, empty}
+//   0xFF84            CONTROL       R/W  Read: {entry_words, threshold}, Write: bit0=pop
+//   0xFF88 + 4*k      DATA[k]       R    Head entry word k (ARG0 write: threshold)
+//
+// DPI FIFO stream window (func_idx=1021, HAS_DPI_FIFO only):
+//   0xFF40..0xFF7C    STREAM        R    Each read returns the next word of the
+//                                        head entry and pops it after its last
+//                                        word; 0xDEADBEEF when empty
+//
+// Large-argument scratch window (func_idx 512..767, HAS_XARGS only):
+//   0x8000 + 4*k      XARG[k]       R    Word k of the pending call's input arrays
+//                                        (the DUT holds them while it is frozen)
+//                     XRES[k]       W    Word k of the call's output arrays,
+//                                        driven to the DUT until overwritten
+//   Shared by every function whose arrays exceed the arg registers; emu_ctrl
+//   forwards one read-write call at a time, so one window is enough.
 
 module loom_dpi_regfile #(
     parameter int unsigned N_DPI_FUNCS      = 1,
     parameter int unsigned MAX_ARGS         = 8,
     parameter bit          HAS_DPI_FIFO     = 1'b0,
     parameter int unsigned FIFO_ENTRY_WORDS = 4,
-    parameter int unsigned FIFO_DEPTH_LOG2  = 10
+    parameter int unsigned FIFO_DEPTH_LOG2  = 10,
+    parameter bit          HAS_XARGS        = 1'b0,
+    parameter int unsigned XARG_WORDS       = 1,   // <= 4096 each
+    parameter int unsigned XRES_WORDS       = 1
 )(
     input  logic        clk_i,
     input  logic        rst_ni,
@@ -67,7 +95,11 @@ module loom_dpi_regfile #(
     input  logic [FIFO_ENTRY_WORDS*32-1:0]    fifo_wr_data_i,
     output logic                              fifo_full_o,
     output logic                              fifo_empty_o,
-    output logic                              fifo_threshold_o
+    output logic                              fifo_threshold_o,
+
+    // Large-argument window (straight to the DUT, bypassing emu_ctrl)
+    input  logic [XARG_WORDS-1:0][31:0]           dpi_xargs_i,
+    output logic [XRES_WORDS-1:0][31:0]           dpi_xresult_o
 );
 
     // =========================================================================
@@ -139,11 +171,23 @@ module loom_dpi_regfile #(
     assign wr_pending = wr_addr_valid_q && wr_data_valid_q && !axil_bvalid_o
                         && (wr_func_idx < N_DPI_FUNCS);
 
+    // Done mask write decode (func_idx == 1023)
+    logic wr_done_mask_pending;
+    assign wr_done_mask_pending = wr_addr_valid_q && wr_data_valid_q && !axil_bvalid_o
+                                  && (wr_func_idx == 10'd1023);
+
     // FIFO write decode (func_idx == 1022)
     logic wr_fifo_pending;
     assign wr_fifo_pending = wr_addr_valid_q && wr_data_valid_q && !axil_bvalid_o
                              && (wr_func_idx == 10'd1022);
 
+    // Scratch window write decode (addr[15:14] == 2'b10)
+    logic wr_xres_pending;
+    logic [11:0] wr_xres_idx;
+    assign wr_xres_idx = wr_addr_q[13:2];
+    assign wr_xres_pending = wr_addr_valid_q && wr_data_valid_q && !axil_bvalid_o
+                             && (wr_addr_q[15:14] == 2'b10) && HAS_XARGS;
+
     // Combinational next-state (merges DPI call events + host AXI writes)
     always_comb begin
         for (int i = 0; i < N_DPI_FUNCS; i++) begin
@@ -179,6 +223,11 @@ module loom_dpi_regfile #(
                     end
                 endcase
             end
+
+            // Coalesced completion: one DONE_MASK word covers 32 functions
+            if (wr_done_mask_pending && wr_reg_idx == 6'(i / 32) &&
+                wr_data_q[i % 32] && func_state_q[i].pending && !func_state_q[i].done)
+                func_state_d[i].done = 1'b1;
         end
     end
 
@@ -199,6 +248,21 @@ module loom_dpi_regfile #(
         end
     end
 
+    // =========================================================================
+    // Large-argument scratch window
+    // =========================================================================
+
+    logic [XRES_WORDS-1:0][31:0] xres_q;
+    assign dpi_xresult_o = xres_q;
+
+    always_ff @(posedge clk_i or negedge rst_ni) begin
+        if (!rst_ni) begin
+            xres_q <= '0;
+        end else if (wr_xres_pending && 32'(wr_xres_idx) < XRES_WORDS) begin
+            xres_q[wr_xres_idx] <= wr_data_q;
+        end
+    end
+
     // =========================================================================
     // DPI FIFO (read-only DPI call buffering)
     // =========================================================================
@@ -207,12 +271,19 @@ module loom_dpi_regfile #(
     logic [15:0] fifo_rd_level;
     logic [15:0] fifo_rd_threshold;
     logic [31:0] fifo_rd_head_word;
+    logic [31:0] fifo_rd_stream_word;
 
     // AXI read address decode — declared here so the FIFO generate block
     // can reference rd_reg_idx without a forward-reference warning
     logic [15:0] rd_addr_q;
+    logic        rd_pending_q;
+    logic        axil_rvalid_q;
     logic [5:0]  rd_reg_idx;
+    logic        rd_stream_fire;
     assign rd_reg_idx = rd_addr_q[5:2];
+    // A STREAM read is answered this cycle and consumes one head word
+    assign rd_stream_fire = rd_pending_q && !axil_rvalid_q && rd_addr_q[15:6] == 10'd1021 &&
+                            HAS_DPI_FIFO && !fifo_empty_o;
 
     generate if (HAS_DPI_FIFO) begin : gen_fifo
         localparam int DEPTH = 2**FIFO_DEPTH_LOG2;
@@ -238,6 +309,11 @@ module loom_dpi_regfile #(
         for (genvar w = 0; w < FIFO_ENTRY_WORDS; w++) begin : gen_head_words
             assign head_words[w] = fifo_mem[rd_ptr_q[FIFO_DEPTH_LOG2-1:0]][w*32 +: 32];
         end
+        // Stream window position within the head entry
+        localparam int unsigned WORD_BITS = (FIFO_ENTRY_WORDS <= 1) ? 1 : $clog2(FIFO_ENTRY_WORDS);
+        logic [WORD_BITS-1:0] head_word_q;
+        assign fifo_rd_stream_word = head_words[head_word_q];
+
         always_comb begin
             fifo_rd_head_word = 32'h0;
             if (!fifo_empty_o && (rd_reg_idx >= REG_ARG0) &&
@@ -262,18 +338,31 @@ module loom_dpi_regfile #(
             end
         end
 
-        // Read side (host pop via AXI write to func_idx=1022, CONTROL, bit0)
+        // Read side: host pop via AXI write to func_idx=1022, CONTROL, bit0,
+        // or by reading the last word of the head entry through STREAM.
+        // Hosts use one or the other; a CONTROL pop restarts the window.
         always_ff @(posedge clk_i or negedge rst_ni) begin
             if (!rst_ni) begin
                 rd_ptr_q    <= '0;
+                head_word_q <= '0;
                 threshold_q <= {{FIFO_DEPTH_LOG2{1'b0}}, 1'b1};  // default: 1 (trigger on any entry)
             end else begin
+                if (rd_stream_fire) begin
+                    if (head_word_q == WORD_BITS'(FIFO_ENTRY_WORDS - 1)) begin
+                        rd_ptr_q    <= rd_ptr_q + 1;
+                        head_word_q <= '0;
+                    end else begin
+                        head_word_q <= head_word_q + WORD_BITS'(1);
+                    end
+                end
                 if (wr_fifo_pending) begin
                     case (wr_reg_idx)
                         REG_CONTROL: begin
                             // bit0 = pop
-                            if (wr_data_q[0] && !fifo_empty_o)
-                                rd_ptr_q <= rd_ptr_q + 1;
+                            if (wr_data_q[0] && !fifo_empty_o && !rd_stream_fire) begin
+                                rd_ptr_q    <= rd_ptr_q + 1;
+                                head_word_q <= '0;
+                            end
                         end
                         REG_ARG0: begin
                             // Threshold register write
@@ -292,22 +381,23 @@ module loom_dpi_regfile #(
         assign fifo_rd_level     = 16'b0;
         assign fifo_rd_threshold = 16'b0;
         assign fifo_rd_head_word = 32'h0;
+        assign fifo_rd_stream_word = 32'h0;
     end endgenerate
 
     // =========================================================================
     // AXI-Lite Read Interface
     // =========================================================================
 
-    logic        rd_pending_q;
     logic [9:0]  rd_func_idx;
     assign rd_func_idx = rd_addr_q[15:6];
+    assign axil_rvalid_o = axil_rvalid_q;
 
     always_ff @(posedge clk_i or negedge rst_ni) begin
         if (!rst_ni) begin
             rd_pending_q   <= 1'b0;
             rd_addr_q      <= 16'd0;
             axil_arready_o <= 1'b0;
-            axil_rvalid_o  <= 1'b0;
+            axil_rvalid_q  <= 1'b0;
             axil_rdata_o   <= 32'd0;
             axil_rresp_o   <= 2'b00;
         end else begin
@@ -318,22 +408,31 @@ module loom_dpi_regfile #(
                 rd_pending_q <= 1'b1;
             end
 
-            if (rd_pending_q && !axil_rvalid_o) begin
-                axil_rvalid_o <= 1'b1;
+            if (rd_pending_q && !axil_rvalid_q) begin
+                axil_rvalid_q <= 1'b1;
                 axil_rresp_o  <= 2'b00;
 
-                if (rd_func_idx == 10'd1023) begin
-                    // Global DPI pending mask — one bit per function
+                if (rd_addr_q[15:14] == 2'b10 && HAS_XARGS) begin
+                    // Scratch window: input array words of the pending call
+                    if (32'(rd_addr_q[13:2]) < XARG_WORDS)
+                        axil_rdata_o <= dpi_xargs_i[rd_addr_q[13:2]];
+                    else
+                        axil_rdata_o <= 32'hDEAD_BEEF;
+                end else if (rd_func_idx == 10'd1023) begin
+                    // Global DPI pending mask bank — word k covers functions
+                    // [32*k, 32*k+31]
                     axil_rdata_o <= 32'd0;
-                    for (int i = 0; i < N_DPI_FUNCS && i < 32; i++)
-                        axil_rdata_o[i] <= func_state_q[i].pending & ~func_state_q[i].done;
+                    for (int i = 0; i < N_DPI_FUNCS && i < 512; i++)
+                        if ((i / 32) == int'(rd_reg_idx))
+                            axil_rdata_o[i % 32] <= func_state_q[i].pending & ~func_state_q[i].done;
                 end else if (rd_func_idx == 10'd1022 && HAS_DPI_FIFO) begin
                     // FIFO registers at func_idx=1022
                     case (rd_reg_idx)
                         REG_STATUS: begin
-                            // {level[15:0], 14'b0, full, empty}
+                            // {level[15:0], 13'b0, stream, full, empty}
                             axil_rdata_o <= {fifo_rd_level[15:0],
-                                             14'b0,
+                                             13'b0,
+                                             1'b1,
                                              fifo_full_o,
                                              fifo_empty_o};
                         end
@@ -353,9 +452,13 @@ module loom_dpi_regfile #(
                             end
                         end
                     endcase
+                end else if (rd_func_idx == 10'd1021 && HAS_DPI_FIFO) begin
+                    // FIFO stream window: next word of the head entry
+                    axil_rdata_o <= fifo_empty_o ? 32'hDEAD_BEEF : fifo_rd_stream_word;
                 end else if (rd_func_idx < N_DPI_FUNCS) begin
                     case (rd_reg_idx)
-                        REG_STATUS: axil_rdata_o <= {29'd0,
+                        REG_STATUS: axil_rdata_o <= {28'd0,
+                                                     1'b1,
                                                      func_state_q[rd_func_idx].error,
                                                      func_state_q[rd_func_idx].done,
                                                      func_state_q[rd_func_idx].pending};
@@ -377,8 +480,8 @@ module loom_dpi_regfile #(
                 rd_pending_q <= 1'b0;
             end
 
-            if (axil_rvalid_o && axil_rready_i) begin
-                axil_rvalid_o <= 1'b0;
+            if (axil_rvalid_q && axil_rready_i) begin
+                axil_rvalid_q <= 1'b0;
             end
         end
     end
@@ -412,8 +515,10 @@ module loom_dpi_regfile #(
             end
 
             if (wr_addr_valid_q && wr_data_valid_q && !axil_bvalid_o) begin
-                // Accept writes to valid function indices, pending mask, or FIFO
-                if (wr_func_idx < N_DPI_FUNCS || wr_func_idx == 10'd1022 || wr_func_idx == 10'd1023) begin
+                // Accept writes to valid function indices, pending mask, FIFO
+                // or scratch window
+                if (wr_func_idx < N_DPI_FUNCS || wr_func_idx == 10'd1022 || wr_func_idx == 10'd1023 ||
+                    wr_xres_pending) begin
                     wr_addr_valid_q <= 1'b0;
                     wr_data_valid_q <= 1'b0;
                     axil_bvalid_o   <= 1'b1;
@@ -12,11 +12,23 @@
 // Stepping is implemented in software by setting time_cmp = time + N
 // then issuing CMD_START.
 //
+// A bank of N_TRIGGERS comparators watches the watch_i probe (flip-flops
+// routed out by scan_insert -watch) and freezes the DUT on the cycle the
+// combined condition holds, before the next DUT edge. Each comparator
+// selects one 32-bit probe word and matches it against value/mask:
+//   mode 0 (equal)   masked word == value
+//   mode 1 (enter)   equal now but not on the previous DUT cycle
+//   mode 2 (change)  masked bits differ from the previous DUT cycle
+// Enabled comparators are ORed, or ANDed with TRIG_CTRL[8]. The bank only
+// fires after the DUT has advanced one cycle in the current run, so
+// resuming from a breakpoint always makes progress. The freeze raises the
+// state-change IRQ; IRQ_STATUS[5] and TRIG_HIT say a trigger caused it.
+//
 // Register Map (offset from base 0x0000):
 //   0x00  EMU_STATUS       R     Current emulation state
 //   0x04  EMU_CONTROL      W     Command register
-//   0x08  EMU_CYCLE_LO     R     DUT cycle counter [31:0]
-//   0x0C  EMU_CYCLE_HI     R     DUT cycle counter [63:32]
+//   0x08  EMU_CYCLE_LO     RW    DUT cycle counter [31:0] (writable while frozen)
+//   0x0C  EMU_CYCLE_HI     RW    DUT cycle counter [63:32]
 //   0x10  EMU_CLK_DIV      W     Clock divider (0 = full speed)
 //   0x14  N_DPI_FUNCS      R     Number of DPI functions
 //   0x18  N_MEMORIES       R     Number of shadow-ported memories
@@ -25,10 +37,12 @@
 //   0x24  MAX_ARGS         R     Max DPI arguments per function
 //   0x28  SHELL_VERSION    R     Shell semver (0xMMNNPP)
 //   0x2C  IRQ_STATUS       R     Aggregated IRQ status
-//   0x30  IRQ_ENABLE       W     Aggregated IRQ enable
+//                                [1]=dpi, [2]=state_change, [3]=scan_done, [4]=mem_done,
+//                                [5]=trigger (cleared by the next CMD_START)
+//   0x30  IRQ_ENABLE       RW    Aggregated IRQ enable (same bit positions)
 //   0x34  EMU_FINISH       RW    Finish request: [0]=req, [15:8]=exit_code
-//   0x38  EMU_TIME_LO      R     DUT time counter [31:0]
-//   0x3C  EMU_TIME_HI      R     DUT time counter [63:32]
+//   0x38  EMU_TIME_LO      RW    DUT time counter [31:0] (writable while frozen)
+//   0x3C  EMU_TIME_HI      RW    DUT time counter [63:32]
 //   0x40  EMU_TIME_CMP_LO  RW    Time compare [31:0]
 //   0x44  EMU_TIME_CMP_HI  RW    Time compare [63:32]
 //   0x48  DESIGN_HASH_0    R     SHA-256 [31:0]
@@ -39,6 +53,38 @@
 //   0x5C  DESIGN_HASH_5    R     SHA-256 [191:160]
 //   0x60  DESIGN_HASH_6    R     SHA-256 [223:192]
 //   0x64  DESIGN_HASH_7    R     SHA-256 [255:224]
+//   0x68  TRACE_BITS       R     Probe bits recorded by loom_trace_ctrl (0 = none)
+//
+// Performance counters (host clock cycles, free-running, see below):
+//   0x6C  PERF_CTRL        RW    R: [0]=counters present; W: [0]=clear all
+//   0x70  PERF_RUN_LO      R     Cycles running (state Running, below time cmp)
+//   0x74  PERF_RUN_HI      R
+//   0x78  PERF_EN_LO       R     Cycles with loom_en high
+//   0x7C  PERF_EN_HI       R
+//   0x80  PERF_DPI_LO      R     Cycles stalled on a blocking DPI call
+//   0x84  PERF_DPI_HI      R
+//   0x88  PERF_FIFO_LO     R     Cycles stalled on a full DPI FIFO
+//   0x8C  PERF_FIFO_HI     R
+//   0x90  PERF_FUNC_SEL    RW    Function index for PERF_FUNC_*
+//   0x94  PERF_FUNC_LO     R     DPI stall cycles of function PERF_FUNC_SEL
+//   0x98  PERF_FUNC_HI     R     (read advances PERF_FUNC_SEL by one)
+//
+// Triggers (see above):
+//   0x9C  WATCH_BITS       R     Width of watch_i (0 = no triggers)
+//   0xA0  TRIG_CTRL        RW    [3:0]=comparator enable, [8]=AND combine,
+//                                R: [31:24]=N_TRIGGERS
+//   0xA4  TRIG_HIT         R     [3:0]=comparators matching when the bank fired,
+//                                [31]=fired (cleared by the next CMD_START)
+//
+// Instances (emu_top -instances):
+//   0xA8  INSTANCE         R     [7:0]=this instance, [15:8]=N_INSTANCES
+//
+//   0xC0 + 16*k  TRIG_SEL   RW   Comparator k: [15:0]=probe word, [17:16]=mode
+//   0xC4 + 16*k  TRIG_MASK  RW   Comparator k: bits compared
+//   0xC8 + 16*k  TRIG_VALUE RW   Comparator k: value (mode 0/1)
+//
+// Reading a PERF_*_LO register latches the matching high word, which the
+// next PERF_*_HI read returns, so a LO/HI pair is never torn while running.
 
 module loom_emu_ctrl #(
     parameter int unsigned N_DPI_FUNCS     = 1,
@@ -57,6 +103,9 @@ module loom_emu_ctrl #(
     parameter logic [31:0] DESIGN_HASH_5  = 32'h0,
     parameter logic [31:0] DESIGN_HASH_6  = 32'h0,
     parameter logic [31:0] DESIGN_HASH_7  = 32'h0,
+    parameter int unsigned TRACE_BITS     = 0,
+    parameter int unsigned WATCH_BITS     = 0,
+    parameter int unsigned N_INSTANCES    = 1,   // DUT copies behind one shell
     // DPI FIFO parameters (read-only DPI call buffering)
     parameter logic [255:0] RO_FUNC_MASK    = '0,
     parameter int unsigned  FIFO_ENTRY_WORDS = 4,
@@ -65,6 +114,9 @@ module loom_emu_ctrl #(
     input  logic        clk_i,
     input  logic        rst_ni,
 
+    // Index of this DUT copy (0 unless emu_top -instances)
+    input  logic [7:0]  instance_id_i,
+
     // AXI-Lite Slave interface
     input  logic [7:0]  axil_araddr_i,
     input  logic        axil_arvalid_i,
@@ -112,8 +164,20 @@ module loom_emu_ctrl #(
     // Finish output
     output logic        finish_o,
 
-    // IRQ output
+    // Scan/memory controller completion (level, cleared via their STATUS)
+    input  logic        scan_done_i,
+    input  logic        mem_done_i,
+
+    // Trace RAM full in lossless mode: hold the DUT until the host drains it
+    input  logic        trace_stall_i,
+
+    // Watched flip-flops (scan_insert -watch), compared by the trigger bank
+    input  logic [(WATCH_BITS > 0 ? WATCH_BITS : 1)-1:0] watch_i,
+
+    // IRQ outputs
     output logic        irq_state_change_o,
+    output logic        irq_scan_done_o,
+    output logic        irq_mem_done_o,
 
     // DPI FIFO write interface (for read-only DPI calls)
     output logic                              fifo_wr_valid_o,
@@ -148,6 +212,9 @@ module loom_emu_ctrl #(
     localparam logic [7:0] CMD_SNAPSHOT = 8'h04;
     localparam logic [7:0] CMD_RESTORE  = 8'h05;
 
+    localparam int unsigned N_TRIGGERS  = 4;
+    localparam int unsigned WATCH_WORDS = WATCH_BITS > 0 ? (WATCH_BITS + 31) / 32 : 1;
+
     // =========================================================================
     // Signals
     // =========================================================================
@@ -204,8 +271,57 @@ module loom_emu_ctrl #(
     logic [31:0] wr_time_cmp_lo_data;
     logic        wr_time_cmp_hi_en;
     logic [31:0] wr_time_cmp_hi_data;
+    logic        wr_cycle_lo_en;
+    logic [31:0] wr_cycle_lo_data;
+    logic        wr_cycle_hi_en;
+    logic [31:0] wr_cycle_hi_data;
+    logic        wr_time_lo_en;
+    logic [31:0] wr_time_lo_data;
+    logic        wr_time_hi_en;
+    logic [31:0] wr_time_hi_data;
     logic        wr_finish_en;
     logic [15:0] wr_finish_data;
+    logic        wr_perf_clear;
+    logic        wr_perf_sel_en;
+    logic [7:0]  wr_perf_sel_data;
+    logic        wr_trig_ctrl_en;
+    logic [31:0] wr_trig_ctrl_data;
+    logic        wr_trig_en;
+    logic [1:0]  wr_trig_idx;
+    logic [1:0]  wr_trig_field;
+    logic [31:0] wr_trig_data;
+
+    // Trigger bank
+    logic [WATCH_WORDS-1:0][31:0] watch_words;
+    logic [N_TRIGGERS-1:0][17:0]  trig_sel_q;
+    logic [N_TRIGGERS-1:0][31:0]  trig_mask_q;
+    logic [N_TRIGGERS-1:0][31:0]  trig_value_q;
+    logic [N_TRIGGERS-1:0][31:0]  trig_prev_q;     // probe word before the last DUT edge
+    logic [N_TRIGGERS-1:0]        trig_eq_prev_q;
+    logic [N_TRIGGERS-1:0][31:0]  trig_word;
+    logic [N_TRIGGERS-1:0]        trig_eq;
+    logic [N_TRIGGERS-1:0]        trig_match;
+    logic [N_TRIGGERS-1:0]        trig_en_q;
+    logic                         trig_and_q;
+    logic                         trig_armed_q;    // DUT advanced in this run
+    logic [N_TRIGGERS-1:0]        trig_hit_q;
+    logic                         trig_fired_q;
+    logic                         trig_fire;
+
+    // Performance counters
+    logic [63:0]                  perf_run_q;
+    logic [63:0]                  perf_en_q;
+    logic [63:0]                  perf_dpi_q;
+    logic [63:0]                  perf_fifo_q;
+    logic [N_DPI_FUNCS-1:0][63:0] perf_func_q;
+    logic [7:0]                   perf_sel_q;
+    logic [31:0]                  perf_hi_q;
+    logic [63:0]                  perf_func_rd;
+
+    // Read-side perf updates (from AXI read comb)
+    logic        rd_perf_hi_en;
+    logic [31:0] rd_perf_hi_data;
+    logic        rd_perf_advance;
 
     // =========================================================================
     // loom_en: Single Authoritative DUT Enable (combinational)
@@ -231,7 +347,133 @@ module loom_emu_ctrl #(
     logic finish_wait_fifo;
     assign finish_wait_fifo = HAS_DPI_FIFO && finish_req_latched_q && !fifo_empty_i;
 
-    assign loom_en_o = emu_running && !ro_stall && !rw_stall && !finish_wait_fifo;
+    assign loom_en_o = emu_running && !ro_stall && !rw_stall && !finish_wait_fifo &&
+                       !trace_stall_i && !trig_fire;
+
+    // =========================================================================
+    // Trigger Bank
+    // =========================================================================
+
+    // Zero-extended to whole words (emu_top ties watch_i low without -watch)
+    assign watch_words = watch_i;
+
+    always_comb begin
+        for (int k = 0; k < N_TRIGGERS; k++) begin
+            trig_word[k] = (int'(trig_sel_q[k][15:0]) < int'(WATCH_WORDS))
+                           ? watch_words[trig_sel_q[k][15:0]] : 32'd0;
+            trig_eq[k] = ((trig_word[k] ^ trig_value_q[k]) & trig_mask_q[k]) == 32'd0;
+            unique case (trig_sel_q[k][17:16])
+                2'd1:    trig_match[k] = trig_eq[k] && !trig_eq_prev_q[k];
+                2'd2:    trig_match[k] = ((trig_word[k] ^ trig_prev_q[k]) & trig_mask_q[k]) != 32'd0;
+                default: trig_match[k] = trig_eq[k];
+            endcase
+        end
+    end
+
+    // Combinational so the DUT holds the matching state: loom_en_o drops in
+    // the same cycle
+    assign trig_fire = WATCH_BITS > 0 && state_q == StRunning && trig_armed_q &&
+                       (trig_en_q != '0) &&
+                       (trig_and_q ? ((trig_match | ~trig_en_q) == '1)
+                                   : ((trig_match & trig_en_q) != '0));
+
+    always_ff @(posedge clk_i or negedge rst_ni) begin
+        if (!rst_ni) begin
+            trig_sel_q     <= '0;
+            trig_mask_q    <= '0;
+            trig_value_q   <= '0;
+            trig_prev_q    <= '0;
+            trig_eq_prev_q <= '0;
+            trig_en_q      <= '0;
+            trig_and_q     <= 1'b0;
+            trig_armed_q   <= 1'b0;
+            trig_hit_q     <= '0;
+            trig_fired_q   <= 1'b0;
+        end else begin
+            // Track the probe while frozen too, so a run never starts on a
+            // stale edge after a restore
+            if (loom_en_o || state_q != StRunning) begin
+                trig_prev_q    <= trig_word;
+                trig_eq_prev_q <= trig_eq;
+            end
+            trig_armed_q <= state_q == StRunning && (trig_armed_q || loom_en_o);
+
+            if (trig_fire) begin
+                trig_hit_q   <= trig_match & trig_en_q;
+                trig_fired_q <= 1'b1;
+            end else if (state_q != StRunning && state_d == StRunning) begin
+                trig_hit_q   <= '0;
+                trig_fired_q <= 1'b0;
+            end
+
+            if (wr_trig_ctrl_en) begin
+                trig_en_q  <= wr_trig_ctrl_data[N_TRIGGERS-1:0];
+                trig_and_q <= wr_trig_ctrl_data[8];
+            end
+            if (wr_trig_en) begin
+                unique case (wr_trig_field)
+                    2'd0:    trig_sel_q[wr_trig_idx]   <= wr_trig_data[17:0];
+                    2'd1:    trig_mask_q[wr_trig_idx]  <= wr_trig_data;
+                    2'd2:    trig_value_q[wr_trig_idx] <= wr_trig_data;
+                    default: ;
+                endcase
+            end
+        end
+    end
+
+    // =========================================================================
+    // Performance Counters
+    // =========================================================================
+
+    // Free-running host-clock counters: how long the DUT ran, and how much of
+    // that it spent held by the host. Only PERF_CTRL clears them.
+    always_ff @(posedge clk_i or negedge rst_ni) begin
+        if (!rst_ni) begin
+            perf_run_q  <= 64'd0;
+            perf_en_q   <= 64'd0;
+            perf_dpi_q  <= 64'd0;
+            perf_fifo_q <= 64'd0;
+            perf_func_q <= '0;
+        end else if (wr_perf_clear) begin
+            perf_run_q  <= 64'd0;
+            perf_en_q   <= 64'd0;
+            perf_dpi_q  <= 64'd0;
+            perf_fifo_q <= 64'd0;
+            perf_func_q <= '0;
+        end else if (emu_running) begin
+            perf_run_q <= perf_run_q + 64'd1;
+            if (loom_en_o) begin
+                perf_en_q <= perf_en_q + 64'd1;
+            end
+            if (rw_stall) begin
+                perf_dpi_q <= perf_dpi_q + 64'd1;
+                if (int'(dut_dpi_func_id_i) < int'(N_DPI_FUNCS)) begin
+                    perf_func_q[dut_dpi_func_id_i] <= perf_func_q[dut_dpi_func_id_i] + 64'd1;
+                end
+            end
+            if (ro_stall) begin
+                perf_fifo_q <= perf_fifo_q + 64'd1;
+            end
+        end
+    end
+
+    always_ff @(posedge clk_i or negedge rst_ni) begin
+        if (!rst_ni) begin
+            perf_sel_q <= 8'd0;
+            perf_hi_q  <= 32'd0;
+        end else begin
+            if (wr_perf_sel_en) begin
+                perf_sel_q <= wr_perf_sel_data;
+            end else if (rd_perf_advance) begin
+                perf_sel_q <= perf_sel_q + 8'd1;
+            end
+            if (rd_perf_hi_en) begin
+                perf_hi_q <= rd_perf_hi_data;
+            end
+        end
+    end
+
+    assign perf_func_rd = (int'(perf_sel_q) < int'(N_DPI_FUNCS)) ? perf_func_q[perf_sel_q] : 64'd0;
 
     // =========================================================================
     // Emulation State Machine (combinational)
@@ -251,7 +493,7 @@ module loom_emu_ctrl #(
             end
 
             StRunning: begin
-                if (finish_reg_q[0] || time_count_q >= time_cmp_q) begin
+                if (finish_reg_q[0] || time_count_q >= time_cmp_q || trig_fire) begin
                     state_d = StFrozen;
                 end else if (cmd_valid_q) begin
                     unique case (cmd_reg_q)
@@ -367,14 +609,17 @@ module loom_emu_ctrl #(
     // DPI FIFO Write (read-only DPI calls — single-cycle push)
     // =========================================================================
 
-    // Pack func_id into word[0][7:0], args into word[1..N-1]
+    // Pack func_id into word[0][7:0], the low 24 bits of the DUT cycle
+    // counter into word[0][31:8], args into word[1..N-1]. The host extends
+    // the stamp against a full cycle count read when it drains the FIFO.
     assign fifo_wr_valid_o = emu_running && dut_dpi_valid_i
                              && dpi_is_readonly && fifo_wr_ready_i;
 
     always_comb begin
         fifo_wr_data_o = '0;
-        // Word 0: func_id in [7:0]
-        fifo_wr_data_o[7:0] = dut_dpi_func_id_i;
+        // Word 0: {cycle[23:0], func_id}
+        fifo_wr_data_o[7:0]  = dut_dpi_func_id_i;
+        fifo_wr_data_o[31:8] = cycle_count_q[23:0];
         // Words 1..N-1: args (pack from DUT args bus)
         for (int w = 0; w < FIFO_ENTRY_WORDS - 1 && w < MAX_ARG_WIDTH / 32; w++) begin
             fifo_wr_data_o[(w+1)*32 +: 32] = dut_dpi_args_i[w*32 +: 32];
@@ -449,6 +694,15 @@ module loom_emu_ctrl #(
         if (wr_irq_enable_en)  irq_enable_d  = wr_irq_enable_data;
         if (wr_time_cmp_lo_en) time_cmp_d[31:0]  = wr_time_cmp_lo_data;
         if (wr_time_cmp_hi_en) time_cmp_d[63:32] = wr_time_cmp_hi_data;
+
+        // Counter writes (snapshot restore / rewind): only while frozen, so
+        // they never race the increment above
+        if (state_q == StFrozen) begin
+            if (wr_cycle_lo_en) cycle_count_d[31:0]  = wr_cycle_lo_data;
+            if (wr_cycle_hi_en) cycle_count_d[63:32] = wr_cycle_hi_data;
+            if (wr_time_lo_en)  time_count_d[31:0]   = wr_time_lo_data;
+            if (wr_time_hi_en)  time_count_d[63:32]  = wr_time_hi_data;
+        end
         if (wr_finish_en && !finish_reg_q[0]) begin
             finish_reg_d = wr_finish_data;
         end
@@ -497,6 +751,8 @@ module loom_emu_ctrl #(
     assign cycle_count_o     = cycle_count_q;
     assign finish_o          = finish_reg_q[0];
     assign irq_state_change_o = state_changed_q && irq_enable_q[2];
+    assign irq_scan_done_o    = scan_done_i && irq_enable_q[3];
+    assign irq_mem_done_o     = mem_done_i && irq_enable_q[4];
 
     // FIFO IRQ: assert when FIFO has entries pending drain (especially during finish)
     // This wakes the host to drain the FIFO when a $finish is pending.
@@ -514,6 +770,10 @@ module loom_emu_ctrl #(
         rdata_d      = rdata_q;
         rresp_d      = rresp_q;
 
+        rd_perf_hi_en   = 1'b0;
+        rd_perf_hi_data = 32'd0;
+        rd_perf_advance = 1'b0;
+
         if (axil_arvalid_i && arready_q) begin
             rd_addr_d    = axil_araddr_i;
             rd_pending_d = 1'b1;
@@ -535,7 +795,8 @@ module loom_emu_ctrl #(
                 6'h08:   rdata_d = TOTAL_SCAN_BITS;                // 0x20 TOTAL_SCAN_BITS
                 6'h09:   rdata_d = MAX_ARGS;                       // 0x24 MAX_ARGS
                 6'h0A:   rdata_d = SHELL_VERSION;                  // 0x28 SHELL_VERSION
-                6'h0B:   rdata_d = {29'd0, state_changed_q, (dpi_state_q != StDpiIdle), 1'b0}; // 0x2C IRQ_STATUS
+                6'h0B:   rdata_d = {26'd0, trig_fired_q, mem_done_i, scan_done_i, state_changed_q,
+                                    (dpi_state_q != StDpiIdle), 1'b0};    // 0x2C IRQ_STATUS
                 6'h0C:   rdata_d = irq_enable_q;                   // 0x30 IRQ_ENABLE
                 6'h0D:   rdata_d = {16'd0, finish_reg_q};          // 0x34 EMU_FINISH
                 6'h0E:   rdata_d = time_count_q[31:0];             // 0x38 EMU_TIME_LO
@@ -550,6 +811,63 @@ module loom_emu_ctrl #(
                 6'h17:   rdata_d = DESIGN_HASH_5;                  // 0x5C DESIGN_HASH_5
                 6'h18:   rdata_d = DESIGN_HASH_6;                  // 0x60 DESIGN_HASH_6
                 6'h19:   rdata_d = DESIGN_HASH_7;                  // 0x64 DESIGN_HASH_7
+                6'h1A:   rdata_d = TRACE_BITS;                     // 0x68 TRACE_BITS
+                6'h1B:   rdata_d = 32'd1;                          // 0x6C PERF_CTRL
+                6'h1C: begin                                       // 0x70 PERF_RUN_LO
+                    rdata_d         = perf_run_q[31:0];
+                    rd_perf_hi_en   = 1'b1;
+                    rd_perf_hi_data = perf_run_q[63:32];
+                end
+                6'h1E: begin                                       // 0x78 PERF_EN_LO
+                    rdata_d         = perf_en_q[31:0];
+                    rd_perf_hi_en   = 1'b1;
+                    rd_perf_hi_data = perf_en_q[63:32];
+                end
+                6'h20: begin                                       // 0x80 PERF_DPI_LO
+                    rdata_d         = perf_dpi_q[31:0];
+                    rd_perf_hi_en   = 1'b1;
+                    rd_perf_hi_data = perf_dpi_q[63:32];
+                end
+                6'h22: begin                                       // 0x88 PERF_FIFO_LO
+                    rdata_d         = perf_fifo_q[31:0];
+                    rd_perf_hi_en   = 1'b1;
+                    rd_perf_hi_data = perf_fifo_q[63:32];
+                end
+                6'h1D, 6'h1F, 6'h21, 6'h23:
+                         rdata_d = perf_hi_q;                      // 0x74..0x8C PERF_*_HI
+                6'h24:   rdata_d = {24'd0, perf_sel_q};            // 0x90 PERF_FUNC_SEL
+                6'h25: begin                                       // 0x94 PERF_FUNC_LO
+                    rdata_d         = perf_func_rd[31:0];
+                    rd_perf_hi_en   = 1'b1;
+                    rd_perf_hi_data = perf_func_rd[63:32];
+                end
+                6'h26: begin                                       // 0x98 PERF_FUNC_HI
+                    rdata_d         = perf_hi_q;
+                    rd_perf_advance = 1'b1;
+                end
+                6'h27:   rdata_d = WATCH_BITS;                     // 0x9C WATCH_BITS
+                6'h28: begin                                       // 0xA0 TRIG_CTRL
+                    rdata_d                   = 32'd0;
+                    rdata_d[N_TRIGGERS-1:0]   = trig_en_q;
+                    rdata_d[8]                = trig_and_q;
+                    rdata_d[31:24]            = 8'(N_TRIGGERS);
+                end
+                6'h29: begin                                       // 0xA4 TRIG_HIT
+                    rdata_d                   = 32'd0;
+                    rdata_d[N_TRIGGERS-1:0]   = trig_hit_q;
+                    rdata_d[31]               = trig_fired_q;
+                end
+                6'h2A:   rdata_d = {16'd0, 8'(N_INSTANCES), instance_id_i};  // 0xA8 INSTANCE
+                6'h30, 6'h31, 6'h32,
+                6'h34, 6'h35, 6'h36,
+                6'h38, 6'h39, 6'h3A,
+                6'h3C, 6'h3D, 6'h3E: begin                         // 0xC0.. TRIG_*
+                    unique case (rd_addr_q[3:2])
+                        2'd0:    rdata_d = {14'd0, trig_sel_q[rd_addr_q[5:4]]};
+                        2'd1:    rdata_d = trig_mask_q[rd_addr_q[5:4]];
+                        default: rdata_d = trig_value_q[rd_addr_q[5:4]];
+                    endcase
+                end
                 default: rdata_d = 32'hDEAD_BEEF;
             endcase
         end
@@ -608,8 +926,25 @@ module loom_emu_ctrl #(
         wr_time_cmp_lo_data = 32'd0;
         wr_time_cmp_hi_en   = 1'b0;
         wr_time_cmp_hi_data = 32'd0;
+        wr_cycle_lo_en      = 1'b0;
+        wr_cycle_lo_data    = 32'd0;
+        wr_cycle_hi_en      = 1'b0;
+        wr_cycle_hi_data    = 32'd0;
+        wr_time_lo_en       = 1'b0;
+        wr_time_lo_data     = 32'd0;
+        wr_time_hi_en       = 1'b0;
+        wr_time_hi_data     = 32'd0;
         wr_finish_en        = 1'b0;
         wr_finish_data      = 16'd0;
+        wr_perf_clear       = 1'b0;
+        wr_perf_sel_en      = 1'b0;
+        wr_perf_sel_data    = 8'd0;
+        wr_trig_ctrl_en     = 1'b0;
+        wr_trig_ctrl_data   = 32'd0;
+        wr_trig_en          = 1'b0;
+        wr_trig_idx         = 2'd0;
+        wr_trig_field       = 2'd0;
+        wr_trig_data        = 32'd0;
 
         if (axil_awvalid_i && awready_q) begin
             wr_addr_d       = axil_awaddr_i;
@@ -627,6 +962,14 @@ module loom_emu_ctrl #(
                     wr_cmd_valid = 1'b1;
                     wr_cmd_data  = wr_data_q[7:0];
                 end
+                6'h02: begin  // 0x08 EMU_CYCLE_LO
+                    wr_cycle_lo_en   = 1'b1;
+                    wr_cycle_lo_data = wr_data_q;
+                end
+                6'h03: begin  // 0x0C EMU_CYCLE_HI
+                    wr_cycle_hi_en   = 1'b1;
+                    wr_cycle_hi_data = wr_data_q;
+                end
                 6'h04: begin  // 0x10 EMU_CLK_DIV
                     wr_clk_div_en   = 1'b1;
                     wr_clk_div_data = wr_data_q;
@@ -641,6 +984,14 @@ module loom_emu_ctrl #(
                         wr_finish_data = wr_data_q[15:0];
                     end
                 end
+                6'h0E: begin  // 0x38 EMU_TIME_LO
+                    wr_time_lo_en   = 1'b1;
+                    wr_time_lo_data = wr_data_q;
+                end
+                6'h0F: begin  // 0x3C EMU_TIME_HI
+                    wr_time_hi_en   = 1'b1;
+                    wr_time_hi_data = wr_data_q;
+                end
                 6'h10: begin  // 0x40 EMU_TIME_CMP_LO
                     wr_time_cmp_lo_en   = 1'b1;
                     wr_time_cmp_lo_data = wr_data_q;
@@ -649,6 +1000,26 @@ module loom_emu_ctrl #(
                     wr_time_cmp_hi_en   = 1'b1;
                     wr_time_cmp_hi_data = wr_data_q;
                 end
+                6'h1B: begin  // 0x6C PERF_CTRL
+                    wr_perf_clear = wr_data_q[0];
+                end
+                6'h24: begin  // 0x90 PERF_FUNC_SEL
+                    wr_perf_sel_en   = 1'b1;
+                    wr_perf_sel_data = wr_data_q[7:0];
+                end
+                6'h28: begin  // 0xA0 TRIG_CTRL
+                    wr_trig_ctrl_en   = 1'b1;
+                    wr_trig_ctrl_data = wr_data_q;
+                end
+                6'h30, 6'h31, 6'h32,
+                6'h34, 6'h35, 6'h36,
+                6'h38, 6'h39, 6'h3A,
+                6'h3C, 6'h3D, 6'h3E: begin  // 0xC0.. TRIG_SEL/MASK/VALUE
+                    wr_trig_en    = 1'b1;
+                    wr_trig_idx   = wr_addr_q[5:4];
+                    wr_trig_field = wr_addr_q[3:2];
+                    wr_trig_data  = wr_data_q;
+                end
                 default: ;
             endcase
 
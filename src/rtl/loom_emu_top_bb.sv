@@ -8,7 +8,7 @@ module loom_emu_top (
     input  wire         rst_ni,
 
     // AXI-Lite slave interface
-    input  wire [19:0]  s_axil_araddr_i,
+    input  wire [23:0]  s_axil_araddr_i,
     input  wire         s_axil_arvalid_i,
     output wire         s_axil_arready_o,
     output wire [31:0]  s_axil_rdata_o,
@@ -16,7 +16,7 @@ module loom_emu_top (
     output wire         s_axil_rvalid_o,
     input  wire         s_axil_rready_i,
 
-    input  wire [19:0]  s_axil_awaddr_i,
+    input  wire [23:0]  s_axil_awaddr_i,
     input  wire         s_axil_awvalid_i,
     output wire         s_axil_awready_o,
     input  wire [31:0]  s_axil_wdata_i,
@@ -5,10 +5,17 @@
 // partial reconfiguration via PCIe.
 //
 // Register Map (offset from base 0x6_0000):
-//   0x00  STATUS (R)  [0]=busy, [1]=prdone (sticky), [2]=prerror (sticky)
-//   0x04  CTRL   (W)  [0]=sw_reset (clears sticky bits, returns FSM to idle)
-//   0x08  DATA   (W)  bitstream word — AXI backpressure holds awready low
-//                     while the previous word is being presented to ICAP
+//   0x00  STATUS (R)  [0]=busy, [1]=prdone (sticky), [2]=prerror (sticky),
+//                     [3]=fifo full
+//   0x04  CTRL   (W)  [0]=sw_reset (clears sticky bits, flushes the FIFO)
+//   0x08  DATA   (W)  bitstream word, queued in the FIFO — AXI backpressure
+//                     holds awready low while the FIFO is full
+//   0x0C  DEPTH  (R)  FIFO depth in words (0 on controllers without the FIFO)
+//   0x1000-0x1FFF     DATA window: any word address queues like DATA, so a
+//                     host can burst a whole chunk with one block write
+//
+// The FIFO feeds ICAPE3 one word per cycle while AVAIL is high, so ICAP
+// runs at its 400 MB/s line rate however the host's writes arrive.
 //
 // Data format:
 //   Host writes raw bytes from the .bit file (after stripping the header up
@@ -22,7 +29,8 @@
 //   ICAPE3 stub from src/bfm/xilinx_primitives.sv is used automatically.
 
 module loom_icap_ctrl #(
-    parameter int unsigned ADDR_WIDTH = 20
+    parameter int unsigned ADDR_WIDTH = 20,
+    parameter int unsigned FIFO_DEPTH = 1024   // words, power of 2
 )(
     input  logic clk_i,
     input  logic rst_ni,
@@ -53,6 +61,9 @@ module loom_icap_ctrl #(
     localparam logic [1:0] REG_STATUS = 2'h0;  // 0x00
     localparam logic [1:0] REG_CTRL   = 2'h1;  // 0x04
     localparam logic [1:0] REG_DATA   = 2'h2;  // 0x08
+    localparam logic [1:0] REG_DEPTH  = 2'h3;  // 0x0C
+
+    localparam int unsigned PTR_BITS = $clog2(FIFO_DEPTH);
 
     // =========================================================================
     // Per-byte bit-reversal (UG570 Table 2-7)
@@ -92,28 +103,34 @@ module loom_icap_ctrl #(
     // =========================================================================
     // AXI-Lite Write Tracking
     // AW and W channels are tracked separately (per AXI-Lite spec).
-    // For DATA register writes awready is suppressed while ICAP is busy,
-    // providing natural backpressure one word at a time.
+    // For DATA writes awready is suppressed while the FIFO is full.
     // =========================================================================
     logic        aw_pending_q;
     logic [1:0]  aw_addr_q;
+    logic        aw_data_q;   // pending AW targets DATA or the DATA window
     logic        w_pending_q;
     logic [31:0] w_data_q;
     logic        bvalid_q;
 
     // =========================================================================
-    // FSM
+    // Bitstream FIFO and ICAP feed
     // =========================================================================
-    typedef enum logic [1:0] {
-        StIdle      = 2'b00,
-        StWaitAvail = 2'b01,
-        StWrite     = 2'b10
-    } state_e;
+    logic [31:0]       fifo_mem [FIFO_DEPTH];
+    logic [PTR_BITS:0] wr_ptr_q, rd_ptr_q;
+    logic              fifo_empty, fifo_full;
+    logic              fifo_push, fifo_pop;
+    logic [31:0]       data_q;    // bit-reversed word presented to ICAP
+    logic              csib_q;    // ICAP chip select (active low)
+    logic              prdone_q;  // sticky
+    logic              prerror_q; // sticky
+
+    assign fifo_empty = (wr_ptr_q == rd_ptr_q);
+    assign fifo_full  = (wr_ptr_q[PTR_BITS] != rd_ptr_q[PTR_BITS]) &&
+                        (wr_ptr_q[PTR_BITS-1:0] == rd_ptr_q[PTR_BITS-1:0]);
+    assign fifo_pop   = !fifo_empty && icap_avail;
 
-    state_e      state_q, state_d;
-    logic [31:0] data_q;    // bit-reversed data staged for ICAP
-    logic        prdone_q;  // sticky
-    logic        prerror_q; // sticky
+    assign icap_csib = csib_q;
+    assign icap_din  = data_q;
 
     // =========================================================================
     // Combinational logic (unified always_comb)
@@ -122,14 +139,15 @@ module loom_icap_ctrl #(
     logic is_data_wr;
     logic both_done;
     logic [1:0] exec_aw_addr;
+    logic exec_aw_data;
     logic exec_data, exec_ctrl_reset;
 
     always_comb begin
         // AW/W handshake
-        is_data_wr = (s_axil_awaddr_i[3:2] == REG_DATA);
+        is_data_wr = s_axil_awaddr_i[12] || (s_axil_awaddr_i[3:2] == REG_DATA);
 
-        // For DATA writes: accept AW only when FSM is idle (backpressure)
-        s_axil_awready_o = !aw_pending_q && (!is_data_wr || state_q == StIdle);
+        // For DATA writes: accept AW only while the FIFO has room (backpressure)
+        s_axil_awready_o = !aw_pending_q && (!is_data_wr || !fifo_full);
         s_axil_wready_o  = !w_pending_q;
 
         aw_accepted = s_axil_awvalid_i && s_axil_awready_o;
@@ -140,37 +158,32 @@ module loom_icap_ctrl #(
 
         // Resolve which AW/W values to act on
         exec_aw_addr = aw_accepted ? s_axil_awaddr_i[3:2] : aw_addr_q;
+        exec_aw_data = aw_accepted ? is_data_wr : aw_data_q;
 
         // Decode write operation (fire when both channels done and no B pending)
         exec_data       = 1'b0;
         exec_ctrl_reset = 1'b0;
         if (both_done && !bvalid_q) begin
-            case (exec_aw_addr)
-                REG_DATA: exec_data       = 1'b1;
-                REG_CTRL: exec_ctrl_reset = w_accepted ? s_axil_wdata_i[0] : w_data_q[0];
-                default:  ;  // STATUS is read-only
-            endcase
+            if (exec_aw_data) begin
+                exec_data = 1'b1;
+            end else if (exec_aw_addr == REG_CTRL) begin
+                exec_ctrl_reset = w_accepted ? s_axil_wdata_i[0] : w_data_q[0];
+            end
+            // STATUS and DEPTH are read-only
         end
 
-        // FSM next-state
-        state_d   = state_q;
-        icap_csib = 1'b1;
-        icap_din  = data_q;
+        // A DATA AW was only accepted with room, and nothing else pushes
+        fifo_push = exec_data && !exec_ctrl_reset;
+    end
 
-        unique case (state_q)
-            StIdle: begin
-                if (exec_data)
-                    state_d = icap_avail ? StWrite : StWaitAvail;
-            end
-            StWaitAvail: begin
-                if (icap_avail) state_d = StWrite;
-            end
-            StWrite: begin
-                icap_csib = 1'b0;
-                state_d   = StIdle;
-            end
-            default: state_d = StIdle;
-        endcase
+    // =========================================================================
+    // FIFO storage (no reset, infers block RAM)
+    // =========================================================================
+    always_ff @(posedge clk_i) begin
+        if (fifo_push)
+            fifo_mem[wr_ptr_q[PTR_BITS-1:0]] <= w_accepted ? s_axil_wdata_i : w_data_q;
+        if (fifo_pop)
+            data_q <= bit_rev_bytes(fifo_mem[rd_ptr_q[PTR_BITS-1:0]]);
     end
 
     // =========================================================================
@@ -178,32 +191,41 @@ module loom_icap_ctrl #(
     // =========================================================================
     always_ff @(posedge clk_i or negedge rst_ni) begin
         if (!rst_ni) begin
-            state_q      <= StIdle;
-            data_q       <= '0;
+            wr_ptr_q     <= '0;
+            rd_ptr_q     <= '0;
+            csib_q       <= 1'b1;
             prdone_q     <= 1'b0;
             prerror_q    <= 1'b0;
             aw_pending_q <= 1'b0;
             aw_addr_q    <= '0;
+            aw_data_q    <= 1'b0;
             w_pending_q  <= 1'b0;
             w_data_q     <= '0;
             bvalid_q     <= 1'b0;
         end else begin
-            state_q <= state_d;
-
-            // Stage bit-reversed data for ICAP presentation
-            if (exec_data) data_q <= bit_rev_bytes(w_accepted ? s_axil_wdata_i : w_data_q);
+            // Present one FIFO word per cycle while ICAP is available
+            csib_q <= !fifo_pop;
+            if (fifo_push) wr_ptr_q <= wr_ptr_q + 1;
+            if (fifo_pop)  rd_ptr_q <= rd_ptr_q + 1;
 
             // Sticky status bits
             if (exec_ctrl_reset) begin
                 prdone_q  <= 1'b0;
                 prerror_q <= 1'b0;
+                wr_ptr_q  <= '0;
+                rd_ptr_q  <= '0;
+                csib_q    <= 1'b1;
             end else begin
                 if (icap_prdone)  prdone_q  <= 1'b1;
                 if (icap_prerror) prerror_q <= 1'b1;
             end
 
             // AXI-Lite write channel tracking
-            if (aw_accepted)            begin aw_pending_q <= 1'b1; aw_addr_q <= s_axil_awaddr_i[3:2]; end
+            if (aw_accepted) begin
+                aw_pending_q <= 1'b1;
+                aw_addr_q    <= s_axil_awaddr_i[3:2];
+                aw_data_q    <= is_data_wr;
+            end
             if (w_accepted)             begin w_pending_q  <= 1'b1; w_data_q  <= s_axil_wdata_i;       end
             if (both_done && !bvalid_q) begin
                 aw_pending_q <= 1'b0;
@@ -237,7 +259,9 @@ module loom_icap_ctrl #(
             if (s_axil_arready_o && s_axil_arvalid_i) begin
                 rvalid_q <= 1'b1;
                 case (s_axil_araddr_i[3:2])
-                    REG_STATUS: rdata_q <= {29'b0, prerror_q, prdone_q, (state_q != StIdle)};
+                    REG_STATUS: rdata_q <= {28'b0, fifo_full, prerror_q, prdone_q,
+                                            (!fifo_empty || !csib_q)};
+                    REG_DEPTH:  rdata_q <= FIFO_DEPTH;
                     default:    rdata_q <= '0;
                 endcase
             end else if (s_axil_rready_i) begin
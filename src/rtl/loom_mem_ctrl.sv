@@ -7,24 +7,52 @@
 //
 // Register Map (offset from base 0x30000):
 //   0x00  MEM_STATUS    R    [0]=busy, [1]=done
-//   0x04  MEM_CONTROL   W    Command: 1=read, 2=write, 3=preload_start, 4=preload_next
+//   0x04  MEM_CONTROL   W    Command [7:0]: 1=read, 2=write, 3=preload_start,
+//                             4=preload_next, 5=read_stream, 6=dirty_clear,
+//                             7=write_stream, 8=fill
+//                             [15:8]: read/write_stream words per entry (0 = N_DATA_WORDS)
+//                             [31:8]: fill entry count
 //   0x08  MEM_ADDR      RW   Target address (global byte addr)
 //   0x0C  MEM_LENGTH    R    Total address space bytes (from parameter)
 //   0x10  MEM_DATA[0]   RW   Data word 0
 //   0x14  MEM_DATA[1]   RW   Data word 1 (for wide memories)
 //   ...up to MEM_DATA[N-1] for max_width/32 words
+//   0x400  MEM_DIRTY_PAGE   R  Dirty-tracking page size in bytes (0 = off)
+//   0x404  MEM_DIRTY_COUNT  R  Number of tracked pages
+//   0x408  MEM_CAPS         R  [0]=write_stream, [1]=fill supported
+//   0x600-0x7FF   MEM_DIRTY   R    Dirty bitmap, page p at word p/32 bit p%32
+//   0x800-0xFFF   MEM_STREAM  RW   Read/write-stream window (any word address)
 //
 // Operations:
 //   Write:         Host writes MEM_ADDR + MEM_DATA, issues CMD_WRITE.
 //   Read:          Host writes MEM_ADDR, issues CMD_READ. Wait done, read MEM_DATA.
 //   Preload start: Host writes MEM_ADDR + MEM_DATA, issues CMD_PRELOAD_START.
 //   Preload next:  Host writes MEM_DATA, issues CMD_PRELOAD_NEXT (auto-increments addr).
+//   Read stream:   Host writes MEM_ADDR, issues CMD_READ_STREAM. Every read from
+//                  the MEM_STREAM window returns the next data word; after the
+//                  last word of an entry the address advances by 4 and the next
+//                  entry is fetched. Reads stall until the entry is ready, so a
+//                  burst over the window drains consecutive entries. Clearing
+//                  MEM_STATUS.done ends the stream.
+//   Write stream:  Host writes MEM_ADDR, issues CMD_WRITE_STREAM. Every write to
+//                  the MEM_STREAM window fills the next data word; the last word
+//                  of an entry writes it and advances the address by 4. Writes
+//                  stall for the cycle the entry is written. Clearing
+//                  MEM_STATUS.done ends the stream (a partial entry is dropped).
+//   Fill:          Host writes MEM_ADDR + MEM_DATA, issues CMD_FILL with the
+//                  entry count in [31:8]. Writes MEM_DATA to that many entries,
+//                  one per cycle, 4 address bytes apart.
+//   Dirty pages:   A page's bit is set by any DUT write port hitting it while
+//                  dut_en_i is high, and by host shadow writes. CMD_DIRTY_CLEAR
+//                  clears the bitmap; a write in the same cycle stays dirty.
 
 module loom_mem_ctrl #(
     parameter int unsigned ADDR_BITS   = 12,   // Shadow address width
     parameter int unsigned DATA_BITS   = 32,   // Max memory data width
     parameter int unsigned TOTAL_BYTES = 4096, // Total address space
-    parameter int unsigned N_DATA_WORDS = (DATA_BITS + 31) / 32  // Data buffer size
+    parameter int unsigned N_DATA_WORDS = (DATA_BITS + 31) / 32, // Data buffer size
+    parameter int unsigned DIRTY_PAGE_BYTES = 0,  // Dirty page size, power of 2 (0 = off)
+    parameter int unsigned N_WR_PORTS  = 1     // DUT write ports feeding dirty tracking
 )(
     input  logic        clk_i,
     input  logic        rst_ni,
@@ -53,19 +81,33 @@ module loom_mem_ctrl #(
     output logic [DATA_BITS-1:0]  shadow_wdata_o,
     input  logic [DATA_BITS-1:0]  shadow_rdata_i,
     output logic                  shadow_wen_o,
-    output logic                  shadow_ren_o
+    output logic                  shadow_ren_o,
+
+    // DUT write-port activity (global byte address per port)
+    input  logic                            dut_en_i,
+    input  logic [N_WR_PORTS-1:0]           dut_wr_valid_i,
+    input  logic [N_WR_PORTS*ADDR_BITS-1:0] dut_wr_addr_i,
+
+    // Status output
+    output logic                  mem_done_o     // Operation completed (MEM_STATUS.done)
 );
 
     // =========================================================================
     // State Machine
     // =========================================================================
 
-    typedef enum logic [2:0] {
-        StIdle    = 3'd0,
-        StWrite   = 3'd1,  // Assert wen for one cycle
-        StRead    = 3'd2,  // Assert ren for one cycle
-        StWait    = 3'd3,  // Wait one cycle for BRAM read latency
-        StDone    = 3'd4
+    typedef enum logic [3:0] {
+        StIdle        = 4'd0,
+        StWrite       = 4'd1,  // Assert wen for one cycle
+        StRead        = 4'd2,  // Assert ren for one cycle
+        StWait        = 4'd3,  // Wait one cycle for BRAM read latency
+        StDone        = 4'd4,
+        StStreamRead  = 4'd5,  // Read stream: assert ren for current entry
+        StStreamWait  = 4'd6,  // Read stream: BRAM read latency
+        StStream      = 4'd7,  // Read stream: entry ready in data buffer
+        StStreamFill  = 4'd8,  // Write stream: collecting entry words
+        StStreamWrite = 4'd9,  // Write stream: assert wen for the entry
+        StFill        = 4'd10  // Fill: assert wen once per entry
     } state_e;
 
     // Command codes
@@ -73,6 +115,10 @@ module loom_mem_ctrl #(
     localparam logic [7:0] CMD_WRITE         = 8'h02;
     localparam logic [7:0] CMD_PRELOAD_START = 8'h03;
     localparam logic [7:0] CMD_PRELOAD_NEXT  = 8'h04;
+    localparam logic [7:0] CMD_READ_STREAM   = 8'h05;
+    localparam logic [7:0] CMD_DIRTY_CLEAR   = 8'h06;
+    localparam logic [7:0] CMD_WRITE_STREAM  = 8'h07;
+    localparam logic [7:0] CMD_FILL          = 8'h08;
 
     state_e state_q;
     logic [ADDR_BITS-1:0] addr_q;            // Current shadow address
@@ -80,14 +126,20 @@ module loom_mem_ctrl #(
     logic [31:0] data_q [N_DATA_WORDS];      // Data buffer
     logic        done_q;
     logic        is_read_q;                  // True if current op is read
+    logic [9:0]  stream_words_q;             // Read/write stream: words per entry
+    logic [9:0]  stream_word_q;              // Read/write stream: next word in entry
+    logic        rd_stream_pop;              // AXI read consumed a stream word
+    logic [23:0] fill_count_q;               // Fill: entries left to write
 
     // =========================================================================
     // Shadow Interface Outputs
     // =========================================================================
 
     assign shadow_addr_o  = addr_q;
-    assign shadow_wen_o   = (state_q == StWrite);
-    assign shadow_ren_o   = (state_q == StRead);
+    assign shadow_wen_o   = (state_q == StWrite || state_q == StStreamWrite ||
+                             state_q == StFill);
+    assign shadow_ren_o   = (state_q == StRead || state_q == StStreamRead);
+    assign mem_done_o     = done_q;
 
     // Pack data buffer into shadow wdata
     // For single-word case (most common), this is just data_q[0].
@@ -115,18 +167,31 @@ module loom_mem_ctrl #(
     logic       wr_cmd_write;
     logic       wr_cmd_preload_start;
     logic       wr_cmd_preload_next;
+    logic       wr_cmd_read_stream;
+    logic       wr_cmd_dirty_clear;
+    logic       wr_cmd_write_stream;
+    logic       wr_cmd_fill;
+    logic       wr_stream_push;
     logic       wr_clear_done;
     logic       wr_addr_en;
     logic       wr_data_en;
     logic [9:0] wr_data_word_addr;
 
-    assign wr_fire = wr_addr_valid_q && wr_data_valid_q && !axil_bvalid_o;
+    // Writes wait out the cycle a streamed entry is written, so the next
+    // window word or the closing MEM_STATUS write never races it
+    assign wr_fire = wr_addr_valid_q && wr_data_valid_q && !axil_bvalid_o &&
+                     state_q != StStreamWrite;
 
     always_comb begin
         wr_cmd_read          = 1'b0;
         wr_cmd_write         = 1'b0;
         wr_cmd_preload_start = 1'b0;
         wr_cmd_preload_next  = 1'b0;
+        wr_cmd_read_stream   = 1'b0;
+        wr_cmd_dirty_clear   = 1'b0;
+        wr_cmd_write_stream  = 1'b0;
+        wr_cmd_fill          = 1'b0;
+        wr_stream_push       = 1'b0;
         wr_clear_done        = 1'b0;
         wr_addr_en           = 1'b0;
         wr_data_en           = 1'b0;
@@ -143,6 +208,10 @@ module loom_mem_ctrl #(
                         CMD_WRITE:         wr_cmd_write         = 1'b1;
                         CMD_PRELOAD_START: wr_cmd_preload_start = 1'b1;
                         CMD_PRELOAD_NEXT:  wr_cmd_preload_next  = 1'b1;
+                        CMD_READ_STREAM:   wr_cmd_read_stream   = 1'b1;
+                        CMD_DIRTY_CLEAR:   wr_cmd_dirty_clear   = 1'b1;
+                        CMD_WRITE_STREAM:  wr_cmd_write_stream  = 1'b1;
+                        CMD_FILL:          wr_cmd_fill          = 1'b1;
                         default: ;
                     endcase
                 end
@@ -150,8 +219,10 @@ module loom_mem_ctrl #(
                     wr_addr_en = 1'b1;
                 end
                 default: begin
-                    // MEM_DATA registers (offset 0x10 = word address 4)
-                    if (wr_addr_q[11:2] >= 10'h004 &&
+                    // MEM_STREAM window, then MEM_DATA registers (offset 0x10 = word address 4)
+                    if (wr_addr_q[11]) begin
+                        wr_stream_push = 1'b1;
+                    end else if (wr_addr_q[11:2] >= 10'h004 &&
                         wr_addr_q[11:2] < 10'h004 + N_DATA_WORDS[9:0]) begin
                         wr_data_en       = 1'b1;
                         wr_data_word_addr = wr_addr_q[11:2] - 10'h004;
@@ -198,6 +269,43 @@ module loom_mem_ctrl #(
         end
     end
 
+    // =========================================================================
+    // Dirty Page Tracking
+    // =========================================================================
+
+    localparam int unsigned N_PAGES = (DIRTY_PAGE_BYTES == 0) ? 1 :
+        (TOTAL_BYTES + DIRTY_PAGE_BYTES - 1) / DIRTY_PAGE_BYTES;
+    localparam int unsigned PAGE_SHIFT = (DIRTY_PAGE_BYTES <= 1) ? 0 : $clog2(DIRTY_PAGE_BYTES);
+    localparam int unsigned N_DIRTY_WORDS = (N_PAGES + 31) / 32;
+
+    logic [N_DIRTY_WORDS*32-1:0] dirty_bitmap;
+
+    if (DIRTY_PAGE_BYTES != 0) begin : g_dirty
+        logic [N_PAGES-1:0] dirty_d, dirty_q;
+
+        always_comb begin
+            int unsigned page;
+            dirty_d = wr_cmd_dirty_clear ? '0 : dirty_q;
+            for (int p = 0; p < int'(N_WR_PORTS); p++) begin
+                page = int'(dut_wr_addr_i[p * ADDR_BITS +: ADDR_BITS] >> PAGE_SHIFT);
+                if (dut_en_i && dut_wr_valid_i[p] && page < N_PAGES)
+                    dirty_d[page] = 1'b1;
+            end
+            page = int'(addr_q >> PAGE_SHIFT);
+            if (shadow_wen_o && page < N_PAGES)
+                dirty_d[page] = 1'b1;
+        end
+
+        always_ff @(posedge clk_i or negedge rst_ni) begin
+            if (!rst_ni) dirty_q <= '0;
+            else         dirty_q <= dirty_d;
+        end
+
+        assign dirty_bitmap = (N_DIRTY_WORDS * 32)'(dirty_q);
+    end else begin : g_no_dirty
+        assign dirty_bitmap = '0;
+    end
+
     // =========================================================================
     // Main FSM
     // =========================================================================
@@ -209,6 +317,9 @@ module loom_mem_ctrl #(
             preload_addr_q <= '0;
             done_q         <= 1'b0;
             is_read_q      <= 1'b0;
+            stream_words_q <= '0;
+            stream_word_q  <= '0;
+            fill_count_q   <= '0;
             for (int i = 0; i < int'(N_DATA_WORDS); i++) begin
                 data_q[i] <= 32'd0;
             end
@@ -237,6 +348,27 @@ module loom_mem_ctrl #(
                         state_q        <= StWrite;
                         done_q         <= 1'b0;
                         is_read_q      <= 1'b0;
+                    end else if (wr_cmd_read_stream) begin
+                        state_q        <= StStreamRead;
+                        done_q         <= 1'b0;
+                        is_read_q      <= 1'b1;
+                        stream_word_q  <= '0;
+                        stream_words_q <= (wr_data_q[15:8] == 8'd0 ||
+                                           wr_data_q[15:8] > N_DATA_WORDS[7:0])
+                                          ? N_DATA_WORDS[9:0] : {2'b00, wr_data_q[15:8]};
+                    end else if (wr_cmd_write_stream) begin
+                        state_q        <= StStreamFill;
+                        done_q         <= 1'b0;
+                        is_read_q      <= 1'b0;
+                        stream_word_q  <= '0;
+                        stream_words_q <= (wr_data_q[15:8] == 8'd0 ||
+                                           wr_data_q[15:8] > N_DATA_WORDS[7:0])
+                                          ? N_DATA_WORDS[9:0] : {2'b00, wr_data_q[15:8]};
+                    end else if (wr_cmd_fill) begin
+                        state_q      <= (wr_data_q[31:8] == 24'd0) ? StDone : StFill;
+                        done_q       <= 1'b0;
+                        is_read_q    <= 1'b0;
+                        fill_count_q <= wr_data_q[31:8];
                     end
 
                     // Register writes while idle
@@ -274,6 +406,70 @@ module loom_mem_ctrl #(
                     state_q <= StDone;
                 end
 
+                StStreamRead: begin
+                    state_q <= StStreamWait;
+                end
+
+                StStreamWait: begin
+                    for (int w = 0; w < int'(N_DATA_WORDS); w++) begin
+                        data_q[w] <= 32'd0;
+                        for (int b = 0; b < 32; b++) begin
+                            if (w * 32 + b < int'(DATA_BITS))
+                                data_q[w][b] <= shadow_rdata_i[w * 32 + b];
+                        end
+                    end
+                    state_q <= StStream;
+                end
+
+                StStream: begin
+                    done_q <= 1'b1;
+                    if (wr_clear_done) begin
+                        done_q  <= 1'b0;
+                        state_q <= StIdle;
+                    end else if (rd_stream_pop) begin
+                        if (stream_word_q + 10'd1 >= stream_words_q) begin
+                            // Entry drained: fetch the next one
+                            stream_word_q <= '0;
+                            addr_q        <= addr_q + ADDR_BITS'(4);
+                            state_q       <= StStreamRead;
+                        end else begin
+                            stream_word_q <= stream_word_q + 10'd1;
+                        end
+                    end
+                end
+
+                StStreamFill: begin
+                    done_q <= 1'b1;
+                    if (wr_clear_done) begin
+                        done_q  <= 1'b0;
+                        state_q <= StIdle;
+                    end else if (wr_stream_push) begin
+                        data_q[stream_word_q] <= wr_data_q;
+                        if (stream_word_q + 10'd1 >= stream_words_q) begin
+                            stream_word_q <= '0;
+                            state_q       <= StStreamWrite;
+                        end else begin
+                            stream_word_q <= stream_word_q + 10'd1;
+                        end
+                    end
+                end
+
+                StStreamWrite: begin
+                    // Shadow wen asserted this cycle; the next entry follows
+                    addr_q  <= addr_q + ADDR_BITS'(4);
+                    state_q <= StStreamFill;
+                end
+
+                StFill: begin
+                    // Shadow wen asserted this cycle for addr_q
+                    fill_count_q <= fill_count_q - 24'd1;
+                    if (fill_count_q == 24'd1) begin
+                        state_q <= StDone;
+                    end else begin
+                        addr_q <= addr_q + ADDR_BITS'(4);
+                    end
+                end
+
                 StDone: begin
                     done_q <= 1'b1;
                     if (wr_clear_done) begin
@@ -299,6 +495,16 @@ module loom_mem_ctrl #(
 
     logic [11:0] rd_addr_q;
     logic        rd_pending_q;
+    logic        rd_stream_win;
+    logic        rd_stream_wait;
+
+    // MEM_STREAM window reads complete only once the current entry is in
+    // the data buffer; reads outside an active stream return 0xDEADBEEF.
+    assign rd_stream_win  = rd_addr_q[11];
+    assign rd_stream_wait = rd_stream_win &&
+                            (state_q == StStreamRead || state_q == StStreamWait);
+    assign rd_stream_pop  = rd_pending_q && !axil_rvalid_o && rd_stream_win &&
+                            (state_q == StStream);
 
     always_ff @(posedge clk_i or negedge rst_ni) begin
         if (!rst_ni) begin
@@ -316,17 +522,29 @@ module loom_mem_ctrl #(
                 rd_pending_q <= 1'b1;
             end
 
-            if (rd_pending_q && !axil_rvalid_o) begin
+            if (rd_pending_q && !axil_rvalid_o && !rd_stream_wait) begin
                 axil_rvalid_o <= 1'b1;
                 axil_rresp_o  <= 2'b00;
 
                 case (rd_addr_q[11:2])
-                    10'h000: axil_rdata_o <= {30'd0, done_q, (state_q != StIdle && state_q != StDone)};  // MEM_STATUS
+                    10'h000: axil_rdata_o <= {30'd0, done_q,  // MEM_STATUS
+                                              (state_q != StIdle && state_q != StDone &&
+                                               state_q != StStream && state_q != StStreamFill)};
                     10'h002: axil_rdata_o <= addr_q;       // MEM_ADDR
                     10'h003: axil_rdata_o <= TOTAL_BYTES;  // MEM_LENGTH
+                    10'h100: axil_rdata_o <= DIRTY_PAGE_BYTES;                      // MEM_DIRTY_PAGE
+                    10'h101: axil_rdata_o <= (DIRTY_PAGE_BYTES == 0) ? 0 : N_PAGES; // MEM_DIRTY_COUNT
+                    10'h102: axil_rdata_o <= 32'h3;                                 // MEM_CAPS
                     default: begin
                         // MEM_DATA registers start at offset 0x10 (word address 4)
-                        if (rd_addr_q[11:2] >= 10'h004 &&
+                        if (rd_stream_win) begin
+                            axil_rdata_o <= (state_q == StStream)
+                                            ? data_q[stream_word_q] : 32'hDEAD_BEEF;
+                        end else if (rd_addr_q[11:9] == 3'b011) begin
+                            // MEM_DIRTY bitmap window (0x600-0x7FF)
+                            axil_rdata_o <= (int'(rd_addr_q[8:2]) < int'(N_DIRTY_WORDS))
+                                            ? dirty_bitmap[rd_addr_q[8:2] * 32 +: 32] : 32'd0;
+                        end else if (rd_addr_q[11:2] >= 10'h004 &&
                             rd_addr_q[11:2] < 10'h004 + N_DATA_WORDS[9:0]) begin
                             axil_rdata_o <= data_q[rd_addr_q[11:2] - 10'h004];
                         end else begin
@@ -3,29 +3,71 @@
 //
 // Controls scan chain capture (shift out state) and restore (shift in state).
 // With free-running clock + FF enable override (loom_en | loom_scan_enable),
-// the scan controller simply asserts scan_enable and shifts one bit per cycle.
+// the scan controller simply asserts scan_enable and shifts one bit per cycle
+// on each of the N_CHAINS parallel chains.
 //
 // Register Map (offset from base):
 //   0x00 SCAN_STATUS    R    [0]=busy, [1]=done, [7:4]=error_code
-//   0x04 SCAN_CONTROL   W    Command: 1=capture, 2=restore
-//   0x08 SCAN_LENGTH    R    Chain length in bits (from parameter)
-//   0x0C reserved
+//   0x04 SCAN_CONTROL   W    Command: 1=capture, 2=restore,
+//                                     3=capture_stream, 4=restore_stream,
+//                                     5=reinit (shift in the reset image ROM)
+//   0x08 SCAN_LENGTH    R    Total scan bits over all chains (from parameter)
+//   0x0C SCAN_CHAINS    R    [15:0]=number of chains, [30]=reset ROM, [31]=stream only
 //   0x10 SCAN_DATA[0]   RW   First 32 bits of scan data (LSBs)
 //   0x14 SCAN_DATA[1]   RW   Next 32 bits
 //   ...
+//   0x7F00-0x7FFF  REINIT_PATCH W   Reset ROM patches (HAS_RESET_ROM only)
+//   0x8000-0xFFFF  SCAN_STREAM  RW  Stream window (any word address)
 //
 // Scan data is stored LSB-first: DATA[0][0] is the first bit shifted out/in.
 // Maximum supported chain length is 32 * N_DATA_WORDS bits.
+//
+// Chain c holds buffer bits [c*CHAIN_BITS, (c+1)*CHAIN_BITS), so the buffer
+// keeps the single-chain offset numbering of the scan map. With several
+// chains CHAIN_BITS is a multiple of 32 (see scan_insert) and every chain
+// shifts for CHAIN_BITS cycles. The last chain may be shorter; its loop is
+// padded to CHAIN_BITS with a shift register here, so capture stays
+// non-destructive and the pad bits land past CHAIN_LENGTH in the buffer.
+//
+// Streaming:
+//   Capture/restore stream through a STREAM_DEPTH-entry FIFO instead of the
+//   data buffer. An entry holds one 32-bit word per chain: word c is buffer
+//   word c*WORDS_PER_CHAIN + w, with w running from WORDS_PER_CHAIN-1 down
+//   to 0 (shift order). The host reads (capture) or writes (restore) the
+//   entries word by word through SCAN_STREAM while the chains shift; the
+//   shift pauses when the FIFO is full (capture) or empty (restore), and
+//   window reads/writes stall until an entry or slot is available.
+//   With STREAM_ONLY the data buffer is omitted and buffered commands fail
+//   with error_code 1, so shell area no longer grows with the chain length.
+//
+// Reset image ROM:
+//   With HAS_RESET_ROM, RESET_ROM holds the initial scan image in stream
+//   entry order (entry w = one word per chain, chain c at [c*32 +: 32]).
+//   CMD_REINIT shifts it in like a restore stream, loading each entry from
+//   the ROM instead of the FIFO, so a reset needs no host data at all.
+//   Patch slot p (0x7F00 + 16*p: WORD, VALUE, MASK) replaces the MASK bits
+//   of buffer word WORD with VALUE on the way in; the host uses them for
+//   values only known at run time (reset DPI results). MASK=0 disables a
+//   slot. The data buffer must end below 0x7F00 (emu_top ensures it).
+//   Without the ROM, CMD_REINIT fails with error_code 2.
 
 module loom_scan_ctrl #(
-    parameter int unsigned CHAIN_LENGTH  = 64,   // Total scan chain bits
-    parameter int unsigned N_DATA_WORDS  = (CHAIN_LENGTH + 31) / 32  // Data buffer size
+    parameter int unsigned CHAIN_LENGTH  = 64,            // Total scan bits
+    parameter int unsigned N_CHAINS      = 1,             // Parallel chains
+    parameter int unsigned CHAIN_BITS    = CHAIN_LENGTH,  // Bits per chain (shift cycles)
+    parameter bit          STREAM_ONLY   = 1'b0,          // No data buffer
+    parameter int unsigned STREAM_DEPTH  = 2,             // Stream FIFO entries
+    parameter int unsigned N_DATA_WORDS  = STREAM_ONLY ? 1 :
+                                           (N_CHAINS * CHAIN_BITS + 31) / 32,  // Data buffer size
+    parameter bit          HAS_RESET_ROM = 1'b0,          // Reset image ROM + CMD_REINIT
+    parameter int unsigned N_PATCHES     = 16,            // Reset ROM patch slots (<= 16)
+    parameter logic [(CHAIN_BITS + 31) / 32 * N_CHAINS * 32 - 1:0] RESET_ROM = '0
 )(
     input  logic        clk_i,
     input  logic        rst_ni,
 
     // AXI-Lite Slave interface
-    input  logic [11:0] axil_araddr_i,
+    input  logic [15:0] axil_araddr_i,
     input  logic        axil_arvalid_i,
     output logic        axil_arready_o,
     output logic [31:0] axil_rdata_o,
@@ -33,7 +75,7 @@ module loom_scan_ctrl #(
     output logic        axil_rvalid_o,
     input  logic        axil_rready_i,
 
-    input  logic [11:0] axil_awaddr_i,
+    input  logic [15:0] axil_awaddr_i,
     input  logic        axil_awvalid_i,
     output logic        axil_awready_o,
     input  logic [31:0] axil_wdata_i,
@@ -44,12 +86,13 @@ module loom_scan_ctrl #(
     input  logic        axil_bready_i,
 
     // Scan chain interface (directly to DUT)
-    output logic        scan_enable_o,    // Scan mode enable (to loom_scan_enable)
-    output logic        scan_in_o,        // Serial data in (to loom_scan_in)
-    input  logic        scan_out_i,       // Serial data out (from loom_scan_out)
+    output logic                scan_enable_o,  // Scan mode enable (to loom_scan_enable)
+    output logic [N_CHAINS-1:0] scan_in_o,      // Serial data in (to loom_scan_in)
+    input  logic [N_CHAINS-1:0] scan_out_i,     // Serial data out (from loom_scan_out)
 
-    // Status output
-    output logic        scan_busy_o       // Scan operation in progress
+    // Status outputs
+    output logic        scan_busy_o,      // Scan operation in progress
+    output logic        scan_done_o       // Operation completed (SCAN_STATUS.done)
 );
 
     // =========================================================================
@@ -64,25 +107,50 @@ module loom_scan_ctrl #(
     } state_e;
 
     // Command codes
-    localparam logic [7:0] CMD_CAPTURE = 8'h01;
-    localparam logic [7:0] CMD_RESTORE = 8'h02;
+    localparam logic [7:0] CMD_CAPTURE        = 8'h01;
+    localparam logic [7:0] CMD_RESTORE        = 8'h02;
+    localparam logic [7:0] CMD_CAPTURE_STREAM = 8'h03;
+    localparam logic [7:0] CMD_RESTORE_STREAM = 8'h04;
+    localparam logic [7:0] CMD_REINIT         = 8'h05;
+
+    // Error codes
+    localparam logic [3:0] ERR_NO_BUFFER = 4'd1;  // buffered command with STREAM_ONLY
+    localparam logic [3:0] ERR_NO_ROM    = 4'd2;  // CMD_REINIT without HAS_RESET_ROM
 
     // Widths for bit position / word index — avoid degenerate zero-width signals
-    localparam int unsigned SHIFT_CNT_W = $clog2(CHAIN_LENGTH + 1);
-    localparam int unsigned BIT_POS_W   = (CHAIN_LENGTH > 1) ? $clog2(CHAIN_LENGTH) : 1;
+    localparam int unsigned SHIFT_CNT_W = $clog2(CHAIN_BITS + 1);
+    localparam int unsigned BIT_POS_W   = (CHAIN_BITS > 1) ? $clog2(CHAIN_BITS) : 1;
+
+    // Per-chain buffer stride and the last chain's loop padding
+    localparam int unsigned WORDS_PER_CHAIN = (CHAIN_BITS + 31) / 32;
+    localparam int unsigned LAST_BITS = CHAIN_LENGTH - (N_CHAINS - 1) * CHAIN_BITS;
+    localparam int unsigned PAD_BITS  = CHAIN_BITS - LAST_BITS;
+
+    // Stream FIFO pointer / count / word-in-entry widths
+    localparam int unsigned FIFO_PTR_W = (STREAM_DEPTH > 1) ? $clog2(STREAM_DEPTH) : 1;
+    localparam int unsigned FIFO_CNT_W = $clog2(STREAM_DEPTH + 1);
+    localparam int unsigned CHAIN_IDX_W = (N_CHAINS > 1) ? $clog2(N_CHAINS) : 1;
 
     state_e state_q;
     logic [SHIFT_CNT_W-1:0] shift_count_q;  // Bits remaining to shift
     logic [31:0] scan_data_q [N_DATA_WORDS]; // Scan data buffer
     logic        done_q;                     // Operation completed
     logic [3:0]  error_code_q;
+    logic        stream_cap_q;               // Current/last op is a capture stream
+    logic        stream_rst_q;               // Current/last op is a restore stream
+    logic        rom_rst_q;                  // Current/last op is a ROM reinit
+
+    // Stream word being assembled (capture) or shifted out (restore), per chain
+    logic [31:0] acc_q [N_CHAINS];
+    logic        acc_full_q;                 // Capture: word complete, not yet pushed
+    logic        acc_valid_q;                // Restore: word loaded from the FIFO
 
     // =========================================================================
     // Scan Shift Logic
     // =========================================================================
 
-    // Current bit position in the data buffer.
-    // shift_count_q counts down from CHAIN_LENGTH.  We number buffer positions
+    // Current bit position within each chain's part of the data buffer.
+    // shift_count_q counts down from CHAIN_BITS.  We number buffer positions
     // so that position 0 corresponds to the LAST bit shifted out (= the bit
     // closest to scan_in, i.e. the first FF's LSB).  This matches the offset
     // numbering in the scan_map generated by scan_insert.
@@ -91,89 +159,277 @@ module loom_scan_ctrl #(
 
     // Which word and bit within that word
     logic [4:0] bit_in_word;
-    assign bit_in_word = bit_pos[4:0];
+    assign bit_in_word = 5'(bit_pos);
 
-    // Word index: bit_pos / 32.  For single-word chains, always 0.
-    logic [$clog2(N_DATA_WORDS > 1 ? N_DATA_WORDS : 2)-1:0] word_idx;
+    // Word index within a chain: bit_pos / 32.  For single-word chains, always 0.
+    logic [$clog2(WORDS_PER_CHAIN > 1 ? WORDS_PER_CHAIN : 2)-1:0] word_idx;
     generate
-        if (N_DATA_WORDS > 1) begin : gen_word_idx_multi
+        if (WORDS_PER_CHAIN > 1) begin : gen_word_idx_multi
             assign word_idx = bit_pos[BIT_POS_W-1:5];
         end else begin : gen_word_idx_single
             assign word_idx = '0;
         end
     endgenerate
 
-    // Scan input data:
-    //   Capture: closed-loop — feed scan_out back to scan_in so the chain
-    //           contents are preserved after a full capture (non-destructive).
-    //   Restore: feed from the data buffer to overwrite chain contents.
-    assign scan_in_o = (state_q == StCapture)  ? scan_out_i :
-                       (state_q == StRestore && shift_count_q > 0) ?
-                       scan_data_q[word_idx][bit_in_word] : 1'b0;
+    // Loop end of each chain: scan_out, or the pad after the short last chain
+    logic [N_CHAINS-1:0] loop_out;
+    logic                pad_out;
+
+    generate
+        if (PAD_BITS > 0) begin : gen_pad
+            logic [PAD_BITS-1:0] pad_q;
+            always_ff @(posedge clk_i or negedge rst_ni) begin
+                if (!rst_ni) begin
+                    pad_q <= '0;
+                end else if (scan_enable_o) begin
+                    pad_q <= (pad_q << 1) | PAD_BITS'(scan_out_i[N_CHAINS-1]);
+                end
+            end
+            assign pad_out = pad_q[PAD_BITS-1];
+        end else begin : gen_no_pad
+            assign pad_out = scan_out_i[N_CHAINS-1];
+        end
+    endgenerate
+
+    always_comb begin
+        loop_out = scan_out_i;
+        loop_out[N_CHAINS-1] = pad_out;
+    end
+
+    // Shift gating: streams pause while the FIFO cannot take or give a word
+    logic stream_ok;
+    assign stream_ok = stream_cap_q ? !acc_full_q :
+                       (stream_rst_q || rom_rst_q) ? acc_valid_q : 1'b1;
 
     // Scan enable: active during capture or restore, but only while shifts remain.
     // Without the shift_count_q guard, an extra shift occurs on the cycle where
     // shift_count_q == 0 (state_q hasn't transitioned to StDone yet).
     assign scan_enable_o = (state_q == StCapture || state_q == StRestore)
-                           && (shift_count_q != '0);
+                           && (shift_count_q != '0) && stream_ok;
+
+    // Scan input data:
+    //   Capture: closed-loop — feed each loop end back to scan_in so the chain
+    //           contents are preserved after a full capture (non-destructive).
+    //   Restore: feed from the data buffer (or stream word) to overwrite
+    //           chain contents.
+    always_comb begin
+        for (int c = 0; c < int'(N_CHAINS); c++) begin
+            if (state_q == StCapture)
+                scan_in_o[c] = loop_out[c];
+            else if (state_q == StRestore && shift_count_q > 0)
+                scan_in_o[c] = (stream_rst_q || rom_rst_q || STREAM_ONLY) ? acc_q[c][bit_in_word] :
+                               scan_data_q[c * int'(WORDS_PER_CHAIN) + int'(word_idx)][bit_in_word];
+            else
+                scan_in_o[c] = 1'b0;
+        end
+    end
 
     // Busy output
     assign scan_busy_o = (state_q != StIdle && state_q != StDone);
+    assign scan_done_o = done_q;
+
+    // =========================================================================
+    // Stream FIFO
+    // =========================================================================
+
+    logic [31:0] fifo_q [STREAM_DEPTH][N_CHAINS];
+    logic [FIFO_PTR_W-1:0]  fifo_wr_ptr_q, fifo_rd_ptr_q;
+    logic [FIFO_CNT_W-1:0]  fifo_count_q;
+    logic [CHAIN_IDX_W-1:0] fifo_wr_word_q, fifo_rd_word_q;  // word within entry
+    logic fifo_full, fifo_empty;
+
+    // Producer/consumer strobes (decoded below)
+    logic fifo_flush;       // stream command started
+    logic fifo_push_acc;    // capture: push acc_q as one entry
+    logic fifo_push_word;   // restore: host wrote one window word
+    logic fifo_pop_acc;     // restore: load one entry into acc_q
+    logic fifo_pop_word;    // capture: host read one window word
+
+    assign fifo_full  = (fifo_count_q == FIFO_CNT_W'(STREAM_DEPTH));
+    assign fifo_empty = (fifo_count_q == '0);
+
+    assign fifo_push_acc = stream_cap_q && acc_full_q && !fifo_full;
+    assign fifo_pop_acc  = stream_rst_q && state_q == StRestore && !acc_valid_q &&
+                           shift_count_q != '0 && !fifo_empty;
+
+    logic fifo_push_entry, fifo_pop_entry;
+    assign fifo_push_entry = fifo_push_acc ||
+                             (fifo_push_word && fifo_wr_word_q == CHAIN_IDX_W'(N_CHAINS - 1));
+    assign fifo_pop_entry  = fifo_pop_acc ||
+                             (fifo_pop_word && fifo_rd_word_q == CHAIN_IDX_W'(N_CHAINS - 1));
+
+    function automatic logic [FIFO_PTR_W-1:0] ptr_next(logic [FIFO_PTR_W-1:0] ptr);
+        return (ptr == FIFO_PTR_W'(STREAM_DEPTH - 1)) ? '0 : ptr + FIFO_PTR_W'(1);
+    endfunction
+
+    always_ff @(posedge clk_i or negedge rst_ni) begin
+        if (!rst_ni) begin
+            fifo_wr_ptr_q  <= '0;
+            fifo_rd_ptr_q  <= '0;
+            fifo_count_q   <= '0;
+            fifo_wr_word_q <= '0;
+            fifo_rd_word_q <= '0;
+        end else if (fifo_flush) begin
+            fifo_wr_ptr_q  <= '0;
+            fifo_rd_ptr_q  <= '0;
+            fifo_count_q   <= '0;
+            fifo_wr_word_q <= '0;
+            fifo_rd_word_q <= '0;
+        end else begin
+            if (fifo_push_acc) begin
+                for (int c = 0; c < int'(N_CHAINS); c++)
+                    fifo_q[fifo_wr_ptr_q][c] <= acc_q[c];
+            end
+            if (fifo_push_word) begin
+                fifo_q[fifo_wr_ptr_q][fifo_wr_word_q] <= wr_data_q;
+                fifo_wr_word_q <= (fifo_wr_word_q == CHAIN_IDX_W'(N_CHAINS - 1))
+                                  ? '0 : fifo_wr_word_q + CHAIN_IDX_W'(1);
+            end
+            if (fifo_pop_word) begin
+                fifo_rd_word_q <= (fifo_rd_word_q == CHAIN_IDX_W'(N_CHAINS - 1))
+                                  ? '0 : fifo_rd_word_q + CHAIN_IDX_W'(1);
+            end
+
+            if (fifo_push_entry) fifo_wr_ptr_q <= ptr_next(fifo_wr_ptr_q);
+            if (fifo_pop_entry)  fifo_rd_ptr_q <= ptr_next(fifo_rd_ptr_q);
+            if (fifo_push_entry && !fifo_pop_entry)
+                fifo_count_q <= fifo_count_q + FIFO_CNT_W'(1);
+            else if (fifo_pop_entry && !fifo_push_entry)
+                fifo_count_q <= fifo_count_q - FIFO_CNT_W'(1);
+        end
+    end
+
+    // =========================================================================
+    // Reset Image ROM
+    // =========================================================================
+
+    // The next entry is loaded when the previous word has shifted in
+    logic        rom_load;
+    logic [31:0] rom_word [N_CHAINS];
+    assign rom_load = rom_rst_q && state_q == StRestore && !acc_valid_q && shift_count_q != '0;
+
+    logic [31:0] patch_word_q [N_PATCHES];
+    logic [31:0] patch_val_q  [N_PATCHES];
+    logic [31:0] patch_mask_q [N_PATCHES];
+
+    generate if (HAS_RESET_ROM) begin : gen_rom
+        localparam int unsigned ENTRY_W = N_CHAINS * 32;
+
+        // word_idx is the entry of the word about to shift in
+        logic [ENTRY_W-1:0] rom_entry;
+        assign rom_entry = RESET_ROM[32'(word_idx) * ENTRY_W +: ENTRY_W];
+
+        always_comb begin
+            for (int c = 0; c < int'(N_CHAINS); c++) begin
+                rom_word[c] = rom_entry[c*32 +: 32];
+                for (int p = 0; p < int'(N_PATCHES); p++) begin
+                    if (patch_mask_q[p] != '0 &&
+                        patch_word_q[p] == 32'(c * int'(WORDS_PER_CHAIN)) + 32'(word_idx))
+                        rom_word[c] = (rom_word[c] & ~patch_mask_q[p]) |
+                                      (patch_val_q[p] & patch_mask_q[p]);
+                end
+            end
+        end
+    end else begin : gen_no_rom
+        always_comb begin
+            for (int c = 0; c < int'(N_CHAINS); c++) rom_word[c] = 32'd0;
+        end
+    end endgenerate
 
     // =========================================================================
     // AXI-Lite Write Handshake
     // =========================================================================
 
     logic        wr_addr_valid_q, wr_data_valid_q;
-    logic [11:0] wr_addr_q;
+    logic [15:0] wr_addr_q;
     logic [31:0] wr_data_q;
 
     // Write-effect decode (combinational) — consumed by main FSM
-    logic       wr_fire;       // write handshake fires this cycle
-    logic       wr_cmd_capture;
-    logic       wr_cmd_restore;
-    logic       wr_clear_done;
-    logic       wr_data_en;
-    logic [9:0] wr_data_word_addr;
-
-    assign wr_fire = wr_addr_valid_q && wr_data_valid_q && !axil_bvalid_o;
+    logic        wr_fire;       // write handshake fires this cycle
+    logic        wr_stall;      // restore stream window write waiting for a slot
+    logic        wr_cmd_capture;
+    logic        wr_cmd_restore;
+    logic        wr_cmd_capture_stream;
+    logic        wr_cmd_restore_stream;
+    logic        wr_cmd_reinit;
+    logic        wr_patch_en;
+    logic        wr_clear_done;
+    logic        wr_data_en;
+    logic [13:0] wr_data_word_addr;
+
+    // The demux keeps one write outstanding until B, so holding the
+    // captured AW/W here while the FIFO is full is safe.
+    assign wr_stall = wr_addr_q[15] && stream_rst_q && state_q == StRestore && fifo_full;
+    assign wr_fire  = wr_addr_valid_q && wr_data_valid_q && !axil_bvalid_o && !wr_stall;
+    assign fifo_push_word = wr_fire && wr_addr_q[15] && stream_rst_q && state_q == StRestore;
 
     always_comb begin
-        wr_cmd_capture   = 1'b0;
-        wr_cmd_restore   = 1'b0;
-        wr_clear_done    = 1'b0;
-        wr_data_en       = 1'b0;
-        wr_data_word_addr = '0;
-
-        if (wr_fire) begin
-            case (wr_addr_q[11:2])
-                10'h000: begin  // SCAN_STATUS — write-to-clear done
+        wr_cmd_capture        = 1'b0;
+        wr_cmd_restore        = 1'b0;
+        wr_cmd_capture_stream = 1'b0;
+        wr_cmd_restore_stream = 1'b0;
+        wr_cmd_reinit         = 1'b0;
+        wr_patch_en           = 1'b0;
+        wr_clear_done         = 1'b0;
+        wr_data_en            = 1'b0;
+        wr_data_word_addr     = '0;
+
+        if (wr_fire && !wr_addr_q[15]) begin
+            case (wr_addr_q[15:2])
+                14'h0000: begin  // SCAN_STATUS — write-to-clear done
                     wr_clear_done = wr_data_q[1];
                 end
-                10'h001: begin  // SCAN_CONTROL
+                14'h0001: begin  // SCAN_CONTROL
                     case (wr_data_q[7:0])
-                        CMD_CAPTURE: wr_cmd_capture = 1'b1;
-                        CMD_RESTORE: wr_cmd_restore = 1'b1;
+                        CMD_CAPTURE:        wr_cmd_capture        = 1'b1;
+                        CMD_RESTORE:        wr_cmd_restore        = 1'b1;
+                        CMD_CAPTURE_STREAM: wr_cmd_capture_stream = 1'b1;
+                        CMD_RESTORE_STREAM: wr_cmd_restore_stream = 1'b1;
+                        CMD_REINIT:         wr_cmd_reinit         = 1'b1;
                         default: ;
                     endcase
                 end
                 default: begin
+                    // REINIT_PATCH slots at 0x7F00 (16 bytes each)
+                    if (HAS_RESET_ROM && wr_addr_q[15:8] == 8'h7F &&
+                        32'(wr_addr_q[7:4]) < N_PATCHES)
+                        wr_patch_en = 1'b1;
                     // SCAN_DATA registers (offset 0x10 = word address 4)
-                    if (wr_addr_q[11:2] >= 10'h004 &&
-                        wr_addr_q[11:2] < 10'h004 + N_DATA_WORDS[9:0]) begin
+                    if (!STREAM_ONLY &&
+                        wr_addr_q[15:2] >= 14'h0004 &&
+                        wr_addr_q[15:2] < 14'h0004 + N_DATA_WORDS[13:0]) begin
                         wr_data_en       = 1'b1;
-                        wr_data_word_addr = wr_addr_q[11:2] - 10'h004;
+                        wr_data_word_addr = wr_addr_q[15:2] - 14'h0004;
                     end
                 end
             endcase
         end
     end
 
+    assign fifo_flush = (state_q == StIdle) && (wr_cmd_capture_stream || wr_cmd_restore_stream);
+
+    always_ff @(posedge clk_i or negedge rst_ni) begin
+        if (!rst_ni) begin
+            for (int p = 0; p < int'(N_PATCHES); p++) begin
+                patch_word_q[p] <= 32'd0;
+                patch_val_q[p]  <= 32'd0;
+                patch_mask_q[p] <= 32'd0;
+            end
+        end else if (wr_patch_en) begin
+            case (wr_addr_q[3:2])
+                2'd0: patch_word_q[wr_addr_q[7:4]] <= wr_data_q;
+                2'd1: patch_val_q[wr_addr_q[7:4]]  <= wr_data_q;
+                2'd2: patch_mask_q[wr_addr_q[7:4]] <= wr_data_q;
+                default: ;
+            endcase
+        end
+    end
+
     always_ff @(posedge clk_i or negedge rst_ni) begin
         if (!rst_ni) begin
             wr_addr_valid_q <= 1'b0;
             wr_data_valid_q <= 1'b0;
-            wr_addr_q       <= 12'd0;
+            wr_addr_q       <= 16'd0;
             wr_data_q       <= 32'd0;
             axil_awready_o  <= 1'b0;
             axil_wready_o   <= 1'b0;
@@ -216,23 +472,56 @@ module loom_scan_ctrl #(
             shift_count_q <= '0;
             done_q        <= 1'b0;
             error_code_q  <= 4'd0;
+            stream_cap_q  <= 1'b0;
+            stream_rst_q  <= 1'b0;
+            rom_rst_q     <= 1'b0;
+            acc_full_q    <= 1'b0;
+            acc_valid_q   <= 1'b0;
             for (int i = 0; i < int'(N_DATA_WORDS); i++) begin
                 scan_data_q[i] <= 32'd0;
             end
+            for (int c = 0; c < int'(N_CHAINS); c++) begin
+                acc_q[c] <= 32'd0;
+            end
         end else begin
             case (state_q)
                 StIdle: begin
                     // Write effects while idle
-                    if (wr_cmd_capture) begin
+                    if ((wr_cmd_capture || wr_cmd_restore) && STREAM_ONLY) begin
+                        state_q       <= StDone;
+                        done_q        <= 1'b0;
+                        error_code_q  <= ERR_NO_BUFFER;
+                        stream_cap_q  <= 1'b0;
+                        stream_rst_q  <= 1'b0;
+                        rom_rst_q     <= 1'b0;
+                    end else if (wr_cmd_reinit && !HAS_RESET_ROM) begin
+                        state_q       <= StDone;
+                        done_q        <= 1'b0;
+                        error_code_q  <= ERR_NO_ROM;
+                        stream_cap_q  <= 1'b0;
+                        stream_rst_q  <= 1'b0;
+                        rom_rst_q     <= 1'b0;
+                    end else if (wr_cmd_capture || wr_cmd_capture_stream) begin
                         state_q       <= StCapture;
-                        shift_count_q <= SHIFT_CNT_W'(CHAIN_LENGTH);
+                        shift_count_q <= SHIFT_CNT_W'(CHAIN_BITS);
                         done_q        <= 1'b0;
                         error_code_q  <= 4'd0;
-                    end else if (wr_cmd_restore) begin
+                        stream_cap_q  <= wr_cmd_capture_stream;
+                        stream_rst_q  <= 1'b0;
+                        rom_rst_q     <= 1'b0;
+                    end else if (wr_cmd_restore || wr_cmd_restore_stream || wr_cmd_reinit) begin
                         state_q       <= StRestore;
-                        shift_count_q <= SHIFT_CNT_W'(CHAIN_LENGTH);
+                        shift_count_q <= SHIFT_CNT_W'(CHAIN_BITS);
                         done_q        <= 1'b0;
                         error_code_q  <= 4'd0;
+                        stream_cap_q  <= 1'b0;
+                        stream_rst_q  <= wr_cmd_restore_stream;
+                        rom_rst_q     <= wr_cmd_reinit;
+                    end
+                    acc_full_q  <= 1'b0;
+                    acc_valid_q <= 1'b0;
+                    for (int c = 0; c < int'(N_CHAINS); c++) begin
+                        acc_q[c] <= 32'd0;
                     end
                     if (wr_clear_done) begin
                         done_q <= 1'b0;
@@ -243,18 +532,44 @@ module loom_scan_ctrl #(
                 end
 
                 StCapture: begin
-                    if (shift_count_q > 0) begin
-                        scan_data_q[word_idx][bit_in_word] <= scan_out_i;
+                    if (scan_enable_o) begin
+                        for (int c = 0; c < int'(N_CHAINS); c++) begin
+                            if (stream_cap_q)
+                                acc_q[c][bit_in_word] <= loop_out[c];
+                            else if (!STREAM_ONLY)
+                                scan_data_q[c * int'(WORDS_PER_CHAIN) + int'(word_idx)][bit_in_word]
+                                    <= loop_out[c];
+                        end
+                        // Word complete: hand it to the FIFO before shifting on
+                        if (stream_cap_q && bit_in_word == 5'd0)
+                            acc_full_q <= 1'b1;
                         shift_count_q <= shift_count_q - 1;
-                    end else begin
+                    end else if (fifo_push_acc) begin
+                        acc_full_q <= 1'b0;
+                        for (int c = 0; c < int'(N_CHAINS); c++) begin
+                            acc_q[c] <= 32'd0;
+                        end
+                    end else if (shift_count_q == '0 && !acc_full_q) begin
                         state_q <= StDone;
                     end
                 end
 
                 StRestore: begin
-                    if (shift_count_q > 0) begin
+                    if (scan_enable_o) begin
+                        if ((stream_rst_q || rom_rst_q) && bit_in_word == 5'd0)
+                            acc_valid_q <= 1'b0;
                         shift_count_q <= shift_count_q - 1;
-                    end else begin
+                    end else if (fifo_pop_acc) begin
+                        acc_valid_q <= 1'b1;
+                        for (int c = 0; c < int'(N_CHAINS); c++) begin
+                            acc_q[c] <= fifo_q[fifo_rd_ptr_q][c];
+                        end
+                    end else if (rom_load) begin
+                        acc_valid_q <= 1'b1;
+                        for (int c = 0; c < int'(N_CHAINS); c++) begin
+                            acc_q[c] <= rom_word[c];
+                        end
+                    end else if (shift_count_q == '0) begin
                         state_q <= StDone;
                     end
                 end
@@ -263,8 +578,11 @@ module loom_scan_ctrl #(
                     done_q <= 1'b1;
                     // Write effects while done
                     if (wr_clear_done) begin
-                        done_q  <= 1'b0;
-                        state_q <= StIdle;
+                        done_q       <= 1'b0;
+                        state_q      <= StIdle;
+                        stream_cap_q <= 1'b0;
+                        stream_rst_q <= 1'b0;
+                        rom_rst_q    <= 1'b0;
                     end
                     if (wr_data_en) begin
                         scan_data_q[wr_data_word_addr] <= wr_data_q;
@@ -280,13 +598,24 @@ module loom_scan_ctrl #(
     // AXI-Lite Read Interface
     // =========================================================================
 
-    logic [11:0] rd_addr_q;
+    logic [15:0] rd_addr_q;
     logic        rd_pending_q;
+    logic        rd_stream_win;
+    logic        rd_stall;
+
+    // SCAN_STREAM reads during a capture stream pop the FIFO and wait for
+    // data while the chains are still shifting; other window reads return
+    // 0xDEADBEEF.
+    assign rd_stream_win = rd_addr_q[15];
+    assign rd_stall      = rd_stream_win && stream_cap_q && fifo_empty &&
+                           state_q == StCapture;
+    assign fifo_pop_word = rd_pending_q && !axil_rvalid_o && rd_stream_win &&
+                           stream_cap_q && !fifo_empty;
 
     always_ff @(posedge clk_i or negedge rst_ni) begin
         if (!rst_ni) begin
             rd_pending_q   <= 1'b0;
-            rd_addr_q      <= 12'd0;
+            rd_addr_q      <= 16'd0;
             axil_arready_o <= 1'b0;
             axil_rvalid_o  <= 1'b0;
             axil_rdata_o   <= 32'd0;
@@ -299,23 +628,31 @@ module loom_scan_ctrl #(
                 rd_pending_q <= 1'b1;
             end
 
-            if (rd_pending_q && !axil_rvalid_o) begin
+            if (rd_pending_q && !axil_rvalid_o && !rd_stall) begin
                 axil_rvalid_o <= 1'b1;
                 axil_rresp_o  <= 2'b00;
 
-                case (rd_addr_q[11:2])
-                    10'h000: axil_rdata_o <= {24'd0, error_code_q, 2'd0, done_q, scan_busy_o};  // SCAN_STATUS
-                    10'h002: axil_rdata_o <= CHAIN_LENGTH;  // SCAN_LENGTH
-                    default: begin
-                        // SCAN_DATA registers start at offset 0x10 (word address 4)
-                        if (rd_addr_q[11:2] >= 10'h004 &&
-                            rd_addr_q[11:2] < 10'h004 + N_DATA_WORDS[9:0]) begin
-                            axil_rdata_o <= scan_data_q[rd_addr_q[11:2] - 10'h004];
-                        end else begin
-                            axil_rdata_o <= 32'hDEAD_BEEF;
+                if (rd_stream_win) begin
+                    axil_rdata_o <= fifo_pop_word ? fifo_q[fifo_rd_ptr_q][fifo_rd_word_q]
+                                                  : 32'hDEAD_BEEF;
+                end else begin
+                    case (rd_addr_q[15:2])
+                        14'h0000: axil_rdata_o <= {24'd0, error_code_q, 2'd0, done_q, scan_busy_o};  // SCAN_STATUS
+                        14'h0002: axil_rdata_o <= CHAIN_LENGTH;  // SCAN_LENGTH
+                        14'h0003: axil_rdata_o <= {STREAM_ONLY, HAS_RESET_ROM, 14'd0,
+                                                   16'(N_CHAINS)};  // SCAN_CHAINS
+                        default: begin
+                            // SCAN_DATA registers start at offset 0x10 (word address 4)
+                            if (!STREAM_ONLY &&
+                                rd_addr_q[15:2] >= 14'h0004 &&
+                                rd_addr_q[15:2] < 14'h0004 + N_DATA_WORDS[13:0]) begin
+                                axil_rdata_o <= scan_data_q[rd_addr_q[15:2] - 14'h0004];
+                            end else begin
+                                axil_rdata_o <= 32'hDEAD_BEEF;
+                            end
                         end
-                    end
-                endcase
+                    endcase
+                end
 
                 rd_pending_q <= 1'b0;
             end
@@ -5,14 +5,19 @@
 // DFX decoupler (AXI4-only), CDC, clock generator, reset synchronizer,
 // and loom_emu_top.
 //
+// The XDMA AXI4 (DMA) master reaches the same emu_top window through the
+// decoupler and an AXI4 → AXI-Lite bridge, arbitrated with MMIO ahead of
+// the firewall.
+//
 // Sub-module implementations differ between sim (behavioral BFMs) and
 // FPGA (Xilinx IPs), but the shell module itself is identical.
 //
-// Address Map (20-bit, 4 masters on aclk domain):
-//   [0x0_0000 – 0x3_FFFF]  firewall → CDC → loom_emu_top
-//   [0x4_0000 – 0x4_FFFF]  xlnx_clk_gen DRP
-//   [0x5_0000 – 0x5_FFFF]  firewall management registers
-//   [0x6_0000 – 0x6_FFFF]  loom_icap_ctrl (ICAP_ULTRASCALE, PCIe DFX)
+// Address Map (24-bit, 4 masters on aclk domain):
+//   [0x00_0000 – 0x03_FFFF]  arbiter → firewall → CDC → loom_emu_top
+//   [0x04_0000 – 0x04_FFFF]  xlnx_clk_gen DRP
+//   [0x05_0000 – 0x05_FFFF]  firewall management registers
+//   [0x06_0000 – 0x06_FFFF]  loom_icap_ctrl (ICAP_ULTRASCALE, PCIe DFX)
+//   [0xk0_0000 – 0xk3_FFFF]  loom_emu_top, instance k (emu_top -instances)
 
 module loom_shell (
     // PCIe (XDMA)
@@ -32,9 +37,12 @@ module loom_shell (
     // =========================================================================
     // Parameters
     // =========================================================================
-    localparam int ADDR_WIDTH    = 20;
-    localparam int N_IRQ         = 16;
-    localparam int N_MASTERS     = 4;
+    localparam int ADDR_WIDTH      = 24;
+    localparam int N_IRQ           = 16;
+    localparam int N_MASTERS       = 4;
+    // AXI-Lite requests in flight per channel on the emu_top path (DMA
+    // bridge, arbiter and firewall)
+    localparam int MAX_OUTSTANDING = 8;
 
     // =========================================================================
     // Clock Buffers
@@ -155,9 +163,13 @@ module loom_shell (
     wire [N_IRQ-1:0] irq    = irq_sync_q2;
     wire              finish = finish_sync_q2;
 
-    // XDMA user IRQ: OR all sources (DPI stall, state change, FIFO threshold, etc.)
+    // XDMA user IRQs: one MSI vector per source so the host learns the cause
+    // from the vector that fired. Vector 0 is reserved (it carried the OR of
+    // all sources in older shells); vectors 1..5 are irq[4:0], i.e. DPI
+    // stall, state change, FIFO threshold, scan done and mem done.
     // Pass full IRQ vector for BFM via loom_irq_i port.
-    wire              usr_irq = |irq;  // FPGA: single-bit OR for XDMA MSI
+    localparam int N_USR_IRQ = 6;
+    wire [N_USR_IRQ-1:0] usr_irq = {irq[N_USR_IRQ-2:0], 1'b0};
 
     /* verilator lint_off PINCONNECTEMPTY */
     xlnx_xdma u_xdma (
@@ -233,7 +245,7 @@ module loom_shell (
         .m_axil_bvalid  (xdma_axil_bvalid),
         .m_axil_bready  (xdma_axil_bready),
 
-        // IRQ — finish on bit 0; full IRQ vector to BFM
+        // IRQ — one vector per source; full IRQ vector to BFM
         .usr_irq_req      (usr_irq),
         .usr_irq_ack      (),
         .msi_enable       (),
@@ -256,10 +268,11 @@ module loom_shell (
     // =========================================================================
     // 2. AXI-Lite Demux (4 masters on aclk domain)
     // =========================================================================
-    // Master 0: [0x0_0000 – 0x3_FFFF] firewall s_axi → CDC → emu_top
-    // Master 1: [0x4_0000 – 0x4_FFFF] clk_gen DRP
-    // Master 2: [0x5_0000 – 0x5_FFFF] firewall s_mgmt (management registers)
-    // Master 3: [0x6_0000 – 0x6_FFFF] loom_icap_ctrl (ICAP_ULTRASCALE)
+    // Master 0: [0xk0_0000 – 0xk3_FFFF] firewall s_axi → CDC → emu_top
+    //           (k selects the emu_top instance; 0 without -instances)
+    // Master 1: [0x04_0000 – 0x04_FFFF] clk_gen DRP
+    // Master 2: [0x05_0000 – 0x05_FFFF] firewall s_mgmt (management registers)
+    // Master 3: [0x06_0000 – 0x06_FFFF] loom_icap_ctrl (ICAP_ULTRASCALE)
 
     wire [N_MASTERS*ADDR_WIDTH-1:0] demux_m_araddr;
     wire [N_MASTERS-1:0]            demux_m_arvalid;
@@ -283,8 +296,8 @@ module loom_shell (
     loom_axil_demux #(
         .ADDR_WIDTH (ADDR_WIDTH),
         .N_MASTERS  (N_MASTERS),
-        .BASE_ADDR  ({20'h60000, 20'h50000, 20'h40000, 20'h00000}),
-        .ADDR_MASK  ({20'hF0000, 20'hF0000, 20'hF0000, 20'hC0000})
+        .BASE_ADDR  ({24'h060000, 24'h050000, 24'h040000, 24'h000000}),
+        .ADDR_MASK  ({24'hFF0000, 24'hFF0000, 24'hFF0000, 24'h0C0000})
     ) u_demux (
         .clk_i  (aclk),
         .rst_ni (aresetn),
@@ -329,7 +342,98 @@ module loom_shell (
     );
 
     // =========================================================================
-    // 3. AXI-Lite Firewall (demux master 0 → CDC, mgmt on master 2)
+    // 2b. AXI-Lite Arbiter (demux master 0 + DMA bridge → firewall)
+    // =========================================================================
+
+    // DMA bridge AXI-Lite master (from section 4b)
+    wire [ADDR_WIDTH-1:0] dma_axil_araddr;
+    wire                  dma_axil_arvalid;
+    wire                  dma_axil_arready;
+    wire [31:0]           dma_axil_rdata;
+    wire [1:0]            dma_axil_rresp;
+    wire                  dma_axil_rvalid;
+    wire                  dma_axil_rready;
+
+    wire [ADDR_WIDTH-1:0] dma_axil_awaddr;
+    wire                  dma_axil_awvalid;
+    wire                  dma_axil_awready;
+    wire [31:0]           dma_axil_wdata;
+    wire [3:0]            dma_axil_wstrb;
+    wire                  dma_axil_wvalid;
+    wire                  dma_axil_wready;
+    wire [1:0]            dma_axil_bresp;
+    wire                  dma_axil_bvalid;
+    wire                  dma_axil_bready;
+
+    // Arbiter master side → firewall upstream
+    wire [ADDR_WIDTH-1:0] arb_m_araddr;
+    wire                  arb_m_arvalid;
+    wire                  arb_m_arready;
+    wire [31:0]           arb_m_rdata;
+    wire [1:0]            arb_m_rresp;
+    wire                  arb_m_rvalid;
+    wire                  arb_m_rready;
+
+    wire [ADDR_WIDTH-1:0] arb_m_awaddr;
+    wire                  arb_m_awvalid;
+    wire                  arb_m_awready;
+    wire [31:0]           arb_m_wdata;
+    wire [3:0]            arb_m_wstrb;
+    wire                  arb_m_wvalid;
+    wire                  arb_m_wready;
+    wire [1:0]            arb_m_bresp;
+    wire                  arb_m_bvalid;
+    wire                  arb_m_bready;
+
+    // Port 0: host MMIO (demux master 0), port 1: DMA bridge
+    loom_axil_arb #(
+        .ADDR_WIDTH      (ADDR_WIDTH),
+        .MAX_OUTSTANDING (MAX_OUTSTANDING)
+    ) u_axil_arb (
+        .clk_i  (aclk),
+        .rst_ni (aresetn),
+
+        .s_axil_araddr_i  ({dma_axil_araddr,  demux_m_araddr[0*ADDR_WIDTH +: ADDR_WIDTH]}),
+        .s_axil_arvalid_i ({dma_axil_arvalid, demux_m_arvalid[0]}),
+        .s_axil_arready_o ({dma_axil_arready, demux_m_arready[0]}),
+        .s_axil_rdata_o   ({dma_axil_rdata,   demux_m_rdata[0*32 +: 32]}),
+        .s_axil_rresp_o   ({dma_axil_rresp,   demux_m_rresp[0*2 +: 2]}),
+        .s_axil_rvalid_o  ({dma_axil_rvalid,  demux_m_rvalid[0]}),
+        .s_axil_rready_i  ({dma_axil_rready,  demux_m_rready[0]}),
+
+        .s_axil_awaddr_i  ({dma_axil_awaddr,  demux_m_awaddr[0*ADDR_WIDTH +: ADDR_WIDTH]}),
+        .s_axil_awvalid_i ({dma_axil_awvalid, demux_m_awvalid[0]}),
+        .s_axil_awready_o ({dma_axil_awready, demux_m_awready[0]}),
+        .s_axil_wdata_i   ({dma_axil_wdata,   demux_m_wdata[0*32 +: 32]}),
+        .s_axil_wstrb_i   ({dma_axil_wstrb,   demux_m_wstrb[0*4 +: 4]}),
+        .s_axil_wvalid_i  ({dma_axil_wvalid,  demux_m_wvalid[0]}),
+        .s_axil_wready_o  ({dma_axil_wready,  demux_m_wready[0]}),
+        .s_axil_bresp_o   ({dma_axil_bresp,   demux_m_bresp[0*2 +: 2]}),
+        .s_axil_bvalid_o  ({dma_axil_bvalid,  demux_m_bvalid[0]}),
+        .s_axil_bready_i  ({dma_axil_bready,  demux_m_bready[0]}),
+
+        .m_axil_araddr_o  (arb_m_araddr),
+        .m_axil_arvalid_o (arb_m_arvalid),
+        .m_axil_arready_i (arb_m_arready),
+        .m_axil_rdata_i   (arb_m_rdata),
+        .m_axil_rresp_i   (arb_m_rresp),
+        .m_axil_rvalid_i  (arb_m_rvalid),
+        .m_axil_rready_o  (arb_m_rready),
+
+        .m_axil_awaddr_o  (arb_m_awaddr),
+        .m_axil_awvalid_o (arb_m_awvalid),
+        .m_axil_awready_i (arb_m_awready),
+        .m_axil_wdata_o   (arb_m_wdata),
+        .m_axil_wstrb_o   (arb_m_wstrb),
+        .m_axil_wvalid_o  (arb_m_wvalid),
+        .m_axil_wready_i  (arb_m_wready),
+        .m_axil_bresp_i   (arb_m_bresp),
+        .m_axil_bvalid_i  (arb_m_bvalid),
+        .m_axil_bready_o  (arb_m_bready)
+    );
+
+    // =========================================================================
+    // 3. AXI-Lite Firewall (arbiter → CDC, mgmt on demux master 2)
     // =========================================================================
 
     // Firewall master-side → CDC source
@@ -358,32 +462,33 @@ module loom_shell (
 
     /* verilator lint_off PINCONNECTEMPTY */
     loom_axil_firewall #(
-        .DATA_WIDTH (32),
-        .ADDR_WIDTH (ADDR_WIDTH)
+        .DATA_WIDTH           (32),
+        .ADDR_WIDTH           (ADDR_WIDTH),
+        .MAX_OUTSTANDING_INIT (MAX_OUTSTANDING)
     ) u_firewall (
         .clk_i  (aclk),
         .rst_ni (aresetn),
 
-        // Upstream: demux master 0
-        .s_axi_awaddr  (demux_m_awaddr[0*ADDR_WIDTH +: ADDR_WIDTH]),
+        // Upstream: arbiter (host MMIO + DMA bridge)
+        .s_axi_awaddr  (arb_m_awaddr),
         .s_axi_awprot  (3'b000),
-        .s_axi_awvalid (demux_m_awvalid[0]),
-        .s_axi_awready (demux_m_awready[0]),
-        .s_axi_wdata   (demux_m_wdata[0*32 +: 32]),
-        .s_axi_wstrb   (demux_m_wstrb[0*4 +: 4]),
-        .s_axi_wvalid  (demux_m_wvalid[0]),
-        .s_axi_wready  (demux_m_wready[0]),
-        .s_axi_bresp   (demux_m_bresp[0*2 +: 2]),
-        .s_axi_bvalid  (demux_m_bvalid[0]),
-        .s_axi_bready  (demux_m_bready[0]),
-        .s_axi_araddr  (demux_m_araddr[0*ADDR_WIDTH +: ADDR_WIDTH]),
+        .s_axi_awvalid (arb_m_awvalid),
+        .s_axi_awready (arb_m_awready),
+        .s_axi_wdata   (arb_m_wdata),
+        .s_axi_wstrb   (arb_m_wstrb),
+        .s_axi_wvalid  (arb_m_wvalid),
+        .s_axi_wready  (arb_m_wready),
+        .s_axi_bresp   (arb_m_bresp),
+        .s_axi_bvalid  (arb_m_bvalid),
+        .s_axi_bready  (arb_m_bready),
+        .s_axi_araddr  (arb_m_araddr),
         .s_axi_arprot  (3'b000),
-        .s_axi_arvalid (demux_m_arvalid[0]),
-        .s_axi_arready (demux_m_arready[0]),
-        .s_axi_rdata   (demux_m_rdata[0*32 +: 32]),
-        .s_axi_rresp   (demux_m_rresp[0*2 +: 2]),
-        .s_axi_rvalid  (demux_m_rvalid[0]),
-        .s_axi_rready  (demux_m_rready[0]),
+        .s_axi_arvalid (arb_m_arvalid),
+        .s_axi_arready (arb_m_arready),
+        .s_axi_rdata   (arb_m_rdata),
+        .s_axi_rresp   (arb_m_rresp),
+        .s_axi_rvalid  (arb_m_rvalid),
+        .s_axi_rready  (arb_m_rready),
 
         // Downstream: → CDC
         .m_axi_awaddr  (fw_m_awaddr),
@@ -480,131 +585,153 @@ module loom_shell (
         .s_intf1_RVALID  (xdma_axi4_rvalid),
         .s_intf1_RREADY  (xdma_axi4_rready),
 
-        // Interface 1 (AXI4): RP side → error slave (future: DMA slave)
-        .rp_intf1_AWID    (axi4_err_awid),
-        .rp_intf1_AWADDR  (axi4_err_awaddr),
-        .rp_intf1_AWLEN   (axi4_err_awlen),
-        .rp_intf1_AWSIZE  (axi4_err_awsize),
-        .rp_intf1_AWBURST (axi4_err_awburst),
-        .rp_intf1_AWLOCK  (axi4_err_awlock),
-        .rp_intf1_AWCACHE (axi4_err_awcache),
-        .rp_intf1_AWPROT  (axi4_err_awprot),
-        .rp_intf1_AWVALID (axi4_err_awvalid),
-        .rp_intf1_AWREADY (axi4_err_awready),
-        .rp_intf1_WDATA   (axi4_err_wdata),
-        .rp_intf1_WSTRB   (axi4_err_wstrb),
-        .rp_intf1_WLAST   (axi4_err_wlast),
-        .rp_intf1_WVALID  (axi4_err_wvalid),
-        .rp_intf1_WREADY  (axi4_err_wready),
-        .rp_intf1_BID     (axi4_err_bid),
-        .rp_intf1_BRESP   (axi4_err_bresp),
-        .rp_intf1_BVALID  (axi4_err_bvalid),
-        .rp_intf1_BREADY  (axi4_err_bready),
-        .rp_intf1_ARID    (axi4_err_arid),
-        .rp_intf1_ARADDR  (axi4_err_araddr),
-        .rp_intf1_ARLEN   (axi4_err_arlen),
-        .rp_intf1_ARSIZE  (axi4_err_arsize),
-        .rp_intf1_ARBURST (axi4_err_arburst),
-        .rp_intf1_ARLOCK  (axi4_err_arlock),
-        .rp_intf1_ARCACHE (axi4_err_arcache),
-        .rp_intf1_ARPROT  (axi4_err_arprot),
-        .rp_intf1_ARVALID (axi4_err_arvalid),
-        .rp_intf1_ARREADY (axi4_err_arready),
-        .rp_intf1_RID     (axi4_err_rid),
-        .rp_intf1_RDATA   (axi4_err_rdata),
-        .rp_intf1_RRESP   (axi4_err_rresp),
-        .rp_intf1_RLAST   (axi4_err_rlast),
-        .rp_intf1_RVALID  (axi4_err_rvalid),
-        .rp_intf1_RREADY  (axi4_err_rready)
+        // Interface 1 (AXI4): RP side → DMA bridge
+        .rp_intf1_AWID    (dma_axi4_awid),
+        .rp_intf1_AWADDR  (dma_axi4_awaddr),
+        .rp_intf1_AWLEN   (dma_axi4_awlen),
+        .rp_intf1_AWSIZE  (dma_axi4_awsize),
+        .rp_intf1_AWBURST (dma_axi4_awburst),
+        .rp_intf1_AWLOCK  (dma_axi4_awlock),
+        .rp_intf1_AWCACHE (dma_axi4_awcache),
+        .rp_intf1_AWPROT  (dma_axi4_awprot),
+        .rp_intf1_AWVALID (dma_axi4_awvalid),
+        .rp_intf1_AWREADY (dma_axi4_awready),
+        .rp_intf1_WDATA   (dma_axi4_wdata),
+        .rp_intf1_WSTRB   (dma_axi4_wstrb),
+        .rp_intf1_WLAST   (dma_axi4_wlast),
+        .rp_intf1_WVALID  (dma_axi4_wvalid),
+        .rp_intf1_WREADY  (dma_axi4_wready),
+        .rp_intf1_BID     (dma_axi4_bid),
+        .rp_intf1_BRESP   (dma_axi4_bresp),
+        .rp_intf1_BVALID  (dma_axi4_bvalid),
+        .rp_intf1_BREADY  (dma_axi4_bready),
+        .rp_intf1_ARID    (dma_axi4_arid),
+        .rp_intf1_ARADDR  (dma_axi4_araddr),
+        .rp_intf1_ARLEN   (dma_axi4_arlen),
+        .rp_intf1_ARSIZE  (dma_axi4_arsize),
+        .rp_intf1_ARBURST (dma_axi4_arburst),
+        .rp_intf1_ARLOCK  (dma_axi4_arlock),
+        .rp_intf1_ARCACHE (dma_axi4_arcache),
+        .rp_intf1_ARPROT  (dma_axi4_arprot),
+        .rp_intf1_ARVALID (dma_axi4_arvalid),
+        .rp_intf1_ARREADY (dma_axi4_arready),
+        .rp_intf1_RID     (dma_axi4_rid),
+        .rp_intf1_RDATA   (dma_axi4_rdata),
+        .rp_intf1_RRESP   (dma_axi4_rresp),
+        .rp_intf1_RLAST   (dma_axi4_rlast),
+        .rp_intf1_RVALID  (dma_axi4_rvalid),
+        .rp_intf1_RREADY  (dma_axi4_rready)
     );
     /* verilator lint_on PINCONNECTEMPTY */
 
     // =========================================================================
-    // 4b. AXI4 Error Slave (DMA RP side)
+    // 4b. AXI4 → AXI-Lite DMA Bridge (DMA RP side)
     // =========================================================================
-    // The XDMA AXI4 DMA port is not used yet.  A proper error slave
-    // ensures that any stray DMA transaction gets a DECERR response
-    // instead of hanging the bus.
-
-    wire [3:0]   axi4_err_awid;
-    wire [63:0]  axi4_err_awaddr;
-    wire [7:0]   axi4_err_awlen;
-    wire [2:0]   axi4_err_awsize;
-    wire [1:0]   axi4_err_awburst;
-    wire         axi4_err_awlock;
-    wire [3:0]   axi4_err_awcache;
-    wire [2:0]   axi4_err_awprot;
-    wire         axi4_err_awvalid;
-    wire         axi4_err_awready;
-    wire [127:0] axi4_err_wdata;
-    wire [15:0]  axi4_err_wstrb;
-    wire         axi4_err_wlast;
-    wire         axi4_err_wvalid;
-    wire         axi4_err_wready;
-    wire [3:0]   axi4_err_bid;
-    wire [1:0]   axi4_err_bresp;
-    wire         axi4_err_bvalid;
-    wire         axi4_err_bready;
-    wire [3:0]   axi4_err_arid;
-    wire [63:0]  axi4_err_araddr;
-    wire [7:0]   axi4_err_arlen;
-    wire [2:0]   axi4_err_arsize;
-    wire [1:0]   axi4_err_arburst;
-    wire         axi4_err_arlock;
-    wire [3:0]   axi4_err_arcache;
-    wire [2:0]   axi4_err_arprot;
-    wire         axi4_err_arvalid;
-    wire         axi4_err_arready;
-    wire [3:0]   axi4_err_rid;
-    wire [127:0] axi4_err_rdata;
-    wire [1:0]   axi4_err_rresp;
-    wire         axi4_err_rlast;
-    wire         axi4_err_rvalid;
-    wire         axi4_err_rready;
-
-    loom_axi4_err_slv #(
-        .ID_WIDTH   (4),
-        .DATA_WIDTH (128),
-        .RESP       (2'b11)  // DECERR
-    ) u_axi4_err_slv (
+    // XDMA H2C/C2H bursts into [0x0_0000 – 0x3_FFFF] are split into 32-bit
+    // AXI-Lite accesses and merged into the emu_top path by the arbiter
+    // (section 2b). Bursts outside that window get DECERR. The accesses are
+    // pipelined, so the CDC latency is paid once per MAX_OUTSTANDING words.
+
+    wire [3:0]   dma_axi4_awid;
+    wire [63:0]  dma_axi4_awaddr;
+    wire [7:0]   dma_axi4_awlen;
+    wire [2:0]   dma_axi4_awsize;
+    wire [1:0]   dma_axi4_awburst;
+    wire         dma_axi4_awlock;
+    wire [3:0]   dma_axi4_awcache;
+    wire [2:0]   dma_axi4_awprot;
+    wire         dma_axi4_awvalid;
+    wire         dma_axi4_awready;
+    wire [127:0] dma_axi4_wdata;
+    wire [15:0]  dma_axi4_wstrb;
+    wire         dma_axi4_wlast;
+    wire         dma_axi4_wvalid;
+    wire         dma_axi4_wready;
+    wire [3:0]   dma_axi4_bid;
+    wire [1:0]   dma_axi4_bresp;
+    wire         dma_axi4_bvalid;
+    wire         dma_axi4_bready;
+    wire [3:0]   dma_axi4_arid;
+    wire [63:0]  dma_axi4_araddr;
+    wire [7:0]   dma_axi4_arlen;
+    wire [2:0]   dma_axi4_arsize;
+    wire [1:0]   dma_axi4_arburst;
+    wire         dma_axi4_arlock;
+    wire [3:0]   dma_axi4_arcache;
+    wire [2:0]   dma_axi4_arprot;
+    wire         dma_axi4_arvalid;
+    wire         dma_axi4_arready;
+    wire [3:0]   dma_axi4_rid;
+    wire [127:0] dma_axi4_rdata;
+    wire [1:0]   dma_axi4_rresp;
+    wire         dma_axi4_rlast;
+    wire         dma_axi4_rvalid;
+    wire         dma_axi4_rready;
+
+    loom_axi4_to_axil #(
+        .ID_WIDTH        (4),
+        .DATA_WIDTH      (128),
+        .ADDR_WIDTH      (ADDR_WIDTH),
+        .WINDOW_END      (64'd1 << ADDR_WIDTH),   // emu_top answers its holes
+        .MAX_OUTSTANDING (MAX_OUTSTANDING)
+    ) u_dma_bridge (
         .clk_i  (aclk),
         .rst_ni (aresetn),
 
-        .s_axi_awid    (axi4_err_awid),
-        .s_axi_awaddr  (axi4_err_awaddr),
-        .s_axi_awlen   (axi4_err_awlen),
-        .s_axi_awsize  (axi4_err_awsize),
-        .s_axi_awburst (axi4_err_awburst),
-        .s_axi_awlock  (axi4_err_awlock),
-        .s_axi_awcache (axi4_err_awcache),
-        .s_axi_awprot  (axi4_err_awprot),
-        .s_axi_awvalid (axi4_err_awvalid),
-        .s_axi_awready (axi4_err_awready),
-        .s_axi_wdata   (axi4_err_wdata),
-        .s_axi_wstrb   (axi4_err_wstrb),
-        .s_axi_wlast   (axi4_err_wlast),
-        .s_axi_wvalid  (axi4_err_wvalid),
-        .s_axi_wready  (axi4_err_wready),
-        .s_axi_bid     (axi4_err_bid),
-        .s_axi_bresp   (axi4_err_bresp),
-        .s_axi_bvalid  (axi4_err_bvalid),
-        .s_axi_bready  (axi4_err_bready),
-        .s_axi_arid    (axi4_err_arid),
-        .s_axi_araddr  (axi4_err_araddr),
-        .s_axi_arlen   (axi4_err_arlen),
-        .s_axi_arsize  (axi4_err_arsize),
-        .s_axi_arburst (axi4_err_arburst),
-        .s_axi_arlock  (axi4_err_arlock),
-        .s_axi_arcache (axi4_err_arcache),
-        .s_axi_arprot  (axi4_err_arprot),
-        .s_axi_arvalid (axi4_err_arvalid),
-        .s_axi_arready (axi4_err_arready),
-        .s_axi_rid     (axi4_err_rid),
-        .s_axi_rdata   (axi4_err_rdata),
-        .s_axi_rresp   (axi4_err_rresp),
-        .s_axi_rlast   (axi4_err_rlast),
-        .s_axi_rvalid  (axi4_err_rvalid),
-        .s_axi_rready  (axi4_err_rready)
+        .s_axi_awid    (dma_axi4_awid),
+        .s_axi_awaddr  (dma_axi4_awaddr),
+        .s_axi_awlen   (dma_axi4_awlen),
+        .s_axi_awsize  (dma_axi4_awsize),
+        .s_axi_awburst (dma_axi4_awburst),
+        .s_axi_awlock  (dma_axi4_awlock),
+        .s_axi_awcache (dma_axi4_awcache),
+        .s_axi_awprot  (dma_axi4_awprot),
+        .s_axi_awvalid (dma_axi4_awvalid),
+        .s_axi_awready (dma_axi4_awready),
+        .s_axi_wdata   (dma_axi4_wdata),
+        .s_axi_wstrb   (dma_axi4_wstrb),
+        .s_axi_wlast   (dma_axi4_wlast),
+        .s_axi_wvalid  (dma_axi4_wvalid),
+        .s_axi_wready  (dma_axi4_wready),
+        .s_axi_bid     (dma_axi4_bid),
+        .s_axi_bresp   (dma_axi4_bresp),
+        .s_axi_bvalid  (dma_axi4_bvalid),
+        .s_axi_bready  (dma_axi4_bready),
+        .s_axi_arid    (dma_axi4_arid),
+        .s_axi_araddr  (dma_axi4_araddr),
+        .s_axi_arlen   (dma_axi4_arlen),
+        .s_axi_arsize  (dma_axi4_arsize),
+        .s_axi_arburst (dma_axi4_arburst),
+        .s_axi_arlock  (dma_axi4_arlock),
+        .s_axi_arcache (dma_axi4_arcache),
+        .s_axi_arprot  (dma_axi4_arprot),
+        .s_axi_arvalid (dma_axi4_arvalid),
+        .s_axi_arready (dma_axi4_arready),
+        .s_axi_rid     (dma_axi4_rid),
+        .s_axi_rdata   (dma_axi4_rdata),
+        .s_axi_rresp   (dma_axi4_rresp),
+        .s_axi_rlast   (dma_axi4_rlast),
+        .s_axi_rvalid  (dma_axi4_rvalid),
+        .s_axi_rready  (dma_axi4_rready),
+
+        .m_axil_araddr_o  (dma_axil_araddr),
+        .m_axil_arvalid_o (dma_axil_arvalid),
+        .m_axil_arready_i (dma_axil_arready),
+        .m_axil_rdata_i   (dma_axil_rdata),
+        .m_axil_rresp_i   (dma_axil_rresp),
+        .m_axil_rvalid_i  (dma_axil_rvalid),
+        .m_axil_rready_o  (dma_axil_rready),
+
+        .m_axil_awaddr_o  (dma_axil_awaddr),
+        .m_axil_awvalid_o (dma_axil_awvalid),
+        .m_axil_awready_i (dma_axil_awready),
+        .m_axil_wdata_o   (dma_axil_wdata),
+        .m_axil_wstrb_o   (dma_axil_wstrb),
+        .m_axil_wvalid_o  (dma_axil_wvalid),
+        .m_axil_wready_i  (dma_axil_wready),
+        .m_axil_bresp_i   (dma_axil_bresp),
+        .m_axil_bvalid_i  (dma_axil_bvalid),
+        .m_axil_bready_o  (dma_axil_bready)
     );
 
     // =========================================================================
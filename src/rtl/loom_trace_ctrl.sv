@@ -0,0 +1,357 @@
+// SPDX-License-Identifier: Apache-2.0
+// Loom Trace Controller
+//
+// Records selected DUT signals every emulated cycle into an on-chip trace
+// RAM while emulation runs. The probe vector is the DUT's loom_trace_data
+// output, built by scan_insert -trace from the requested registers. The
+// host drains entries through a read window without stopping the DUT.
+//
+// Each entry is ENTRY_WORDS words: word 0 is the low 32 bits of the DUT
+// cycle counter, words 1.. hold the probe bits LSB first.
+//
+// Register Map (offset from base 0x38000):
+//   0x00  TRACE_STATUS      R   [0]=armed, [1]=capturing, [2]=done, [3]=overflow,
+//                               [4]=full
+//   0x04  TRACE_CONTROL     W   Command [7:0]: 1=arm, 2=stop, 3=clear
+//                               [8]: with arm, stall the DUT while the RAM is full
+//                               instead of dropping entries
+//   0x08  TRACE_WIDTH       R   Probe bits (parameter)
+//   0x0C  TRACE_DEPTH       R   RAM entries (parameter)
+//   0x10  TRACE_LEVEL       R   Entries waiting to be read
+//   0x14  TRACE_DROPPED     R   Cycles lost to a full RAM since arm / clear
+//   0x18  TRACE_TRIG_WORD   RW  Probe word compared by the trigger
+//   0x1C  TRACE_TRIG_MASK   RW  Trigger bit mask (0 = trigger on arm)
+//   0x20  TRACE_TRIG_VALUE  RW  Trigger value under the mask
+//   0x24  TRACE_POST        RW  Cycles to record from the trigger on (0 = until stop)
+//   0x28  TRACE_ENTRY_WORDS R   Words per entry
+//   0x800-0xFFF TRACE_STREAM R  Read window (any word address): each read returns
+//                               the next word of the oldest entry. Reads with no
+//                               entry waiting return 0xDEADBEEF.
+//
+// Operation:
+//   Arm:     clears the RAM and counters and waits for the trigger. The cycle
+//            that matches is the first one recorded.
+//   Capture: every cycle with dut_en_i set is recorded, until TRACE_POST
+//            cycles have been seen or the host issues stop.
+//   Stop:    ends the capture (done) or cancels a pending trigger (idle).
+//   Clear:   drops waiting entries and zeroes TRACE_DROPPED.
+
+module loom_trace_ctrl #(
+    parameter int unsigned WIDTH = 32,     // Probe bits
+    parameter int unsigned DEPTH = 1024,   // RAM entries, power of 2
+    parameter int unsigned DATA_WORDS  = (WIDTH + 31) / 32,
+    parameter int unsigned ENTRY_WORDS = DATA_WORDS + 1
+)(
+    input  logic        clk_i,
+    input  logic        rst_ni,
+
+    // AXI-Lite Slave interface
+    input  logic [11:0] axil_araddr_i,
+    input  logic        axil_arvalid_i,
+    output logic        axil_arready_o,
+    output logic [31:0] axil_rdata_o,
+    output logic [1:0]  axil_rresp_o,
+    output logic        axil_rvalid_o,
+    input  logic        axil_rready_i,
+
+    input  logic [11:0] axil_awaddr_i,
+    input  logic        axil_awvalid_i,
+    output logic        axil_awready_o,
+    input  logic [31:0] axil_wdata_i,
+    input  logic        axil_wvalid_i,
+    output logic        axil_wready_o,
+    output logic [1:0]  axil_bresp_o,
+    output logic        axil_bvalid_o,
+    input  logic        axil_bready_i,
+
+    // DUT side
+    input  logic             dut_en_i,     // DUT advances this cycle
+    input  logic [31:0]      cycle_i,      // Cycle counter (low word)
+    input  logic [WIDTH-1:0] probe_i,
+
+    // Hold the DUT while the RAM is full (lossless mode)
+    output logic             stall_o
+);
+
+    localparam int unsigned PTR_BITS  = (DEPTH <= 1) ? 1 : $clog2(DEPTH);
+    localparam int unsigned WORD_BITS = (ENTRY_WORDS <= 1) ? 1 : $clog2(ENTRY_WORDS);
+
+    typedef enum logic [1:0] {
+        StIdle    = 2'd0,
+        StArmed   = 2'd1,  // Waiting for the trigger
+        StCapture = 2'd2,  // Recording every enabled cycle
+        StDone    = 2'd3
+    } state_e;
+
+    localparam logic [7:0] CMD_ARM   = 8'h01;
+    localparam logic [7:0] CMD_STOP  = 8'h02;
+    localparam logic [7:0] CMD_CLEAR = 8'h03;
+
+    state_e state_q;
+    logic        stall_en_q;
+    logic [31:0] trig_word_q, trig_mask_q, trig_value_q, post_q;
+    logic [31:0] post_cnt_q;
+    logic [31:0] dropped_q;
+
+    logic [PTR_BITS-1:0] wr_ptr_q, rd_ptr_q;
+    logic [PTR_BITS:0]   count_q;                 // Entries in RAM (head excluded)
+    logic                head_valid_q;
+    logic [31:0]         head_q [ENTRY_WORDS];    // Entry being read out
+    logic [WORD_BITS-1:0] head_word_q;
+    logic                rd_stream_pop;
+
+    logic full;
+    assign full = (count_q == (PTR_BITS + 1)'(DEPTH));
+
+    // =========================================================================
+    // AXI-Lite Write Handshake
+    // =========================================================================
+
+    logic        wr_addr_valid_q, wr_data_valid_q;
+    logic [11:0] wr_addr_q;
+    logic [31:0] wr_data_q;
+
+    logic wr_fire;
+    logic wr_cmd_arm, wr_cmd_stop, wr_cmd_clear;
+
+    assign wr_fire = wr_addr_valid_q && wr_data_valid_q && !axil_bvalid_o;
+
+    always_comb begin
+        wr_cmd_arm   = 1'b0;
+        wr_cmd_stop  = 1'b0;
+        wr_cmd_clear = 1'b0;
+        if (wr_fire && wr_addr_q[11:2] == 10'h001) begin
+            case (wr_data_q[7:0])
+                CMD_ARM:   wr_cmd_arm   = 1'b1;
+                CMD_STOP:  wr_cmd_stop  = 1'b1;
+                CMD_CLEAR: wr_cmd_clear = 1'b1;
+                default: ;
+            endcase
+        end
+    end
+
+    always_ff @(posedge clk_i or negedge rst_ni) begin
+        if (!rst_ni) begin
+            wr_addr_valid_q <= 1'b0;
+            wr_data_valid_q <= 1'b0;
+            wr_addr_q       <= 12'd0;
+            wr_data_q       <= 32'd0;
+            axil_awready_o  <= 1'b0;
+            axil_wready_o   <= 1'b0;
+            axil_bvalid_o   <= 1'b0;
+            axil_bresp_o    <= 2'b00;
+            trig_word_q     <= 32'd0;
+            trig_mask_q     <= 32'd0;
+            trig_value_q    <= 32'd0;
+            post_q          <= 32'd0;
+        end else begin
+            axil_awready_o <= 1'b1;
+            axil_wready_o  <= 1'b1;
+
+            if (axil_awvalid_i && axil_awready_o) begin
+                wr_addr_q       <= axil_awaddr_i;
+                wr_addr_valid_q <= 1'b1;
+            end
+
+            if (axil_wvalid_i && axil_wready_o) begin
+                wr_data_q       <= axil_wdata_i;
+                wr_data_valid_q <= 1'b1;
+            end
+
+            if (wr_fire) begin
+                wr_addr_valid_q <= 1'b0;
+                wr_data_valid_q <= 1'b0;
+                axil_bvalid_o   <= 1'b1;
+                axil_bresp_o    <= 2'b00;
+                case (wr_addr_q[11:2])
+                    10'h006: trig_word_q  <= wr_data_q;
+                    10'h007: trig_mask_q  <= wr_data_q;
+                    10'h008: trig_value_q <= wr_data_q;
+                    10'h009: post_q       <= wr_data_q;
+                    default: ;
+                endcase
+            end
+
+            if (axil_bvalid_o && axil_bready_i) begin
+                axil_bvalid_o <= 1'b0;
+            end
+        end
+    end
+
+    // =========================================================================
+    // Trigger and Capture
+    // =========================================================================
+
+    logic [DATA_WORDS*32-1:0] probe_pad;
+    logic [31:0] trig_probe;
+    logic        trig_hit;
+    logic        capture, push, drop, post_reached;
+
+    assign probe_pad = (DATA_WORDS * 32)'(probe_i);
+
+    always_comb begin
+        trig_probe = 32'd0;
+        for (int w = 0; w < int'(DATA_WORDS); w++) begin
+            if (trig_word_q == 32'(w))
+                trig_probe = probe_pad[w * 32 +: 32];
+        end
+    end
+    assign trig_hit   = ((trig_probe ^ trig_value_q) & trig_mask_q) == 32'd0;
+
+    assign capture = dut_en_i && (state_q == StCapture || (state_q == StArmed && trig_hit));
+    assign push    = capture && !full;
+    assign drop    = capture && full;
+    assign post_reached = (post_q != 32'd0) && (post_cnt_q + 32'd1 >= post_q);
+
+    assign stall_o = stall_en_q && full && (state_q == StArmed || state_q == StCapture);
+
+    always_ff @(posedge clk_i or negedge rst_ni) begin
+        if (!rst_ni) begin
+            state_q    <= StIdle;
+            stall_en_q <= 1'b0;
+            post_cnt_q <= 32'd0;
+        end else begin
+            case (state_q)
+                StArmed, StCapture: begin
+                    if (capture) begin
+                        post_cnt_q <= post_cnt_q + 32'd1;
+                        state_q    <= post_reached ? StDone : StCapture;
+                    end
+                    if (wr_cmd_stop)
+                        state_q <= (state_q == StArmed && !capture) ? StIdle : StDone;
+                end
+                default: ;
+            endcase
+            if (wr_cmd_arm) begin
+                state_q    <= StArmed;
+                stall_en_q <= wr_data_q[8];
+                post_cnt_q <= 32'd0;
+            end
+        end
+    end
+
+    // =========================================================================
+    // Trace RAM (FIFO)
+    // =========================================================================
+
+    logic [ENTRY_WORDS*32-1:0] ram_q [DEPTH];
+    logic fetch;
+    logic flush;
+
+    assign flush = wr_cmd_arm || wr_cmd_clear;
+    assign fetch = !head_valid_q && count_q != '0 && !flush;
+
+    always_ff @(posedge clk_i) begin
+        if (push)
+            ram_q[wr_ptr_q] <= {probe_pad, cycle_i};
+        if (fetch) begin
+            for (int w = 0; w < int'(ENTRY_WORDS); w++)
+                head_q[w] <= ram_q[rd_ptr_q][w * 32 +: 32];
+        end
+    end
+
+    always_ff @(posedge clk_i or negedge rst_ni) begin
+        if (!rst_ni) begin
+            wr_ptr_q     <= '0;
+            rd_ptr_q     <= '0;
+            count_q      <= '0;
+            head_valid_q <= 1'b0;
+            head_word_q  <= '0;
+            dropped_q    <= 32'd0;
+        end else if (flush) begin
+            wr_ptr_q     <= '0;
+            rd_ptr_q     <= '0;
+            count_q      <= '0;
+            head_valid_q <= 1'b0;
+            head_word_q  <= '0;
+            dropped_q    <= 32'd0;
+        end else begin
+            if (push)
+                wr_ptr_q <= wr_ptr_q + PTR_BITS'(1);
+            if (fetch)
+                rd_ptr_q <= rd_ptr_q + PTR_BITS'(1);
+            count_q <= count_q + (PTR_BITS + 1)'(push) - (PTR_BITS + 1)'(fetch);
+            if (drop)
+                dropped_q <= dropped_q + 32'd1;
+
+            if (fetch) begin
+                head_valid_q <= 1'b1;
+                head_word_q  <= '0;
+            end else if (rd_stream_pop) begin
+                if (head_word_q == WORD_BITS'(ENTRY_WORDS - 1)) begin
+                    head_valid_q <= 1'b0;
+                    head_word_q  <= '0;
+                end else begin
+                    head_word_q <= head_word_q + WORD_BITS'(1);
+                end
+            end
+        end
+    end
+
+    // =========================================================================
+    // AXI-Lite Read Interface
+    // =========================================================================
+
+    logic [11:0] rd_addr_q;
+    logic        rd_pending_q;
+    logic        rd_stream_win;
+    logic        rd_stream_wait;
+    logic [PTR_BITS:0] level;
+
+    assign level = count_q + (PTR_BITS + 1)'(head_valid_q);
+
+    // TRACE_STREAM reads wait for an entry that is still being fetched
+    assign rd_stream_win  = rd_addr_q[11];
+    assign rd_stream_wait = rd_stream_win && !head_valid_q && count_q != '0;
+    assign rd_stream_pop  = rd_pending_q && !axil_rvalid_o && rd_stream_win && head_valid_q;
+
+    always_ff @(posedge clk_i or negedge rst_ni) begin
+        if (!rst_ni) begin
+            rd_pending_q   <= 1'b0;
+            rd_addr_q      <= 12'd0;
+            axil_arready_o <= 1'b0;
+            axil_rvalid_o  <= 1'b0;
+            axil_rdata_o   <= 32'd0;
+            axil_rresp_o   <= 2'b00;
+        end else begin
+            axil_arready_o <= 1'b1;
+
+            if (axil_arvalid_i && axil_arready_o) begin
+                rd_addr_q    <= axil_araddr_i;
+                rd_pending_q <= 1'b1;
+            end
+
+            if (rd_pending_q && !axil_rvalid_o && !rd_stream_wait) begin
+                axil_rvalid_o <= 1'b1;
+                axil_rresp_o  <= 2'b00;
+
+                if (rd_stream_win) begin
+                    axil_rdata_o <= head_valid_q ? head_q[head_word_q] : 32'hDEAD_BEEF;
+                end else begin
+                    case (rd_addr_q[11:2])
+                        10'h000: axil_rdata_o <= {27'd0, full, dropped_q != 32'd0,
+                                                  state_q == StDone, state_q == StCapture,
+                                                  state_q == StArmed};       // TRACE_STATUS
+                        10'h002: axil_rdata_o <= WIDTH;                      // TRACE_WIDTH
+                        10'h003: axil_rdata_o <= DEPTH;                      // TRACE_DEPTH
+                        10'h004: axil_rdata_o <= 32'(level);                 // TRACE_LEVEL
+                        10'h005: axil_rdata_o <= dropped_q;                  // TRACE_DROPPED
+                        10'h006: axil_rdata_o <= trig_word_q;                // TRACE_TRIG_WORD
+                        10'h007: axil_rdata_o <= trig_mask_q;                // TRACE_TRIG_MASK
+                        10'h008: axil_rdata_o <= trig_value_q;               // TRACE_TRIG_VALUE
+                        10'h009: axil_rdata_o <= post_q;                     // TRACE_POST
+                        10'h00A: axil_rdata_o <= ENTRY_WORDS;                // TRACE_ENTRY_WORDS
+                        default: axil_rdata_o <= 32'hDEAD_BEEF;
+                    endcase
+                end
+
+                rd_pending_q <= 1'b0;
+            end
+
+            if (axil_rvalid_o && axil_rready_i) begin
+                axil_rvalid_o <= 1'b0;
+            end
+        end
+    end
+
+endmodule
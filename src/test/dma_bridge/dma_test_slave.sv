@@ -0,0 +1,198 @@
+// SPDX-License-Identifier: Apache-2.0
+// Pipelined AXI-Lite memory slave for the DMA bridge testbench
+//
+// Accepts up to QUEUE_DEPTH requests per channel before responding, so the
+// outstanding limits upstream are what bound the requests in flight.
+// Responses come back in order, at least LATENCY cycles after their
+// request, and none start while stall_i is set.
+//
+// Memory: MEM_WORDS words at addr[2 +: $clog2(MEM_WORDS)] (aliased).
+// Addresses with addr[19:16] == ERR_REGION answer SLVERR; writes there
+// are dropped and reads return 0xBAD0_0000 | addr[15:0].
+//
+// Counters (read hierarchically by the testbench):
+//   rd_inflight_q / wr_inflight_q   requests accepted, response not yet taken
+//   rd_inflight_max_q / wr_...      highest value seen since reset
+//   n_reads_q / n_writes_q          requests accepted since reset
+
+module dma_test_slave #(
+    parameter int unsigned ADDR_WIDTH  = 20,
+    parameter int unsigned MEM_WORDS   = 4096,
+    parameter int unsigned QUEUE_DEPTH = 16,
+    parameter int unsigned LATENCY     = 3,
+    parameter logic [3:0]  ERR_REGION  = 4'h3
+)(
+    input  logic                    clk_i,
+    input  logic                    rst_ni,
+
+    input  logic                    stall_i,     // hold back new responses
+
+    input  logic [ADDR_WIDTH-1:0]   s_axil_awaddr,
+    input  logic                    s_axil_awvalid,
+    output logic                    s_axil_awready,
+    input  logic [31:0]             s_axil_wdata,
+    input  logic [3:0]              s_axil_wstrb,
+    input  logic                    s_axil_wvalid,
+    output logic                    s_axil_wready,
+    output logic [1:0]              s_axil_bresp,
+    output logic                    s_axil_bvalid,
+    input  logic                    s_axil_bready,
+
+    input  logic [ADDR_WIDTH-1:0]   s_axil_araddr,
+    input  logic                    s_axil_arvalid,
+    output logic                    s_axil_arready,
+    output logic [31:0]             s_axil_rdata,
+    output logic [1:0]              s_axil_rresp,
+    output logic                    s_axil_rvalid,
+    input  logic                    s_axil_rready
+);
+
+    localparam int unsigned MEM_W = $clog2(MEM_WORDS);
+    localparam int unsigned Q_W   = $clog2(QUEUE_DEPTH);
+    localparam logic [1:0]  RESP_OKAY   = 2'b00;
+    localparam logic [1:0]  RESP_SLVERR = 2'b10;
+
+    logic [31:0] mem [MEM_WORDS];
+    logic [31:0] cycle_q;
+
+    function automatic logic is_err(logic [ADDR_WIDTH-1:0] addr);
+        return addr[19:16] == ERR_REGION;
+    endfunction
+
+    // =====================================================================
+    // Read channel: AR → queue → R
+    // =====================================================================
+    logic [31:0]  rq_data [QUEUE_DEPTH];
+    logic [1:0]   rq_resp [QUEUE_DEPTH];
+    logic [31:0]  rq_due  [QUEUE_DEPTH];
+    logic [Q_W:0] rq_head_q, rq_tail_q;
+    logic         rq_empty, rq_full;
+    logic         ar_fire, r_fire, r_load;
+
+    logic         r_valid_q;
+    logic [31:0]  r_data_q;
+    logic [1:0]   r_resp_q;
+
+    assign rq_empty = (rq_head_q == rq_tail_q);
+    assign rq_full  = (rq_head_q[Q_W-1:0] == rq_tail_q[Q_W-1:0]) &&
+                      (rq_head_q[Q_W] != rq_tail_q[Q_W]);
+
+    assign s_axil_arready = !rq_full;
+    assign s_axil_rvalid  = r_valid_q;
+    assign s_axil_rdata   = r_data_q;
+    assign s_axil_rresp   = r_resp_q;
+
+    assign ar_fire = s_axil_arvalid && s_axil_arready;
+    assign r_fire  = s_axil_rvalid && s_axil_rready;
+    assign r_load  = (!r_valid_q || r_fire) && !rq_empty && !stall_i &&
+                     (cycle_q >= rq_due[rq_head_q[Q_W-1:0]]);
+
+    // =====================================================================
+    // Write channel: AW+W → queue → B
+    // =====================================================================
+    logic [1:0]   wq_resp [QUEUE_DEPTH];
+    logic [31:0]  wq_due  [QUEUE_DEPTH];
+    logic [Q_W:0] wq_head_q, wq_tail_q;
+    logic         wq_empty, wq_full;
+    logic         w_fire, b_fire, b_load;
+
+    logic         b_valid_q;
+    logic [1:0]   b_resp_q;
+
+    assign wq_empty = (wq_head_q == wq_tail_q);
+    assign wq_full  = (wq_head_q[Q_W-1:0] == wq_tail_q[Q_W-1:0]) &&
+                      (wq_head_q[Q_W] != wq_tail_q[Q_W]);
+
+    // AW and W are taken together
+    assign w_fire         = s_axil_awvalid && s_axil_wvalid && !wq_full;
+    assign s_axil_awready = w_fire;
+    assign s_axil_wready  = w_fire;
+    assign s_axil_bvalid  = b_valid_q;
+    assign s_axil_bresp   = b_resp_q;
+
+    assign b_fire = s_axil_bvalid && s_axil_bready;
+    assign b_load = (!b_valid_q || b_fire) && !wq_empty && !stall_i &&
+                    (cycle_q >= wq_due[wq_head_q[Q_W-1:0]]);
+
+    // =====================================================================
+    // Counters
+    // =====================================================================
+    logic [7:0]  rd_inflight_q, rd_inflight_max_q;
+    logic [7:0]  wr_inflight_q, wr_inflight_max_q;
+    logic [31:0] n_reads_q, n_writes_q;
+
+    logic [7:0] rd_inflight_d, wr_inflight_d;
+    assign rd_inflight_d = rd_inflight_q + 8'(ar_fire) - 8'(r_fire);
+    assign wr_inflight_d = wr_inflight_q + 8'(w_fire) - 8'(b_fire);
+
+    always_ff @(posedge clk_i or negedge rst_ni) begin
+        if (!rst_ni) begin
+            cycle_q           <= '0;
+            rq_head_q         <= '0;
+            rq_tail_q         <= '0;
+            r_valid_q         <= 1'b0;
+            r_data_q          <= '0;
+            r_resp_q          <= RESP_OKAY;
+            wq_head_q         <= '0;
+            wq_tail_q         <= '0;
+            b_valid_q         <= 1'b0;
+            b_resp_q          <= RESP_OKAY;
+            rd_inflight_q     <= '0;
+            rd_inflight_max_q <= '0;
+            wr_inflight_q     <= '0;
+            wr_inflight_max_q <= '0;
+            n_reads_q         <= '0;
+            n_writes_q        <= '0;
+        end else begin
+            cycle_q <= cycle_q + 32'd1;
+
+            if (ar_fire) begin
+                rq_data[rq_tail_q[Q_W-1:0]] <= is_err(s_axil_araddr)
+                    ? (32'hBAD0_0000 | 32'(s_axil_araddr[15:0]))
+                    : mem[s_axil_araddr[2 +: MEM_W]];
+                rq_resp[rq_tail_q[Q_W-1:0]] <= is_err(s_axil_araddr) ? RESP_SLVERR : RESP_OKAY;
+                rq_due [rq_tail_q[Q_W-1:0]] <= cycle_q + 32'(LATENCY);
+                rq_tail_q <= rq_tail_q + 1'b1;
+                n_reads_q <= n_reads_q + 32'd1;
+            end
+            if (r_load) begin
+                r_valid_q <= 1'b1;
+                r_data_q  <= rq_data[rq_head_q[Q_W-1:0]];
+                r_resp_q  <= rq_resp[rq_head_q[Q_W-1:0]];
+                rq_head_q <= rq_head_q + 1'b1;
+            end else if (r_fire) begin
+                r_valid_q <= 1'b0;
+            end
+
+            if (w_fire) begin
+                if (!is_err(s_axil_awaddr)) begin
+                    for (int b = 0; b < 4; b++)
+                        if (s_axil_wstrb[b])
+                            mem[s_axil_awaddr[2 +: MEM_W]][b*8 +: 8] <= s_axil_wdata[b*8 +: 8];
+                end
+                wq_resp[wq_tail_q[Q_W-1:0]] <= is_err(s_axil_awaddr) ? RESP_SLVERR : RESP_OKAY;
+                wq_due [wq_tail_q[Q_W-1:0]] <= cycle_q + 32'(LATENCY);
+                wq_tail_q  <= wq_tail_q + 1'b1;
+                n_writes_q <= n_writes_q + 32'd1;
+            end
+            if (b_load) begin
+                b_valid_q <= 1'b1;
+                b_resp_q  <= wq_resp[wq_head_q[Q_W-1:0]];
+                wq_head_q <= wq_head_q + 1'b1;
+            end else if (b_fire) begin
+                b_valid_q <= 1'b0;
+            end
+
+            rd_inflight_q <= rd_inflight_d;
+            wr_inflight_q <= wr_inflight_d;
+            if (rd_inflight_d > rd_inflight_max_q) rd_inflight_max_q <= rd_inflight_d;
+            if (wr_inflight_d > wr_inflight_max_q) wr_inflight_max_q <= wr_inflight_d;
+        end
+    end
+
+    // Start from a known pattern so reads of unwritten words are checkable
+    initial begin
+        for (int i = 0; i < MEM_WORDS; i++) mem[i] = 32'h5A00_0000 | i;
+    end
+
+endmodule
@@ -0,0 +1,837 @@
+// SPDX-License-Identifier: Apache-2.0
+// Standalone testbench for the XDMA DMA path: loom_axi4_to_axil and
+// loom_axil_arb, wired as in loom_shell
+//
+// Architecture:
+//   AXI4 master tasks ──► loom_axi4_to_axil ──► arb port 1 ─┐
+//                                                           loom_axil_arb ──► dma_test_slave
+//   MMIO master tasks ────────────────────────► arb port 0 ─┘
+//
+// The xlnx_xdma BFM only drives the AXI-Lite BAR path, so the AXI4 side
+// is driven here by SV tasks rather than the socket BFM. The test is
+// self-checking: it prints per-test PASS/FAIL and exits through $fatal
+// on any failure.
+
+`timescale 1ns / 1ps
+
+module tb_dma_bridge;
+
+    localparam int          ADDR_WIDTH      = 20;
+    localparam int          ID_WIDTH        = 4;
+    localparam int          DATA_WIDTH      = 128;
+    localparam int          LANES           = DATA_WIDTH / 32;
+    localparam int          MAX_OUTSTANDING = 4;
+    localparam logic [63:0] WINDOW_END      = 64'h4_0000;
+    localparam int          MEM_WORDS       = 4096;
+
+    localparam logic [1:0]  RESP_OKAY   = 2'b00;
+    localparam logic [1:0]  RESP_SLVERR = 2'b10;
+    localparam logic [1:0]  RESP_DECERR = 2'b11;
+
+    typedef logic [DATA_WIDTH-1:0]   beat_t;
+    typedef logic [DATA_WIDTH/8-1:0] strb_t;
+
+    // =====================================================================
+    // Clock and Reset
+    // =====================================================================
+    logic clk;
+    logic rst_n;
+
+    initial begin
+        clk = 1'b0;
+        forever #5 clk = ~clk;  // 100 MHz
+    end
+
+    initial begin
+        rst_n = 1'b0;
+        #100;
+        rst_n = 1'b1;
+    end
+
+    // =====================================================================
+    // Watchdog
+    // =====================================================================
+    longint unsigned timeout_ns;
+
+    initial begin
+        if (!$value$plusargs("timeout=%d", timeout_ns))
+            timeout_ns = 10_000_000;  // 10ms default
+        #(timeout_ns);
+        $fatal(1, "ERROR: Watchdog timeout after %0d ns", timeout_ns);
+    end
+
+    // =====================================================================
+    // Wave dump
+    // =====================================================================
+`ifdef VERILATOR
+    initial begin
+        $dumpfile("dump.fst");
+        $dumpvars(0, tb_dma_bridge);
+    end
+`endif
+
+    // =====================================================================
+    // Wires
+    // =====================================================================
+
+    // AXI4 master (driven by the dma_* tasks)
+    logic [ID_WIDTH-1:0]   dma_awid,    dma_arid;
+    logic [63:0]           dma_awaddr,  dma_araddr;
+    logic [7:0]            dma_awlen,   dma_arlen;
+    logic                  dma_awvalid, dma_arvalid;
+    logic                  dma_awready, dma_arready;
+    beat_t                 dma_wdata;
+    strb_t                 dma_wstrb;
+    logic                  dma_wlast,   dma_wvalid,  dma_wready;
+    logic [ID_WIDTH-1:0]   dma_bid,     dma_rid;
+    logic [1:0]            dma_bresp,   dma_rresp;
+    logic                  dma_bvalid,  dma_bready;
+    beat_t                 dma_rdata;
+    logic                  dma_rlast,   dma_rvalid,  dma_rready;
+
+    // Bridge → arbiter port 1
+    logic [ADDR_WIDTH-1:0] br_araddr,  br_awaddr;
+    logic                  br_arvalid, br_awvalid;
+    logic                  br_arready, br_awready;
+    logic [31:0]           br_rdata,   br_wdata;
+    logic [1:0]            br_rresp,   br_bresp;
+    logic                  br_rvalid,  br_bvalid;
+    logic                  br_rready,  br_bready;
+    logic [3:0]            br_wstrb;
+    logic                  br_wvalid,  br_wready;
+
+    // MMIO master (driven by the mm_* tasks) → arbiter port 0
+    logic [ADDR_WIDTH-1:0] mm_araddr,  mm_awaddr;
+    logic                  mm_arvalid, mm_awvalid;
+    logic                  mm_arready, mm_awready;
+    logic [31:0]           mm_rdata,   mm_wdata;
+    logic [1:0]            mm_rresp,   mm_bresp;
+    logic                  mm_rvalid,  mm_bvalid;
+    logic                  mm_rready,  mm_bready;
+    logic [3:0]            mm_wstrb;
+    logic                  mm_wvalid,  mm_wready;
+
+    // Arbiter → slave
+    logic [ADDR_WIDTH-1:0] sl_araddr,  sl_awaddr;
+    logic                  sl_arvalid, sl_awvalid;
+    logic                  sl_arready, sl_awready;
+    logic [31:0]           sl_rdata,   sl_wdata;
+    logic [1:0]            sl_rresp,   sl_bresp;
+    logic                  sl_rvalid,  sl_bvalid;
+    logic                  sl_rready,  sl_bready;
+    logic [3:0]            sl_wstrb;
+    logic                  sl_wvalid,  sl_wready;
+
+    logic                  slave_stall;
+
+    // =====================================================================
+    // DUT: AXI4 → AXI-Lite bridge
+    // =====================================================================
+    loom_axi4_to_axil #(
+        .ID_WIDTH        (ID_WIDTH),
+        .DATA_WIDTH      (DATA_WIDTH),
+        .ADDR_WIDTH      (ADDR_WIDTH),
+        .WINDOW_END      (WINDOW_END),
+        .MAX_OUTSTANDING (MAX_OUTSTANDING)
+    ) u_bridge (
+        .clk_i  (clk),
+        .rst_ni (rst_n),
+
+        .s_axi_awid    (dma_awid),
+        .s_axi_awaddr  (dma_awaddr),
+        .s_axi_awlen   (dma_awlen),
+        .s_axi_awsize  (3'd4),
+        .s_axi_awburst (2'b01),
+        .s_axi_awlock  (1'b0),
+        .s_axi_awcache (4'b0000),
+        .s_axi_awprot  (3'b000),
+        .s_axi_awvalid (dma_awvalid),
+        .s_axi_awready (dma_awready),
+        .s_axi_wdata   (dma_wdata),
+        .s_axi_wstrb   (dma_wstrb),
+        .s_axi_wlast   (dma_wlast),
+        .s_axi_wvalid  (dma_wvalid),
+        .s_axi_wready  (dma_wready),
+        .s_axi_bid     (dma_bid),
+        .s_axi_bresp   (dma_bresp),
+        .s_axi_bvalid  (dma_bvalid),
+        .s_axi_bready  (dma_bready),
+        .s_axi_arid    (dma_arid),
+        .s_axi_araddr  (dma_araddr),
+        .s_axi_arlen   (dma_arlen),
+        .s_axi_arsize  (3'd4),
+        .s_axi_arburst (2'b01),
+        .s_axi_arlock  (1'b0),
+        .s_axi_arcache (4'b0000),
+        .s_axi_arprot  (3'b000),
+        .s_axi_arvalid (dma_arvalid),
+        .s_axi_arready (dma_arready),
+        .s_axi_rid     (dma_rid),
+        .s_axi_rdata   (dma_rdata),
+        .s_axi_rresp   (dma_rresp),
+        .s_axi_rlast   (dma_rlast),
+        .s_axi_rvalid  (dma_rvalid),
+        .s_axi_rready  (dma_rready),
+
+        .m_axil_araddr_o  (br_araddr),
+        .m_axil_arvalid_o (br_arvalid),
+        .m_axil_arready_i (br_arready),
+        .m_axil_rdata_i   (br_rdata),
+        .m_axil_rresp_i   (br_rresp),
+        .m_axil_rvalid_i  (br_rvalid),
+        .m_axil_rready_o  (br_rready),
+        .m_axil_awaddr_o  (br_awaddr),
+        .m_axil_awvalid_o (br_awvalid),
+        .m_axil_awready_i (br_awready),
+        .m_axil_wdata_o   (br_wdata),
+        .m_axil_wstrb_o   (br_wstrb),
+        .m_axil_wvalid_o  (br_wvalid),
+        .m_axil_wready_i  (br_wready),
+        .m_axil_bresp_i   (br_bresp),
+        .m_axil_bvalid_i  (br_bvalid),
+        .m_axil_bready_o  (br_bready)
+    );
+
+    // =====================================================================
+    // DUT: arbiter (port 0 = MMIO, port 1 = DMA, as in loom_shell)
+    // =====================================================================
+    loom_axil_arb #(
+        .ADDR_WIDTH      (ADDR_WIDTH),
+        .MAX_OUTSTANDING (MAX_OUTSTANDING)
+    ) u_arb (
+        .clk_i  (clk),
+        .rst_ni (rst_n),
+
+        .s_axil_araddr_i  ({br_araddr,  mm_araddr}),
+        .s_axil_arvalid_i ({br_arvalid, mm_arvalid}),
+        .s_axil_arready_o ({br_arready, mm_arready}),
+        .s_axil_rdata_o   ({br_rdata,   mm_rdata}),
+        .s_axil_rresp_o   ({br_rresp,   mm_rresp}),
+        .s_axil_rvalid_o  ({br_rvalid,  mm_rvalid}),
+        .s_axil_rready_i  ({br_rready,  mm_rready}),
+
+        .s_axil_awaddr_i  ({br_awaddr,  mm_awaddr}),
+        .s_axil_awvalid_i ({br_awvalid, mm_awvalid}),
+        .s_axil_awready_o ({br_awready, mm_awready}),
+        .s_axil_wdata_i   ({br_wdata,   mm_wdata}),
+        .s_axil_wstrb_i   ({br_wstrb,   mm_wstrb}),
+        .s_axil_wvalid_i  ({br_wvalid,  mm_wvalid}),
+        .s_axil_wready_o  ({br_wready,  mm_wready}),
+        .s_axil_bresp_o   ({br_bresp,   mm_bresp}),
+        .s_axil_bvalid_o  ({br_bvalid,  mm_bvalid}),
+        .s_axil_bready_i  ({br_bready,  mm_bready}),
+
+        .m_axil_araddr_o  (sl_araddr),
+        .m_axil_arvalid_o (sl_arvalid),
+        .m_axil_arready_i (sl_arready),
+        .m_axil_rdata_i   (sl_rdata),
+        .m_axil_rresp_i   (sl_rresp),
+        .m_axil_rvalid_i  (sl_rvalid),
+        .m_axil_rready_o  (sl_rready),
+        .m_axil_awaddr_o  (sl_awaddr),
+        .m_axil_awvalid_o (sl_awvalid),
+        .m_axil_awready_i (sl_awready),
+        .m_axil_wdata_o   (sl_wdata),
+        .m_axil_wstrb_o   (sl_wstrb),
+        .m_axil_wvalid_o  (sl_wvalid),
+        .m_axil_wready_i  (sl_wready),
+        .m_axil_bresp_i   (sl_bresp),
+        .m_axil_bvalid_i  (sl_bvalid),
+        .m_axil_bready_o  (sl_bready)
+    );
+
+    // =====================================================================
+    // Memory slave
+    // =====================================================================
+    dma_test_slave #(
+        .ADDR_WIDTH  (ADDR_WIDTH),
+        .MEM_WORDS   (MEM_WORDS),
+        .QUEUE_DEPTH (16),
+        .LATENCY     (3),
+        .ERR_REGION  (4'h3)
+    ) u_slave (
+        .clk_i   (clk),
+        .rst_ni  (rst_n),
+        .stall_i (slave_stall),
+
+        .s_axil_awaddr  (sl_awaddr),
+        .s_axil_awvalid (sl_awvalid),
+        .s_axil_awready (sl_awready),
+        .s_axil_wdata   (sl_wdata),
+        .s_axil_wstrb   (sl_wstrb),
+        .s_axil_wvalid  (sl_wvalid),
+        .s_axil_wready  (sl_wready),
+        .s_axil_bresp   (sl_bresp),
+        .s_axil_bvalid  (sl_bvalid),
+        .s_axil_bready  (sl_bready),
+
+        .s_axil_araddr  (sl_araddr),
+        .s_axil_arvalid (sl_arvalid),
+        .s_axil_arready (sl_arready),
+        .s_axil_rdata   (sl_rdata),
+        .s_axil_rresp   (sl_rresp),
+        .s_axil_rvalid  (sl_rvalid),
+        .s_axil_rready  (sl_rready)
+    );
+
+    // =====================================================================
+    // Reference model (mirrors dma_test_slave's memory)
+    // =====================================================================
+    logic [31:0] model [MEM_WORDS];
+
+    initial begin
+        for (int i = 0; i < MEM_WORDS; i++) model[i] = 32'h5A00_0000 | i;
+    end
+
+    function automatic logic in_err_region(logic [ADDR_WIDTH-1:0] addr);
+        return addr[19:16] == 4'h3;
+    endfunction
+
+    function automatic logic [31:0] expect_word(logic [ADDR_WIDTH-1:0] addr);
+        if (in_err_region(addr)) return 32'hBAD0_0000 | 32'(addr[15:0]);
+        return model[addr[2 +: $clog2(MEM_WORDS)]];
+    endfunction
+
+    function automatic logic [ADDR_WIDTH-1:0] beat_addr(logic [63:0] addr, int beat);
+        return ADDR_WIDTH'(addr & ~64'(DATA_WIDTH / 8 - 1)) + ADDR_WIDTH'(beat * DATA_WIDTH / 8);
+    endfunction
+
+    // Entries in a bridge tag FIFO (pointers carry one wrap bit)
+    function automatic int tag_count(int tail, int head);
+        return (tail - head) & (2 * MAX_OUTSTANDING - 1);
+    endfunction
+
+    function automatic beat_t rand_beat();
+        beat_t b;
+        for (int l = 0; l < LANES; l++) b[l*32 +: 32] = $urandom;
+        return b;
+    endfunction
+
+    // =====================================================================
+    // Test bookkeeping
+    // =====================================================================
+    int n_fail  = 0;
+    int n_tests = 0;
+    int test_fail_base;
+
+    task automatic test_begin(string name);
+        n_tests++;
+        test_fail_base = n_fail;
+        $display("[test %0d] %s", n_tests, name);
+    endtask
+
+    task automatic test_end();
+        if (n_fail == test_fail_base) $display("  PASS");
+    endtask
+
+    task automatic expect_eq(string what, logic [63:0] got, logic [63:0] exp);
+        if (got !== exp) begin
+            $display("  FAIL: %s = 0x%0h, expected 0x%0h", what, got, exp);
+            n_fail++;
+        end
+    endtask
+
+    // All drives happen just after a rising edge and all samples at the
+    // falling edge, so a handshake seen at a falling edge completes at the
+    // next rising edge
+    task automatic tick();
+        @(posedge clk);
+        #1;
+    endtask
+
+    // =====================================================================
+    // AXI4 master tasks
+    // =====================================================================
+    task automatic dma_ar(input logic [ID_WIDTH-1:0] id, input logic [63:0] addr,
+                          input logic [7:0] len);
+        dma_arid    = id;
+        dma_araddr  = addr;
+        dma_arlen   = len;
+        dma_arvalid = 1'b1;
+        do @(negedge clk); while (!dma_arready);
+        tick();
+        dma_arvalid = 1'b0;
+    endtask
+
+    task automatic dma_aw(input logic [ID_WIDTH-1:0] id, input logic [63:0] addr,
+                          input logic [7:0] len);
+        dma_awid    = id;
+        dma_awaddr  = addr;
+        dma_awlen   = len;
+        dma_awvalid = 1'b1;
+        do @(negedge clk); while (!dma_awready);
+        tick();
+        dma_awvalid = 1'b0;
+    endtask
+
+    task automatic dma_w(input beat_t data, input strb_t strb, input logic last);
+        dma_wdata  = data;
+        dma_wstrb  = strb;
+        dma_wlast  = last;
+        dma_wvalid = 1'b1;
+        do @(negedge clk); while (!dma_wready);
+        tick();
+        dma_wvalid = 1'b0;
+    endtask
+
+    // Collect one read burst and check RID, RLAST on the final beat only,
+    // RRESP and the data (DECERR beats carry no data)
+    task automatic dma_collect(input logic [ID_WIDTH-1:0] id, input logic [63:0] addr,
+                               input int len);
+        for (int b = 0; b <= len; b++) begin
+            logic [ADDR_WIDTH-1:0] beat;
+            logic [1:0] exp_resp;
+            beat = beat_addr(addr, b);
+            dma_rready = 1'b1;
+            do @(negedge clk); while (!dma_rvalid);
+
+            expect_eq($sformatf("beat %0d RID", b), dma_rid, id);
+            expect_eq($sformatf("beat %0d RLAST", b), dma_rlast, b == len);
+            if (addr >= WINDOW_END) begin
+                exp_resp = RESP_DECERR;
+            end else begin
+                exp_resp = RESP_OKAY;
+                for (int l = 0; l < LANES; l++) begin
+                    logic [ADDR_WIDTH-1:0] a;
+                    a = beat + ADDR_WIDTH'(4 * l);
+                    if (in_err_region(a)) exp_resp = RESP_SLVERR;
+                    expect_eq($sformatf("word 0x%05h", a), dma_rdata[l*32 +: 32], expect_word(a));
+                end
+            end
+            expect_eq($sformatf("beat %0d RRESP", b), dma_rresp, exp_resp);
+            tick();
+            dma_rready = 1'b0;
+        end
+    endtask
+
+    task automatic dma_read(input logic [ID_WIDTH-1:0] id, input logic [63:0] addr, input int len);
+        fork
+            dma_ar(id, addr, 8'(len));
+            dma_collect(id, addr, len);
+        join
+    endtask
+
+    task automatic dma_w_burst(input beat_t beats[$], input strb_t strbs[$]);
+        for (int b = 0; b < beats.size(); b++)
+            dma_w(beats[b], strbs[b], b == beats.size() - 1);
+    endtask
+
+    // Wait for the B of a write burst, check BID/BRESP and apply the burst
+    // to the model
+    task automatic dma_b(input logic [ID_WIDTH-1:0] id, input logic [63:0] addr,
+                         input beat_t beats[$], input strb_t strbs[$]);
+        logic [1:0] exp_resp;
+        exp_resp = addr >= WINDOW_END ? RESP_DECERR : RESP_OKAY;
+        for (int b = 0; b < beats.size() && addr < WINDOW_END; b++) begin
+            for (int l = 0; l < LANES; l++) begin
+                logic [ADDR_WIDTH-1:0] a;
+                a = beat_addr(addr, b) + ADDR_WIDTH'(4 * l);
+                if (strbs[b][l*4 +: 4] == 4'b0000) continue;
+                if (in_err_region(a)) begin
+                    exp_resp = RESP_SLVERR;
+                    continue;
+                end
+                for (int k = 0; k < 4; k++)
+                    if (strbs[b][l*4 + k])
+                        model[a[2 +: $clog2(MEM_WORDS)]][k*8 +: 8] = beats[b][l*32 + k*8 +: 8];
+            end
+        end
+
+        dma_bready = 1'b1;
+        do @(negedge clk); while (!dma_bvalid);
+        expect_eq("BID", dma_bid, id);
+        expect_eq("BRESP", dma_bresp, exp_resp);
+        tick();
+        dma_bready = 1'b0;
+    endtask
+
+    task automatic dma_write(input logic [ID_WIDTH-1:0] id, input logic [63:0] addr,
+                             input beat_t beats[$], input strb_t strbs[$]);
+        fork
+            dma_aw(id, addr, 8'(beats.size() - 1));
+            dma_w_burst(beats, strbs);
+        join
+        dma_b(id, addr, beats, strbs);
+    endtask
+
+    // Write `n` random full beats at `addr`
+    task automatic dma_write_rand(input logic [ID_WIDTH-1:0] id, input logic [63:0] addr, input int n);
+        beat_t beats[$];
+        strb_t strbs[$];
+        for (int b = 0; b < n; b++) begin
+            beats.push_back(rand_beat());
+            strbs.push_back({DATA_WIDTH/8{1'b1}});
+        end
+        dma_write(id, addr, beats, strbs);
+    endtask
+
+    // =====================================================================
+    // AXI-Lite (MMIO) master tasks
+    // =====================================================================
+    task automatic mm_read(input logic [ADDR_WIDTH-1:0] addr, output logic [31:0] data,
+                           output logic [1:0] resp);
+        mm_araddr  = addr;
+        mm_arvalid = 1'b1;
+        do @(negedge clk); while (!mm_arready);
+        tick();
+        mm_arvalid = 1'b0;
+        mm_rready  = 1'b1;
+        do @(negedge clk); while (!mm_rvalid);
+        data = mm_rdata;
+        resp = mm_rresp;
+        tick();
+        mm_rready = 1'b0;
+    endtask
+
+    task automatic mm_write(input logic [ADDR_WIDTH-1:0] addr, input logic [31:0] data,
+                            output logic [1:0] resp);
+        logic aw_hs, w_hs;
+        mm_awaddr  = addr;
+        mm_wdata   = data;
+        mm_wstrb   = 4'hF;
+        mm_awvalid = 1'b1;
+        mm_wvalid  = 1'b1;
+        while (mm_awvalid || mm_wvalid) begin
+            @(negedge clk);
+            aw_hs = mm_awvalid && mm_awready;
+            w_hs  = mm_wvalid && mm_wready;
+            tick();
+            if (aw_hs) mm_awvalid = 1'b0;
+            if (w_hs)  mm_wvalid  = 1'b0;
+        end
+        mm_bready = 1'b1;
+        do @(negedge clk); while (!mm_bvalid);
+        resp = mm_bresp;
+        tick();
+        mm_bready = 1'b0;
+        if (!in_err_region(addr)) model[addr[2 +: $clog2(MEM_WORDS)]] = data;
+    endtask
+
+    // =====================================================================
+    // Tests
+    // =====================================================================
+    int unsigned n_reads0, n_writes0;
+
+    task automatic snap_counts();
+        n_reads0  = u_slave.n_reads_q;
+        n_writes0 = u_slave.n_writes_q;
+    endtask
+
+    // One beat: one AXI-Lite transaction per lane each way
+    task automatic test_single_beat();
+        test_begin("single_beat");
+        snap_counts();
+        dma_write_rand(4'd1, 64'h0100, 1);
+        dma_read(4'd1, 64'h0100, 0);
+        expect_eq("AXI-Lite writes", u_slave.n_writes_q - n_writes0, LANES);
+        expect_eq("AXI-Lite reads", u_slave.n_reads_q - n_reads0, LANES);
+        test_end();
+    endtask
+
+    // Long burst, including an unaligned start (aligned down to the beat)
+    task automatic test_long_burst();
+        test_begin("long_burst");
+        dma_write_rand(4'd2, 64'h1000, 16);
+        dma_read(4'd2, 64'h1000, 15);
+        dma_read(4'd3, 64'h1008, 3);
+        test_end();
+    endtask
+
+    // Back-to-back read bursts with different IDs, issued without waiting
+    // for data; responses come back in issue order
+    task automatic test_back_to_back_reads();
+        test_begin("back_to_back_reads");
+        fork
+            for (int i = 0; i < 4; i++)
+                dma_ar(ID_WIDTH'(4 + i), 64'h1000 + 64'(i * 'h40), 8'(i));
+            for (int i = 0; i < 4; i++)
+                dma_collect(ID_WIDTH'(4 + i), 64'h1000 + 64'(i * 'h40), i);
+        join
+        test_end();
+    endtask
+
+    // Back-to-back write bursts: AWs, Ws and Bs run in separate threads
+    task automatic test_back_to_back_writes();
+        beat_t beats[3][$];
+        strb_t strbs[3][$];
+        test_begin("back_to_back_writes");
+        for (int i = 0; i < 3; i++) begin
+            for (int b = 0; b <= i + 1; b++) begin
+                beats[i].push_back(rand_beat());
+                strbs[i].push_back('1);
+            end
+        end
+        fork
+            for (int i = 0; i < 3; i++)
+                dma_aw(ID_WIDTH'(8 + i), 64'h2000 + 64'(i * 'h100), 8'(i + 1));
+            for (int i = 0; i < 3; i++)
+                dma_w_burst(beats[i], strbs[i]);
+            for (int i = 0; i < 3; i++)
+                dma_b(ID_WIDTH'(8 + i), 64'h2000 + 64'(i * 'h100), beats[i], strbs[i]);
+        join
+        for (int i = 0; i < 3; i++)
+            dma_read(4'd0, 64'h2000 + 64'(i * 'h100), i + 1);
+        test_end();
+    endtask
+
+    // With responses held back, a second burst is accepted while the first
+    // is still waiting for all of its data
+    task automatic test_outstanding_bursts();
+        test_begin("outstanding_bursts");
+        slave_stall = 1'b1;
+        dma_ar(4'd1, 64'h1000, 8'd0);
+        dma_ar(4'd2, 64'h1010, 8'd0);
+        expect_eq("AXI-Lite reads in flight", u_slave.rd_inflight_q, MAX_OUTSTANDING);
+        slave_stall = 1'b0;
+        dma_collect(4'd1, 64'h1000, 0);
+        dma_collect(4'd2, 64'h1010, 0);
+        test_end();
+    endtask
+
+    // The AXI-Lite requests in flight reach MAX_OUTSTANDING and stop there
+    task automatic test_outstanding_limit();
+        test_begin("outstanding_limit");
+        slave_stall = 1'b1;
+        fork
+            dma_read(4'd3, 64'h1000, 3);
+            begin
+                repeat (40) tick();
+                expect_eq("reads in flight", u_slave.rd_inflight_q, MAX_OUTSTANDING);
+                expect_eq("bridge read tags", tag_count(u_bridge.rt_tail_q, u_bridge.rt_head_q),
+                          MAX_OUTSTANDING);
+                slave_stall = 1'b0;
+            end
+        join
+
+        slave_stall = 1'b1;
+        fork
+            dma_write_rand(4'd4, 64'h1000, 4);
+            begin
+                repeat (40) tick();
+                expect_eq("writes in flight", u_slave.wr_inflight_q, MAX_OUTSTANDING);
+                expect_eq("bridge write tags", tag_count(u_bridge.wt_tail_q, u_bridge.wt_head_q),
+                          MAX_OUTSTANDING);
+                slave_stall = 1'b0;
+            end
+        join
+        dma_read(4'd3, 64'h1000, 3);
+        expect_eq("max reads in flight", u_slave.rd_inflight_max_q, MAX_OUTSTANDING);
+        expect_eq("max writes in flight", u_slave.wr_inflight_max_q, MAX_OUTSTANDING);
+        test_end();
+    endtask
+
+    // Byte strobes: lanes without strobes send nothing, including the
+    // burst's final lane and a whole final beat
+    task automatic test_partial_strobes();
+        beat_t beats[$];
+        strb_t strbs[$];
+        test_begin("partial_strobes");
+        for (int b = 0; b < 3; b++) beats.push_back(rand_beat());
+        strbs.push_back(16'h0F03);   // lane 0 bytes 0-1, lane 2
+        strbs.push_back(16'h00F0);   // lane 1
+        strbs.push_back(16'h0000);   // nothing
+        snap_counts();
+        dma_write(4'd5, 64'h3000, beats, strbs);
+        expect_eq("AXI-Lite writes", u_slave.n_writes_q - n_writes0, 3);
+        dma_read(4'd5, 64'h3000, 2);
+        test_end();
+    endtask
+
+    // Bursts at or past WINDOW_END get DECERR without reaching AXI-Lite
+    task automatic test_decerr();
+        test_begin("decerr");
+        snap_counts();
+        dma_read(4'd6, WINDOW_END, 1);
+        dma_write_rand(4'd6, WINDOW_END + 64'h100, 2);
+        expect_eq("AXI-Lite reads", u_slave.n_reads_q - n_reads0, 0);
+        expect_eq("AXI-Lite writes", u_slave.n_writes_q - n_writes0, 0);
+        // The error does not stick to the next burst
+        dma_read(4'd6, 64'h0100, 0);
+        dma_write_rand(4'd6, 64'h0100, 1);
+        test_end();
+    endtask
+
+    // DECERR beats use tags too: with R back-pressured the bridge stops
+    // at MAX_OUTSTANDING tags on its own, with no arbiter limit involved
+    task automatic test_decerr_backpressure();
+        test_begin("decerr_backpressure");
+        dma_ar(4'd7, WINDOW_END, 8'd7);
+        repeat (20) tick();
+        expect_eq("bridge read tags", tag_count(u_bridge.rt_tail_q, u_bridge.rt_head_q), MAX_OUTSTANDING);
+        expect_eq("burst still issuing", u_bridge.ar_busy_q, 1);
+        dma_collect(4'd7, WINDOW_END, 7);
+        test_end();
+    endtask
+
+    // SLVERR from the slave: per beat on reads, for the whole burst on
+    // writes
+    task automatic test_slave_error();
+        test_begin("slave_error");
+        dma_write_rand(4'd8, 64'h2_FFE0, 3);    // beat 2 is in the error region
+        dma_read(4'd8, 64'h2_FFE0, 2);
+        dma_write_rand(4'd8, 64'h0200, 1);
+        dma_read(4'd8, 64'h0200, 0);
+        test_end();
+    endtask
+
+    // MMIO and DMA traffic at the same time
+    task automatic test_arbitration();
+        logic [31:0] data;
+        logic [1:0]  resp;
+        test_begin("arbitration");
+        fork
+            begin
+                dma_write_rand(4'd9, 64'h3400, 8);
+                dma_read(4'd9, 64'h3400, 7);
+            end
+            begin
+                for (int i = 0; i < 16; i++) begin
+                    mm_write(ADDR_WIDTH'('h3800 + 4 * i), $urandom, resp);
+                    expect_eq("MMIO BRESP", resp, RESP_OKAY);
+                end
+                for (int i = 0; i < 16; i++) begin
+                    mm_read(ADDR_WIDTH'('h3800 + 4 * i), data, resp);
+                    expect_eq("MMIO RRESP", resp, RESP_OKAY);
+                    expect_eq($sformatf("MMIO word %0d", i), data,
+                              expect_word(ADDR_WIDTH'('h3800 + 4 * i)));
+                end
+            end
+        join
+
+        // An MMIO read waits until the DMA burst holding the grant drains
+        slave_stall = 1'b1;
+        snap_counts();
+        fork
+            dma_read(4'd10, 64'h3400, 3);
+            begin
+                repeat (10) tick();
+                fork
+                    begin
+                        mm_read(ADDR_WIDTH'('h3804), data, resp);
+                        expect_eq("MMIO RRESP", resp, RESP_OKAY);
+                        expect_eq("MMIO word", data, expect_word(ADDR_WIDTH'('h3804)));
+                    end
+                    begin
+                        repeat (20) tick();
+                        expect_eq("AXI-Lite reads while stalled", u_slave.n_reads_q - n_reads0,
+                                  MAX_OUTSTANDING);
+                        slave_stall = 1'b0;
+                    end
+                join
+            end
+        join
+        test_end();
+    endtask
+
+    // =====================================================================
+    // Main
+    // =====================================================================
+    initial begin
+        dma_awvalid = 1'b0;
+        dma_wvalid  = 1'b0;
+        dma_bready  = 1'b0;
+        dma_arvalid = 1'b0;
+        dma_rready  = 1'b0;
+        dma_awid    = '0;
+        dma_awaddr  = '0;
+        dma_awlen   = '0;
+        dma_arid    = '0;
+        dma_araddr  = '0;
+        dma_arlen   = '0;
+        dma_wdata   = '0;
+        dma_wstrb   = '0;
+        dma_wlast   = 1'b0;
+        mm_arvalid  = 1'b0;
+        mm_rready   = 1'b0;
+        mm_awvalid  = 1'b0;
+        mm_wvalid   = 1'b0;
+        mm_bready   = 1'b0;
+        mm_araddr   = '0;
+        mm_awaddr   = '0;
+        mm_wdata    = '0;
+        mm_wstrb    = '0;
+        slave_stall = 1'b0;
+
+        wait (rst_n);
+        repeat (4) tick();
+
+        test_single_beat();
+        test_long_burst();
+        test_back_to_back_reads();
+        test_back_to_back_writes();
+        test_outstanding_bursts();
+        test_outstanding_limit();
+        test_partial_strobes();
+        test_decerr();
+        test_decerr_backpressure();
+        test_slave_error();
+        test_arbitration();
+
+        $display("--- %0d tests, %0d failure(s) ---", n_tests, n_fail);
+        if (n_fail != 0) $fatal(1, "DMA bridge testbench failed");
+        $finish;
+    end
+
+    // =====================================================================
+    // SV Assertions (immediate assertions in always_ff for Verilator)
+    // =====================================================================
+
+    // A1: Outstanding limit — the slave never sees more than
+    // MAX_OUTSTANDING requests per channel without a response, and the
+    // arbiter's and bridge's own counts stay within it.
+    always_ff @(posedge clk) begin
+        if (rst_n) begin
+            assert (u_slave.rd_inflight_q <= MAX_OUTSTANDING)
+                else $error("A1: %0d reads in flight", u_slave.rd_inflight_q);
+            assert (u_slave.wr_inflight_q <= MAX_OUTSTANDING)
+                else $error("A1: %0d writes in flight", u_slave.wr_inflight_q);
+            assert (u_arb.rd_cnt_q <= MAX_OUTSTANDING)
+                else $error("A1: arbiter rd_cnt_q = %0d", u_arb.rd_cnt_q);
+            assert (u_arb.wr_cnt_q <= MAX_OUTSTANDING)
+                else $error("A1: arbiter wr_cnt_q = %0d", u_arb.wr_cnt_q);
+        end
+    end
+
+    // A2: VALID stability — once raised, the arbiter's AR/AW/W VALID and
+    // payload hold until the handshake, and the bridge's R/B VALID and
+    // payload hold until taken.
+    logic                  sl_ar_wait_q, sl_aw_wait_q, sl_w_wait_q;
+    logic [ADDR_WIDTH-1:0] sl_araddr_q,  sl_awaddr_q;
+    logic [31:0]           sl_wdata_q;
+    logic                  dma_r_wait_q, dma_b_wait_q;
+    logic [ID_WIDTH-1:0]   dma_rid_q,    dma_bid_q;
+    beat_t                 dma_rdata_q;
+
+    always_ff @(posedge clk) begin
+        sl_ar_wait_q <= rst_n && sl_arvalid && !sl_arready;
+        sl_aw_wait_q <= rst_n && sl_awvalid && !sl_awready;
+        sl_w_wait_q  <= rst_n && sl_wvalid  && !sl_wready;
+        sl_araddr_q  <= sl_araddr;
+        sl_awaddr_q  <= sl_awaddr;
+        sl_wdata_q   <= sl_wdata;
+        dma_r_wait_q <= rst_n && dma_rvalid && !dma_rready;
+        dma_b_wait_q <= rst_n && dma_bvalid && !dma_bready;
+        dma_rid_q    <= dma_rid;
+        dma_bid_q    <= dma_bid;
+        dma_rdata_q  <= dma_rdata;
+
+        if (rst_n) begin
+            if (sl_ar_wait_q)
+                assert (sl_arvalid && sl_araddr == sl_araddr_q)
+                    else $error("A2: AR changed before its handshake");
+            if (sl_aw_wait_q)
+                assert (sl_awvalid && sl_awaddr == sl_awaddr_q)
+                    else $error("A2: AW changed before its handshake");
+            if (sl_w_wait_q)
+                assert (sl_wvalid && sl_wdata == sl_wdata_q)
+                    else $error("A2: W changed before its handshake");
+            if (dma_r_wait_q)
+                assert (dma_rvalid && dma_rid == dma_rid_q && dma_rdata == dma_rdata_q)
+                    else $error("A2: AXI4 R changed before it was taken");
+            if (dma_b_wait_q)
+                assert (dma_bvalid && dma_bid == dma_bid_q)
+                    else $error("A2: AXI4 B changed before it was taken");
+        end
+    end
+
+endmodule
@@ -9,20 +9,29 @@
 //   loomc [options] <sources...>
 //   loomc -top my_dut -work build/ my_dut.sv
 //   loomc -top my_dut -f dut.f -work build/
+//
+// Builds are cached by content: the key covers every source file (and the
+// headers they `include), the Yosys script, the target options, the Yosys
+// and plugin binaries and the dispatch compiler. A hit copies the cached
+// outputs into the work directory and skips Yosys and cc altogether.
 
 #include "loom_paths.h"
 #include "loom_log.h"
 #include "sha256.h"
 #include "toml_utils.h"
+#include "loom_version.h"
 
+#include <algorithm>
 #include <cerrno>
 #include <chrono>
 #include <cstdlib>
 #include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <set>
 #include <sstream>
 #include <string>
+#include <sys/resource.h>
 #include <sys/wait.h>
 #include <unistd.h>
 #include <vector>
@@ -39,10 +48,39 @@ struct Options {
     std::string clk;          // empty = auto-detect from tbx clkgen, fallback clk_i
     std::string rst = "rst_ni";
     uint32_t freq_mhz = 50;   // target emulation clock frequency
+    uint32_t scan_chains = 1; // parallel scan chains
+    uint32_t scan_buf_words = 0;      // emu_top -scan_buf_words, 0 = pass default
+    bool scan_stream = false;         // emu_top -scan_stream
     std::vector<fs::path> sources;
     std::vector<fs::path> filelists;
     std::vector<std::string> defines;
+    std::vector<std::string> trace;   // scan_insert -trace patterns
+    uint32_t trace_depth = 0;         // 0 = emu_top default
+    std::vector<std::string> watch;   // scan_insert -watch patterns
+    bool reset_rom = false;           // emu_top -reset_rom
+    uint32_t instances = 1;           // emu_top -instances
+    bool clock_gate = false;          // loom_instrument -clock_gate
+    int cover_bits = -1;              // loom_instrument -cover_bits, -1 = pass default
+    bool cover_first = false;         // loom_instrument -cover_first
     bool verbose = false;
+    bool use_cache = true;
+    bool profile = false;             // write loom_profile.toml, implies no cache
+    fs::path cache_dir;               // empty = LOOM_CACHE_DIR / ~/.cache/loom
+};
+
+// Files restored from / stored into a cache entry. The manifest is stored
+// as emu_top wrote it; the build metadata is appended on every run.
+const char *const kCachedOutputs[] = {
+    "transformed.v",
+    "loom_dpi_dispatch.c",
+    "loom_dpi_dispatch.so",
+    "scan_map.pb",
+    "scan_map.idx",
+    "mem_map.pb",
+    "trace_map.pb",
+    "watch_map.pb",
+    "display_map.pb",
+    "loom_manifest.toml",
 };
 
 void print_usage(const char *prog) {
@@ -56,7 +94,31 @@ void print_usage(const char *prog) {
         "  -clk SIGNAL    Clock signal name (default: clk_i)\n"
         "  -rst SIGNAL    Reset signal name (default: rst_ni)\n"
         "  -freq MHZ      Target emulation clock frequency (default: 50)\n"
+        "  -scan-chains N Parallel scan chains (default: 1)\n"
+        "  -scan-buf-words N\n"
+        "                 Largest scan image kept in the scan data buffer;\n"
+        "                 longer ones are streamed (default: 1024)\n"
+        "  -scan-stream   Always stream scan images (no scan data buffer)\n"
         "  -D DEFINE      Preprocessor define (passed to slang)\n"
+        "  -trace PATTERN Record matching registers in the trace buffer\n"
+        "                 (scan map names, glob; may be repeated)\n"
+        "  -trace-depth N Trace buffer entries, a power of two (default: 1024)\n"
+        "  -watch PATTERN Route matching registers to the hardware breakpoint\n"
+        "                 comparators (scan map names, glob; may be repeated)\n"
+        "  -reset-rom     Keep the initial scan image in an on-chip ROM so reset\n"
+        "                 needs no image upload\n"
+        "  -instances N   Place N copies of the DUT, each driven as its own\n"
+        "                 board by loomx -farm (default: 1)\n"
+        "  -clock-gate    Freeze the DUT by gating its clock (BUFGCE) instead of\n"
+        "                 per-flop enables; single-clock designs without memories\n"
+        "  -cover-bits N  Hit counter width per cover property (default: 32,\n"
+        "                 0 = drop cover properties)\n"
+        "  -cover-first   Also record the cycle of each cover's first hit\n"
+        "  -cache DIR     Build cache directory (default: $LOOM_CACHE_DIR,\n"
+        "                 else $XDG_CACHE_HOME/loom or ~/.cache/loom)\n"
+        "  -no-cache      Always run Yosys and cc, don't touch the cache\n"
+        "  -profile       Record time, peak RSS and cell counts per Yosys pass\n"
+        "                 and loomc step in <work>/loom_profile.toml (no cache)\n"
         "  -v             Verbose output\n"
         "  -h             Show this help\n",
         prog);
@@ -79,8 +141,48 @@ Options parse_args(int argc, char **argv) {
             opts.rst = argv[++i];
         } else if (arg == "-freq" && i + 1 < argc) {
             opts.freq_mhz = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "-scan-chains" && i + 1 < argc) {
+            opts.scan_chains = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+            if (opts.scan_chains == 0) {
+                logger.error("-scan-chains must be at least 1");
+                std::exit(1);
+            }
+        } else if (arg == "-scan-buf-words" && i + 1 < argc) {
+            opts.scan_buf_words = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "-scan-stream") {
+            opts.scan_stream = true;
+        } else if (arg == "-trace" && i + 1 < argc) {
+            opts.trace.emplace_back(argv[++i]);
+        } else if (arg == "-trace-depth" && i + 1 < argc) {
+            opts.trace_depth = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "-watch" && i + 1 < argc) {
+            opts.watch.emplace_back(argv[++i]);
+        } else if (arg == "-reset-rom") {
+            opts.reset_rom = true;
+        } else if (arg == "-instances" && i + 1 < argc) {
+            opts.instances = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+            if (opts.instances == 0 || opts.instances > 16) {
+                logger.error("-instances must be between 1 and 16");
+                std::exit(1);
+            }
+        } else if (arg == "-clock-gate") {
+            opts.clock_gate = true;
+        } else if (arg == "-cover-bits" && i + 1 < argc) {
+            opts.cover_bits = static_cast<int>(std::strtol(argv[++i], nullptr, 10));
+            if (opts.cover_bits < 0 || opts.cover_bits > 64) {
+                logger.error("-cover-bits must be between 0 and 64");
+                std::exit(1);
+            }
+        } else if (arg == "-cover-first") {
+            opts.cover_first = true;
         } else if (arg == "-D" && i + 1 < argc) {
             opts.defines.emplace_back(argv[++i]);
+        } else if (arg == "-cache" && i + 1 < argc) {
+            opts.cache_dir = argv[++i];
+        } else if (arg == "-no-cache") {
+            opts.use_cache = false;
+        } else if (arg == "-profile") {
+            opts.profile = true;
         } else if (arg == "-v") {
             opts.verbose = true;
         } else if (arg == "-h" || arg == "--help") {
@@ -110,7 +212,9 @@ Options parse_args(int argc, char **argv) {
 
 // Run a subprocess and return its exit code.
 // If cwd is non-empty, the child process chdir's there before exec.
-int run(const std::vector<std::string> &args, const std::string &cwd = {}) {
+// If usage is non-null it receives the child's resource usage.
+int run(const std::vector<std::string> &args, const std::string &cwd = {},
+        struct rusage *usage = nullptr) {
     if (!cwd.empty())
         logger.debug("(in %s)", cwd.c_str());
     {
@@ -145,7 +249,10 @@ int run(const std::vector<std::string> &args, const std::string &cwd = {}) {
         _exit(127);
     }
     int status = 0;
-    waitpid(pid, &status, 0);
+    if (usage)
+        wait4(pid, &status, 0, usage);
+    else
+        waitpid(pid, &status, 0);
     if (WIFEXITED(status))
         return WEXITSTATUS(status);
     return 1;
@@ -185,7 +292,7 @@ std::string build_yosys_script(const Options &opts,
         ys << " -clk " << opts.clk;
     else
         ys << " -clk clk_i";
-    ys << " -map mem_map.pb\n";
+    ys << " -dirty -map mem_map.pb\n";
 
     // Flatten
     ys << "flatten\n";
@@ -206,7 +313,14 @@ std::string build_yosys_script(const Options &opts,
     // DPI instrument (creates loom_en, DPI/finish output ports).
     // From here on, DPI args/result and finish are module outputs —
     // opt_clean preserves FFs in their fan-in, removes dead ones.
-    ys << "loom_instrument -header_out loom_dpi_dispatch.c\n";
+    ys << "loom_instrument -header_out loom_dpi_dispatch.c -display_map display_map.pb";
+    if (opts.clock_gate)
+        ys << " -clock_gate";
+    if (opts.cover_bits >= 0)
+        ys << " -cover_bits " << opts.cover_bits;
+    if (opts.cover_first)
+        ys << " -cover_first";
+    ys << "\n";
 
     // Optimize: DPI/finish outputs anchor the live fan-in cone.
     // Dead FFs (unused register file entries, tied-off subsystems)
@@ -221,14 +335,38 @@ std::string build_yosys_script(const Options &opts,
     ys << "opt_clean\n";
 
     // Scan insert (after opt — only live FFs end up on the chain)
-    ys << "scan_insert -map scan_map.pb\n";
+    ys << "scan_insert -map scan_map.pb -index scan_map.idx";
+    if (opts.scan_chains > 1)
+        ys << " -chains " << opts.scan_chains;
+    if (!opts.trace.empty()) {
+        for (auto &pat : opts.trace)
+            ys << " -trace " << pat;
+        ys << " -trace_map trace_map.pb";
+    }
+    if (!opts.watch.empty()) {
+        for (auto &pat : opts.watch)
+            ys << " -watch " << pat;
+        ys << " -watch_map watch_map.pb";
+    }
+    ys << "\n";
 
 
     // Emulation top wrapper
     ys << "emu_top -top " << opts.top_module;
     if (!opts.clk.empty())
     ys << " -clk " << opts.clk;
-ys << " -rst " << opts.rst << "\n";
+ys << " -rst " << opts.rst;
+    if (opts.trace_depth)
+        ys << " -trace_depth " << opts.trace_depth;
+    if (opts.scan_buf_words)
+        ys << " -scan_buf_words " << opts.scan_buf_words;
+    if (opts.scan_stream)
+        ys << " -scan_stream";
+    if (opts.reset_rom)
+        ys << " -reset_rom";
+    if (opts.instances > 1)
+        ys << " -instances " << opts.instances;
+    ys << "\n";
 
     // Final cleanup
     ys << "opt\n";
@@ -238,10 +376,377 @@ ys << " -rst " << opts.rst << "\n";
     return ys.str();
 }
 
+// Header directories for compiling the dispatch table. Public headers
+// (svdpi.h) live in src/include, internal DPI code (loom_svdpi_array.h,
+// svdpi_openarray.c, loom_dpi_service.h) in src/dpi.
+struct DispatchDirs {
+    fs::path svdpi_include;
+    fs::path dpi_dir;
+};
+
+DispatchDirs dispatch_dirs(const loom::LoomPaths &paths) {
+    if (paths.is_build_tree)
+        return {paths.root / "src" / "include", paths.root / "src" / "dpi"};
+    return {paths.root / "include" / "loom", paths.root / "lib" / "loom" / "dpi"};
+}
+
+std::string dispatch_cc() {
+    if (const char *env_cc = std::getenv("CC"))
+        return env_cc;
+    return "cc";
+}
+
+// ============================================================================
+// Build cache
+// ============================================================================
+
+fs::path resolve_cache_dir(const Options &opts) {
+    if (!opts.cache_dir.empty())
+        return fs::absolute(opts.cache_dir);
+    if (const char *env = std::getenv("LOOM_CACHE_DIR"); env && *env)
+        return fs::absolute(env);
+    if (const char *env = std::getenv("XDG_CACHE_HOME"); env && *env)
+        return fs::path(env) / "loom";
+    if (const char *env = std::getenv("HOME"); env && *env)
+        return fs::path(env) / ".cache" / "loom";
+    return {};
+}
+
+bool read_file(const fs::path &path, std::string &out) {
+    std::ifstream f(path, std::ios::binary);
+    if (!f)
+        return false;
+    out.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// Accumulates the cache key. Sources are keyed by content, not path, so
+// the same DUT checked out in different places shares cache entries.
+class BuildKey {
+public:
+    void add(const std::string &tag, const std::string &value) {
+        text_ << tag << '=' << value << '\n';
+    }
+
+    // Content of a source file and, recursively, of the files it includes.
+    // Files that cannot be read are keyed by name only; slang reports them.
+    void add_source(const fs::path &path) {
+        std::string content;
+        if (!read_file(path, content)) {
+            add("missing", path.string());
+            return;
+        }
+        add("src", loom::sha256_hex(loom::sha256(content)));
+        if (!visited_.insert(fs::weakly_canonical(path).string()).second)
+            return;
+        add_includes(content, path.parent_path());
+    }
+
+    // Slang command file. -F (what loomc passes) resolves relative paths
+    // against the file's directory; nested -f against the Yosys CWD.
+    void add_filelist(const fs::path &path, const fs::path &cwd, int depth = 0) {
+        std::string content;
+        if (depth > 16 || !read_file(path, content)) {
+            add("missing", path.string());
+            return;
+        }
+        auto base = path.parent_path();
+        auto resolve = [](const fs::path &dir, const std::string &p) {
+            fs::path fp(p);
+            return fp.is_absolute() ? fp : dir / fp;
+        };
+
+        std::vector<std::string> tokens;
+        std::istringstream lines(content);
+        std::string line;
+        while (std::getline(lines, line)) {
+            if (auto c = line.find("//"); c != std::string::npos)
+                line.resize(c);
+            if (auto c = line.find('#'); c != std::string::npos)
+                line.resize(c);
+            std::istringstream ws(line);
+            std::string tok;
+            while (ws >> tok)
+                tokens.push_back(tok);
+        }
+
+        for (size_t i = 0; i < tokens.size(); i++) {
+            const auto &tok = tokens[i];
+            bool has_next = i + 1 < tokens.size();
+            if ((tok == "-F" || tok == "-f") && has_next) {
+                add_filelist(resolve(tok == "-F" ? base : cwd, tokens[++i]), cwd, depth + 1);
+            } else if ((tok == "-I" || tok == "--include-directory") && has_next) {
+                incdirs_.push_back(resolve(base, tokens[++i]));
+                add("incdir", tokens[i]);
+            } else if (tok.rfind("+incdir+", 0) == 0) {
+                std::istringstream dirs(tok.substr(8));
+                std::string d;
+                while (std::getline(dirs, d, '+')) {
+                    if (!d.empty())
+                        incdirs_.push_back(resolve(base, d));
+                }
+                add("incdir", tok);
+            } else if (tok[0] == '-' || tok[0] == '+') {
+                add("flag", tok);
+            } else {
+                add_source(resolve(base, tok));
+            }
+        }
+    }
+
+    std::string hex() const { return loom::sha256_hex(loom::sha256(text_.str())); }
+
+private:
+    void add_includes(const std::string &content, const fs::path &dir) {
+        static const std::string kDirective = "`include";
+        for (size_t pos = content.find(kDirective); pos != std::string::npos;
+             pos = content.find(kDirective, pos + kDirective.size())) {
+            auto open = content.find_first_of("\"<\n", pos + kDirective.size());
+            if (open == std::string::npos || content[open] == '\n')
+                continue;
+            auto close = content.find_first_of(content[open] == '"' ? "\"\n" : ">\n", open + 1);
+            if (close == std::string::npos || content[close] == '\n')
+                continue;
+            auto name = content.substr(open + 1, close - open - 1);
+            add("include", name);
+
+            std::vector<fs::path> search{dir};
+            search.insert(search.end(), incdirs_.begin(), incdirs_.end());
+            for (auto &d : search) {
+                if (fs::is_regular_file(d / name)) {
+                    add_source(d / name);
+                    break;
+                }
+            }
+        }
+    }
+
+    std::ostringstream text_;
+    std::vector<fs::path> incdirs_;
+    std::set<std::string> visited_;
+};
+
+fs::path find_in_path(const std::string &prog) {
+    if (prog.find('/') != std::string::npos)
+        return prog;
+    const char *env = std::getenv("PATH");
+    std::istringstream dirs(env ? env : "");
+    std::string d;
+    while (std::getline(dirs, d, ':')) {
+        if (!d.empty() && access((fs::path(d) / prog).c_str(), X_OK) == 0)
+            return fs::path(d) / prog;
+    }
+    return prog;
+}
+
+// Tool binaries are keyed by path, size and mtime rather than content:
+// hashing Yosys and the plugins on every run would cost more than a
+// typical cache hit saves, and any rebuild or reinstall changes the mtime.
+std::string file_stamp(const fs::path &path) {
+    std::error_code ec;
+    auto size = fs::file_size(path, ec);
+    if (ec)
+        return path.string() + ":missing";
+    auto mtime = fs::last_write_time(path, ec).time_since_epoch().count();
+    return path.string() + ":" + std::to_string(size) + ":" + std::to_string(mtime);
+}
+
+std::string compute_build_key(const Options &opts, const loom::LoomPaths &paths,
+                              const std::string &script, const fs::path &work) {
+    BuildKey key;
+    key.add("loom", std::to_string(LOOM_SHELL_VERSION));
+
+    // The read_slang line carries absolute source paths; key it by its
+    // flags here and by source content below.
+    key.add("script", script.substr(script.find('\n') + 1));
+    key.add("top", opts.top_module);
+    for (auto &d : opts.defines)
+        key.add("define", d);
+    key.add("freq_mhz", std::to_string(opts.freq_mhz));
+
+    for (auto &f : opts.filelists)
+        key.add_filelist(fs::absolute(f), work);
+    for (auto &s : opts.sources)
+        key.add_source(fs::absolute(s));
+
+    key.add("yosys", file_stamp(paths.yosys_bin));
+    for (auto &p : {paths.slang_plugin, paths.reset_extract_plugin,
+                    paths.scan_insert_plugin, paths.loom_instrument_plugin,
+                    paths.emu_top_plugin, paths.mem_shadow_plugin})
+        key.add("plugin", file_stamp(p));
+
+    // Dispatch compile: compiler plus every header/source it may pull in
+    key.add("cc", dispatch_cc());
+    key.add("cc_bin", file_stamp(find_in_path(dispatch_cc())));
+    auto dirs = dispatch_dirs(paths);
+    for (auto &dir : {paths.include_dir, dirs.svdpi_include, dirs.dpi_dir}) {
+        std::error_code ec;
+        std::vector<fs::path> files;
+        for (auto &e : fs::directory_iterator(dir, ec)) {
+            auto ext = e.path().extension();
+            if (e.is_regular_file() && (ext == ".h" || ext == ".c"))
+                files.push_back(e.path());
+        }
+        std::sort(files.begin(), files.end());
+        for (auto &f : files) {
+            std::string content;
+            read_file(f, content);
+            key.add(f.filename().string(), loom::sha256_hex(loom::sha256(content)));
+        }
+    }
+
+    return key.hex();
+}
+
+// Copy a cache entry into the work directory. Returns false (leaving the
+// work directory possibly half-updated, which the rebuild then fixes) if
+// the entry is incomplete.
+bool restore_from_cache(const fs::path &entry, const fs::path &work) {
+    std::error_code ec;
+    for (auto *name : kCachedOutputs) {
+        if (!fs::exists(entry / name))
+            continue;
+        fs::copy_file(entry / name, work / name,
+                      fs::copy_options::overwrite_existing, ec);
+        if (ec) {
+            logger.warning("Cache restore of %s failed: %s", name, ec.message().c_str());
+            return false;
+        }
+    }
+    return fs::exists(work / "transformed.v") && fs::exists(work / "loom_dpi_dispatch.so");
+}
+
+// Publish a finished build. The entry is assembled in a private staging
+// directory and renamed into place, so concurrent loomc runs never see a
+// partial entry; if another run won the race its entry is kept. Failures
+// only cost the next run a rebuild and are not fatal.
+void store_in_cache(const fs::path &entry, const fs::path &work,
+                    const std::string &manifest_base) {
+    auto staging = entry;
+    staging += ".tmp." + std::to_string(getpid());
+
+    std::error_code ec;
+    fs::create_directories(staging, ec);
+    for (auto *name : kCachedOutputs) {
+        if (ec)
+            break;
+        if (std::strcmp(name, "loom_manifest.toml") == 0) {
+            if (manifest_base.empty())
+                continue;
+            std::ofstream f(staging / name, std::ios::binary);
+            if (!(f << manifest_base))
+                ec = std::make_error_code(std::errc::io_error);
+        } else if (fs::exists(work / name)) {
+            fs::copy_file(work / name, staging / name, ec);
+        }
+    }
+    if (!ec)
+        fs::rename(staging, entry, ec);
+    if (ec) {
+        if (!fs::is_directory(entry))
+            logger.warning("Cannot store build in cache: %s", ec.message().c_str());
+        fs::remove_all(staging, ec);
+        return;
+    }
+    logger.debug("Cached build as %s", entry.c_str());
+}
+
+// ============================================================================
+// Profiling (-profile)
+// ============================================================================
+
+constexpr const char *kProfileFile = "loom_profile.toml";
+
+// Follow every script command with a loom_profile mark named after it.
+// The loom_profile pass writes one [[pass]] entry per mark.
+std::string add_profile_marks(const std::string &script) {
+    std::ostringstream out;
+    out << "loom_profile -o " << kProfileFile << " -start\n";
+    std::istringstream in(script);
+    std::string line;
+    while (std::getline(in, line)) {
+        out << line << "\n";
+        auto name = line.substr(0, line.find(' '));
+        if (!name.empty() && name[0] != '#')
+            out << "loom_profile -o " << kProfileFile << " " << name << "\n";
+    }
+    return out.str();
+}
+
+double cpu_seconds(const struct rusage &ru) {
+    return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec * 1e-6 +
+           ru.ru_stime.tv_sec + ru.ru_stime.tv_usec * 1e-6;
+}
+
+double peak_rss_mb(const struct rusage &ru) {
+#if defined(__APPLE__)
+    return ru.ru_maxrss / (1024.0 * 1024.0);  // bytes
+#else
+    return ru.ru_maxrss / 1024.0;             // KiB
+#endif
+}
+
+// One loomc step. Subprocess steps report the child's CPU time and peak
+// RSS, in-process steps loomc's own CPU time and no RSS.
+struct StepProfile {
+    std::string name;
+    double wall_s = 0;
+    double cpu_s = 0;
+    double peak_rss_mb = 0;
+};
+
+class StepTimer {
+public:
+    StepTimer() : wall_(std::chrono::steady_clock::now()) { getrusage(RUSAGE_SELF, &self_); }
+
+    StepProfile finish(const std::string &name, const struct rusage *child = nullptr) const {
+        StepProfile p;
+        p.name = name;
+        p.wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_).count();
+        if (child) {
+            p.cpu_s = cpu_seconds(*child);
+            p.peak_rss_mb = peak_rss_mb(*child);
+        } else {
+            struct rusage now;
+            getrusage(RUSAGE_SELF, &now);
+            p.cpu_s = cpu_seconds(now) - cpu_seconds(self_);
+        }
+        return p;
+    }
+
+private:
+    std::chrono::steady_clock::time_point wall_;
+    struct rusage self_;
+};
+
+// Append loomc's own steps and a summary after the per-pass entries
+void write_profile_steps(const fs::path &path, const std::vector<StepProfile> &steps,
+                         double total_wall_s) {
+    FILE *f = std::fopen(path.c_str(), "a");
+    if (!f) {
+        logger.warning("Cannot append to %s", path.c_str());
+        return;
+    }
+    for (auto &st : steps) {
+        std::fprintf(f, "[[step]]\n");
+        std::fprintf(f, "name = \"%s\"\n", st.name.c_str());
+        std::fprintf(f, "wall_s = %.3f\n", st.wall_s);
+        std::fprintf(f, "cpu_s = %.3f\n", st.cpu_s);
+        std::fprintf(f, "peak_rss_mb = %.1f\n\n", st.peak_rss_mb);
+    }
+    std::fprintf(f, "[summary]\n");
+    std::fprintf(f, "total_wall_s = %.3f\n", total_wall_s);
+    for (auto &st : steps)
+        std::fprintf(f, "%s_wall_s = %.3f\n", st.name.c_str(), st.wall_s);
+    std::fclose(f);
+}
+
 } // namespace
 
 int main(int argc, char **argv) {
     auto opts = parse_args(argc, argv);
+    StepTimer total_timer;
+    std::vector<StepProfile> steps;
 
     if (opts.verbose) {
         loom::set_log_level(loom::LogLevel::Debug);
@@ -265,6 +770,8 @@ int main(int argc, char **argv) {
 
     // Write Yosys script to work dir
     auto script = build_yosys_script(opts, paths);
+    if (opts.profile)
+        script = add_profile_marks(script);
     auto script_path = work / "run.ys";
     {
         std::ofstream f(script_path);
@@ -277,9 +784,37 @@ int main(int argc, char **argv) {
 
     logger.debug("Yosys script:\n%s", script.c_str());
 
+    // Look up the build cache
+    fs::path cache_entry;
+    std::string manifest_base;
+    bool cache_hit = false;
+    if (opts.use_cache && !opts.profile) {
+        auto cache_root = resolve_cache_dir(opts);
+        if (cache_root.empty()) {
+            logger.debug("No cache directory (set LOOM_CACHE_DIR), caching disabled");
+        } else {
+            auto key = compute_build_key(opts, paths, script, work);
+            cache_entry = cache_root / "build" / key;
+            logger.debug("Build key: %s", key.c_str());
+            if (fs::is_directory(cache_entry) && restore_from_cache(cache_entry, work)) {
+                cache_hit = true;
+                logger.info("Build cache hit (%s), skipping Yosys and cc",
+                            key.substr(0, 16).c_str());
+            }
+        }
+    }
+
+    auto transformed = work / "transformed.v";
+    auto dispatch_c = work / "loom_dpi_dispatch.c";
+    auto dispatch_so = work / "loom_dpi_dispatch.so";
+
     // Step 1: Run Yosys
-    logger.info("Running Yosys transformation...");
-    {
+    if (!cache_hit) {
+        logger.info("Running Yosys transformation...");
+        StepTimer timer;
+        struct rusage usage {};
+        if (opts.profile)
+            fs::remove(work / kProfileFile);
         auto args = std::vector<std::string>{paths.yosys_bin.string()};
         auto plugins = paths.plugin_args();
         args.insert(args.end(), plugins.begin(), plugins.end());
@@ -288,29 +823,33 @@ int main(int argc, char **argv) {
 
         // Run Yosys with CWD = work directory so relative output paths
         // (transformed.v, scan_map.pb, etc.) land in the right place.
-        int rc = run(args, work.string());
+        int rc = run(args, work.string(), &usage);
         if (rc != 0) {
             logger.error("Yosys failed (exit %d)", rc);
             return rc;
         }
-    }
+        steps.push_back(timer.finish("yosys", &usage));
 
-    // Verify outputs exist
-    auto transformed = work / "transformed.v";
-    auto dispatch_c = work / "loom_dpi_dispatch.c";
-    if (!fs::exists(transformed)) {
-        logger.error("Yosys did not produce %s", transformed.c_str());
-        return 1;
-    }
-    if (!fs::exists(dispatch_c)) {
-        logger.error("Yosys did not produce %s", dispatch_c.c_str());
-        return 1;
+        // Verify outputs exist
+        if (!fs::exists(transformed)) {
+            logger.error("Yosys did not produce %s", transformed.c_str());
+            return 1;
+        }
+        if (!fs::exists(dispatch_c)) {
+            logger.error("Yosys did not produce %s", dispatch_c.c_str());
+            return 1;
+        }
     }
 
     // Append build metadata to loom_manifest.toml (written by emu_top pass)
     {
+        StepTimer timer;
         auto manifest_path = work / "loom_manifest.toml";
         if (fs::exists(manifest_path)) {
+            // The cache stores the manifest as emu_top wrote it
+            if (!cache_hit && !cache_entry.empty())
+                read_file(manifest_path, manifest_base);
+
             // Compute SHA-256 of transformed.v
             std::ifstream tf(transformed, std::ios::binary);
             std::string tv_content((std::istreambuf_iterator<char>(tf)),
@@ -334,26 +873,18 @@ int main(int argc, char **argv) {
             loom::toml_append(manifest_path.string(), build_data);
             logger.info("  loom_manifest.toml (appended build metadata)");
         }
+        steps.push_back(timer.finish("manifest"));
     }
 
     // Step 2: Compile dispatch table into shared object
-    logger.info("Compiling dispatch shared object...");
-    auto dispatch_so = work / "loom_dpi_dispatch.so";
-    {
+    if (!cache_hit) {
+        logger.info("Compiling dispatch shared object...");
+        StepTimer timer;
+        struct rusage usage {};
+
         // Use cc (from environment or default)
-        std::string cc = "cc";
-        if (const char *env_cc = std::getenv("CC"))
-            cc = env_cc;
-
-        // Public headers (svdpi.h) in src/include, internal DPI
-        // code (loom_svdpi_array.h, svdpi_openarray.c, loom_dpi_service.h)
-        // in src/dpi.
-        auto svdpi_include = paths.root / "src" / "include";
-        auto dpi_dir = paths.root / "src" / "dpi";
-        if (!paths.is_build_tree) {
-            svdpi_include = paths.root / "include" / "loom";
-            dpi_dir = paths.root / "lib" / "loom" / "dpi";
-        }
+        auto cc = dispatch_cc();
+        auto [svdpi_include, dpi_dir] = dispatch_dirs(paths);
 
         auto args = std::vector<std::string>{
             cc,
@@ -376,19 +907,34 @@ int main(int argc, char **argv) {
             dispatch_so.string(),
         };
 
-        int rc = run(args);
+        int rc = run(args, {}, &usage);
         if (rc != 0) {
             logger.error("Dispatch compilation failed (exit %d)", rc);
             return rc;
         }
+        steps.push_back(timer.finish("dispatch_cc", &usage));
+
+        if (!cache_entry.empty())
+            store_in_cache(cache_entry, work, manifest_base);
     }
 
     logger.info("Done. Work directory: %s", work.c_str());
     logger.info("  transformed.v");
     logger.info("  loom_dpi_dispatch.so");
     logger.info("  scan_map.pb");
+    logger.info("  scan_map.idx");
     logger.info("  mem_map.pb");
+    logger.info("  display_map.pb");
+    if (!opts.trace.empty())
+        logger.info("  trace_map.pb");
+    if (!opts.watch.empty())
+        logger.info("  watch_map.pb");
     logger.info("  loom_manifest.toml");
 
+    if (opts.profile) {
+        write_profile_steps(work / kProfileFile, steps, total_timer.finish("total").wall_s);
+        logger.info("  %s", kProfileFile);
+    }
+
     return 0;
 }
@@ -0,0 +1,172 @@
+// SPDX-License-Identifier: Apache-2.0
+// loomsnap — Offline Snapshot Decoder
+//
+// Decodes snapshot files without a board, simulator or shell session.
+// Either all variables of each file, or a handful picked by name across
+// many files (one row per file), which is the common "how did this signal
+// evolve over my checkpoint ring" question.
+//
+// Usage:
+//   loomsnap build/snap.pb                        # every variable
+//   loomsnap -v counter_q -v state_q ckpt_*.pb    # selected, one row per file
+//   loomsnap -csv -v counter_q ckpt_*.pb > counter.csv
+
+#include "loom_log.h"
+#include "loom_scan_decode.h"
+#include "loom_snapshot.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+loom::Logger logger = loom::make_logger("loomsnap");
+
+struct Options {
+    std::vector<std::string> names;   // -v, exact variable names
+    std::vector<std::string> files;
+    bool csv = false;
+    bool verbose = false;
+};
+
+void print_usage(const char *prog) {
+    std::printf(
+        "Usage: %s [options] <snapshot.pb>...\n"
+        "\n"
+        "Options:\n"
+        "  -v NAME         Print only variable NAME (repeatable)\n"
+        "  -csv            Comma-separated output with a header row\n"
+        "  --verbose       Verbose output\n"
+        "  -h              Show this help\n",
+        prog);
+}
+
+Options parse_args(int argc, char **argv) {
+    Options opts;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-v" && i + 1 < argc) {
+            opts.names.push_back(argv[++i]);
+        } else if (arg == "-csv") {
+            opts.csv = true;
+        } else if (arg == "--verbose") {
+            opts.verbose = true;
+        } else if (arg == "-h" || arg == "--help") {
+            print_usage(argv[0]);
+            std::exit(0);
+        } else if (!arg.empty() && arg[0] == '-') {
+            logger.error("Unknown option: %s", arg.c_str());
+            print_usage(argv[0]);
+            std::exit(1);
+        } else {
+            opts.files.push_back(arg);
+        }
+    }
+    if (opts.files.empty()) {
+        logger.error("No snapshot files given");
+        print_usage(argv[0]);
+        std::exit(1);
+    }
+    return opts;
+}
+
+// All variables of one file, decoded in a single pass
+bool dump_all(loom::SnapshotFile& file, const Options& opts) {
+    const loom::ScanMap* map = file.has_scan_map() ? file.scan_map() : nullptr;
+    if (!map) {
+        logger.error("%s: no embedded scan map", file.path().c_str());
+        return false;
+    }
+    auto raw = file.raw_scan_data();
+    if (!raw.ok()) {
+        logger.error("%s: cannot read scan data", file.path().c_str());
+        return false;
+    }
+
+    auto scan = loom::unpack_words(raw.value());
+    loom::ScanDecoder decoder(*map);
+    std::vector<uint32_t> values;
+    decoder.decode_all(scan, values);
+
+    size_t max_name = 0;
+    for (const auto& var : map->variables())
+        max_name = std::max(max_name, var.name().size());
+
+    if (!opts.csv)
+        std::printf("%s (cycle %llu)\n", file.path().c_str(),
+                    static_cast<unsigned long long>(file.cycle_count()));
+    for (int i = 0; i < map->variables_size(); i++) {
+        const auto& var = map->variables(i);
+        std::string hex = loom::format_hex_words(decoder.value(values, i), var.width());
+        if (opts.csv)
+            std::printf("%s,%llu,%s,%u,%s\n", file.path().c_str(),
+                        static_cast<unsigned long long>(file.cycle_count()),
+                        var.name().c_str(), var.width(), hex.c_str());
+        else
+            std::printf("  %-*s [%2u] = %s\n", static_cast<int>(max_name),
+                        var.name().c_str(), var.width(), hex.c_str());
+    }
+    return true;
+}
+
+// Selected variables of one file, touching only their scan words
+bool dump_selected(loom::SnapshotFile& file, const Options& opts) {
+    auto found = file.query(opts.names);
+    if (!found.ok()) {
+        logger.error("%s: cannot read scan data", file.path().c_str());
+        return false;
+    }
+
+    std::printf("%s%s%llu", file.path().c_str(), opts.csv ? "," : "  ",
+                static_cast<unsigned long long>(file.cycle_count()));
+    for (size_t i = 0; i < opts.names.size(); i++) {
+        const auto& v = found.value()[i];
+        std::string text = v ? loom::format_hex_words(loom::unpack_words(v->bits), v->var.width())
+                             : "-";
+        if (opts.csv)
+            std::printf(",%s", text.c_str());
+        else
+            std::printf("  %s=%s", opts.names[i].c_str(), text.c_str());
+    }
+    std::printf("\n");
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    auto opts = parse_args(argc, argv);
+
+    if (opts.verbose) {
+        loom::set_log_level(loom::LogLevel::Debug);
+    }
+
+    if (opts.csv) {
+        if (opts.names.empty()) {
+            std::printf("file,cycle,name,width,value\n");
+        } else {
+            std::printf("file,cycle");
+            for (const auto& name : opts.names)
+                std::printf(",%s", name.c_str());
+            std::printf("\n");
+        }
+    }
+
+    int rc = 0;
+    for (const auto& path : opts.files) {
+        auto file = loom::SnapshotFile::open(path);
+        if (!file.ok()) {
+            logger.error("Cannot open snapshot: %s", path.c_str());
+            rc = 1;
+            continue;
+        }
+        bool ok = opts.names.empty() ? dump_all(*file.value(), opts)
+                                     : dump_selected(*file.value(), opts);
+        if (!ok)
+            rc = 1;
+    }
+    return rc;
+}
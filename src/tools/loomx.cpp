@@ -8,6 +8,9 @@
 // Usage:
 //   loomx -work build/                                  # no user DPI
 //   loomx -work build/ -sv_lib dpi -sim Vloom_shell   # with user DPI
+//   loomx -work build/ -sv_lib dpi -farm tests.txt -j 4  # 4 sims, test queue
+//   loomx -work build/ -farm tests.txt -fork-boot boot.txt  # tests from a warm state
+//   loomx decode-log -work build/ display.dlog            # render a -display-log file
 
 #include "loom_paths.h"
 
@@ -17,14 +20,24 @@
 #include "loom_shell.h"
 #include "toml_utils.h"
 
+#include <atomic>
 #include <cerrno>
+#include <chrono>
 #include <csignal>
 #include <cstdlib>
 #include <cstring>
 #include <dlfcn.h>
 #include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <pthread.h>
+#include <sched.h>
+#include <sstream>
 #include <string>
 #include <sys/wait.h>
+#include <thread>
 #include <unistd.h>
 #include <vector>
 
@@ -41,9 +54,25 @@ struct Options {
     std::string script_file;
     std::string socket_path;    // Empty = auto PID-based
     std::string timeout;        // Sim timeout in ns (empty = sim default, "-1" = infinite)
-    std::string transport = "socket";  // "socket" or "xdma"
+    std::string sim_poll;       // BFM idle poll backoff limit (empty = BFM default)
+    std::string transport = "socket";  // "socket", "shm" or "xdma"
     std::string device;         // XDMA device path (default /dev/xdma0_user)
-    std::string dpi_mode = "polling"; // "polling" or "interrupt"
+    std::string dpi_mode = "polling"; // "polling", "interrupt" or "adaptive"
+    uint32_t dpi_spin_us = loom::kDpiDefaultSpinUs;  // Adaptive spin budget
+    unsigned dpi_workers = 0;   // 0 = service DPI calls inline
+    std::vector<std::string> dpi_independent;  // Function names, or "all"
+    std::string dpi_record;     // Log every DPI call to this file
+    std::string dpi_replay;     // Complete DPI calls from this log
+    std::string display_log;    // Log $display entries raw to this file
+    std::string perf_file;      // Write host perf counters (TOML) at exit
+    std::string log_file;       // Async log + $display sink ("-" = stdout)
+    std::string restore_file;   // Snapshot to restore before the first command
+    std::string bitstream;      // XDMA: partial bitstream to load (skipped if already loaded)
+    std::string farm_file;      // Farm mode: test list (one shell script per line)
+    unsigned farm_jobs = 1;     // Farm mode: simulations to launch
+    std::vector<int> farm_cpus; // Farm mode: CPUs for the board threads
+    std::string fork_snapshot;  // Farm mode: start every test from this snapshot
+    std::string fork_boot;      // Farm mode: script whose end state is the snapshot
     bool verbose = false;
     bool no_sim = false;
     bool sim_explicit = false;  // true if user passed -sim
@@ -58,15 +87,62 @@ void print_usage(const char *prog) {
         "  -sv_lib NAME    User DPI shared library (without lib/.so)\n"
         "  -sim BINARY     Simulation binary name (default: Vloom_shell)\n"
         "  -f SCRIPT       Run commands from script file\n"
-        "  -s SOCKET       Socket path (default: auto PID-based)\n"
+        "  -s SOCKET       Socket (or shm segment) path (default: auto PID-based)\n"
         "  -timeout NS     Simulation timeout in ns (-1 for infinite)\n"
-        "  -t TRANSPORT    Transport: socket (default) or xdma\n"
-        "  -d DEVICE       XDMA device path or PCI BDF (default: /dev/xdma0_user)\n"
-        "  -dpi-mode MODE  DPI service mode: polling (default) or interrupt\n"
+        "  -sim-poll N     Idle socket poll backoff limit in sim cycles (default: 32,\n"
+        "                  0 = poll every cycle)\n"
+        "  -t TRANSPORT    Transport: socket (default), shm (shared-memory rings to\n"
+        "                  the sim) or xdma\n"
+        "  -d DEVICE       XDMA device path or PCI BDF (default: /dev/xdma0_user);\n"
+        "                  comma-separated list of boards with -farm\n"
+        "  -restore FILE.pb\n"
+        "                  Restore snapshot FILE.pb (e.g. taken on the FPGA) before\n"
+        "                  the first command, instead of the initial state\n"
+        "  -bit FILE       XDMA: stream partial bitstream FILE into the board unless its\n"
+        "                  design hash already matches FILE's .hash sidecar\n"
+        "  -dpi-mode MODE  DPI service mode: polling (default), interrupt or adaptive\n"
+        "  -dpi-spin-us N  Adaptive mode: poll N us after the last call (default: 200)\n"
+        "  -dpi-workers N  Run independent DPI calls on N worker threads\n"
+        "  -dpi-independent F[,F...]\n"
+        "                  DPI functions safe to run concurrently (or 'all')\n"
+        "  -dpi-record FILE\n"
+        "                  Log every DPI call (cycle, args, results) to FILE\n"
+        "  -dpi-replay FILE\n"
+        "                  Complete DPI calls from a -dpi-record log instead of\n"
+        "                  running them; fails at the first call that diverges\n"
+        "  -display-log FILE\n"
+        "                  Append $display output raw to FILE instead of formatting\n"
+        "                  it (render with '%s decode-log'); one file per test\n"
+        "                  with -farm (display.dlog becomes display.0.dlog, ...)\n"
+        "  -perf FILE      Write host performance counters to FILE (TOML) at exit\n"
+        "  -log FILE       Write log and $display output to FILE from a background\n"
+        "                  thread ('-' = stdout); errors still go to stderr\n"
+        "  -farm FILE      Run the shell scripts listed in FILE (one per line) on\n"
+        "                  several boards or sims, each pulling from a shared queue\n"
+        "  -j N            Farm mode: number of simulations to launch (default: 1)\n"
+        "  -farm-cpus C[,C...]\n"
+        "                  Farm mode: pin board threads to these CPUs (XDMA default:\n"
+        "                  the process CPUs in turn)\n"
+        "  -fork FILE.pb   Farm mode: start every test from snapshot FILE.pb\n"
+        "  -fork-boot SCRIPT\n"
+        "                  Farm mode: run SCRIPT once and start every test from\n"
+        "                  its end state (saved to -fork FILE, or work/farm_warm.pb)\n"
         "  --no-sim        Don't launch sim (connect to existing socket)\n"
         "  -v              Verbose output\n"
         "  -h              Show this help\n",
-        prog);
+        prog, prog);
+}
+
+std::vector<std::string> split_list(const std::string& list) {
+    std::vector<std::string> items;
+    size_t pos = 0;
+    while (pos <= list.size()) {
+        size_t comma = list.find(',', pos);
+        if (comma == std::string::npos) comma = list.size();
+        if (comma > pos) items.push_back(list.substr(pos, comma - pos));
+        pos = comma + 1;
+    }
+    return items;
 }
 
 Options parse_args(int argc, char **argv) {
@@ -87,12 +163,45 @@ Options parse_args(int argc, char **argv) {
             opts.socket_path = argv[++i];
         } else if (arg == "-timeout" && i + 1 < argc) {
             opts.timeout = argv[++i];
+        } else if (arg == "-sim-poll" && i + 1 < argc) {
+            opts.sim_poll = argv[++i];
         } else if (arg == "-t" && i + 1 < argc) {
             opts.transport = argv[++i];
         } else if (arg == "-d" && i + 1 < argc) {
             opts.device = argv[++i];
         } else if (arg == "-dpi-mode" && i + 1 < argc) {
             opts.dpi_mode = argv[++i];
+        } else if (arg == "-dpi-spin-us" && i + 1 < argc) {
+            opts.dpi_spin_us = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "-dpi-workers" && i + 1 < argc) {
+            opts.dpi_workers = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "-dpi-independent" && i + 1 < argc) {
+            opts.dpi_independent = split_list(argv[++i]);
+        } else if (arg == "-dpi-record" && i + 1 < argc) {
+            opts.dpi_record = argv[++i];
+        } else if (arg == "-dpi-replay" && i + 1 < argc) {
+            opts.dpi_replay = argv[++i];
+        } else if (arg == "-display-log" && i + 1 < argc) {
+            opts.display_log = argv[++i];
+        } else if (arg == "-restore" && i + 1 < argc) {
+            opts.restore_file = argv[++i];
+        } else if (arg == "-bit" && i + 1 < argc) {
+            opts.bitstream = argv[++i];
+        } else if (arg == "-farm" && i + 1 < argc) {
+            opts.farm_file = argv[++i];
+        } else if (arg == "-j" && i + 1 < argc) {
+            opts.farm_jobs = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "-fork" && i + 1 < argc) {
+            opts.fork_snapshot = argv[++i];
+        } else if (arg == "-fork-boot" && i + 1 < argc) {
+            opts.fork_boot = argv[++i];
+        } else if (arg == "-farm-cpus" && i + 1 < argc) {
+            for (const auto& c : split_list(argv[++i]))
+                opts.farm_cpus.push_back(static_cast<int>(std::strtol(c.c_str(), nullptr, 10)));
+        } else if (arg == "-log" && i + 1 < argc) {
+            opts.log_file = argv[++i];
+        } else if (arg == "-perf" && i + 1 < argc) {
+            opts.perf_file = argv[++i];
         } else if (arg == "--no-sim") {
             opts.no_sim = true;
         } else if (arg == "-v") {
@@ -112,16 +221,37 @@ Options parse_args(int argc, char **argv) {
         print_usage(argv[0]);
         std::exit(1);
     }
-    if (opts.transport != "socket" && opts.transport != "xdma") {
-        logger.error("Unknown transport: %s (expected 'socket' or 'xdma')",
+    if (opts.transport != "socket" && opts.transport != "shm" && opts.transport != "xdma") {
+        logger.error("Unknown transport: %s (expected 'socket', 'shm' or 'xdma')",
                      opts.transport.c_str());
         std::exit(1);
     }
-    if (opts.dpi_mode != "polling" && opts.dpi_mode != "interrupt") {
-        logger.error("Unknown DPI mode: %s (expected 'polling' or 'interrupt')",
+    if (opts.dpi_mode != "polling" && opts.dpi_mode != "interrupt" &&
+        opts.dpi_mode != "adaptive") {
+        logger.error("Unknown DPI mode: %s (expected 'polling', 'interrupt' or 'adaptive')",
                      opts.dpi_mode.c_str());
         std::exit(1);
     }
+    if (!opts.farm_file.empty() && opts.farm_jobs == 0) {
+        logger.error("-j must be at least 1");
+        std::exit(1);
+    }
+    if (!opts.farm_file.empty() && !opts.restore_file.empty()) {
+        logger.error("-restore does not apply to -farm (see -fork)");
+        std::exit(1);
+    }
+    if (opts.farm_file.empty() && (!opts.fork_snapshot.empty() || !opts.fork_boot.empty())) {
+        logger.error("-fork and -fork-boot need -farm");
+        std::exit(1);
+    }
+    if (!opts.farm_file.empty() && (!opts.dpi_record.empty() || !opts.dpi_replay.empty())) {
+        logger.error("-dpi-record and -dpi-replay do not apply to -farm");
+        std::exit(1);
+    }
+    if (!opts.dpi_record.empty() && opts.dpi_record == opts.dpi_replay) {
+        logger.error("-dpi-record and -dpi-replay name the same file");
+        std::exit(1);
+    }
     return opts;
 }
 
@@ -138,9 +268,876 @@ bool wait_for_socket(const std::string &path, int timeout_ms) {
     return false;
 }
 
+// ============================================================================
+// DPI loading (two-stage dlopen)
+// ============================================================================
+
+struct DpiLibs {
+    const loom_dpi_func_t *funcs = nullptr;
+    const int *n_funcs = nullptr;
+    void *dispatch_handle = nullptr;
+    void *user_handle = nullptr;
+};
+
+// Only loads DPI libraries if the dispatch library exists; false on error
+bool load_dpi_libs(const Options &opts, const fs::path &work, DpiLibs &libs) {
+    auto dispatch_path = work / "loom_dpi_dispatch.so";
+    if (!fs::exists(dispatch_path)) {
+        logger.info("No dispatch library found - design has no DPI calls");
+        return true;
+    }
+
+    // Stage 1: Load dispatch .so first — it provides svdpi open array
+    // functions (svGetArrayPtr etc.) that the user library may depend on.
+    logger.info("Loading dispatch library: %s", dispatch_path.c_str());
+    libs.dispatch_handle = dlopen(dispatch_path.c_str(), RTLD_LAZY | RTLD_GLOBAL);
+    if (!libs.dispatch_handle) {
+        logger.error("Failed to load dispatch library: %s", dlerror());
+        return false;
+    }
+
+    // Stage 2: Load user .so with RTLD_GLOBAL (exports user function symbols
+    // that the dispatch wrappers call via -undefined dynamic_lookup)
+    if (!opts.sv_lib.empty()) {
+        // Resolve library path (SystemVerilog -sv_lib convention):
+        //   -sv_lib foo       → try foo.so, then libfoo.so
+        //   -sv_lib dir/foo   → try dir/foo.so, then dir/libfoo.so
+        std::string user_lib;
+        fs::path sv_path(opts.sv_lib);
+        fs::path with_so = sv_path;
+        with_so += ".so";
+        fs::path with_lib = sv_path.parent_path() / ("lib" + sv_path.filename().string() + ".so");
+
+        if (fs::exists(with_so)) {
+            user_lib = fs::absolute(with_so).string();
+        } else if (fs::exists(with_lib)) {
+            user_lib = fs::absolute(with_lib).string();
+        } else {
+            // Try as a direct path
+            user_lib = opts.sv_lib;
+        }
+
+        logger.info("Loading user DPI library: %s", user_lib.c_str());
+        libs.user_handle = dlopen(user_lib.c_str(), RTLD_NOW | RTLD_GLOBAL);
+        if (!libs.user_handle) {
+            logger.error("Failed to load user library: %s", dlerror());
+            return false;
+        }
+    }
+
+    // Get function table from dispatch .so
+    libs.funcs = reinterpret_cast<const loom_dpi_func_t *>(
+        dlsym(libs.dispatch_handle, "loom_dpi_funcs"));
+    libs.n_funcs =
+        reinterpret_cast<const int *>(dlsym(libs.dispatch_handle, "loom_dpi_n_funcs"));
+
+    if (!libs.funcs || !libs.n_funcs) {
+        logger.error("Dispatch library missing loom_dpi_funcs/loom_dpi_n_funcs");
+        return false;
+    }
+
+    // Route built-in $display through the logger (older dispatch
+    // libraries have no hook and keep printing directly)
+    auto *display_hook = reinterpret_cast<loom_dpi_display_fn_t *>(
+        dlsym(libs.dispatch_handle, "loom_dpi_display_hook"));
+    if (display_hook) {
+        *display_hook = loom::log_display_v;
+    }
+
+    logger.info("Loaded %d DPI functions from dispatch table", *libs.n_funcs);
+    return true;
+}
+
+void close_dpi_libs(DpiLibs &libs) {
+    if (libs.dispatch_handle)
+        dlclose(libs.dispatch_handle);
+    if (libs.user_handle)
+        dlclose(libs.user_handle);
+    libs = {};
+}
+
+// Mode, functions and workers of a DPI service, from the command line
+void setup_dpi_service(loom::DpiService &dpi_service, const Options &opts, const DpiLibs &libs) {
+    dpi_service.set_mode(opts.dpi_mode == "interrupt" ? loom::DpiMode::Interrupt
+                         : opts.dpi_mode == "adaptive" ? loom::DpiMode::Adaptive
+                                                       : loom::DpiMode::Polling);
+    dpi_service.set_spin_budget_us(opts.dpi_spin_us);
+    if (!libs.funcs || !libs.n_funcs)
+        return;
+    dpi_service.register_funcs(libs.funcs, *libs.n_funcs);
+    for (const auto &name : opts.dpi_independent) {
+        if (name == "all")
+            dpi_service.set_all_independent();
+        else if (!dpi_service.set_independent(name))
+            logger.warning("-dpi-independent: no DPI function '%s'", name.c_str());
+    }
+    dpi_service.set_workers(opts.dpi_workers);
+}
+
+// ============================================================================
+// Manifest
+// ============================================================================
+
+struct Manifest {
+    loom::TomlData data;
+    bool present = false;
+    uint32_t freq_mhz = 0;
+};
+
+// Read before connect — we need freq_mhz for clock programming
+Manifest read_manifest(const fs::path &work) {
+    Manifest m;
+    auto manifest_path = work / "loom_manifest.toml";
+    if (!fs::exists(manifest_path))
+        return m;
+    m.data = loom::toml_read(manifest_path.string());
+    m.present = true;
+
+    // Extract clock frequency
+    auto it_clock = m.data.find("clock");
+    if (it_clock != m.data.end()) {
+        auto it_freq = it_clock->second.find("freq_mhz");
+        if (it_freq != it_clock->second.end()) {
+            m.freq_mhz = static_cast<uint32_t>(
+                std::strtoul(it_freq->second.c_str(), nullptr, 10));
+            logger.info("Target clock: %u MHz (from manifest)", m.freq_mhz);
+        }
+    }
+    return m;
+}
+
+// Verify design hash + shell version from manifest
+void check_manifest(const Manifest &manifest, const loom::Context &ctx) {
+    if (!manifest.present) {
+        logger.debug("No loom_manifest.toml found");
+        return;
+    }
+
+    // Compare design hash
+    auto it_design = manifest.data.find("design");
+    if (it_design != manifest.data.end()) {
+        auto it_hash = it_design->second.find("hash");
+        if (it_hash != it_design->second.end()) {
+            std::string manifest_hash = it_hash->second;
+            std::string hw_hash = ctx.design_hash_hex();
+            if (manifest_hash != hw_hash) {
+                logger.warning("Design hash mismatch!");
+                logger.warning("  Manifest: %s", manifest_hash.c_str());
+                logger.warning("  Hardware: %s", hw_hash.c_str());
+                logger.warning("  The hardware may have been built from a different design.");
+            }
+        }
+    }
+
+    // Compare shell version
+    auto it_shell = manifest.data.find("shell");
+    if (it_shell != manifest.data.end()) {
+        auto it_ver = it_shell->second.find("version_hex");
+        if (it_ver != it_shell->second.end()) {
+            uint32_t manifest_ver = static_cast<uint32_t>(
+                std::strtoul(it_ver->second.c_str(), nullptr, 0));
+            uint32_t hw_ver = ctx.shell_version();
+
+            uint32_t sw_major = (manifest_ver >> 16) & 0xFF;
+            uint32_t hw_major = (hw_ver >> 16) & 0xFF;
+            uint32_t sw_minor = (manifest_ver >> 8) & 0xFF;
+            uint32_t hw_minor = (hw_ver >> 8) & 0xFF;
+
+            if (sw_major != hw_major) {
+                logger.warning("Shell major version mismatch! SW=%s HW=%s",
+                               loom::version_string(manifest_ver).c_str(),
+                               loom::version_string(hw_ver).c_str());
+            } else if (hw_minor > sw_minor) {
+                logger.warning("Shell is newer than loomx (HW=%s SW=%s)",
+                               loom::version_string(hw_ver).c_str(),
+                               loom::version_string(manifest_ver).c_str());
+            }
+        }
+    }
+}
+
+// ============================================================================
+// Simulation and connection
+// ============================================================================
+
+// Fork the simulation with its socket (or shm segment) at `path` and wait
+// for it to appear. Returns the sim PID, or -1 on error.
+pid_t launch_sim(const Options &opts, const fs::path &work, const std::string &path) {
+    // Find simulation binary
+    auto sim_bin =
+        work / "sim" / "obj_dir" / opts.sim_name;
+    if (!fs::exists(sim_bin)) {
+        logger.error("Simulation binary not found: %s",
+                     sim_bin.c_str());
+        return -1;
+    }
+
+    // Clean up any stale socket
+    if (fs::exists(path)) {
+        fs::remove(path);
+    }
+
+    logger.info("Launching simulation: %s", sim_bin.c_str());
+    logger.info("Socket: %s", path.c_str());
+
+    pid_t sim_pid = fork();
+    if (sim_pid < 0) {
+        logger.error("fork: %s", strerror(errno));
+        return -1;
+    }
+    if (sim_pid == 0) {
+        // Child: exec simulation with plusargs
+        std::vector<std::string> sim_args = {
+            sim_bin, (opts.transport == "shm" ? "+shm=" : "+socket=") + path,
+            "+verilator+rand+reset+2"
+        };
+        if (!opts.timeout.empty())
+            sim_args.push_back("+timeout=" + opts.timeout);
+        if (!opts.sim_poll.empty())
+            sim_args.push_back("+loom_poll_max=" + opts.sim_poll);
+
+        std::vector<const char *> argv;
+        for (auto &a : sim_args) argv.push_back(a.c_str());
+        argv.push_back(nullptr);
+
+        execv(sim_bin.c_str(), const_cast<char *const *>(argv.data()));
+        // In child — can't use logger safely after fork
+        std::perror("execv");
+        _exit(127);
+    }
+
+    // Parent: wait for socket to appear
+    if (!wait_for_socket(path, 10000)) {
+        logger.error("Timeout waiting for simulation socket");
+        kill(sim_pid, SIGTERM);
+        waitpid(sim_pid, nullptr, 0);
+        return -1;
+    }
+    return sim_pid;
+}
+
+// Wait briefly for a clean exit, then force kill, and remove the socket.
+// Returns 128 + signal if the sim crashed on its own, 0 otherwise.
+int reap_sim(pid_t sim_pid, const std::string &path) {
+    int status = 0;
+    int crash = 0;
+    bool we_killed_it = false;
+    pid_t rc = waitpid(sim_pid, &status, WNOHANG);
+    if (rc == 0) {
+        kill(sim_pid, SIGTERM);
+        we_killed_it = true;
+        waitpid(sim_pid, &status, 0);
+    }
+    if (WIFEXITED(status)) {
+        int sim_exit = WEXITSTATUS(status);
+        if (sim_exit != 0)
+            logger.error("Simulation exited with code %d", sim_exit);
+    } else if (WIFSIGNALED(status) && !we_killed_it) {
+        // Only report signals we didn't send ourselves
+        logger.error("Simulation crashed (signal %d: %s)",
+                     WTERMSIG(status), strsignal(WTERMSIG(status)));
+        crash = 128 + WTERMSIG(status);
+    }
+    // Remove socket file
+    if (fs::exists(path)) {
+        fs::remove(path);
+    }
+    return crash;
+}
+
+std::unique_ptr<loom::Transport> make_transport(const Options &opts) {
+    if (opts.transport == "xdma")
+        return loom::create_xdma_transport();
+    if (opts.transport == "shm")
+        return loom::create_shm_transport();
+    return loom::create_socket_transport();
+}
+
+// Connect, load -bit if given and check the result against the manifest.
+// configure=false leaves the bitstream and clock alone (further instances
+// of an emu_top -instances design, set up by the first connect).
+bool connect_board(loom::Context &ctx, const std::string &target, const Options &opts,
+                   const Manifest &manifest, const DpiLibs &libs, bool configure = true) {
+    // Only program clock for XDMA transport (BFM handles it in sim)
+    const bool use_xdma = opts.transport == "xdma";
+    uint32_t connect_freq = use_xdma && configure ? manifest.freq_mhz : 0;
+
+    logger.info("Connecting to %s...", target.c_str());
+    auto rc = ctx.connect(target, connect_freq);
+    if (!rc.ok()) {
+        logger.error("Failed to connect to %s", target.c_str());
+        return false;
+    }
+
+    // Same design already loaded: reconfigure only resets it
+    if (use_xdma && configure && !opts.bitstream.empty()) {
+        loom::Context::ReconfigureOptions ropts;
+        ropts.skip_if_loaded = true;
+        if (!ctx.reconfigure(opts.bitstream, ropts).ok()) {
+            logger.error("Failed to load %s on %s", opts.bitstream.c_str(), target.c_str());
+            return false;
+        }
+    }
+
+    check_manifest(manifest, ctx);
+
+    ctx.set_completion_irq(opts.dpi_mode != "polling");
+    if (libs.funcs && libs.n_funcs) {
+        if (ctx.n_dpi_funcs() > static_cast<uint32_t>(*libs.n_funcs)) {
+            logger.warning("Design has %u DPI funcs but dispatch only has %d",
+                           ctx.n_dpi_funcs(), *libs.n_funcs);
+        }
+    } else if (ctx.n_dpi_funcs() > 0) {
+        // No DPI functions in design
+        logger.warning("Design has %u DPI funcs but no dispatch library loaded",
+                       ctx.n_dpi_funcs());
+    }
+    return true;
+}
+
+// Per-test file of a farm: perf.toml becomes perf.<t>.toml
+std::string farm_test_path(const std::string &path, size_t t) {
+    fs::path p(path);
+    fs::path name = p.stem();
+    name += "." + std::to_string(t) + p.extension().string();
+    return (p.parent_path() / name).string();
+}
+
+void write_perf_file(const std::string &path, loom::DpiService &dpi_service, loom::Context &ctx) {
+    std::ofstream perf(path);
+    if (!perf) {
+        logger.error("Cannot write %s", path.c_str());
+        return;
+    }
+    std::optional<loom::EmuPerf> emu;
+    if (ctx.has_emu_perf()) {
+        auto hw = ctx.read_emu_perf();
+        if (hw.ok()) emu = std::move(hw.value());
+    }
+    dpi_service.write_perf(perf, ctx, emu ? &*emu : nullptr);
+}
+
+// ============================================================================
+// Farm mode
+// ============================================================================
+//
+// One thread per board (XDMA device or simulation) pulls shell scripts off
+// a shared queue. The DPI libraries, manifest and scan/trace/memory maps
+// (including parsed init files) are loaded once; each board has its own
+// Context and DpiService. An XDMA board stays connected: between tests
+// emu_ctrl is reset, and designs without an initial scan image get the
+// state captured before their first test scanned back in. A simulation
+// ends with the test's $finish, so sim boards launch a fresh one per test.
+//
+// A design built with emu_top -instances N gives every XDMA device N
+// boards, one per DUT copy, sharing the device's transport (see
+// create_instance_transport); they poll instead of waiting for IRQs.
+// Simulations only drive instance 0.
+//
+// With -fork every test instead starts from one warm snapshot (typically
+// taken after an OS boot, by -fork-boot), plus the memory patches listed
+// with it. A board that stays connected only rewrites the pages dirtied
+// since it last restored the snapshot.
+
+struct FarmMaps {
+    loom::ScanMap scan;
+    loom::ScanMap trace;
+    loom::ScanMap watch;
+    loom::MemMap mem;
+    bool has_scan = false;
+    bool has_trace = false;
+    bool has_watch = false;
+    bool has_mem = false;
+};
+
+struct FarmTest {
+    fs::path script;
+    std::vector<std::pair<std::string, fs::path>> patches;  // memory, loadmem file
+    int board = -1;     // -1 = not run
+    int rc = 1;
+    double seconds = 0.0;
+};
+
+struct FarmBoard {
+    int index = 0;
+    std::string target;  // XDMA device, or socket / shm path of its sims
+    int cpu = -1;        // pinned CPU, -1 = none
+    std::shared_ptr<loom::Transport> shared;  // device transport, -instances only
+    uint32_t instance = 0;
+    std::unique_ptr<loom::Context> ctx;
+    loom::DpiService dpi;
+    pid_t sim_pid = -1;
+    std::vector<uint32_t> clean_image;
+    bool dpi_ready = false;
+    // Memories hold the warm snapshot apart from the pages dirtied since
+    // the context's dirty epoch was warm_epoch
+    bool warm_valid = false;
+    uint64_t warm_epoch = 0;
+    unsigned passed = 0;
+    unsigned failed = 0;
+};
+
+struct Farm {
+    const Options &opts;
+    const fs::path &work;
+    const DpiLibs &libs;
+    const Manifest &manifest;
+    FarmMaps maps;
+    std::unique_ptr<loom::Snapshot> warm;  // -fork: start state of every test
+    std::vector<FarmTest> tests;
+    std::atomic<size_t> next{0};
+    uint64_t sigints = 0;
+    std::mutex report_mutex;
+
+    Farm(const Options &o, const fs::path &w, const DpiLibs &l, const Manifest &m)
+        : opts(o), work(w), libs(l), manifest(m) {}
+};
+
+// Test list: one script per line, '#' comments, optionally followed by
+// <memory>=<file> patches loaded after a -fork restore. Relative paths are
+// taken from the list's directory.
+bool read_farm_list(const std::string &file, std::vector<FarmTest> &tests) {
+    std::ifstream in(file);
+    if (!in) {
+        logger.error("Cannot open farm list %s", file.c_str());
+        return false;
+    }
+    fs::path dir = fs::absolute(file).parent_path();
+    std::string line;
+    while (std::getline(in, line)) {
+        auto b = line.find_first_not_of(" \t");
+        if (b == std::string::npos || line[b] == '#') continue;
+        std::istringstream fields(line);
+        fs::path script;
+        fields >> script;
+        FarmTest test;
+        test.script = script.is_absolute() ? script : dir / script;
+        for (std::string patch; fields >> patch;) {
+            auto eq = patch.find('=');
+            if (eq == 0 || eq == std::string::npos || eq + 1 == patch.size()) {
+                logger.error("%s: expected <memory>=<file>, got '%s'", file.c_str(),
+                             patch.c_str());
+                return false;
+            }
+            fs::path data = patch.substr(eq + 1);
+            test.patches.emplace_back(patch.substr(0, eq), data.is_absolute() ? data : dir / data);
+        }
+        tests.push_back(std::move(test));
+    }
+    return true;
+}
+
+std::vector<int> allowed_cpus() {
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) return cpus;
+    for (int c = 0; c < CPU_SETSIZE; c++)
+        if (CPU_ISSET(c, &set)) cpus.push_back(c);
+    return cpus;
+}
+
+// Connect a board for the next test. Sim boards launch their simulation.
+bool farm_open(Farm &farm, FarmBoard &b) {
+    if (farm.opts.transport != "xdma") {
+        b.sim_pid = launch_sim(farm.opts, farm.work, b.target);
+        if (b.sim_pid < 0) return false;
+    }
+    b.ctx = std::make_unique<loom::Context>(
+        b.shared ? loom::create_instance_transport(b.shared, b.instance) : make_transport(farm.opts));
+    if (!connect_board(*b.ctx, b.target, farm.opts, farm.manifest, farm.libs, !b.shared))
+        return false;
+
+    if (farm.opts.transport == "xdma" && !farm.warm && b.ctx->scan_chain_length() > 0 &&
+        (!farm.maps.has_scan || farm.maps.scan.initial_scan_image().empty())) {
+        auto img = b.ctx->scan_capture_image();
+        if (img.ok()) b.clean_image = std::move(img.value());
+        else logger.warning("board %d: cannot capture its initial state", b.index);
+    }
+    return true;
+}
+
+// Disconnect after a test (sims) or at the end (XDMA). Returns the sim's
+// crash code, as for reap_sim().
+int farm_close(FarmBoard &b, int exit_code) {
+    int crash = 0;
+    if (b.ctx && b.sim_pid > 0 && b.ctx->is_connected()) {
+        b.ctx->finish(exit_code);
+        usleep(100000);  // let the sim process $finish and flush traces
+    }
+    if (b.ctx) b.ctx->disconnect();
+    b.ctx.reset();
+    b.warm_valid = false;
+    if (b.sim_pid > 0) {
+        crash = reap_sim(b.sim_pid, b.target);
+        b.sim_pid = -1;
+    }
+    return crash;
+}
+
+// DUT copies on an XDMA device; connecting as a plain board first loads
+// -bit and programs the clock for all of them. 1 if it can't be reached:
+// its board then fails on its first test like any other.
+uint32_t farm_instances(Farm &farm, const std::string &device) {
+    loom::Context ctx(make_transport(farm.opts));
+    if (!connect_board(ctx, device, farm.opts, farm.manifest, farm.libs))
+        return 1;
+    uint32_t n = ctx.n_instances();
+    ctx.disconnect();
+    if (n > 1)
+        logger.info("Farm: %s holds %u instances", device.c_str(), n);
+    return n;
+}
+
+// Board thread: run tests until the queue is empty or the board fails
+void farm_board(Farm &farm, FarmBoard &b) {
+    if (b.cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(b.cpu, &set);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+            logger.warning("board %d: cannot pin to CPU %d", b.index, b.cpu);
+    }
+    if (!b.dpi_ready) {
+        setup_dpi_service(b.dpi, farm.opts, farm.libs);
+        b.dpi_ready = true;
+    }
+    const bool reuse = farm.opts.transport == "xdma";
+
+    while (loom::Shell::interrupt_count() == farm.sigints) {
+        size_t t = farm.next.fetch_add(1);
+        if (t >= farm.tests.size()) break;
+        FarmTest &test = farm.tests[t];
+        test.board = b.index;
+        auto t0 = std::chrono::steady_clock::now();
+
+        bool ready = b.ctx != nullptr;
+        if (ready) {
+            // Clean start on a board that stays connected (-fork restores
+            // the registers anyway)
+            ready = b.ctx->reset().ok() &&
+                    (b.clean_image.empty() || b.ctx->scan_restore_image(b.clean_image).ok());
+        } else {
+            ready = farm_open(farm, b);
+        }
+
+        if (ready) {
+            b.dpi.reset_stats(*b.ctx);
+            loom::Shell shell(*b.ctx, b.dpi);
+            shell.set_save_history(false);
+            if (farm.maps.has_scan) shell.set_scan_map(farm.maps.scan);
+            if (farm.maps.has_trace) shell.set_trace_map(farm.maps.trace);
+            if (farm.maps.has_watch) shell.set_watch_map(farm.maps.watch);
+            if (farm.maps.has_mem) shell.set_mem_map(farm.maps.mem);
+            bool provisioned = true;
+            if (farm.warm) {
+                bool delta = b.warm_valid && b.ctx->mem_dirty_epoch() == b.warm_epoch;
+                provisioned = shell.restore_snapshot(*farm.warm, delta);
+                b.warm_valid = provisioned;
+                b.warm_epoch = b.ctx->mem_dirty_epoch();
+                for (const auto &[mem, file] : test.patches) {
+                    if (!provisioned) break;
+                    provisioned = shell.execute("loadmem " + mem + " " + file.string()) >= 0;
+                }
+                if (!provisioned)
+                    logger.error("board %d: cannot provision %s", b.index, test.script.c_str());
+            }
+            if (provisioned && !farm.opts.display_log.empty())
+                provisioned = b.dpi.display_log_to(farm_test_path(farm.opts.display_log, t)).ok();
+            test.rc = provisioned ? shell.run_script(test.script.string()) : 1;
+            if (b.dpi.display_logging() && !b.dpi.close_log().ok() && test.rc == 0)
+                test.rc = 1;
+            if (!farm.opts.perf_file.empty())
+                write_perf_file(farm_test_path(farm.opts.perf_file, t), b.dpi, *b.ctx);
+        }
+        if (!reuse || !ready || !b.ctx->is_connected()) {
+            int crash = farm_close(b, test.rc);
+            if (test.rc == 0 && crash) test.rc = crash;
+        }
+        test.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        {
+            std::lock_guard<std::mutex> lock(farm.report_mutex);
+            (test.rc == 0 ? b.passed : b.failed)++;
+            logger.info("board %d: %s %s (%.2f s)", b.index, test.rc == 0 ? "PASS" : "FAIL",
+                        test.script.c_str(), test.seconds);
+        }
+        if (!ready) {
+            logger.error("board %d (%s) unavailable, leaving the farm", b.index, b.target.c_str());
+            break;
+        }
+    }
+    farm_close(b, 0);
+}
+
+// -fork-boot: run the boot script on board `b` and save its end state.
+// An XDMA board is left holding it, so its first test needs no restore
+// beyond the registers.
+bool farm_boot(Farm &farm, FarmBoard &b, const std::string &snapshot_path) {
+    setup_dpi_service(b.dpi, farm.opts, farm.libs);
+    b.dpi_ready = true;
+    if (!farm_open(farm, b)) {
+        farm_close(b, 1);
+        return false;
+    }
+
+    logger.info("Farm: booting on board %d with %s", b.index, farm.opts.fork_boot.c_str());
+    bool ok;
+    {
+        loom::Shell shell(*b.ctx, b.dpi);
+        shell.set_save_history(false);
+        if (farm.maps.has_scan) shell.set_scan_map(farm.maps.scan);
+        if (farm.maps.has_trace) shell.set_trace_map(farm.maps.trace);
+        if (farm.maps.has_watch) shell.set_watch_map(farm.maps.watch);
+        if (farm.maps.has_mem) shell.set_mem_map(farm.maps.mem);
+        ok = shell.run_script(farm.opts.fork_boot) == 0;
+        if (!ok)
+            logger.error("Boot script %s failed", farm.opts.fork_boot.c_str());
+        else
+            ok = shell.execute("dump " + snapshot_path) >= 0;
+    }
+
+    // dump reads back and clears the dirty pages: the board now holds
+    // the snapshot
+    if (ok && farm.opts.transport == "xdma" && b.ctx->is_connected()) {
+        b.warm_valid = true;
+        b.warm_epoch = b.ctx->mem_dirty_epoch();
+    } else {
+        farm_close(b, ok ? 0 : 1);
+    }
+    return ok;
+}
+
+int run_farm(const Options &opts, const fs::path &work, const DpiLibs &libs,
+             const Manifest &manifest) {
+    Farm farm(opts, work, libs, manifest);
+    if (!read_farm_list(opts.farm_file, farm.tests)) return 1;
+    if (farm.tests.empty()) {
+        logger.error("Farm list %s has no tests", opts.farm_file.c_str());
+        return 1;
+    }
+
+    farm.maps.has_scan = loom::Shell::read_scan_map((work / "scan_map.pb").string(), farm.maps.scan);
+    if (fs::exists(work / "trace_map.pb"))
+        farm.maps.has_trace = loom::Shell::read_trace_map((work / "trace_map.pb").string(),
+                                                          farm.maps.trace);
+    if (fs::exists(work / "watch_map.pb"))
+        farm.maps.has_watch = loom::Shell::read_trace_map((work / "watch_map.pb").string(),
+                                                          farm.maps.watch);
+    if (fs::exists(work / "mem_map.pb"))
+        farm.maps.has_mem = loom::Shell::read_mem_map((work / "mem_map.pb").string(), farm.maps.mem);
+
+    const bool fork = !opts.fork_snapshot.empty() || !opts.fork_boot.empty();
+    if (!fork) {
+        for (const auto &test : farm.tests) {
+            if (!test.patches.empty()) {
+                logger.error("%s: memory patches need -fork or -fork-boot", test.script.c_str());
+                return 1;
+            }
+        }
+    }
+
+    // Boards: one per XDMA device, or -j simulations
+    std::vector<std::string> targets;
+    if (opts.transport == "xdma") {
+        targets = split_list(opts.device);
+    } else {
+        std::string base = opts.socket_path;
+        std::string ext = opts.transport == "shm" ? ".shm" : ".sock";
+        if (base.size() > ext.size() && base.compare(base.size() - ext.size(), ext.size(), ext) == 0)
+            base.resize(base.size() - ext.size());
+        for (unsigned i = 0; i < opts.farm_jobs; i++)
+            targets.push_back(base + "_" + std::to_string(i) + ext);
+    }
+    std::vector<int> cpus = opts.farm_cpus;
+    if (cpus.empty() && opts.transport == "xdma") cpus = allowed_cpus();
+
+    std::vector<std::unique_ptr<FarmBoard>> boards;
+    for (const auto &target : targets) {
+        uint32_t n = opts.transport == "xdma" ? farm_instances(farm, target) : 1;
+        auto shared = n > 1 ? loom::create_shared_transport(make_transport(opts)) : nullptr;
+        for (uint32_t k = 0; k < n && boards.size() < farm.tests.size(); k++) {
+            auto b = std::make_unique<FarmBoard>();
+            b->index = static_cast<int>(boards.size());
+            b->target = target;
+            b->shared = shared;
+            b->instance = k;
+            if (!cpus.empty()) b->cpu = cpus[boards.size() % cpus.size()];
+            boards.push_back(std::move(b));
+        }
+        if (boards.size() >= farm.tests.size()) break;
+    }
+
+    logger.info("Farm: %zu tests on %zu %s", farm.tests.size(), boards.size(),
+                opts.transport == "xdma" ? "boards" : "simulations");
+    farm.sigints = loom::Shell::interrupt_count();
+    auto t0 = std::chrono::steady_clock::now();
+
+    if (fork) {
+        std::string snapshot_path =
+            opts.fork_snapshot.empty() ? (work / "farm_warm.pb").string() : opts.fork_snapshot;
+        if (!opts.fork_boot.empty() && !farm_boot(farm, *boards[0], snapshot_path))
+            return 1;
+        auto snapshot = loom::read_snapshot(snapshot_path);
+        if (!snapshot.ok()) {
+            logger.error("Cannot read warm snapshot %s", snapshot_path.c_str());
+            for (auto &b : boards) farm_close(*b, 1);
+            return 1;
+        }
+        farm.warm = std::make_unique<loom::Snapshot>(std::move(snapshot.value()));
+        logger.info("Farm: every test starts from %s (time %llu)", snapshot_path.c_str(),
+                    static_cast<unsigned long long>(farm.warm->dut_time()));
+    }
+
+    std::vector<std::thread> threads;
+    for (auto &b : boards)
+        threads.emplace_back([&farm, bp = b.get()] { farm_board(farm, *bp); });
+    for (auto &t : threads) t.join();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    unsigned passed = 0, failed = 0, not_run = 0;
+    for (const auto &test : farm.tests) {
+        if (test.board < 0) not_run++;
+        else if (test.rc == 0) passed++;
+        else failed++;
+    }
+
+    std::printf("\nFarm: %zu tests, %u passed, %u failed, %u not run (%.2f s)\n",
+                farm.tests.size(), passed, failed, not_run, seconds);
+    for (const auto &test : farm.tests) {
+        if (test.board < 0) {
+            std::printf("  SKIP  %s\n", test.script.c_str());
+        } else {
+            std::printf("  %s  %s  (board %d, %.2f s%s)\n", test.rc == 0 ? "PASS" : "FAIL",
+                        test.script.c_str(), test.board, test.seconds,
+                        test.rc == 0 ? "" : (", exit " + std::to_string(test.rc)).c_str());
+        }
+    }
+    for (const auto &b : boards) {
+        std::printf("  board %d  %s: %u passed, %u failed, %llu DPI calls\n", b->index,
+                    b->target.c_str(), b->passed, b->failed,
+                    static_cast<unsigned long long>(b->dpi.call_count()));
+    }
+
+    return failed || not_run ? 1 : 0;
+}
+
+// ============================================================================
+// decode-log: render a -display-log file
+// ============================================================================
+
+void print_decode_usage(const char *prog) {
+    std::printf(
+        "Usage: %s decode-log [options] <display.dlog>\n"
+        "\n"
+        "Renders a -display-log file as the $display output of the run.\n"
+        "\n"
+        "Options:\n"
+        "  -work DIR       Work directory from loomc (reads DIR/display_map.pb)\n"
+        "  -map FILE       Display map to use instead of the work directory's\n"
+        "  -o FILE         Write the text to FILE (default: stdout)\n"
+        "  -cycles         Prefix every entry with its EMU cycle\n"
+        "  -follow         Keep reading as a running test appends to the log\n"
+        "                  (until interrupted)\n"
+        "  -h              Show this help\n",
+        prog);
+}
+
+int decode_log(int argc, char **argv) {
+    std::string map_path;
+    std::string log_path;
+    std::string out_path;
+    bool cycles = false;
+    bool follow = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-work" && i + 1 < argc) {
+            map_path = (fs::path(argv[++i]) / "display_map.pb").string();
+        } else if (arg == "-map" && i + 1 < argc) {
+            map_path = argv[++i];
+        } else if (arg == "-o" && i + 1 < argc) {
+            out_path = argv[++i];
+        } else if (arg == "-cycles") {
+            cycles = true;
+        } else if (arg == "-follow") {
+            follow = true;
+        } else if (arg == "-h" || arg == "--help") {
+            print_decode_usage("loomx");
+            return 0;
+        } else if (!arg.empty() && arg[0] == '-') {
+            logger.error("Unknown option: %s", arg.c_str());
+            print_decode_usage("loomx");
+            return 1;
+        } else if (log_path.empty()) {
+            log_path = arg;
+        } else {
+            logger.error("decode-log takes one log file");
+            return 1;
+        }
+    }
+    if (map_path.empty() || log_path.empty()) {
+        logger.error("decode-log needs -work (or -map) and a log file");
+        print_decode_usage("loomx");
+        return 1;
+    }
+
+    auto formatter = loom::DisplayFormatter::open(map_path);
+    if (!formatter.ok())
+        return 1;
+    auto reader = loom::DisplayLogReader::open(log_path);
+    if (!reader.ok())
+        return 1;
+    FILE *out = stdout;
+    if (!out_path.empty() && !(out = std::fopen(out_path.c_str(), "w"))) {
+        logger.error("Cannot write %s: %s", out_path.c_str(), std::strerror(errno));
+        return 1;
+    }
+
+    constexpr size_t kFlushBytes = 1 << 16;
+    std::string text;
+    loom::DisplayLogRecord rec;
+    uint64_t n_entries = 0, n_unknown = 0;
+    while (true) {
+        while (reader.value()->next(rec)) {
+            size_t start = text.size();
+            if (cycles)
+                loom::append_format(text, "[%llu] ", static_cast<unsigned long long>(rec.cycle));
+            if (!formatter.value()->format(rec.func_id, rec.args, text)) {
+                text.resize(start);
+                n_unknown++;
+            }
+            n_entries++;
+            if (text.size() >= kFlushBytes) {
+                std::fwrite(text.data(), 1, text.size(), out);
+                text.clear();
+            }
+        }
+        std::fwrite(text.data(), 1, text.size(), out);
+        text.clear();
+        if (!follow) break;
+        std::fflush(out);
+        usleep(loom::kDisplayFlushMs * 1000 / 2);
+    }
+
+    if (n_unknown > 0)
+        logger.warning("%llu of %llu entries have no format in %s (map from another build?)",
+                       static_cast<unsigned long long>(n_unknown),
+                       static_cast<unsigned long long>(n_entries), map_path.c_str());
+    bool ok = std::fflush(out) == 0;
+    if (out != stdout) ok = std::fclose(out) == 0 && ok;
+    if (!ok) {
+        logger.error("Cannot write %s", out_path.empty() ? "stdout" : out_path.c_str());
+        return 1;
+    }
+    return 0;
+}
+
 } // namespace
 
 int main(int argc, char **argv) {
+    if (argc > 1 && std::strcmp(argv[1], "decode-log") == 0)
+        return decode_log(argc - 1, argv + 1);
+
     auto opts = parse_args(argc, argv);
 
     // Ignore SIGPIPE — the simulation may close the socket before we
@@ -151,6 +1148,11 @@ int main(int argc, char **argv) {
         loom::set_log_level(loom::LogLevel::Debug);
     }
 
+    if (!opts.log_file.empty() && !loom::start_async_log(opts.log_file)) {
+        logger.error("Cannot write log file %s", opts.log_file.c_str());
+        return 1;
+    }
+
     auto work = fs::absolute(opts.work_dir);
     if (!fs::is_directory(work)) {
         logger.error("Work directory not found: %s", work.c_str());
@@ -169,78 +1171,39 @@ int main(int argc, char **argv) {
             opts.device = "/dev/xdma0_user";
         }
     }
-
-    // Auto socket path: PID-based for parallel safety (socket mode only)
-    if (!use_xdma && opts.socket_path.empty()) {
-        opts.socket_path =
-            "/tmp/loom_sim_" + std::to_string(getpid()) + ".sock";
+    if (!opts.farm_file.empty() && !use_xdma && opts.no_sim) {
+        logger.error("-farm needs simulations it can launch (drop --no-sim)");
+        return 1;
     }
 
-    // ========================================================================
-    // DPI loading (two-stage dlopen)
-    // ========================================================================
-
-    // Initialize to null (for designs without DPI)
-    const loom_dpi_func_t *funcs = nullptr;
-    const int *n_funcs = nullptr;
-    void *dispatch_handle = nullptr;
-    void *user_handle = nullptr;
-
-    // Only load DPI libraries if dispatch library exists
-    auto dispatch_path = work / "loom_dpi_dispatch.so";
-    if (fs::exists(dispatch_path)) {
-        // Stage 1: Load dispatch .so first — it provides svdpi open array
-        // functions (svGetArrayPtr etc.) that the user library may depend on.
-        logger.info("Loading dispatch library: %s", dispatch_path.c_str());
-        dispatch_handle = dlopen(dispatch_path.c_str(), RTLD_LAZY | RTLD_GLOBAL);
-        if (!dispatch_handle) {
-            logger.error("Failed to load dispatch library: %s", dlerror());
-            return 1;
+    // Auto socket path: PID-based for parallel safety (socket mode only).
+    // The shm segment goes to /dev/shm where it exists (tmpfs).
+    bool use_shm = (opts.transport == "shm");
+    if (!use_xdma && opts.socket_path.empty()) {
+        if (use_shm) {
+            std::string dir = fs::is_directory("/dev/shm") ? "/dev/shm" : "/tmp";
+            opts.socket_path = dir + "/loom_sim_" + std::to_string(getpid()) + ".shm";
+        } else {
+            opts.socket_path =
+                "/tmp/loom_sim_" + std::to_string(getpid()) + ".sock";
         }
+    }
 
-        // Stage 2: Load user .so with RTLD_GLOBAL (exports user function symbols
-        // that the dispatch wrappers call via -undefined dynamic_lookup)
-        if (!opts.sv_lib.empty()) {
-            // Resolve library path (SystemVerilog -sv_lib convention):
-            //   -sv_lib foo       → try foo.so, then libfoo.so
-            //   -sv_lib dir/foo   → try dir/foo.so, then dir/libfoo.so
-            std::string user_lib;
-            fs::path sv_path(opts.sv_lib);
-            fs::path with_so = sv_path;
-            with_so += ".so";
-            fs::path with_lib = sv_path.parent_path() / ("lib" + sv_path.filename().string() + ".so");
-
-            if (fs::exists(with_so)) {
-                user_lib = fs::absolute(with_so).string();
-            } else if (fs::exists(with_lib)) {
-                user_lib = fs::absolute(with_lib).string();
-            } else {
-                // Try as a direct path
-                user_lib = opts.sv_lib;
-            }
-
-            logger.info("Loading user DPI library: %s", user_lib.c_str());
-            user_handle = dlopen(user_lib.c_str(), RTLD_NOW | RTLD_GLOBAL);
-            if (!user_handle) {
-                logger.error("Failed to load user library: %s", dlerror());
-                return 1;
-            }
-        }
+    if (!opts.display_log.empty() && !fs::exists(work / "display_map.pb"))
+        logger.warning("No display_map.pb in %s: decode-log needs one (rebuild with loomc)",
+                       work.c_str());
 
-        // Get function table from dispatch .so
-        funcs = reinterpret_cast<const loom_dpi_func_t *>(
-            dlsym(dispatch_handle, "loom_dpi_funcs"));
-        n_funcs =
-            reinterpret_cast<const int *>(dlsym(dispatch_handle, "loom_dpi_n_funcs"));
+    DpiLibs libs;
+    if (!load_dpi_libs(opts, work, libs))
+        return 1;
 
-        if (!funcs || !n_funcs) {
-            logger.error("Dispatch library missing loom_dpi_funcs/loom_dpi_n_funcs");
-            return 1;
-        }
+    auto manifest = read_manifest(work);
 
-        logger.info("Loaded %d DPI functions from dispatch table", *n_funcs);
-    } else {
-        logger.info("No dispatch library found - design has no DPI calls");
+    if (!opts.farm_file.empty()) {
+        int exit_code = run_farm(opts, work, libs, manifest);
+        loom::stop_async_log();
+        close_dpi_libs(libs);
+        return exit_code;
     }
 
     // ========================================================================
@@ -249,71 +1212,17 @@ int main(int argc, char **argv) {
 
     pid_t sim_pid = -1;
     if (!opts.no_sim) {
-        // Find simulation binary
-        auto sim_bin =
-            work / "sim" / "obj_dir" / opts.sim_name;
-        if (!fs::exists(sim_bin)) {
-            logger.error("Simulation binary not found: %s",
-                         sim_bin.c_str());
-            return 1;
-        }
-
-        // Clean up any stale socket
-        if (fs::exists(opts.socket_path)) {
-            fs::remove(opts.socket_path);
-        }
-
-        logger.info("Launching simulation: %s", sim_bin.c_str());
-        logger.info("Socket: %s", opts.socket_path.c_str());
-
-        sim_pid = fork();
-        if (sim_pid < 0) {
-            logger.error("fork: %s", strerror(errno));
-            return 1;
-        }
-        if (sim_pid == 0) {
-            // Child: exec simulation with plusargs
-            std::vector<std::string> sim_args = {
-                sim_bin, "+socket=" + opts.socket_path,
-                "+verilator+rand+reset+2"
-            };
-            if (!opts.timeout.empty())
-                sim_args.push_back("+timeout=" + opts.timeout);
-
-            std::vector<const char *> argv;
-            for (auto &a : sim_args) argv.push_back(a.c_str());
-            argv.push_back(nullptr);
-
-            execv(sim_bin.c_str(), const_cast<char *const *>(argv.data()));
-            // In child — can't use logger safely after fork
-            std::perror("execv");
-            _exit(127);
-        }
-
-        // Parent: wait for socket to appear
-        if (!wait_for_socket(opts.socket_path, 10000)) {
-            logger.error("Timeout waiting for simulation socket");
-            kill(sim_pid, SIGTERM);
-            waitpid(sim_pid, nullptr, 0);
+        sim_pid = launch_sim(opts, work, opts.socket_path);
+        if (sim_pid < 0)
             return 1;
-        }
     }
 
     // ========================================================================
     // Connect and run shell
     // ========================================================================
 
-    std::unique_ptr<loom::Transport> transport;
-    std::string connect_target;
-
-    if (use_xdma) {
-        transport = loom::create_xdma_transport();
-        connect_target = opts.device;
-    } else {
-        transport = loom::create_socket_transport();
-        connect_target = opts.socket_path;
-    }
-
+    std::string connect_target = use_xdma ? opts.device : opts.socket_path;
+    auto transport = make_transport(opts);
     if (!transport) {
         logger.error("Failed to create transport");
         if (sim_pid > 0) {
@@ -325,34 +1234,7 @@ int main(int argc, char **argv) {
 
     loom::Context ctx(std::move(transport));
 
-    // Read manifest before connect — we need freq_mhz for clock programming
-    uint32_t freq_mhz = 0;
-    auto manifest_path = work / "loom_manifest.toml";
-    loom::TomlData manifest;
-    bool have_manifest = false;
-    if (fs::exists(manifest_path)) {
-        manifest = loom::toml_read(manifest_path.string());
-        have_manifest = true;
-
-        // Extract clock frequency
-        auto it_clock = manifest.find("clock");
-        if (it_clock != manifest.end()) {
-            auto it_freq = it_clock->second.find("freq_mhz");
-            if (it_freq != it_clock->second.end()) {
-                freq_mhz = static_cast<uint32_t>(
-                    std::strtoul(it_freq->second.c_str(), nullptr, 10));
-                logger.info("Target clock: %u MHz (from manifest)", freq_mhz);
-            }
-        }
-    }
-
-    // Only program clock for XDMA transport (BFM handles it in sim)
-    uint32_t connect_freq = use_xdma ? freq_mhz : 0;
-
-    logger.info("Connecting to %s...", connect_target.c_str());
-    auto rc = ctx.connect(connect_target, connect_freq);
-    if (!rc.ok()) {
-        logger.error("Failed to connect to %s", connect_target.c_str());
+    if (!connect_board(ctx, connect_target, opts, manifest, libs)) {
         if (sim_pid > 0) {
             kill(sim_pid, SIGTERM);
             waitpid(sim_pid, nullptr, 0);
@@ -360,72 +1242,17 @@ int main(int argc, char **argv) {
         return 1;
     }
 
-    // Verify design hash + shell version from manifest
-    {
-        if (have_manifest) {
-
-            // Compare design hash
-            auto it_design = manifest.find("design");
-            if (it_design != manifest.end()) {
-                auto it_hash = it_design->second.find("hash");
-                if (it_hash != it_design->second.end()) {
-                    std::string manifest_hash = it_hash->second;
-                    std::string hw_hash = ctx.design_hash_hex();
-                    if (manifest_hash != hw_hash) {
-                        logger.warning("Design hash mismatch!");
-                        logger.warning("  Manifest: %s", manifest_hash.c_str());
-                        logger.warning("  Hardware: %s", hw_hash.c_str());
-                        logger.warning("  The hardware may have been built from a different design.");
-                    }
-                }
-            }
-
-            // Compare shell version
-            auto it_shell = manifest.find("shell");
-            if (it_shell != manifest.end()) {
-                auto it_ver = it_shell->second.find("version_hex");
-                if (it_ver != it_shell->second.end()) {
-                    uint32_t manifest_ver = static_cast<uint32_t>(
-                        std::strtoul(it_ver->second.c_str(), nullptr, 0));
-                    uint32_t hw_ver = ctx.shell_version();
-
-                    uint32_t sw_major = (manifest_ver >> 16) & 0xFF;
-                    uint32_t hw_major = (hw_ver >> 16) & 0xFF;
-                    uint32_t sw_minor = (manifest_ver >> 8) & 0xFF;
-                    uint32_t hw_minor = (hw_ver >> 8) & 0xFF;
-
-                    if (sw_major != hw_major) {
-                        logger.warning("Shell major version mismatch! SW=%s HW=%s",
-                                       loom::version_string(manifest_ver).c_str(),
-                                       loom::version_string(hw_ver).c_str());
-                    } else if (hw_minor > sw_minor) {
-                        logger.warning("Shell is newer than loomx (HW=%s SW=%s)",
-                                       loom::version_string(hw_ver).c_str(),
-                                       loom::version_string(manifest_ver).c_str());
-                    }
-                }
-            }
-        } else {
-            logger.debug("No loom_manifest.toml found");
-        }
-    }
-
     // Configure DPI service
     auto &dpi_service = loom::global_dpi_service();
-    dpi_service.set_mode(opts.dpi_mode == "interrupt" ? loom::DpiMode::Interrupt
-                                                      : loom::DpiMode::Polling);
-    if (funcs && n_funcs) {
-        if (ctx.n_dpi_funcs() > static_cast<uint32_t>(*n_funcs)) {
-            logger.warning("Design has %u DPI funcs but dispatch only has %d",
-                           ctx.n_dpi_funcs(), *n_funcs);
-        }
-        dpi_service.register_funcs(funcs, *n_funcs);
-    } else {
-        // No DPI functions in design
-        if (ctx.n_dpi_funcs() > 0) {
-            logger.warning("Design has %u DPI funcs but no dispatch library loaded",
-                           ctx.n_dpi_funcs());
+    setup_dpi_service(dpi_service, opts, libs);
+    if ((!opts.dpi_replay.empty() && !dpi_service.replay_from(opts.dpi_replay).ok()) ||
+        (!opts.dpi_record.empty() && !dpi_service.record_to(opts.dpi_record).ok()) ||
+        (!opts.display_log.empty() && !dpi_service.display_log_to(opts.display_log).ok())) {
+        if (sim_pid > 0) {
+            kill(sim_pid, SIGTERM);
+            waitpid(sim_pid, nullptr, 0);
         }
+        return 1;
     }
 
     // Run shell
@@ -435,13 +1262,28 @@ int main(int argc, char **argv) {
     auto scan_map_path = work / "scan_map.pb";
     shell.load_scan_map(scan_map_path.string());
 
+    // Load trace map for the hardware trace buffer (loomc -trace)
+    auto trace_map_path = work / "trace_map.pb";
+    if (fs::exists(trace_map_path))
+        shell.load_trace_map(trace_map_path.string());
+
+    // ... and the watch map for hardware breakpoints (loomc -watch)
+    auto watch_map_path = work / "watch_map.pb";
+    if (fs::exists(watch_map_path))
+        shell.load_watch_map(watch_map_path.string());
+
     // Load memory map for memory preload/dump
     auto mem_map_path = work / "mem_map.pb";
     if (fs::exists(mem_map_path))
         shell.load_mem_map(mem_map_path.string());
 
     int exit_code;
-    if (!opts.script_file.empty()) {
+    loom::Snapshot snapshot;
+    if (!opts.restore_file.empty() &&
+        !(shell.load_snapshot(opts.restore_file, snapshot) && shell.restore_snapshot(snapshot))) {
+        logger.error("Cannot restore %s", opts.restore_file.c_str());
+        exit_code = 1;
+    } else if (!opts.script_file.empty()) {
         exit_code = shell.run_script(opts.script_file);
     } else {
         exit_code = shell.run_interactive();
@@ -468,6 +1310,13 @@ int main(int argc, char **argv) {
                     static_cast<unsigned long long>(cycle_result.value()));
     }
     dpi_service.print_stats();
+    if (!dpi_service.close_log().ok() && exit_code == 0)
+        exit_code = 1;
+    // A replay that diverged did not reproduce the recorded run
+    if (dpi_service.divergence_cycle() && exit_code == 0)
+        exit_code = 1;
+    if (!opts.perf_file.empty())
+        write_perf_file(opts.perf_file, dpi_service, ctx);
 
     // Tell simulation to finish cleanly (allows trace flush)
     if (sim_pid > 0 && ctx.is_connected()) {
@@ -481,36 +1330,15 @@ int main(int argc, char **argv) {
 
     // Clean up simulation process
     if (sim_pid > 0) {
-        // Wait briefly for clean exit, then force kill
-        int status;
-        bool we_killed_it = false;
-        pid_t rc = waitpid(sim_pid, &status, WNOHANG);
-        if (rc == 0) {
-            kill(sim_pid, SIGTERM);
-            we_killed_it = true;
-            waitpid(sim_pid, &status, 0);
-        }
-        if (WIFEXITED(status)) {
-            int sim_exit = WEXITSTATUS(status);
-            if (sim_exit != 0)
-                logger.error("Simulation exited with code %d", sim_exit);
-        } else if (WIFSIGNALED(status) && !we_killed_it) {
-            // Only report signals we didn't send ourselves
-            logger.error("Simulation crashed (signal %d: %s)",
-                         WTERMSIG(status), strsignal(WTERMSIG(status)));
-            if (exit_code == 0) exit_code = 128 + WTERMSIG(status);
-        }
-        // Remove socket file
-        if (fs::exists(opts.socket_path)) {
-            fs::remove(opts.socket_path);
-        }
+        int crash = reap_sim(sim_pid, opts.socket_path);
+        if (exit_code == 0 && crash) exit_code = crash;
     }
 
+    // Drain the async log while the DPI libraries are still mapped
+    loom::stop_async_log();
+
     // Close dlopen handles
-    if (dispatch_handle)
-        dlclose(dispatch_handle);
-    if (user_handle)
-        dlclose(user_handle);
+    close_dpi_libs(libs);
 
     // SIGPIPE (exit 141) is expected when sim terminates before host
     if (exit_code == 141)
@@ -3,14 +3,34 @@
 //
 // A lightweight, header-only logging system with log levels and component prefixes.
 // Thread-safe output with optional color support.
+//
+// By default each message is formatted and written under a global mutex.
+// start_async_log() hands output to a background writer instead: every
+// thread formats into its own SPSC ring (no lock, no syscall) and the
+// writer drains all rings into one buffered FILE. log_display() routes
+// $display / vpi_printf text into the same sink. Building with
+// LOOM_LOG_MIN_LEVEL=1 compiles debug() calls out entirely.
 
 #pragma once
 
+#include "loom_ring.h"
+
+#include <atomic>
+#include <chrono>
 #include <cstdio>
 #include <cstdarg>
 #include <cstdint>
+#include <cstring>
+#include <memory>
 #include <string>
 #include <mutex>
+#include <thread>
+#include <vector>
+
+// Calls below this level compile to nothing (0 = Debug, 1 = Info, ...)
+#ifndef LOOM_LOG_MIN_LEVEL
+#define LOOM_LOG_MIN_LEVEL 0
+#endif
 
 namespace loom {
 
@@ -43,8 +63,8 @@ public:
         return config;
     }
 
-    void set_level(LogLevel level) { level_ = level; }
-    LogLevel level() const { return level_; }
+    void set_level(LogLevel level) { level_.store(level, std::memory_order_relaxed); }
+    LogLevel level() const { return level_.load(std::memory_order_relaxed); }
 
     void set_color_enabled(bool enabled) { color_enabled_ = enabled; }
     bool color_enabled() const { return color_enabled_; }
@@ -53,11 +73,212 @@ public:
 
 private:
     LogConfig() : level_(LogLevel::Info), color_enabled_(true) {}
-    LogLevel level_;
+    std::atomic<LogLevel> level_;
     bool color_enabled_;
     std::mutex mutex_;
 };
 
+// Append printf-style output to `buf`
+inline void append_vformat(std::string& buf, const char* fmt, va_list args) {
+    constexpr size_t kGuess = 256;
+    va_list retry;
+    va_copy(retry, args);
+    size_t old = buf.size();
+    buf.resize(old + kGuess);
+    int n = std::vsnprintf(&buf[old], kGuess + 1, fmt, args);
+    if (n < 0) {
+        buf.resize(old);
+    } else if (static_cast<size_t>(n) > kGuess) {
+        buf.resize(old + static_cast<size_t>(n));
+        std::vsnprintf(&buf[old], static_cast<size_t>(n) + 1, fmt, retry);
+    } else {
+        buf.resize(old + static_cast<size_t>(n));
+    }
+    va_end(retry);
+}
+
+inline void append_format(std::string& buf, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    append_vformat(buf, fmt, args);
+    va_end(args);
+}
+
+// Per-thread scratch line; reused so formatting does not allocate
+inline std::string& log_line_buffer() {
+    thread_local std::string buf;
+    buf.clear();
+    return buf;
+}
+
+// Background log writer (see start_async_log)
+class AsyncLog {
+public:
+    static constexpr size_t kRecordBytes = 248;   // text per ring slot
+    static constexpr size_t kRingRecords = 4096;  // slots per producing thread
+
+    static AsyncLog& instance() {
+        static AsyncLog log;
+        return log;
+    }
+
+    ~AsyncLog() { stop(); }
+
+    bool active() const { return active_.load(std::memory_order_acquire); }
+    // True when the sink is a file rather than stdout/stderr
+    bool to_file() const { return owns_.load(std::memory_order_relaxed); }
+
+    // Start the writer on `out`, closed in stop() if `owns`
+    void start(FILE* out, bool owns) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (active()) return;
+        out_ = out;
+        owns_.store(owns, std::memory_order_relaxed);
+        stop_.store(false, std::memory_order_relaxed);
+        writer_ = std::thread([this] { run(); });
+        active_.store(true, std::memory_order_seq_cst);
+    }
+
+    // Drain everything queued, join the writer and go back to synchronous
+    // output
+    void stop() {
+        std::vector<std::shared_ptr<Producer>> producers;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!active()) return;
+            active_.store(false, std::memory_order_seq_cst);
+            producers = producers_;
+        }
+        // Producers that saw active() finish their message first
+        for (auto& p : producers) {
+            while (p->busy.load(std::memory_order_seq_cst)) std::this_thread::yield();
+        }
+        stop_.store(true, std::memory_order_release);
+        writer_.join();
+        if (owns_.load(std::memory_order_relaxed)) std::fclose(out_);
+        out_ = nullptr;
+        owns_.store(false, std::memory_order_relaxed);
+    }
+
+    // Queue `n` bytes; false if the sink is not running (write it yourself).
+    // Blocks (yielding) while this thread's ring is full, never drops.
+    // Text longer than one record is written out in one piece.
+    bool write(const char* data, size_t n) {
+        if (!active()) return false;   // no ring for threads that never log async
+        Producer& p = local();
+        p.busy.store(true, std::memory_order_seq_cst);
+        if (!active_.load(std::memory_order_seq_cst)) {
+            p.busy.store(false, std::memory_order_release);
+            return false;
+        }
+        while (n > 0) {
+            Record* rec;
+            while (!(rec = p.ring.try_reserve())) std::this_thread::yield();
+            size_t len = n < kRecordBytes ? n : kRecordBytes;
+            std::memcpy(rec->text, data, len);
+            rec->len = static_cast<uint32_t>(len);
+            rec->more = len < n;
+            p.ring.commit();
+            data += len;
+            n -= len;
+        }
+        p.busy.store(false, std::memory_order_release);
+        return true;
+    }
+
+    // Wait until everything queued before the call has been written out
+    void flush() {
+        if (!active()) {
+            std::fflush(stdout);
+            return;
+        }
+        uint64_t target = idle_passes_.load(std::memory_order_acquire) + 2;
+        while (active() && idle_passes_.load(std::memory_order_acquire) < target) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+
+private:
+    struct Record {
+        uint32_t len = 0;
+        bool more = false;   // the message continues in the next record
+        char text[kRecordBytes];
+    };
+
+    struct Producer {
+        SpscRing<Record> ring{kRingRecords};
+        std::atomic<bool> busy{false};
+        std::atomic<bool> exited{false};
+    };
+
+    AsyncLog() = default;
+
+    // This thread's ring, registered with the writer on first use
+    Producer& local() {
+        struct Holder {
+            std::shared_ptr<Producer> p;
+            ~Holder() { if (p) p->exited.store(true, std::memory_order_release); }
+        };
+        thread_local Holder holder;
+        if (!holder.p) {
+            holder.p = std::make_shared<Producer>();
+            std::lock_guard<std::mutex> lock(mutex_);
+            producers_.push_back(holder.p);
+        }
+        return *holder.p;
+    }
+
+    // One pass over all rings; drops rings of exited threads once empty
+    size_t drain() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t n = 0;
+        for (auto it = producers_.begin(); it != producers_.end();) {
+            auto& ring = (*it)->ring;
+            bool more = false;
+            while (true) {
+                Record* rec = ring.front();
+                if (!rec) {
+                    // Wait for the rest of a split message so that no other
+                    // thread's output lands inside it
+                    if (!more) break;
+                    std::this_thread::yield();
+                    continue;
+                }
+                more = rec->more;
+                std::fwrite(rec->text, 1, rec->len, out_);
+                ring.pop();
+                n++;
+            }
+            if ((*it)->exited.load(std::memory_order_acquire) && ring.empty()) {
+                it = producers_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        return n;
+    }
+
+    void run() {
+        while (true) {
+            bool stopping = stop_.load(std::memory_order_acquire);
+            if (drain() > 0) continue;
+            std::fflush(out_);
+            idle_passes_.fetch_add(1, std::memory_order_release);
+            if (stopping) break;
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+        }
+    }
+
+    std::mutex mutex_;   // producers_ and start/stop, never the hot path
+    std::vector<std::shared_ptr<Producer>> producers_;
+    std::thread writer_;
+    std::atomic<bool> active_{false};
+    std::atomic<bool> stop_{false};
+    std::atomic<uint64_t> idle_passes_{0};
+    FILE* out_ = nullptr;
+    std::atomic<bool> owns_{false};
+};
+
 // Logger class for a specific component
 class Logger {
 public:
@@ -66,12 +287,22 @@ public:
 
     template<typename... Args>
     void debug(const char* fmt, Args... args) const {
-        log(LogLevel::Debug, fmt, args...);
+        if constexpr (LOOM_LOG_MIN_LEVEL <= 0) {
+            log(LogLevel::Debug, fmt, args...);
+        } else {
+            (void)fmt;
+            ((void)args, ...);
+        }
     }
 
     template<typename... Args>
     void info(const char* fmt, Args... args) const {
-        log(LogLevel::Info, fmt, args...);
+        if constexpr (LOOM_LOG_MIN_LEVEL <= 1) {
+            log(LogLevel::Info, fmt, args...);
+        } else {
+            (void)fmt;
+            ((void)args, ...);
+        }
     }
 
     template<typename... Args>
@@ -86,6 +317,7 @@ public:
 
     // Varargs version for C compatibility
     void debug_v(const char* fmt, ...) const {
+        if constexpr (LOOM_LOG_MIN_LEVEL > 0) return;
         va_list args;
         va_start(args, fmt);
         log_v(LogLevel::Debug, fmt, args);
@@ -93,6 +325,7 @@ public:
     }
 
     void info_v(const char* fmt, ...) const {
+        if constexpr (LOOM_LOG_MIN_LEVEL > 1) return;
         va_list args;
         va_start(args, fmt);
         log_v(LogLevel::Info, fmt, args);
@@ -119,36 +352,42 @@ private:
         auto& config = LogConfig::instance();
         if (level < config.level()) return;
 
-        std::lock_guard<std::mutex> lock(config.mutex());
-
-        FILE* out = (level >= LogLevel::Warning) ? stderr : stdout;
-
-        print_prefix(out, level, config.color_enabled());
+        std::string& line = log_line_buffer();
+        append_prefix(line, level, config.color_enabled());
         if constexpr (sizeof...(args) == 0) {
             // No args - print format string directly (safely)
-            std::fputs(fmt, out);
+            line += fmt;
         } else {
-            std::fprintf(out, fmt, args...);
+            append_format(line, fmt, args...);
         }
-        std::fprintf(out, "\n");
-        std::fflush(out);
+        line += '\n';
+        emit(level, line);
     }
 
     void log_v(LogLevel level, const char* fmt, va_list args) const {
         auto& config = LogConfig::instance();
         if (level < config.level()) return;
 
-        std::lock_guard<std::mutex> lock(config.mutex());
+        std::string& line = log_line_buffer();
+        append_prefix(line, level, config.color_enabled());
+        append_vformat(line, fmt, args);
+        line += '\n';
+        emit(level, line);
+    }
 
-        FILE* out = (level >= LogLevel::Warning) ? stderr : stdout;
+    static void emit(LogLevel level, const std::string& line) {
+        auto& sink = AsyncLog::instance();
+        bool queued = sink.write(line.data(), line.size());
+        // Errors also reach the terminal when the log goes to a file
+        if (queued && !(level >= LogLevel::Error && sink.to_file())) return;
 
-        print_prefix(out, level, config.color_enabled());
-        std::vfprintf(out, fmt, args);
-        std::fprintf(out, "\n");
+        std::lock_guard<std::mutex> lock(LogConfig::instance().mutex());
+        FILE* out = (level >= LogLevel::Warning) ? stderr : stdout;
+        std::fwrite(line.data(), 1, line.size(), out);
         std::fflush(out);
     }
 
-    void print_prefix(FILE* out, LogLevel level, bool use_color) const {
+    void append_prefix(std::string& line, LogLevel level, bool use_color) const {
         const char* level_str = "";
         const char* level_color = "";
         const char* component_color = color::Cyan;
@@ -175,11 +414,11 @@ private:
         }
 
         if (use_color) {
-            std::fprintf(out, "%s[%s]%s %s%-5s%s ",
-                         component_color, component_.c_str(), color::Reset,
-                         level_color, level_str, color::Reset);
+            append_format(line, "%s[%s]%s %s%-5s%s ",
+                          component_color, component_.c_str(), color::Reset,
+                          level_color, level_str, color::Reset);
         } else {
-            std::fprintf(out, "[%s] %-5s ", component_.c_str(), level_str);
+            append_format(line, "[%s] %-5s ", component_.c_str(), level_str);
         }
     }
 
@@ -201,4 +440,45 @@ inline void set_log_color(bool enabled) {
     LogConfig::instance().set_color_enabled(enabled);
 }
 
+// Send all log output (and log_display text) through the background
+// writer into `path`, or stdout for "-". Colors are turned off for files.
+inline bool start_async_log(const std::string& path) {
+    if (path == "-") {
+        AsyncLog::instance().start(stdout, false);
+        return true;
+    }
+    FILE* out = std::fopen(path.c_str(), "we");   // not inherited by the simulator
+    if (!out) return false;
+    std::setvbuf(out, nullptr, _IOFBF, 1 << 16);
+    set_log_color(false);
+    AsyncLog::instance().start(out, true);
+    return true;
+}
+
+inline void stop_async_log() { AsyncLog::instance().stop(); }
+
+// Block until queued output has been written (no-op when synchronous)
+inline void log_flush() { AsyncLog::instance().flush(); }
+
+// Raw DUT output ($display, vpi_printf): no prefix, no newline added.
+// Queued with the log when it is async, plain stdout otherwise.
+inline int log_display_v(const char* fmt, va_list args) {
+    auto& sink = AsyncLog::instance();
+    if (!sink.active()) return std::vprintf(fmt, args);
+    std::string& line = log_line_buffer();
+    append_vformat(line, fmt, args);
+    if (!sink.write(line.data(), line.size())) {
+        std::fwrite(line.data(), 1, line.size(), stdout);
+    }
+    return static_cast<int>(line.size());
+}
+
+inline int log_display(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int n = log_display_v(fmt, args);
+    va_end(args);
+    return n;
+}
+
 } // namespace loom
@@ -42,6 +42,7 @@ struct LoomPaths {
     fs::path loom_instrument_plugin;
     fs::path emu_top_plugin;
     fs::path mem_shadow_plugin;
+    fs::path loom_profile_plugin;
 
     // Get the directory containing the running executable
     static fs::path exe_dir() {
@@ -105,6 +106,9 @@ struct LoomPaths {
             paths.mem_shadow_plugin =
                 paths.root / "build" / "passes" / "mem_shadow" /
                 "mem_shadow.so";
+            paths.loom_profile_plugin =
+                paths.root / "build" / "passes" / "loom_profile" /
+                "loom_profile.so";
             paths.rtl_dir = paths.root / "src" / "rtl";
             paths.bfm_dir = paths.root / "src" / "bfm";
             paths.sim_top = paths.root / "src" / "rtl" / "loom_shell.sv";
@@ -120,6 +124,7 @@ struct LoomPaths {
                 paths.plugin_dir / "loom_instrument.so";
             paths.emu_top_plugin = paths.plugin_dir / "emu_top.so";
             paths.mem_shadow_plugin = paths.plugin_dir / "mem_shadow.so";
+            paths.loom_profile_plugin = paths.plugin_dir / "loom_profile.so";
             paths.rtl_dir = paths.root / "share" / "loom" / "rtl";
             paths.bfm_dir = paths.root / "share" / "loom" / "bfm";
             paths.sim_top =
@@ -145,6 +150,8 @@ struct LoomPaths {
         args.push_back(emu_top_plugin.string());
         args.push_back("-m");
         args.push_back(mem_shadow_plugin.string());
+        args.push_back("-m");
+        args.push_back(loom_profile_plugin.string());
         return args;
     }
 };
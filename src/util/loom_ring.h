@@ -0,0 +1,154 @@
+// SPDX-License-Identifier: Apache-2.0
+// Loom bounded lock-free rings
+//
+// Ring: multi-producer / multi-consumer. Classic sequence-numbered ring
+// (D. Vyukov): each slot carries a sequence counter that tells producers
+// and consumers whether it is free or full, so push/pop never take a lock
+// and never allocate. Used by the concurrent DPI service to hand calls to
+// worker threads and post completions back to the poller.
+//
+// SpscRing: single-producer / single-consumer. Two cursors and no CAS;
+// slots are filled and drained in place (reserve/commit, front/pop) so
+// large records are never copied. Used by the async logger.
+//
+// Capacities are rounded up to a power of two.
+
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace loom {
+
+template <typename T>
+class Ring {
+public:
+    explicit Ring(size_t capacity)
+        : mask_(std::bit_ceil(capacity < 2 ? size_t(2) : capacity) - 1),
+          slots_(std::make_unique<Slot[]>(mask_ + 1)) {
+        for (size_t i = 0; i <= mask_; i++)
+            slots_[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    Ring(const Ring&) = delete;
+    Ring& operator=(const Ring&) = delete;
+
+    size_t capacity() const { return mask_ + 1; }
+
+    // Returns false if the ring is full
+    bool try_push(T value) {
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots_[pos & mask_];
+            size_t seq = slot.seq.load(std::memory_order_acquire);
+            auto diff = static_cast<ptrdiff_t>(seq) - static_cast<ptrdiff_t>(pos);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.value = std::move(value);
+                    slot.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Returns false if the ring is empty
+    bool try_pop(T& out) {
+        size_t pos = head_.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots_[pos & mask_];
+            size_t seq = slot.seq.load(std::memory_order_acquire);
+            auto diff = static_cast<ptrdiff_t>(seq) - static_cast<ptrdiff_t>(pos + 1);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    out = std::move(slot.value);
+                    slot.seq.store(pos + mask_ + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> seq{0};
+        T value{};
+    };
+
+    // Keep producer and consumer cursors on separate cache lines
+    static constexpr size_t kLine = 64;
+
+    const size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    alignas(kLine) std::atomic<size_t> head_{0};
+    alignas(kLine) std::atomic<size_t> tail_{0};
+};
+
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity)
+        : mask_(std::bit_ceil(capacity < 2 ? size_t(2) : capacity) - 1),
+          slots_(std::make_unique<T[]>(mask_ + 1)) {}
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    size_t capacity() const { return mask_ + 1; }
+
+    // Producer: the next free slot, or nullptr if the ring is full.
+    // Fill it, then commit() to publish it.
+    T* try_reserve() {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_cache_ > mask_) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ > mask_) return nullptr;
+        }
+        return &slots_[tail & mask_];
+    }
+    void commit() {
+        tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Consumer: the oldest published slot, or nullptr if the ring is
+    // empty. pop() releases it back to the producer.
+    T* front() {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head == tail_cache_) return nullptr;
+        }
+        return &slots_[head & mask_];
+    }
+    void pop() {
+        head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+private:
+    static constexpr size_t kLine = 64;
+
+    const size_t mask_;
+    std::unique_ptr<T[]> slots_;
+    // Each side caches the other's cursor to touch its line only when needed
+    alignas(kLine) std::atomic<size_t> head_{0};
+    size_t tail_cache_ = 0;     // consumer-owned
+    alignas(kLine) std::atomic<size_t> tail_{0};
+    size_t head_cache_ = 0;     // producer-owned
+};
+
+} // namespace loom
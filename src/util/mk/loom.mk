@@ -9,6 +9,7 @@ LOOM_HOME ?= $(error LOOM_HOME is not set)
 
 LOOMC := $(LOOM_HOME)/build/src/tools/loomc
 LOOMX := $(LOOM_HOME)/build/src/tools/loomx
+LOOMSNAP := $(LOOM_HOME)/build/src/tools/loomsnap
 
 CC ?= cc
 
@@ -13,6 +13,10 @@ LOOM_HOME ?= $(error LOOM_HOME is not set)
 _LOOM_VERILATOR_BUILD := $(LOOM_HOME)/build/verilator/bin/verilator
 VERILATOR ?= $(if $(wildcard $(_LOOM_VERILATOR_BUILD)),$(_LOOM_VERILATOR_BUILD),verilator)
 
+# Verilator model threads (--threads); 1 builds the single-threaded model.
+# Non-pure DPI imports (the socket BFM, user DPI) stay on one thread.
+VERILATOR_THREADS ?= 1
+
 VERILATOR_FLAGS := \
     --binary --timing -Wall -Wno-fatal \
     -Wno-DECLFILENAME -Wno-UNUSEDSIGNAL -Wno-UNUSEDPARAM \
@@ -35,10 +39,13 @@ LOOM_SIM_RTL := \
     $(_LOOM_RTL)/loom_emu_ctrl.sv \
     $(_LOOM_RTL)/loom_axil_demux.sv \
     $(_LOOM_RTL)/loom_axil_firewall.sv \
-    $(_LOOM_RTL)/loom_axi4_err_slv.sv \
+    $(_LOOM_RTL)/loom_axi4_to_axil.sv \
+    $(_LOOM_RTL)/loom_axil_arb.sv \
     $(_LOOM_RTL)/loom_dpi_regfile.sv \
     $(_LOOM_RTL)/loom_scan_ctrl.sv \
     $(_LOOM_RTL)/loom_mem_ctrl.sv \
+    $(_LOOM_RTL)/loom_trace_ctrl.sv \
+    $(_LOOM_RTL)/loom_clk_gate.sv \
     $(_LOOM_RTL)/loom_icap_ctrl.sv \
     $(_LOOM_RTL)/loom_shell.sv \
     $(_LOOM_BFM)/loom_axil_socket_bfm.sv \
@@ -55,5 +62,6 @@ LOOM_SIM_DPI := $(_LOOM_BFM)/loom_sock_dpi.c
 %/sim/obj_dir/Vloom_shell: %/transformed.v
 	@mkdir -p $*/sim/obj_dir
 	$(VERILATOR) $(VERILATOR_FLAGS) --top-module loom_shell \
+	    $(if $(filter-out 0 1,$(VERILATOR_THREADS)),--threads $(VERILATOR_THREADS)) \
 	    $(LOOM_SIM_RTL) $< $(LOOM_SIM_DPI) \
 	    --Mdir $*/sim/obj_dir -o Vloom_shell
@@ -11,6 +11,8 @@
 #   DPI_CXXFLAGS :=                  # Extra C++ compile flags (optional)
 #   LOOMC_FLAGS  :=                  # Extra loomc flags, e.g. -clk/-rst (optional)
 #   BUILD     := build               # Build directory (optional, default: build)
+#   VERILATOR_THREADS := 4           # Verilator --threads (optional, default: 1)
+#   LOOMX_FLAGS  :=                  # Extra loomx flags, e.g. -t shm (optional)
 #
 #   include path/to/loom_test.mk
 #
@@ -93,11 +95,11 @@ _TEST_DEPS := $(BUILD)/sim/obj_dir/Vloom_shell $(if $(DPI_SRCS),$(BUILD)/libdpi.
 test: $(_TEST_DEPS)
 	@echo "run" > $(BUILD)/test_script.txt
 	@echo "exit" >> $(BUILD)/test_script.txt
-	$(LOOMX) -work $(BUILD) $(_LOOMX_DPI) $(_LOOMX_TIMEOUT) -sim Vloom_shell -f $(BUILD)/test_script.txt
+	$(LOOMX) -work $(BUILD) $(_LOOMX_DPI) $(_LOOMX_TIMEOUT) $(LOOMX_FLAGS) -sim Vloom_shell -f $(BUILD)/test_script.txt
 
 # ---------- Step 5: Interactive ----------
 interactive: $(_TEST_DEPS)
-	$(LOOMX) -work $(BUILD) $(_LOOMX_DPI) $(_LOOMX_TIMEOUT) -sim Vloom_shell
+	$(LOOMX) -work $(BUILD) $(_LOOMX_DPI) $(_LOOMX_TIMEOUT) $(LOOMX_FLAGS) -sim Vloom_shell
 
 # ---------- Clean ----------
 clean:
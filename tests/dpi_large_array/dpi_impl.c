@@ -0,0 +1,27 @@
+// SPDX-License-Identifier: Apache-2.0
+// DPI implementation for large array test
+
+#include <svdpi.h>
+#include <stdint.h>
+#include <stdio.h>
+
+int32_t dpi_fill_large(svOpenArrayHandle data, int32_t n_elements) {
+    svBitVecVal *ptr = (svBitVecVal *)svGetArrayPtr(data);
+    printf("[dpi] dpi_fill_large(n=%d)\n", n_elements);
+    for (int i = 0; i < n_elements; i++)
+        ptr[i] = (i + 1) * 0x01010101;
+    printf("[dpi]   data[%d] = 0x%08x\n", n_elements - 1, ptr[n_elements - 1]);
+    return n_elements;
+}
+
+int32_t dpi_sum_large(svOpenArrayHandle data, int32_t n_elements) {
+    const svBitVecVal *ptr = (const svBitVecVal *)svGetArrayPtr(data);
+    printf("[dpi] dpi_sum_large(n=%d)\n", n_elements);
+    uint32_t sum = 0;
+    for (int i = 0; i < n_elements; i++)
+        sum += ptr[i];
+    printf("[dpi]   data[0] = 0x%08x, data[%d] = 0x%08x\n", ptr[0], n_elements - 1,
+           ptr[n_elements - 1]);
+    printf("[dpi]   sum = 0x%08x\n", sum);
+    return (int32_t)sum;
+}
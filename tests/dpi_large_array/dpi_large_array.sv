@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: Apache-2.0
+// DPI large array test — open arrays larger than the regfile's arg
+// registers go through the scratch window in both directions
+
+import "DPI-C" function int dpi_fill_large(
+    output bit [31:0] data[],
+    input int n_elements
+);
+
+import "DPI-C" function int dpi_sum_large(
+    input bit [31:0] data[],
+    input int n_elements
+);
+
+module dpi_large_array (
+    input logic clk_i,
+    input logic rst_ni
+);
+
+    localparam int N = 64;
+
+    // Packed wrapper: output open array
+    function automatic int dpi_fill_large_packed(output logic [N*32-1:0] data, input int n);
+        bit [31:0] data_unpacked[N];
+        int ret;
+        ret = dpi_fill_large(data_unpacked, n);
+        for (int i = 0; i < N; i++)
+            data[i*32+:32] = data_unpacked[i];
+        return ret;
+    endfunction
+
+    // Packed wrapper: input open array
+    function automatic int dpi_sum_large_packed(input logic [N*32-1:0] data, input int n);
+        bit [31:0] data_unpacked[N];
+        for (int i = 0; i < N; i++)
+            data_unpacked[i] = data[i*32+:32];
+        return dpi_sum_large(data_unpacked, n);
+    endfunction
+
+    typedef enum logic [1:0] {
+        StIdle,
+        StFill,
+        StSum,
+        StDone
+    } state_e;
+
+    state_e state_q;
+    logic [N*32-1:0] packed_arr;
+    int fill_ret, sum_ret;
+
+    always_ff @(posedge clk_i or negedge rst_ni) begin
+        if (!rst_ni) begin
+            state_q <= StIdle;
+            fill_ret <= 0;
+            sum_ret <= 0;
+            packed_arr <= '0;
+        end else begin
+            case (state_q)
+                StIdle: state_q <= StFill;
+                StFill: begin
+                    fill_ret <= dpi_fill_large_packed(packed_arr, N);
+                    state_q <= StSum;
+                end
+                StSum: begin
+                    sum_ret <= dpi_sum_large_packed(packed_arr, N);
+                    state_q <= StDone;
+                end
+                StDone: begin
+                    $display("fill_ret=%0d, sum_ret=0x%0h, last=0x%0h",
+                             fill_ret, sum_ret, packed_arr[(N-1)*32+:32]);
+                    $finish;
+                end
+            endcase
+        end
+    end
+
+endmodule
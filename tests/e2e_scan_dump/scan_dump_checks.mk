@@ -0,0 +1,96 @@
+# SPDX-License-Identifier: Apache-2.0
+# scan_dump_checks.mk — scan dump checks shared by the e2e_scan_dump variants
+#
+# Include after loom_test.mk. Provides scan_dump_checks, which runs
+# test_script.txt and restore_script.txt from this directory against the
+# including test's build and checks the results. The variants differ only
+# in LOOMC_FLAGS (scan chain count, streaming), so the captured values
+# must be the same in all of them.
+
+SCAN_DUMP_DIR := $(realpath $(dir $(lastword $(MAKEFILE_LIST))))
+
+# Scan chains the shell should report for the build
+SCAN_CHAINS ?= 1
+
+.PHONY: scan_dump_checks
+
+scan_dump_checks: $(_TEST_DEPS)
+	$(LOOMX) -work $(BUILD) $(_LOOMX_DPI) -sim Vloom_shell -timeout -1 \
+		-f $(SCAN_DUMP_DIR)/test_script.txt 2>&1 | tee $(BUILD)/test.log
+	@echo "--- Checking output (per-snapshot) ---"
+	@# loomc writes the scan map index; loomx ran off the mapped files
+	@test -s $(BUILD)/scan_map.idx
+	@grep -q 'Scan bits: .*($(SCAN_CHAINS) chains*[,)]' $(BUILD)/test.log
+	@# snap_idle: after reset — StIdle, all DPI results zero
+	@grep -A 20 'File:.*snap_idle' $(BUILD)/test.log | grep -q 'state_q.*StIdle (0x0)'
+	@grep -A 20 'File:.*snap_idle' $(BUILD)/test.log | grep -q 'counter_q.*0xcafe'
+	@grep -A 20 'File:.*snap_idle' $(BUILD)/test.log | grep -q 'add_result_q.*0x00000000'
+	@grep -A 20 'File:.*snap_idle' $(BUILD)/test.log | grep -q 'step_count_q.*0x00'
+	@# snap_call_add: StIdle -> StCallAdd (1 cycle)
+	@grep -A 20 'File:.*snap_call_add' $(BUILD)/test.log | grep -q 'state_q.*StCallAdd (0x1)'
+	@grep -A 20 'File:.*snap_call_add' $(BUILD)/test.log | grep -q 'step_count_q.*0x01'
+	@# snap_call_notify: StCallAdd -> StCallNotify (dpi_add executed)
+	@grep -A 20 'File:.*snap_call_notify' $(BUILD)/test.log | grep -q 'state_q.*StCallNotify (0x2)'
+	@grep -A 20 'File:.*snap_call_notify' $(BUILD)/test.log | grep -q 'add_result_q.*0x0000dafe'
+	@grep -A 20 'File:.*snap_call_notify' $(BUILD)/test.log | grep -q 'step_count_q.*0x02'
+	@# snap_call_fill: StCallNotify -> StCallFill (dpi_notify executed)
+	@grep -A 20 'File:.*snap_call_fill' $(BUILD)/test.log | grep -q 'state_q.*StCallFill (0x3)'
+	@grep -A 20 'File:.*snap_call_fill' $(BUILD)/test.log | grep -q 'step_count_q.*0x03'
+	@# Verify $display output shows correct notify_done_q value
+	@grep -q 'notify=1' $(BUILD)/test.log
+	@# snap_call_sum: StCallFill -> StCallSum (dpi_fill_fixed executed)
+	@grep -A 20 'File:.*snap_call_sum' $(BUILD)/test.log | grep -q 'state_q.*StCallSum (0x4)'
+	@grep -A 20 'File:.*snap_call_sum' $(BUILD)/test.log | grep -q 'fill_ret_q.*0x00000004'
+	@grep -A 20 'File:.*snap_call_sum' $(BUILD)/test.log | grep -q 'step_count_q.*0x04'
+	@# snap_done: StCallSum -> StDone (dpi_sum_open executed)
+	@grep -A 20 'File:.*snap_done' $(BUILD)/test.log | grep -q 'state_q.*StDone (0x5)'
+	@grep -A 20 'File:.*snap_done' $(BUILD)/test.log | grep -q 'sum_result_q.*0xaaaaaaaa'
+	@grep -A 20 'File:.*snap_done' $(BUILD)/test.log | grep -q 'step_count_q.*0x05'
+	@# snap_count: 3 more cycles counting in StDone
+	@grep -A 20 'File:.*snap_count' $(BUILD)/test.log | grep -q 'state_q.*StDone (0x5)'
+	@grep -A 20 'File:.*snap_count' $(BUILD)/test.log | grep -q 'counter_q.*0xcb01'
+	@grep -A 20 'File:.*snap_count' $(BUILD)/test.log | grep -q 'step_count_q.*0x08'
+	@# snap_delta: compressed delta of snap_count resolves to the same state
+	@grep -A 20 'File:.*snap_delta' $(BUILD)/test.log | grep -q 'state_q.*StDone (0x5)'
+	@grep -A 20 'File:.*snap_delta' $(BUILD)/test.log | grep -q 'counter_q.*0xcb01'
+	@grep -A 20 'File:.*snap_delta' $(BUILD)/test.log | grep -q 'step_count_q.*0x08'
+	@# filtered inspect: only the named variable, unknown names reported
+	@grep -q 'no_such_var: no such variable' $(BUILD)/test.log
+	@grep -B 1 -A 2 'no_such_var: no such variable' $(BUILD)/test.log | grep -q 'counter_q.*0xcb01'
+	@# snap_restored: restore of snap_call_notify (state and counters)
+	@grep -A 20 'File:.*snap_restored' $(BUILD)/test.log | grep -q 'Cycle: *2$$'
+	@grep -A 20 'File:.*snap_restored' $(BUILD)/test.log | grep -q 'state_q.*StCallNotify (0x2)'
+	@grep -A 20 'File:.*snap_restored' $(BUILD)/test.log | grep -q 'add_result_q.*0x0000dafe'
+	@grep -A 20 'File:.*snap_restored' $(BUILD)/test.log | grep -q 'step_count_q.*0x02'
+	@# snap_rewound: rewind after 3 steps returns to the checkpoint
+	@grep -A 20 'File:.*snap_rewound' $(BUILD)/test.log | grep -q 'Cycle: *2$$'
+	@grep -A 20 'File:.*snap_rewound' $(BUILD)/test.log | grep -q 'state_q.*StCallNotify (0x2)'
+	@grep -A 20 'File:.*snap_rewound' $(BUILD)/test.log | grep -q 'step_count_q.*0x02'
+	@# waveform: one sample per step, step_count_q reaches 8
+	@grep -q 'Wrote 7 samples to build/trace.vcd' $(BUILD)/test.log
+	@grep -q 'var wire 8 .* step_count_q' $(BUILD)/trace.vcd
+	@grep -q '^b1000 ' $(BUILD)/trace.vcd
+	@# offline decode: full dump and per-file selection agree with inspect
+	$(LOOMSNAP) $(BUILD)/snap_count.pb $(BUILD)/snap_delta.pb > $(BUILD)/loomsnap.log
+	$(LOOMSNAP) -csv -v no_such_var $(BUILD)/snap_delta.pb >> $(BUILD)/loomsnap.log
+	@test $$(grep -c 'counter_q.*= 0xcb01' $(BUILD)/loomsnap.log) -eq 2
+	@grep -q 'snap_delta.pb,[0-9]*,-$$' $(BUILD)/loomsnap.log
+	@# snap_recapture: back-to-back captures agree on every variable
+	$(LOOMSNAP) -csv $(BUILD)/snap_count.pb | cut -d, -f2- > $(BUILD)/snap_count.csv
+	$(LOOMSNAP) -csv $(BUILD)/snap_recapture.pb | cut -d, -f2- > $(BUILD)/snap_recapture.csv
+	@cmp -s $(BUILD)/snap_count.csv $(BUILD)/snap_recapture.csv
+	@# capture -> restore -> capture: snap_restored matches snap_call_notify exactly
+	$(LOOMSNAP) -csv $(BUILD)/snap_call_notify.pb | cut -d, -f2- > $(BUILD)/snap_call_notify.csv
+	$(LOOMSNAP) -csv $(BUILD)/snap_restored.pb | cut -d, -f2- > $(BUILD)/snap_restored.csv
+	@cmp -s $(BUILD)/snap_call_notify.csv $(BUILD)/snap_restored.csv
+	@# loomx -restore: snap_call_notify restored into a fresh sim at startup
+	$(LOOMX) -work $(BUILD) $(_LOOMX_DPI) -sim Vloom_shell -timeout -1 \
+		-restore $(BUILD)/snap_call_notify.pb \
+		-f $(SCAN_DUMP_DIR)/restore_script.txt 2>&1 | tee $(BUILD)/restore.log
+	@grep -A 20 'File:.*snap_cli_restored' $(BUILD)/restore.log | grep -q 'Cycle: *2$$'
+	@grep -A 20 'File:.*snap_cli_restored' $(BUILD)/restore.log | grep -q 'state_q.*StCallNotify (0x2)'
+	@grep -A 20 'File:.*snap_cli_restored' $(BUILD)/restore.log | grep -q 'add_result_q.*0x0000dafe'
+	@grep -A 20 'File:.*snap_cli_step' $(BUILD)/restore.log | grep -q 'state_q.*StCallFill (0x3)'
+	@grep -A 20 'File:.*snap_cli_step' $(BUILD)/restore.log | grep -q 'step_count_q.*0x03'
+	@grep -q 'notify=1' $(BUILD)/restore.log
+	@grep -q 'No divergence up to time' $(BUILD)/restore.log
@@ -0,0 +1,20 @@
+// SPDX-License-Identifier: Apache-2.0
+// cover_dut.sv - Counter with cover properties
+// Used to test loom_instrument cover property counters
+
+module cover_dut (
+    input  logic        clk,
+    input  logic        rst,
+    input  logic        inc,
+    output logic [3:0]  count
+);
+    always_ff @(posedge clk or posedge rst) begin
+        if (rst)
+            count <= 4'h0;
+        else if (inc)
+            count <= count + 4'h1;
+    end
+
+    c_wrap: cover property (@(posedge clk) disable iff (rst) count == 4'hf && inc);
+    c_idle: cover property (@(posedge clk) disable iff (rst) !inc);
+endmodule
@@ -0,0 +1,30 @@
+// SPDX-License-Identifier: Apache-2.0
+// wide_dff.sv - Test module with enough flip-flops for several scan chains
+// Used to test multi-chain scan insertion (129 bits)
+
+module wide_dff (
+    input  logic        clk,
+    input  logic        rst,
+    input  logic [63:0] data_in,
+    output logic [63:0] data_out,
+    output logic        flag
+);
+    logic [63:0] reg_a;
+    logic [63:0] reg_b;
+    logic        reg_c;
+
+    always_ff @(posedge clk or posedge rst) begin
+        if (rst) begin
+            reg_a <= 64'h0;
+            reg_b <= 64'h0;
+            reg_c <= 1'b0;
+        end else begin
+            reg_a <= data_in;
+            reg_b <= reg_a ^ data_in;
+            reg_c <= ^reg_b;
+        end
+    end
+
+    assign data_out = reg_b;
+    assign flag = reg_c;
+endmodule
@@ -0,0 +1,30 @@
+# SPDX-License-Identifier: Apache-2.0
+# One benchmark variant: a loom_test.mk build plus a `run` target that
+# executes BENCH_CMDS (';'-separated shell commands) in loomx.
+#
+# Invoked by Makefile with TOP, DUT_SRC, DPI_SRCS, BUILD and LOOMC_FLAGS.
+
+include ../../src/util/mk/loom_test.mk
+
+TRANSPORT   ?= socket
+XDMA_DEVICE ?= /dev/xdma0_user
+
+# The board runs whatever bitstream is loaded: only the maps and DPI
+# libraries come from the work directory
+ifeq ($(TRANSPORT),xdma)
+  _BENCH_DEPS  := $(BUILD)/transformed.v $(if $(DPI_SRCS),$(BUILD)/libdpi.so)
+  _BENCH_LOOMX := -t xdma -d $(XDMA_DEVICE)
+else
+  _BENCH_DEPS  := $(_TEST_DEPS)
+  _BENCH_LOOMX := -sim Vloom_shell $(if $(filter shm,$(TRANSPORT)),-t shm)
+endif
+
+.PHONY: run
+
+run: $(_BENCH_DEPS)
+	@echo "$(BENCH_CMDS)" | tr ';' '\n' > $(BUILD)/bench_script.txt
+	@echo "exit" >> $(BUILD)/bench_script.txt
+	$(LOOMX) -work $(BUILD) $(_LOOMX_DPI) $(_BENCH_LOOMX) \
+		-f $(BUILD)/bench_script.txt 2>&1 | tee $(BUILD)/bench.log
+	@! grep -q 'BENCH FAILED\|bench .* failed' $(BUILD)/bench.log || \
+		{ echo "FAIL: benchmark reported errors"; exit 1; }
@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: Apache-2.0
+"""Compare two loom_bench result files (JSON Lines from `bench -o`).
+
+Results are matched on (name, param, label); with --label-a/--label-b two
+labels of the same file (e.g. socket vs xdma) can be compared instead.
+Exits 1 when any benchmark's µs/op got worse by more than --threshold
+percent.
+
+    bench_compare.py base.jsonl new.jsonl
+    bench_compare.py results.jsonl --label-a socket --label-b xdma
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path, label=None):
+    results = {}
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if not line:
+                continue
+            r = json.loads(line)
+            if label is not None and r["label"] != label:
+                continue
+            key = (r["name"], r["param"]) if label is not None else \
+                  (r["name"], r["param"], r["label"])
+            # Repeated runs: the last one wins
+            results[key] = r
+    return results
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("a", help="baseline results (.jsonl)")
+    ap.add_argument("b", nargs="?", help="new results (default: same file as a)")
+    ap.add_argument("--label-a", help="only use results with this label from a")
+    ap.add_argument("--label-b", help="only use results with this label from b")
+    ap.add_argument("--threshold", type=float, default=10.0,
+                    help="regression threshold in percent (default: 10)")
+    args = ap.parse_args()
+
+    if (args.label_a is None) != (args.label_b is None):
+        ap.error("--label-a and --label-b go together")
+    a = load(args.a, args.label_a)
+    b = load(args.b or args.a, args.label_b)
+
+    common = sorted(set(a) & set(b))
+    if not common:
+        print("no benchmarks in common", file=sys.stderr)
+        return 1
+
+    print(f"{'Benchmark':<28} {'Param':>9} {'us/op A':>11} {'us/op B':>11} "
+          f"{'Delta':>8} {'MB/s B':>10}")
+    regressions = 0
+    for key in common:
+        ra, rb = a[key], b[key]
+        ua, ub = ra["us_per_op"], rb["us_per_op"]
+        delta = (ub - ua) / ua * 100.0 if ua > 0 else 0.0
+        mark = ""
+        if delta > args.threshold:
+            mark = "  REGRESSION"
+            regressions += 1
+        name = key[0] if len(key) == 2 else f"{key[0]} [{key[2]}]"
+        print(f"{name:<28} {key[1]:>9} {ua:>11.3f} {ub:>11.3f} {delta:>+7.1f}% "
+              f"{rb['mb_per_s']:>10.3f}{mark}")
+
+    for key in sorted(set(a) ^ set(b)):
+        print(f"only in {'a' if key in a else 'b'}: {key[0]} param={key[1]}")
+
+    if regressions:
+        print(f"{regressions} regression(s) above {args.threshold:g}%")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: Apache-2.0
+// DPI function implementations for the DPI round-trip benchmark
+//
+// Kept trivial so the measured time is the transport and service loop,
+// not the callbacks.
+
+#include <stdio.h>
+#include <stdint.h>
+
+static int32_t flood_count = 0;
+static int32_t flood_errors = 0;
+
+int32_t bench_ping1(int32_t a) {
+    return a + 1;
+}
+
+int32_t bench_ping4(int32_t a, int32_t b, int32_t c, int32_t d) {
+    return a + b + c + d;
+}
+
+int32_t bench_ping8(int32_t a, int32_t b, int32_t c, int32_t d,
+                    int32_t e, int32_t f, int32_t g, int32_t h) {
+    return a + b + c + d + e + f + g + h;
+}
+
+// Read-only (FIFO path): calls must arrive in order and intact
+void bench_flood(int32_t seq, int32_t value) {
+    if (seq != flood_count || value != (seq ^ 0x5A5A5A5A)) {
+        flood_errors++;
+    }
+    flood_count++;
+}
+
+int32_t bench_report(int32_t errors) {
+    printf("[bench] ping mismatches=%d flood calls=%d flood errors=%d\n",
+           errors, flood_count, flood_errors);
+    if (errors == 0 && flood_errors == 0) {
+        printf("BENCH PASSED\n");
+    } else {
+        printf("BENCH FAILED\n");
+    }
+    return 0;
+}
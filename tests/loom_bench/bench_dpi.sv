@@ -0,0 +1,139 @@
+// SPDX-License-Identifier: Apache-2.0
+// DPI Round-Trip Benchmark DUT
+//
+// Issues BENCH_CALLS calls of each benchmark function back to back, with
+// no DUT work in between, so the run time is dominated by the host round
+// trip:
+//   - bench_ping1/4/8: read-write calls with 1, 4 and 8 arguments (regfile
+//     path); results are checked against a local reference
+//   - bench_flood:     read-only call (DPI FIFO path), one per cycle
+// Finally reports the mismatch count and finishes.
+
+`ifndef BENCH_CALLS
+`define BENCH_CALLS 10000
+`endif
+
+import "DPI-C" function int bench_ping1(input int a);
+import "DPI-C" function int bench_ping4(input int a, input int b, input int c, input int d);
+import "DPI-C" function int bench_ping8(input int a, input int b, input int c, input int d,
+                                        input int e, input int f, input int g, input int h);
+import "DPI-C" function void bench_flood(input int seq, input int value);
+import "DPI-C" function int bench_report(input int errors);
+
+module bench_dpi (
+    input  logic clk_i,
+    input  logic rst_ni
+);
+
+    localparam int unsigned N_CALLS = `BENCH_CALLS;
+
+    typedef enum logic [1:0] {
+        PhPing1,
+        PhPing4,
+        PhPing8,
+        PhFlood
+    } phase_e;
+
+    typedef enum logic [2:0] {
+        StIdle,
+        StCall,
+        StCheck,
+        StNext,
+        StReport,
+        StDone
+    } state_e;
+
+    state_e      state_q;
+    phase_e      phase_q;
+    logic [31:0] seq_q;
+    logic [31:0] result_q;
+    logic [31:0] n_err_q;
+
+    // Local reference: ping<N> sums seq, seq+1, ..., seq+N-1
+    logic [31:0] expected;
+    always_comb begin
+        unique case (phase_q)
+            PhPing1: expected = seq_q + 32'd1;
+            PhPing4: expected = (seq_q << 2) + 32'd6;
+            PhPing8: expected = (seq_q << 3) + 32'd28;
+            default: expected = 32'd0;
+        endcase
+    end
+
+    always_ff @(posedge clk_i or negedge rst_ni) begin
+        if (!rst_ni) begin
+            state_q  <= StIdle;
+            phase_q  <= PhPing1;
+            seq_q    <= 32'd0;
+            result_q <= 32'd0;
+            n_err_q  <= 32'd0;
+        end else begin
+            unique case (state_q)
+                StIdle: begin
+                    state_q <= StCall;
+                end
+
+                StCall: begin
+                    unique case (phase_q)
+                        PhPing1: begin
+                            result_q <= bench_ping1(seq_q);
+                            state_q  <= StCheck;
+                        end
+                        PhPing4: begin
+                            result_q <= bench_ping4(seq_q, seq_q + 32'd1, seq_q + 32'd2,
+                                                    seq_q + 32'd3);
+                            state_q  <= StCheck;
+                        end
+                        PhPing8: begin
+                            result_q <= bench_ping8(seq_q, seq_q + 32'd1, seq_q + 32'd2,
+                                                    seq_q + 32'd3, seq_q + 32'd4,
+                                                    seq_q + 32'd5, seq_q + 32'd6,
+                                                    seq_q + 32'd7);
+                            state_q  <= StCheck;
+                        end
+                        default: begin
+                            // Read-only: no result, issue the next one
+                            // straight away
+                            bench_flood(seq_q, seq_q ^ 32'h5A5A_5A5A);
+                            state_q <= StNext;
+                        end
+                    endcase
+                end
+
+                StCheck: begin
+                    if (result_q != expected) begin
+                        n_err_q <= n_err_q + 32'd1;
+                    end
+                    state_q <= StNext;
+                end
+
+                StNext: begin
+                    if (seq_q == N_CALLS - 1) begin
+                        seq_q <= 32'd0;
+                        if (phase_q == PhFlood) begin
+                            state_q <= StReport;
+                        end else begin
+                            phase_q <= phase_e'(phase_q + 2'd1);
+                            state_q <= StCall;
+                        end
+                    end else begin
+                        seq_q   <= seq_q + 32'd1;
+                        state_q <= StCall;
+                    end
+                end
+
+                StReport: begin
+                    result_q <= bench_report(n_err_q);
+                    state_q  <= StDone;
+                end
+
+                StDone: begin
+                    $finish;
+                end
+
+                default: state_q <= StIdle;
+            endcase
+        end
+    end
+
+endmodule
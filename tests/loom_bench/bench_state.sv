@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: Apache-2.0
+// Scan and Memory Benchmark DUT
+//
+// BENCH_SCAN_BITS flip-flops in a feedback shift register (so none are
+// optimized away) and one BENCH_MEM_WORDS x 32 RAM written by the DUT. The
+// host-side benchmarks capture/restore the scan chain and dump/preload the
+// RAM; the DUT only needs to have run for a few cycles.
+
+`ifndef BENCH_SCAN_BITS
+`define BENCH_SCAN_BITS 1024
+`endif
+`ifndef BENCH_MEM_WORDS
+`define BENCH_MEM_WORDS 4096
+`endif
+
+module bench_state (
+    input  logic        clk_i,
+    input  logic        rst_ni,
+    output logic        sr_o,
+    output logic [31:0] mem_data_o
+);
+
+    localparam int unsigned SCAN_BITS = `BENCH_SCAN_BITS;
+    localparam int unsigned MEM_WORDS = `BENCH_MEM_WORDS;
+    localparam int unsigned ADDR_W    = $clog2(MEM_WORDS);
+
+    logic [SCAN_BITS-1:0] sr_q;
+    logic [31:0]          lfsr_q;
+    logic [ADDR_W-1:0]    addr_q;
+
+    logic [31:0] lfsr_next;
+    assign lfsr_next = {1'b0, lfsr_q[31:1]} ^ (lfsr_q[0] ? 32'h8020_0003 : 32'h0);
+
+    always_ff @(posedge clk_i or negedge rst_ni) begin
+        if (!rst_ni) begin
+            sr_q   <= '0;
+            lfsr_q <= 32'hACE1_2468;
+            addr_q <= '0;
+        end else begin
+            sr_q   <= {sr_q[SCAN_BITS-2:0], sr_q[SCAN_BITS-1] ^ lfsr_q[0]};
+            lfsr_q <= lfsr_next;
+            addr_q <= addr_q + 1'b1;
+        end
+    end
+
+    assign sr_o = sr_q[SCAN_BITS-1];
+
+    logic [31:0] mem [MEM_WORDS];
+
+    always_ff @(posedge clk_i) begin
+        mem[addr_q] <= lfsr_q;
+        mem_data_o  <= mem[addr_q];
+    end
+
+endmodule